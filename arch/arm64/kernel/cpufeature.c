@@ -762,6 +762,15 @@ static bool has_no_hw_prefetch(const struct arm64_cpu_capabilities *entry, int _
 		MIDR_CPU_VAR_REV(1, MIDR_REVISION_MASK));
 }
 
+static bool has_nt_memcpy(const struct arm64_cpu_capabilities *entry, int __unused)
+{
+	u32 model = read_cpuid_id() & MIDR_CPU_MODEL_MASK;
+
+	/* Kryo 3xx (SDM845) and the Cortex-A75/A55 cores it is derived from */
+	return model == MIDR_KRYO3G || model == MIDR_KRYO3S ||
+	       model == MIDR_CORTEX_A75 || model == MIDR_CORTEX_A55;
+}
+
 static bool runs_at_el2(const struct arm64_cpu_capabilities *entry, int __unused)
 {
 	return is_kernel_in_hyp_mode();
@@ -931,6 +940,12 @@ static const struct arm64_cpu_capabilities arm64_features[] = {
 		.type = ARM64_CPUCAP_SYSTEM_FEATURE,
 		.matches = has_no_hw_prefetch,
 	},
+	{
+		.desc = "Non-temporal stores for large memcpy",
+		.capability = ARM64_HAS_NT_MEMCPY,
+		.type = ARM64_CPUCAP_SYSTEM_FEATURE,
+		.matches = has_nt_memcpy,
+	},
 #ifdef CONFIG_ARM64_UAO
 	{
 		.desc = "User Access Override",
@@ -40,6 +40,7 @@
 
 #include "blk.h"
 #include "blk-mq.h"
+#include "blk-wbt.h"
 
 #include <linux/math64.h>
 
@@ -1416,6 +1417,8 @@ void __blk_put_request(struct request_queue *q, struct request *req)
 		return;
 	}
 
+	wbt_done(q, req);
+
 	blk_pm_put_request(req);
 
 	elv_completed_request(q, req);
@@ -1663,6 +1666,7 @@ static blk_qc_t blk_queue_bio(struct request_queue *q, struct bio *bio)
 	int el_ret, rw_flags = 0, where = ELEVATOR_INSERT_SORT;
 	struct request *req;
 	unsigned int request_count = 0;
+	bool wbt_counted;
 
 	/*
 	 * low level driver can indicate that it wants pages above a
@@ -1728,12 +1732,16 @@ static blk_qc_t blk_queue_bio(struct request_queue *q, struct bio *bio)
 	 */
 	rw_flags |= (bio->bi_opf & (REQ_META | REQ_PRIO));
 
+	wbt_counted = wbt_wait(q, bio, q->queue_lock);
+
 	/*
 	 * Grab a free request. This is might sleep but can not fail.
 	 * Returns with the queue unlocked.
 	 */
 	req = get_request(q, bio_data_dir(bio), rw_flags, bio, GFP_NOIO);
 	if (IS_ERR(req)) {
+		if (wbt_counted)
+			wbt_release(q);
 		bio->bi_error = PTR_ERR(req);
 		bio_endio(bio);
 		goto out_unlock;
@@ -1746,6 +1754,8 @@ static blk_qc_t blk_queue_bio(struct request_queue *q, struct bio *bio)
 	 * often, and the elevators are able to handle it.
 	 */
 	init_request_from_bio(req, bio);
+	if (wbt_counted)
+		req->cmd_flags |= REQ_WBT;
 
 	if (test_bit(QUEUE_FLAG_SAME_COMP, &q->queue_flags))
 		req->cpu = raw_smp_processor_id();
@@ -2108,6 +2118,8 @@ blk_qc_t submit_bio(struct bio *bio)
 				workingset_read = true;
 			task_io_account_read(bio->bi_iter.bi_size);
 			count_vm_events(PGPGIN, count);
+			if (unlikely(current->in_fault_io_boost))
+				bio->bi_opf |= REQ_PRIO;
 		}
 
 		if (unlikely(block_dump)) {
@@ -2298,6 +2310,14 @@ void blk_account_io_done(struct request *req)
 		struct hd_struct *part;
 		int cpu;
 
+		if (trace_block_rq_latency_enabled()) {
+			u64 start = rq_start_time_ns(req);
+
+			trace_block_rq_latency(req, start ?
+				sched_clock() - start :
+				(u64)jiffies_to_usecs(duration) * NSEC_PER_USEC);
+		}
+
 		cpu = part_stat_lock();
 		part = req->part;
 
@@ -2524,6 +2544,7 @@ void blk_start_request(struct request *req)
 
 	BUG_ON(test_bit(REQ_ATOM_COMPLETE, &req->atomic_flags));
 	blk_add_timer(req);
+	wbt_issue(req->q, req);
 }
 EXPORT_SYMBOL(blk_start_request);
 
@@ -0,0 +1,127 @@
+/*
+ * Interactive async request throttling for blk-mq queues
+ *
+ * blk-mq in this kernel runs without an I/O scheduler, so the read bias
+ * of elevators such as maple is lost once a device is driven through
+ * blk-mq. What is left to arbitrate is the tag space: a writeback burst
+ * can hold every tag and make the next sync read of the foreground app
+ * wait for writes to complete. While the display is on, async requests
+ * are therefore limited to async_depth tags, leaving the remainder for
+ * sync I/O. As with maple's longer expiries while the device sleeps, the
+ * limit is lifted once the display is off. Requests of the realtime I/O
+ * priority class are never throttled.
+ */
+#include <linux/kernel.h>
+#include <linux/blkdev.h>
+#include <linux/blk-mq.h>
+#include <linux/bio.h>
+#include <linux/init.h>
+#include <linux/ioprio.h>
+#include <linux/msm_drm_notify.h>
+#include <linux/sched.h>
+#include <linux/wait.h>
+
+#include "blk-mq.h"
+
+static bool display_on = true;
+
+static int msm_drm_notifier_cb(struct notifier_block *nb,
+			       unsigned long action, void *data)
+{
+	struct msm_drm_notifier *evdata = data;
+	int *blank = evdata->data;
+
+	if (action != MSM_DRM_EVENT_BLANK)
+		return NOTIFY_OK;
+
+	if (*blank == MSM_DRM_BLANK_UNBLANK)
+		WRITE_ONCE(display_on, true);
+	else if (*blank == MSM_DRM_BLANK_POWERDOWN)
+		WRITE_ONCE(display_on, false);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block msm_drm_notif = {
+	.notifier_call	= msm_drm_notifier_cb,
+	.priority	= INT_MAX,
+};
+
+void blk_mq_interactive_init(struct request_queue *q)
+{
+	/* leave a quarter of the tags to sync requests */
+	q->mq_async_depth = max(q->nr_requests - q->nr_requests / 4, 1UL);
+	atomic_set(&q->mq_async_inflight, 0);
+	init_waitqueue_head(&q->mq_async_wait);
+}
+
+static bool atomic_inc_below(atomic_t *v, unsigned int below)
+{
+	unsigned int cur = atomic_read(v);
+
+	for (;;) {
+		unsigned int old;
+
+		if (cur >= below)
+			return false;
+		old = atomic_cmpxchg(v, cur, cur + 1);
+		if (old == cur)
+			break;
+		cur = old;
+	}
+
+	return true;
+}
+
+static unsigned int blk_mq_async_limit(struct request_queue *q)
+{
+	/* throttling disabled or display off, only count the request */
+	if (!q->mq_async_depth || !READ_ONCE(display_on))
+		return UINT_MAX;
+
+	return q->mq_async_depth;
+}
+
+/*
+ * Returns true if the request about to be allocated for @bio is counted
+ * against the async depth, in which case blk_mq_interactive_done() has to
+ * be called once it is freed.
+ */
+bool blk_mq_interactive_wait(struct request_queue *q, struct bio *bio)
+{
+	DEFINE_WAIT(wait);
+
+	if (rw_is_sync(bio_op(bio), bio->bi_opf) ||
+	    IOPRIO_PRIO_CLASS(bio_prio(bio)) == IOPRIO_CLASS_RT)
+		return false;
+
+	if (atomic_inc_below(&q->mq_async_inflight, blk_mq_async_limit(q)))
+		return true;
+
+	do {
+		prepare_to_wait_exclusive(&q->mq_async_wait, &wait,
+					  TASK_UNINTERRUPTIBLE);
+		if (atomic_inc_below(&q->mq_async_inflight,
+				     blk_mq_async_limit(q)))
+			break;
+		io_schedule();
+	} while (1);
+	finish_wait(&q->mq_async_wait, &wait);
+
+	return true;
+}
+
+void blk_mq_interactive_done(struct request_queue *q)
+{
+	atomic_dec(&q->mq_async_inflight);
+	/* pairs with the barrier in prepare_to_wait_exclusive() */
+	smp_mb__after_atomic();
+	if (waitqueue_active(&q->mq_async_wait))
+		wake_up(&q->mq_async_wait);
+}
+
+static int __init blk_mq_interactive_late_init(void)
+{
+	return msm_drm_register_client(&msm_drm_notif);
+}
+late_initcall(blk_mq_interactive_late_init);
@@ -30,6 +30,7 @@
 #include "blk.h"
 #include "blk-mq.h"
 #include "blk-mq-tag.h"
+#include "blk-wbt.h"
 
 static DEFINE_MUTEX(all_q_mutex);
 static LIST_HEAD(all_q_list);
@@ -300,6 +301,9 @@ static void __blk_mq_free_request(struct blk_mq_hw_ctx *hctx,
 
 	if (rq->cmd_flags & REQ_MQ_INFLIGHT)
 		atomic_dec(&hctx->nr_active);
+	if (rq->cmd_flags & REQ_MQ_ASYNC)
+		blk_mq_interactive_done(q);
+	wbt_done(q, rq);
 	rq->cmd_flags = 0;
 
 	clear_bit(REQ_ATOM_STARTED, &rq->atomic_flags);
@@ -420,6 +424,7 @@ void blk_mq_start_request(struct request *rq)
 	struct request_queue *q = rq->q;
 
 	trace_block_rq_issue(q, rq);
+	wbt_issue(q, rq);
 
 	rq->resid_len = blk_rq_bytes(rq);
 	if (unlikely(blk_bidi_rq(rq)))
@@ -1194,6 +1199,11 @@ static struct request *blk_mq_map_request(struct request_queue *q,
 	int op = bio_data_dir(bio);
 	int op_flags = 0;
 	struct blk_mq_alloc_data alloc_data;
+	bool async_counted, wbt_counted;
+
+	/* may sleep, so wait before the ctx is pinned */
+	wbt_counted = wbt_wait(q, bio, NULL);
+	async_counted = blk_mq_interactive_wait(q, bio);
 
 	blk_queue_enter_live(q);
 	ctx = blk_mq_get_ctx(q);
@@ -1205,6 +1215,18 @@ static struct request *blk_mq_map_request(struct request_queue *q,
 	trace_block_getrq(q, bio, op);
 	blk_mq_set_alloc_data(&alloc_data, q, 0, ctx, hctx);
 	rq = __blk_mq_alloc_request(&alloc_data, op, op_flags);
+	if (async_counted) {
+		if (likely(rq))
+			rq->cmd_flags |= REQ_MQ_ASYNC;
+		else
+			blk_mq_interactive_done(q);
+	}
+	if (wbt_counted) {
+		if (likely(rq))
+			rq->cmd_flags |= REQ_WBT;
+		else
+			wbt_release(q);
+	}
 
 	data->hctx = alloc_data.hctx;
 	data->ctx = alloc_data.ctx;
@@ -2013,6 +2035,7 @@ struct request_queue *blk_mq_init_allocated_queue(struct blk_mq_tag_set *set,
 	 * Do this after blk_queue_make_request() overrides it...
 	 */
 	q->nr_requests = set->queue_depth;
+	blk_mq_interactive_init(q);
 
 	if (set->ops->complete)
 		blk_queue_softirq_done(q, set->ops->complete);
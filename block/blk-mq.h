@@ -106,4 +106,25 @@ static inline bool blk_mq_hw_queue_mapped(struct blk_mq_hw_ctx *hctx)
 	return hctx->nr_ctx && hctx->tags;
 }
 
+/*
+ * Interactive async request throttling
+ */
+#ifdef CONFIG_BLK_MQ_INTERACTIVE
+extern void blk_mq_interactive_init(struct request_queue *q);
+extern bool blk_mq_interactive_wait(struct request_queue *q, struct bio *bio);
+extern void blk_mq_interactive_done(struct request_queue *q);
+#else
+static inline void blk_mq_interactive_init(struct request_queue *q)
+{
+}
+static inline bool blk_mq_interactive_wait(struct request_queue *q,
+					   struct bio *bio)
+{
+	return false;
+}
+static inline void blk_mq_interactive_done(struct request_queue *q)
+{
+}
+#endif
+
 #endif
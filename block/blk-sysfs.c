@@ -13,6 +13,7 @@
 
 #include "blk.h"
 #include "blk-mq.h"
+#include "blk-wbt.h"
 
 struct queue_sysfs_entry {
 	struct attribute attr;
@@ -382,6 +383,65 @@ static ssize_t queue_wc_store(struct request_queue *q, const char *page,
 	return count;
 }
 
+#ifdef CONFIG_BLK_MQ_INTERACTIVE
+static ssize_t queue_async_depth_show(struct request_queue *q, char *page)
+{
+	if (!q->mq_ops)
+		return -EINVAL;
+
+	return queue_var_show(q->mq_async_depth, page);
+}
+
+static ssize_t queue_async_depth_store(struct request_queue *q,
+				       const char *page, size_t count)
+{
+	unsigned long depth;
+	ssize_t ret;
+
+	if (!q->mq_ops)
+		return -EINVAL;
+
+	ret = queue_var_store(&depth, page, count);
+	if (ret < 0)
+		return ret;
+
+	/* 0 disables throttling */
+	q->mq_async_depth = min(depth, q->nr_requests);
+	wake_up_all(&q->mq_async_wait);
+
+	return ret;
+}
+#endif
+
+#ifdef CONFIG_BLK_WBT
+static ssize_t queue_wbt_lat_show(struct request_queue *q, char *page)
+{
+	if (!q->rq_wb)
+		return -EINVAL;
+
+	return sprintf(page, "%llu\n", wbt_get_lat_usec(q));
+}
+
+static ssize_t queue_wbt_lat_store(struct request_queue *q, const char *page,
+				   size_t count)
+{
+	unsigned long lat;
+	ssize_t ret;
+	int err;
+
+	ret = queue_var_store(&lat, page, count);
+	if (ret < 0)
+		return ret;
+
+	/* 0 disables throttling */
+	err = wbt_set_lat_usec(q, lat);
+	if (err)
+		return err;
+
+	return ret;
+}
+#endif
+
 static ssize_t queue_dax_show(struct request_queue *q, char *page)
 {
 	return queue_var_show(blk_queue_dax(q), page);
@@ -531,6 +591,22 @@ static struct queue_sysfs_entry queue_dax_entry = {
 	.show = queue_dax_show,
 };
 
+#ifdef CONFIG_BLK_MQ_INTERACTIVE
+static struct queue_sysfs_entry queue_async_depth_entry = {
+	.attr = {.name = "async_depth", .mode = S_IRUGO | S_IWUSR },
+	.show = queue_async_depth_show,
+	.store = queue_async_depth_store,
+};
+#endif
+
+#ifdef CONFIG_BLK_WBT
+static struct queue_sysfs_entry queue_wbt_lat_entry = {
+	.attr = {.name = "wbt_lat_usec", .mode = S_IRUGO | S_IWUSR },
+	.show = queue_wbt_lat_show,
+	.store = queue_wbt_lat_store,
+};
+#endif
+
 static struct attribute *default_attrs[] = {
 	&queue_requests_entry.attr,
 #ifdef CONFIG_READAHEAD
@@ -560,6 +636,12 @@ static struct attribute *default_attrs[] = {
 	&queue_poll_entry.attr,
 	&queue_wc_entry.attr,
 	&queue_dax_entry.attr,
+#ifdef CONFIG_BLK_MQ_INTERACTIVE
+	&queue_async_depth_entry.attr,
+#endif
+#ifdef CONFIG_BLK_WBT
+	&queue_wbt_lat_entry.attr,
+#endif
 	NULL,
 };
 
@@ -636,6 +718,7 @@ static void blk_release_queue(struct kobject *kobj)
 
 	bdi_put(q->backing_dev_info);
 	blkcg_exit_queue(q);
+	wbt_exit(q);
 
 	if (q->elevator) {
 		spin_lock_irq(q->queue_lock);
@@ -710,6 +793,8 @@ int blk_register_queue(struct gendisk *disk)
 
 	kobject_uevent(&q->kobj, KOBJ_ADD);
 
+	wbt_init(q);
+
 	if (q->mq_ops)
 		blk_mq_register_dev(dev, q);
 
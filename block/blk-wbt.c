@@ -0,0 +1,257 @@
+/*
+ * Writeback throttling against a read latency target
+ *
+ * Flash read latency goes up steeply once the device is saturated with
+ * writes, so a large download or app update makes every page fault and
+ * database read of the foreground app slower. This limits the number of
+ * async writes a queue may have in flight and adjusts that limit once per
+ * window from the latency of the reads completed during the window: if
+ * more than one in a hundred of them took longer than the target, the
+ * limit is halved; if none did, or there were no reads to wait for, it
+ * is doubled again up to three quarters of the queue depth.
+ *
+ * Read latency is measured from issue to the driver, the time spent in
+ * the elevator says nothing about how busy the device is. Sync writes
+ * (fsync, O_DIRECT), flushes and the realtime I/O priority class are
+ * never throttled. It covers both legacy and blk-mq queues; the target
+ * is set per queue through the wbt_lat_usec sysfs attribute and
+ * defaults to 2ms on non-rotational devices, 0 disables throttling.
+ */
+#include <linux/kernel.h>
+#include <linux/blkdev.h>
+#include <linux/bio.h>
+#include <linux/ioprio.h>
+#include <linux/ktime.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/timer.h>
+#include <linux/wait.h>
+
+#include "blk-wbt.h"
+
+#define WBT_DEF_LAT_NSEC	(2 * NSEC_PER_MSEC)
+#define WBT_WINDOW_MSEC		100
+/* fewer reads than this in a window say nothing about their latency */
+#define WBT_MIN_SAMPLES		8
+
+struct rq_wb {
+	struct request_queue *q;
+	u64 min_lat_nsec;		/* read latency target, 0 disables */
+	unsigned int scale_step;
+	unsigned int depth;		/* async writes allowed in flight */
+	atomic_t inflight;
+	atomic_t nr_reads;		/* reads completed in this window */
+	atomic_t nr_slow;		/* ... that missed the target */
+	struct timer_list window_timer;
+	wait_queue_head_t wait;
+};
+
+static unsigned int wbt_max_depth(struct rq_wb *rwb)
+{
+	return max(rwb->q->nr_requests - rwb->q->nr_requests / 4, 1UL);
+}
+
+static unsigned int wbt_limit(struct rq_wb *rwb)
+{
+	if (!READ_ONCE(rwb->min_lat_nsec))
+		return UINT_MAX;
+
+	return READ_ONCE(rwb->depth);
+}
+
+static void wbt_arm_window(struct rq_wb *rwb)
+{
+	if (!timer_pending(&rwb->window_timer))
+		mod_timer(&rwb->window_timer,
+			  jiffies + msecs_to_jiffies(WBT_WINDOW_MSEC));
+}
+
+static void wbt_window_fn(unsigned long data)
+{
+	struct rq_wb *rwb = (struct rq_wb *)data;
+	unsigned int max_depth = wbt_max_depth(rwb);
+	unsigned int reads = atomic_xchg(&rwb->nr_reads, 0);
+	unsigned int slow = atomic_xchg(&rwb->nr_slow, 0);
+
+	if (reads >= WBT_MIN_SAMPLES && slow * 100 > reads) {
+		if ((max_depth >> rwb->scale_step) > 1)
+			rwb->scale_step++;
+	} else if (!slow && rwb->scale_step) {
+		rwb->scale_step--;
+	}
+
+	WRITE_ONCE(rwb->depth, max(max_depth >> rwb->scale_step, 1U));
+	wake_up_all(&rwb->wait);
+
+	if (rwb->scale_step || atomic_read(&rwb->inflight))
+		wbt_arm_window(rwb);
+}
+
+static bool wbt_should_throttle(struct bio *bio)
+{
+	if (bio_op(bio) != REQ_OP_WRITE)
+		return false;
+	if (bio->bi_opf & (REQ_SYNC | REQ_PREFLUSH | REQ_FUA))
+		return false;
+
+	return IOPRIO_PRIO_CLASS(bio_prio(bio)) != IOPRIO_CLASS_RT;
+}
+
+static bool atomic_inc_below(atomic_t *v, unsigned int below)
+{
+	unsigned int cur = atomic_read(v);
+
+	for (;;) {
+		unsigned int old;
+
+		if (cur >= below)
+			return false;
+		old = atomic_cmpxchg(v, cur, cur + 1);
+		if (old == cur)
+			break;
+		cur = old;
+	}
+
+	return true;
+}
+
+/*
+ * Returns true if the request about to be allocated for @bio is counted
+ * against the writeback depth, in which case it has to be flagged
+ * REQ_WBT, or handed back with wbt_release() if the allocation fails.
+ * @lock, if given, is the irq disabled queue lock held by the caller and
+ * is dropped while waiting.
+ */
+bool wbt_wait(struct request_queue *q, struct bio *bio, spinlock_t *lock)
+{
+	struct rq_wb *rwb = q->rq_wb;
+	DEFINE_WAIT(wait);
+
+	if (!rwb || !READ_ONCE(rwb->min_lat_nsec) || !wbt_should_throttle(bio))
+		return false;
+
+	wbt_arm_window(rwb);
+
+	if (atomic_inc_below(&rwb->inflight, wbt_limit(rwb)))
+		return true;
+
+	if (lock)
+		spin_unlock_irq(lock);
+
+	do {
+		prepare_to_wait_exclusive(&rwb->wait, &wait,
+					  TASK_UNINTERRUPTIBLE);
+		if (atomic_inc_below(&rwb->inflight, wbt_limit(rwb)))
+			break;
+		io_schedule();
+	} while (1);
+	finish_wait(&rwb->wait, &wait);
+
+	if (lock)
+		spin_lock_irq(lock);
+
+	return true;
+}
+
+void wbt_release(struct request_queue *q)
+{
+	struct rq_wb *rwb = q->rq_wb;
+
+	atomic_dec(&rwb->inflight);
+	/* pairs with the barrier in prepare_to_wait_exclusive() */
+	smp_mb__after_atomic();
+	if (waitqueue_active(&rwb->wait))
+		wake_up(&rwb->wait);
+}
+
+void wbt_issue(struct request_queue *q, struct request *rq)
+{
+	struct rq_wb *rwb = q->rq_wb;
+
+	rq->wbt_issue_ns = 0;
+	if (rwb && READ_ONCE(rwb->min_lat_nsec) &&
+	    !blk_rq_is_passthrough(rq) && rq_data_dir(rq) == READ)
+		rq->wbt_issue_ns = ktime_get_ns();
+}
+
+void wbt_done(struct request_queue *q, struct request *rq)
+{
+	struct rq_wb *rwb = q->rq_wb;
+	u64 lat;
+
+	if (!rwb)
+		return;
+
+	if (rq->cmd_flags & REQ_WBT) {
+		rq->cmd_flags &= ~REQ_WBT;
+		wbt_release(q);
+	} else if (rq->wbt_issue_ns) {
+		lat = ktime_get_ns() - rq->wbt_issue_ns;
+		rq->wbt_issue_ns = 0;
+		atomic_inc(&rwb->nr_reads);
+		if (lat > READ_ONCE(rwb->min_lat_nsec))
+			atomic_inc(&rwb->nr_slow);
+		wbt_arm_window(rwb);
+	}
+}
+
+u64 wbt_get_lat_usec(struct request_queue *q)
+{
+	return div_u64(READ_ONCE(q->rq_wb->min_lat_nsec), NSEC_PER_USEC);
+}
+
+int wbt_set_lat_usec(struct request_queue *q, u64 lat_usec)
+{
+	struct rq_wb *rwb = q->rq_wb;
+
+	if (!rwb)
+		return -EINVAL;
+
+	/* start over at full depth with the new target */
+	del_timer_sync(&rwb->window_timer);
+	rwb->scale_step = 0;
+	WRITE_ONCE(rwb->depth, wbt_max_depth(rwb));
+	atomic_set(&rwb->nr_reads, 0);
+	atomic_set(&rwb->nr_slow, 0);
+	WRITE_ONCE(rwb->min_lat_nsec, lat_usec * NSEC_PER_USEC);
+	wake_up_all(&rwb->wait);
+
+	return 0;
+}
+
+void wbt_init(struct request_queue *q)
+{
+	struct rq_wb *rwb;
+
+	/* bio based drivers have no requests to count */
+	if (q->rq_wb || (!q->request_fn && !q->mq_ops))
+		return;
+
+	rwb = kzalloc(sizeof(*rwb), GFP_KERNEL);
+	if (!rwb)
+		return;
+
+	rwb->q = q;
+	rwb->depth = wbt_max_depth(rwb);
+	if (blk_queue_nonrot(q))
+		rwb->min_lat_nsec = WBT_DEF_LAT_NSEC;
+	atomic_set(&rwb->inflight, 0);
+	atomic_set(&rwb->nr_reads, 0);
+	atomic_set(&rwb->nr_slow, 0);
+	setup_timer(&rwb->window_timer, wbt_window_fn, (unsigned long)rwb);
+	init_waitqueue_head(&rwb->wait);
+
+	q->rq_wb = rwb;
+}
+
+void wbt_exit(struct request_queue *q)
+{
+	struct rq_wb *rwb = q->rq_wb;
+
+	if (!rwb)
+		return;
+
+	del_timer_sync(&rwb->window_timer);
+	q->rq_wb = NULL;
+	kfree(rwb);
+}
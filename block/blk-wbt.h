@@ -0,0 +1,42 @@
+#ifndef BLK_WBT_H
+#define BLK_WBT_H
+
+#include <linux/blkdev.h>
+
+/*
+ * Writeback throttling against a read latency target
+ */
+#ifdef CONFIG_BLK_WBT
+extern void wbt_init(struct request_queue *q);
+extern void wbt_exit(struct request_queue *q);
+extern bool wbt_wait(struct request_queue *q, struct bio *bio,
+		     spinlock_t *lock);
+extern void wbt_release(struct request_queue *q);
+extern void wbt_issue(struct request_queue *q, struct request *rq);
+extern void wbt_done(struct request_queue *q, struct request *rq);
+extern u64 wbt_get_lat_usec(struct request_queue *q);
+extern int wbt_set_lat_usec(struct request_queue *q, u64 lat_usec);
+#else
+static inline void wbt_init(struct request_queue *q)
+{
+}
+static inline void wbt_exit(struct request_queue *q)
+{
+}
+static inline bool wbt_wait(struct request_queue *q, struct bio *bio,
+			    spinlock_t *lock)
+{
+	return false;
+}
+static inline void wbt_release(struct request_queue *q)
+{
+}
+static inline void wbt_issue(struct request_queue *q, struct request *rq)
+{
+}
+static inline void wbt_done(struct request_queue *q, struct request *rq)
+{
+}
+#endif
+
+#endif
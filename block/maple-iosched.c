@@ -88,6 +88,16 @@ maple_add_request(struct request_queue *q, struct request *rq)
 	/* increase expiration when device is asleep */
 	unsigned int fifo_expire_suspended = mdata->fifo_expire[sync][dir] * sleep_latency_multiple;
 
+	/*
+	 * Reads a foreground fault is waiting on jump the queue, the
+	 * dispatcher picks them up ahead of the batch.
+	 */
+	if ((rq->cmd_flags & REQ_PRIO) && sync && dir == READ) {
+		rq->fifo_time = jiffies;
+		list_add(&rq->queuelist, &mdata->fifo_list[SYNC][READ]);
+		return;
+	}
+
 	/*
 	 * Add request to the proper fifo list and set its
 	 * expire time.
@@ -212,11 +222,18 @@ maple_dispatch_requests(struct request_queue *q, int force)
 	struct request *rq = NULL;
 	int data_dir = READ;
 
+	/* Prioritized reads are kept at the head of the sync read fifo */
+	if (!list_empty(&mdata->fifo_list[SYNC][READ])) {
+		rq = rq_entry_fifo(mdata->fifo_list[SYNC][READ].next);
+		if (!(rq->cmd_flags & REQ_PRIO))
+			rq = NULL;
+	}
+
 	/*
 	 * Retrieve any expired request after a batch of
 	 * sequential requests.
 	 */
-	if (mdata->batched >= mdata->fifo_batch)
+	if (!rq && mdata->batched >= mdata->fifo_batch)
 		rq = maple_choose_expired_request(mdata);
 
 	/* Retrieve request */
@@ -26,6 +26,8 @@
 #include <linux/pm_runtime.h>
 #include <linux/pinctrl/devinfo.h>
 
+#include <soc/qcom/boot_stats.h>
+
 #include "base.h"
 #include "power/power.h"
 
@@ -524,6 +526,7 @@ EXPORT_SYMBOL_GPL(wait_for_device_probe);
 int driver_probe_device(struct device_driver *drv, struct device *dev)
 {
 	int ret = 0;
+	ktime_t calltime;
 
 	if (!device_is_registered(dev))
 		return -ENODEV;
@@ -535,7 +538,12 @@ int driver_probe_device(struct device_driver *drv, struct device *dev)
 		pm_runtime_get_sync(dev->parent);
 
 	pm_runtime_barrier(dev);
+	calltime = ktime_get();
 	ret = really_probe(dev, drv);
+	if (boot_marker_enabled())
+		place_duration_marker(ktime_us_delta(ktime_get(), calltime),
+				      "D - %s probe%s - ", drv->name,
+				      dev->driver ? "" : " (unbound)");
 	pm_request_idle(dev);
 
 	if (dev->parent)
@@ -544,6 +552,30 @@ int driver_probe_device(struct device_driver *drv, struct device *dev)
 	return ret;
 }
 
+/*
+ * Comma separated list of built-in drivers that should probe
+ * asynchronously, e.g. "driver_async_probe=drv1,drv2". Lets slow probes
+ * that wait on regulators, firmware or buses overlap with the rest of
+ * the initcalls without touching the drivers themselves.
+ */
+#define ASYNC_DRV_NAMES_MAX_LEN	256
+static char async_probe_drv_names[ASYNC_DRV_NAMES_MAX_LEN];
+
+static int __init save_async_options(char *buf)
+{
+	if (strlen(buf) >= ASYNC_DRV_NAMES_MAX_LEN)
+		pr_warn("Too long list of driver names for 'driver_async_probe'!\n");
+
+	strlcpy(async_probe_drv_names, buf, ASYNC_DRV_NAMES_MAX_LEN);
+	return 0;
+}
+__setup("driver_async_probe=", save_async_options);
+
+static bool cmdline_requested_async_probing(const char *drv_name)
+{
+	return parse_option_str(async_probe_drv_names, drv_name);
+}
+
 bool driver_allows_async_probing(struct device_driver *drv)
 {
 	switch (drv->probe_type) {
@@ -554,6 +586,9 @@ bool driver_allows_async_probing(struct device_driver *drv)
 		return false;
 
 	default:
+		if (cmdline_requested_async_probing(drv->name))
+			return true;
+
 		if (module_requested_async_probing(drv->owner))
 			return true;
 
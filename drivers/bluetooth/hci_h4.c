@@ -167,6 +167,35 @@ int __exit h4_deinit(void)
 	return hci_uart_unregister_proto(&h4p);
 }
 
+/* Size the buffer for the packet when its header is already at hand, so
+ * that small events and short ACL fragments do not each take a buffer of
+ * the maximum packet size from the atomic pool.
+ */
+static unsigned int h4_recv_size(const struct h4_recv_pkt *pkt,
+				 const unsigned char *hdr, int count)
+{
+	unsigned int len;
+
+	if (count < pkt->hlen)
+		return pkt->maxlen;
+
+	switch (pkt->lsize) {
+	case 0:
+		len = pkt->hlen;
+		break;
+	case 1:
+		len = pkt->hlen + hdr[pkt->loff];
+		break;
+	case 2:
+		len = pkt->hlen + get_unaligned_le16(hdr + pkt->loff);
+		break;
+	default:
+		return pkt->maxlen;
+	}
+
+	return min_t(unsigned int, len, pkt->maxlen);
+}
+
 struct sk_buff *h4_recv_buf(struct hci_dev *hdev, struct sk_buff *skb,
 			    const unsigned char *buffer, int count,
 			    const struct h4_recv_pkt *pkts, int pkts_count)
@@ -179,7 +208,9 @@ struct sk_buff *h4_recv_buf(struct hci_dev *hdev, struct sk_buff *skb,
 				if (buffer[0] != (&pkts[i])->type)
 					continue;
 
-				skb = bt_skb_alloc((&pkts[i])->maxlen,
+				skb = bt_skb_alloc(h4_recv_size(&pkts[i],
+								buffer + 1,
+								count - 1),
 						   GFP_ATOMIC);
 				if (!skb)
 					return ERR_PTR(-ENOMEM);
@@ -576,7 +576,11 @@ static void hci_uart_tty_receive(struct tty_struct *tty, const u8 *data,
 	if (hu->hdev)
 		hu->hdev->stat.byte_rx += count;
 
-	tty_unthrottle(tty);
+	/* tty_unthrottle() takes the termios lock even when there is nothing
+	 * to do, keep that off the receive path unless we were throttled.
+	 */
+	if (test_bit(TTY_THROTTLED, &tty->flags))
+		tty_unthrottle(tty);
 }
 
 static int hci_uart_register_dev(struct hci_uart *hu)
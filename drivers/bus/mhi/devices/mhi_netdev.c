@@ -98,6 +98,7 @@ struct mhi_netdev {
 	u32 order;
 	const char *interface_name;
 	struct napi_struct *napi;
+	u32 napi_weight;
 	struct net_device *ndev;
 
 	struct list_head *recycle_pool;
@@ -120,6 +121,7 @@ struct mhi_netdev {
 
 	/* debug stats */
 	u32 abuffers, kbuffers, rbuffers;
+	u32 budget_hits; /* polls that used the whole budget */
 };
 
 struct mhi_netdev_priv {
@@ -509,6 +511,8 @@ static int mhi_netdev_poll(struct napi_struct *napi, int budget)
 	/* complete work if # of packet processed less than allocated budget */
 	if (rx_work < budget)
 		napi_complete(napi);
+	else
+		mhi_netdev->budget_hits++;
 
 	MSG_VERB("polled %d pkts\n", rx_work);
 
@@ -729,7 +733,7 @@ static int mhi_netdev_enable_iface(struct mhi_netdev *mhi_netdev)
 	}
 
 	netif_napi_add(mhi_netdev->ndev, mhi_netdev->napi,
-		       mhi_netdev_poll, NAPI_POLL_WEIGHT);
+		       mhi_netdev_poll, mhi_netdev->napi_weight);
 	ret = register_netdev(mhi_netdev->ndev);
 	if (ret) {
 		MSG_ERR("Network device registration failed\n");
@@ -855,11 +859,12 @@ static int mhi_netdev_debugfs_stats_show(struct seq_file *m, void *d)
 	struct mhi_netdev *mhi_netdev = m->private;
 
 	seq_printf(m,
-		   "mru:%u order:%u pool_size:%d, bg_pool_size:%d bg_pool_limit:%d abuf:%u kbuf:%u rbuf:%u\n",
+		   "mru:%u order:%u pool_size:%d, bg_pool_size:%d bg_pool_limit:%d abuf:%u kbuf:%u rbuf:%u napi_weight:%u budget_hits:%u\n",
 		   mhi_netdev->mru, mhi_netdev->order, mhi_netdev->pool_size,
 		   mhi_netdev->bg_pool_size, mhi_netdev->bg_pool_limit,
 		   mhi_netdev->abuffers, mhi_netdev->kbuffers,
-		   mhi_netdev->rbuffers);
+		   mhi_netdev->rbuffers, mhi_netdev->napi_weight,
+		   mhi_netdev->budget_hits);
 
 	return 0;
 }
@@ -1034,6 +1039,13 @@ static int mhi_netdev_probe(struct mhi_device *mhi_dev,
 		put_device(dev);
 	} else {
 		mhi_netdev->msg_lvl = MHI_MSG_LVL_ERROR;
+
+		/* per event ring poll budget, larger for high rate channels */
+		if (of_property_read_u32(of_node, "mhi,napi-weight",
+					 &mhi_netdev->napi_weight) ||
+		    !mhi_netdev->napi_weight)
+			mhi_netdev->napi_weight = NAPI_POLL_WEIGHT;
+
 		no_chain = of_property_read_bool(of_node,
 						 "mhi,disable-chain-skb");
 		if (!no_chain) {
@@ -22,6 +22,7 @@
 #include <linux/cdev.h>
 #include <linux/list.h>
 #include <linux/hash.h>
+#include <linux/hashtable.h>
 #include <linux/msm_ion.h>
 #include <soc/qcom/secure_buffer.h>
 #include <soc/qcom/glink.h>
@@ -78,6 +79,7 @@
 #define NUM_SESSIONS	9	/*8 compute, 1 cpz*/
 #define M_FDLIST	(16)
 #define M_CRCLIST	(64)
+#define FASTRPC_MAP_HASH_BITS	(5)
 #define SESSION_ID_INDEX (30)
 #define FASTRPC_CTX_MAGIC (0xbeeddeed)
 #define FASTRPC_CTX_MAX (256)
@@ -344,6 +346,7 @@ struct fastrpc_apps {
 
 struct fastrpc_mmap {
 	struct hlist_node hn;
+	struct hlist_node hn_fd;	/* fl->map_hash, keyed by fd */
 	struct fastrpc_file *fl;
 	struct fastrpc_apps *apps;
 	int fd;
@@ -395,6 +398,7 @@ struct fastrpc_file {
 	struct hlist_node hn;
 	spinlock_t hlock;
 	struct hlist_head maps;
+	DECLARE_HASHTABLE(map_hash, FASTRPC_MAP_HASH_BITS);
 	struct hlist_head cached_bufs;
 	struct hlist_head remote_bufs;
 	struct fastrpc_ctx_lst clst;
@@ -621,6 +625,7 @@ static void fastrpc_mmap_add(struct fastrpc_mmap *map)
 		struct fastrpc_file *fl = map->fl;
 
 		hlist_add_head(&map->hn, &fl->maps);
+		hash_add(fl->map_hash, &map->hn_fd, map->fd);
 	}
 }
 
@@ -654,7 +659,7 @@ static int fastrpc_mmap_find(struct fastrpc_file *fl, int fd,
 		}
 		spin_unlock(&me->hlock);
 	} else {
-		hlist_for_each_entry_safe(map, n, &fl->maps, hn) {
+		hash_for_each_possible(fl->map_hash, map, hn_fd, fd) {
 			if (va >= map->va &&
 				va + len <= map->va + map->len &&
 				map->fd == fd) {
@@ -732,6 +737,7 @@ static int fastrpc_mmap_remove(struct fastrpc_file *fl, uintptr_t va,
 			!map->is_filemap) {
 			match = map;
 			hlist_del_init(&map->hn);
+			hash_del(&map->hn_fd);
 			break;
 		}
 	}
@@ -780,8 +786,10 @@ static void fastrpc_mmap_free(struct fastrpc_mmap *map, uint32_t flags)
 			return;
 	} else {
 		map->refs--;
-		if (!map->refs)
+		if (!map->refs) {
 			hlist_del_init(&map->hn);
+			hash_del(&map->hn_fd);
+		}
 		if (map->refs > 0 && !flags)
 			return;
 	}
@@ -870,6 +878,7 @@ static int fastrpc_mmap_create(struct fastrpc_file *fl, int fd,
 	if (err)
 		goto bail;
 	INIT_HLIST_NODE(&map->hn);
+	INIT_HLIST_NODE(&map->hn_fd);
 	map->flags = mflags;
 	map->refs = 1;
 	map->fl = fl;
@@ -3235,6 +3244,7 @@ static int fastrpc_file_free(struct fastrpc_file *fl)
 		lmap = NULL;
 		hlist_for_each_entry_safe(map, n, &fl->maps, hn) {
 			hlist_del_init(&map->hn);
+			hash_del(&map->hn_fd);
 			lmap = map;
 			break;
 		}
@@ -3749,6 +3759,7 @@ static int fastrpc_device_open(struct inode *inode, struct file *filp)
 	context_list_ctor(&fl->clst);
 	spin_lock_init(&fl->hlock);
 	INIT_HLIST_HEAD(&fl->maps);
+	hash_init(fl->map_hash);
 	INIT_HLIST_HEAD(&fl->perf);
 	INIT_HLIST_HEAD(&fl->cached_bufs);
 	INIT_HLIST_HEAD(&fl->remote_bufs);
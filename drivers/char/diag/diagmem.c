@@ -19,6 +19,7 @@
 #include <linux/kmemleak.h>
 #include <linux/ratelimit.h>
 #include <linux/atomic.h>
+#include <linux/percpu.h>
 #include <linux/slab.h>
 #include <linux/of.h>
 #include <linux/kmemleak.h>
@@ -163,7 +164,9 @@ void *diagmem_alloc(struct diagchar_dev *driver, int size, int pool_type)
 	void *buf = NULL;
 	int i = 0;
 	unsigned long flags;
+	bool reserved = false;
 	struct diag_mempool_t *mempool = NULL;
+	struct diag_mempool_pcp *pcp;
 
 	if (!driver)
 		return NULL;
@@ -185,10 +188,22 @@ void *diagmem_alloc(struct diagchar_dev *driver, int size, int pool_type)
 		spin_lock_irqsave(&mempool->lock, flags);
 		if (mempool->count < mempool->poolsize) {
 			atomic_add(1, (atomic_t *)&mempool->count);
+			reserved = true;
+			pcp = this_cpu_ptr(mempool->pcp);
+			if (pcp->nr)
+				buf = pcp->buf[--pcp->nr];
+		}
+		spin_unlock_irqrestore(&mempool->lock, flags);
+		/* Only go to the allocator, outside the lock, on a miss */
+		if (reserved && !buf) {
 			buf = mempool_alloc(mempool->pool, GFP_ATOMIC);
 			kmemleak_not_leak(buf);
+			if (!buf) {
+				spin_lock_irqsave(&mempool->lock, flags);
+				atomic_add(-1, (atomic_t *)&mempool->count);
+				spin_unlock_irqrestore(&mempool->lock, flags);
+			}
 		}
-		spin_unlock_irqrestore(&mempool->lock, flags);
 		if (!buf) {
 			pr_debug_ratelimited("diag: Unable to allocate buffer from memory pool %s, size: %d/%d count: %d/%d\n",
 					     mempool->name,
@@ -207,6 +222,7 @@ void diagmem_free(struct diagchar_dev *driver, void *buf, int pool_type)
 	int i = 0;
 	unsigned long flags;
 	struct diag_mempool_t *mempool = NULL;
+	struct diag_mempool_pcp *pcp;
 
 	if (!driver || !buf)
 		return;
@@ -222,13 +238,20 @@ void diagmem_free(struct diagchar_dev *driver, void *buf, int pool_type)
 		}
 		spin_lock_irqsave(&mempool->lock, flags);
 		if (mempool->count > 0 && buf) {
-			mempool_free(buf, mempool->pool);
 			atomic_add(-1, (atomic_t *)&mempool->count);
+			pcp = this_cpu_ptr(mempool->pcp);
+			if (pcp->nr < DIAG_MEMPOOL_PCP_SZ) {
+				pcp->buf[pcp->nr++] = buf;
+				buf = NULL;
+			}
 		} else {
 			pr_err_ratelimited("diag: Attempting to free items from %s mempool which is already empty\n",
 					   mempool->name);
+			buf = NULL;
 		}
 		spin_unlock_irqrestore(&mempool->lock, flags);
+		if (buf)
+			mempool_free(buf, mempool->pool);
 		break;
 	}
 }
@@ -258,12 +281,21 @@ void diagmem_init(struct diagchar_dev *driver, int index)
 		return;
 	}
 
+	mempool->pcp = alloc_percpu(struct diag_mempool_pcp);
+	if (!mempool->pcp) {
+		pr_err("diag: cannot allocate %s mempool\n", mempool->name);
+		return;
+	}
+
 	mempool->pool = mempool_create_kmalloc_pool(mempool->poolsize,
 						    mempool->itemsize);
-	if (!mempool->pool)
+	if (!mempool->pool) {
 		pr_err("diag: cannot allocate %s mempool\n", mempool->name);
-	else
+		free_percpu(mempool->pcp);
+		mempool->pcp = NULL;
+	} else {
 		kmemleak_not_leak(mempool->pool);
+	}
 
 	spin_lock_init(&mempool->lock);
 }
@@ -272,6 +304,8 @@ void diagmem_exit(struct diagchar_dev *driver, int index)
 {
 	unsigned long flags;
 	struct diag_mempool_t *mempool = NULL;
+	struct diag_mempool_pcp *pcp;
+	int cpu;
 
 	if (!driver)
 		return;
@@ -284,6 +318,14 @@ void diagmem_exit(struct diagchar_dev *driver, int index)
 	mempool = &diag_mempools[index];
 	spin_lock_irqsave(&mempool->lock, flags);
 	if (mempool->count == 0 && mempool->pool != NULL) {
+		for_each_possible_cpu(cpu) {
+			pcp = per_cpu_ptr(mempool->pcp, cpu);
+			while (pcp->nr)
+				mempool_free(pcp->buf[--pcp->nr],
+					     mempool->pool);
+		}
+		free_percpu(mempool->pcp);
+		mempool->pcp = NULL;
 		mempool_destroy(mempool->pool);
 		mempool->pool = NULL;
 	} else {
@@ -41,6 +41,13 @@
 
 #define DIAG_MEMPOOL_NAME_SZ		24
 #define DIAG_MEMPOOL_GET_NAME(x)	(diag_mempools[x].name)
+#define DIAG_MEMPOOL_PCP_SZ		4
+
+/* Per-CPU stash of free items, kept out of the mempool */
+struct diag_mempool_pcp {
+	int nr;
+	void *buf[DIAG_MEMPOOL_PCP_SZ];
+};
 
 struct diag_mempool_t {
 	int id;
@@ -50,6 +57,7 @@ struct diag_mempool_t {
 	unsigned int poolsize;
 	int count;
 	spinlock_t lock;
+	struct diag_mempool_pcp __percpu *pcp;
 } __packed;
 
 extern struct diag_mempool_t diag_mempools[NUM_MEMORY_POOLS];
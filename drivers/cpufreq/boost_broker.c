@@ -0,0 +1,289 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Single event source for CPU, devfreq and SchedTune input boosting.
+ *
+ * cpu_input_boost and devfreq_boost normally register their own input
+ * handler and DRM notifier, and each run their own unboost timer. With the
+ * broker enabled, input and screen events are received once here and fanned
+ * out to every boost target from a single work item on a shared timeline.
+ * Unboosting is ordered so that memory bandwidth is only dropped after the
+ * CPU boost has ended.
+ */
+
+#define pr_fmt(fmt) "boost_broker: " fmt
+
+#include <linux/cpu_input_boost.h>
+#include <linux/devfreq_boost.h>
+#include <linux/input.h>
+#include <linux/moduleparam.h>
+#include <linux/msm_drm_notify.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+
+static unsigned short input_boost_duration = CONFIG_INPUT_BOOST_DURATION_MS;
+static unsigned short devfreq_unboost_delay = CONFIG_BOOST_BROKER_DEVFREQ_DELAY_MS;
+module_param(input_boost_duration, short, 0644);
+module_param(devfreq_unboost_delay, short, 0644);
+
+#ifdef CONFIG_DYNAMIC_STUNE_BOOST
+static int stune_boost;
+module_param(stune_boost, int, 0644);
+#endif
+
+struct boost_broker {
+	struct workqueue_struct *wq;
+	struct work_struct boost;
+	struct delayed_work cpu_unboost;
+	struct delayed_work df_unboost;
+	struct notifier_block msm_drm_notif;
+	bool screen_awake;
+	bool cpu_boosted;
+	bool df_boosted;
+#ifdef CONFIG_DYNAMIC_STUNE_BOOST
+	bool stune_active;
+	int stune_slot;
+#endif
+};
+
+static void boost_broker_devfreq_set(bool boost)
+{
+	int i;
+
+	for (i = 0; i < DEVFREQ_MAX; i++)
+		devfreq_boost_set(i, boost);
+}
+
+#ifdef CONFIG_DYNAMIC_STUNE_BOOST
+static void boost_broker_stune_set(struct boost_broker *bb, bool boost)
+{
+	if (boost && !bb->stune_active && stune_boost) {
+		if (!do_stune_boost("top-app", stune_boost, &bb->stune_slot))
+			bb->stune_active = true;
+	} else if (!boost && bb->stune_active) {
+		reset_stune_boost("top-app", bb->stune_slot);
+		bb->stune_active = false;
+	}
+}
+#else
+static inline void boost_broker_stune_set(struct boost_broker *bb, bool boost)
+{
+}
+#endif
+
+/*
+ * All of the works below run on the same ordered workqueue, so they are
+ * serialized against each other and need no further locking.
+ */
+static void boost_broker_boost_worker(struct work_struct *work)
+{
+	struct boost_broker *bb = container_of(work, typeof(*bb), boost);
+
+	/* A new boost supersedes any pending bandwidth unboost */
+	cancel_delayed_work(&bb->df_unboost);
+
+	if (!READ_ONCE(bb->cpu_boosted)) {
+		cpu_input_boost_set(true);
+		boost_broker_stune_set(bb, true);
+		WRITE_ONCE(bb->cpu_boosted, true);
+	}
+
+	if (!READ_ONCE(bb->df_boosted)) {
+		boost_broker_devfreq_set(true);
+		WRITE_ONCE(bb->df_boosted, true);
+	}
+
+	mod_delayed_work(bb->wq, &bb->cpu_unboost,
+			 msecs_to_jiffies(input_boost_duration));
+}
+
+static void boost_broker_cpu_unboost_worker(struct work_struct *work)
+{
+	struct boost_broker *bb = container_of(to_delayed_work(work),
+					       typeof(*bb), cpu_unboost);
+
+	cpu_input_boost_set(false);
+	boost_broker_stune_set(bb, false);
+	WRITE_ONCE(bb->cpu_boosted, false);
+
+	/* Keep memory bandwidth up until the CPU has finished the frame */
+	queue_delayed_work(bb->wq, &bb->df_unboost,
+			   msecs_to_jiffies(devfreq_unboost_delay));
+}
+
+static void boost_broker_df_unboost_worker(struct work_struct *work)
+{
+	struct boost_broker *bb = container_of(to_delayed_work(work),
+					       typeof(*bb), df_unboost);
+
+	boost_broker_devfreq_set(false);
+	WRITE_ONCE(bb->df_boosted, false);
+}
+
+static int msm_drm_notifier_cb(struct notifier_block *nb,
+			       unsigned long action, void *data)
+{
+	struct boost_broker *bb = container_of(nb, typeof(*bb), msm_drm_notif);
+	struct msm_drm_notifier *evdata = data;
+	int *blank = evdata->data;
+
+	/* Parse framebuffer blank events as soon as they occur */
+	if (action != MSM_DRM_EARLY_EVENT_BLANK)
+		return NOTIFY_OK;
+
+	bb->screen_awake = *blank == MSM_DRM_BLANK_UNBLANK;
+	if (!bb->screen_awake) {
+		cancel_work_sync(&bb->boost);
+		cancel_delayed_work_sync(&bb->cpu_unboost);
+		cancel_delayed_work_sync(&bb->df_unboost);
+		if (bb->cpu_boosted)
+			cpu_input_boost_set(false);
+		boost_broker_stune_set(bb, false);
+		bb->cpu_boosted = false;
+		bb->df_boosted = false;
+	}
+
+	cpu_input_boost_screen_event(bb->screen_awake);
+	devfreq_boost_screen_event(bb->screen_awake);
+
+	return NOTIFY_OK;
+}
+
+static void boost_broker_input_event(struct input_handle *handle,
+				     unsigned int type, unsigned int code,
+				     int value)
+{
+	struct boost_broker *bb = handle->handler->private;
+
+	if (!bb->screen_awake || !input_boost_duration)
+		return;
+
+	/*
+	 * Once every target is boosted, extending the shared timeline is
+	 * all that is needed and no boost work has to run.
+	 */
+	if (READ_ONCE(bb->cpu_boosted) && READ_ONCE(bb->df_boosted) &&
+	    mod_delayed_work(bb->wq, &bb->cpu_unboost,
+			     msecs_to_jiffies(input_boost_duration)))
+		return;
+
+	queue_work(bb->wq, &bb->boost);
+}
+
+static int boost_broker_input_connect(struct input_handler *handler,
+				      struct input_dev *dev,
+				      const struct input_device_id *id)
+{
+	struct input_handle *handle;
+	int ret;
+
+	handle = kzalloc(sizeof(*handle), GFP_KERNEL);
+	if (!handle)
+		return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = "boost_broker_handle";
+
+	ret = input_register_handle(handle);
+	if (ret)
+		goto free_handle;
+
+	ret = input_open_device(handle);
+	if (ret)
+		goto unregister_handle;
+
+	return 0;
+
+unregister_handle:
+	input_unregister_handle(handle);
+free_handle:
+	kfree(handle);
+	return ret;
+}
+
+static void boost_broker_input_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id boost_broker_ids[] = {
+	/* Multi-touch touchscreen */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT |
+			INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { [BIT_WORD(ABS_MT_POSITION_X)] =
+			BIT_MASK(ABS_MT_POSITION_X) |
+			BIT_MASK(ABS_MT_POSITION_Y) }
+	},
+	/* Touchpad */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_KEYBIT |
+			INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.keybit = { [BIT_WORD(BTN_TOUCH)] = BIT_MASK(BTN_TOUCH) },
+		.absbit = { [BIT_WORD(ABS_X)] =
+			BIT_MASK(ABS_X) | BIT_MASK(ABS_Y) }
+	},
+	/* Keypad */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT,
+		.evbit = { BIT_MASK(EV_KEY) }
+	},
+	{ }
+};
+
+static struct input_handler boost_broker_input_handler = {
+	.event		= boost_broker_input_event,
+	.connect	= boost_broker_input_connect,
+	.disconnect	= boost_broker_input_disconnect,
+	.name		= "boost_broker_handler",
+	.id_table	= boost_broker_ids
+};
+
+static int __init boost_broker_init(void)
+{
+	struct boost_broker *bb;
+	int ret;
+
+	bb = kzalloc(sizeof(*bb), GFP_KERNEL);
+	if (!bb)
+		return -ENOMEM;
+
+	bb->wq = alloc_ordered_workqueue("boost_broker_wq", WQ_HIGHPRI);
+	if (!bb->wq) {
+		ret = -ENOMEM;
+		goto free_bb;
+	}
+
+	INIT_WORK(&bb->boost, boost_broker_boost_worker);
+	INIT_DELAYED_WORK(&bb->cpu_unboost, boost_broker_cpu_unboost_worker);
+	INIT_DELAYED_WORK(&bb->df_unboost, boost_broker_df_unboost_worker);
+
+	boost_broker_input_handler.private = bb;
+	ret = input_register_handler(&boost_broker_input_handler);
+	if (ret) {
+		pr_err("Failed to register input handler, err: %d\n", ret);
+		goto destroy_wq;
+	}
+
+	bb->msm_drm_notif.notifier_call = msm_drm_notifier_cb;
+	bb->msm_drm_notif.priority = INT_MAX;
+	ret = msm_drm_register_client(&bb->msm_drm_notif);
+	if (ret) {
+		pr_err("Failed to register msm_drm notifier, err: %d\n", ret);
+		goto unregister_handler;
+	}
+
+	return 0;
+
+unregister_handler:
+	input_unregister_handler(&boost_broker_input_handler);
+destroy_wq:
+	destroy_workqueue(bb->wq);
+free_bb:
+	kfree(bb);
+	return ret;
+}
+late_initcall(boost_broker_init);
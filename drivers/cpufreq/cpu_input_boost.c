@@ -45,6 +45,19 @@ module_param(input_boost_duration, short, 0644);
 module_param(remove_input_boost_freq_lp, uint, 0644);
 module_param(remove_input_boost_freq_perf, uint, 0644);
 
+/*
+ * Frame-aware boosting: input boosts are kept alive by display commit and
+ * retire events for at most frame_boost_max_duration, and are dropped once
+ * no frame has been produced for frame_boost_timeout.
+ */
+static bool frame_boost;
+static unsigned short frame_boost_timeout = CONFIG_FRAME_BOOST_TIMEOUT_MS;
+static unsigned short frame_boost_max_duration =
+	CONFIG_FRAME_BOOST_MAX_DURATION_MS;
+module_param(frame_boost, bool, 0644);
+module_param(frame_boost_timeout, short, 0644);
+module_param(frame_boost_max_duration, short, 0644);
+
 /* The sched_param struct is located elsewhere in newer kernels */
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 10, 0)
 #include <uapi/linux/sched/types.h>
@@ -64,6 +77,7 @@ struct boost_drv {
 	struct notifier_block msm_drm_notif;
 	wait_queue_head_t boost_waitq;
 	atomic64_t max_boost_expires;
+	unsigned long input_boost_start;
 	atomic_t state;
 };
 
@@ -131,13 +145,24 @@ static void update_online_cpu_policy(void)
 
 static void __cpu_input_boost_kick(struct boost_drv *b)
 {
-	if ((get_boost_state(b) & SCREEN_OFF) || CONFIG_INPUT_BOOST_DURATION_MS == 0)
+	unsigned int duration_ms;
+	u32 state = get_boost_state(b);
+
+	if ((state & SCREEN_OFF) || CONFIG_INPUT_BOOST_DURATION_MS == 0)
 		return;
 
+	if (!(state & INPUT_BOOST))
+		b->input_boost_start = jiffies;
+
+	if (frame_boost)
+		duration_ms = frame_boost_timeout;
+	else
+		duration_ms = CONFIG_INPUT_BOOST_DURATION_MS;
+
 	set_boost_bit(b, INPUT_BOOST);
 	wake_up(&b->boost_waitq);
 	mod_delayed_work(system_unbound_wq, &b->input_unboost,
-			 msecs_to_jiffies(CONFIG_INPUT_BOOST_DURATION_MS));
+			 msecs_to_jiffies(duration_ms));
 }
 
 void cpu_input_boost_kick(void)
@@ -150,6 +175,37 @@ void cpu_input_boost_kick(void)
 	__cpu_input_boost_kick(b);
 }
 
+void cpu_input_boost_frame_event(void)
+{
+	struct boost_drv *b = boost_drv_g;
+	unsigned long max_expires;
+
+	if (!b || !frame_boost)
+		return;
+
+	/* Frames only extend a boost that was started by input */
+	if (!(get_boost_state(b) & INPUT_BOOST))
+		return;
+
+	max_expires = b->input_boost_start +
+		      msecs_to_jiffies(frame_boost_max_duration);
+	if (time_after(jiffies, max_expires))
+		return;
+
+	mod_delayed_work(system_unbound_wq, &b->input_unboost,
+			 msecs_to_jiffies(frame_boost_timeout));
+}
+
+bool cpu_input_boost_active(void)
+{
+	struct boost_drv *b = boost_drv_g;
+
+	if (!b)
+		return false;
+
+	return get_boost_state(b) & (INPUT_BOOST | MAX_BOOST);
+}
+
 static void __cpu_input_boost_kick_max(struct boost_drv *b,
 	unsigned int duration_ms)
 {
@@ -189,6 +245,30 @@ void cpu_input_boost_kick_max(unsigned int duration_ms)
 	__cpu_input_boost_kick_max(b, duration_ms);
 }
 
+#ifdef CONFIG_BOOST_BROKER
+/*
+ * Synchronous input boost control for the boost broker, which owns the
+ * boost timeline itself. Must be called from process context.
+ */
+void cpu_input_boost_set(bool boost)
+{
+	struct boost_drv *b = boost_drv_g;
+
+	if (!b)
+		return;
+
+	if (boost) {
+		if (get_boost_state(b) & SCREEN_OFF)
+			return;
+		set_boost_bit(b, INPUT_BOOST);
+	} else {
+		clear_boost_bit(b, INPUT_BOOST);
+	}
+
+	update_online_cpu_policy();
+}
+#endif
+
 static void input_unboost_worker(struct work_struct *work)
 {
 	struct boost_drv *b =
@@ -296,19 +376,10 @@ static int cpu_notifier_cb(struct notifier_block *nb,
 	return NOTIFY_OK;
 }
 
-static int msm_drm_notifier_cb(struct notifier_block *nb,
-			  unsigned long action, void *data)
+static void __cpu_input_boost_screen_event(struct boost_drv *b, bool awake)
 {
-	struct boost_drv *b = container_of(nb, typeof(*b), msm_drm_notif);
-	struct msm_drm_notifier *evdata = data;
-	int *blank = evdata->data;
-
-	/* Parse framebuffer blank events as soon as they occur */
-	if (action != MSM_DRM_EARLY_EVENT_BLANK)
-		return NOTIFY_OK;
-
 	/* Boost when the screen turns on and unboost when it turns off */
-	if (*blank == MSM_DRM_BLANK_UNBLANK) {
+	if (awake) {
 		clear_boost_bit(b, SCREEN_OFF);
 		__cpu_input_boost_kick_max(b, CONFIG_WAKE_BOOST_DURATION_MS);
 		remove_input_boost_freq_lp = previous_remove_input_boost_freq_lp;
@@ -321,6 +392,31 @@ static int msm_drm_notifier_cb(struct notifier_block *nb,
 		remove_input_boost_freq_lp = CONFIG_REMOVE_INPUT_BOOST_FREQ_LP;
 		remove_input_boost_freq_perf = CONFIG_REMOVE_INPUT_BOOST_FREQ_PERF;
 	}
+}
+
+#ifdef CONFIG_BOOST_BROKER
+void cpu_input_boost_screen_event(bool awake)
+{
+	struct boost_drv *b = boost_drv_g;
+
+	if (!b)
+		return;
+
+	__cpu_input_boost_screen_event(b, awake);
+}
+#else
+static int msm_drm_notifier_cb(struct notifier_block *nb,
+			  unsigned long action, void *data)
+{
+	struct boost_drv *b = container_of(nb, typeof(*b), msm_drm_notif);
+	struct msm_drm_notifier *evdata = data;
+	int *blank = evdata->data;
+
+	/* Parse framebuffer blank events as soon as they occur */
+	if (action != MSM_DRM_EARLY_EVENT_BLANK)
+		return NOTIFY_OK;
+
+	__cpu_input_boost_screen_event(b, *blank == MSM_DRM_BLANK_UNBLANK);
 
 	return NOTIFY_OK;
 }
@@ -410,6 +506,7 @@ static struct input_handler cpu_input_boost_input_handler = {
 	.name		= "cpu_input_boost_handler",
 	.id_table	= cpu_input_boost_ids
 };
+#endif /* CONFIG_BOOST_BROKER */
 
 static int __init cpu_input_boost_init(void)
 {
@@ -435,6 +532,7 @@ static int __init cpu_input_boost_init(void)
 		goto free_b;
 	}
 
+#ifndef CONFIG_BOOST_BROKER
 	cpu_input_boost_input_handler.private = b;
 	ret = input_register_handler(&cpu_input_boost_input_handler);
 	if (ret) {
@@ -449,6 +547,7 @@ static int __init cpu_input_boost_init(void)
 		pr_err("Failed to register dsi_panel_notifier, err: %d\n", ret);
 		goto unregister_handler;
 	}
+#endif
 
 	boost_thread = kthread_run(cpu_boost_thread, b, "cpu_boostd");
 	if (IS_ERR(boost_thread)) {
@@ -462,10 +561,12 @@ static int __init cpu_input_boost_init(void)
 	return 0;
 
 unregister_drm_notif:
+#ifndef CONFIG_BOOST_BROKER
 	msm_drm_unregister_client(&b->msm_drm_notif);
 unregister_handler:
 	input_unregister_handler(&cpu_input_boost_input_handler);
 unregister_cpu_notif:
+#endif
 	cpufreq_unregister_notifier(&b->cpu_notif, CPUFREQ_POLICY_NOTIFIER);
 free_b:
 	kfree(b);
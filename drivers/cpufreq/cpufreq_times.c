@@ -29,9 +29,12 @@
 
 static DECLARE_HASHTABLE(uid_hash_table, UID_HASH_BITS);
 
-/* task->time_in_state */
+/*
+ * task->time_in_state: only the accounting tick of the task itself writes
+ * the array, so the lock is taken there only to resize it.
+ */
 static  __cacheline_aligned_in_smp DEFINE_SPINLOCK(task_time_in_state_lock);
-/* uid_hash_table */
+/* uid_hash_table: entries are updated under RCU once registered and sized */
 static __cacheline_aligned_in_smp DEFINE_SPINLOCK(uid_lock);
 
 struct concurrent_times {
@@ -45,7 +48,7 @@ struct uid_entry {
 	struct hlist_node hash;
 	struct rcu_head rcu;
 	struct concurrent_times *concurrent_times;
-	u64 time_in_state[0];
+	atomic64_t time_in_state[0];
 };
 
 /**
@@ -157,7 +160,8 @@ static int single_uid_time_in_state_show(struct seq_file *m, void *ptr)
 	}
 
 	for (i = 0; i < uid_entry->max_state; ++i) {
-		u64 time = cputime_to_clock_t(uid_entry->time_in_state[i]);
+		u64 time = cputime_to_clock_t(
+			atomic64_read(&uid_entry->time_in_state[i]));
 		seq_write(m, &time, sizeof(time));
 	}
 
@@ -218,7 +222,8 @@ static int uid_time_in_state_seq_show(struct seq_file *m, void *v)
 		}
 		for (i = 0; i < uid_entry->max_state; ++i) {
 			u64 time =
-				cputime_to_clock_t(uid_entry->time_in_state[i]);
+				cputime_to_clock_t(atomic64_read(
+					&uid_entry->time_in_state[i]));
 			seq_put_decimal_ull(m, " ", time);
 		}
 		if (uid_entry->max_state)
@@ -415,25 +420,37 @@ void cpufreq_acct_update_power(struct task_struct *p, cputime_t cputime)
 
 	state = freqs->offset + READ_ONCE(freqs->last_index);
 
-	spin_lock_irqsave(&task_time_in_state_lock, flags);
-	if ((state < p->max_state || !cpufreq_task_times_realloc_locked(p)) &&
-	    p->time_in_state)
+	if (state < p->max_state && p->time_in_state) {
 		p->time_in_state[state] += cputime;
-	spin_unlock_irqrestore(&task_time_in_state_lock, flags);
-
-	spin_lock_irqsave(&uid_lock, flags);
-	uid_entry = find_or_register_uid_locked(uid);
-	if (uid_entry && state < uid_entry->max_state)
-		uid_entry->time_in_state[state] += cputime;
-	spin_unlock_irqrestore(&uid_lock, flags);
+	} else {
+		spin_lock_irqsave(&task_time_in_state_lock, flags);
+		if ((state < p->max_state ||
+		     !cpufreq_task_times_realloc_locked(p)) &&
+		    p->time_in_state)
+			p->time_in_state[state] += cputime;
+		spin_unlock_irqrestore(&task_time_in_state_lock, flags);
+	}
 
 	rcu_read_lock();
 	uid_entry = find_uid_entry_rcu(uid);
-	if (!uid_entry) {
+	if (!uid_entry || uid_entry->max_state != READ_ONCE(next_offset)) {
 		rcu_read_unlock();
-		return;
+
+		spin_lock_irqsave(&uid_lock, flags);
+		find_or_register_uid_locked(uid);
+		spin_unlock_irqrestore(&uid_lock, flags);
+
+		rcu_read_lock();
+		uid_entry = find_uid_entry_rcu(uid);
+		if (!uid_entry) {
+			rcu_read_unlock();
+			return;
+		}
 	}
 
+	if (state < uid_entry->max_state)
+		atomic64_add(cputime, &uid_entry->time_in_state[state]);
+
 	for_each_possible_cpu(cpu)
 		if (!idle_cpu(cpu))
 			++active_cpu_cnt;
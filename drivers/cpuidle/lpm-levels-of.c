@@ -816,6 +816,8 @@ struct lpm_cluster *parse_cluster(struct device_node *node,
 	INIT_LIST_HEAD(&c->cpu);
 	c->parent = parent;
 	spin_lock_init(&c->sync_lock);
+	INIT_LIST_HEAD(&c->irq_steer_list);
+	INIT_WORK(&c->irq_steer_work, lpm_cluster_irq_steer_fn);
 	c->min_child_level = NR_LPM_LEVELS;
 
 	for_each_child_of_node(node, n) {
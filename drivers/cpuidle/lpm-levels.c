@@ -35,6 +35,9 @@
 #include <linux/sched.h>
 #include <linux/cpu_pm.h>
 #include <linux/cpuhotplug.h>
+#include <linux/irq.h>
+#include <linux/irqdesc.h>
+#include <linux/interrupt.h>
 #include <soc/qcom/pm.h>
 #include <soc/qcom/event_timer.h>
 #include <soc/qcom/lpm_levels.h>
@@ -70,6 +73,28 @@ module_param_named(lpm_prediction, lpm_prediction, bool, 0664);
 static uint32_t bias_hyst;
 module_param_named(bias_hyst, bias_hyst, uint, 0664);
 
+/*
+ * A wakeup that lands within tmr_wake_slack_us of the expected timer
+ * expiry is treated as a timer wakeup and kept out of the residency
+ * history, so that the predictor only learns the IRQ/IPI wakeup pattern.
+ */
+static uint32_t tmr_wake_slack_us = 100;
+module_param_named(tmr_wake_slack_us, tmr_wake_slack_us, uint, 0664);
+
+/*
+ * When a cluster enters its deepest level while CPUs outside of it are
+ * still running, move the movable device IRQs off the cluster so periodic
+ * interrupts do not keep breaking cluster power collapse.
+ */
+static bool lpm_irq_steer;
+module_param_named(lpm_irq_steer, lpm_irq_steer, bool, 0664);
+
+struct lpm_irq_steer {
+	struct list_head list;
+	unsigned int irq;
+	struct cpumask mask;
+};
+
 struct lpm_history {
 	uint32_t resi[MAXSAMPLES];
 	int mode[MAXSAMPLES];
@@ -77,6 +102,7 @@ struct lpm_history {
 	uint32_t hptr;
 	uint32_t hinvalid;
 	uint32_t htmr_wkup;
+	uint32_t expected_us;
 	int64_t stime;
 };
 
@@ -617,6 +643,12 @@ static int cpu_power_select(struct cpuidle_device *dev,
 					&idx_restrict, &idx_restrict_time);
 				if (predicted && (predicted < min_residency[i]))
 					predicted = min_residency[i];
+				/*
+				 * The history only covers IRQ/IPI wakeups, the
+				 * next timer is known and bounds the residency.
+				 */
+				if (predicted > next_wakeup_us)
+					predicted = next_wakeup_us;
 			} else
 				invalidate_predict_history(dev);
 		}
@@ -658,6 +690,8 @@ static int cpu_power_select(struct cpuidle_device *dev,
 	}
 
 done_select:
+	per_cpu(hist, dev->cpu).expected_us = next_wakeup_us;
+
 	trace_cpu_power_select(best_level, sleep_us, latency_us, next_event_us);
 
 	trace_cpu_pred_select(idx_restrict_time ? 2 : (predicted ? 1 : 0),
@@ -975,6 +1009,102 @@ static void cluster_notify(struct lpm_cluster *cluster,
 		cpu_cluster_pm_exit(cluster->aff_level);
 }
 
+static void cluster_irq_restore(struct lpm_cluster *cluster)
+{
+	struct lpm_irq_steer *s, *tmp;
+
+	list_for_each_entry_safe(s, tmp, &cluster->irq_steer_list, list) {
+		irq_set_affinity(s->irq, &s->mask);
+		list_del(&s->list);
+		kfree(s);
+	}
+}
+
+static void cluster_irq_steer(struct lpm_cluster *cluster)
+{
+	struct cpumask target;
+	struct irq_desc *desc;
+	struct lpm_irq_steer *s;
+	unsigned int irq;
+
+	cpumask_andnot(&target, cpu_online_mask, &cluster->child_cpus);
+	cpumask_andnot(&target, &target, cpu_isolated_mask);
+	if (cpumask_empty(&target))
+		return;
+
+	for_each_irq_desc(irq, desc) {
+		struct irq_data *d = irq_desc_get_irq_data(desc);
+		const struct cpumask *aff = irq_data_get_affinity_mask(d);
+		struct cpumask mask;
+
+		if (!desc->action || irqd_is_per_cpu(d) ||
+			!irqd_can_balance(d) || irqd_affinity_is_managed(d) ||
+			!cpumask_intersects(aff, &cluster->child_cpus))
+			continue;
+
+		s = kmalloc(sizeof(*s), GFP_KERNEL);
+		if (!s)
+			break;
+
+		cpumask_copy(&s->mask, aff);
+		if (!cpumask_and(&mask, aff, &target))
+			cpumask_copy(&mask, &target);
+
+		if (irq_set_affinity(irq, &mask)) {
+			kfree(s);
+			continue;
+		}
+
+		s->irq = irq;
+		list_add(&s->list, &cluster->irq_steer_list);
+	}
+}
+
+void lpm_cluster_irq_steer_fn(struct work_struct *work)
+{
+	struct lpm_cluster *cluster = container_of(work, struct lpm_cluster,
+						irq_steer_work);
+	bool want = READ_ONCE(cluster->irq_steer_want);
+
+	if (want == !list_empty(&cluster->irq_steer_list))
+		return;
+
+	if (want)
+		cluster_irq_steer(cluster);
+	else
+		cluster_irq_restore(cluster);
+}
+
+static void cluster_request_irq_steer(struct lpm_cluster *cluster)
+{
+	unsigned int cpu;
+
+	if (!lpm_irq_steer || cluster->irq_steer_want)
+		return;
+
+	/* The work must run on a CPU that is awake outside of the cluster */
+	for_each_online_cpu(cpu) {
+		if (cpumask_test_cpu(cpu, &cluster->child_cpus) ||
+			cpu_isolated(cpu) || idle_cpu(cpu))
+			continue;
+
+		cluster->irq_steer_want = true;
+		queue_work_on(cpu, system_highpri_wq,
+					&cluster->irq_steer_work);
+		return;
+	}
+}
+
+static void cluster_release_irq_steer(struct lpm_cluster *cluster)
+{
+	if (!cluster->irq_steer_want)
+		return;
+
+	cluster->irq_steer_want = false;
+	queue_work_on(raw_smp_processor_id(), system_highpri_wq,
+					&cluster->irq_steer_work);
+}
+
 static int cluster_configure(struct lpm_cluster *cluster, int idx,
 		bool from_idle, int predicted)
 {
@@ -1028,6 +1158,9 @@ static int cluster_configure(struct lpm_cluster *cluster, int idx,
 	/* Notify cluster enter event after successfully config completion */
 	cluster_notify(cluster, level, true);
 
+	if (from_idle && (idx == cluster->nlevels - 1))
+		cluster_request_irq_steer(cluster);
+
 	cluster->last_level = idx;
 
 	if (predicted && (idx < (cluster->nlevels - 1))) {
@@ -1171,6 +1304,8 @@ static void cluster_unprepare(struct lpm_cluster *cluster,
 
 	cluster_notify(cluster, &cluster->levels[last_level], false);
 
+	cluster_release_irq_steer(cluster);
+
 	if (from_idle)
 		update_cluster_history(&cluster->history, last_level);
 
@@ -1316,6 +1451,15 @@ static void update_history(struct cpuidle_device *dev, int idx)
 	if (!lpm_prediction || !lpm_cpu->lpm_prediction)
 		return;
 
+	/*
+	 * Timer wakeups are already accounted for by the sleep length,
+	 * recording them would only dilute the IRQ/IPI residency pattern.
+	 */
+	if (!history->htmr_wkup && history->expected_us &&
+		(dev->last_residency + tmr_wake_slack_us >=
+					history->expected_us))
+		return;
+
 	if (history->htmr_wkup) {
 		if (!history->hptr)
 			history->hptr = MAXSAMPLES-1;
@@ -10,6 +10,7 @@
  * GNU General Public License for more details.
  */
 
+#include <linux/workqueue.h>
 #include <soc/qcom/pm.h>
 #include <soc/qcom/spm.h>
 
@@ -121,6 +122,9 @@ struct lpm_cluster {
 	unsigned int psci_mode_mask;
 	struct cluster_history history;
 	struct hrtimer histtimer;
+	bool irq_steer_want;
+	struct list_head irq_steer_list;
+	struct work_struct irq_steer_work;
 };
 
 struct lpm_cluster *lpm_of_parse_cluster(struct platform_device *pdev);
@@ -134,6 +138,7 @@ bool lpm_cluster_mode_allow(struct lpm_cluster *cluster,
 		unsigned int mode, bool from_idle);
 uint32_t *get_per_cpu_max_residency(int cpu);
 uint32_t *get_per_cpu_min_residency(int cpu);
+void lpm_cluster_irq_steer_fn(struct work_struct *work);
 extern struct lpm_cluster *lpm_root_node;
 
 #if defined(CONFIG_SMP)
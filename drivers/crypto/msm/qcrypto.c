@@ -65,6 +65,15 @@
 
 #define QCRYPTO_HIGH_BANDWIDTH_TIMEOUT 1000
 
+/*
+ * AES ECB/CBC/CTR requests shorter than this many bytes are done by the
+ * software fallback cipher (the ARMv8 CE instructions on arm64) instead of
+ * the crypto engine, whose setup cost dominates for small requests.
+ * 0 sends every request to the engine.
+ */
+static unsigned int qcrypto_sw_max_bytes;
+module_param(qcrypto_sw_max_bytes, uint, 0644);
+
 
 
 /* Status of response workq */
@@ -421,6 +430,7 @@ struct qcrypto_cipher_ctx {
 	u8 ccm4309_nonce[QCRYPTO_CCM4309_NONCE_LEN];
 
 	struct crypto_skcipher *cipher_aes192_fb;
+	bool cipher_fb_keyed; /* fallback holds the key for small requests */
 
 	struct crypto_ahash *ahash_aead_aes192_fb;
 };
@@ -1465,6 +1475,8 @@ static int _qcrypto_setkey_aes(struct crypto_ablkcipher *cipher, const u8 *key,
 			pr_err("%s Inavlid key pointer\n", __func__);
 			return -EINVAL;
 		}
+		ctx->cipher_fb_keyed = ctx->cipher_aes192_fb &&
+			!crypto_skcipher_setkey(ctx->cipher_aes192_fb, key, len);
 	}
 	return 0;
 };
@@ -2481,6 +2493,20 @@ static int _qcrypto_queue_req(struct crypto_priv *cp,
 	return ret;
 }
 
+static bool _qcrypto_use_fallback(struct crypto_priv *cp,
+				  struct qcrypto_cipher_ctx *ctx,
+				  struct ablkcipher_request *req)
+{
+	if (!ctx->cipher_aes192_fb)
+		return false;
+
+	if (ctx->enc_key_len == AES_KEYSIZE_192 && !cp->ce_support.aes_key_192)
+		return true;
+
+	return ctx->cipher_fb_keyed &&
+		req->nbytes < READ_ONCE(qcrypto_sw_max_bytes);
+}
+
 static int _qcrypto_enc_aes_192_fallback(struct ablkcipher_request *req)
 {
 	struct qcrypto_cipher_ctx *ctx = crypto_tfm_ctx(req->base.tfm);
@@ -2529,9 +2555,7 @@ static int _qcrypto_enc_aes_ecb(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_enc_aes_ecb: %pK\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_use_fallback(cp, ctx, req))
 		return _qcrypto_enc_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
@@ -2559,9 +2583,7 @@ static int _qcrypto_enc_aes_cbc(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_enc_aes_cbc: %pK\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_use_fallback(cp, ctx, req))
 		return _qcrypto_enc_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
@@ -2589,9 +2611,7 @@ static int _qcrypto_enc_aes_ctr(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_enc_aes_ctr: %pK\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_use_fallback(cp, ctx, req))
 		return _qcrypto_enc_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
@@ -2777,9 +2797,7 @@ static int _qcrypto_dec_aes_ecb(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_dec_aes_ecb: %pK\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_use_fallback(cp, ctx, req))
 		return _qcrypto_dec_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
@@ -2807,9 +2825,7 @@ static int _qcrypto_dec_aes_cbc(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_dec_aes_cbc: %pK\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_use_fallback(cp, ctx, req))
 		return _qcrypto_dec_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
@@ -2837,9 +2853,7 @@ static int _qcrypto_dec_aes_ctr(struct ablkcipher_request *req)
 	dev_info(&ctx->pengine->pdev->dev, "_qcrypto_dec_aes_ctr: %pK\n", req);
 #endif
 
-	if ((ctx->enc_key_len == AES_KEYSIZE_192) &&
-			(!cp->ce_support.aes_key_192) &&
-				ctx->cipher_aes192_fb)
+	if (_qcrypto_use_fallback(cp, ctx, req))
 		return _qcrypto_dec_aes_192_fallback(req);
 
 	rctx = ablkcipher_request_ctx(req);
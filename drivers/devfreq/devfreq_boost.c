@@ -238,19 +238,10 @@ static void devfreq_max_unboost(struct work_struct *work)
 	mutex_unlock(&df->lock);
 }
 
-static int msm_drm_notifier_cb(struct notifier_block *nb,
-			       unsigned long action, void *data)
+static void __devfreq_boost_screen_event(struct df_boost_drv *d, bool awake)
 {
-	struct df_boost_drv *d = container_of(nb, typeof(*d), msm_drm_notif);
-	struct msm_drm_notifier *evdata = data;
-	int *blank = evdata->data;
-
-	/* Parse framebuffer blank events as soon as they occur */
-	if (action != MSM_DRM_EARLY_EVENT_BLANK)
-		return NOTIFY_OK;
-
 	/* Boost when the screen turns on and unboost when it turns off */
-	d->screen_awake = *blank == MSM_DRM_BLANK_UNBLANK;
+	d->screen_awake = awake;
 	if (d->screen_awake) {
 		int i;
 
@@ -260,6 +251,68 @@ static int msm_drm_notifier_cb(struct notifier_block *nb,
 	} else {
 		devfreq_unboost_all(d);
 	}
+}
+
+#ifdef CONFIG_BOOST_BROKER
+/*
+ * Synchronous input boost control for the boost broker, which owns the
+ * boost timeline itself. Must be called from process context.
+ */
+void devfreq_boost_set(enum df_device device, bool boost)
+{
+	struct df_boost_drv *d = df_boost_drv_g;
+	struct boost_dev *b;
+	struct devfreq *df;
+	unsigned long boost_freq, flags;
+
+	if (!d)
+		return;
+
+	if (boost && !d->screen_awake)
+		return;
+
+	b = d->devices + device;
+	spin_lock_irqsave(&b->lock, flags);
+	df = b->df;
+	boost_freq = b->boost_freq;
+	spin_unlock_irqrestore(&b->lock, flags);
+
+	if (!df)
+		return;
+
+	mutex_lock(&df->lock);
+	if (!boost)
+		df->min_freq = devfreq_abs_min_freq(b);
+	else if (df->max_freq)
+		df->min_freq = min(boost_freq, df->max_freq);
+	else
+		df->min_freq = boost_freq;
+	update_devfreq(df);
+	mutex_unlock(&df->lock);
+}
+
+void devfreq_boost_screen_event(bool awake)
+{
+	struct df_boost_drv *d = df_boost_drv_g;
+
+	if (!d)
+		return;
+
+	__devfreq_boost_screen_event(d, awake);
+}
+#else
+static int msm_drm_notifier_cb(struct notifier_block *nb,
+			       unsigned long action, void *data)
+{
+	struct df_boost_drv *d = container_of(nb, typeof(*d), msm_drm_notif);
+	struct msm_drm_notifier *evdata = data;
+	int *blank = evdata->data;
+
+	/* Parse framebuffer blank events as soon as they occur */
+	if (action != MSM_DRM_EARLY_EVENT_BLANK)
+		return NOTIFY_OK;
+
+	__devfreq_boost_screen_event(d, *blank == MSM_DRM_BLANK_UNBLANK);
 
 	return NOTIFY_OK;
 }
@@ -350,6 +403,7 @@ static struct input_handler devfreq_boost_input_handler = {
 	.name		= "devfreq_boost_handler",
 	.id_table	= devfreq_boost_ids
 };
+#endif /* CONFIG_BOOST_BROKER */
 
 static int __init devfreq_boost_init(void)
 {
@@ -385,6 +439,7 @@ static int __init devfreq_boost_init(void)
 	d->devices[DEVFREQ_MSM_LLCCBW].boost_freq =
 		CONFIG_DEVFREQ_MSM_LLCCBW_BOOST_FREQ;
 
+#ifndef CONFIG_BOOST_BROKER
 	devfreq_boost_input_handler.private = d;
 	ret = input_register_handler(&devfreq_boost_input_handler);
 	if (ret) {
@@ -399,14 +454,17 @@ static int __init devfreq_boost_init(void)
 		pr_err("Failed to register msm_drm notifier, err: %d\n", ret);
 		goto unregister_handler;
 	}
+#endif
 
 	df_boost_drv_g = d;
 
 	return 0;
 
+#ifndef CONFIG_BOOST_BROKER
 unregister_handler:
 	input_unregister_handler(&devfreq_boost_input_handler);
 destroy_wq:
+#endif
 	destroy_workqueue(wq);
 free_d:
 	kfree(d);
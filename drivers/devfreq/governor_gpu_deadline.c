@@ -0,0 +1,254 @@
+/*
+ * Frame deadline based governor for the Adreno GPU
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Instead of chasing the busy percentage of the last sampling window, the
+ * frequency is picked so that the longest frame reported by the dispatcher
+ * since the previous sample would have completed within target_load percent
+ * of the display's vsync period. When no frames were completed, e.g. for
+ * compute work or while the display is off, the governor falls back to a
+ * utilization estimate against the same target load.
+ */
+#include <linux/errno.h>
+#include <linux/module.h>
+#include <linux/devfreq.h>
+#include <linux/math64.h>
+#include <linux/spinlock.h>
+#include <linux/msm_adreno_devfreq.h>
+#include <linux/msm_drm_notify.h>
+#include "governor.h"
+
+#define TAG "gpu_deadline: "
+
+#define DEFAULT_REFRESH_RATE	60
+#define DEFAULT_TARGET_LOAD	85
+
+/* Minimum window in usec for the utilization fallback */
+#define UTIL_FLOOR		50000
+
+static unsigned int target_load = DEFAULT_TARGET_LOAD;
+
+static ssize_t target_load_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%u\n", target_load);
+}
+
+static ssize_t target_load_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	if (val < 1 || val > 100)
+		return -EINVAL;
+
+	target_load = val;
+	return count;
+}
+
+static DEVICE_ATTR(target_load, 0644, target_load_show, target_load_store);
+
+static const struct device_attribute *gpu_deadline_attr_list[] = {
+	&dev_attr_target_load,
+	NULL
+};
+
+/*
+ * Lowest level whose frequency satisfies @want. The frequency table is
+ * ordered from the fastest level 0 down to the slowest max_state - 1.
+ */
+static int gpu_deadline_level(struct devfreq *devfreq, u64 want)
+{
+	int lev;
+
+	for (lev = devfreq->profile->max_state - 1; lev > 0; lev--)
+		if (devfreq->profile->freq_table[lev] >= want)
+			break;
+
+	return lev;
+}
+
+static int gpu_deadline_cur_level(struct devfreq *devfreq, unsigned long freq)
+{
+	int lev;
+
+	for (lev = 0; lev < devfreq->profile->max_state; lev++)
+		if (freq == devfreq->profile->freq_table[lev])
+			return lev;
+
+	return -EINVAL;
+}
+
+static int gpu_deadline_get_target_freq(struct devfreq *devfreq,
+		unsigned long *freq)
+{
+	struct devfreq_msm_adreno_tz_data *priv = devfreq->data;
+	struct devfreq_dev_status stats;
+	unsigned int refresh, load = READ_ONCE(target_load);
+	unsigned long flags;
+	u64 max_ns, period_ns, want;
+	int result, level, cur;
+	u32 nr;
+
+	result = devfreq->profile->get_dev_status(devfreq->dev.parent, &stats);
+	if (result) {
+		pr_err(TAG "get_status failed %d\n", result);
+		return result;
+	}
+
+	*freq = stats.current_frequency;
+	priv->bin.total_time += stats.total_time;
+	priv->bin.busy_time += stats.busy_time;
+
+	spin_lock_irqsave(&priv->frame.lock, flags);
+	max_ns = priv->frame.max_ns;
+	nr = priv->frame.nr;
+	priv->frame.max_ns = 0;
+	priv->frame.nr = 0;
+	spin_unlock_irqrestore(&priv->frame.lock, flags);
+
+	cur = gpu_deadline_cur_level(devfreq, stats.current_frequency);
+	if (cur < 0) {
+		pr_err(TAG "bad freq %ld\n", stats.current_frequency);
+		return cur;
+	}
+
+	if (nr) {
+		refresh = msm_drm_get_refresh_rate();
+		if (!refresh)
+			refresh = DEFAULT_REFRESH_RATE;
+		period_ns = div_u64(NSEC_PER_SEC, refresh);
+
+		/* the frame took max_ns at the current frequency */
+		want = div64_u64(max_ns * stats.current_frequency,
+				 div_u64(period_ns * load, 100));
+	} else {
+		if (priv->bin.total_time < UTIL_FLOOR)
+			return 0;
+
+		want = div64_u64((u64)priv->bin.busy_time * 100 *
+				 stats.current_frequency,
+				 (u64)priv->bin.total_time * load);
+	}
+
+	priv->bin.total_time = 0;
+	priv->bin.busy_time = 0;
+
+	/* Go up at once, but only step down one level per sample */
+	level = gpu_deadline_level(devfreq, want);
+	if (level > cur)
+		level = cur + 1;
+
+	*freq = devfreq->profile->freq_table[level];
+	return 0;
+}
+
+static int gpu_deadline_start(struct devfreq *devfreq)
+{
+	struct msm_adreno_extended_profile *gpu_profile = container_of(
+					(devfreq->profile),
+					struct msm_adreno_extended_profile,
+					profile);
+	int i;
+
+	/*
+	 * As for msm-adreno-tz, there is only one adreno device, so the
+	 * private data can be taken from the container of the profile.
+	 */
+	devfreq->data = gpu_profile->private_data;
+
+	for (i = 0; gpu_deadline_attr_list[i] != NULL; i++)
+		device_create_file(&devfreq->dev, gpu_deadline_attr_list[i]);
+
+	return 0;
+}
+
+static int gpu_deadline_stop(struct devfreq *devfreq)
+{
+	int i;
+
+	for (i = 0; gpu_deadline_attr_list[i] != NULL; i++)
+		device_remove_file(&devfreq->dev, gpu_deadline_attr_list[i]);
+
+	devfreq->data = NULL;
+	return 0;
+}
+
+static void gpu_deadline_reset(struct devfreq *devfreq)
+{
+	struct devfreq_msm_adreno_tz_data *priv = devfreq->data;
+	unsigned long flags;
+
+	priv->bin.total_time = 0;
+	priv->bin.busy_time = 0;
+
+	spin_lock_irqsave(&priv->frame.lock, flags);
+	priv->frame.max_ns = 0;
+	priv->frame.nr = 0;
+	spin_unlock_irqrestore(&priv->frame.lock, flags);
+}
+
+static int gpu_deadline_handler(struct devfreq *devfreq, unsigned int event,
+		void *data)
+{
+	int result = 0;
+
+	switch (event) {
+	case DEVFREQ_GOV_START:
+		result = gpu_deadline_start(devfreq);
+		break;
+
+	case DEVFREQ_GOV_STOP:
+		result = gpu_deadline_stop(devfreq);
+		break;
+
+	case DEVFREQ_GOV_SUSPEND:
+	case DEVFREQ_GOV_RESUME:
+		/* frames from before the idle period say nothing about now */
+		gpu_deadline_reset(devfreq);
+		break;
+
+	case DEVFREQ_GOV_INTERVAL:
+		/* fallthrough, this governor doesn't use polling */
+	default:
+		break;
+	}
+
+	return result;
+}
+
+static struct devfreq_governor gpu_deadline = {
+	.name = "gpu-deadline",
+	.get_target_freq = gpu_deadline_get_target_freq,
+	.event_handler = gpu_deadline_handler,
+};
+
+static int __init gpu_deadline_init(void)
+{
+	return devfreq_add_governor(&gpu_deadline);
+}
+subsys_initcall(gpu_deadline_init);
+
+static void __exit gpu_deadline_exit(void)
+{
+	int ret = devfreq_remove_governor(&gpu_deadline);
+
+	if (ret)
+		pr_err(TAG "failed to remove governor %d\n", ret);
+}
+module_exit(gpu_deadline_exit);
+
+MODULE_LICENSE("GPL v2");
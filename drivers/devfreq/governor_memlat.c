@@ -36,6 +36,9 @@
 struct memlat_node {
 	unsigned int ratio_ceil;
 	unsigned int stall_floor;
+	unsigned int hist_memory;
+	unsigned int hist_mem;
+	unsigned long hist_max_freq;
 	bool mon_started;
 	bool already_zero;
 	struct list_head list;
@@ -239,6 +242,7 @@ static int gov_resume(struct devfreq *df)
 	mutex_unlock(&df->lock);
 
 	node->resume_freq = 0;
+	node->hist_mem = 0;
 
 	devfreq_monitor_resume(df);
 	node->mon_started = true;
@@ -308,6 +312,19 @@ static int devfreq_memlat_get_freq(struct devfreq *df,
 	if (max_freq)
 		max_freq = core_to_dev_freq(node, max_freq);
 
+	/*
+	 * Remember the peak vote of the past hist_memory windows so that a
+	 * single sample where no core looks latency bound does not drop the
+	 * vote only for it to be raised again on the next one.
+	 */
+	if (max_freq >= node->hist_max_freq || !node->hist_mem) {
+		node->hist_max_freq = max_freq;
+		node->hist_mem = node->hist_memory;
+	} else {
+		node->hist_mem--;
+		max_freq = node->hist_max_freq;
+	}
+
 	if (max_freq || !node->already_zero) {
 		trace_memlat_dev_update(dev_name(df->dev.parent),
 					hw->core_stats[lat_dev].id,
@@ -325,10 +342,12 @@ static int devfreq_memlat_get_freq(struct devfreq *df,
 
 gov_attr(ratio_ceil, 1U, 20000U);
 gov_attr(stall_floor, 0U, 100U);
+gov_attr(hist_memory, 0U, 20U);
 
 static struct attribute *memlat_dev_attr[] = {
 	&dev_attr_ratio_ceil.attr,
 	&dev_attr_stall_floor.attr,
+	&dev_attr_hist_memory.attr,
 	&dev_attr_freq_map.attr,
 	NULL,
 };
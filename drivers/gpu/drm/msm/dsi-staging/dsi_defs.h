@@ -383,6 +383,7 @@ struct dsi_cmd_desc {
  * @state:     state of the command
  * @count:     number of cmds
  * @ctrl_idx:  index of the dsi control
+ * @batched:   send the whole set with a single dma trigger
  * @cmds:      arry of cmds
  */
 struct dsi_panel_cmd_set {
@@ -390,6 +391,7 @@ struct dsi_panel_cmd_set {
 	enum dsi_cmd_set_state state;
 	u32 count;
 	u32 ctrl_idx;
+	bool batched;
 	struct dsi_cmd_desc *cmds;
 };
 
@@ -21,6 +21,7 @@
 #include <linux/of_gpio.h>
 #include <linux/err.h>
 #include <drm/drm_notifier.h>
+#include <linux/msm_drm_notify.h>
 
 #include "msm_drv.h"
 #include "sde_connector.h"
@@ -4261,6 +4262,33 @@ static int dsi_display_dynamic_clk_switch(struct dsi_display *display,
 	return rc;
 }
 
+/*
+ * A command mode panel scans out of its own memory at the rate of its TE,
+ * so there is no host timing to retune. The panel is moved to the new
+ * rate with the timing switch commands of the target mode, and the new
+ * TE rate is picked up by the tear check of the encoder.
+ */
+static int dsi_display_cmd_dfps_update(struct dsi_display *display,
+				       struct dsi_display_mode *dsi_mode)
+{
+	struct dsi_display_mode *panel_mode;
+	int rc;
+
+	SDE_EVT32(SDE_EVTLOG_FUNC_ENTRY, dsi_mode->timing.refresh_rate);
+
+	panel_mode = display->panel->cur_mode;
+	memcpy(panel_mode, dsi_mode, sizeof(*panel_mode));
+	panel_mode->dsi_mode_flags = 0;
+
+	rc = dsi_panel_switch(display->panel);
+	if (rc)
+		pr_err("[%s] failed to switch panel refresh rate, rc=%d\n",
+		       display->name, rc);
+
+	SDE_EVT32(SDE_EVTLOG_FUNC_EXIT, rc);
+	return rc;
+}
+
 static int dsi_display_dfps_update(struct dsi_display *display,
 				   struct dsi_display_mode *dsi_mode)
 {
@@ -4277,6 +4305,9 @@ static int dsi_display_dfps_update(struct dsi_display *display,
 	}
 	timing = &dsi_mode->timing;
 
+	if (display->panel->panel_mode == DSI_OP_CMD_MODE)
+		return dsi_display_cmd_dfps_update(display, dsi_mode);
+
 	dsi_panel_get_dfps_caps(display->panel, &dfps_caps);
 	if (!dfps_caps.dfps_support) {
 		pr_err("dfps not supported\n");
@@ -6008,6 +6039,20 @@ int dsi_display_find_mode(struct dsi_display *display,
 	return rc;
 }
 
+/*
+ * Command mode panels change their TE rate through the timing switch
+ * commands of the target mode rather than through a dfps list.
+ */
+static bool dsi_display_cmd_dfps_supported(struct dsi_display *display,
+		struct dsi_display_mode *adj_mode)
+{
+	if (display->panel->panel_mode != DSI_OP_CMD_MODE ||
+	    !adj_mode->priv_info)
+		return false;
+
+	return adj_mode->priv_info->cmd_sets[DSI_CMD_SET_TIMING_SWITCH].count;
+}
+
 /**
  * dsi_display_validate_mode_change() - Validate if varaible refresh case.
  * @display:     DSI display handle.
@@ -6043,7 +6088,8 @@ int dsi_display_validate_mode_change(struct dsi_display *display,
 		if (cur_mode->timing.refresh_rate !=
 		    adj_mode->timing.refresh_rate) {
 			dsi_panel_get_dfps_caps(display->panel, &dfps_caps);
-			if (!dfps_caps.dfps_support) {
+			if (!dfps_caps.dfps_support &&
+			    !dsi_display_cmd_dfps_supported(display, adj_mode)) {
 				pr_err("invalid mode dfps not supported\n");
 				rc = -ENOTSUPP;
 				goto error;
@@ -6182,6 +6228,9 @@ int dsi_display_set_mode(struct dsi_display *display,
 	}
 
 	memcpy(display->panel->cur_mode, &adj_mode, sizeof(adj_mode));
+
+	if (display->is_prim_display)
+		msm_drm_set_refresh_rate(adj_mode.timing.refresh_rate);
 error:
 	mutex_unlock(&display->display_lock);
 	return rc;
@@ -1087,7 +1087,11 @@ int dsi_conn_post_kickoff(struct drm_connector *connector)
 	adj_mode = c_bridge->dsi_mode;
 	display = c_bridge->display;
 
-	if (adj_mode.dsi_mode_flags & DSI_MODE_FLAG_VRR) {
+	/* command mode has no video timing double buffer to latch */
+	if ((adj_mode.dsi_mode_flags & DSI_MODE_FLAG_VRR) &&
+	    display->panel->panel_mode == DSI_OP_CMD_MODE) {
+		c_bridge->dsi_mode.dsi_mode_flags &= ~DSI_MODE_FLAG_VRR;
+	} else if (adj_mode.dsi_mode_flags & DSI_MODE_FLAG_VRR) {
 		m_ctrl = &display->ctrl[display->clk_master_idx];
 		rc = dsi_ctrl_timing_db_update(m_ctrl->ctrl, false);
 		if (rc) {
@@ -56,6 +56,9 @@
 #define MAX_PANEL_JITTER		10
 #define DEFAULT_PANEL_PREFILL_LINES	25
 
+/* Must not exceed the cmd tx buffer allocated by dsi_display */
+#define DSI_PANEL_CMD_BATCH_MAX		SZ_4K
+
 #define DISPLAY_OFF_MODE 0x60000
 #define DISPLAY_ON_MODE 0x70000
 
@@ -800,13 +803,40 @@ static int dsi_panel_power_off(struct dsi_panel *panel)
 
 	return rc;
 }
+/*
+ * Size the command occupies in the embedded mode dma buffer: a 4 byte
+ * header, followed by the payload padded to a word for long packets.
+ */
+static u32 dsi_panel_cmd_packed_len(const struct dsi_cmd_desc *cmd)
+{
+	if (!mipi_dsi_packet_format_is_long(cmd->msg.type))
+		return 4;
+
+	return 4 + ALIGN(cmd->msg.tx_len, 4);
+}
+
+/*
+ * Within a batched set the dma is only triggered at the end of the set,
+ * before a delay that has to be observed between two commands, for
+ * commands expecting a response, or when the next command would no
+ * longer fit in the tx buffer.
+ */
+static bool dsi_panel_cmd_ends_batch(const struct dsi_cmd_desc *cmd,
+				     bool last, u32 next_len)
+{
+	return last || cmd->post_wait_ms ||
+	       (cmd->msg.flags & MIPI_DSI_MSG_REQ_ACK) ||
+	       next_len > DSI_PANEL_CMD_BATCH_MAX;
+}
+
 static int dsi_panel_tx_cmd_set(struct dsi_panel *panel,
 				enum dsi_cmd_set_type type)
 {
 	int rc = 0, i = 0;
 	ssize_t len;
 	struct dsi_cmd_desc *cmds;
-	u32 count;
+	u32 count, batch_len = 0;
+	bool batched;
 	enum dsi_cmd_set_state state;
 	struct dsi_display_mode *mode;
 	const struct mipi_dsi_host_ops *ops = panel->host->ops;
@@ -822,6 +852,7 @@ static int dsi_panel_tx_cmd_set(struct dsi_panel *panel,
 	cmds = mode->priv_info->cmd_sets[type].cmds;
 	count = mode->priv_info->cmd_sets[type].count;
 	state = mode->priv_info->cmd_sets[type].state;
+	batched = mode->priv_info->cmd_sets[type].batched;
 
 	if (count == 0) {
 		pr_debug("[%s] No commands to be sent for state(%d)\n",
@@ -833,8 +864,21 @@ static int dsi_panel_tx_cmd_set(struct dsi_panel *panel,
 		if (state == DSI_CMD_SET_STATE_LP)
 			cmds->msg.flags |= MIPI_DSI_MSG_USE_LPM;
 
-		if (cmds->last_command)
+		if (batched) {
+			bool last = (i == count - 1);
+			u32 next_len = last ? 0 : dsi_panel_cmd_packed_len(cmds + 1);
+
+			batch_len += dsi_panel_cmd_packed_len(cmds);
+			if (dsi_panel_cmd_ends_batch(cmds, last,
+						     batch_len + next_len)) {
+				cmds->msg.flags |= MIPI_DSI_MSG_LASTCOMMAND;
+				batch_len = 0;
+			} else {
+				cmds->msg.flags &= ~MIPI_DSI_MSG_LASTCOMMAND;
+			}
+		} else if (cmds->last_command) {
 			cmds->msg.flags |= MIPI_DSI_MSG_LASTCOMMAND;
+		}
 
 		len = ops->transfer(panel->host, &cmds->msg);
 		if (len < 0) {
@@ -2346,6 +2390,30 @@ static int dsi_panel_alloc_cmd_packets(struct dsi_panel_cmd_set *cmd,
 	return 0;
 }
 
+/*
+ * Sets sent from the commit path, where one dma round trip per command
+ * adds up to milliseconds of blocking time. Their per command last flags
+ * from the device tree are ignored in favour of batch boundaries.
+ */
+static bool dsi_panel_cmd_set_batchable(enum dsi_cmd_set_type type)
+{
+	switch (type) {
+	case DSI_CMD_SET_TIMING_SWITCH:
+	case DSI_CMD_SET_DOZE_HBM:
+	case DSI_CMD_SET_DOZE_LBM:
+	case DSI_CMD_SET_DISP_DIMMINGON:
+	case DSI_CMD_SET_DISP_DIMMINGOFF:
+	case DSI_CMD_SET_DISP_HBM_ON:
+	case DSI_CMD_SET_DISP_HBM_OFF:
+	case DSI_CMD_SET_DISP_HBM_FOD_ON:
+	case DSI_CMD_SET_DISP_HBM_FOD_OFF:
+	case DSI_CMD_SET_DISP_HBM_FOD2NORM:
+		return true;
+	default:
+		return false;
+	}
+}
+
 static int dsi_panel_parse_cmd_sets_sub(struct dsi_panel_cmd_set *cmd,
 					enum dsi_cmd_set_type type,
 					struct device_node *of_node)
@@ -2384,6 +2452,8 @@ static int dsi_panel_parse_cmd_sets_sub(struct dsi_panel_cmd_set *cmd,
 		goto error_free_mem;
 	}
 
+	cmd->batched = dsi_panel_cmd_set_batchable(type);
+
 	state = of_get_property(of_node, cmd_set_state_map[type], NULL);
 	if (!state || !strcmp(state, "dsi_lp_mode")) {
 		cmd->state = DSI_CMD_SET_STATE_LP;
@@ -66,6 +66,29 @@ int msm_drm_unregister_client(struct notifier_block *nb)
 }
 EXPORT_SYMBOL(msm_drm_unregister_client);
 
+static unsigned int msm_drm_refresh_rate;
+
+/**
+ * msm_drm_get_refresh_rate - refresh rate of the primary display
+ *
+ * Returns the refresh rate in Hz of the mode last set on the primary
+ * display, or 0 if no mode has been set yet.
+ */
+unsigned int msm_drm_get_refresh_rate(void)
+{
+	return READ_ONCE(msm_drm_refresh_rate);
+}
+EXPORT_SYMBOL(msm_drm_get_refresh_rate);
+
+/**
+ * msm_drm_set_refresh_rate - record the refresh rate of the primary display
+ * @refresh_rate: refresh rate in Hz
+ */
+void msm_drm_set_refresh_rate(unsigned int refresh_rate)
+{
+	WRITE_ONCE(msm_drm_refresh_rate, refresh_rate);
+}
+
 /**
  * msm_drm_notifier_call_chain - notify clients of drm_events
  * @val: event MSM_DRM_EARLY_EVENT_BLANK or MSM_DRM_EVENT_BLANK
@@ -626,6 +649,8 @@ static void msm_atomic_commit_dispatch(struct drm_device *dev,
 	/* cache since work will kfree commit in non-blocking case */
 	nonblock = commit->nonblock;
 
+	msm_thread_policy_update_boost(priv);
+
 	for_each_crtc_in_state(state, crtc, crtc_state, i) {
 		for (j = 0; j < priv->num_crtcs; j++) {
 			if (priv->disp_thread[j].crtc_id ==
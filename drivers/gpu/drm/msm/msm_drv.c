@@ -41,6 +41,7 @@
 #include <linux/of_address.h>
 #include <linux/kthread.h>
 #include <linux/workqueue.h>
+#include <linux/cpu_input_boost.h>
 #include "msm_drv.h"
 #include "msm_debugfs.h"
 #include "msm_fence.h"
@@ -614,6 +615,227 @@ static void msm_idle_init(struct drm_device *ddev)
 	spin_lock_init(&idle->lock);
 }
 
+/**
+ * this priority was found during empiric testing to have appropriate
+ * realtime scheduling to process display updates and interact with
+ * other real time and normal priority task
+ */
+#define MSM_THREAD_DEFAULT_PRIORITY	16
+
+static void _msm_thread_set_policy(struct task_struct *thread,
+		struct msm_thread_policy *policy, const struct cpumask *cpus)
+{
+	struct sched_param param = { .sched_priority = policy->priority };
+	int ret;
+
+	if (!thread)
+		return;
+
+	ret = sched_setscheduler(thread, policy->priority ?
+			SCHED_FIFO : SCHED_NORMAL, &param);
+	if (ret)
+		pr_warn("%s priority update failed: %d\n", thread->comm, ret);
+
+	ret = set_cpus_allowed_ptr(thread, cpus);
+	if (ret)
+		pr_warn("%s affinity update failed: %d\n", thread->comm, ret);
+}
+
+/* must be called with the policy lock held */
+static void msm_thread_policy_apply(struct msm_drm_private *priv)
+{
+	struct msm_thread_policy *policy = &priv->thread_policy;
+	const struct cpumask *cpus = &policy->cpus;
+	int i;
+
+	if (policy->boosted && cpumask_intersects(cpu_perf_mask,
+			cpu_online_mask))
+		cpus = cpu_perf_mask;
+
+	/**
+	 * event thread should also run at same priority as disp_thread
+	 * because it is handling frame_done events. A lower priority
+	 * event thread and higher priority disp_thread can causes
+	 * frame_pending counters beyond 2. This can lead to commit
+	 * failure at crtc commit level.
+	 */
+	for (i = 0; i < priv->num_crtcs; i++) {
+		_msm_thread_set_policy(priv->disp_thread[i].thread, policy,
+				cpus);
+		_msm_thread_set_policy(priv->event_thread[i].thread, policy,
+				cpus);
+	}
+
+	_msm_thread_set_policy(priv->pp_event_thread, policy, cpus);
+}
+
+/**
+ * msm_thread_policy_update_boost - follow the input boost state
+ * @priv: msm drm private data
+ *
+ * Called on every commit. The threads are only touched when the boost
+ * state changed since the previous commit, so once a boost ends they move
+ * back to the configured cpus with the next frame.
+ */
+void msm_thread_policy_update_boost(struct msm_drm_private *priv)
+{
+	struct msm_thread_policy *policy = &priv->thread_policy;
+	bool boost;
+
+	boost = READ_ONCE(policy->boost_migrate) && cpu_input_boost_active();
+	if (boost == READ_ONCE(policy->boosted))
+		return;
+
+	mutex_lock(&policy->lock);
+	policy->boosted = boost;
+	msm_thread_policy_apply(priv);
+	mutex_unlock(&policy->lock);
+}
+
+static ssize_t commit_thread_priority_show(struct device *device,
+			      struct device_attribute *attr,
+			      char *buf)
+{
+	struct drm_device *ddev = dev_get_drvdata(device);
+	struct msm_drm_private *priv = ddev->dev_private;
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 priv->thread_policy.priority);
+}
+
+static ssize_t commit_thread_priority_store(struct device *device,
+			       struct device_attribute *attr,
+			       const char *buf, size_t count)
+{
+	struct drm_device *ddev = dev_get_drvdata(device);
+	struct msm_drm_private *priv = ddev->dev_private;
+	struct msm_thread_policy *policy = &priv->thread_policy;
+	u32 priority;
+	int rc;
+
+	rc = kstrtouint(buf, 10, &priority);
+	if (rc)
+		return rc;
+
+	if (priority >= MAX_USER_RT_PRIO)
+		return -EINVAL;
+
+	mutex_lock(&policy->lock);
+	policy->priority = priority;
+	msm_thread_policy_apply(priv);
+	mutex_unlock(&policy->lock);
+
+	return count;
+}
+
+static ssize_t commit_thread_cpus_show(struct device *device,
+			      struct device_attribute *attr,
+			      char *buf)
+{
+	struct drm_device *ddev = dev_get_drvdata(device);
+	struct msm_drm_private *priv = ddev->dev_private;
+
+	return cpumap_print_to_pagebuf(true, buf, &priv->thread_policy.cpus);
+}
+
+static ssize_t commit_thread_cpus_store(struct device *device,
+			       struct device_attribute *attr,
+			       const char *buf, size_t count)
+{
+	struct drm_device *ddev = dev_get_drvdata(device);
+	struct msm_drm_private *priv = ddev->dev_private;
+	struct msm_thread_policy *policy = &priv->thread_policy;
+	cpumask_t cpus;
+	int rc;
+
+	rc = cpulist_parse(buf, &cpus);
+	if (rc)
+		return rc;
+
+	if (!cpumask_intersects(&cpus, cpu_online_mask))
+		return -EINVAL;
+
+	mutex_lock(&policy->lock);
+	cpumask_copy(&policy->cpus, &cpus);
+	msm_thread_policy_apply(priv);
+	mutex_unlock(&policy->lock);
+
+	return count;
+}
+
+static ssize_t commit_thread_boost_migrate_show(struct device *device,
+			      struct device_attribute *attr,
+			      char *buf)
+{
+	struct drm_device *ddev = dev_get_drvdata(device);
+	struct msm_drm_private *priv = ddev->dev_private;
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n",
+			 priv->thread_policy.boost_migrate);
+}
+
+static ssize_t commit_thread_boost_migrate_store(struct device *device,
+			       struct device_attribute *attr,
+			       const char *buf, size_t count)
+{
+	struct drm_device *ddev = dev_get_drvdata(device);
+	struct msm_drm_private *priv = ddev->dev_private;
+	bool enable;
+	int rc;
+
+	rc = kstrtobool(buf, &enable);
+	if (rc)
+		return rc;
+
+	WRITE_ONCE(priv->thread_policy.boost_migrate, enable);
+	msm_thread_policy_update_boost(priv);
+
+	return count;
+}
+
+static DEVICE_ATTR_RW(commit_thread_priority);
+static DEVICE_ATTR_RW(commit_thread_cpus);
+static DEVICE_ATTR_RW(commit_thread_boost_migrate);
+
+static const struct attribute *msm_thread_policy_attrs[] = {
+	&dev_attr_commit_thread_priority.attr,
+	&dev_attr_commit_thread_cpus.attr,
+	&dev_attr_commit_thread_boost_migrate.attr,
+	NULL
+};
+
+static void msm_thread_policy_init(struct drm_device *ddev)
+{
+	struct msm_drm_private *priv = ddev->dev_private;
+	struct msm_thread_policy *policy = &priv->thread_policy;
+	struct device_node *np = ddev->dev->of_node;
+	int i, count;
+	u32 cpu;
+
+	mutex_init(&policy->lock);
+
+	if (of_property_read_u32(np, "qcom,commit-thread-priority",
+			&policy->priority) ||
+			policy->priority >= MAX_USER_RT_PRIO)
+		policy->priority = MSM_THREAD_DEFAULT_PRIORITY;
+
+	count = of_property_count_u32_elems(np, "qcom,commit-thread-cpus");
+	for (i = 0; i < count; i++) {
+		if (!of_property_read_u32_index(np, "qcom,commit-thread-cpus",
+				i, &cpu) && cpu < nr_cpu_ids)
+			cpumask_set_cpu(cpu, &policy->cpus);
+	}
+
+	if (cpumask_empty(&policy->cpus))
+		cpumask_copy(&policy->cpus, cpu_possible_mask);
+
+	policy->boost_migrate = of_property_read_bool(np,
+			"qcom,commit-thread-boost-migrate");
+
+	if (sysfs_create_files(&ddev->dev->kobj, msm_thread_policy_attrs) < 0)
+		pr_warn("failed to create commit thread policy files");
+}
+
 static int msm_drm_init(struct device *dev, struct drm_driver *drv)
 {
 	struct platform_device *pdev = to_platform_device(dev);
@@ -622,7 +844,6 @@ static int msm_drm_init(struct device *dev, struct drm_driver *drv)
 	struct msm_kms *kms;
 	struct sde_dbg_power_ctrl dbg_power_ctrl = { 0 };
 	int ret, i;
-	struct sched_param param;
 
 	ddev = drm_dev_alloc(drv, dev);
 	if (!ddev) {
@@ -676,6 +897,7 @@ static int msm_drm_init(struct device *dev, struct drm_driver *drv)
 	}
 
 	msm_idle_init(ddev);
+	msm_thread_policy_init(ddev);
 
 	/* Bind all our sub-components: */
 	ret = msm_component_bind_all(dev, ddev);
@@ -733,12 +955,6 @@ static int msm_drm_init(struct device *dev, struct drm_driver *drv)
 	}
 	ddev->mode_config.funcs = &mode_config_funcs;
 
-	/**
-	 * this priority was found during empiric testing to have appropriate
-	 * realtime scheduling to process display updates and interact with
-	 * other real time and normal priority task
-	 */
-	param.sched_priority = 16;
 	for (i = 0; i < priv->num_crtcs; i++) {
 
 		/* initialize display thread */
@@ -749,11 +965,6 @@ static int msm_drm_init(struct device *dev, struct drm_driver *drv)
 			kthread_run(kthread_worker_fn,
 				&priv->disp_thread[i].worker,
 				"crtc_commit:%d", priv->disp_thread[i].crtc_id);
-		ret = sched_setscheduler(priv->disp_thread[i].thread,
-							SCHED_FIFO, &param);
-		if (ret)
-			pr_warn("display thread priority update failed: %d\n",
-									ret);
 
 		if (IS_ERR(priv->disp_thread[i].thread)) {
 			dev_err(dev, "failed to create crtc_commit kthread\n");
@@ -768,18 +979,6 @@ static int msm_drm_init(struct device *dev, struct drm_driver *drv)
 			kthread_run(kthread_worker_fn,
 				&priv->event_thread[i].worker,
 				"crtc_event:%d", priv->event_thread[i].crtc_id);
-		/**
-		 * event thread should also run at same priority as disp_thread
-		 * because it is handling frame_done events. A lower priority
-		 * event thread and higher priority disp_thread can causes
-		 * frame_pending counters beyond 2. This can lead to commit
-		 * failure at crtc commit level.
-		 */
-		ret = sched_setscheduler(priv->event_thread[i].thread,
-							SCHED_FIFO, &param);
-		if (ret)
-			pr_warn("display event thread priority update failed: %d\n",
-									ret);
 
 		if (IS_ERR(priv->event_thread[i].thread)) {
 			dev_err(dev, "failed to create crtc_event kthread\n");
@@ -815,18 +1014,16 @@ static int msm_drm_init(struct device *dev, struct drm_driver *drv)
 	priv->pp_event_thread = kthread_run(kthread_worker_fn,
 			&priv->pp_event_worker, "pp_event");
 
-	ret = sched_setscheduler(priv->pp_event_thread,
-						SCHED_FIFO, &param);
-	if (ret)
-		pr_warn("pp_event thread priority update failed: %d\n",
-								ret);
-
 	if (IS_ERR(priv->pp_event_thread)) {
 		dev_err(dev, "failed to create pp_event kthread\n");
 		priv->pp_event_thread = NULL;
 		goto fail;
 	}
 
+	mutex_lock(&priv->thread_policy.lock);
+	msm_thread_policy_apply(priv);
+	mutex_unlock(&priv->thread_policy.lock);
+
 	ret = drm_vblank_init(ddev, priv->num_crtcs);
 	if (ret < 0) {
 		dev_err(dev, "failed to initialize vblank\n");
@@ -524,6 +524,24 @@ struct msm_idle {
 	struct delayed_work work;
 };
 
+/**
+ * struct msm_thread_policy - scheduling policy of the display kthreads
+ * @priority: SCHED_FIFO priority, 0 runs the threads as SCHED_NORMAL
+ * @cpus: cpus the threads are allowed to run on
+ * @boost_migrate: move the threads to the performance cluster while an
+ *                 input boost is active
+ * @boosted: threads currently follow the performance cluster
+ * @lock: serializes policy updates
+ */
+struct msm_thread_policy {
+	u32 priority;
+	cpumask_t cpus;
+	bool boost_migrate;
+	bool boosted;
+
+	struct mutex lock;
+};
+
 struct msm_drm_private {
 
 	struct drm_device *dev;
@@ -640,6 +658,8 @@ struct msm_drm_private {
 	bool shutdown_in_progress;
 
 	struct msm_idle idle;
+
+	struct msm_thread_policy thread_policy;
 };
 
 /* get struct msm_kms * from drm_device * */
@@ -880,6 +900,7 @@ void __init msm_mdp_register(void);
 void __exit msm_mdp_unregister(void);
 
 void msm_idle_set_state(struct drm_encoder *encoder, bool active);
+void msm_thread_policy_update_boost(struct msm_drm_private *priv);
 #ifdef CONFIG_DEBUG_FS
 void msm_gem_describe(struct drm_gem_object *obj, struct seq_file *m);
 void msm_gem_describe_objects(struct list_head *list, struct seq_file *m);
@@ -610,6 +610,25 @@ static int _sde_connector_update_dirty_properties(
 	return 0;
 }
 
+bool sde_connector_is_dirty(struct drm_connector *connector)
+{
+	struct sde_connector *c_conn;
+	struct sde_connector_state *c_state;
+	bool dirty;
+
+	if (!connector || !connector->state)
+		return false;
+
+	c_conn = to_sde_connector(connector);
+	c_state = to_sde_connector_state(connector->state);
+
+	mutex_lock(&c_conn->property_info.property_lock);
+	dirty = !list_empty(&c_state->property_state.dirty_list);
+	mutex_unlock(&c_conn->property_info.property_lock);
+
+	return dirty || c_conn->bl_scale_dirty;
+}
+
 int sde_connector_pre_kickoff(struct drm_connector *connector)
 {
 	struct sde_connector *c_conn;
@@ -1809,6 +1828,64 @@ static const struct drm_connector_funcs sde_connector_ops = {
 	.early_unregister =       sde_connector_early_unregister,
 };
 
+static void _sde_connector_update_refresh_rates(struct sde_connector *c_conn)
+{
+	struct drm_display_mode *mode;
+	u32 i, count = 0;
+
+	list_for_each_entry(mode, &c_conn->base.probed_modes, head) {
+		for (i = 0; i < count; i++)
+			if (c_conn->refresh_rates[i].hdisplay == mode->hdisplay &&
+			    c_conn->refresh_rates[i].vdisplay == mode->vdisplay &&
+			    c_conn->refresh_rates[i].vrefresh == mode->vrefresh)
+				break;
+
+		if (i < count)
+			continue;
+
+		if (count == SDE_CONNECTOR_MAX_REFRESH_RATES)
+			break;
+
+		c_conn->refresh_rates[count].hdisplay = mode->hdisplay;
+		c_conn->refresh_rates[count].vdisplay = mode->vdisplay;
+		c_conn->refresh_rates[count].vrefresh = mode->vrefresh;
+		count++;
+	}
+
+	c_conn->num_refresh_rates = count;
+}
+
+int sde_connector_get_min_refresh_rate(struct drm_connector *connector,
+		const struct drm_display_mode *mode, int fps)
+{
+	struct sde_connector *c_conn;
+	int rate, best = 0, highest = 0;
+	u32 i;
+
+	if (!connector || !mode) {
+		SDE_ERROR("invalid argument(s)\n");
+		return 0;
+	}
+
+	c_conn = to_sde_connector(connector);
+
+	for (i = 0; i < c_conn->num_refresh_rates; i++) {
+		if (c_conn->refresh_rates[i].hdisplay != mode->hdisplay ||
+		    c_conn->refresh_rates[i].vdisplay != mode->vdisplay)
+			continue;
+
+		rate = c_conn->refresh_rates[i].vrefresh;
+		highest = max(highest, rate);
+		if (rate >= fps && (!best || rate < best))
+			best = rate;
+	}
+
+	if (best)
+		return best;
+
+	return highest ? highest : mode->vrefresh;
+}
+
 static int sde_connector_get_modes(struct drm_connector *connector)
 {
 	struct sde_connector *c_conn;
@@ -1831,6 +1908,8 @@ static int sde_connector_get_modes(struct drm_connector *connector)
 		return 0;
 	}
 
+	_sde_connector_update_refresh_rates(c_conn);
+
 	if (c_conn->hdr_capable)
 		sde_connector_update_hdr_props(connector);
 
@@ -24,6 +24,7 @@
 #include "sde_fence.h"
 
 #define SDE_CONNECTOR_NAME_SIZE	16
+#define SDE_CONNECTOR_MAX_REFRESH_RATES	8
 
 struct sde_connector;
 struct sde_connector_state;
@@ -358,6 +359,8 @@ struct sde_connector_evt {
  * @allow_bl_update: Flag to indicate if BL update is allowed currently or not
  * @last_cmd_tx_sts: status of the last command transfer
  * @hdr_capable: external hdr support present
+ * @refresh_rates: Resolution and refresh rate of each probed mode
+ * @num_refresh_rates: Number of valid entries in refresh_rates
  */
 struct sde_connector {
 	struct drm_connector base;
@@ -407,6 +410,13 @@ struct sde_connector {
 	bool last_cmd_tx_sts;
 	bool hdr_capable;
 	bool panel_dead_skip;
+
+	struct {
+		int hdisplay;
+		int vdisplay;
+		int vrefresh;
+	} refresh_rates[SDE_CONNECTOR_MAX_REFRESH_RATES];
+	u32 num_refresh_rates;
 };
 
 /**
@@ -706,6 +716,25 @@ void sde_connector_unregister_event(struct drm_connector *connector,
 int sde_connector_register_custom_event(struct sde_kms *kms,
 		struct drm_connector *conn_drm, u32 event, bool en);
 
+/**
+ * sde_connector_is_dirty - check for connector properties pending kickoff
+ * @connector: Pointer to drm connector object
+ * Returns: true if any property was set since the last kickoff
+ */
+bool sde_connector_is_dirty(struct drm_connector *connector);
+
+/**
+ * sde_connector_get_min_refresh_rate - lowest refresh rate able to show @fps
+ * @connector: Pointer to drm connector object
+ * @mode: Pointer to the current mode, only its resolution is considered
+ * @fps: Rate at which the content is updated
+ * Returns: The lowest probed refresh rate of at least @fps at the resolution
+ *	of @mode, the highest one if none is fast enough, or the refresh rate
+ *	of @mode if the connector has no other modes at that resolution
+ */
+int sde_connector_get_min_refresh_rate(struct drm_connector *connector,
+		const struct drm_display_mode *mode, int fps);
+
 /**
  * sde_connector_pre_kickoff - trigger kickoff time feature programming
  * @connector: Pointer to drm connector object
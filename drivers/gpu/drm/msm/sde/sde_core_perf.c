@@ -107,6 +107,78 @@ static bool _sde_core_video_mode_intf_connected(struct drm_crtc *crtc)
 	return intf_connected;
 }
 
+/**
+ * _sde_core_perf_predict_bw - trim the ab vote to the expected frame fetch
+ * @kms: Pointer to the kms
+ * @crtc: Pointer to drm crtc
+ * @state: Pointer to new crtc state
+ * @perf: Pointer to performance parameters to update
+ *
+ * The ab votes set by user mode describe the worst case of the layer
+ * stack. Estimate the bytes actually fetched for this frame instead: only
+ * the part of each layer inside the partial update roi is fetched, and
+ * UBWC layers are assumed to compress by ubwc_ratio percent. The ib votes
+ * are left untouched so the latency requirement of the pipes still holds.
+ */
+static void _sde_core_perf_predict_bw(struct sde_kms *kms,
+		struct drm_crtc *crtc,
+		struct drm_crtc_state *state,
+		struct sde_core_perf_params *perf)
+{
+	struct sde_core_perf *core_perf = &kms->perf;
+	const struct drm_plane_state *pstate;
+	const struct sde_rect *crtc_roi;
+	struct drm_plane *plane;
+	u64 bytes = 0, bw;
+	int fps, i;
+
+	fps = drm_mode_vrefresh(&state->adjusted_mode);
+	if (fps <= 0)
+		return;
+
+	sde_crtc_get_crtc_roi(state, &crtc_roi);
+
+	drm_atomic_crtc_state_for_each_plane_state(plane, pstate, state) {
+		const struct sde_format *fmt;
+		struct sde_rect dst, vis;
+		u64 fetch;
+
+		if (IS_ERR_OR_NULL(pstate) || !pstate->fb)
+			continue;
+
+		fmt = to_sde_format(msm_framebuffer_format(pstate->fb));
+
+		dst.x = max(pstate->crtc_x, 0);
+		dst.y = max(pstate->crtc_y, 0);
+		dst.w = pstate->crtc_w;
+		dst.h = pstate->crtc_h;
+		if (!dst.w || !dst.h)
+			continue;
+
+		fetch = (u64)(pstate->src_w >> 16) * (pstate->src_h >> 16) *
+				fmt->bpp;
+
+		if (crtc_roi && !sde_kms_rect_is_null(crtc_roi)) {
+			sde_kms_rect_intersect(&dst, crtc_roi, &vis);
+			fetch = div_u64(fetch * vis.w * vis.h,
+					(u32)dst.w * dst.h);
+		}
+
+		if (SDE_FORMAT_IS_UBWC(fmt))
+			fetch = div_u64(fetch * core_perf->ubwc_ratio, 100);
+
+		bytes += fetch;
+	}
+
+	bw = div_u64(bytes * fps * SDE_PERF_PREDICT_HEADROOM, 100);
+
+	for (i = 0; i < SDE_POWER_HANDLE_DBUS_ID_MAX; i++)
+		if (bw < perf->bw_ctl[i])
+			perf->bw_ctl[i] = bw;
+
+	SDE_EVT32(crtc->base.id, fps, bytes, bw);
+}
+
 static void _sde_core_perf_calc_crtc(struct sde_kms *kms,
 		struct drm_crtc *crtc,
 		struct drm_crtc_state *state,
@@ -170,6 +242,8 @@ static void _sde_core_perf_calc_crtc(struct sde_kms *kms,
 			perf->max_per_pipe_ib[i] = kms->perf.fix_core_ib_vote;
 		}
 		perf->core_clk_rate = kms->perf.fix_core_clk_rate;
+	} else if (kms->perf.predictive_bw) {
+		_sde_core_perf_predict_bw(kms, crtc, state, perf);
 	}
 
 	trace_sde_perf_calc_crtc(crtc->base.id,
@@ -781,6 +855,10 @@ int sde_core_perf_debugfs_init(struct sde_core_perf *perf,
 			&perf->core_clk_rate);
 	debugfs_create_u32("enable_bw_release", 0600, perf->debugfs_root,
 			(u32 *)&perf->enable_bw_release);
+	debugfs_create_u32("predictive_bw", 0600, perf->debugfs_root,
+			&perf->predictive_bw);
+	debugfs_create_u32("ubwc_ratio", 0600, perf->debugfs_root,
+			&perf->ubwc_ratio);
 	debugfs_create_u32("threshold_low", 0600, perf->debugfs_root,
 			(u32 *)&catalog->perf.max_bw_low);
 	debugfs_create_u32("threshold_high", 0600, perf->debugfs_root,
@@ -851,6 +929,7 @@ int sde_core_perf_init(struct sde_core_perf *perf,
 	perf->phandle = phandle;
 	perf->pclient = pclient;
 	perf->clk_name = clk_name;
+	perf->ubwc_ratio = SDE_PERF_DEFAULT_UBWC_RATIO;
 	perf->sde_rsc_available = is_sde_rsc_available(SDE_RSC_INDEX);
 	/* set default mode */
 	if (perf->sde_rsc_available)
@@ -23,6 +23,12 @@
 
 #define	SDE_PERF_DEFAULT_MAX_CORE_CLK_RATE	320000000
 
+/* assumed UBWC fetch size in percent of the uncompressed size */
+#define SDE_PERF_DEFAULT_UBWC_RATIO	70
+
+/* headroom in percent applied to the predicted bandwidth */
+#define SDE_PERF_PREDICT_HEADROOM	125
+
 /**
  * struct sde_core_perf_params - definition of performance parameters
  * @max_per_pipe_ib: maximum instantaneous bandwidth request
@@ -66,6 +72,9 @@ struct sde_core_perf_tune {
  * @bw_vote_mode: apps rsc vs display rsc bandwidth vote mode
  * @sde_rsc_available: is display rsc available
  * @bw_vote_mode_updated: bandwidth vote mode update
+ * @predictive_bw: vote ab for the estimated frame fetch instead of the
+ *	user mode worst case
+ * @ubwc_ratio: assumed UBWC fetch size in percent for predictive_bw
  */
 struct sde_core_perf {
 	struct drm_device *dev;
@@ -85,6 +94,8 @@ struct sde_core_perf {
 	u32 bw_vote_mode;
 	bool sde_rsc_available;
 	bool bw_vote_mode_updated;
+	u32 predictive_bw;
+	u32 ubwc_ratio;
 };
 
 /**
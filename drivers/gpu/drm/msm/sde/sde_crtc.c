@@ -21,6 +21,7 @@
 #include <linux/sort.h>
 #include <linux/debugfs.h>
 #include <linux/ktime.h>
+#include <linux/cpu_input_boost.h>
 #include <uapi/drm/sde_drm.h>
 #include <drm/drm_mode.h>
 #include <drm/drm_crtc.h>
@@ -89,6 +90,14 @@ static struct sde_crtc_custom_events custom_events[] = {
 #define MAX_FRAME_COUNT			1000
 #define MILI_TO_MICRO			1000
 
+/*
+ * Content rate heuristic: a refresh rate is good enough for content within
+ * 2% of it, and a lower rate is only preferred once the content has been
+ * slower for this many consecutive periods.
+ */
+#define CONTENT_FPS_TOLERANCE_PCT	98
+#define REFRESH_DOWN_PERIODS		2
+
 static inline struct sde_kms *_sde_crtc_get_kms(struct drm_crtc *crtc)
 {
 	struct msm_drm_private *priv;
@@ -135,6 +144,50 @@ static inline int _sde_crtc_power_enable(struct sde_crtc *sde_crtc, bool enable)
 									enable);
 }
 
+/*
+ * _sde_crtc_update_preferred_refresh() - Arbitrate the refresh rate
+ * @sde_crtc   : CRTC structure
+ *
+ * Picks the lowest refresh rate of the connector that still shows every
+ * content update, based on the rate of commits that were not static.
+ * Higher rates are taken at once, lower ones only after the content has
+ * stayed slow. User space is notified of changes through sysfs and can
+ * move to the new rate with a seamless VRR commit.
+ */
+static void _sde_crtc_update_preferred_refresh(struct sde_crtc *sde_crtc)
+{
+	struct drm_crtc_state *state = sde_crtc->base.state;
+	struct sde_crtc_state *cstate;
+	struct sde_crtc_fps_info *info = &sde_crtc->fps_info;
+	int fps, rate;
+
+	if (!state)
+		return;
+
+	cstate = to_sde_crtc_state(state);
+	if (!cstate->num_connectors)
+		return;
+
+	fps = DIV_ROUND_UP(info->content_fps * CONTENT_FPS_TOLERANCE_PCT, 1000);
+	rate = sde_connector_get_min_refresh_rate(cstate->connectors[0],
+			&state->adjusted_mode, fps);
+
+	if (rate < info->preferred_refresh &&
+			++info->refresh_down_cnt < REFRESH_DOWN_PERIODS)
+		return;
+
+	info->refresh_down_cnt = 0;
+	if (rate == info->preferred_refresh)
+		return;
+
+	SDE_EVT32(DRMID(&sde_crtc->base), info->content_fps,
+			info->preferred_refresh, rate);
+	info->preferred_refresh = rate;
+
+	if (sde_crtc->preferred_refresh_sf)
+		sysfs_notify_dirent(sde_crtc->preferred_refresh_sf);
+}
+
 /*
  * sde_crtc_calc_fps() - Calculates fps value.
  * @sde_crtc   : CRTC structure
@@ -153,6 +206,8 @@ static void sde_crtc_calc_fps(struct sde_crtc *sde_crtc)
 	diff_us = (u64)ktime_us_delta(current_time_us,
 			sde_crtc->fps_info.last_sampled_time_us);
 	sde_crtc->fps_info.frame_count++;
+	if (!sde_crtc->static_frame)
+		sde_crtc->fps_info.content_count++;
 
 	if (diff_us >= DEFAULT_FPS_PERIOD_1_SEC) {
 
@@ -166,6 +221,13 @@ static void sde_crtc_calc_fps(struct sde_crtc *sde_crtc)
 				(unsigned int)fps%10);
 		sde_crtc->fps_info.last_sampled_time_us = current_time_us;
 		sde_crtc->fps_info.frame_count = 0;
+
+		fps = ((u64)sde_crtc->fps_info.content_count)
+						* DEFAULT_FPS_PERIOD_1_SEC * 10;
+		do_div(fps, diff_us);
+		sde_crtc->fps_info.content_fps = (unsigned int)fps;
+		sde_crtc->fps_info.content_count = 0;
+		_sde_crtc_update_preferred_refresh(sde_crtc);
 	}
 
 	if (!sde_crtc->fps_info.time_buf)
@@ -871,14 +933,122 @@ static ssize_t vsync_event_show(struct device *device,
 			ktime_to_ns(sde_crtc->vblank_last_cb_time));
 }
 
+static const char * const sde_crtc_lat_stage_names[SDE_CRTC_LAT_MAX] = {
+	[SDE_CRTC_LAT_COMMIT_KICKOFF] = "commit_kickoff",
+	[SDE_CRTC_LAT_KICKOFF_VSYNC] = "kickoff_vsync",
+	[SDE_CRTC_LAT_VSYNC_RETIRE] = "vsync_retire",
+	[SDE_CRTC_LAT_COMMIT_RETIRE] = "commit_retire",
+};
+
+/**
+ * _sde_crtc_frame_stats_print - print the latency histograms of a crtc
+ * @sde_crtc: Pointer to sde crtc structure
+ * @buf: Output buffer
+ * @size: Size of the output buffer
+ * Returns: Number of characters written to @buf
+ */
+static ssize_t _sde_crtc_frame_stats_print(struct sde_crtc *sde_crtc,
+		char *buf, size_t size)
+{
+	struct sde_crtc_frame_stats *stats;
+	unsigned long flags;
+	ssize_t len = 0;
+	int i, j;
+
+	stats = kmalloc(sizeof(*stats), GFP_KERNEL);
+	if (!stats)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&sde_crtc->spin_lock, flags);
+	memcpy(stats, &sde_crtc->frame_stats, sizeof(*stats));
+	spin_unlock_irqrestore(&sde_crtc->spin_lock, flags);
+
+	len += scnprintf(buf + len, size - len,
+			"frames:%llu janky:%llu missed_vsyncs:%llu\n",
+			stats->frames, stats->janky_frames,
+			stats->missed_vsyncs);
+
+	len += scnprintf(buf + len, size - len, "%-15s <1", "bucket_ms:");
+	for (j = 1; j < SDE_CRTC_LAT_BUCKETS - 1; j++)
+		len += scnprintf(buf + len, size - len, " %d", 1 << (j - 1));
+	len += scnprintf(buf + len, size - len, " %d+\n", 1 << (j - 1));
+
+	for (i = 0; i < SDE_CRTC_LAT_MAX; i++) {
+		len += scnprintf(buf + len, size - len, "%-15s",
+				sde_crtc_lat_stage_names[i]);
+		for (j = 0; j < SDE_CRTC_LAT_BUCKETS; j++)
+			len += scnprintf(buf + len, size - len, " %llu",
+					stats->hist[i][j]);
+		len += scnprintf(buf + len, size - len, "\n");
+	}
+
+	kfree(stats);
+	return len;
+}
+
+static ssize_t frame_latency_show(struct device *device,
+	struct device_attribute *attr, char *buf)
+{
+	struct drm_crtc *crtc;
+
+	if (!device || !buf) {
+		SDE_ERROR("invalid input param(s)\n");
+		return -EAGAIN;
+	}
+
+	crtc = dev_get_drvdata(device);
+	return _sde_crtc_frame_stats_print(to_sde_crtc(crtc), buf, PAGE_SIZE);
+}
+
+static ssize_t content_fps_show(struct device *device,
+	struct device_attribute *attr, char *buf)
+{
+	struct drm_crtc *crtc;
+	struct sde_crtc *sde_crtc;
+	unsigned int fps;
+
+	if (!device || !buf) {
+		SDE_ERROR("invalid input param(s)\n");
+		return -EAGAIN;
+	}
+
+	crtc = dev_get_drvdata(device);
+	sde_crtc = to_sde_crtc(crtc);
+	fps = sde_crtc->fps_info.content_fps;
+	return scnprintf(buf, PAGE_SIZE, "%u.%u\n", fps / 10, fps % 10);
+}
+
+static ssize_t preferred_refresh_rate_show(struct device *device,
+	struct device_attribute *attr, char *buf)
+{
+	struct drm_crtc *crtc;
+	struct sde_crtc *sde_crtc;
+
+	if (!device || !buf) {
+		SDE_ERROR("invalid input param(s)\n");
+		return -EAGAIN;
+	}
+
+	crtc = dev_get_drvdata(device);
+	sde_crtc = to_sde_crtc(crtc);
+	return scnprintf(buf, PAGE_SIZE, "%d\n",
+			sde_crtc->fps_info.preferred_refresh);
+}
+
 static DEVICE_ATTR_RO(vsync_event);
 static DEVICE_ATTR(measured_fps, 0444, measured_fps_show, NULL);
 static DEVICE_ATTR(fps_periodicity_ms, 0644, fps_periodicity_show,
 							set_fps_periodicity);
+static DEVICE_ATTR_RO(content_fps);
+static DEVICE_ATTR_RO(preferred_refresh_rate);
+static DEVICE_ATTR_RO(frame_latency);
 static struct attribute *sde_crtc_dev_attrs[] = {
 	&dev_attr_vsync_event.attr,
 	&dev_attr_measured_fps.attr,
 	&dev_attr_fps_periodicity_ms.attr,
+	&dev_attr_content_fps.attr,
+	&dev_attr_preferred_refresh_rate.attr,
+	&dev_attr_frame_latency.attr,
 	NULL
 };
 
@@ -902,6 +1072,8 @@ static void sde_crtc_destroy(struct drm_crtc *crtc)
 
 	if (sde_crtc->vsync_event_sf)
 		sysfs_put(sde_crtc->vsync_event_sf);
+	if (sde_crtc->preferred_refresh_sf)
+		sysfs_put(sde_crtc->preferred_refresh_sf);
 	if (sde_crtc->sysfs_dev)
 		device_unregister(sde_crtc->sysfs_dev);
 
@@ -2541,6 +2713,143 @@ enum sde_intf_mode sde_crtc_get_intf_mode(struct drm_crtc *crtc)
 	return INTF_MODE_NONE;
 }
 
+/**
+ * _sde_crtc_frame_stats_kickoff - track a frame from kickoff until retire
+ * @crtc: Pointer to drm crtc structure
+ */
+static void _sde_crtc_frame_stats_kickoff(struct drm_crtc *crtc)
+{
+	struct sde_crtc *sde_crtc = to_sde_crtc(crtc);
+	struct sde_crtc_state *cstate = to_sde_crtc_state(crtc->state);
+	struct sde_crtc_frame_stats *stats = &sde_crtc->frame_stats;
+	int vrefresh = crtc->state->adjusted_mode.vrefresh;
+	unsigned long flags;
+	u32 idx;
+
+	spin_lock_irqsave(&sde_crtc->spin_lock, flags);
+	if (stats->count == SDE_CRTC_LAT_INFLIGHT) {
+		/* no retire event for the oldest frame, stop tracking it */
+		stats->head = (stats->head + 1) % SDE_CRTC_LAT_INFLIGHT;
+		stats->count--;
+	}
+
+	idx = (stats->head + stats->count) % SDE_CRTC_LAT_INFLIGHT;
+	stats->inflight[idx].commit = cstate->commit_ts;
+	stats->inflight[idx].kickoff = ktime_get();
+	stats->inflight[idx].vsync = ktime_set(0, 0);
+	stats->inflight[idx].period_us = vrefresh > 0 ?
+			USEC_PER_SEC / vrefresh : 0;
+	stats->count++;
+	spin_unlock_irqrestore(&sde_crtc->spin_lock, flags);
+}
+
+static void _sde_crtc_frame_stats_vsync(struct sde_crtc *sde_crtc, ktime_t ts)
+{
+	struct sde_crtc_frame_stats *stats = &sde_crtc->frame_stats;
+	unsigned long flags;
+	u32 i, idx;
+
+	spin_lock_irqsave(&sde_crtc->spin_lock, flags);
+	for (i = 0; i < stats->count; i++) {
+		idx = (stats->head + i) % SDE_CRTC_LAT_INFLIGHT;
+		if (ktime_equal(stats->inflight[idx].vsync, ktime_set(0, 0))) {
+			stats->inflight[idx].vsync = ts;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&sde_crtc->spin_lock, flags);
+}
+
+static inline u32 _sde_crtc_lat_bucket(s64 us)
+{
+	u32 ms = us > 0 ? (u32)div_s64(us, USEC_PER_MSEC) : 0;
+
+	return min_t(u32, fls(ms), SDE_CRTC_LAT_BUCKETS - 1);
+}
+
+/**
+ * _sde_crtc_frame_stats_retire - account the oldest frame in flight
+ * @crtc: Pointer to drm crtc structure
+ * @ts: ktime at which the retire fence was signaled
+ *
+ * A frame counts as on time when it retires within one and a half refresh
+ * periods of its kickoff; every further period is a missed vsync.
+ */
+static void _sde_crtc_frame_stats_retire(struct drm_crtc *crtc, ktime_t ts)
+{
+	struct sde_crtc *sde_crtc = to_sde_crtc(crtc);
+	struct sde_crtc_frame_stats *stats = &sde_crtc->frame_stats;
+	s64 lat[SDE_CRTC_LAT_MAX] = { -1, -1, -1, -1 };
+	ktime_t commit, kickoff, vsync;
+	unsigned long flags;
+	u32 period, missed = 0;
+	s64 kickoff_retire;
+	int i;
+
+	spin_lock_irqsave(&sde_crtc->spin_lock, flags);
+	if (!stats->count) {
+		spin_unlock_irqrestore(&sde_crtc->spin_lock, flags);
+		return;
+	}
+
+	commit = stats->inflight[stats->head].commit;
+	kickoff = stats->inflight[stats->head].kickoff;
+	vsync = stats->inflight[stats->head].vsync;
+	period = stats->inflight[stats->head].period_us;
+	stats->head = (stats->head + 1) % SDE_CRTC_LAT_INFLIGHT;
+	stats->count--;
+
+	kickoff_retire = ktime_us_delta(ts, kickoff);
+	if (!ktime_equal(commit, ktime_set(0, 0))) {
+		lat[SDE_CRTC_LAT_COMMIT_KICKOFF] =
+				ktime_us_delta(kickoff, commit);
+		lat[SDE_CRTC_LAT_COMMIT_RETIRE] = ktime_us_delta(ts, commit);
+	}
+	if (!ktime_equal(vsync, ktime_set(0, 0)) &&
+			ktime_compare(vsync, ts) <= 0) {
+		lat[SDE_CRTC_LAT_KICKOFF_VSYNC] =
+				ktime_us_delta(vsync, kickoff);
+		lat[SDE_CRTC_LAT_VSYNC_RETIRE] = ktime_us_delta(ts, vsync);
+	}
+
+	for (i = 0; i < SDE_CRTC_LAT_MAX; i++)
+		if (lat[i] >= 0)
+			stats->hist[i][_sde_crtc_lat_bucket(lat[i])]++;
+
+	if (period && kickoff_retire > period) {
+		missed = (u32)div_s64(kickoff_retire + period / 2, period);
+		missed = missed ? missed - 1 : 0;
+	}
+
+	stats->frames++;
+	stats->missed_vsyncs += missed;
+	if (missed)
+		stats->janky_frames++;
+	spin_unlock_irqrestore(&sde_crtc->spin_lock, flags);
+
+	trace_sde_crtc_frame_latency(DRMID(crtc),
+			lat[SDE_CRTC_LAT_COMMIT_KICKOFF],
+			lat[SDE_CRTC_LAT_KICKOFF_VSYNC],
+			lat[SDE_CRTC_LAT_VSYNC_RETIRE],
+			lat[SDE_CRTC_LAT_COMMIT_RETIRE], missed);
+}
+
+static void _sde_crtc_frame_stats_reset(struct sde_crtc *sde_crtc,
+		bool inflight_only)
+{
+	struct sde_crtc_frame_stats *stats = &sde_crtc->frame_stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&sde_crtc->spin_lock, flags);
+	if (inflight_only) {
+		stats->head = 0;
+		stats->count = 0;
+	} else {
+		memset(stats, 0, sizeof(*stats));
+	}
+	spin_unlock_irqrestore(&sde_crtc->spin_lock, flags);
+}
+
 static void sde_crtc_vblank_cb(void *data)
 {
 	struct drm_crtc *crtc = (struct drm_crtc *)data;
@@ -2553,6 +2862,7 @@ static void sde_crtc_vblank_cb(void *data)
 		sde_crtc->vblank_cb_count++;
 
 	sde_crtc->vblank_last_cb_time = ktime_get();
+	_sde_crtc_frame_stats_vsync(sde_crtc, sde_crtc->vblank_last_cb_time);
 	if (sde_crtc->vsync_event_sf)
 		sysfs_notify_dirent(sde_crtc->vsync_event_sf);
 
@@ -2646,11 +2956,14 @@ static void sde_crtc_frame_event_work(struct kthread_work *work)
 		SDE_ATRACE_END("signal_release_fence");
 	}
 
-	if (fevent->event & SDE_ENCODER_FRAME_EVENT_SIGNAL_RETIRE_FENCE)
+	if (fevent->event & SDE_ENCODER_FRAME_EVENT_SIGNAL_RETIRE_FENCE) {
 		/* this api should be called without spin_lock */
 		_sde_crtc_retire_event(fevent->connector, fevent->ts,
 				(fevent->event & SDE_ENCODER_FRAME_EVENT_ERROR)
 				? SDE_FENCE_SIGNAL_ERROR : SDE_FENCE_SIGNAL);
+		_sde_crtc_frame_stats_retire(crtc, fevent->ts);
+		cpu_input_boost_frame_event();
+	}
 
 	if (fevent->event & SDE_ENCODER_FRAME_EVENT_PANEL_DEAD)
 		SDE_ERROR("crtc%d ts:%lld received panel dead event\n",
@@ -3320,6 +3633,35 @@ static void _sde_crtc_setup_lm_bounds(struct drm_crtc *crtc,
 	drm_mode_debug_printmodeline(adj_mode);
 }
 
+/**
+ * _sde_crtc_is_static_frame - check if the commit changes the crtc output
+ * @crtc: Pointer to crtc
+ * @old_state: Pointer to the previous crtc state
+ *
+ * Only covers the crtc level state, planes mark the frame dirty from their
+ * atomic update.
+ */
+static bool _sde_crtc_is_static_frame(struct drm_crtc *crtc,
+		struct drm_crtc_state *old_state)
+{
+	struct sde_crtc *sde_crtc = to_sde_crtc(crtc);
+	struct sde_crtc_state *cstate = to_sde_crtc_state(crtc->state);
+
+	if (!old_state || drm_atomic_crtc_needs_modeset(crtc->state) ||
+			crtc->state->plane_mask != old_state->plane_mask ||
+			sde_crtc_is_crtc_roi_dirty(crtc->state))
+		return false;
+
+	/* crtc or color processing properties pending for this commit */
+	if (!list_empty(&cstate->property_state.dirty_list) ||
+			!list_empty(&sde_crtc->dirty_list) ||
+			!list_empty(&sde_crtc->ad_dirty) ||
+			!list_empty(&sde_crtc->ad_active))
+		return false;
+
+	return true;
+}
+
 static void sde_crtc_atomic_begin(struct drm_crtc *crtc,
 		struct drm_crtc_state *old_state)
 {
@@ -3375,7 +3717,10 @@ static void sde_crtc_atomic_begin(struct drm_crtc *crtc,
 	if (unlikely(!sde_crtc->num_mixers))
 		return;
 
+	sde_crtc->static_frame = _sde_crtc_is_static_frame(crtc, old_state);
+
 	if (_sde_crtc_get_ctlstart_timeout(crtc)) {
+		sde_crtc->static_frame = false;
 		_sde_crtc_blend_setup(crtc, old_state, false);
 		SDE_ERROR("border fill only commit after ctlstart timeout\n");
 	} else {
@@ -3949,6 +4294,7 @@ void sde_crtc_commit_kickoff(struct drm_crtc *crtc,
 		params.inline_rotate_prefill = cstate->sbuf_prefill_line;
 		params.affected_displays = _sde_crtc_get_displays_affected(crtc,
 				crtc->state);
+		params.static_frame = sde_crtc->static_frame && !is_error;
 		if (sde_encoder_prepare_for_kickoff(encoder, &params))
 			reset_req = true;
 
@@ -3972,6 +4318,7 @@ void sde_crtc_commit_kickoff(struct drm_crtc *crtc,
 	_sde_crtc_flush_event_thread(crtc);
 	SDE_ATRACE_END("flush_event_thread");
 	sde_crtc_calc_fps(sde_crtc);
+	_sde_crtc_frame_stats_kickoff(crtc);
 
 	if (atomic_inc_return(&sde_crtc->frame_pending) == 1) {
 		/* acquire bandwidth and other resources */
@@ -3984,6 +4331,7 @@ void sde_crtc_commit_kickoff(struct drm_crtc *crtc,
 				SDE_EVTLOG_FUNC_CASE2);
 	}
 	sde_crtc->play_count++;
+	cpu_input_boost_frame_event();
 
 	/*
 	 * For SYNC inline modes, delay the kick off until after the
@@ -4173,6 +4521,9 @@ static struct drm_crtc_state *sde_crtc_duplicate_state(struct drm_crtc *crtc)
 	/* record whether or not the sbuf_clk_rate fifo has been shifted */
 	cstate->sbuf_clk_shifted = false;
 
+	/* stamped again when the new state is checked */
+	cstate->commit_ts = ktime_set(0, 0);
+
 	/* duplicate base helper */
 	__drm_atomic_helper_crtc_duplicate_state(crtc, &cstate->base);
 
@@ -4441,6 +4792,7 @@ static void sde_crtc_disable(struct drm_crtc *crtc)
 		sde_core_perf_crtc_release_bw(crtc);
 		atomic_set(&sde_crtc->frame_pending, 0);
 	}
+	_sde_crtc_frame_stats_reset(sde_crtc, true);
 
 	spin_lock_irqsave(&sde_crtc->spin_lock, flags);
 	list_for_each_entry(node, &sde_crtc->user_event_list, list) {
@@ -4822,6 +5174,7 @@ static int sde_crtc_atomic_check(struct drm_crtc *crtc,
 
 	sde_crtc = to_sde_crtc(crtc);
 	cstate = to_sde_crtc_state(state);
+	cstate->commit_ts = ktime_get();
 
 	if (!state->enable || !state->active) {
 		SDE_DEBUG("crtc%d -> enable %d, active %d, skip atomic_check\n",
@@ -5019,13 +5372,6 @@ static int sde_crtc_atomic_check(struct drm_crtc *crtc,
 		}
 	}
 
-	rc = sde_core_perf_crtc_check(crtc, state);
-	if (rc) {
-		SDE_ERROR("crtc%d failed performance check %d\n",
-				crtc->base.id, rc);
-		goto end;
-	}
-
 	/* validate source split:
 	 * use pstates sorted by stage to check planes on same stage
 	 * we assume that all pipes are in source split so its valid to compare
@@ -5107,6 +5453,14 @@ static int sde_crtc_atomic_check(struct drm_crtc *crtc,
 		goto end;
 	}
 
+	/* the predictive bandwidth vote depends on the crtc roi */
+	rc = sde_core_perf_crtc_check(crtc, state);
+	if (rc) {
+		SDE_ERROR("crtc%d failed performance check %d\n",
+				crtc->base.id, rc);
+		goto end;
+	}
+
 end:
 	kfree(pstates);
 	kfree(multirect_plane);
@@ -6063,6 +6417,44 @@ static int _sde_debugfs_fence_status(struct inode *inode, struct file *file)
 				inode->i_private);
 }
 
+static ssize_t _sde_crtc_frame_latency_read(struct file *file,
+		char __user *user_buff, size_t count, loff_t *ppos)
+{
+	struct sde_crtc *sde_crtc;
+	ssize_t len;
+	char *buf;
+
+	if (!file || !file->private_data)
+		return -EINVAL;
+
+	sde_crtc = file->private_data;
+	buf = kzalloc(PAGE_SIZE, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	len = _sde_crtc_frame_stats_print(sde_crtc, buf, PAGE_SIZE);
+	if (len >= 0)
+		len = simple_read_from_buffer(user_buff, count, ppos, buf, len);
+
+	kfree(buf);
+	return len;
+}
+
+static ssize_t _sde_crtc_frame_latency_reset(struct file *file,
+		const char __user *user_buf, size_t count, loff_t *ppos)
+{
+	struct sde_crtc *sde_crtc;
+
+	if (!file || !file->private_data)
+		return -EINVAL;
+
+	/* any write clears the histograms */
+	sde_crtc = file->private_data;
+	_sde_crtc_frame_stats_reset(sde_crtc, false);
+
+	return count;
+}
+
 static int _sde_crtc_init_debugfs(struct drm_crtc *crtc)
 {
 	struct sde_crtc *sde_crtc;
@@ -6087,6 +6479,11 @@ static int _sde_crtc_init_debugfs(struct drm_crtc *crtc)
 		.open =		_sde_debugfs_fps_status,
 		.read =		seq_read,
 	};
+	static const struct file_operations debugfs_frame_latency_fops = {
+		.open =		simple_open,
+		.read =		_sde_crtc_frame_latency_read,
+		.write =	_sde_crtc_frame_latency_reset,
+	};
 
 	if (!crtc)
 		return -EINVAL;
@@ -6115,6 +6512,8 @@ static int _sde_crtc_init_debugfs(struct drm_crtc *crtc)
 					sde_crtc, &debugfs_fence_fops);
 	debugfs_create_file("fps", 0400, sde_crtc->debugfs_root,
 					sde_crtc, &debugfs_fps_fops);
+	debugfs_create_file("frame_latency", 0600, sde_crtc->debugfs_root,
+					sde_crtc, &debugfs_frame_latency_fops);
 
 	return 0;
 }
@@ -6411,6 +6810,12 @@ int sde_crtc_post_init(struct drm_device *dev, struct drm_crtc *crtc)
 		SDE_ERROR("crtc:%d vsync_event sysfs create failed\n",
 						crtc->base.id);
 
+	sde_crtc->preferred_refresh_sf = sysfs_get_dirent(
+		sde_crtc->sysfs_dev->kobj.sd, "preferred_refresh_rate");
+	if (!sde_crtc->preferred_refresh_sf)
+		SDE_ERROR("crtc:%d preferred_refresh_rate sysfs create failed\n",
+						crtc->base.id);
+
 end:
 	return rc;
 }
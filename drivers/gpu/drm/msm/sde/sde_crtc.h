@@ -157,6 +157,11 @@ struct sde_crtc_event {
  *                                Default value is 1 second.
  * @time_buf		: Buffer for storing ktime of the commits
  * @next_time_index	: index into time_buf for storing ktime for next commit
+ * @content_count	: Commits changing the output during the current period
+ * @content_fps		: Last measured rate of commits changing the output,
+ *                        10 times the calculated value like measured_fps
+ * @preferred_refresh	: Lowest refresh rate able to show the content
+ * @refresh_down_cnt	: Consecutive periods asking for a lower refresh
  */
 struct sde_crtc_fps_info {
 	u32 frame_count;
@@ -165,6 +170,55 @@ struct sde_crtc_fps_info {
 	u32 fps_periodic_duration;
 	ktime_t *time_buf;
 	u32 next_time_index;
+	u32 content_count;
+	u32 content_fps;
+	int preferred_refresh;
+	u32 refresh_down_cnt;
+};
+
+/**
+ * enum sde_crtc_lat_stage - stages of the commit to present latency
+ * @SDE_CRTC_LAT_COMMIT_KICKOFF: atomic commit to hardware kickoff
+ * @SDE_CRTC_LAT_KICKOFF_VSYNC: kickoff to the next vsync
+ * @SDE_CRTC_LAT_VSYNC_RETIRE: that vsync to the retire fence
+ * @SDE_CRTC_LAT_COMMIT_RETIRE: atomic commit to the retire fence
+ * @SDE_CRTC_LAT_MAX: number of stages
+ */
+enum sde_crtc_lat_stage {
+	SDE_CRTC_LAT_COMMIT_KICKOFF,
+	SDE_CRTC_LAT_KICKOFF_VSYNC,
+	SDE_CRTC_LAT_VSYNC_RETIRE,
+	SDE_CRTC_LAT_COMMIT_RETIRE,
+	SDE_CRTC_LAT_MAX,
+};
+
+/* Buckets are powers of two in ms, from below 1ms to 64ms and above */
+#define SDE_CRTC_LAT_BUCKETS		8
+#define SDE_CRTC_LAT_INFLIGHT		4
+
+/**
+ * struct sde_crtc_frame_stats - commit to present latency accounting
+ * @inflight	: Timestamps of the frames kicked off but not yet retired
+ * @head	: Index of the oldest in flight frame
+ * @count	: Number of in flight frames
+ * @hist	: Latency histogram of each stage
+ * @frames	: Number of retired frames accounted
+ * @missed_vsyncs: Total vsyncs missed between kickoff and retire
+ * @janky_frames: Number of frames that missed at least one vsync
+ */
+struct sde_crtc_frame_stats {
+	struct {
+		ktime_t commit;
+		ktime_t kickoff;
+		ktime_t vsync;
+		u32 period_us;
+	} inflight[SDE_CRTC_LAT_INFLIGHT];
+	u32 head;
+	u32 count;
+	u64 hist[SDE_CRTC_LAT_MAX][SDE_CRTC_LAT_BUCKETS];
+	u64 frames;
+	u64 missed_vsyncs;
+	u64 janky_frames;
 };
 
 /*
@@ -192,10 +246,14 @@ struct sde_crtc_fps_info {
  * @debugfs_root  : Parent of debugfs node
  * @vblank_cb_count : count of vblank callback since last reset
  * @play_count    : frame count between crtc enable and disable
+ * @static_frame  : true while nothing that affects the output has changed
+ *                  in the current commit
  * @vblank_cb_time  : ktime at vblank count reset
  * @vblank_last_cb_time  : ktime at last vblank notification
+ * @frame_stats : commit to present latency accounting, under spin_lock
  * @sysfs_dev  : sysfs device node for crtc
  * @vsync_event_sf : vsync event notifier sysfs device
+ * @preferred_refresh_sf : preferred refresh rate notifier sysfs device
  * @vblank_requested : whether the user has requested vblank events
  * @suspend         : whether or not a suspend operation is in progress
  * @enabled       : whether the SDE CRTC is currently enabled. updated in the
@@ -260,11 +318,14 @@ struct sde_crtc {
 
 	u32 vblank_cb_count;
 	u64 play_count;
+	bool static_frame;
 	ktime_t vblank_cb_time;
 	ktime_t vblank_last_cb_time;
 	struct sde_crtc_fps_info fps_info;
+	struct sde_crtc_frame_stats frame_stats;
 	struct device *sysfs_dev;
 	struct kernfs_node *vsync_event_sf;
+	struct kernfs_node *preferred_refresh_sf;
 	bool vblank_requested;
 	bool suspend;
 	bool enabled;
@@ -405,6 +466,7 @@ struct sde_crtc_respool {
  * @sbuf_clk_rate : previous and current user specified inline rotator clock
  * @sbuf_clk_shifted : whether or not sbuf_clk_rate has been shifted as part
  *	of crtc atomic check
+ * @commit_ts : ktime at which this state was checked for the commit
  */
 struct sde_crtc_state {
 	struct drm_crtc_state base;
@@ -438,6 +500,7 @@ struct sde_crtc_state {
 	u32 sbuf_prefill_line;
 	u64 sbuf_clk_rate[2];
 	bool sbuf_clk_shifted;
+	ktime_t commit_ts;
 
 	struct sde_crtc_respool rp;
 };
@@ -644,6 +707,16 @@ static inline u32 sde_crtc_get_inline_prefill(struct drm_crtc *crtc)
 		cstate->sbuf_prefill_line : 0;
 }
 
+/**
+ * sde_crtc_mark_frame_dirty - flag that the current commit changes the output
+ * @crtc: Pointer to crtc
+ */
+static inline void sde_crtc_mark_frame_dirty(struct drm_crtc *crtc)
+{
+	if (crtc)
+		to_sde_crtc(crtc)->static_frame = false;
+}
+
 /**
  * sde_crtc_is_reset_required - validate the reset request based on the
  *	pm_suspend and crtc's active status. crtc's are left active
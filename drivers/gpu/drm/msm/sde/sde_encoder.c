@@ -301,6 +301,11 @@ static struct sde_csc_cfg sde_csc_10bit_convert[SDE_MAX_CSC] = {
  * @misr_frame_count:		misr frame count before start capturing the data
  * @idle_pc_enabled:		indicate if idle power collapse is enabled
  *				currently. This can be controlled by user-mode
+ * @static_frame_threshold:	number of consecutive static commits after
+ *				which a command mode panel is left to self
+ *				refresh, 0 to always kick off
+ * @static_frame_cnt:		consecutive static commits seen so far
+ * @skip_kickoff:		current commit is not sent to the panel
  * @rc_lock:			resource control mutex lock to protect
  *				virt encoder over various state changes
  * @rc_state:			resource controller state
@@ -351,6 +356,9 @@ struct sde_encoder_virt {
 	u32 misr_frame_count;
 
 	bool idle_pc_enabled;
+	u32 static_frame_threshold;
+	u32 static_frame_cnt;
+	bool skip_kickoff;
 	struct mutex rc_lock;
 	enum sde_enc_rc_states rc_state;
 	struct kthread_delayed_work delayed_off_work;
@@ -4127,6 +4135,71 @@ int sde_encoder_poll_line_counts(struct drm_encoder *drm_enc)
 	return -ETIMEDOUT;
 }
 
+/**
+ * _sde_encoder_update_static_frame - track static commits
+ * @sde_enc: Pointer to virtual encoder
+ * @params: kickoff parameters of the current commit
+ *
+ * A command mode panel keeps showing the last transferred frame from its
+ * own memory. Once static_frame_threshold commits in a row didn't change
+ * the output, the frame transfer is skipped so that the idle timer can
+ * expire and the MDP can power collapse while the panel self refreshes.
+ * The first commit that changes the output is kicked off as usual.
+ */
+static void _sde_encoder_update_static_frame(struct sde_encoder_virt *sde_enc,
+		struct sde_encoder_kickoff_params *params)
+{
+	struct drm_connector *conn = NULL;
+	bool is_static = params->static_frame;
+
+	if (sde_enc->cur_master)
+		conn = sde_enc->cur_master->connector;
+
+	if (!sde_enc->static_frame_threshold || !conn || !conn->state ||
+			!(sde_enc->disp_info.capabilities &
+				MSM_DISPLAY_CAP_CMD_MODE) ||
+			sde_encoder_in_clone_mode(&sde_enc->base) ||
+			sde_connector_is_dirty(conn) ||
+			sde_connector_get_property(conn->state,
+				CONNECTOR_PROP_AUTOREFRESH))
+		is_static = false;
+
+	sde_enc->static_frame_cnt = is_static ?
+			sde_enc->static_frame_cnt + 1 : 0;
+	sde_enc->skip_kickoff = is_static &&
+		(sde_enc->static_frame_cnt >= sde_enc->static_frame_threshold);
+
+	SDE_EVT32_VERBOSE(DRMID(&sde_enc->base), is_static,
+			sde_enc->static_frame_cnt, sde_enc->skip_kickoff);
+}
+
+/**
+ * _sde_encoder_skip_kickoff - complete a static commit without a transfer
+ * @sde_enc: Pointer to virtual encoder
+ *
+ * The flush is left pending in the ctl and goes out with the next kickoff,
+ * the frame done is reported right away so that fences are signaled and
+ * the resources are released as after a transfer.
+ */
+static void _sde_encoder_skip_kickoff(struct sde_encoder_virt *sde_enc)
+{
+	u32 event = SDE_ENCODER_FRAME_EVENT_DONE |
+			SDE_ENCODER_FRAME_EVENT_SIGNAL_RELEASE_FENCE |
+			SDE_ENCODER_FRAME_EVENT_SIGNAL_RETIRE_FENCE;
+
+	SDE_EVT32(DRMID(&sde_enc->base), sde_enc->static_frame_cnt);
+
+	sde_encoder_resource_control(&sde_enc->base,
+			SDE_ENC_RC_EVENT_FRAME_DONE);
+
+	if (sde_enc->crtc_frame_event_cb) {
+		sde_enc->crtc_frame_event_cb_data.connector =
+				sde_enc->cur_master->connector;
+		sde_enc->crtc_frame_event_cb(
+				&sde_enc->crtc_frame_event_cb_data, event);
+	}
+}
+
 int sde_encoder_prepare_for_kickoff(struct drm_encoder *drm_enc,
 		struct sde_encoder_kickoff_params *params)
 {
@@ -4211,6 +4284,10 @@ int sde_encoder_prepare_for_kickoff(struct drm_encoder *drm_enc,
 
 	_sde_encoder_update_roi(drm_enc);
 
+	if (needs_hw_reset || ret)
+		params->static_frame = false;
+	_sde_encoder_update_static_frame(sde_enc, params);
+
 	if (sde_enc->cur_master && sde_enc->cur_master->connector) {
 		conn_mas = sde_enc->cur_master->connector;
 		rc = sde_connector_pre_kickoff(conn_mas);
@@ -4329,6 +4406,13 @@ void sde_encoder_kickoff(struct drm_encoder *drm_enc, bool is_error)
 	if (is_error)
 		_sde_encoder_reset_ctl_hw(drm_enc);
 
+	/* panel keeps showing the previous frame, nothing to transfer */
+	if (sde_enc->skip_kickoff && !is_error && sde_enc->cur_master) {
+		_sde_encoder_skip_kickoff(sde_enc);
+		SDE_ATRACE_END("encoder_kickoff");
+		return;
+	}
+
 	/* All phys encs are ready to go, trigger the kickoff */
 	_sde_encoder_kickoff_phys(sde_enc);
 
@@ -4637,6 +4721,9 @@ static int _sde_encoder_init_debugfs(struct drm_encoder *drm_enc)
 	debugfs_create_file("misr_data", 0600,
 		sde_enc->debugfs_root, sde_enc, &debugfs_misr_fops);
 
+	debugfs_create_u32("static_frame_threshold", 0600,
+		sde_enc->debugfs_root, &sde_enc->static_frame_threshold);
+
 	for (i = 0; i < sde_enc->num_phys_encs; i++)
 		if (sde_enc->phys_encs[i] &&
 				sde_enc->phys_encs[i]->ops.late_register)
@@ -327,6 +327,8 @@ static inline int sde_encoder_phys_inc_pending(struct sde_encoder_phys *phys)
  * @rot_fetch:	Prefill for inline rotation
  * @error_count: Number of consecutive kickoffs that experienced an error
  * @rot_fetch_valid: true if rot_fetch is updated (reset in enc enable)
+ * @vrr_pending: timing engine needs reprogramming for a seamless refresh
+ *	rate change at the next kickoff
  */
 struct sde_encoder_phys_vid {
 	struct sde_encoder_phys base;
@@ -335,6 +337,7 @@ struct sde_encoder_phys_vid {
 	struct intf_prog_fetch rot_fetch;
 	int error_count;
 	bool rot_fetch_valid;
+	bool vrr_pending;
 };
 
 /**
@@ -364,6 +367,8 @@ struct sde_encoder_phys_cmd_autorefresh {
  * @rd_ptr_timestamp: last rd_ptr_irq timestamp
  * @pending_vblank_cnt: Atomic counter tracking pending wait for VBLANK
  * @pending_vblank_wq: Wait queue for blocking until VBLANK received
+ * @vrr_pending: tear check needs reprogramming for a seamless refresh rate
+ *	change at the next kickoff
  */
 struct sde_encoder_phys_cmd {
 	struct sde_encoder_phys base;
@@ -376,6 +381,7 @@ struct sde_encoder_phys_cmd {
 	atomic_t pending_vblank_cnt;
 	wait_queue_head_t pending_vblank_wq;
 	struct work_struct ctl_wait_work;
+	bool vrr_pending;
 };
 
 /**
@@ -433,6 +433,11 @@ static void sde_encoder_phys_cmd_mode_set(
 	SDE_DEBUG_CMDENC(cmd_enc, "caching mode:\n");
 	drm_mode_debug_printmodeline(adj_mode);
 
+	/* enable is skipped for seamless vrr, retune the tear check instead */
+	if (phys_enc->enable_state == SDE_ENC_ENABLED &&
+			msm_is_mode_seamless_vrr(adj_mode))
+		cmd_enc->vrr_pending = true;
+
 	instance = phys_enc->split_role == ENC_ROLE_SLAVE ? 1 : 0;
 
 	/* Retrieve previously allocated HW Resources. Shouldn't fail */
@@ -1107,6 +1112,29 @@ static void sde_encoder_phys_cmd_get_hw_resources(
 	hw_res->intfs[phys_enc->intf_idx - INTF_0] = INTF_MODE_CMD;
 }
 
+/*
+ * The panel only changes its TE rate, so the vsync counter is all that has
+ * to follow. Reprogramming the tear check disconnects the external TE,
+ * which is restored to its previous state afterwards.
+ */
+static void _sde_encoder_phys_cmd_vrr_update(
+		struct sde_encoder_phys *phys_enc)
+{
+	struct sde_hw_pingpong *hw_pp = phys_enc->hw_pp;
+	int te_connected = 0;
+
+	if (hw_pp->ops.connect_external_te)
+		te_connected = hw_pp->ops.connect_external_te(hw_pp, false);
+
+	sde_encoder_phys_cmd_tearcheck_config(phys_enc);
+
+	if (te_connected > 0)
+		hw_pp->ops.connect_external_te(hw_pp, true);
+
+	SDE_EVT32(DRMID(phys_enc->parent), hw_pp->idx - PINGPONG_0,
+			phys_enc->cached_mode.vrefresh, te_connected);
+}
+
 static int sde_encoder_phys_cmd_prepare_for_kickoff(
 		struct sde_encoder_phys *phys_enc,
 		struct sde_encoder_kickoff_params *params)
@@ -1138,6 +1166,11 @@ static int sde_encoder_phys_cmd_prepare_for_kickoff(
 		SDE_ERROR("failed wait_for_idle: %d\n", ret);
 	}
 
+	if (cmd_enc->vrr_pending) {
+		_sde_encoder_phys_cmd_vrr_update(phys_enc);
+		cmd_enc->vrr_pending = false;
+	}
+
 	SDE_DEBUG_CMDENC(cmd_enc, "pp:%d pending_cnt %d\n",
 			phys_enc->hw_pp->idx - PINGPONG_0,
 			atomic_read(&phys_enc->pending_kickoff_cnt));
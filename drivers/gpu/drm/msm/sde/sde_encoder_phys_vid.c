@@ -358,32 +358,13 @@ static bool sde_encoder_phys_vid_mode_fixup(
 	return true;
 }
 
-static void sde_encoder_phys_vid_setup_timing_engine(
-		struct sde_encoder_phys *phys_enc)
+static void _sde_encoder_phys_vid_get_timing(
+		struct sde_encoder_phys *phys_enc,
+		struct intf_timing_params *timing_params)
 {
-	struct sde_encoder_phys_vid *vid_enc;
-	struct drm_display_mode mode;
-	struct intf_timing_params timing_params = { 0 };
-	const struct sde_format *fmt = NULL;
-	u32 fmt_fourcc = DRM_FORMAT_RGB888;
-	unsigned long lock_flags;
-	struct sde_hw_intf_cfg intf_cfg = { 0 };
-
-	if (!phys_enc || !phys_enc->sde_kms || !phys_enc->hw_ctl ||
-			!phys_enc->hw_ctl->ops.setup_intf_cfg) {
-		SDE_ERROR("invalid encoder %d\n", phys_enc != 0);
-		return;
-	}
-
-	mode = phys_enc->cached_mode;
-	vid_enc = to_sde_encoder_phys_vid(phys_enc);
-	if (!vid_enc->hw_intf->ops.setup_timing_gen) {
-		SDE_ERROR("timing engine setup is not supported\n");
-		return;
-	}
-
-	SDE_DEBUG_VIDENC(vid_enc, "enabling mode:\n");
-	drm_mode_debug_printmodeline(&mode);
+	struct sde_encoder_phys_vid *vid_enc =
+		to_sde_encoder_phys_vid(phys_enc);
+	struct drm_display_mode mode = phys_enc->cached_mode;
 
 	if (phys_enc->split_role != ENC_ROLE_SOLO ||
 	    (mode.private_flags & MSM_MODE_FLAG_COLOR_FORMAT_YCBCR420)) {
@@ -408,7 +389,35 @@ static void sde_encoder_phys_vid_setup_timing_engine(
 			phys_enc->vfp_cached = mode.vsync_start - mode.vdisplay;
 	}
 
-	drm_mode_to_intf_timing_params(vid_enc, &mode, &timing_params);
+	drm_mode_to_intf_timing_params(vid_enc, &mode, timing_params);
+}
+
+static void sde_encoder_phys_vid_setup_timing_engine(
+		struct sde_encoder_phys *phys_enc)
+{
+	struct sde_encoder_phys_vid *vid_enc;
+	struct intf_timing_params timing_params = { 0 };
+	const struct sde_format *fmt = NULL;
+	u32 fmt_fourcc = DRM_FORMAT_RGB888;
+	unsigned long lock_flags;
+	struct sde_hw_intf_cfg intf_cfg = { 0 };
+
+	if (!phys_enc || !phys_enc->sde_kms || !phys_enc->hw_ctl ||
+			!phys_enc->hw_ctl->ops.setup_intf_cfg) {
+		SDE_ERROR("invalid encoder %d\n", phys_enc != 0);
+		return;
+	}
+
+	vid_enc = to_sde_encoder_phys_vid(phys_enc);
+	if (!vid_enc->hw_intf->ops.setup_timing_gen) {
+		SDE_ERROR("timing engine setup is not supported\n");
+		return;
+	}
+
+	SDE_DEBUG_VIDENC(vid_enc, "enabling mode:\n");
+	drm_mode_debug_printmodeline(&phys_enc->cached_mode);
+
+	_sde_encoder_phys_vid_get_timing(phys_enc, &timing_params);
 
 	vid_enc->timing_params = timing_params;
 
@@ -603,6 +612,14 @@ static void sde_encoder_phys_vid_mode_set(
 		phys_enc->cached_mode = *adj_mode;
 		drm_mode_debug_printmodeline(adj_mode);
 		SDE_DEBUG_VIDENC(vid_enc, "caching mode:\n");
+
+		/*
+		 * enable is skipped for seamless vrr, the new vertical front
+		 * porch is programmed into the running timing engine instead
+		 */
+		if (phys_enc->enable_state == SDE_ENC_ENABLED &&
+				msm_is_mode_seamless_vrr(adj_mode))
+			vid_enc->vrr_pending = true;
 	}
 
 	instance = phys_enc->split_role == ENC_ROLE_SLAVE ? 1 : 0;
@@ -925,6 +942,43 @@ static int sde_encoder_phys_vid_wait_for_vblank(
 	return _sde_encoder_phys_vid_wait_for_vblank(phys_enc, true);
 }
 
+/*
+ * Only the vertical front porch differs between the modes of a seamless
+ * refresh rate change. The timing engine keeps running, the new values are
+ * latched by the interface flush of this kickoff at the next frame start.
+ */
+static void _sde_encoder_phys_vid_vrr_update(
+		struct sde_encoder_phys *phys_enc)
+{
+	struct sde_encoder_phys_vid *vid_enc =
+		to_sde_encoder_phys_vid(phys_enc);
+	struct sde_hw_ctl *ctl = phys_enc->hw_ctl;
+	struct intf_timing_params timing_params = { 0 };
+	const struct sde_format *fmt;
+	unsigned long lock_flags;
+	u32 flush_mask = 0;
+
+	if (!vid_enc->hw_intf->ops.setup_timing_gen)
+		return;
+
+	_sde_encoder_phys_vid_get_timing(phys_enc, &timing_params);
+	vid_enc->timing_params = timing_params;
+
+	fmt = sde_get_sde_format(DRM_FORMAT_RGB888);
+
+	spin_lock_irqsave(phys_enc->enc_spinlock, lock_flags);
+	vid_enc->hw_intf->ops.setup_timing_gen(vid_enc->hw_intf,
+			&timing_params, fmt);
+	spin_unlock_irqrestore(phys_enc->enc_spinlock, lock_flags);
+	programmable_fetch_config(phys_enc, &timing_params);
+
+	ctl->ops.get_bitmask_intf(ctl, &flush_mask, vid_enc->hw_intf->idx);
+	ctl->ops.update_pending_flush(ctl, flush_mask);
+
+	SDE_EVT32(DRMID(phys_enc->parent), vid_enc->hw_intf->idx - INTF_0,
+			timing_params.v_front_porch, flush_mask);
+}
+
 static int sde_encoder_phys_vid_prepare_for_kickoff(
 		struct sde_encoder_phys *phys_enc,
 		struct sde_encoder_kickoff_params *params)
@@ -940,6 +994,12 @@ static int sde_encoder_phys_vid_prepare_for_kickoff(
 	vid_enc = to_sde_encoder_phys_vid(phys_enc);
 
 	ctl = phys_enc->hw_ctl;
+
+	if (vid_enc->vrr_pending) {
+		_sde_encoder_phys_vid_vrr_update(phys_enc);
+		vid_enc->vrr_pending = false;
+	}
+
 	if (!ctl->ops.wait_reset_status)
 		return 0;
 
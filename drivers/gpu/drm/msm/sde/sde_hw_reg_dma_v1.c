@@ -98,6 +98,7 @@ static u32 v1_supported[REG_DMA_FEATURES_MAX]  = {
 	[GC] = GRP_DSPP_HW_BLK_SELECT,
 	[IGC] = DSPP_IGC | GRP_DSPP_HW_BLK_SELECT,
 	[PCC] = GRP_DSPP_HW_BLK_SELECT,
+	[QSEED] = GRP_VIG_HW_BLK_SELECT,
 };
 
 static u32 ctl_trigger_done_mask[CTL_MAX][DMA_CTL_QUEUE_MAX] = {
@@ -44,10 +44,14 @@
 #define SIXZONE_MEM_SIZE ((sizeof(struct drm_msm_sixzone)) + \
 		REG_DMA_HEADERS_BUFFER_SZ)
 
+#define QSEED3_LUT_MEM_SIZE (SDE_HW_SCALER3_LUT_MAX_SIZE + \
+		REG_DMA_HEADERS_BUFFER_SZ)
+
 #define REG_MASK(n) ((BIT(n)) - 1)
 #define REG_MASK_SHIFT(n, shift) ((REG_MASK(n)) << (shift))
 
 static struct sde_reg_dma_buffer *dspp_buf[REG_DMA_FEATURES_MAX][DSPP_MAX];
+static struct sde_reg_dma_buffer *sspp_buf[REG_DMA_FEATURES_MAX][SSPP_MAX];
 
 static u32 feature_map[SDE_DSPP_MAX] = {
 	[SDE_DSPP_VLUT] = REG_DMA_FEATURES_MAX,
@@ -80,6 +84,13 @@ static u32 dspp_mapping[DSPP_MAX] = {
 	[DSPP_3] = DSPP3,
 };
 
+static u32 sspp_mapping[SSPP_MAX] = {
+	[SSPP_VIG0] = VIG0,
+	[SSPP_VIG1] = VIG1,
+	[SSPP_VIG2] = VIG2,
+	[SSPP_VIG3] = VIG3,
+};
+
 #define REG_DMA_INIT_OPS(cfg, block, reg_dma_feature, feature_dma_buf) \
 	do { \
 		memset(&cfg, 0, sizeof(cfg)); \
@@ -310,7 +321,27 @@ int reg_dmav1_init_dspp_op_v4(int feature, enum sde_dspp idx)
 
 int reg_dmav1_init_sspp_op_v4(int feature, enum sde_sspp idx)
 {
-	return -ENOTSUPP;
+	int rc = -ENOTSUPP;
+	struct sde_hw_reg_dma_ops *dma_ops;
+	bool is_supported = false;
+
+	if (feature != SDE_SSPP_SCALER_QSEED3 || idx >= SSPP_MAX ||
+		!sspp_mapping[idx])
+		return rc;
+
+	dma_ops = sde_reg_dma_get_ops();
+	if (IS_ERR_OR_NULL(dma_ops))
+		return -ENOTSUPP;
+
+	rc = dma_ops->check_support(QSEED, sspp_mapping[idx], &is_supported);
+	if (!rc)
+		rc = (is_supported) ? 0 : -ENOTSUPP;
+
+	if (!rc)
+		rc = reg_dma_buf_init(&sspp_buf[QSEED][idx],
+				QSEED3_LUT_MEM_SIZE);
+
+	return rc;
 }
 
 void reg_dmav1_setup_dspp_vlutv18(struct sde_hw_dspp *ctx, void *cfg)
@@ -1202,3 +1233,98 @@ int reg_dmav1_deinit_dspp_ops(enum sde_dspp idx)
 	}
 	return 0;
 }
+
+static int reg_dma_vig_qseed3_lut(struct sde_hw_pipe *ctx,
+		struct sde_hw_scaler3_cfg *scaler3_cfg)
+{
+	struct sde_reg_dma_buffer *dma_buf = sspp_buf[QSEED][ctx->idx];
+	enum sde_reg_dma_blk blk = sspp_mapping[ctx->idx];
+	u32 scaler_off = ctx->cap->sblk->scaler_blk.base;
+	u32 lut_off, lut_len, swap = BIT(0);
+	unsigned long lut_flags;
+	const u32 *lut;
+	int i, rc;
+
+	rc = reg_dma_blk_select(QSEED, blk, dma_buf);
+	if (rc)
+		return rc;
+
+	for (i = 0; i < SDE_HW_SCALER3_LUT_REGIONS; i++) {
+		lut = sde_hw_scaler3_lut_region(scaler3_cfg, i,
+				&lut_off, &lut_len);
+		if (!lut)
+			continue;
+
+		rc = reg_dma_write(REG_BLK_WRITE_INC, scaler_off + lut_off,
+				lut_len * sizeof(u32), (u32 *)lut, dma_buf,
+				QSEED, blk);
+		if (rc)
+			return rc;
+	}
+
+	lut_flags = (unsigned long) scaler3_cfg->lut_flag;
+	if (test_bit(QSEED3_COEF_LUT_SWAP_BIT, &lut_flags)) {
+		rc = reg_dma_write(REG_SINGLE_WRITE,
+				scaler_off + QSEED3_COEF_LUT_CTRL,
+				sizeof(swap), &swap, dma_buf, QSEED, blk);
+		if (rc)
+			return rc;
+	}
+
+	return reg_dma_kick_off(REG_DMA_WRITE, DMA_CTL_QUEUE0,
+			WRITE_IMMEDIATE, dma_buf, ctx->ctl);
+}
+
+void reg_dmav1_setup_vig_qseed3(struct sde_hw_pipe *ctx,
+		struct sde_hw_pipe_cfg *sspp, struct sde_hw_pixel_ext *pe,
+		void *scaler_cfg)
+{
+	struct sde_hw_scaler3_cfg *scaler3_cfg = scaler_cfg;
+	struct sde_hw_scaler3_cfg cfg;
+
+	if (!ctx || !ctx->cap || !ctx->cap->sblk || !sspp || !scaler3_cfg ||
+		ctx->idx >= SSPP_MAX) {
+		DRM_ERROR("invalid param ctx %pK sspp %pK scaler_cfg %pK\n",
+			ctx, sspp, scaler3_cfg);
+		return;
+	}
+
+	/*
+	 * The coefficient luts make up most of the scaler programming, queue
+	 * them on the ctl reg dma so they are written with the rest of the
+	 * frame's reg dma payload. The remaining scaler registers are few and
+	 * still written directly.
+	 */
+	cfg = *scaler3_cfg;
+	if (cfg.lut_flag && ctx->ctl && sspp_buf[QSEED][ctx->idx] &&
+		!reg_dma_vig_qseed3_lut(ctx, &cfg))
+		cfg.lut_flag = 0;
+
+	sde_hw_setup_scaler3(&ctx->hw, &cfg,
+			ctx->cap->sblk->scaler_blk.base,
+			ctx->cap->sblk->scaler_blk.version,
+			sspp->layout.format);
+}
+
+int reg_dmav1_deinit_sspp_ops(enum sde_sspp idx)
+{
+	int i;
+	struct sde_hw_reg_dma_ops *dma_ops;
+
+	dma_ops = sde_reg_dma_get_ops();
+	if (IS_ERR_OR_NULL(dma_ops))
+		return -ENOTSUPP;
+
+	if (idx >= SSPP_MAX) {
+		DRM_ERROR("invalid sspp idx %x max %xd\n", idx, SSPP_MAX);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < REG_DMA_FEATURES_MAX; i++) {
+		if (!sspp_buf[i][idx])
+			continue;
+		dma_ops->dealloc_reg_dma(sspp_buf[i][idx]);
+		sspp_buf[i][idx] = NULL;
+	}
+	return 0;
+}
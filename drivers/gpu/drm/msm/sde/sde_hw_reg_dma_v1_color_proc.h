@@ -15,6 +15,7 @@
 #include "sde_hw_util.h"
 #include "sde_hw_catalog.h"
 #include "sde_hw_dspp.h"
+#include "sde_hw_sspp.h"
 
 /**
  * reg_dmav1_init_dspp_op_v4() - initialize the dspp feature op for sde v4
@@ -93,4 +94,22 @@ void reg_dmav1_setup_dspp_sixzonev18(struct sde_hw_dspp *ctx, void *cfg);
  * @idx: dspp idx
  */
 int reg_dmav1_deinit_dspp_ops(enum sde_dspp idx);
+
+/**
+ * reg_dmav1_setup_vig_qseed3() - qseed3 scaler impl using reg dma v1.
+ * @ctx: sspp ctx info
+ * @sspp: pointer to struct sde_hw_pipe_cfg
+ * @pe: pointer to struct sde_hw_pixel_ext
+ * @scaler_cfg: pointer to struct sde_hw_scaler3_cfg
+ */
+void reg_dmav1_setup_vig_qseed3(struct sde_hw_pipe *ctx,
+		struct sde_hw_pipe_cfg *sspp, struct sde_hw_pixel_ext *pe,
+		void *scaler_cfg);
+
+/**
+ * reg_dmav1_deinit_sspp_ops() - deinitialize the sspp feature op for sde v4
+ *                               which were initialized.
+ * @idx: sspp idx
+ */
+int reg_dmav1_deinit_sspp_ops(enum sde_sspp idx);
 #endif /* _SDE_HW_REG_DMA_V1_COLOR_PROC_H */
@@ -954,7 +954,10 @@ static void _setup_layer_ops(struct sde_hw_pipe *c,
 		c->ops.setup_multirect = sde_hw_sspp_setup_multirect;
 
 	if (test_bit(SDE_SSPP_SCALER_QSEED3, &features)) {
-		c->ops.setup_scaler = _sde_hw_sspp_setup_scaler3;
+		if (!reg_dmav1_init_sspp_op_v4(SDE_SSPP_SCALER_QSEED3, c->idx))
+			c->ops.setup_scaler = reg_dmav1_setup_vig_qseed3;
+		else
+			c->ops.setup_scaler = _sde_hw_sspp_setup_scaler3;
 		c->ops.get_scaler_ver = _sde_hw_sspp_get_scaler3_ver;
 	}
 
@@ -1071,8 +1074,10 @@ struct sde_hw_pipe *sde_hw_sspp_init(enum sde_sspp idx,
 
 void sde_hw_sspp_destroy(struct sde_hw_pipe *ctx)
 {
-	if (ctx)
+	if (ctx) {
+		reg_dmav1_deinit_sspp_ops(ctx->idx);
 		sde_hw_blk_destroy(&ctx->base);
+	}
 	kfree(ctx);
 }
 
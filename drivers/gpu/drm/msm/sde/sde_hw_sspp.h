@@ -21,6 +21,7 @@
 #include "sde_color_processing.h"
 
 struct sde_hw_pipe;
+struct sde_hw_ctl;
 
 /**
  * Flags
@@ -537,6 +538,8 @@ struct sde_hw_sspp_ops {
  * @idx: pipe index
  * @cap: pointer to layer_cfg
  * @ops: pointer to operations possible for this pipe
+ * @ctl: ctl path the pipe is staged on for the current commit, used to
+ *       queue scaler programming through reg dma
  */
 struct sde_hw_pipe {
 	struct sde_hw_blk base;
@@ -550,6 +553,8 @@ struct sde_hw_pipe {
 
 	/* Ops */
 	struct sde_hw_sspp_ops ops;
+
+	struct sde_hw_ctl *ctl;
 };
 
 /**
@@ -40,8 +40,6 @@ static u32 sde_hw_util_log_mask = SDE_DBG_MASK_NONE;
 #define QSEED3_SRC_SIZE_Y_RGB_A            0x40
 #define QSEED3_SRC_SIZE_UV                 0x44
 #define QSEED3_DST_SIZE                    0x48
-#define QSEED3_COEF_LUT_CTRL               0x4C
-#define QSEED3_COEF_LUT_SWAP_BIT           0
 #define QSEED3_COEF_LUT_DIR_BIT            1
 #define QSEED3_COEF_LUT_Y_CIR_BIT          2
 #define QSEED3_COEF_LUT_UV_CIR_BIT         3
@@ -142,76 +140,108 @@ void sde_set_scaler_v2(struct sde_hw_scaler3_cfg *cfg,
 	}
 }
 
+static const uint32_t qseed3_lut_tbl[QSEED3_FILTERS][QSEED3_LUT_REGIONS][2] = {
+	{{18, 0x000}, {12, 0x120}, {12, 0x1E0}, {8, 0x2A0} },
+	{{6, 0x320}, {3, 0x3E0}, {3, 0x440}, {3, 0x4A0} },
+	{{6, 0x500}, {3, 0x5c0}, {3, 0x620}, {3, 0x680} },
+	{{6, 0x380}, {3, 0x410}, {3, 0x470}, {3, 0x4d0} },
+	{{6, 0x560}, {3, 0x5f0}, {3, 0x650}, {3, 0x6b0} },
+};
+
+static u32 *_sde_hw_scaler3_get_lut(struct sde_hw_scaler3_cfg *scaler3_cfg,
+		int filter)
+{
+	unsigned long lut_flags = (unsigned long) scaler3_cfg->lut_flag;
+
+	switch (filter) {
+	case 0:
+		if (test_bit(QSEED3_COEF_LUT_DIR_BIT, &lut_flags) &&
+			(scaler3_cfg->dir_len == QSEED3_DIR_LUT_SIZE))
+			return scaler3_cfg->dir_lut;
+		break;
+	case 1:
+		if (test_bit(QSEED3_COEF_LUT_Y_CIR_BIT, &lut_flags) &&
+			(scaler3_cfg->y_rgb_cir_lut_idx < QSEED3_CIRCULAR_LUTS) &&
+			(scaler3_cfg->cir_len == QSEED3_CIR_LUT_SIZE))
+			return scaler3_cfg->cir_lut +
+				scaler3_cfg->y_rgb_cir_lut_idx * QSEED3_LUT_SIZE;
+		break;
+	case 2:
+		if (test_bit(QSEED3_COEF_LUT_UV_CIR_BIT, &lut_flags) &&
+			(scaler3_cfg->uv_cir_lut_idx < QSEED3_CIRCULAR_LUTS) &&
+			(scaler3_cfg->cir_len == QSEED3_CIR_LUT_SIZE))
+			return scaler3_cfg->cir_lut +
+				scaler3_cfg->uv_cir_lut_idx * QSEED3_LUT_SIZE;
+		break;
+	case 3:
+		if (test_bit(QSEED3_COEF_LUT_Y_SEP_BIT, &lut_flags) &&
+			(scaler3_cfg->y_rgb_sep_lut_idx <
+				QSEED3_SEPARABLE_LUTS) &&
+			(scaler3_cfg->sep_len == QSEED3_SEP_LUT_SIZE))
+			return scaler3_cfg->sep_lut +
+				scaler3_cfg->y_rgb_sep_lut_idx * QSEED3_LUT_SIZE;
+		break;
+	case 4:
+		if (test_bit(QSEED3_COEF_LUT_UV_SEP_BIT, &lut_flags) &&
+			(scaler3_cfg->uv_sep_lut_idx < QSEED3_SEPARABLE_LUTS) &&
+			(scaler3_cfg->sep_len == QSEED3_SEP_LUT_SIZE))
+			return scaler3_cfg->sep_lut +
+				scaler3_cfg->uv_sep_lut_idx * QSEED3_LUT_SIZE;
+		break;
+	}
+
+	return NULL;
+}
+
+const u32 *sde_hw_scaler3_lut_region(struct sde_hw_scaler3_cfg *scaler3_cfg,
+		int region, u32 *off, u32 *len)
+{
+	int i, filter, lut_region;
+	u32 lut_offset = 0;
+	u32 *lut;
+
+	if (!scaler3_cfg || !off || !len ||
+		region < 0 || region >= SDE_HW_SCALER3_LUT_REGIONS)
+		return NULL;
+
+	filter = region / QSEED3_LUT_REGIONS;
+	lut_region = region % QSEED3_LUT_REGIONS;
+
+	lut = _sde_hw_scaler3_get_lut(scaler3_cfg, filter);
+	if (!lut)
+		return NULL;
+
+	for (i = 0; i < lut_region; i++)
+		lut_offset += qseed3_lut_tbl[filter][i][0] << 2;
+
+	*off = QSEED3_COEF_LUT + qseed3_lut_tbl[filter][lut_region][1];
+	*len = qseed3_lut_tbl[filter][lut_region][0] << 2;
+
+	return lut + lut_offset;
+}
+
 static void _sde_hw_setup_scaler3_lut(struct sde_hw_blk_reg_map *c,
 		struct sde_hw_scaler3_cfg *scaler3_cfg, u32 offset)
 {
-	int i, j, filter;
-	int config_lut = 0x0;
+	int i, j;
 	unsigned long lut_flags;
-	u32 lut_addr, lut_offset, lut_len;
-	u32 *lut[QSEED3_FILTERS] = {NULL, NULL, NULL, NULL, NULL};
-	static const uint32_t off_tbl[QSEED3_FILTERS][QSEED3_LUT_REGIONS][2] = {
-		{{18, 0x000}, {12, 0x120}, {12, 0x1E0}, {8, 0x2A0} },
-		{{6, 0x320}, {3, 0x3E0}, {3, 0x440}, {3, 0x4A0} },
-		{{6, 0x500}, {3, 0x5c0}, {3, 0x620}, {3, 0x680} },
-		{{6, 0x380}, {3, 0x410}, {3, 0x470}, {3, 0x4d0} },
-		{{6, 0x560}, {3, 0x5f0}, {3, 0x650}, {3, 0x6b0} },
-	};
-
-	lut_flags = (unsigned long) scaler3_cfg->lut_flag;
-	if (test_bit(QSEED3_COEF_LUT_DIR_BIT, &lut_flags) &&
-		(scaler3_cfg->dir_len == QSEED3_DIR_LUT_SIZE)) {
-		lut[0] = scaler3_cfg->dir_lut;
-		config_lut = 1;
-	}
-	if (test_bit(QSEED3_COEF_LUT_Y_CIR_BIT, &lut_flags) &&
-		(scaler3_cfg->y_rgb_cir_lut_idx < QSEED3_CIRCULAR_LUTS) &&
-		(scaler3_cfg->cir_len == QSEED3_CIR_LUT_SIZE)) {
-		lut[1] = scaler3_cfg->cir_lut +
-			scaler3_cfg->y_rgb_cir_lut_idx * QSEED3_LUT_SIZE;
-		config_lut = 1;
-	}
-	if (test_bit(QSEED3_COEF_LUT_UV_CIR_BIT, &lut_flags) &&
-		(scaler3_cfg->uv_cir_lut_idx < QSEED3_CIRCULAR_LUTS) &&
-		(scaler3_cfg->cir_len == QSEED3_CIR_LUT_SIZE)) {
-		lut[2] = scaler3_cfg->cir_lut +
-			scaler3_cfg->uv_cir_lut_idx * QSEED3_LUT_SIZE;
-		config_lut = 1;
-	}
-	if (test_bit(QSEED3_COEF_LUT_Y_SEP_BIT, &lut_flags) &&
-		(scaler3_cfg->y_rgb_sep_lut_idx < QSEED3_SEPARABLE_LUTS) &&
-		(scaler3_cfg->sep_len == QSEED3_SEP_LUT_SIZE)) {
-		lut[3] = scaler3_cfg->sep_lut +
-			scaler3_cfg->y_rgb_sep_lut_idx * QSEED3_LUT_SIZE;
-		config_lut = 1;
-	}
-	if (test_bit(QSEED3_COEF_LUT_UV_SEP_BIT, &lut_flags) &&
-		(scaler3_cfg->uv_sep_lut_idx < QSEED3_SEPARABLE_LUTS) &&
-		(scaler3_cfg->sep_len == QSEED3_SEP_LUT_SIZE)) {
-		lut[4] = scaler3_cfg->sep_lut +
-			scaler3_cfg->uv_sep_lut_idx * QSEED3_LUT_SIZE;
-		config_lut = 1;
-	}
-
-	if (config_lut) {
-		for (filter = 0; filter < QSEED3_FILTERS; filter++) {
-			if (!lut[filter])
-				continue;
-			lut_offset = 0;
-			for (i = 0; i < QSEED3_LUT_REGIONS; i++) {
-				lut_addr = QSEED3_COEF_LUT + offset
-					+ off_tbl[filter][i][1];
-				lut_len = off_tbl[filter][i][0] << 2;
-				for (j = 0; j < lut_len; j++) {
-					SDE_REG_WRITE(c,
-						lut_addr,
-						(lut[filter])[lut_offset++]);
-					lut_addr += 4;
-				}
-			}
+	u32 lut_addr, lut_len;
+	const u32 *lut;
+
+	for (i = 0; i < SDE_HW_SCALER3_LUT_REGIONS; i++) {
+		lut = sde_hw_scaler3_lut_region(scaler3_cfg, i,
+				&lut_addr, &lut_len);
+		if (!lut)
+			continue;
+
+		lut_addr += offset;
+		for (j = 0; j < lut_len; j++) {
+			SDE_REG_WRITE(c, lut_addr, lut[j]);
+			lut_addr += 4;
 		}
 	}
 
+	lut_flags = (unsigned long) scaler3_cfg->lut_flag;
 	if (test_bit(QSEED3_COEF_LUT_SWAP_BIT, &lut_flags))
 		SDE_REG_WRITE(c, QSEED3_COEF_LUT_CTRL + offset, BIT(0));
 
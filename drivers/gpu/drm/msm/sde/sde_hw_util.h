@@ -158,6 +158,14 @@ struct sde_hw_scaler3_lut_cfg {
 	size_t sep_len;
 };
 
+/* QSEEDv3 coefficient lut control */
+#define QSEED3_COEF_LUT_CTRL               0x4C
+#define QSEED3_COEF_LUT_SWAP_BIT           0
+
+/* QSEEDv3 coefficient luts, 4 regions for each of the 5 filters */
+#define SDE_HW_SCALER3_LUT_REGIONS	20
+#define SDE_HW_SCALER3_LUT_MAX_SIZE	((200 + 4 * 60) * sizeof(u32))
+
 u32 *sde_hw_util_get_log_mask_ptr(void);
 
 void sde_reg_write(struct sde_hw_blk_reg_map *c,
@@ -188,6 +196,9 @@ void sde_hw_setup_scaler3(struct sde_hw_blk_reg_map *c,
 u32 sde_hw_get_scaler3_ver(struct sde_hw_blk_reg_map *c,
 		u32 scaler_offset);
 
+const u32 *sde_hw_scaler3_lut_region(struct sde_hw_scaler3_cfg *scaler3_cfg,
+		int region, u32 *off, u32 *len);
+
 void sde_hw_csc_setup(struct sde_hw_blk_reg_map  *c,
 		u32 csc_reg_off,
 		struct sde_csc_cfg *data, bool csc10);
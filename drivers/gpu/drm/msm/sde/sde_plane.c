@@ -97,6 +97,7 @@ enum sde_plane_qos {
  * @catalog: Points to sde catalog structure
  * @sbuf_mode: force stream buffer mode if set
  * @sbuf_writeback: force stream buffer writeback if set
+ * @rot_auto_dnsc: let the inline rotator downscale video layers if set
  * @revalidate: force revalidation of all the plane properties
  * @xin_halt_forced_clk: whether or not clocks were forced on for xin halt
  * @blob_rot_caps: Pointer to rotator capability blob
@@ -123,6 +124,7 @@ struct sde_plane {
 	struct sde_mdss_cfg *catalog;
 	u32 sbuf_mode;
 	u32 sbuf_writeback;
+	u32 rot_auto_dnsc;
 	bool revalidate;
 	bool xin_halt_forced_clk;
 
@@ -1616,6 +1618,75 @@ u32 sde_plane_rot_get_prefill(struct drm_plane *plane)
 	return blocksize + sde_kms->catalog->sbuf_headroom;
 }
 
+/* largest downscale the rotator supports for all inline output formats */
+#define SDE_PLANE_ROT_MAX_DNSC		4
+#define SDE_PLANE_ROT_MAX_DNSC_DX	2
+
+static u32 _sde_plane_rot_dnsc_factor(u32 src, u32 dst, u32 max)
+{
+	u32 factor = 1;
+
+	while (factor < max && !(src % (factor << 1)) &&
+			src / (factor << 1) >= dst)
+		factor <<= 1;
+
+	return factor;
+}
+
+/**
+ * _sde_plane_rot_auto_dnsc - offload the downscale of a video layer to the
+ *	inline rotator
+ * @psde: Pointer to sde plane
+ * @state: Pointer to drm plane state
+ *
+ * When user space doesn't choose a rotator destination, a video layer that
+ * is shrunk on the display is downscaled in the rotator by the largest power
+ * of two that keeps the rotator output at least as large as the layer on
+ * screen. The pipe then fetches less from the stream buffer and only has to
+ * apply the remaining fraction, which keeps such layers within the inline
+ * downscale limit of video mode instead of falling back to a GPU pass.
+ */
+static void _sde_plane_rot_auto_dnsc(struct sde_plane *psde,
+		struct drm_plane_state *state)
+{
+	struct sde_plane_rot_state *rstate = &to_sde_plane_state(state)->rot;
+	const struct sde_format *fmt;
+	struct drm_rect *out_rot = &rstate->out_rot_rect;
+	u32 w, h, max;
+
+	/* planes sharing the rotator need a common output, leave them be */
+	if (!rstate->auto_dnsc || rstate->nplane != 1)
+		return;
+
+	fmt = to_sde_format(msm_framebuffer_format(state->fb));
+	if (!SDE_FORMAT_IS_YUV(fmt))
+		return;
+
+	if ((drm_rect_width(out_rot) | drm_rect_height(out_rot)) & 0xFFFF)
+		return;
+
+	w = drm_rect_width(out_rot) >> 16;
+	h = drm_rect_height(out_rot) >> 16;
+	max = SDE_FORMAT_IS_DX(fmt) ? SDE_PLANE_ROT_MAX_DNSC_DX :
+			SDE_PLANE_ROT_MAX_DNSC;
+
+	rstate->dnsc_factor_w = _sde_plane_rot_dnsc_factor(w, state->crtc_w,
+			max);
+	rstate->dnsc_factor_h = _sde_plane_rot_dnsc_factor(h, state->crtc_h,
+			max);
+	if (rstate->dnsc_factor_w == 1 && rstate->dnsc_factor_h == 1)
+		return;
+
+	out_rot->x2 = out_rot->x1 + ((w / rstate->dnsc_factor_w) << 16);
+	out_rot->y2 = out_rot->y1 + ((h / rstate->dnsc_factor_h) << 16);
+	rstate->out_src_rect = *out_rot;
+
+	SDE_DEBUG_PLANE(psde, "rot dnsc %ux%u, %ux%u -> %ux%u\n",
+			rstate->dnsc_factor_w, rstate->dnsc_factor_h, w, h,
+			drm_rect_width(out_rot) >> 16,
+			drm_rect_height(out_rot) >> 16);
+}
+
 /**
  * sde_plane_rot_calc_cfg - calculate rotator/sspp configuration by
  *	enumerating over all planes attached to the same rotator
@@ -1632,6 +1703,7 @@ static int sde_plane_rot_calc_cfg(struct drm_plane *plane,
 	struct drm_rect *in_rot, *out_rot;
 	struct drm_plane *attached_plane;
 	u32 dst_x, dst_y, dst_w, dst_h;
+	bool auto_dst;
 	int found = 0;
 	int xpos = 0;
 	int ret;
@@ -1663,7 +1735,8 @@ static int sde_plane_rot_calc_cfg(struct drm_plane *plane,
 	dst_w = sde_plane_get_property(pstate, PLANE_PROP_ROT_DST_W);
 	dst_h = sde_plane_get_property(pstate, PLANE_PROP_ROT_DST_H);
 
-	if (!dst_w && !dst_h) {
+	auto_dst = !dst_w && !dst_h;
+	if (auto_dst) {
 		rstate->out_rot_rect = rstate->in_rot_rect;
 		drm_rect_rotate(&rstate->out_rot_rect, state->fb->width << 16,
 				state->fb->height << 16, rstate->in_rotation);
@@ -1675,6 +1748,8 @@ static int sde_plane_rot_calc_cfg(struct drm_plane *plane,
 	}
 
 	rstate->out_src_rect = rstate->out_rot_rect;
+	rstate->dnsc_factor_w = 1;
+	rstate->dnsc_factor_h = 1;
 
 	/* enumerating over all planes attached to the same rotator */
 	drm_atomic_crtc_state_for_each_plane(attached_plane, cstate) {
@@ -1846,6 +1921,9 @@ static int sde_plane_rot_calc_cfg(struct drm_plane *plane,
 	rstate->out_xpos = xpos;
 	rstate->nplane = found;
 
+	if (auto_dst)
+		_sde_plane_rot_auto_dnsc(to_sde_plane(plane), state);
+
 	SDE_DEBUG("plane%d.%u xpos:%d/%d rot:%dx%d+%d+%d/%dx%d+%d+%d\n",
 			plane->base.id, rstate->sequence_id,
 			rstate->out_xpos, rstate->nplane,
@@ -2323,6 +2401,7 @@ static int sde_plane_rot_atomic_check(struct drm_plane *plane,
 	rstate->hflip = rstate->in_rotation & DRM_MODE_REFLECT_X ? true : false;
 	rstate->vflip = rstate->in_rotation & DRM_MODE_REFLECT_Y ? true : false;
 	rstate->out_sbuf = psde->sbuf_mode || rstate->rot90;
+	rstate->auto_dnsc = !!psde->rot_auto_dnsc;
 
 	if (sde_plane_enabled(state) && rstate->out_sbuf) {
 		SDE_DEBUG("plane%d.%d acquire rotator, fb %d\n",
@@ -2370,6 +2449,21 @@ static int sde_plane_rot_atomic_check(struct drm_plane *plane,
 
 		ret = sde_plane_rot_submit_command(plane, state,
 				SDE_HW_ROT_CMD_VALIDATE);
+		if (ret && (rstate->dnsc_factor_w > 1 ||
+				rstate->dnsc_factor_h > 1)) {
+			/* rotator refused the downscale, let the pipe do it */
+			SDE_DEBUG("plane%d.%d rot dnsc rejected %d\n",
+					plane->base.id, rstate->sequence_id,
+					ret);
+			rstate->auto_dnsc = false;
+
+			ret = sde_plane_rot_calc_cfg(plane, state);
+			if (ret)
+				return ret;
+
+			ret = sde_plane_rot_submit_command(plane, state,
+					SDE_HW_ROT_CMD_VALIDATE);
+		}
 		if (ret)
 			return ret;
 
@@ -3751,9 +3845,11 @@ static int sde_plane_sspp_atomic_update(struct drm_plane *plane,
 	struct sde_plane_rot_state *rstate;
 	const struct sde_format *fmt;
 	struct drm_crtc *crtc;
+	struct sde_crtc *sde_crtc;
 	struct drm_framebuffer *fb;
 	struct sde_rect src, dst;
 	bool q16_data = true;
+	bool props_dirty = false;
 	int idx;
 
 	if (!plane) {
@@ -3808,6 +3904,7 @@ static int sde_plane_sspp_atomic_update(struct drm_plane *plane,
 	/* determine what needs to be refreshed */
 	while ((idx = msm_property_pop_dirty(&psde->property_info,
 					&pstate->property_state)) >= 0) {
+		props_dirty = true;
 		switch (idx) {
 		case PLANE_PROP_SCALER_V1:
 		case PLANE_PROP_SCALER_V2:
@@ -3878,6 +3975,10 @@ static int sde_plane_sspp_atomic_update(struct drm_plane *plane,
 	if (pstate->dirty & SDE_PLANE_DIRTY_RECTS)
 		memset(&(psde->pipe_cfg), 0, sizeof(struct sde_hw_pipe_cfg));
 
+	/* new buffer, fence or any property change updates the output */
+	if (props_dirty || pstate->dirty || state->fb != old_state->fb)
+		sde_crtc_mark_frame_dirty(crtc);
+
 	_sde_plane_set_scanout(plane, pstate, &psde->pipe_cfg, fb);
 
 	/* early out if nothing dirty */
@@ -3959,6 +4060,11 @@ static int sde_plane_sspp_atomic_update(struct drm_plane *plane,
 			psde->pipe_hw->ops.setup_pe(psde->pipe_hw,
 					&pstate->pixel_ext);
 
+		/* scaler luts may be queued on the ctl reg dma of this crtc */
+		sde_crtc = to_sde_crtc(crtc);
+		psde->pipe_hw->ctl = sde_crtc->num_mixers ?
+				sde_crtc->mixers[0].hw_ctl : NULL;
+
 		/**
 		 * when programmed in multirect mode, scalar block will be
 		 * bypassed. Still we need to update alpha and bitwidth
@@ -5079,6 +5185,10 @@ static int _sde_plane_init_debugfs(struct drm_plane *plane)
 			0600,
 			psde->debugfs_root,
 			&psde->sbuf_writeback);
+	debugfs_create_u32("rot_auto_dnsc",
+			0600,
+			psde->debugfs_root,
+			&psde->rot_auto_dnsc);
 
 	return 0;
 }
@@ -5191,6 +5301,7 @@ struct drm_plane *sde_plane_init(struct drm_device *dev,
 	plane = &psde->base;
 	psde->pipe = pipe;
 	psde->is_virtual = (master_plane_id != 0);
+	psde->rot_auto_dnsc = 1;
 	INIT_LIST_HEAD(&psde->mplane_list);
 	master_plane = drm_plane_find(dev, master_plane_id);
 	if (master_plane) {
@@ -56,6 +56,9 @@
  * @out_fb: Pointer to output drm framebuffer of rotator stage
  * @out_fbo: framebuffer object of output streaming buffer
  * @out_xpos: relative horizontal position of the plane (0 - leftmost)
+ * @auto_dnsc: true if the rotator may downscale without a user destination
+ * @dnsc_factor_w: downscale factor applied by the rotator to the width
+ * @dnsc_factor_h: downscale factor applied by the rotator to the height
  */
 struct sde_plane_rot_state {
 	u32 sequence_id;
@@ -87,6 +90,9 @@ struct sde_plane_rot_state {
 	struct drm_framebuffer *out_fb;
 	struct sde_kms_fbo *out_fbo;
 	int out_xpos;
+	bool auto_dnsc;
+	u32 dnsc_factor_w;
+	u32 dnsc_factor_h;
 };
 
 /* dirty bits for update function */
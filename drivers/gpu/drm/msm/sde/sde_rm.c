@@ -764,6 +764,54 @@ static bool _sde_rm_check_lm_and_get_connected_blks(
 	return true;
 }
 
+/**
+ * _sde_rm_lm_cost - cost of reserving a set of layer mixers
+ * @rm: SDE Resource Manager handle
+ * @rsvp: reservation currently being created
+ * @lm: proposed layer mixers
+ * @lm_count: number of proposed layer mixers
+ * @Return: number of free mixers that would lose a pairing peer
+ *
+ * Reserving a mixer that can be paired leaves its peers without a partner
+ * for dual mixer topologies of other displays, which then have to fall
+ * back to fewer mixers or fail. Prefer the set that strands the fewest
+ * peers; candidates already meet the dspp, ds and pp requirements.
+ */
+static int _sde_rm_lm_cost(
+		struct sde_rm *rm,
+		struct sde_rm_rsvp *rsvp,
+		struct sde_rm_hw_blk **lm,
+		int lm_count)
+{
+	struct sde_rm_hw_iter iter;
+	int i, cost = 0;
+
+	sde_rm_init_hw_iter(&iter, 0, SDE_HW_BLK_LM);
+	while (_sde_rm_get_hw_locked(rm, &iter)) {
+		const struct sde_lm_cfg *lm_cfg;
+		bool in_set = false;
+
+		if (RESERVED_BY_OTHER(iter.blk, rsvp))
+			continue;
+
+		for (i = 0; i < lm_count; i++)
+			if (lm[i] == iter.blk)
+				in_set = true;
+		if (in_set)
+			continue;
+
+		for (i = 0; i < lm_count; i++) {
+			lm_cfg = to_sde_hw_mixer(lm[i]->hw)->cap;
+			if (test_bit(iter.blk->id, &lm_cfg->lm_pair_mask)) {
+				cost++;
+				break;
+			}
+		}
+	}
+
+	return cost;
+}
+
 static int _sde_rm_reserve_lms(
 		struct sde_rm *rm,
 		struct sde_rm_rsvp *rsvp,
@@ -771,12 +819,12 @@ static int _sde_rm_reserve_lms(
 		u8 *_lm_ids)
 
 {
-	struct sde_rm_hw_blk *lm[MAX_BLOCKS];
-	struct sde_rm_hw_blk *dspp[MAX_BLOCKS];
-	struct sde_rm_hw_blk *ds[MAX_BLOCKS];
-	struct sde_rm_hw_blk *pp[MAX_BLOCKS];
+	struct sde_rm_hw_blk *lm[MAX_BLOCKS], *best_lm[MAX_BLOCKS];
+	struct sde_rm_hw_blk *dspp[MAX_BLOCKS], *best_dspp[MAX_BLOCKS];
+	struct sde_rm_hw_blk *ds[MAX_BLOCKS], *best_ds[MAX_BLOCKS];
+	struct sde_rm_hw_blk *pp[MAX_BLOCKS], *best_pp[MAX_BLOCKS];
 	struct sde_rm_hw_iter iter_i, iter_j;
-	int lm_count = 0;
+	int lm_count = 0, cost, best_cost = INT_MAX;
 	int i, rc = 0;
 
 	if (!reqs->topology->num_lm) {
@@ -784,10 +832,14 @@ static int _sde_rm_reserve_lms(
 		return -EINVAL;
 	}
 
-	/* Find a primary mixer */
+	memset(&best_lm, 0, sizeof(best_lm));
+	memset(&best_dspp, 0, sizeof(best_dspp));
+	memset(&best_ds, 0, sizeof(best_ds));
+	memset(&best_pp, 0, sizeof(best_pp));
+
+	/* Find a primary mixer, evaluating every valid set of mixers */
 	sde_rm_init_hw_iter(&iter_i, 0, SDE_HW_BLK_LM);
-	while (lm_count != reqs->topology->num_lm &&
-			_sde_rm_get_hw_locked(rm, &iter_i)) {
+	while (best_cost && _sde_rm_get_hw_locked(rm, &iter_i)) {
 		memset(&lm, 0, sizeof(lm));
 		memset(&dspp, 0, sizeof(dspp));
 		memset(&ds, 0, sizeof(ds));
@@ -837,8 +889,29 @@ static int _sde_rm_reserve_lms(
 
 			++lm_count;
 		}
+
+		if (lm_count != reqs->topology->num_lm)
+			continue;
+
+		cost = _sde_rm_lm_cost(rm, rsvp, lm, lm_count);
+		SDE_DEBUG("lm %d set cost %d best %d\n", iter_i.blk->id, cost,
+				best_cost);
+		if (cost >= best_cost)
+			continue;
+
+		best_cost = cost;
+		memcpy(best_lm, lm, sizeof(lm));
+		memcpy(best_dspp, dspp, sizeof(dspp));
+		memcpy(best_ds, ds, sizeof(ds));
+		memcpy(best_pp, pp, sizeof(pp));
 	}
 
+	memcpy(lm, best_lm, sizeof(lm));
+	memcpy(dspp, best_dspp, sizeof(dspp));
+	memcpy(ds, best_ds, sizeof(ds));
+	memcpy(pp, best_pp, sizeof(pp));
+	lm_count = (best_cost == INT_MAX) ? 0 : reqs->topology->num_lm;
+
 	if (lm_count != reqs->topology->num_lm) {
 		SDE_DEBUG("unable to find appropriate mixers\n");
 		return -ENAVAIL;
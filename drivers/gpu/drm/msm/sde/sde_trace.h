@@ -144,6 +144,33 @@ TRACE_EVENT(sde_encoder_underrun,
 		__entry->underrun_cnt)
 );
 
+TRACE_EVENT(sde_crtc_frame_latency,
+	TP_PROTO(u32 crtc_id, s64 commit_kickoff, s64 kickoff_vsync,
+		s64 vsync_retire, s64 commit_retire, u32 missed_vsyncs),
+	TP_ARGS(crtc_id, commit_kickoff, kickoff_vsync, vsync_retire,
+		commit_retire, missed_vsyncs),
+	TP_STRUCT__entry(
+			__field(u32, crtc_id)
+			__field(s64, commit_kickoff)
+			__field(s64, kickoff_vsync)
+			__field(s64, vsync_retire)
+			__field(s64, commit_retire)
+			__field(u32, missed_vsyncs)
+	),
+	TP_fast_assign(
+			__entry->crtc_id = crtc_id;
+			__entry->commit_kickoff = commit_kickoff;
+			__entry->kickoff_vsync = kickoff_vsync;
+			__entry->vsync_retire = vsync_retire;
+			__entry->commit_retire = commit_retire;
+			__entry->missed_vsyncs = missed_vsyncs;
+	),
+	TP_printk("crtc:%d commit_kickoff:%lld kickoff_vsync:%lld vsync_retire:%lld commit_retire:%lld missed_vsyncs:%d",
+		__entry->crtc_id, __entry->commit_kickoff,
+		__entry->kickoff_vsync, __entry->vsync_retire,
+		__entry->commit_retire, __entry->missed_vsyncs)
+);
+
 TRACE_EVENT(tracing_mark_write,
 	TP_PROTO(int pid, const char *name, bool trace_begin),
 	TP_ARGS(pid, name, trace_begin),
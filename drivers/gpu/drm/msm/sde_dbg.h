@@ -16,6 +16,7 @@
 #include <stdarg.h>
 #include <linux/debugfs.h>
 #include <linux/list.h>
+#include <asm/local.h>
 
 /* select an uncommon hex value for the limiter */
 #define SDE_EVTLOG_DATA_LIMITER	(0xC0DEBEEF)
@@ -63,11 +64,11 @@ enum sde_dbg_dump_flag {
 #define SDE_EVTLOG_PRINT_ENTRY	256
 
 /*
- * evtlog keeps this number of entries in memory for debug purpose. This
- * number must be greater than print entry to prevent out of bound evtlog
- * entry array access.
+ * evtlog keeps this number of entries per cpu in memory for debug purpose.
+ * This number must be greater than print entry so a dump can be served
+ * from a single busy cpu.
  */
-#define SDE_EVTLOG_ENTRY	(SDE_EVTLOG_PRINT_ENTRY * 8)
+#define SDE_EVTLOG_CPU_ENTRY	(SDE_EVTLOG_PRINT_ENTRY * 2)
 #define SDE_EVTLOG_MAX_DATA 15
 #define SDE_EVTLOG_BUF_MAX 512
 #define SDE_EVTLOG_BUF_ALIGN 32
@@ -85,19 +86,32 @@ struct sde_dbg_evtlog_log {
 	u32 data[SDE_EVTLOG_MAX_DATA];
 	u32 data_cnt;
 	int pid;
+	u32 seq;
 };
 
 /**
- * @last_dump: Index of last entry to be output during evtlog dumps
- * @filter_list: Linked list of currently active filter strings
+ * struct sde_dbg_evtlog_cpu - ring of evtlog entries logged on one cpu
+ * @logs: entry ring, indexed by entry number modulo SDE_EVTLOG_CPU_ENTRY
+ * @curr: number of entries reserved on this cpu so far
+ * @next: number of the next entry to be output during evtlog dumps
+ * @last_dump: number of the entry after the last one to be output
  */
-struct sde_dbg_evtlog {
-	struct sde_dbg_evtlog_log logs[SDE_EVTLOG_ENTRY];
-	u32 first;
-	u32 last;
-	u32 last_dump;
-	u32 curr;
+struct sde_dbg_evtlog_cpu {
+	struct sde_dbg_evtlog_log logs[SDE_EVTLOG_CPU_ENTRY];
+	local_t curr;
 	u32 next;
+	u32 last_dump;
+};
+
+/**
+ * @cpus: per cpu entry rings, merged by timestamp during evtlog dumps
+ * @prev_time: timestamp of the entry output last during evtlog dumps
+ * @spin_lock: serializes evtlog dumps and filter updates, not logging
+ * @filter_list: RCU list of currently active filter strings
+ */
+struct sde_dbg_evtlog {
+	struct sde_dbg_evtlog_cpu *cpus;
+	s64 prev_time;
 	u32 enable;
 	spinlock_t spin_lock;
 	struct list_head filter_list;
@@ -19,6 +19,8 @@
 #include <linux/uaccess.h>
 #include <linux/dma-buf.h>
 #include <linux/slab.h>
+#include <linux/rculist.h>
+#include <linux/vmalloc.h>
 
 #include "sde_dbg.h"
 #include "sde_trace.h"
@@ -27,11 +29,13 @@
 
 struct sde_evtlog_filter {
 	struct list_head list;
+	struct list_head free;
 	char filter[SDE_EVTLOG_FILTER_STRSIZE];
 };
 
-static bool _sde_evtlog_is_filtered_no_lock(
-		struct sde_dbg_evtlog *evtlog, const char *str)
+/* caller must hold the rcu read lock */
+static bool _sde_evtlog_is_filtered(struct sde_dbg_evtlog *evtlog,
+		const char *str)
 {
 	struct sde_evtlog_filter *filter_node;
 	size_t len;
@@ -47,7 +51,7 @@ static bool _sde_evtlog_is_filtered_no_lock(
 	 * a matching entry is not in the list.
 	 */
 	rc = !list_empty(&evtlog->filter_list);
-	list_for_each_entry(filter_node, &evtlog->filter_list, list)
+	list_for_each_entry_rcu(filter_node, &evtlog->filter_list, list)
 		if (strnstr(str, filter_node->filter, len)) {
 			rc = false;
 			break;
@@ -61,13 +65,22 @@ bool sde_evtlog_is_enabled(struct sde_dbg_evtlog *evtlog, u32 flag)
 	return evtlog && (evtlog->enable & flag);
 }
 
+/*
+ * Entries are logged into a ring of the local cpu without taking any lock.
+ * A slot is reserved with an irq safe local increment so that an interrupt
+ * logging on top of a task gets the next slot. The seq field is cleared
+ * while the slot is written, which lets a concurrent dump detect entries
+ * that are incomplete or were overwritten.
+ */
 void sde_evtlog_log(struct sde_dbg_evtlog *evtlog, const char *name, int line,
 		int flag, ...)
 {
-	unsigned long flags;
 	int i, val = 0;
 	va_list args;
+	struct sde_dbg_evtlog_cpu *cpu;
 	struct sde_dbg_evtlog_log *log;
+	bool filtered;
+	u32 idx;
 
 	if (!evtlog)
 		return;
@@ -75,12 +88,21 @@ void sde_evtlog_log(struct sde_dbg_evtlog *evtlog, const char *name, int line,
 	if (!sde_evtlog_is_enabled(evtlog, flag))
 		return;
 
-	spin_lock_irqsave(&evtlog->spin_lock, flags);
+	rcu_read_lock();
+	filtered = _sde_evtlog_is_filtered(evtlog, name);
+	rcu_read_unlock();
+	if (filtered)
+		return;
 
-	if (_sde_evtlog_is_filtered_no_lock(evtlog, name))
-		goto exit;
+	preempt_disable();
+
+	cpu = &evtlog->cpus[smp_processor_id()];
+	idx = local_inc_return(&cpu->curr) - 1;
+	log = &cpu->logs[idx % SDE_EVTLOG_CPU_ENTRY];
+
+	WRITE_ONCE(log->seq, 0);
+	smp_wmb();
 
-	log = &evtlog->logs[evtlog->curr];
 	log->time = ktime_to_us(ktime_get());
 	log->name = name;
 	log->line = line;
@@ -98,43 +120,99 @@ void sde_evtlog_log(struct sde_dbg_evtlog *evtlog, const char *name, int line,
 	}
 	va_end(args);
 	log->data_cnt = i;
-	evtlog->curr = (evtlog->curr + 1) % SDE_EVTLOG_ENTRY;
-	evtlog->last++;
+
+	smp_wmb();
+	WRITE_ONCE(log->seq, idx + 1);
 
 	trace_sde_evtlog(name, line, log->data_cnt, log->data);
-exit:
-	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
+
+	preempt_enable();
+}
+
+/* copy out entry @idx of @cpu, false if it is incomplete or overwritten */
+static bool _sde_evtlog_read(struct sde_dbg_evtlog_cpu *cpu, u32 idx,
+		struct sde_dbg_evtlog_log *out)
+{
+	struct sde_dbg_evtlog_log *log = &cpu->logs[idx % SDE_EVTLOG_CPU_ENTRY];
+
+	if (READ_ONCE(log->seq) != idx + 1)
+		return false;
+
+	smp_rmb();
+	memcpy(out, log, sizeof(*out));
+	smp_rmb();
+
+	return READ_ONCE(log->seq) == idx + 1;
+}
+
+/* take the oldest entry not dumped yet from all cpu rings */
+static bool _sde_evtlog_dump_next(struct sde_dbg_evtlog *evtlog,
+		struct sde_dbg_evtlog_log *out, int *out_cpu)
+{
+	struct sde_dbg_evtlog_cpu *cpu;
+	struct sde_dbg_evtlog_log log;
+	int i, best = -1;
+
+	for_each_possible_cpu(i) {
+		cpu = &evtlog->cpus[i];
+
+		/* entries that can't be read are lost to a writer */
+		while (cpu->next != cpu->last_dump &&
+				!_sde_evtlog_read(cpu, cpu->next, &log))
+			cpu->next++;
+
+		if (cpu->next == cpu->last_dump)
+			continue;
+
+		if (best < 0 || log.time < out->time) {
+			memcpy(out, &log, sizeof(*out));
+			best = i;
+		}
+	}
+
+	if (best < 0)
+		return false;
+
+	evtlog->cpus[best].next++;
+	*out_cpu = best;
+
+	return true;
 }
 
 /* always dump the last entries which are not dumped yet */
 static bool _sde_evtlog_dump_calc_range(struct sde_dbg_evtlog *evtlog,
 		bool update_last_entry)
 {
+	struct sde_dbg_evtlog_cpu *cpu;
+	struct sde_dbg_evtlog_log log;
+	u32 pending = 0, skip;
+	int i;
+
 	if (!evtlog)
 		return false;
 
-	evtlog->first = evtlog->next;
+	for_each_possible_cpu(i) {
+		cpu = &evtlog->cpus[i];
 
-	if (update_last_entry)
-		evtlog->last_dump = evtlog->last;
+		if (update_last_entry)
+			cpu->last_dump = (u32)local_read(&cpu->curr);
 
-	if (evtlog->last_dump == evtlog->first)
-		return false;
+		/* older entries have been overwritten in the ring */
+		if (cpu->last_dump - cpu->next > SDE_EVTLOG_CPU_ENTRY)
+			cpu->next = cpu->last_dump - SDE_EVTLOG_CPU_ENTRY;
 
-	if (evtlog->last_dump < evtlog->first) {
-		evtlog->first %= SDE_EVTLOG_ENTRY;
-		if (evtlog->last_dump < evtlog->first)
-			evtlog->last_dump += SDE_EVTLOG_ENTRY;
+		pending += cpu->last_dump - cpu->next;
 	}
 
-	if ((evtlog->last_dump - evtlog->first) > SDE_EVTLOG_PRINT_ENTRY) {
-		pr_info("evtlog skipping %d entries, last=%d\n",
-			evtlog->last_dump - evtlog->first -
-			SDE_EVTLOG_PRINT_ENTRY,
-			evtlog->last_dump - 1);
-		evtlog->first = evtlog->last_dump - SDE_EVTLOG_PRINT_ENTRY;
+	if (!pending)
+		return false;
+
+	if (pending > SDE_EVTLOG_PRINT_ENTRY) {
+		skip = pending - SDE_EVTLOG_PRINT_ENTRY;
+		pr_info("evtlog skipping %u entries\n", skip);
+		while (skip-- && _sde_evtlog_dump_next(evtlog, &log, &i))
+			evtlog->prev_time = log.time;
 	}
-	evtlog->next = evtlog->first + 1;
 
 	return true;
 }
@@ -143,9 +221,9 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 		char *evtlog_buf, ssize_t evtlog_buf_size,
 		bool update_last_entry)
 {
-	int i;
+	int i, cpu;
 	ssize_t off = 0;
-	struct sde_dbg_evtlog_log *log, *prev_log;
+	struct sde_dbg_evtlog_log log;
 	unsigned long flags;
 
 	if (!evtlog || !evtlog_buf)
@@ -157,12 +235,11 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 	if (!_sde_evtlog_dump_calc_range(evtlog, update_last_entry))
 		goto exit;
 
-	log = &evtlog->logs[evtlog->first % SDE_EVTLOG_ENTRY];
-
-	prev_log = &evtlog->logs[(evtlog->first - 1) % SDE_EVTLOG_ENTRY];
+	if (!_sde_evtlog_dump_next(evtlog, &log, &cpu))
+		goto exit;
 
 	off = snprintf((evtlog_buf + off), (evtlog_buf_size - off), "%s:%-4d",
-		log->name, log->line);
+		log.name, log.line);
 
 	if (off < SDE_EVTLOG_BUF_ALIGN) {
 		memset((evtlog_buf + off), 0x20, (SDE_EVTLOG_BUF_ALIGN - off));
@@ -170,14 +247,16 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 	}
 
 	off += snprintf((evtlog_buf + off), (evtlog_buf_size - off),
-		"=>[%-8d:%-11llu:%9llu][%-4d]:", evtlog->first,
-		log->time, (log->time - prev_log->time), log->pid);
+		"=>[%-8u:%-11llu:%9llu][%-4d][%d]:", log.seq - 1,
+		log.time, (log.time - evtlog->prev_time), log.pid, cpu);
 
-	for (i = 0; i < log->data_cnt; i++)
+	for (i = 0; i < log.data_cnt; i++)
 		off += snprintf((evtlog_buf + off), (evtlog_buf_size - off),
-			"%x ", log->data[i]);
+			"%x ", log.data[i]);
 
 	off += snprintf((evtlog_buf + off), (evtlog_buf_size - off), "\n");
+
+	evtlog->prev_time = log.time;
 exit:
 	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
 
@@ -207,6 +286,12 @@ struct sde_dbg_evtlog *sde_evtlog_init(void)
 	if (!evtlog)
 		return ERR_PTR(-ENOMEM);
 
+	evtlog->cpus = vzalloc(nr_cpu_ids * sizeof(*evtlog->cpus));
+	if (!evtlog->cpus) {
+		kfree(evtlog);
+		return ERR_PTR(-ENOMEM);
+	}
+
 	spin_lock_init(&evtlog->spin_lock);
 	evtlog->enable = SDE_EVTLOG_DEFAULT_ENABLE;
 
@@ -258,11 +343,14 @@ void sde_evtlog_set_filter(struct sde_dbg_evtlog *evtlog, char *filter)
 	 */
 	spin_lock_irqsave(&evtlog->spin_lock, flags);
 	list_for_each_entry_safe(filter_node, tmp, &evtlog->filter_list, list) {
-		list_del_init(&filter_node->list);
-		list_add_tail(&filter_node->list, &free_list);
+		list_del_rcu(&filter_node->list);
+		list_add_tail(&filter_node->free, &free_list);
 	}
 	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
 
+	/* loggers may still be walking the old filter_nodes */
+	synchronize_rcu();
+
 	/*
 	 * Parse incoming filter request string and build up a new
 	 * filter list. New filter nodes are taken from the local
@@ -277,12 +365,10 @@ void sde_evtlog_set_filter(struct sde_dbg_evtlog *evtlog, char *filter)
 			filter_node = kzalloc(sizeof(*filter_node), GFP_KERNEL);
 			if (!filter_node)
 				break;
-
-			INIT_LIST_HEAD(&filter_node->list);
 		} else {
 			filter_node = list_first_entry(&free_list,
-					struct sde_evtlog_filter, list);
-			list_del_init(&filter_node->list);
+					struct sde_evtlog_filter, free);
+			list_del(&filter_node->free);
 		}
 
 		/* don't care if copy truncated */
@@ -290,15 +376,15 @@ void sde_evtlog_set_filter(struct sde_dbg_evtlog *evtlog, char *filter)
 				SDE_EVTLOG_FILTER_STRSIZE);
 
 		spin_lock_irqsave(&evtlog->spin_lock, flags);
-		list_add_tail(&filter_node->list, &evtlog->filter_list);
+		list_add_tail_rcu(&filter_node->list, &evtlog->filter_list);
 		spin_unlock_irqrestore(&evtlog->spin_lock, flags);
 	}
 
 	/*
 	 * Free any unused filter_nodes back to the system.
 	 */
-	list_for_each_entry_safe(filter_node, tmp, &free_list, list) {
-		list_del(&filter_node->list);
+	list_for_each_entry_safe(filter_node, tmp, &free_list, free) {
+		list_del(&filter_node->free);
 		kfree(filter_node);
 	}
 }
@@ -314,5 +400,6 @@ void sde_evtlog_destroy(struct sde_dbg_evtlog *evtlog)
 		list_del(&filter_node->list);
 		kfree(filter_node);
 	}
+	vfree(evtlog->cpus);
 	kfree(evtlog);
 }
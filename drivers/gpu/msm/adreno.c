@@ -2625,6 +2625,28 @@ static int adreno_setproperty(struct kgsl_device_private *dev_priv,
 			kgsl_context_put(context);
 		}
 		break;
+	case KGSL_PROP_CONTEXT_EVENTFD: {
+			struct kgsl_context_eventfd efd;
+			struct kgsl_context *context;
+
+			if (sizebytes != sizeof(efd))
+				break;
+
+			if (copy_from_user(&efd, value, sizeof(efd))) {
+				status = -EFAULT;
+				break;
+			}
+
+			context = kgsl_context_get_owner(dev_priv,
+							efd.context_id);
+			if (context == NULL)
+				break;
+
+			status = kgsl_event_group_set_eventfd(&context->events,
+							efd.fd);
+			kgsl_context_put(context);
+		}
+		break;
 	default:
 		break;
 	}
@@ -3358,6 +3380,8 @@ static void adreno_device_private_destroy(struct kgsl_device_private *dev_priv)
 		dev_priv);
 	struct adreno_perfcounter_list_node *p, *tmp;
 
+	adreno_perfcounter_sample_stop(adreno_dev, dev_priv);
+
 	mutex_lock(&device->mutex);
 	list_for_each_entry_safe(p, tmp, &adreno_priv->perfcounter_list, node) {
 		adreno_perfcounter_put(adreno_dev, p->groupid,
@@ -287,6 +287,7 @@ enum adreno_preempt_states {
  * skipsaverestore: To skip saverestore during L1 preemption (for 6XX)
  * usesgmem: enable GMEM save/restore across preemption (for 6XX)
  * count: Track the number of preemptions triggered
+ * trigger_time: Time the pending preemption was triggered
  */
 struct adreno_preemption {
 	atomic_t state;
@@ -298,6 +299,7 @@ struct adreno_preemption {
 	bool skipsaverestore;
 	bool usesgmem;
 	unsigned int count;
+	ktime_t trigger_time;
 };
 
 
@@ -327,6 +329,8 @@ struct adreno_firmware {
 	struct kgsl_memdesc memdesc;
 };
 
+struct adreno_perfcounter_sampler;
+
 /**
  * struct adreno_perfcounter_list_node - struct to store perfcounters
  * allocated by a process on a kgsl fd.
@@ -453,6 +457,7 @@ enum gpu_coresight_sources {
  * @ft_pf_policy: Defines the fault policy for page faults
  * @ocmem_hdl: Handle to the ocmem allocated buffer
  * @profile: Container for adreno profiler information
+ * @sampler: Active perfcounter sampling session, protected by device->mutex
  * @dispatcher: Container for adreno GPU dispatcher
  * @pwron_fixup: Command buffer to run a post-power collapse shader workaround
  * @pwron_fixup_dwords: Number of dwords in the command buffer
@@ -527,6 +532,7 @@ struct adreno_device {
 	unsigned long ft_pf_policy;
 	struct ocmem_buf *ocmem_hdl;
 	struct adreno_profile profile;
+	struct adreno_perfcounter_sampler *sampler;
 	struct adreno_dispatcher dispatcher;
 	struct kgsl_memdesc pwron_fixup;
 	unsigned int pwron_fixup_dwords;
@@ -1152,6 +1158,9 @@ long adreno_ioctl_perfcounter_get(struct kgsl_device_private *dev_priv,
 long adreno_ioctl_perfcounter_put(struct kgsl_device_private *dev_priv,
 	unsigned int cmd, void *data);
 
+long adreno_ioctl_perfcounter_sample(struct kgsl_device_private *dev_priv,
+	unsigned int cmd, void *data);
+
 int adreno_efuse_map(struct adreno_device *adreno_dev);
 int adreno_efuse_read_u32(struct adreno_device *adreno_dev, unsigned int offset,
 		unsigned int *val);
@@ -1693,6 +1702,28 @@ static inline void adreno_set_preempt_state(struct adreno_device *adreno_dev,
 	smp_wmb();
 }
 
+/**
+ * adreno_preempt_record_latency() - Account the latency of a preemption
+ * @adreno_dev: Device that completed the preemption
+ *
+ * Add the time from the trigger to the switch completing to the latency
+ * histogram of the ringbuffer that was switched to. Bucket n counts the
+ * switches that took [2^(n-1), 2^n) usecs, the last one everything longer.
+ */
+static inline void adreno_preempt_record_latency(
+		struct adreno_device *adreno_dev)
+{
+	struct adreno_ringbuffer *rb = adreno_dev->next_rb;
+	s64 us = ktime_us_delta(ktime_get(), adreno_dev->preempt.trigger_time);
+	int bucket;
+
+	if (rb == NULL)
+		return;
+
+	bucket = us > 0 ? fls((u32)min_t(s64, us, U32_MAX)) : 0;
+	rb->preempt_latency[min(bucket, ADRENO_PREEMPT_LATENCY_BUCKETS - 1)]++;
+}
+
 static inline bool adreno_is_preemption_enabled(
 				struct adreno_device *adreno_dev)
 {
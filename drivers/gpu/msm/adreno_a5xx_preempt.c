@@ -88,6 +88,8 @@ static void _a5xx_preemption_done(struct adreno_device *adreno_dev)
 
 	del_timer_sync(&adreno_dev->preempt.timer);
 
+	adreno_preempt_record_latency(adreno_dev);
+
 	trace_adreno_preempt_done(adreno_dev->cur_rb, adreno_dev->next_rb, 0);
 
 	/* Clean up all the bits */
@@ -272,6 +274,8 @@ void a5xx_preemption_trigger(struct adreno_device *adreno_dev)
 	mod_timer(&adreno_dev->preempt.timer,
 		jiffies + msecs_to_jiffies(ADRENO_PREEMPT_TIMEOUT));
 
+	adreno_dev->preempt.trigger_time = ktime_get();
+
 	trace_adreno_preempt_trigger(adreno_dev->cur_rb, adreno_dev->next_rb,
 		1);
 
@@ -308,6 +312,8 @@ void a5xx_preempt_callback(struct adreno_device *adreno_dev, int bit)
 
 	del_timer(&adreno_dev->preempt.timer);
 
+	adreno_preempt_record_latency(adreno_dev);
+
 	trace_adreno_preempt_done(adreno_dev->cur_rb, adreno_dev->next_rb, 0);
 
 	adreno_dev->prev_rb = adreno_dev->cur_rb;
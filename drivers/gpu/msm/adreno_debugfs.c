@@ -122,6 +122,95 @@ static int _active_count_get(void *data, u64 *val)
 
 DEFINE_SIMPLE_ATTRIBUTE(_active_count_fops, _active_count_get, NULL, "%llu\n");
 
+static int _preempt_latency_print(struct seq_file *s, void *unused)
+{
+	struct adreno_device *adreno_dev = s->private;
+	struct adreno_ringbuffer *rb;
+	int i, j;
+
+	seq_printf(s, "%-6s", "usecs");
+	FOR_EACH_RINGBUFFER(adreno_dev, rb, i)
+		seq_printf(s, " %10s%d", "rb", rb->id);
+	seq_puts(s, "\n");
+
+	for (j = 0; j < ADRENO_PREEMPT_LATENCY_BUCKETS; j++) {
+		if (j == ADRENO_PREEMPT_LATENCY_BUCKETS - 1)
+			seq_printf(s, ">=%-4u", 1U << (j - 1));
+		else
+			seq_printf(s, "<%-5u", 1U << j);
+
+		FOR_EACH_RINGBUFFER(adreno_dev, rb, i)
+			seq_printf(s, " %11u", rb->preempt_latency[j]);
+		seq_puts(s, "\n");
+	}
+
+	return 0;
+}
+
+static int _preempt_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, _preempt_latency_print, inode->i_private);
+}
+
+static const struct file_operations _preempt_latency_fops = {
+	.open = _preempt_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int _dispatch_latency_print(struct seq_file *s, void *unused)
+{
+	struct adreno_device *adreno_dev = s->private;
+	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
+	int j;
+
+	seq_printf(s, "%-6s %11s %11s\n", "usecs", "queue", "retire");
+
+	for (j = 0; j < ADRENO_DISPATCH_LATENCY_BUCKETS; j++) {
+		if (j == ADRENO_DISPATCH_LATENCY_BUCKETS - 1)
+			seq_printf(s, ">=%-4u", 1U << (j - 1));
+		else
+			seq_printf(s, "<%-5u", 1U << j);
+
+		seq_printf(s, " %11u %11u\n", dispatcher->queue_latency[j],
+			dispatcher->retire_latency[j]);
+	}
+
+	return 0;
+}
+
+static int _dispatch_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, _dispatch_latency_print, inode->i_private);
+}
+
+/* Any write clears both histograms */
+static ssize_t _dispatch_latency_write(struct file *file,
+		const char __user *buf, size_t count, loff_t *ppos)
+{
+	struct adreno_device *adreno_dev =
+		((struct seq_file *)file->private_data)->private;
+	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
+
+	mutex_lock(&dispatcher->mutex);
+	memset(dispatcher->queue_latency, 0,
+		sizeof(dispatcher->queue_latency));
+	memset(dispatcher->retire_latency, 0,
+		sizeof(dispatcher->retire_latency));
+	mutex_unlock(&dispatcher->mutex);
+
+	return count;
+}
+
+static const struct file_operations _dispatch_latency_fops = {
+	.open = _dispatch_latency_open,
+	.read = seq_read,
+	.write = _dispatch_latency_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 typedef void (*reg_read_init_t)(struct kgsl_device *device);
 typedef void (*reg_read_fill_t)(struct kgsl_device *device, int i,
 	unsigned int *vals, int linec);
@@ -278,10 +367,11 @@ static int ctx_print(struct seq_file *s, void *unused)
 	struct kgsl_event *event;
 	unsigned int queued = 0, consumed = 0, retired = 0;
 
-	seq_printf(s, "id: %d type: %s priority: %d process: %s (%d) tid: %d\n",
+	seq_printf(s, "id: %d type: %s priority: %d (%d) process: %s (%d) tid: %d\n",
 		   drawctxt->base.id,
 		   ctx_type_str(drawctxt->type),
 		   drawctxt->base.priority,
+		   drawctxt->inherit_priority,
 		   drawctxt->base.proc_priv->comm,
 		   pid_nr(drawctxt->base.proc_priv->pid),
 		   drawctxt->base.tid);
@@ -395,4 +485,11 @@ void adreno_debugfs_init(struct adreno_device *adreno_dev)
 	if (adreno_is_a5xx(adreno_dev))
 		debugfs_create_file("isdb", 0644, device->d_debugfs,
 			device, &_isdb_fops);
+
+	if (ADRENO_FEATURE(adreno_dev, ADRENO_PREEMPTION))
+		debugfs_create_file("preempt_latency", 0444, device->d_debugfs,
+			adreno_dev, &_preempt_latency_fops);
+
+	debugfs_create_file("dispatch_latency", 0644, device->d_debugfs,
+		adreno_dev, &_dispatch_latency_fops);
 }
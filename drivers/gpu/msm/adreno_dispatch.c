@@ -55,6 +55,9 @@ static unsigned int _context_queue_wait = 10000;
 /* Number of drawobjs sent at a time from a single context */
 static unsigned int _context_drawobj_burst = 5;
 
+/* Maximum number of drawobjs taken off a context queue at once */
+#define DISPATCH_BATCH_SIZE 8
+
 /*
  * GFT throttle parameters. If GFT recovered more than
  * X times in Y ms invalidate the context and do not attempt recovery.
@@ -513,6 +516,93 @@ static inline int adreno_dispatcher_requeue_cmdobj(
 	return 0;
 }
 
+/*
+ * Put the unsent tail of a dequeued batch back on the head of the context
+ * queue. Entries are pushed back to front so that the queue order is kept.
+ */
+static void _requeue_batch(struct adreno_context *drawctxt,
+		struct kgsl_drawobj **batch, int nr)
+{
+	while (nr--)
+		adreno_dispatcher_requeue_cmdobj(drawctxt, CMDOBJ(batch[nr]));
+}
+
+/**
+ * _context_priority() - Return the priority to put a context on the pending
+ * list with
+ * @drawctxt: Pointer to the adreno draw context
+ *
+ * Drop an inherited priority once the timestamp that was waited on retired.
+ * Must be called with the dispatcher plist_lock held while the node is not on
+ * any list.
+ */
+static int _context_priority(struct adreno_context *drawctxt)
+{
+	unsigned int retired;
+
+	if (drawctxt->inherit_priority >= drawctxt->base.priority)
+		return drawctxt->base.priority;
+
+	kgsl_readtimestamp(drawctxt->base.device, &drawctxt->base,
+		KGSL_TIMESTAMP_RETIRED, &retired);
+
+	if (timestamp_cmp(retired, drawctxt->inherit_timestamp) >= 0) {
+		drawctxt->inherit_priority = drawctxt->base.priority;
+		return drawctxt->base.priority;
+	}
+
+	return drawctxt->inherit_priority;
+}
+
+/**
+ * _inherit_priority() - Lend the priority of a context to the contexts it
+ * waits on
+ * @adreno_dev: Pointer to the adreno device struct
+ * @drawctxt: Pointer to the adreno draw context queueing the sync object
+ * @syncobj: Pointer to the sync object being queued
+ *
+ * A timestamp syncpoint on a lower priority context would otherwise leave
+ * the waiter stuck behind everything else the dispatcher has on that
+ * priority. The holder is raised to the priority of the waiter until the
+ * timestamp retires. The new priority takes effect the next time the holder
+ * is put on the dispatcher pending list, which happens on every dispatcher
+ * pass.
+ */
+static void _inherit_priority(struct adreno_device *adreno_dev,
+		struct adreno_context *drawctxt,
+		struct kgsl_drawobj_sync *syncobj)
+{
+	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
+	unsigned int i;
+
+	for (i = 0; i < syncobj->numsyncs; i++) {
+		struct kgsl_drawobj_sync_event *event = &syncobj->synclist[i];
+		struct adreno_context *holder;
+
+		if (event->type != KGSL_CMD_SYNCPOINT_TYPE_TIMESTAMP ||
+			event->context == &drawctxt->base)
+			continue;
+
+		holder = ADRENO_CONTEXT(event->context);
+		if (holder->base.priority <= drawctxt->base.priority)
+			continue;
+
+		spin_lock(&dispatcher->plist_lock);
+
+		if (drawctxt->base.priority < holder->inherit_priority) {
+			holder->inherit_priority = drawctxt->base.priority;
+			holder->inherit_timestamp = event->timestamp;
+		} else if (drawctxt->base.priority ==
+				holder->inherit_priority &&
+			timestamp_cmp(event->timestamp,
+				holder->inherit_timestamp) > 0) {
+			holder->inherit_timestamp = event->timestamp;
+		}
+
+		spin_unlock(&dispatcher->plist_lock);
+	}
+}
+
 /**
  * dispatcher_queue_context() - Queue a context in the dispatcher pending list
  * @dispatcher: Pointer to the adreno dispatcher struct
@@ -535,6 +625,7 @@ static void  dispatcher_queue_context(struct adreno_device *adreno_dev,
 		/* Get a reference to the context while it sits on the list */
 		if (_kgsl_context_get(&drawctxt->base)) {
 			trace_dispatch_queue_context(drawctxt);
+			drawctxt->pending.prio = _context_priority(drawctxt);
 			plist_add(&drawctxt->pending, &dispatcher->pending);
 		}
 	}
@@ -542,6 +633,19 @@ static void  dispatcher_queue_context(struct adreno_device *adreno_dev,
 	spin_unlock(&dispatcher->plist_lock);
 }
 
+/*
+ * Add the time between two local_clock() stamps to a dispatcher latency
+ * histogram. Bucket n counts [2^(n-1), 2^n) usecs, the last one everything
+ * longer.
+ */
+static void _record_latency(unsigned int *hist, u64 start, u64 end)
+{
+	u64 us = end > start ? div_u64(end - start, NSEC_PER_USEC) : 0;
+	int bucket = fls((u32)min_t(u64, us, U32_MAX));
+
+	hist[min(bucket, ADRENO_DISPATCH_LATENCY_BUCKETS - 1)]++;
+}
+
 /**
  * sendcmd() - Send a drawobj to the GPU hardware
  * @dispatcher: Pointer to the adreno dispatcher struct
@@ -667,6 +771,9 @@ static int sendcmd(struct adreno_device *adreno_dev,
 	mutex_unlock(&device->mutex);
 
 	cmdobj->submit_ticks = time.ticks;
+	cmdobj->submit_ktime = time.ktime;
+	_record_latency(dispatcher->queue_latency, cmdobj->queue_ktime,
+		time.ktime);
 
 	dispatch_q->cmd_q[dispatch_q->tail] = cmdobj;
 	dispatch_q->tail = (dispatch_q->tail + 1) %
@@ -807,61 +914,90 @@ static int dispatcher_context_sendcmds(struct adreno_device *adreno_dev,
 	 */
 	while ((count < _context_drawobj_burst) &&
 		(dispatch_q->inflight < inflight)) {
-		struct kgsl_drawobj *drawobj;
-		struct kgsl_drawobj_cmd *cmdobj;
+		struct kgsl_drawobj *batch[DISPATCH_BATCH_SIZE];
+		int nr, i;
 
 		if (adreno_gpu_fault(adreno_dev) != 0)
 			break;
 
-		spin_lock(&drawctxt->lock);
-		drawobj = _process_drawqueue_get_next_drawobj(drawctxt);
+		nr = min_t(int, _context_drawobj_burst - count,
+			inflight - dispatch_q->inflight);
+		nr = min_t(int, nr, DISPATCH_BATCH_SIZE);
 
 		/*
-		 * adreno_context_get_drawobj returns -EAGAIN if the current
-		 * drawobj has pending sync points so no more to do here.
-		 * When the sync points are satisfied then the context will get
-		 * reqeueued
+		 * Take the whole batch off the context queue in one go so the
+		 * submitting thread only contends with us once per batch
 		 */
+		spin_lock(&drawctxt->lock);
+		for (i = 0; i < nr; i++) {
+			struct kgsl_drawobj *drawobj;
 
-		if (IS_ERR_OR_NULL(drawobj)) {
-			if (IS_ERR(drawobj))
-				ret = PTR_ERR(drawobj);
-			spin_unlock(&drawctxt->lock);
-			break;
+			drawobj = _process_drawqueue_get_next_drawobj(drawctxt);
+
+			/*
+			 * adreno_context_get_drawobj returns -EAGAIN if the
+			 * current drawobj has pending sync points so no more to
+			 * do here. When the sync points are satisfied then the
+			 * context will get reqeueued
+			 */
+			if (IS_ERR_OR_NULL(drawobj)) {
+				if (IS_ERR(drawobj))
+					ret = PTR_ERR(drawobj);
+				break;
+			}
+
+			_pop_drawobj(drawctxt);
+			batch[i] = drawobj;
 		}
-		_pop_drawobj(drawctxt);
 		spin_unlock(&drawctxt->lock);
 
-		timestamp = drawobj->timestamp;
-		cmdobj = CMDOBJ(drawobj);
-		ret = sendcmd(adreno_dev, cmdobj);
+		nr = i;
+		for (i = 0; i < nr; i++) {
+			int r;
+
+			if (adreno_gpu_fault(adreno_dev) != 0) {
+				_requeue_batch(drawctxt, &batch[i], nr - i);
+				break;
+			}
+
+			timestamp = batch[i]->timestamp;
+			r = sendcmd(adreno_dev, CMDOBJ(batch[i]));
+			if (r == 0) {
+				drawctxt->submitted_timestamp = timestamp;
+				count++;
+				continue;
+			}
+
+			/*
+			 * On error from sendcmd() put the rest of the batch
+			 * back, in order, ahead of anything queued since and
+			 * then try to requeue the failed cmdobj unless we got
+			 * back -ENOENT which means that the context has been
+			 * detached and there will be no more deliveries from
+			 * here
+			 */
+			_requeue_batch(drawctxt, &batch[i + 1], nr - i - 1);
 
-		/*
-		 * On error from sendcmd() try to requeue the cmdobj
-		 * unless we got back -ENOENT which means that the context has
-		 * been detached and there will be no more deliveries from here
-		 */
-		if (ret != 0) {
 			/* Destroy the cmdobj on -ENOENT */
-			if (ret == -ENOENT)
-				kgsl_drawobj_destroy(drawobj);
+			if (r == -ENOENT)
+				kgsl_drawobj_destroy(batch[i]);
 			else {
 				/*
 				 * If the requeue returns an error, return that
 				 * instead of whatever sendcmd() sent us
 				 */
-				int r = adreno_dispatcher_requeue_cmdobj(
-					drawctxt, cmdobj);
-				if (r)
-					ret = r;
+				int e = adreno_dispatcher_requeue_cmdobj(
+					drawctxt, CMDOBJ(batch[i]));
+				if (e)
+					r = e;
 			}
 
+			ret = r;
 			break;
 		}
 
-		drawctxt->submitted_timestamp = timestamp;
-
-		count++;
+		if (ret || nr == 0)
+			break;
 	}
 
 	/*
@@ -978,12 +1114,14 @@ static void _adreno_dispatcher_issuecmds(struct adreno_device *adreno_dev)
 	/* Put the contexts that couldn't submit back on the pending list */
 	plist_for_each_entry_safe(drawctxt, next, &busy_list, pending) {
 		plist_del(&drawctxt->pending, &busy_list);
+		drawctxt->pending.prio = _context_priority(drawctxt);
 		plist_add(&drawctxt->pending, &dispatcher->pending);
 	}
 
 	/* Now put the contexts that need to be requeued back on the list */
 	plist_for_each_entry_safe(drawctxt, next, &requeue, pending) {
 		plist_del(&drawctxt->pending, &requeue);
+		drawctxt->pending.prio = _context_priority(drawctxt);
 		plist_add(&drawctxt->pending, &dispatcher->pending);
 	}
 
@@ -993,12 +1131,33 @@ static void _adreno_dispatcher_issuecmds(struct adreno_device *adreno_dev)
 /**
  * adreno_dispatcher_issuecmds() - Issue commmands from pending contexts
  * @adreno_dev: Pointer to the adreno device struct
+ * @dispatch_q: The drawqueue that new commands were queued for
  *
- * Lock the dispatcher and call _adreno_dispatcher_issueibcmds
+ * If the ringbuffer behind @dispatch_q is idle and the dispatcher isn't
+ * busy, issue the commands from the submitting thread instead of waking the
+ * dispatcher thread for them. Otherwise leave it to the dispatcher.
  */
-static void adreno_dispatcher_issuecmds(struct adreno_device *adreno_dev)
+static void adreno_dispatcher_issuecmds(struct adreno_device *adreno_dev,
+		struct adreno_dispatcher_drawqueue *dispatch_q)
 {
-	adreno_dispatcher_schedule(KGSL_DEVICE(adreno_dev));
+	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
+	bool pending;
+
+	if (dispatch_q->inflight || !mutex_trylock(&dispatcher->mutex)) {
+		adreno_dispatcher_schedule(KGSL_DEVICE(adreno_dev));
+		return;
+	}
+
+	_adreno_dispatcher_issuecmds(adreno_dev);
+	mutex_unlock(&dispatcher->mutex);
+
+	/* Anything that couldn't go out now is left for the dispatcher */
+	spin_lock(&dispatcher->plist_lock);
+	pending = !plist_head_empty(&dispatcher->pending);
+	spin_unlock(&dispatcher->plist_lock);
+
+	if (pending)
+		adreno_dispatcher_schedule(KGSL_DEVICE(adreno_dev));
 }
 
 /**
@@ -1317,6 +1476,7 @@ static int _queue_cmdobj(struct adreno_device *adreno_dev,
 	drawctxt->queued_timestamp = *timestamp;
 	_set_ft_policy(adreno_dev, drawctxt, cmdobj);
 	_cmdobj_set_flags(drawctxt, cmdobj);
+	cmdobj->queue_ktime = local_clock();
 
 	_queue_drawobj(drawctxt, drawobj);
 
@@ -1422,6 +1582,8 @@ int adreno_dispatcher_queue_cmds(struct kgsl_device_private *dev_priv,
 			}
 			break;
 		case SYNCOBJ_TYPE:
+			_inherit_priority(adreno_dev, drawctxt,
+						SYNCOBJ(drawobj[i]));
 			_queue_syncobj(drawctxt, SYNCOBJ(drawobj[i]),
 						timestamp);
 			break;
@@ -1469,7 +1631,7 @@ int adreno_dispatcher_queue_cmds(struct kgsl_device_private *dev_priv,
 	 */
 
 	if (dispatch_q->inflight < _context_drawobj_burst)
-		adreno_dispatcher_issuecmds(adreno_dev);
+		adreno_dispatcher_issuecmds(adreno_dev, dispatch_q);
 done:
 	if (test_and_clear_bit(ADRENO_CONTEXT_FAULT, &context->priv))
 		return -EPROTO;
@@ -2303,6 +2465,32 @@ static void cmdobj_profile_ticks(struct adreno_device *adreno_dev,
 	*retire = entry->retired;
 }
 
+/*
+ * Add the GPU time of a retired command obj to the frame its context is
+ * working on and report the frame to pwrscale when it ends. Commands run
+ * one after another, so a command is only charged from the later of its
+ * submission and the previous retirement.
+ */
+static void _account_frame_time(struct adreno_device *adreno_dev,
+		struct kgsl_drawobj_cmd *cmdobj)
+{
+	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
+	struct kgsl_drawobj *drawobj = DRAWOBJ(cmdobj);
+	struct adreno_context *drawctxt = ADRENO_CONTEXT(drawobj->context);
+	u64 now = local_clock();
+	u64 start = max(cmdobj->submit_ktime, dispatcher->last_retire_ns);
+
+	if (now > start)
+		drawctxt->frame_busy_ns += now - start;
+	dispatcher->last_retire_ns = now;
+
+	if (drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME) {
+		kgsl_pwrscale_frame_done(KGSL_DEVICE(adreno_dev),
+				drawctxt->frame_busy_ns);
+		drawctxt->frame_busy_ns = 0;
+	}
+}
+
 static void retire_cmdobj(struct adreno_device *adreno_dev,
 		struct kgsl_drawobj_cmd *cmdobj)
 {
@@ -2340,6 +2528,10 @@ static void retire_cmdobj(struct adreno_device *adreno_dev,
 	drawctxt->ticks_index = (drawctxt->ticks_index + 1) %
 		SUBMIT_RETIRE_TICKS_SIZE;
 
+	_account_frame_time(adreno_dev, cmdobj);
+	_record_latency(dispatcher->retire_latency, cmdobj->submit_ktime,
+		local_clock());
+
 	kgsl_drawobj_destroy(drawobj);
 }
 
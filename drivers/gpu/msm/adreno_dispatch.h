@@ -48,6 +48,9 @@ enum adreno_dispatcher_starve_timer_states {
 
 #define DRAWQUEUE_NEXT(_i, _s) (((_i) + 1) % (_s))
 
+/* Number of log2 usec buckets in the dispatcher latency histograms */
+#define ADRENO_DISPATCH_LATENCY_BUCKETS 16
+
 /**
  * struct adreno_dispatcher_drawqueue - List of commands for a RB level
  * @cmd_q: List of command obj's submitted to dispatcher
@@ -83,6 +86,11 @@ struct adreno_dispatcher_drawqueue {
  * @thread: Kthread for the command dispatcher
  * @cmd_waitq: Waitqueue for the command dispatcher
  * @send_cmds: Atomic boolean indicating that commands should be dispatched
+ * @last_retire_ns: local_clock() when the last command obj was retired
+ * @queue_latency: Histogram of the time command objs spent queued on their
+ * context before being written to the ringbuffer
+ * @retire_latency: Histogram of the time from ringbuffer submission to the
+ * command obj being retired
  */
 struct adreno_dispatcher {
 	struct mutex mutex;
@@ -99,6 +107,9 @@ struct adreno_dispatcher {
 	struct task_struct *thread;
 	wait_queue_head_t cmd_waitq;
 	atomic_t send_cmds;
+	u64 last_retire_ns;
+	unsigned int queue_latency[ADRENO_DISPATCH_LATENCY_BUCKETS];
+	unsigned int retire_latency[ADRENO_DISPATCH_LATENCY_BUCKETS];
 };
 
 enum adreno_dispatcher_flags {
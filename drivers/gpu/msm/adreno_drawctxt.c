@@ -411,6 +411,7 @@ adreno_drawctxt_create(struct kgsl_device_private *dev_priv,
 	 * drawctxt pending list based on priority.
 	 */
 	plist_node_init(&drawctxt->pending, drawctxt->base.priority);
+	drawctxt->inherit_priority = drawctxt->base.priority;
 
 	/*
 	 * Now initialize the common part of the context. This allocates the
@@ -53,6 +53,10 @@ struct kgsl_context;
  *		 be written.
  * @active_node: Linkage for nodes in active_list
  * @active_time: Time when this context last seen
+ * @frame_busy_ns: GPU time spent on the frame this context is working on
+ * @inherit_priority: Dispatch priority inherited from a higher priority
+ *		      context waiting on one of our timestamps
+ * @inherit_timestamp: Timestamp to hold the inherited priority until
  */
 struct adreno_context {
 	struct kgsl_context base;
@@ -82,6 +86,9 @@ struct adreno_context {
 
 	struct list_head active_node;
 	unsigned long active_time;
+	u64 frame_busy_ns;
+	int inherit_priority;
+	unsigned int inherit_timestamp;
 };
 
 /* Flag definitions for flag field in adreno_context */
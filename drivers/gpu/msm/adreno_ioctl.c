@@ -145,6 +145,12 @@ static long adreno_ioctl_perfcounter_read(struct kgsl_device_private *dev_priv,
 		read->count);
 }
 
+long adreno_ioctl_perfcounter_sample(struct kgsl_device_private *dev_priv,
+		unsigned int cmd, void *data)
+{
+	return (long) adreno_perfcounter_sample_start(dev_priv, data);
+}
+
 static long adreno_ioctl_preemption_counters_query(
 		struct kgsl_device_private *dev_priv,
 		unsigned int cmd, void *data)
@@ -232,6 +238,7 @@ static struct kgsl_ioctl adreno_ioctl_funcs[] = {
 	{ IOCTL_KGSL_PERFCOUNTER_READ, adreno_ioctl_perfcounter_read },
 	{ IOCTL_KGSL_PREEMPTIONCOUNTER_QUERY,
 		adreno_ioctl_preemption_counters_query },
+	{ IOCTL_KGSL_PERFCOUNTER_SAMPLE, adreno_ioctl_perfcounter_sample },
 };
 
 long adreno_ioctl(struct kgsl_device_private *dev_priv,
@@ -220,6 +220,27 @@ static unsigned int _tlbiall(struct adreno_device *adreno_dev,
 	return cmds - start;
 }
 
+/*
+ * _tlbi_needed() - Check whether a switch to @ttbr0 has to invalidate the TLB
+ * @adreno_dev: the device
+ * @ttbr0: TTBR0 of the incoming pagetable
+ *
+ * Every pagetable gets its own ASID from the SMMU driver and unmaps
+ * already invalidate by that ASID, so entries left behind by the previous
+ * pagetable can never hit once TTBR0 and CONTEXTIDR are switched. The
+ * TLBIALL is only kept when the TLB is not known to be ASID tagged.
+ */
+static bool _tlbi_needed(struct adreno_device *adreno_dev, u64 ttbr0)
+{
+	struct kgsl_mmu *mmu = KGSL_MMU(adreno_dev);
+
+	if (!MMU_FEATURE(mmu, KGSL_MMU_ASID_TLB) ||
+		MMU_FEATURE(mmu, KGSL_MMU_FLUSH_TLB_ON_MAP))
+		return true;
+
+	return !((ttbr0 >> KGSL_IOMMU_TTBR0_ASID_SHIFT) &
+		KGSL_IOMMU_TTBR0_ASID_MASK);
+}
 
 /**
  * _adreno_iommu_add_idle_cmds - Add pm4 packets for GPU idle
@@ -503,10 +524,12 @@ static unsigned int _adreno_iommu_set_pt_v2_a3xx(struct kgsl_device *device,
 
 	cmds += _vbif_unlock(adreno_dev, cmds);
 
-	cmds += _tlbiall(adreno_dev, cmds);
+	if (_tlbi_needed(adreno_dev, ttbr0)) {
+		cmds += _tlbiall(adreno_dev, cmds);
 
-	/* wait for me to finish the TLBI */
-	cmds += cp_wait_for_me(adreno_dev, cmds);
+		/* wait for me to finish the TLBI */
+		cmds += cp_wait_for_me(adreno_dev, cmds);
+	}
 
 	cmds += _adreno_iommu_add_idle_cmds(adreno_dev, cmds);
 
@@ -532,10 +555,12 @@ static unsigned int _adreno_iommu_set_pt_v2_a4xx(struct kgsl_device *device,
 
 	cmds += _vbif_unlock(adreno_dev, cmds);
 
-	cmds += _tlbiall(adreno_dev, cmds);
+	if (_tlbi_needed(adreno_dev, ttbr0)) {
+		cmds += _tlbiall(adreno_dev, cmds);
 
-	/* wait for me to finish the TLBI */
-	cmds += cp_wait_for_me(adreno_dev, cmds);
+		/* wait for me to finish the TLBI */
+		cmds += cp_wait_for_me(adreno_dev, cmds);
+	}
 
 	cmds += _adreno_iommu_add_idle_cmds(adreno_dev, cmds);
 
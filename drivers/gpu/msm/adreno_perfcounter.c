@@ -12,8 +12,10 @@
  */
 #include <linux/module.h>
 #include <linux/uaccess.h>
+#include <linux/workqueue.h>
 
 #include "kgsl.h"
+#include "kgsl_sharedmem.h"
 #include "adreno.h"
 #include "adreno_perfcounter.h"
 #include "adreno_pm4types.h"
@@ -1130,3 +1132,249 @@ uint64_t adreno_perfcounter_read(struct adreno_device *adreno_dev,
 		return _perfcounter_read_default(adreno_dev, group, counter);
 	}
 }
+
+/**
+ * struct adreno_perfcounter_sampler - Periodic perfcounter sampling session
+ * @adreno_dev: Device the counters are sampled on
+ * @owner: The fd that started the session
+ * @entry: GPU object holding the sample ring
+ * @header: Kernel mapping of the ring header
+ * @work: Work item taking the samples
+ * @period: Sampling period in jiffies
+ * @count: Number of counters sampled
+ * @groupid: Group of each sampled counter
+ * @counter: Index of each sampled counter in its group
+ */
+struct adreno_perfcounter_sampler {
+	struct adreno_device *adreno_dev;
+	struct kgsl_device_private *owner;
+	struct kgsl_mem_entry *entry;
+	struct kgsl_perfcounter_sample_header *header;
+	struct delayed_work work;
+	unsigned long period;
+	unsigned int count;
+	unsigned int groupid[ADRENO_PERFCOUNTER_SAMPLE_MAX];
+	unsigned int counter[ADRENO_PERFCOUNTER_SAMPLE_MAX];
+};
+
+static void _perfcounter_sample(struct adreno_perfcounter_sampler *sampler)
+{
+	struct adreno_device *adreno_dev = sampler->adreno_dev;
+	struct kgsl_perfcounter_sample_header *header = sampler->header;
+	struct kgsl_perfcounter_sample_entry *sample;
+	struct adreno_ringbuffer *rb = adreno_dev->cur_rb;
+	unsigned int i, index = header->write_index;
+
+	sample = (void *)(header + 1) +
+		(index % header->max_samples) * header->sample_size;
+
+	sample->time = ktime_get_ns();
+	sample->context_id = (rb && rb->drawctxt_active) ?
+		rb->drawctxt_active->base.id : 0;
+
+	for (i = 0; i < sampler->count; i++)
+		sample->values[i] = adreno_perfcounter_read(adreno_dev,
+			sampler->groupid[i], sampler->counter[i]);
+
+	/* Make sure the sample is visible before the index moves */
+	wmb();
+	header->write_index = index + 1;
+}
+
+static void _perfcounter_sample_work(struct work_struct *work)
+{
+	struct adreno_perfcounter_sampler *sampler = container_of(
+		to_delayed_work(work), struct adreno_perfcounter_sampler, work);
+	struct adreno_device *adreno_dev = sampler->adreno_dev;
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+
+	mutex_lock(&device->mutex);
+
+	/*
+	 * Don't wake the GPU up for a sample, the counters don't move while
+	 * it is asleep anyway
+	 */
+	if (kgsl_state_is_awake(device) &&
+		!adreno_perfcntr_active_oob_get(adreno_dev)) {
+		_perfcounter_sample(sampler);
+		adreno_perfcntr_active_oob_put(adreno_dev);
+	}
+
+	mutex_unlock(&device->mutex);
+
+	queue_delayed_work(kgsl_driver.workqueue, &sampler->work,
+		sampler->period);
+}
+
+static void _perfcounter_sampler_free(
+		struct adreno_perfcounter_sampler *sampler)
+{
+	cancel_delayed_work_sync(&sampler->work);
+	kgsl_memdesc_unmap(&sampler->entry->memdesc);
+	kgsl_mem_entry_put(sampler->entry);
+	kfree(sampler);
+}
+
+/**
+ * adreno_perfcounter_sample_stop() - Stop the sampling session of an fd
+ * @adreno_dev: Adreno device
+ * @dev_priv: The fd that owns the session, NULL to stop any session
+ */
+void adreno_perfcounter_sample_stop(struct adreno_device *adreno_dev,
+		struct kgsl_device_private *dev_priv)
+{
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+	struct adreno_perfcounter_sampler *sampler;
+
+	mutex_lock(&device->mutex);
+	sampler = adreno_dev->sampler;
+	if (sampler && (dev_priv == NULL || sampler->owner == dev_priv))
+		adreno_dev->sampler = NULL;
+	else
+		sampler = NULL;
+	mutex_unlock(&device->mutex);
+
+	/* The work takes the device mutex so it has to be cancelled outside */
+	if (sampler)
+		_perfcounter_sampler_free(sampler);
+}
+
+static int _perfcounter_sampler_setup(struct adreno_device *adreno_dev,
+		struct adreno_perfcounter_sampler *sampler,
+		struct kgsl_perfcounter_read_group *list, unsigned int count)
+{
+	struct adreno_perfcounters *counters = ADRENO_PERFCOUNTERS(adreno_dev);
+	struct kgsl_memdesc *memdesc = &sampler->entry->memdesc;
+	struct kgsl_perfcounter_sample_header *header;
+	unsigned int i, j, mode, size;
+
+	mode = kgsl_memdesc_get_cachemode(memdesc);
+	if ((memdesc->flags & KGSL_MEMFLAGS_SECURE) ||
+		(mode != KGSL_CACHEMODE_UNCACHED &&
+		mode != KGSL_CACHEMODE_WRITECOMBINE))
+		return -EINVAL;
+
+	size = sizeof(struct kgsl_perfcounter_sample_entry) +
+		count * sizeof(uint64_t);
+	if (memdesc->size < sizeof(*header) + size)
+		return -EINVAL;
+
+	for (j = 0; j < count; j++) {
+		struct adreno_perfcount_group *group;
+
+		if (list[j].groupid >= counters->group_count)
+			return -EINVAL;
+
+		group = &counters->groups[list[j].groupid];
+
+		for (i = 0; i < group->reg_count; i++)
+			if (group->regs[i].countable == list[j].countable)
+				break;
+
+		/* The counter has to be reserved already */
+		if (i == group->reg_count)
+			return -EINVAL;
+
+		sampler->groupid[j] = list[j].groupid;
+		sampler->counter[j] = i;
+	}
+
+	header = kgsl_memdesc_map(memdesc);
+	if (header == NULL)
+		return -ENOMEM;
+
+	header->write_index = 0;
+	header->max_samples = (memdesc->size - sizeof(*header)) / size;
+	header->sample_size = size;
+	header->count = count;
+
+	sampler->header = header;
+	sampler->count = count;
+	return 0;
+}
+
+/**
+ * adreno_perfcounter_sample_start() - Start sampling counters periodically
+ * @dev_priv: The fd starting the session
+ * @param: Session parameters from userspace
+ *
+ * Replaces any session previously started on the same fd. Returns -EBUSY if
+ * another fd already owns the sampler.
+ */
+int adreno_perfcounter_sample_start(struct kgsl_device_private *dev_priv,
+		struct kgsl_perfcounter_sample *param)
+{
+	struct kgsl_device *device = dev_priv->device;
+	struct adreno_device *adreno_dev = ADRENO_DEVICE(device);
+	struct adreno_perfcounter_sampler *sampler;
+	struct kgsl_perfcounter_read_group *list;
+	int ret;
+
+	adreno_perfcounter_sample_stop(adreno_dev, dev_priv);
+
+	if (param->count == 0)
+		return 0;
+
+	if (ADRENO_PERFCOUNTERS(adreno_dev) == NULL ||
+		param->count > ADRENO_PERFCOUNTER_SAMPLE_MAX ||
+		param->period_us == 0)
+		return -EINVAL;
+
+	list = kmalloc_array(param->count, sizeof(*list), GFP_KERNEL);
+	if (list == NULL)
+		return -ENOMEM;
+
+	if (copy_from_user(list, to_user_ptr(param->reads),
+			param->count * sizeof(*list))) {
+		ret = -EFAULT;
+		goto free_list;
+	}
+
+	sampler = kzalloc(sizeof(*sampler), GFP_KERNEL);
+	if (sampler == NULL) {
+		ret = -ENOMEM;
+		goto free_list;
+	}
+
+	sampler->entry = kgsl_sharedmem_find_id(dev_priv->process_priv,
+		param->id);
+	if (sampler->entry == NULL) {
+		ret = -EINVAL;
+		goto free_sampler;
+	}
+
+	sampler->adreno_dev = adreno_dev;
+	sampler->owner = dev_priv;
+	sampler->period = max(usecs_to_jiffies(param->period_us), 1UL);
+	INIT_DELAYED_WORK(&sampler->work, _perfcounter_sample_work);
+
+	mutex_lock(&device->mutex);
+
+	if (adreno_dev->sampler != NULL) {
+		mutex_unlock(&device->mutex);
+		ret = -EBUSY;
+		goto put_entry;
+	}
+
+	ret = _perfcounter_sampler_setup(adreno_dev, sampler, list,
+		param->count);
+	if (ret) {
+		mutex_unlock(&device->mutex);
+		goto put_entry;
+	}
+
+	adreno_dev->sampler = sampler;
+	queue_delayed_work(kgsl_driver.workqueue, &sampler->work, 0);
+
+	mutex_unlock(&device->mutex);
+	kfree(list);
+	return 0;
+
+put_entry:
+	kgsl_mem_entry_put(sampler->entry);
+free_sampler:
+	kfree(sampler);
+free_list:
+	kfree(list);
+	return ret;
+}
@@ -112,6 +112,9 @@ struct adreno_invalid_countables {
 	[KGSL_PERFCOUNTER_GROUP_##off] = { name##_invalid_countables, \
 				ARRAY_SIZE(name##_invalid_countables) }
 
+/* Maximum number of counters in a sampling session */
+#define ADRENO_PERFCOUNTER_SAMPLE_MAX 32
+
 int adreno_perfcounter_query_group(struct adreno_device *adreno_dev,
 	unsigned int groupid, unsigned int __user *countables,
 	unsigned int count, unsigned int *max_counters);
@@ -145,4 +148,10 @@ int adreno_perfcounter_get(struct adreno_device *adreno_dev,
 int adreno_perfcounter_put(struct adreno_device *adreno_dev,
 	unsigned int groupid, unsigned int countable, unsigned int flags);
 
+int adreno_perfcounter_sample_start(struct kgsl_device_private *dev_priv,
+		struct kgsl_perfcounter_sample *param);
+
+void adreno_perfcounter_sample_stop(struct adreno_device *adreno_dev,
+		struct kgsl_device_private *dev_priv);
+
 #endif /* __ADRENO_PERFCOUNTER_H */
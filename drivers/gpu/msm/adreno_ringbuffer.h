@@ -34,6 +34,9 @@
  */
 #define KGSL_RB_DWORDS (KGSL_RB_SIZE >> 2)
 
+/* Number of log2(usec) buckets in the preemption latency histogram */
+#define ADRENO_PREEMPT_LATENCY_BUCKETS 16
+
 struct kgsl_device;
 struct kgsl_device_private;
 
@@ -111,6 +114,7 @@ struct adreno_ringbuffer_pagetable_info {
  * or how long it has been scheduled for after preempting in
  * @starve_timer_state: Indicates the state of the wait.
  * @preempt_lock: Lock to protect the wptr pointer while it is being updated
+ * @preempt_latency: Histogram of the latencies of preemptions to this RB
  */
 struct adreno_ringbuffer {
 	uint32_t flags;
@@ -147,6 +151,7 @@ struct adreno_ringbuffer {
 	 * enough.
 	 */
 	u32 profile_index;
+	unsigned int preempt_latency[ADRENO_PREEMPT_LATENCY_BUCKETS];
 };
 
 /* Returns the current ringbuffer */
@@ -696,6 +696,7 @@ kgsl_context_destroy(struct kref *kref)
 		context->id = KGSL_CONTEXT_INVALID;
 	}
 	write_unlock(&device->context_lock);
+	kgsl_event_group_set_eventfd(&context->events, -1);
 	kgsl_sync_timeline_destroy(context);
 	kgsl_process_private_put(context->proc_priv);
 
@@ -2472,7 +2473,10 @@ long kgsl_ioctl_gpuobj_import(struct kgsl_device_private *dev_priv,
 	if (ret)
 		goto out;
 
-	if (entry->memdesc.size >= SZ_1M)
+	/* Let 2MB chunks of an imported buffer get section mappings */
+	if (entry->memdesc.size >= SZ_2M)
+		kgsl_memdesc_set_align(&entry->memdesc, ilog2(SZ_2M));
+	else if (entry->memdesc.size >= SZ_1M)
 		kgsl_memdesc_set_align(&entry->memdesc, ilog2(SZ_1M));
 	else if (entry->memdesc.size >= SZ_64K)
 		kgsl_memdesc_set_align(&entry->memdesc, ilog2(SZ_64K));
@@ -3013,6 +3017,79 @@ long kgsl_ioctl_sharedmem_flush_cache(struct kgsl_device_private *dev_priv,
 	return ret;
 }
 
+static int sync_obj_cmp(const void *_a, const void *_b)
+{
+	const struct kgsl_gpuobj_sync_obj *a = _a, *b = _b;
+
+	if (a->id != b->id)
+		return (a->id > b->id) ? 1 : -1;
+	if (a->offset != b->offset)
+		return (a->offset > b->offset) ? 1 : -1;
+	return 0;
+}
+
+static inline uint64_t sync_obj_end(struct kgsl_gpuobj_sync_obj *obj)
+{
+	return (obj->length > U64_MAX - obj->offset) ?
+		U64_MAX : obj->offset + obj->length;
+}
+
+static bool sync_obj_merge(struct kgsl_gpuobj_sync_obj *prev,
+		struct kgsl_gpuobj_sync_obj *cur)
+{
+	uint64_t start, end;
+
+	if (cur->id != prev->id || ((cur->op ^ prev->op) &
+			~KGSL_GPUMEM_CACHE_RANGE))
+		return false;
+
+	/* A sync of the whole object covers everything else on it */
+	if (!(cur->op & KGSL_GPUMEM_CACHE_RANGE) ||
+		!(prev->op & KGSL_GPUMEM_CACHE_RANGE)) {
+		prev->op &= ~KGSL_GPUMEM_CACHE_RANGE;
+		return true;
+	}
+
+	/* Merge ranges that overlap or touch */
+	if (cur->offset > sync_obj_end(prev) ||
+		prev->offset > sync_obj_end(cur))
+		return false;
+
+	start = min(prev->offset, cur->offset);
+	end = max(sync_obj_end(prev), sync_obj_end(cur));
+
+	prev->offset = start;
+	prev->length = end - start;
+	return true;
+}
+
+/*
+ * Coalesce the sync requests for the same object and cache operation so that
+ * each range is only walked once. If every request uses the same operation
+ * the list is sorted first, otherwise only neighbouring requests are merged
+ * so the order of different operations on an object is kept. Returns the
+ * number of requests left.
+ */
+static unsigned int _gpuobj_sync_coalesce(struct kgsl_gpuobj_sync_obj *objs,
+		unsigned int count)
+{
+	unsigned int i, n = 0;
+
+	for (i = 1; i < count; i++)
+		if ((objs[i].op ^ objs[0].op) & ~KGSL_GPUMEM_CACHE_RANGE)
+			break;
+
+	if (i == count)
+		sort(objs, count, sizeof(*objs), sync_obj_cmp, NULL);
+
+	for (i = 1; i < count; i++) {
+		if (!sync_obj_merge(&objs[n], &objs[i]))
+			objs[++n] = objs[i];
+	}
+
+	return count ? n + 1 : 0;
+}
+
 long kgsl_ioctl_gpuobj_sync(struct kgsl_device_private *dev_priv,
 		unsigned int cmd, void *data)
 {
@@ -3023,6 +3100,7 @@ long kgsl_ioctl_gpuobj_sync(struct kgsl_device_private *dev_priv,
 	long ret = 0;
 	bool full_flush = false;
 	uint64_t size = 0;
+	unsigned int count;
 	int i;
 	void __user *ptr;
 
@@ -3047,6 +3125,12 @@ long kgsl_ioctl_gpuobj_sync(struct kgsl_device_private *dev_priv,
 		if (ret)
 			goto out;
 
+		ptr += sizeof(*objs);
+	}
+
+	count = _gpuobj_sync_coalesce(objs, param->count);
+
+	for (i = 0; i < count; i++) {
 		entries[i] = kgsl_sharedmem_find_id(private, objs[i].id);
 
 		/* Not finding the ID is not a fatal failure - just skip it */
@@ -3063,11 +3147,9 @@ long kgsl_ioctl_gpuobj_sync(struct kgsl_device_private *dev_priv,
 			trace_kgsl_mem_sync_full_cache(i, size);
 			goto out;
 		}
-
-		ptr += sizeof(*objs);
 	}
 
-	for (i = 0; !ret && i < param->count; i++)
+	for (i = 0; !ret && i < count; i++)
 		if (entries[i])
 			ret = _kgsl_gpumem_sync_cache(entries[i],
 					objs[i].offset, objs[i].length,
@@ -4585,8 +4667,10 @@ static int kgsl_mmap(struct file *file, struct vm_area_struct *vma)
 
 	vma->vm_ops = &kgsl_gpumem_vm_ops;
 
-	if (cache == KGSL_CACHEMODE_WRITEBACK
-		|| cache == KGSL_CACHEMODE_WRITETHROUGH) {
+	/* Lazy memory is populated from the fault handler instead */
+	if ((cache == KGSL_CACHEMODE_WRITEBACK
+		|| cache == KGSL_CACHEMODE_WRITETHROUGH) &&
+		!kgsl_memdesc_is_lazy(&entry->memdesc)) {
 		int i;
 		unsigned long addr = vma->vm_start;
 		struct kgsl_memdesc *m = &entry->memdesc;
@@ -199,6 +199,8 @@ struct kgsl_memdesc_ops {
 #define KGSL_MEMDESC_CONTIG BIT(8)
 /* For global buffers, randomly assign an address from the region */
 #define KGSL_MEMDESC_RANDOM BIT(9)
+/* Backing pages are allocated on the first CPU or GPU access */
+#define KGSL_MEMDESC_LAZY BIT(10)
 
 /**
  * struct kgsl_memdesc - GPU memory object descriptor
@@ -296,6 +298,7 @@ struct kgsl_mem_entry {
 
 struct kgsl_device_private;
 struct kgsl_event_group;
+struct eventfd_ctx;
 
 typedef void (*kgsl_event_func)(struct kgsl_device *, struct kgsl_event_group *,
 		void *, int);
@@ -333,12 +336,13 @@ typedef int (*readtimestamp_func)(struct kgsl_device *, void *,
  * struct event_group - A list of GPU events
  * @context: Pointer to the active context for the events
  * @lock: Spinlock for protecting the list
- * @events: List of active GPU events
+ * @events: List of active GPU events, sorted by timestamp
  * @group: Node for the master group list
  * @processed: Last processed timestamp
  * @name: String name for the group (for the debugfs file)
  * @readtimestamp: Function pointer to read a timestamp
  * @priv: Priv member to pass to the readtimestamp function
+ * @eventfd: Optional eventfd signaled when the retired timestamp advances
  */
 struct kgsl_event_group {
 	struct kgsl_context *context;
@@ -349,6 +353,7 @@ struct kgsl_event_group {
 	char name[64];
 	readtimestamp_func readtimestamp;
 	void *priv;
+	struct eventfd_ctx *eventfd;
 };
 
 /**
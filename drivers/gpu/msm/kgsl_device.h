@@ -728,6 +728,7 @@ void kgsl_events_exit(void);
 void kgsl_context_detach(struct kgsl_context *context);
 
 void kgsl_del_event_group(struct kgsl_event_group *group);
+int kgsl_event_group_set_eventfd(struct kgsl_event_group *group, int fd);
 
 void kgsl_add_event_group(struct kgsl_event_group *group,
 		struct kgsl_context *context, const char *name,
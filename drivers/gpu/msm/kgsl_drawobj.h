@@ -68,6 +68,8 @@ struct kgsl_drawobj {
  * buffer
  * @submit_ticks: Variable to hold ticks at the time of
  *     command obj submit.
+ * @submit_ktime: local_clock() at the time of command obj submit
+ * @queue_ktime: local_clock() when the command obj was queued to its context
 
  */
 struct kgsl_drawobj_cmd {
@@ -83,6 +85,8 @@ struct kgsl_drawobj_cmd {
 	uint64_t profiling_buffer_gpuaddr;
 	unsigned int profile_index;
 	uint64_t submit_ticks;
+	u64 submit_ktime;
+	u64 queue_ktime;
 };
 
 /**
@@ -15,6 +15,7 @@
 #include <linux/list.h>
 #include <linux/workqueue.h>
 #include <linux/debugfs.h>
+#include <linux/eventfd.h>
 #include <kgsl_device.h>
 
 #include "kgsl_debugfs.h"
@@ -96,20 +97,32 @@ static void _process_event_group(struct kgsl_device *device,
 
 	spin_lock(&group->lock);
 
+	/* Nobody is waiting on this group, don't bother reading the timestamp */
+	if (!flush && list_empty(&group->events) && group->eventfd == NULL)
+		goto out;
+
 	group->readtimestamp(device, group->priv, KGSL_TIMESTAMP_RETIRED,
 		&timestamp);
 
 	if (!flush && _do_process_group(group->processed, timestamp) == false)
 		goto out;
 
+	/*
+	 * The list is sorted by timestamp so stop at the first event that
+	 * hasn't expired yet unless everything is being flushed
+	 */
 	list_for_each_entry_safe(event, tmp, &group->events, node) {
 		if (timestamp_cmp(event->timestamp, timestamp) <= 0)
 			signal_event(device, event, KGSL_EVENT_RETIRED);
 		else if (flush)
 			signal_event(device, event, KGSL_EVENT_CANCELLED);
-
+		else
+			break;
 	}
 
+	if (group->eventfd != NULL && group->processed != timestamp)
+		eventfd_signal(group->eventfd, 1);
+
 	group->processed = timestamp;
 
 out:
@@ -249,7 +262,7 @@ int kgsl_add_event(struct kgsl_device *device, struct kgsl_event_group *group,
 {
 	unsigned int queued;
 	struct kgsl_context *context = group->context;
-	struct kgsl_event *event;
+	struct kgsl_event *event, *tmp;
 	unsigned int retired;
 
 	if (!func)
@@ -306,8 +319,15 @@ int kgsl_add_event(struct kgsl_device *device, struct kgsl_event_group *group,
 		return 0;
 	}
 
-	/* Add the event to the group list */
-	list_add_tail(&event->node, &group->events);
+	/*
+	 * Keep the group list sorted by timestamp. Events are almost always
+	 * added in order so start looking from the tail.
+	 */
+	list_for_each_entry_reverse(tmp, &group->events, node) {
+		if (timestamp_cmp(tmp->timestamp, timestamp) <= 0)
+			break;
+	}
+	list_add(&event->node, &tmp->node);
 
 	spin_unlock(&group->lock);
 
@@ -344,6 +364,37 @@ void kgsl_del_event_group(struct kgsl_event_group *group)
 }
 EXPORT_SYMBOL(kgsl_del_event_group);
 
+/**
+ * kgsl_event_group_set_eventfd() - Attach an eventfd to a GPU event group
+ * @group: GPU event group to attach the eventfd to
+ * @fd: eventfd file descriptor, or a negative value to detach the current one
+ *
+ * The eventfd is signaled every time the retired timestamp of the group is
+ * seen to advance, so userspace can poll it and read the timestamp from the
+ * memstore instead of sleeping in a waittimestamp ioctl.
+ */
+int kgsl_event_group_set_eventfd(struct kgsl_event_group *group, int fd)
+{
+	struct eventfd_ctx *ctx = NULL, *old;
+
+	if (fd >= 0) {
+		ctx = eventfd_ctx_fdget(fd);
+		if (IS_ERR(ctx))
+			return PTR_ERR(ctx);
+	}
+
+	spin_lock(&group->lock);
+	old = group->eventfd;
+	group->eventfd = ctx;
+	spin_unlock(&group->lock);
+
+	if (old != NULL)
+		eventfd_ctx_put(old);
+
+	return 0;
+}
+EXPORT_SYMBOL(kgsl_event_group_set_eventfd);
+
 /**
  * kgsl_add_event_group() - Add a new GPU event group
  * group: Pointer to the new group to add to the list
@@ -365,6 +416,7 @@ void kgsl_add_event_group(struct kgsl_event_group *group,
 	group->context = context;
 	group->readtimestamp = readtimestamp;
 	group->priv = priv;
+	group->eventfd = NULL;
 
 	if (name)
 		strlcpy(group->name, name, sizeof(group->name));
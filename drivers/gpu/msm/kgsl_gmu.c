@@ -467,8 +467,25 @@ int gmu_dcvs_set(struct gmu_device *gmu,
 	if (ADRENO_QUIRK(adreno_dev, ADRENO_QUIRK_HFI_USE_REG))
 		ret = gpudev->rpmh_gpu_pwrctrl(adreno_dev,
 			GMU_DCVS_NOHFI, perf_idx, bw_idx);
-	else if (test_bit(GMU_HFI_ON, &gmu->flags))
-		ret = hfi_send_dcvs_vote(gmu, perf_idx, bw_idx, ACK_NONBLOCK);
+	else if (test_bit(GMU_HFI_ON, &gmu->flags)) {
+		/*
+		 * With DCVS offloaded the requested level only becomes the
+		 * floor, the GMU steps up from there on its own up to the
+		 * current thermal/user limit.
+		 */
+		if (gmu->dcvs_offload && perf_idx != INVALID_DCVS_IDX) {
+			ret = hfi_send_dcvs_bounds(gmu, perf_idx,
+				gmu->num_gpupwrlevels -
+				device->pwrctrl.max_pwrlevel - 1,
+				ACK_NONBLOCK);
+			perf_idx = INVALID_DCVS_IDX;
+		}
+
+		if (!ret && (perf_idx != INVALID_DCVS_IDX ||
+				bw_idx != INVALID_DCVS_IDX))
+			ret = hfi_send_dcvs_vote(gmu, perf_idx, bw_idx,
+				ACK_NONBLOCK);
+	}
 
 	if (ret) {
 		dev_err_ratelimited(&gmu->pdev->dev,
@@ -1234,6 +1251,8 @@ int gmu_probe(struct kgsl_device *device)
 
 	hfi_init(&gmu->hfi, mem_addr, HFI_QUEUE_SIZE);
 
+	gmu->dcvs_offload = of_property_read_bool(node, "qcom,gmu-dcvs-offload");
+
 	/* Set up GMU idle states */
 	if (ADRENO_FEATURE(adreno_dev, ADRENO_MIN_VOLT))
 		gmu->idle_level = GPU_HW_MIN_VOLT;
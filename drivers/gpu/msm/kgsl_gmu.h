@@ -220,6 +220,7 @@ enum gpu_idle_level {
  * @idle_level: Minimal GPU idle power level
  * @fault_count: GMU fault count
  * @unrecovered: Indicates whether GMU recovery failed or not
+ * @dcvs_offload: GMU steps the GPU frequency itself, KGSL only sets bounds
  */
 struct gmu_device {
 	unsigned int ver;
@@ -255,6 +256,7 @@ struct gmu_device {
 	unsigned int idle_level;
 	unsigned int fault_count;
 	bool unrecovered;
+	bool dcvs_offload;
 };
 
 void gmu_snapshot(struct kgsl_device *device);
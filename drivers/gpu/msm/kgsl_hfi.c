@@ -449,6 +449,57 @@ static int hfi_send_bwtbl(struct gmu_device *gmu)
 	return rc;
 }
 
+/*
+ * The down threshold of a level is the busy percentage that would reach the
+ * up threshold of the next lower level once the work is run slower, minus
+ * a hysteresis margin so the GMU doesn't bounce between two levels.
+ */
+static int hfi_send_gpu_dcvs_tbl(struct gmu_device *gmu)
+{
+	struct hfi_gpu_dcvs_tbl_cmd dcvstbl = {
+		.hdr = {
+			.id = H2F_MSG_GPU_DCVS_TBL,
+			.size = sizeof(dcvstbl) >> 2,
+			.type = HFI_MSG_CMD,
+		},
+		.level_num = gmu->num_gpupwrlevels,
+		.sample_us = GMU_DCVS_SAMPLE_US,
+		.up_samples = GMU_DCVS_UP_SAMPLES,
+		.down_samples = GMU_DCVS_DOWN_SAMPLES,
+	};
+	struct hfi_msg_rsp *rsp;
+	struct pending_msg msg;
+	uint32_t msg_size_dwords = (sizeof(dcvstbl)) >> 2;
+	int i, rc = 0;
+
+	for (i = 0; i < gmu->num_gpupwrlevels; i++) {
+		uint64_t down = 0;
+
+		dcvstbl.steps[i].up_pct = GMU_DCVS_UP_THRESHOLD;
+
+		if (i > 0 && gmu->gpu_freqs[i]) {
+			down = div_u64((uint64_t)GMU_DCVS_UP_THRESHOLD *
+					gmu->gpu_freqs[i - 1],
+					gmu->gpu_freqs[i]);
+			down = down > GMU_DCVS_HYSTERESIS ?
+				down - GMU_DCVS_HYSTERESIS : 0;
+		}
+
+		dcvstbl.steps[i].down_pct = (uint32_t)down;
+	}
+
+	rc = hfi_send_msg(gmu, &dcvstbl.hdr, msg_size_dwords, &msg);
+	if (rc)
+		return rc;
+
+	rsp = (struct hfi_msg_rsp *)&msg.results;
+	rc = rsp->error;
+	if (rc)
+		dev_err(&gmu->pdev->dev,
+			"gmu send gpu dcvs table failed with error=%d\n", rc);
+	return rc;
+}
+
 static int hfi_send_test(struct gmu_device *gmu)
 {
 	struct hfi_test_cmd test_msg = {
@@ -501,6 +552,43 @@ int hfi_send_dcvs_vote(struct gmu_device *gmu, uint32_t perf_idx,
 	return rc;
 }
 
+/**
+ * hfi_send_dcvs_bounds() - Limit the GX levels the GMU may pick on its own
+ * @gmu: Pointer to GMU device
+ * @min_perf_idx: Lowest GX level index the GMU may step down to
+ * @max_perf_idx: Highest GX level index the GMU may step up to
+ * @ack_type: Whether to wait for the RPMh vote to complete
+ */
+int hfi_send_dcvs_bounds(struct gmu_device *gmu, uint32_t min_perf_idx,
+		uint32_t max_perf_idx, enum rpm_ack_type ack_type)
+{
+	struct hfi_dcvs_bounds_cmd bounds_cmd = {
+		.hdr = {
+			.id = H2F_MSG_DCVS_BOUNDS,
+			.size = sizeof(bounds_cmd) >> 2,
+			.type = HFI_MSG_CMD,
+		},
+		.ack_type = ack_type,
+		.min_perf_idx = min_perf_idx,
+		.max_perf_idx = max_perf_idx,
+	};
+	struct hfi_msg_rsp *rsp;
+	uint32_t msg_size_dwords = (sizeof(bounds_cmd)) >> 2;
+	int rc = 0;
+	struct pending_msg msg;
+
+	rc = hfi_send_msg(gmu, &bounds_cmd.hdr, msg_size_dwords, &msg);
+	if (rc)
+		return rc;
+
+	rsp = (struct hfi_msg_rsp *)&msg.results;
+	rc = rsp->error;
+	if (rc)
+		dev_err(&gmu->pdev->dev,
+			"gmu send dcvs bounds failed with error=%d\n", rc);
+	return rc;
+}
+
 int hfi_notify_slumber(struct gmu_device *gmu,
 		uint32_t init_perf_idx, uint32_t init_bw_idx)
 {
@@ -611,6 +699,15 @@ int hfi_start(struct gmu_device *gmu, uint32_t boot_state)
 	if (result)
 		return result;
 
+	/*
+	 * Fall back to voting for every frequency change from the CPU if the
+	 * firmware doesn't take the table
+	 */
+	if (gmu->dcvs_offload && hfi_send_gpu_dcvs_tbl(gmu)) {
+		dev_err(dev, "GMU DCVS not supported, disabling offload\n");
+		gmu->dcvs_offload = false;
+	}
+
 	/* Tell the GMU we are sending no more HFIs until the next boot */
 	if (ADRENO_QUIRK(adreno_dev, ADRENO_QUIRK_HFI_USE_REG)) {
 		result = hfi_send_test(gmu);
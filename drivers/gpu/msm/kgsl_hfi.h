@@ -132,8 +132,10 @@ enum hfi_msg_id {
 	H2F_MSG_BW_VOTE_TBL = 3,
 	H2F_MSG_PERF_TBL = 4,
 	H2F_MSG_TEST = 5,
+	H2F_MSG_GPU_DCVS_TBL = 6,
 	H2F_MSG_DCVS_VOTE = 30,
 	H2F_MSG_FW_HALT = 31,
+	H2F_MSG_DCVS_BOUNDS = 32,
 	H2F_MSG_PREPARE_SLUMBER = 33,
 	F2H_MSG_ERR  = 100,
 	F2H_MSG_GMU_CNTR_REGISTER = 101,
@@ -293,6 +295,39 @@ struct hfi_dcvs_cmd {
 	struct gpu_bw_vote bw;
 };
 
+/* Defaults for the GMU DCVS table */
+#define GMU_DCVS_SAMPLE_US	4000
+#define GMU_DCVS_UP_THRESHOLD	80
+#define GMU_DCVS_HYSTERESIS	10
+#define GMU_DCVS_UP_SAMPLES	1
+#define GMU_DCVS_DOWN_SAMPLES	3
+
+/*
+ * Busy percentage thresholds for one GX level. The GMU steps up a level once
+ * the busy percentage was above up_pct for up_samples consecutive samples,
+ * and down a level once it was below down_pct for down_samples.
+ */
+struct gpu_dcvs_step {
+	uint32_t up_pct;
+	uint32_t down_pct;
+};
+
+struct hfi_gpu_dcvs_tbl_cmd {
+	struct hfi_msg_hdr hdr;
+	uint32_t level_num;
+	uint32_t sample_us;
+	uint32_t up_samples;
+	uint32_t down_samples;
+	struct gpu_dcvs_step steps[MAX_GX_LEVELS];
+};
+
+struct hfi_dcvs_bounds_cmd {
+	struct hfi_msg_hdr hdr;
+	uint32_t ack_type;
+	uint32_t min_perf_idx;
+	uint32_t max_perf_idx;
+};
+
 struct hfi_prep_slumber_cmd {
 	struct hfi_msg_hdr hdr;
 	uint32_t init_bw_idx;
@@ -361,4 +396,6 @@ int hfi_send_dcvs_vote(struct gmu_device *gmu, uint32_t perf_idx,
 int hfi_notify_slumber(struct gmu_device *gmu, uint32_t init_perf_idx,
 		uint32_t init_bw_idx);
 int hfi_send_lmconfig(struct gmu_device *gmu);
+int hfi_send_dcvs_bounds(struct gmu_device *gmu, uint32_t min_perf_idx,
+		uint32_t max_perf_idx, enum rpm_ack_type ack_type);
 #endif  /* __KGSL_HFI_H */
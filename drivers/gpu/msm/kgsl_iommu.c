@@ -760,6 +760,33 @@ static bool kgsl_iommu_suppress_pagefault(uint64_t faultaddr, int write,
 	return kgsl_iommu_uche_overfetch(context->proc_priv, faultaddr);
 }
 
+/*
+ * Back the faulting page of a lazily allocated buffer. Returns true if the
+ * stalled transaction can be retried against the new mapping.
+ */
+static bool kgsl_iommu_lazy_fault(struct kgsl_context *context,
+		uint64_t faultaddr, int flags)
+{
+	struct kgsl_mem_entry *entry;
+	int ret = -EINVAL;
+
+	if (!context || !(flags & IOMMU_FAULT_TRANSLATION) ||
+		!(flags & IOMMU_FAULT_TRANSACTION_STALLED))
+		return false;
+
+	entry = kgsl_sharedmem_find(context->proc_priv, faultaddr);
+	if (entry == NULL)
+		return false;
+
+	if (kgsl_memdesc_is_lazy(&entry->memdesc))
+		ret = kgsl_memdesc_lazy_populate(&entry->memdesc,
+				faultaddr - entry->memdesc.gpuaddr, 1);
+
+	kgsl_mem_entry_put(entry);
+
+	return ret == 0;
+}
+
 static int kgsl_iommu_fault_handler(struct iommu_domain *domain,
 	struct device *dev, unsigned long addr, int flags, void *token)
 {
@@ -811,6 +838,12 @@ static int kgsl_iommu_fault_handler(struct iommu_domain *domain,
 
 	context = kgsl_context_get(device, curr_context_id);
 
+	/* Not a fault, just the first GPU access to a lazy buffer */
+	if (kgsl_iommu_lazy_fault(context, addr, flags)) {
+		kgsl_context_put(context);
+		return -EAGAIN;
+	}
+
 	write = (flags & IOMMU_FAULT_WRITE) ? 1 : 0;
 	if (flags & IOMMU_FAULT_TRANSLATION)
 		fault_type = "translation";
@@ -1666,6 +1699,10 @@ static int _setup_user_context(struct kgsl_mmu *mmu)
 		sctlr_val &= ~(0x1 << KGSL_IOMMU_SCTLR_CFCFG_SHIFT);
 		sctlr_val |= (0x1 << KGSL_IOMMU_SCTLR_HUPCF_SHIFT);
 	}
+
+	/* Lazily allocated buffers rely on stalled transactions being retried */
+	if (kgsl_sharedmem_lazy_enabled())
+		sctlr_val |= (0x1 << KGSL_IOMMU_SCTLR_CFCFG_SHIFT);
 	KGSL_IOMMU_SET_CTX_REG(ctx, SCTLR, sctlr_val);
 	kgsl_iommu_disable_clk(mmu);
 
@@ -1749,12 +1786,40 @@ kgsl_iommu_unmap_offset(struct kgsl_pagetable *pt,
 	return _iommu_unmap_sync_pc(pt, addr + offset, size);
 }
 
+/*
+ * A lazy memdesc is only mapped where it has been populated. Unmap it chunk
+ * by chunk, below @end, since unmapping stops at the first hole.
+ */
+static void _iommu_unmap_lazy(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc *memdesc, uint64_t end)
+{
+	uint64_t offset;
+
+	for (offset = 0; offset < end; offset += KGSL_LAZY_CHUNK) {
+		if (memdesc->pages[offset >> PAGE_SHIFT] == NULL)
+			continue;
+
+		_iommu_unmap_sync_pc(pt, memdesc->gpuaddr + offset,
+			min_t(uint64_t, KGSL_LAZY_CHUNK, end - offset));
+	}
+}
+
 static int
 kgsl_iommu_unmap(struct kgsl_pagetable *pt, struct kgsl_memdesc *memdesc)
 {
 	if (memdesc->size == 0 || memdesc->gpuaddr == 0)
 		return -EINVAL;
 
+	if (kgsl_memdesc_is_lazy(memdesc)) {
+		_iommu_unmap_lazy(pt, memdesc, memdesc->size);
+
+		if (kgsl_memdesc_has_guard_page(memdesc))
+			_iommu_unmap_sync_pc(pt,
+				memdesc->gpuaddr + memdesc->size,
+				kgsl_memdesc_guard_page_size(memdesc));
+		return 0;
+	}
+
 	return kgsl_iommu_unmap_offset(pt, memdesc, memdesc->gpuaddr, 0,
 			kgsl_memdesc_footprint(memdesc));
 }
@@ -1833,6 +1898,58 @@ static unsigned int _get_protection_flags(struct kgsl_memdesc *memdesc)
 	return flags;
 }
 
+static int kgsl_iommu_map_lazy(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc *memdesc, uint64_t offset, uint64_t size)
+{
+	struct sg_table sgt;
+	int ret;
+
+	ret = sg_alloc_table_from_pages(&sgt,
+			memdesc->pages + (offset >> PAGE_SHIFT),
+			size >> PAGE_SHIFT, 0, size, GFP_KERNEL);
+	if (ret)
+		return ret;
+
+	ret = _iommu_map_sg_sync_pc(pt, memdesc->gpuaddr + offset, sgt.sgl,
+			sgt.nents, _get_protection_flags(memdesc));
+
+	sg_free_table(&sgt);
+
+	return ret;
+}
+
+/*
+ * Only map the chunks of a lazy memdesc that already have pages, the rest
+ * is mapped by the pagefault handler on the first GPU access.
+ */
+static int _iommu_map_lazy(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc *memdesc)
+{
+	uint64_t offset;
+	int ret;
+
+	for (offset = 0; offset < memdesc->size; offset += KGSL_LAZY_CHUNK) {
+		if (memdesc->pages[offset >> PAGE_SHIFT] == NULL)
+			continue;
+
+		ret = kgsl_iommu_map_lazy(pt, memdesc, offset,
+			min_t(uint64_t, KGSL_LAZY_CHUNK,
+				memdesc->size - offset));
+		if (ret) {
+			_iommu_unmap_lazy(pt, memdesc, offset);
+			return ret;
+		}
+	}
+
+	ret = _iommu_map_guard_page(pt, memdesc,
+			memdesc->gpuaddr + memdesc->size,
+			_get_protection_flags(memdesc));
+	if (ret)
+		_iommu_unmap_lazy(pt, memdesc, memdesc->size);
+
+	return ret;
+}
+
 static int
 kgsl_iommu_map(struct kgsl_pagetable *pt,
 			struct kgsl_memdesc *memdesc)
@@ -1843,6 +1960,9 @@ kgsl_iommu_map(struct kgsl_pagetable *pt,
 	unsigned int flags = _get_protection_flags(memdesc);
 	struct sg_table *sgt = NULL;
 
+	if (kgsl_memdesc_is_lazy(memdesc))
+		return _iommu_map_lazy(pt, memdesc);
+
 	/*
 	 * For paged memory allocated through kgsl, memdesc->pages is not NULL.
 	 * Allocate sgt here just for its map operation. Contiguous memory
@@ -1856,6 +1976,11 @@ kgsl_iommu_map(struct kgsl_pagetable *pt,
 	if (IS_ERR(sgt))
 		return PTR_ERR(sgt);
 
+	/*
+	 * Physically contiguous pages are merged into a single sg entry, so
+	 * a 2MB page at a 2MB aligned GPU address is mapped as a section
+	 * rather than 512 individual PTEs.
+	 */
 	ret = _iommu_map_sg_sync_pc(pt, addr, sgt->sgl, sgt->nents, flags);
 	if (ret)
 		goto done;
@@ -2194,6 +2319,9 @@ static int kgsl_iommu_set_pf_policy(struct kgsl_mmu *mmu,
 			sctlr_val |= (0x1 << KGSL_IOMMU_SCTLR_HUPCF_SHIFT);
 		}
 
+		if (kgsl_sharedmem_lazy_enabled())
+			sctlr_val |= (0x1 << KGSL_IOMMU_SCTLR_CFCFG_SHIFT);
+
 		KGSL_IOMMU_SET_CTX_REG(ctx, SCTLR, sctlr_val);
 
 		kgsl_iommu_disable_clk(mmu);
@@ -2660,6 +2788,7 @@ static const struct {
 	{ "qcom,global_pt", KGSL_MMU_GLOBAL_PAGETABLE },
 	{ "qcom,hyp_secure_alloc", KGSL_MMU_HYP_SECURE_ALLOC },
 	{ "qcom,force-32bit", KGSL_MMU_FORCE_32BIT },
+	{ "qcom,asid-tlb", KGSL_MMU_ASID_TLB },
 };
 
 static int _kgsl_iommu_probe(struct kgsl_device *device,
@@ -2805,4 +2934,5 @@ static struct kgsl_mmu_pt_ops iommu_pt_ops = {
 	.mmu_map_offset = kgsl_iommu_map_offset,
 	.mmu_unmap_offset = kgsl_iommu_unmap_offset,
 	.mmu_sparse_dummy_map = kgsl_iommu_sparse_dummy_map,
+	.mmu_map_lazy = kgsl_iommu_map_lazy,
 };
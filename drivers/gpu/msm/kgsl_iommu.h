@@ -50,6 +50,10 @@
 #define KGSL_IOMMU_SVM_BASE64		0x700000000ULL
 #define KGSL_IOMMU_SVM_END64		0x800000000ULL
 
+/* ASID field of TTBR0 */
+#define KGSL_IOMMU_TTBR0_ASID_SHIFT	48
+#define KGSL_IOMMU_TTBR0_ASID_MASK	0xFF
+
 /* TLBSTATUS register fields */
 #define KGSL_IOMMU_CTX_TLBSTATUS_SACTIVE BIT(0)
 
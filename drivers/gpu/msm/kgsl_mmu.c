@@ -577,6 +577,27 @@ int kgsl_mmu_sparse_dummy_map(struct kgsl_pagetable *pagetable,
 }
 EXPORT_SYMBOL(kgsl_mmu_sparse_dummy_map);
 
+/**
+ * kgsl_mmu_map_lazy() - Map newly populated pages of a lazy memdesc
+ * @pagetable: Pagetable the memdesc is mapped in
+ * @memdesc: Lazily populated memory descriptor
+ * @offset: Offset of the populated range in the memdesc
+ * @size: Size of the populated range
+ *
+ * The range was already accounted for when the memdesc was mapped, so the
+ * pagetable statistics are left alone.
+ */
+int kgsl_mmu_map_lazy(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc, uint64_t offset, uint64_t size)
+{
+	if (PT_OP_VALID(pagetable, mmu_map_lazy))
+		return pagetable->pt_ops->mmu_map_lazy(pagetable, memdesc,
+				offset, size);
+
+	return 0;
+}
+EXPORT_SYMBOL(kgsl_mmu_map_lazy);
+
 void kgsl_mmu_remove_global(struct kgsl_device *device,
 		struct kgsl_memdesc *memdesc)
 {
@@ -113,6 +113,9 @@ struct kgsl_mmu_pt_ops {
 	int (*mmu_sparse_dummy_map)(struct kgsl_pagetable *pt,
 			struct kgsl_memdesc *memdesc, uint64_t offset,
 			uint64_t size);
+	int (*mmu_map_lazy)(struct kgsl_pagetable *pt,
+			struct kgsl_memdesc *memdesc, uint64_t offset,
+			uint64_t size);
 };
 
 /*
@@ -134,6 +137,8 @@ struct kgsl_mmu_pt_ops {
 #define KGSL_MMU_FORCE_32BIT BIT(5)
 /* 64 bit address is live */
 #define KGSL_MMU_64BIT BIT(6)
+/* TLB entries are tagged with the pagetable ASID */
+#define KGSL_MMU_ASID_TLB BIT(7)
 /* The MMU supports non-contigious pages */
 #define KGSL_MMU_PAGED BIT(8)
 /* The device requires a guard page */
@@ -244,6 +249,8 @@ struct kgsl_memdesc *kgsl_mmu_get_qtimer_global_entry(
 
 int kgsl_mmu_sparse_dummy_map(struct kgsl_pagetable *pagetable,
 		struct kgsl_memdesc *memdesc, uint64_t offset, uint64_t size);
+int kgsl_mmu_map_lazy(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc, uint64_t offset, uint64_t size);
 
 /*
  * Static inline functions of MMU that simply call the SMMU specific
@@ -16,15 +16,19 @@
 #include <linux/slab.h>
 #include <linux/highmem.h>
 #include <linux/version.h>
+#include <linux/workqueue.h>
 
 #include "kgsl.h"
 #include "kgsl_device.h"
 #include "kgsl_pool.h"
 
 #define KGSL_MAX_POOLS 4
-#define KGSL_MAX_POOL_ORDER 8
+#define KGSL_MAX_POOL_ORDER 9
 #define KGSL_MAX_RESERVED_PAGES 4096
 
+/* Grow a pool once more than this percentage of its allocations miss */
+#define KGSL_POOL_MISS_PCT 10
+
 /**
  * struct kgsl_page_pool - Structure to hold information for the pool
  * @pool_order: Page order describing the size of the page
@@ -34,6 +38,11 @@
  * from system memory
  * @list_lock: Spinlock for page list in the pool
  * @page_list: List of pages held/reserved in this pool
+ * @dirty_count: Number of freed pages waiting to be zeroed
+ * @dirty_list: List of freed pages waiting to be zeroed
+ * @target_pages: Autotuned number of pages to keep in the pool
+ * @hits: Allocations served by the pool in the current autotune period
+ * @misses: Allocations that found the pool empty in the current period
  */
 struct kgsl_page_pool {
 	unsigned int pool_order;
@@ -42,12 +51,33 @@ struct kgsl_page_pool {
 	bool allocation_allowed;
 	spinlock_t list_lock;
 	struct list_head page_list;
+	int dirty_count;
+	struct list_head dirty_list;
+	unsigned int target_pages;
+	atomic_t hits;
+	atomic_t misses;
 };
 
 static struct kgsl_page_pool kgsl_pools[KGSL_MAX_POOLS];
 static int kgsl_num_pools;
 static int kgsl_pool_max_pages;
 
+/* Zero freed pages from a low priority worker instead of at free time */
+static bool kgsl_pool_deferred_zero = true;
+module_param_named(pool_deferred_zero, kgsl_pool_deferred_zero, bool, 0644);
+
+/* Resize pool reserves from the recent allocation miss rate */
+static bool kgsl_pool_autotune;
+module_param_named(pool_autotune, kgsl_pool_autotune, bool, 0644);
+
+static unsigned int kgsl_pool_autotune_ms = 1000;
+module_param_named(pool_autotune_ms, kgsl_pool_autotune_ms, uint, 0644);
+
+static struct workqueue_struct *kgsl_pool_wq;
+static void kgsl_pool_zero_worker(struct work_struct *work);
+static DECLARE_WORK(kgsl_pool_zero_work, kgsl_pool_zero_worker);
+static void kgsl_pool_tune_worker(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(kgsl_pool_tune_work, kgsl_pool_tune_worker);
 
 /* Returns KGSL pool corresponding to input page order*/
 static struct kgsl_page_pool *
@@ -91,7 +121,44 @@ _kgsl_pool_add_page(struct kgsl_page_pool *pool, struct page *p)
 	spin_unlock(&pool->list_lock);
 }
 
-/* Returns a page from specified pool */
+/*
+ * Add a freed page to specified pool, leaving the zeroing to
+ * kgsl_pool_zero_worker() when deferred zeroing is enabled
+ */
+static void
+_kgsl_pool_add_dirty_page(struct kgsl_page_pool *pool, struct page *p)
+{
+	if (!kgsl_pool_wq || !READ_ONCE(kgsl_pool_deferred_zero)) {
+		_kgsl_pool_add_page(pool, p);
+		return;
+	}
+
+	spin_lock(&pool->list_lock);
+	list_add_tail(&p->lru, &pool->dirty_list);
+	pool->dirty_count++;
+	spin_unlock(&pool->list_lock);
+
+	queue_work(kgsl_pool_wq, &kgsl_pool_zero_work);
+}
+
+/* Returns a page that still needs zeroing from specified pool */
+static struct page *
+_kgsl_pool_get_dirty_page(struct kgsl_page_pool *pool)
+{
+	struct page *p = NULL;
+
+	spin_lock(&pool->list_lock);
+	if (pool->dirty_count) {
+		p = list_first_entry(&pool->dirty_list, struct page, lru);
+		pool->dirty_count--;
+		list_del(&p->lru);
+	}
+	spin_unlock(&pool->list_lock);
+
+	return p;
+}
+
+/* Returns a zeroed page from specified pool */
 static struct page *
 _kgsl_pool_get_page(struct kgsl_page_pool *pool)
 {
@@ -115,7 +182,8 @@ kgsl_pool_size(struct kgsl_page_pool *kgsl_pool)
 	int size;
 
 	spin_lock(&kgsl_pool->list_lock);
-	size = kgsl_pool->page_count * (1 << kgsl_pool->pool_order);
+	size = (kgsl_pool->page_count + kgsl_pool->dirty_count) *
+		(1 << kgsl_pool->pool_order);
 	spin_unlock(&kgsl_pool->list_lock);
 
 	return size;
@@ -146,7 +214,11 @@ _kgsl_pool_shrink(struct kgsl_page_pool *pool, int num_pages)
 		return pcount;
 
 	for (j = 0; j < num_pages >> pool->pool_order; j++) {
-		struct page *page = _kgsl_pool_get_page(pool);
+		/* Pages not zeroed yet are the cheapest to give back */
+		struct page *page = _kgsl_pool_get_dirty_page(pool);
+
+		if (page == NULL)
+			page = _kgsl_pool_get_page(pool);
 
 		if (page != NULL) {
 			__free_pages(page, pool->pool_order);
@@ -265,6 +337,12 @@ void kgsl_pool_free_pages(struct page **pages, unsigned int pcount)
 		 */
 		struct page *p = pages[i];
 
+		/* Lazily allocated memory may not be fully populated */
+		if (p == NULL) {
+			i++;
+			continue;
+		}
+
 		i += 1 << compound_order(p);
 		kgsl_pool_free_page(p);
 	}
@@ -357,6 +435,18 @@ int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 	pool_idx = kgsl_pool_idx_lookup(order);
 	page = _kgsl_pool_get_page(pool);
 
+	/* Zeroing a pooled page is still cheaper than going to the system */
+	if (page == NULL) {
+		page = _kgsl_pool_get_dirty_page(pool);
+		if (page != NULL)
+			_kgsl_pool_zero_page(page, order);
+	}
+
+	if (page != NULL)
+		atomic_inc(&pool->hits);
+	else
+		atomic_inc(&pool->misses);
+
 	/* Allocate a new page if not allocated from pool */
 	if (page == NULL) {
 		gfp_t gfp_mask = kgsl_gfp_mask(order);
@@ -413,7 +503,7 @@ void kgsl_pool_free_page(struct page *page)
 			(kgsl_pool_size_total() < kgsl_pool_max_pages)) {
 		pool = _kgsl_get_pool_from_order(page_order);
 		if (pool != NULL) {
-			_kgsl_pool_add_page(pool, page);
+			_kgsl_pool_add_dirty_page(pool, page);
 			return;
 		}
 	}
@@ -458,6 +548,95 @@ static void kgsl_pool_reserve_pages(void)
 	}
 }
 
+static void kgsl_pool_zero_worker(struct work_struct *work)
+{
+	long nice = task_nice(current);
+	int i;
+
+	/* Zeroing is background work, leave the CPU to everyone else */
+	set_user_nice(current, MAX_NICE);
+
+	for (i = 0; i < kgsl_num_pools; i++) {
+		struct kgsl_page_pool *pool = &kgsl_pools[i];
+		struct page *page;
+
+		while ((page = _kgsl_pool_get_dirty_page(pool)) != NULL) {
+			_kgsl_pool_add_page(pool, page);
+			cond_resched();
+		}
+	}
+
+	set_user_nice(current, nice);
+}
+
+/*
+ * Adjust the target size of a pool from the allocations seen during the
+ * last period: grow by the number of misses if they exceed
+ * KGSL_POOL_MISS_PCT of all allocations, or decay back towards the DT
+ * reserve after a period without misses. Only pools that the shrinker
+ * may reduce are grown beyond their reserve.
+ */
+static void kgsl_pool_tune(struct kgsl_page_pool *pool)
+{
+	unsigned int hits = atomic_xchg(&pool->hits, 0);
+	unsigned int misses = atomic_xchg(&pool->misses, 0);
+	unsigned int target = pool->target_pages;
+	unsigned int max_target = max(pool->reserved_pages,
+			KGSL_MAX_RESERVED_PAGES >> pool->pool_order);
+
+	if (!pool->allocation_allowed)
+		return;
+
+	if (misses * 100 > (hits + misses) * KGSL_POOL_MISS_PCT)
+		target = min(target + misses, max_target);
+	else if (!misses && target > pool->reserved_pages)
+		target -= DIV_ROUND_UP(target - pool->reserved_pages, 8);
+
+	pool->target_pages = target;
+}
+
+/* Top up a pool to its target without entering reclaim */
+static void kgsl_pool_refill(struct kgsl_page_pool *pool)
+{
+	unsigned int order = pool->pool_order;
+	gfp_t gfp_mask = (kgsl_gfp_mask(order) & ~__GFP_RECLAIM) |
+			 __GFP_NORETRY | __GFP_NOWARN;
+	struct page *page;
+
+	while (kgsl_pool_size(pool) >> order < pool->target_pages) {
+		if (kgsl_pool_max_pages &&
+			kgsl_pool_size_total() >= kgsl_pool_max_pages)
+			break;
+
+		page = alloc_pages(gfp_mask, order);
+		if (page == NULL)
+			break;
+
+		_kgsl_pool_add_page(pool, page);
+		cond_resched();
+	}
+}
+
+static void kgsl_pool_tune_worker(struct work_struct *work)
+{
+	long nice = task_nice(current);
+	int i;
+
+	if (READ_ONCE(kgsl_pool_autotune)) {
+		set_user_nice(current, MAX_NICE);
+
+		for (i = 0; i < kgsl_num_pools; i++) {
+			kgsl_pool_tune(&kgsl_pools[i]);
+			kgsl_pool_refill(&kgsl_pools[i]);
+		}
+
+		set_user_nice(current, nice);
+	}
+
+	queue_delayed_work(kgsl_pool_wq, &kgsl_pool_tune_work,
+			msecs_to_jiffies(max(kgsl_pool_autotune_ms, 100U)));
+}
+
 /* Functions for the shrinker */
 
 static unsigned long
@@ -507,8 +686,10 @@ static void kgsl_pool_config(unsigned int order, unsigned int reserved_pages,
 	kgsl_pools[kgsl_num_pools].pool_order = order;
 	kgsl_pools[kgsl_num_pools].reserved_pages = reserved_pages;
 	kgsl_pools[kgsl_num_pools].allocation_allowed = allocation_allowed;
+	kgsl_pools[kgsl_num_pools].target_pages = reserved_pages;
 	spin_lock_init(&kgsl_pools[kgsl_num_pools].list_lock);
 	INIT_LIST_HEAD(&kgsl_pools[kgsl_num_pools].page_list);
+	INIT_LIST_HEAD(&kgsl_pools[kgsl_num_pools].dirty_list);
 	kgsl_num_pools++;
 }
 
@@ -566,10 +747,27 @@ void kgsl_init_page_pools(struct platform_device *pdev)
 
 	/* Initialize shrinker */
 	register_shrinker(&kgsl_pool_shrinker);
+
+	if (!kgsl_num_pools)
+		return;
+
+	/* Without the workqueue pages are zeroed at free and never tuned */
+	kgsl_pool_wq = alloc_workqueue("kgsl-pool",
+			WQ_UNBOUND | WQ_FREEZABLE, 1);
+	if (kgsl_pool_wq)
+		queue_delayed_work(kgsl_pool_wq, &kgsl_pool_tune_work,
+				msecs_to_jiffies(kgsl_pool_autotune_ms));
 }
 
 void kgsl_exit_page_pools(void)
 {
+	if (kgsl_pool_wq) {
+		cancel_delayed_work_sync(&kgsl_pool_tune_work);
+		cancel_work_sync(&kgsl_pool_zero_work);
+		destroy_workqueue(kgsl_pool_wq);
+		kgsl_pool_wq = NULL;
+	}
+
 	/* Release all pages in pools, if any.*/
 	kgsl_pool_reduce(0, true);
 
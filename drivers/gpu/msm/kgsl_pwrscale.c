@@ -109,6 +109,30 @@ void kgsl_pwrscale_busy(struct kgsl_device *device)
 }
 EXPORT_SYMBOL(kgsl_pwrscale_busy);
 
+/*
+ * kgsl_pwrscale_frame_done - report a completed frame to the governor
+ * @device: The device
+ * @busy_ns: GPU time spent on the frame
+ *
+ * Used by frame deadline based governors, which consume and reset the
+ * frame statistics on every sample.
+ */
+void kgsl_pwrscale_frame_done(struct kgsl_device *device, u64 busy_ns)
+{
+	struct devfreq_msm_adreno_tz_data *data =
+		device->pwrscale.gpu_profile.private_data;
+	unsigned long flags;
+
+	if (!device->pwrscale.enabled || !data)
+		return;
+
+	spin_lock_irqsave(&data->frame.lock, flags);
+	data->frame.max_ns = max(data->frame.max_ns, busy_ns);
+	data->frame.nr++;
+	spin_unlock_irqrestore(&data->frame.lock, flags);
+}
+EXPORT_SYMBOL(kgsl_pwrscale_frame_done);
+
 /**
  * kgsl_pwrscale_update_stats() - update device busy statistics
  * @device: The device
@@ -805,6 +829,8 @@ int kgsl_pwrscale_init(struct device *dev, const char *governor)
 	/* initialize msm-adreno-tz governor specific data here */
 	data = gpu_profile->private_data;
 
+	spin_lock_init(&data->frame.lock);
+
 	data->disable_busy_time_burst = of_property_read_bool(
 		device->pdev->dev.of_node, "qcom,disable-busy-time-burst");
 
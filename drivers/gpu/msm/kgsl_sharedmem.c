@@ -12,6 +12,7 @@
  */
 
 #include <linux/export.h>
+#include <linux/moduleparam.h>
 #include <linux/vmalloc.h>
 #include <asm/cacheflush.h>
 #include <linux/slab.h>
@@ -37,8 +38,20 @@
 
 static bool sharedmem_noretry_flag;
 
+/*
+ * User allocations of at least this many bytes only get their backing pages
+ * on the first CPU or GPU access to each KGSL_LAZY_CHUNK. GPU accesses are
+ * caught by stalling the faulting transaction in the IOMMU, so this can only
+ * be set at boot. Zero disables lazy allocation.
+ */
+static unsigned int kgsl_lazy_alloc_size;
+module_param_named(lazy_alloc_size, kgsl_lazy_alloc_size, uint, 0444);
+
 static DEFINE_MUTEX(kernel_map_global_lock);
 
+/* Serializes populating lazily allocated memory */
+static DEFINE_MUTEX(lazy_populate_lock);
+
 struct cp2_mem_chunks {
 	unsigned int chunk_list;
 	unsigned int chunk_list_size;
@@ -439,6 +452,10 @@ static int kgsl_page_alloc_vmfault(struct kgsl_memdesc *memdesc,
 
 	pgoff = offset >> PAGE_SHIFT;
 
+	if (kgsl_memdesc_is_lazy(memdesc) &&
+		kgsl_memdesc_lazy_populate(memdesc, offset, 1))
+		return VM_FAULT_OOM;
+
 	if (pgoff < memdesc->page_count) {
 		struct page *page = memdesc->pages[pgoff];
 
@@ -499,6 +516,15 @@ static void kgsl_page_alloc_free(struct kgsl_memdesc *memdesc)
 		}
 
 		atomic_long_sub(memdesc->size, &kgsl_driver.stats.secure);
+	} else if (kgsl_memdesc_is_lazy(memdesc)) {
+		unsigned int i, populated = 0;
+
+		for (i = 0; i < memdesc->page_count; i++)
+			if (memdesc->pages[i])
+				populated++;
+
+		atomic_long_sub((long)populated << PAGE_SHIFT,
+				&kgsl_driver.stats.page_alloc);
 	} else {
 		atomic_long_sub(memdesc->size, &kgsl_driver.stats.page_alloc);
 	}
@@ -536,6 +562,13 @@ static int kgsl_page_alloc_map_kernel(struct kgsl_memdesc *memdesc)
 	if (memdesc->size > ULONG_MAX)
 		return -ENOMEM;
 
+	/* The kernel mapping covers the whole buffer */
+	if (kgsl_memdesc_is_lazy(memdesc)) {
+		ret = kgsl_memdesc_lazy_populate(memdesc, 0, memdesc->size);
+		if (ret)
+			return ret;
+	}
+
 	mutex_lock(&kernel_map_global_lock);
 	if ((!memdesc->hostptr) && (memdesc->pages != NULL)) {
 		pgprot_t page_prot = pgprot_writecombine(PAGE_KERNEL);
@@ -735,6 +768,14 @@ int kgsl_cache_range_op(struct kgsl_memdesc *memdesc, uint64_t offset,
 		if (memdesc->pages == NULL)
 			return ret;
 
+		/* The sg table below is built from every page in the buffer */
+		if (kgsl_memdesc_is_lazy(memdesc)) {
+			ret = kgsl_memdesc_lazy_populate(memdesc, 0,
+					memdesc->size);
+			if (ret)
+				return ret;
+		}
+
 		sgt = kgsl_alloc_sgt_from_pages(memdesc);
 		if (IS_ERR(sgt))
 			return PTR_ERR(sgt);
@@ -800,6 +841,103 @@ void kgsl_memdesc_init(struct kgsl_device *device,
 	spin_lock_init(&memdesc->lock);
 }
 
+static bool kgsl_use_lazy_alloc(struct kgsl_memdesc *memdesc, uint64_t size)
+{
+	if (!kgsl_lazy_alloc_size || size < kgsl_lazy_alloc_size)
+		return false;
+
+	/* Secure and sparse physical buffers are bound up front */
+	return !(memdesc->flags & (KGSL_MEMFLAGS_SECURE |
+				KGSL_MEMFLAGS_SPARSE_PHYS));
+}
+
+static int _lazy_populate_chunk(struct kgsl_memdesc *memdesc, uint64_t start)
+{
+	uint64_t len = min_t(uint64_t, KGSL_LAZY_CHUNK, memdesc->size - start);
+	struct page **pages = memdesc->pages + (start >> PAGE_SHIFT);
+	unsigned int npages = len >> PAGE_SHIFT;
+	unsigned int pcount = 0;
+	unsigned int align = ilog2(KGSL_LAZY_CHUNK);
+	uint64_t left = len;
+	int page_size, ret;
+
+	/* Chunks are populated as a whole */
+	if (pages[0] != NULL)
+		return 0;
+
+	page_size = kgsl_get_page_size(left, align);
+
+	while (left > 0) {
+		int page_count;
+
+		page_count = kgsl_pool_alloc_page(&page_size, pages + pcount,
+					npages - pcount, &align);
+		if (page_count == -EAGAIN)
+			continue;
+
+		if (page_count <= 0) {
+			ret = -ENOMEM;
+			goto err;
+		}
+
+		pcount += page_count;
+		left -= page_size;
+
+		page_size = kgsl_get_page_size(left, align);
+	}
+
+	if (memdesc->priv & KGSL_MEMDESC_MAPPED) {
+		ret = kgsl_mmu_map_lazy(memdesc->pagetable, memdesc, start, len);
+		if (ret)
+			goto err;
+	}
+
+	KGSL_STATS_ADD(len, &kgsl_driver.stats.page_alloc,
+		&kgsl_driver.stats.page_alloc_max);
+
+	return 0;
+
+err:
+	kgsl_pool_free_pages(pages, pcount);
+	memset(pages, 0, npages * sizeof(*pages));
+	return ret;
+}
+
+/**
+ * kgsl_memdesc_lazy_populate() - Back a range of a lazy memdesc with pages
+ * @memdesc: Lazily allocated memory descriptor
+ * @offset: Start of the range in the memdesc
+ * @size: Size of the range
+ *
+ * Allocate the pages of every KGSL_LAZY_CHUNK in the range that isn't
+ * populated yet and map them in the GPU pagetable if the memdesc is already
+ * mapped there. Returns 0 on success or a negative error code.
+ */
+int kgsl_memdesc_lazy_populate(struct kgsl_memdesc *memdesc,
+		uint64_t offset, uint64_t size)
+{
+	uint64_t start, end;
+	int ret = 0;
+
+	if (size == 0 || offset >= memdesc->size)
+		return -ERANGE;
+
+	end = min_t(uint64_t, offset + size, memdesc->size);
+
+	mutex_lock(&lazy_populate_lock);
+
+	for (start = round_down(offset, KGSL_LAZY_CHUNK); start < end;
+			start += KGSL_LAZY_CHUNK) {
+		ret = _lazy_populate_chunk(memdesc, start);
+		if (ret)
+			break;
+	}
+
+	mutex_unlock(&lazy_populate_lock);
+
+	return ret;
+}
+
 int
 kgsl_sharedmem_page_alloc_user(struct kgsl_memdesc *memdesc,
 			uint64_t size)
@@ -821,15 +959,17 @@ kgsl_sharedmem_page_alloc_user(struct kgsl_memdesc *memdesc,
 	align = (memdesc->flags & KGSL_MEMALIGN_MASK) >> KGSL_MEMALIGN_SHIFT;
 
 	/*
-	 * As 1MB is the max supported page size, use the alignment
-	 * corresponding to 1MB page to make sure higher order pages
-	 * are used if possible for a given memory size. Also, we
+	 * As 2MB is the max supported page size, use the alignment
+	 * corresponding to the largest page that fits the memory size
+	 * to make sure higher order pages are used if possible. Also, we
 	 * don't need to update alignment in memdesc flags in case
 	 * higher order page is used, as memdesc flags represent the
 	 * virtual alignment specified by the user which is anyways
-	 * getting satisfied.
+	 * getting satisfied. The one exception are 2MB pages, see below.
 	 */
-	if (align < ilog2(SZ_1M))
+	if (size >= SZ_2M && align < ilog2(SZ_2M))
+		align = ilog2(SZ_2M);
+	else if (align < ilog2(SZ_1M))
 		align = ilog2(SZ_1M);
 
 	page_size = kgsl_get_page_size(size, align);
@@ -870,6 +1010,15 @@ kgsl_sharedmem_page_alloc_user(struct kgsl_memdesc *memdesc,
 		goto done;
 	}
 
+	/* Leave the pages to be allocated when the buffer is first touched */
+	if (kgsl_use_lazy_alloc(memdesc, size)) {
+		memset(memdesc->pages, 0, len_alloc * sizeof(struct page *));
+		memdesc->page_count = len_alloc;
+		memdesc->size = size;
+		memdesc->priv |= KGSL_MEMDESC_LAZY;
+		goto done;
+	}
+
 	len = size;
 
 	while (len > 0) {
@@ -909,6 +1058,18 @@ kgsl_sharedmem_page_alloc_user(struct kgsl_memdesc *memdesc,
 		page_size = kgsl_get_page_size(len, align);
 	}
 
+	/*
+	 * If the allocation starts with a 2MB page then give it a 2MB aligned
+	 * GPU address too, so that the IOMMU can map the 2MB pages as
+	 * sections instead of individual PTEs. Sparse allocations keep the
+	 * page size they asked for.
+	 */
+	if (memdesc->page_count &&
+		compound_order(memdesc->pages[0]) == get_order(SZ_2M) &&
+		!(memdesc->flags & KGSL_MEMFLAGS_SPARSE_PHYS) &&
+		kgsl_memdesc_get_align(memdesc) < ilog2(SZ_2M))
+		kgsl_memdesc_set_align(memdesc, ilog2(SZ_2M));
+
 	/* Call to the hypervisor to lock any secure buffer allocations */
 	if (memdesc->flags & KGSL_MEMFLAGS_SECURE) {
 		unsigned int i;
@@ -1359,3 +1520,8 @@ bool kgsl_sharedmem_get_noretry(void)
 {
 	return sharedmem_noretry_flag;
 }
+
+bool kgsl_sharedmem_lazy_enabled(void)
+{
+	return kgsl_lazy_alloc_size != 0;
+}
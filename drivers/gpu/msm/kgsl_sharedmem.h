@@ -328,6 +328,25 @@ static inline void kgsl_free_global(struct kgsl_device *device,
 void kgsl_sharedmem_set_noretry(bool val);
 bool kgsl_sharedmem_get_noretry(void);
 
+bool kgsl_sharedmem_lazy_enabled(void);
+int kgsl_memdesc_lazy_populate(struct kgsl_memdesc *memdesc,
+		uint64_t offset, uint64_t size);
+
+/* Granularity at which lazily allocated memory is backed */
+#define KGSL_LAZY_CHUNK SZ_1M
+
+/*
+ * kgsl_memdesc_is_lazy - Check if the backing pages of a memdesc are
+ * allocated on demand
+ * @memdesc - the memdesc
+ *
+ * Returns true if the memdesc is lazily populated, false otherwise
+ */
+static inline bool kgsl_memdesc_is_lazy(const struct kgsl_memdesc *memdesc)
+{
+	return memdesc->priv & KGSL_MEMDESC_LAZY;
+}
+
 /**
  * kgsl_alloc_sgt_from_pages() - Allocate a sg table
  *
@@ -383,7 +402,10 @@ static inline void kgsl_free_sgt(struct sg_table *sgt)
 #ifndef CONFIG_ALLOC_BUFFERS_IN_4K_CHUNKS
 static inline int kgsl_get_page_size(size_t size, unsigned int align)
 {
-	if (align >= ilog2(SZ_1M) && size >= SZ_1M &&
+	if (align >= ilog2(SZ_2M) && size >= SZ_2M &&
+		kgsl_pool_avaialable(SZ_2M))
+		return SZ_2M;
+	else if (align >= ilog2(SZ_1M) && size >= SZ_1M &&
 		kgsl_pool_avaialable(SZ_1M))
 		return SZ_1M;
 	else if (align >= ilog2(SZ_64K) && size >= SZ_64K &&
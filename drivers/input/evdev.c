@@ -256,17 +256,20 @@ static void __pass_event(struct evdev_client *client,
 	}
 }
 
-static void evdev_pass_values(struct evdev_client *client,
+/*
+ * Returns true if a complete packet was queued for @client. The caller
+ * wakes up the readers once for all clients.
+ */
+static bool evdev_pass_values(struct evdev_client *client,
 			const struct input_value *vals, unsigned int count,
 			ktime_t *ev_time)
 {
-	struct evdev *evdev = client->evdev;
 	const struct input_value *v;
 	struct input_event event;
 	bool wakeup = false;
 
 	if (client->revoked)
-		return;
+		return false;
 
 	event.time = ktime_to_timeval(ev_time[client->clk_type]);
 
@@ -293,8 +296,7 @@ static void evdev_pass_values(struct evdev_client *client,
 
 	spin_unlock(&client->buffer_lock);
 
-	if (wakeup)
-		wake_up_interruptible(&evdev->wait);
+	return wakeup;
 }
 
 /*
@@ -306,6 +308,7 @@ static void evdev_events(struct input_handle *handle,
 	struct evdev *evdev = handle->private;
 	struct evdev_client *client;
 	ktime_t ev_time[EV_CLK_MAX];
+	bool wakeup = false;
 
 	ev_time[EV_CLK_MONO] = ktime_get();
 	ev_time[EV_CLK_REAL] = ktime_mono_to_real(ev_time[EV_CLK_MONO]);
@@ -317,12 +320,16 @@ static void evdev_events(struct input_handle *handle,
 	client = rcu_dereference(evdev->grab);
 
 	if (client)
-		evdev_pass_values(client, vals, count, ev_time);
+		wakeup = evdev_pass_values(client, vals, count, ev_time);
 	else
 		list_for_each_entry_rcu(client, &evdev->client_list, node)
-			evdev_pass_values(client, vals, count, ev_time);
+			wakeup |= evdev_pass_values(client, vals, count,
+						    ev_time);
 
 	rcu_read_unlock();
+
+	if (wakeup)
+		wake_up_interruptible(&evdev->wait);
 }
 
 /*
@@ -1502,14 +1502,18 @@ static irqreturn_t arm_smmu_context_fault(int irq, void *dev)
 	frsynra = readl_relaxed(gr1_base + ARM_SMMU_GR1_CBFRSYNRA(cfg->cbndx));
 	frsynra &= CBFRSYNRA_SID_MASK;
 	tmp = report_iommu_fault(domain, smmu->dev, iova, flags);
-	if (!tmp || (tmp == -EBUSY)) {
+	if (!tmp || (tmp == -EBUSY) || (tmp == -EAGAIN)) {
 		dev_dbg(smmu->dev,
 			"Context fault handled by client: iova=0x%08lx, fsr=0x%x, fsynr=0x%x, cb=%d\n",
 			iova, fsr, fsynr, cfg->cbndx);
 		dev_dbg(smmu->dev,
 			"soft iova-to-phys=%pa\n", &phys_soft);
 		ret = IRQ_HANDLED;
-		resume = RESUME_TERMINATE;
+		/*
+		 * -EAGAIN means the client has fixed up the mapping, so a
+		 * stalled transaction can be retried instead of terminated.
+		 */
+		resume = tmp == -EAGAIN ? RESUME_RETRY : RESUME_TERMINATE;
 	} else {
 		phys_addr_t phys_atos = arm_smmu_verify_fault(domain, iova,
 							      fsr);
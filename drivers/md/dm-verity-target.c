@@ -28,6 +28,7 @@
 #define DM_VERITY_ENV_VAR_NAME		"DM_VERITY_ERR_BLOCK_NR"
 
 #define DM_VERITY_DEFAULT_PREFETCH_SIZE	262144
+#define DM_VERITY_DEFAULT_PIN_SIZE	524288
 
 #define DM_VERITY_MAX_CORRUPTED_ERRS	100
 
@@ -43,6 +44,11 @@ static unsigned dm_verity_prefetch_cluster = DM_VERITY_DEFAULT_PREFETCH_SIZE;
 
 module_param_named(prefetch_cluster, dm_verity_prefetch_cluster, uint, S_IRUGO | S_IWUSR);
 
+/* memory budget for pinning the upper hash tree levels, taken at table load */
+static unsigned dm_verity_pin_size = DM_VERITY_DEFAULT_PIN_SIZE;
+
+module_param_named(pin_size, dm_verity_pin_size, uint, S_IRUGO | S_IWUSR);
+
 static int dm_device_wait;
 
 struct dm_verity_prefetch_work {
@@ -116,6 +122,15 @@ static int verity_hash_init(struct dm_verity *v, struct shash_desc *desc)
 	desc->tfm = v->tfm;
 	desc->flags = CRYPTO_TFM_REQ_MAY_SLEEP;
 
+	if (likely(v->initial_hashstate)) {
+		r = crypto_shash_import(desc, v->initial_hashstate);
+
+		if (unlikely(r < 0))
+			DMERR("crypto_shash_import failed: %d", r);
+
+		return r;
+	}
+
 	r = crypto_shash_init(desc);
 
 	if (unlikely(r < 0)) {
@@ -177,6 +192,16 @@ int verity_hash(struct dm_verity *v, struct shash_desc *desc,
 	if (unlikely(r < 0))
 		return r;
 
+	/* no trailing salt, hash the data in a single call */
+	if (likely(v->version >= 1)) {
+		r = crypto_shash_finup(desc, data, len, digest);
+
+		if (unlikely(r < 0))
+			DMERR("crypto_shash_finup failed: %d", r);
+
+		return r;
+	}
+
 	r = verity_hash_update(v, desc, data, len);
 	if (unlikely(r < 0))
 		return r;
@@ -281,6 +306,13 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 
 	verity_hash_at_level(v, block, level, &hash_block, &offset);
 
+	if (level >= v->pin_level) {
+		data = v->pinned_hash +
+		       ((hash_block - v->hash_start) << v->hash_dev_block_bits);
+		memcpy(want_digest, data + offset, v->digest_size);
+		return 0;
+	}
+
 	data = dm_bufio_read(v->bufio, hash_block, &buf);
 	if (IS_ERR(data))
 		return PTR_ERR(data);
@@ -424,6 +456,35 @@ static inline void verity_bv_skip_block(struct dm_verity *v,
 	bio_advance_iter(bio, iter, 1 << v->data_dev_block_bits);
 }
 
+/*
+ * Hash the data block at @iter with a single verity_hash() call if it is
+ * contiguous in one bio_vec, which is the case for page sized blocks.
+ * Returns 1 if the block is split over several bio_vecs.
+ */
+static int verity_hash_contig_block(struct dm_verity *v,
+				    struct dm_verity_io *io,
+				    struct bvec_iter *iter, u8 *digest)
+{
+	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	unsigned int block_size = 1 << v->data_dev_block_bits;
+	struct bio_vec bv = bio_iter_iovec(bio, *iter);
+	u8 *page;
+	int r;
+
+	if (bv.bv_len < block_size)
+		return 1;
+
+	page = kmap_atomic(bv.bv_page);
+	r = verity_hash(v, verity_io_hash_desc(v, io), page + bv.bv_offset,
+			block_size, digest);
+	kunmap_atomic(page);
+
+	if (likely(!r))
+		bio_advance_iter(bio, iter, block_size);
+
+	return r;
+}
+
 /*
  * Verify one "dm_verity_io" structure.
  */
@@ -464,18 +525,27 @@ static int verity_verify_io(struct dm_verity_io *io)
 			continue;
 		}
 
-		r = verity_hash_init(v, desc);
-		if (unlikely(r < 0))
-			return r;
-
 		start = io->iter;
-		r = verity_for_bv_block(v, io, &io->iter, verity_bv_hash_update);
+		r = verity_hash_contig_block(v, io, &io->iter,
+					     verity_io_real_digest(v, io));
 		if (unlikely(r < 0))
 			return r;
 
-		r = verity_hash_final(v, desc, verity_io_real_digest(v, io));
-		if (unlikely(r < 0))
-			return r;
+		if (r) {
+			r = verity_hash_init(v, desc);
+			if (unlikely(r < 0))
+				return r;
+
+			r = verity_for_bv_block(v, io, &io->iter,
+						verity_bv_hash_update);
+			if (unlikely(r < 0))
+				return r;
+
+			r = verity_hash_final(v, desc,
+					      verity_io_real_digest(v, io));
+			if (unlikely(r < 0))
+				return r;
+		}
 
 		if (likely(memcmp(verity_io_real_digest(v, io),
 				  verity_io_want_digest(v, io), v->digest_size) == 0)) {
@@ -541,29 +611,39 @@ static void verity_prefetch_io(struct work_struct *work)
 	struct dm_verity_prefetch_work *pw =
 		container_of(work, struct dm_verity_prefetch_work, work);
 	struct dm_verity *v = pw->v;
+	sector_t block = pw->block;
+	sector_t last = pw->block + pw->n_blocks - 1;
+	unsigned cluster = ACCESS_ONCE(dm_verity_prefetch_cluster);
 	int i;
 
+	cluster >>= v->data_dev_block_bits;
+	if (likely(cluster)) {
+		unsigned bits = v->hash_per_block_bits;
+
+		if (unlikely(cluster & (cluster - 1)))
+			cluster = 1 << __fls(cluster);
+
+		/*
+		 * Widen the io to the data covered by a cluster of level 0 hash
+		 * blocks, and prefetch the upper levels for all of it, so that
+		 * neighbouring reads find their whole hash chain cached.
+		 */
+		block = ((block >> bits) & ~(sector_t)(cluster - 1)) << bits;
+		last = (((last >> bits) | (cluster - 1)) + 1) << bits;
+		if (last > v->data_blocks)
+			last = v->data_blocks;
+		last--;
+	}
+
 	for (i = v->levels - 2; i >= 0; i--) {
 		sector_t hash_block_start;
 		sector_t hash_block_end;
-		verity_hash_at_level(v, pw->block, i, &hash_block_start, NULL);
-		verity_hash_at_level(v, pw->block + pw->n_blocks - 1, i, &hash_block_end, NULL);
-		if (!i) {
-			unsigned cluster = ACCESS_ONCE(dm_verity_prefetch_cluster);
-
-			cluster >>= v->data_dev_block_bits;
-			if (unlikely(!cluster))
-				goto no_prefetch_cluster;
-
-			if (unlikely(cluster & (cluster - 1)))
-				cluster = 1 << __fls(cluster);
-
-			hash_block_start &= ~(sector_t)(cluster - 1);
-			hash_block_end |= cluster - 1;
-			if (unlikely(hash_block_end >= v->hash_blocks))
-				hash_block_end = v->hash_blocks - 1;
-		}
-no_prefetch_cluster:
+
+		if (i >= v->pin_level)
+			continue;
+
+		verity_hash_at_level(v, block, i, &hash_block_start, NULL);
+		verity_hash_at_level(v, last, i, &hash_block_end, NULL);
 		dm_bufio_prefetch(v->bufio, hash_block_start,
 				  hash_block_end - hash_block_start + 1);
 	}
@@ -751,7 +831,9 @@ void verity_dtr(struct dm_target *ti)
 		dm_bufio_client_destroy(v->bufio);
 
 	vfree(v->validated_blocks);
+	vfree(v->pinned_hash);
 	kfree(v->salt);
+	kfree(v->initial_hashstate);
 	kfree(v->root_digest);
 	kfree(v->zero_digest);
 
@@ -823,6 +905,133 @@ static int verity_alloc_zero_digest(struct dm_verity *v)
 	return r;
 }
 
+/*
+ * With the salt prepended (version 1), every block hash starts from the same
+ * state. Compute it once, so that hashing a block only takes an import and
+ * a single finup. Algorithms that cannot export their state keep hashing the
+ * salt for every block.
+ */
+static int verity_init_hashstate(struct dm_verity *v)
+{
+	struct shash_desc *desc;
+	u8 *state;
+	int r;
+
+	if (!v->version || !v->salt_size)
+		return 0;
+
+	state = kmalloc(crypto_shash_statesize(v->tfm), GFP_KERNEL);
+	if (!state)
+		return -ENOMEM;
+
+	desc = kmalloc(v->shash_descsize, GFP_KERNEL);
+	if (!desc) {
+		kfree(state);
+		return -ENOMEM;
+	}
+
+	r = verity_hash_init(v, desc);
+	if (!r)
+		r = crypto_shash_export(desc, state);
+	kfree(desc);
+
+	if (r) {
+		kfree(state);
+		return 0;
+	}
+
+	v->initial_hashstate = state;
+	return 0;
+}
+
+/* first hash block after the levels from @level up */
+static sector_t verity_levels_end(struct dm_verity *v, int level)
+{
+	return level ? v->hash_level_block[level - 1] : v->hash_blocks;
+}
+
+/*
+ * Keep a verified copy of as many upper hash tree levels as fit into
+ * dm_verity_pin_size, so that memory pressure evicting them from dm-bufio
+ * never turns into synchronous hash block reads. The levels are stored
+ * top-down from hash_start on, so the pinned part of the tree is a single
+ * range of hash blocks. Failing to pin is not fatal, the levels are then
+ * just read through dm-bufio.
+ */
+static void verity_pin_hash_levels(struct dm_verity *v)
+{
+	sector_t budget = ACCESS_ONCE(dm_verity_pin_size) >> v->hash_dev_block_bits;
+	unsigned block_size = 1 << v->hash_dev_block_bits;
+	struct shash_desc *desc;
+	sector_t nr, b;
+	int level = v->levels, l;
+	u8 *pinned, *digest;
+
+	while (level > 0 &&
+	       verity_levels_end(v, level - 1) - v->hash_start <= budget)
+		level--;
+
+	if (level == v->levels)
+		return;
+
+	nr = verity_levels_end(v, level) - v->hash_start;
+	pinned = vmalloc(nr << v->hash_dev_block_bits);
+	desc = kmalloc(v->shash_descsize + v->digest_size, GFP_KERNEL);
+	if (!pinned || !desc)
+		goto fail;
+	digest = (u8 *)desc + v->shash_descsize;
+
+	dm_bufio_prefetch(v->bufio, v->hash_start, nr);
+	for (b = 0; b < nr; b++) {
+		struct dm_buffer *buf;
+		u8 *data;
+
+		data = dm_bufio_read(v->bufio, v->hash_start + b, &buf);
+		if (IS_ERR(data))
+			goto fail;
+		memcpy(pinned + (b << v->hash_dev_block_bits), data, block_size);
+		dm_bufio_release(buf);
+	}
+
+	/* verify every pinned block against its parent, from the root down */
+	for (l = v->levels - 1; l >= level; l--) {
+		for (b = v->hash_level_block[l]; b < verity_levels_end(v, l); b++) {
+			u8 *data = pinned +
+				   ((b - v->hash_start) << v->hash_dev_block_bits);
+			u8 *want = v->root_digest;
+
+			if (l < v->levels - 1) {
+				sector_t parent, pos = b - v->hash_level_block[l];
+				unsigned offset;
+
+				verity_hash_at_level(v, pos << ((l + 1) *
+						     v->hash_per_block_bits),
+						     l + 1, &parent, &offset);
+				want = pinned + offset + ((parent - v->hash_start)
+					<< v->hash_dev_block_bits);
+			}
+
+			if (verity_hash(v, desc, data, block_size, digest) ||
+			    memcmp(digest, want, v->digest_size)) {
+				DMWARN("%s: hash block %llu does not verify, not pinning hash tree",
+				       v->data_dev->name, (unsigned long long)b);
+				goto fail;
+			}
+		}
+	}
+
+	kfree(desc);
+	v->pinned_hash = pinned;
+	v->pin_level = level;
+	DMINFO("%s: pinned %d hash tree levels (%llu blocks)", v->data_dev->name,
+	       v->levels - level, (unsigned long long)nr);
+	return;
+
+fail:
+	kfree(desc);
+	vfree(pinned);
+}
+
 static int verity_parse_pre_opt_args(struct dm_arg_set *as,
 					struct dm_verity *v)
 {
@@ -1108,6 +1317,12 @@ int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 		}
 	}
 
+	r = verity_init_hashstate(v);
+	if (r) {
+		ti->error = "Cannot allocate initial hash state";
+		goto bad;
+	}
+
 	argv += 10;
 	argc -= 10;
 
@@ -1176,8 +1391,18 @@ int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 		goto bad;
 	}
 
-	/* WQ_UNBOUND greatly improves performance when running on ramdisk */
-	v->verify_wq = alloc_workqueue("kverityd", WQ_CPU_INTENSIVE | WQ_MEM_RECLAIM | WQ_UNBOUND, num_online_cpus());
+	v->pin_level = v->levels;
+	verity_pin_hash_levels(v);
+
+	/*
+	 * WQ_UNBOUND greatly improves performance when running on ramdisk,
+	 * and spreads the hashing over all CPUs when completions arrive on a
+	 * single one. WQ_HIGHPRI keeps verification, which the reader is
+	 * waiting for, ahead of regular kworkers.
+	 */
+	v->verify_wq = alloc_workqueue("kverityd",
+				       WQ_HIGHPRI | WQ_MEM_RECLAIM | WQ_UNBOUND,
+				       num_online_cpus());
 	if (!v->verify_wq) {
 		ti->error = "Cannot allocate workqueue";
 		r = -ENOMEM;
@@ -41,6 +41,7 @@ struct dm_verity {
 	u8 *root_digest;	/* digest of the root block */
 	u8 *salt;		/* salt: its size is salt_size */
 	u8 *zero_digest;	/* digest for a zero block */
+	u8 *initial_hashstate;	/* salted initial state, if version 1 */
 	unsigned salt_size;
 	sector_t data_start;	/* data offset in 512-byte sectors */
 	sector_t hash_start;	/* hash start in blocks */
@@ -64,6 +65,10 @@ struct dm_verity {
 
 	struct dm_verity_fec *fec;	/* forward error correction */
 	unsigned long *validated_blocks; /* bitset blocks validated */
+
+	/* verified copy of the hash tree levels pin_level..levels - 1 */
+	u8 *pinned_hash;
+	unsigned char pin_level;
 };
 
 struct dm_verity_io {
@@ -93,34 +93,31 @@ void cam_hfi_queue_dump(void)
 		CAM_INFO(CAM_HFI, "Word: %d Data: 0x%08x ", i, read_ptr[i]);
 }
 
-int hfi_write_cmd(void *cmd_ptr)
+static int hfi_check_cmd_q(void)
 {
-	uint32_t size_in_words, empty_space, new_write_idx, read_idx, temp;
-	uint32_t *write_q, *write_ptr;
-	struct hfi_qtbl *q_tbl;
-	struct hfi_q_hdr *q;
-	int rc = 0;
-
-	if (!cmd_ptr) {
-		CAM_ERR(CAM_HFI, "command is null");
-		return -EINVAL;
-	}
-
-	mutex_lock(&hfi_cmd_q_mutex);
 	if (!g_hfi) {
 		CAM_ERR(CAM_HFI, "HFI interface not setup");
-		rc = -ENODEV;
-		goto err;
+		return -ENODEV;
 	}
 
 	if (g_hfi->hfi_state != HFI_READY ||
 		!g_hfi->cmd_q_state) {
 		CAM_ERR(CAM_HFI, "HFI state: %u, cmd q state: %u",
 			g_hfi->hfi_state, g_hfi->cmd_q_state);
-		rc = -ENODEV;
-		goto err;
+		return -ENODEV;
 	}
 
+	return 0;
+}
+
+/* Copy one packet into the command queue, caller holds hfi_cmd_q_mutex */
+static int hfi_queue_cmd(void *cmd_ptr)
+{
+	uint32_t size_in_words, empty_space, new_write_idx, read_idx, temp;
+	uint32_t *write_q, *write_ptr;
+	struct hfi_qtbl *q_tbl;
+	struct hfi_q_hdr *q;
+
 	q_tbl = (struct hfi_qtbl *)g_hfi->map.qtbl.kva;
 	q = &q_tbl->q_hdr[Q_CMD];
 
@@ -129,8 +126,7 @@ int hfi_write_cmd(void *cmd_ptr)
 	size_in_words = (*(uint32_t *)cmd_ptr) >> BYTE_WORD_SHIFT;
 	if (!size_in_words) {
 		CAM_DBG(CAM_HFI, "failed");
-		rc = -EINVAL;
-		goto err;
+		return -EINVAL;
 	}
 
 	read_idx = q->qhdr_read_idx;
@@ -140,8 +136,7 @@ int hfi_write_cmd(void *cmd_ptr)
 	if (empty_space <= size_in_words) {
 		CAM_ERR(CAM_HFI, "failed: empty space %u, size_in_words %u",
 			empty_space, size_in_words);
-		rc = -EIO;
-		goto err;
+		return -EIO;
 	}
 
 	new_write_idx = q->qhdr_write_idx + size_in_words;
@@ -166,6 +161,11 @@ int hfi_write_cmd(void *cmd_ptr)
 
 	q->qhdr_write_idx = new_write_idx;
 
+	return 0;
+}
+
+static void hfi_raise_cmd_intr(void)
+{
 	/*
 	 * Before raising interrupt make sure command data is ready for
 	 * firmware to process
@@ -173,6 +173,69 @@ int hfi_write_cmd(void *cmd_ptr)
 	wmb();
 	cam_io_w_mb((uint32_t)INTR_ENABLE,
 		g_hfi->csr_base + HFI_REG_A5_CSR_HOST2ICPINT);
+}
+
+int hfi_write_cmd(void *cmd_ptr)
+{
+	int rc = 0;
+
+	if (!cmd_ptr) {
+		CAM_ERR(CAM_HFI, "command is null");
+		return -EINVAL;
+	}
+
+	mutex_lock(&hfi_cmd_q_mutex);
+	rc = hfi_check_cmd_q();
+	if (rc)
+		goto err;
+
+	rc = hfi_queue_cmd(cmd_ptr);
+	if (rc)
+		goto err;
+
+	hfi_raise_cmd_intr();
+err:
+	mutex_unlock(&hfi_cmd_q_mutex);
+	return rc;
+}
+
+/*
+ * Queue several packets and interrupt the firmware once. Packets that
+ * made it into the queue before a failure are still signalled, so the
+ * return value is the number of packets queued or a negative error if
+ * none were.
+ */
+int hfi_write_cmd_batch(void **cmd_ptrs, uint32_t num_cmds)
+{
+	uint32_t i;
+	int rc = 0;
+
+	if (!cmd_ptrs || !num_cmds) {
+		CAM_ERR(CAM_HFI, "Invalid cmds %pK num %u", cmd_ptrs, num_cmds);
+		return -EINVAL;
+	}
+
+	mutex_lock(&hfi_cmd_q_mutex);
+	rc = hfi_check_cmd_q();
+	if (rc)
+		goto err;
+
+	for (i = 0; i < num_cmds; i++) {
+		if (!cmd_ptrs[i]) {
+			CAM_ERR(CAM_HFI, "command %u is null", i);
+			rc = -EINVAL;
+			break;
+		}
+
+		rc = hfi_queue_cmd(cmd_ptrs[i]);
+		if (rc)
+			break;
+	}
+
+	if (i) {
+		hfi_raise_cmd_intr();
+		rc = i;
+	}
 err:
 	mutex_unlock(&hfi_cmd_q_mutex);
 	return rc;
@@ -278,6 +341,46 @@ int hfi_read_message(uint32_t *pmsg, uint8_t q_id,
 	return rc;
 }
 
+/*
+ * Busy wait for a message instead of waiting for the ICP interrupt, for
+ * short commands whose response normally lands within a few microseconds
+ * and where the irq round trip dominates.
+ */
+int hfi_poll_message(uint32_t *pmsg, uint8_t q_id,
+	uint32_t *words_read, uint32_t timeout_us)
+{
+	struct hfi_qtbl *q_tbl_ptr;
+	struct hfi_q_hdr *q;
+	ktime_t timeout;
+
+	if (q_id > Q_DBG) {
+		CAM_ERR(CAM_HFI, "Inavlid q :%u", q_id);
+		return -EINVAL;
+	}
+
+	if (!g_hfi) {
+		CAM_ERR(CAM_HFI, "hfi not set up yet");
+		return -ENODEV;
+	}
+
+	q_tbl_ptr = (struct hfi_qtbl *)g_hfi->map.qtbl.kva;
+	q = &q_tbl_ptr->q_hdr[q_id];
+
+	timeout = ktime_add_us(ktime_get(), timeout_us);
+	while (READ_ONCE(q->qhdr_read_idx) == READ_ONCE(q->qhdr_write_idx)) {
+		if (ktime_compare(ktime_get(), timeout) > 0) {
+			CAM_DBG(CAM_HFI, "poll timeout on q %u", q_id);
+			return -ETIMEDOUT;
+		}
+		cpu_relax();
+	}
+
+	/* Read the packet only after the firmware write index is seen */
+	rmb();
+
+	return hfi_read_message(pmsg, q_id, words_read);
+}
+
 int hfi_cmd_ubwc_config(uint32_t *ubwc_cfg)
 {
 	uint8_t *prop;
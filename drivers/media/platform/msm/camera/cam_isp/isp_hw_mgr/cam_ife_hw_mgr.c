@@ -975,6 +975,74 @@ static int cam_ife_hw_mgr_acquire_res_ife_src(
 	return rc;
 }
 
+static bool cam_ife_hw_mgr_topo_match(struct cam_ife_hw_mgr_topo *topo,
+	struct cam_isp_in_port_info *in_port, uint32_t csid_path)
+{
+	return topo->last_used &&
+		topo->res_type == in_port->res_type &&
+		topo->lane_type == in_port->lane_type &&
+		topo->lane_num == in_port->lane_num &&
+		topo->lane_cfg == in_port->lane_cfg &&
+		topo->format == in_port->format &&
+		topo->usage_type == in_port->usage_type &&
+		topo->csid_path == csid_path;
+}
+
+/*
+ * A camera switch releases and acquires the same few topologies over and
+ * over. Remember which CSID served each one so the next acquire can go
+ * straight to it instead of probing every CSID in turn.
+ */
+static int cam_ife_hw_mgr_get_topo(struct cam_ife_hw_mgr *hw_mgr,
+	struct cam_isp_in_port_info *in_port, uint32_t csid_path)
+{
+	int i, csid_idx = -1;
+
+	mutex_lock(&hw_mgr->topo_mutex);
+	for (i = 0; i < CAM_IFE_HW_TOPO_MAX; i++) {
+		if (cam_ife_hw_mgr_topo_match(&hw_mgr->topo[i], in_port,
+			csid_path)) {
+			csid_idx = hw_mgr->topo[i].csid_idx;
+			break;
+		}
+	}
+	mutex_unlock(&hw_mgr->topo_mutex);
+
+	return csid_idx;
+}
+
+static void cam_ife_hw_mgr_update_topo(struct cam_ife_hw_mgr *hw_mgr,
+	struct cam_isp_in_port_info *in_port, uint32_t csid_path,
+	uint32_t csid_idx)
+{
+	struct cam_ife_hw_mgr_topo *topo, *victim = NULL;
+	int i;
+
+	mutex_lock(&hw_mgr->topo_mutex);
+	for (i = 0; i < CAM_IFE_HW_TOPO_MAX; i++) {
+		topo = &hw_mgr->topo[i];
+		if (cam_ife_hw_mgr_topo_match(topo, in_port, csid_path)) {
+			victim = topo;
+			break;
+		}
+		if (!victim || topo->last_used < victim->last_used)
+			victim = topo;
+	}
+
+	victim->res_type = in_port->res_type;
+	victim->lane_type = in_port->lane_type;
+	victim->lane_num = in_port->lane_num;
+	victim->lane_cfg = in_port->lane_cfg;
+	victim->format = in_port->format;
+	victim->usage_type = in_port->usage_type;
+	victim->csid_path = csid_path;
+	victim->csid_idx = csid_idx;
+	if (!++hw_mgr->topo_seq)
+		hw_mgr->topo_seq = 1;
+	victim->last_used = hw_mgr->topo_seq;
+	mutex_unlock(&hw_mgr->topo_mutex);
+}
+
 static int cam_ife_mgr_acquire_cid_res(
 	struct cam_ife_hw_mgr_ctx          *ife_ctx,
 	struct cam_isp_in_port_info        *in_port,
@@ -1046,6 +1114,22 @@ static int cam_ife_mgr_acquire_cid_res(
 		}
 	}
 
+	/* Try the CSID that served this topology last time */
+	i = cam_ife_hw_mgr_get_topo(ife_hw_mgr, in_port, csid_path);
+	if (!acquired_cnt && i >= 0 && i < CAM_IFE_CSID_HW_NUM_MAX &&
+		ife_hw_mgr->csid_devices[i]) {
+		hw_intf = ife_hw_mgr->csid_devices[i];
+		rc = hw_intf->hw_ops.reserve(hw_intf->hw_priv, &csid_acquire,
+			sizeof(csid_acquire));
+		if (!rc) {
+			CAM_DBG(CAM_ISP, "reuse csid %d for path %d",
+				i, csid_path);
+			cid_res_temp->hw_res[acquired_cnt++] =
+				csid_acquire.node_res;
+			goto acquire_successful;
+		}
+	}
+
 	/* Acquire Left if not already acquired */
 	for (i = CAM_IFE_CSID_HW_NUM_MAX - 1; i >= 0; i--) {
 		if (!ife_hw_mgr->csid_devices[i])
@@ -1072,6 +1156,8 @@ static int cam_ife_mgr_acquire_cid_res(
 acquire_successful:
 	CAM_DBG(CAM_ISP, "CID left acquired success is_dual %d",
 		in_port->usage_type);
+	cam_ife_hw_mgr_update_topo(ife_hw_mgr, in_port, csid_path,
+		cid_res_temp->hw_res[0]->hw_intf->hw_idx);
 
 	cid_res_temp->res_type = CAM_IFE_HW_MGR_RES_CID;
 	/* CID(DT_ID) value of acquire device, require for path */
@@ -4560,6 +4646,7 @@ int cam_ife_hw_mgr_init(struct cam_hw_mgr_intf *hw_mgr_intf, int *iommu_hdl)
 	memset(&g_ife_hw_mgr, 0, sizeof(g_ife_hw_mgr));
 
 	mutex_init(&g_ife_hw_mgr.ctx_mutex);
+	mutex_init(&g_ife_hw_mgr.topo_mutex);
 
 	if (CAM_IFE_HW_NUM_MAX != CAM_IFE_CSID_HW_NUM_MAX) {
 		CAM_ERR(CAM_ISP, "CSID num is different then IFE num");
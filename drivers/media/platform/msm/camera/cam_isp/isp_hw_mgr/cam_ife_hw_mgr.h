@@ -33,6 +33,7 @@ enum cam_ife_hw_mgr_res_type {
 #define CAM_IFE_HW_IN_RES_MAX            (CAM_ISP_IFE_IN_RES_MAX & 0xFF)
 #define CAM_IFE_HW_OUT_RES_MAX           (CAM_ISP_IFE_OUT_RES_MAX & 0xFF)
 #define CAM_IFE_HW_RES_POOL_MAX          64
+#define CAM_IFE_HW_TOPO_MAX              8
 
 /**
  * struct cam_vfe_hw_mgr_res- HW resources for the VFE manager
@@ -167,6 +168,31 @@ struct cam_ife_hw_mgr_ctx {
 	uint32_t                        dual_ife_irq_mismatch_cnt;
 };
 
+/**
+ * struct cam_ife_hw_mgr_topo - CSID placement remembered per input topology
+ *
+ * @res_type:              input port (PHY) of the topology
+ * @lane_type:             lane type of the input port
+ * @lane_num:              number of lanes of the input port
+ * @lane_cfg:              lane configuration of the input port
+ * @format:                input format
+ * @usage_type:            single or dual IFE
+ * @csid_path:             CSID path the CID resource was acquired for
+ * @csid_idx:              CSID the left CID resource came from
+ * @last_used:             acquire sequence of the last hit, 0 when unused
+ */
+struct cam_ife_hw_mgr_topo {
+	uint32_t                        res_type;
+	uint32_t                        lane_type;
+	uint32_t                        lane_num;
+	uint32_t                        lane_cfg;
+	uint32_t                        format;
+	uint32_t                        usage_type;
+	uint32_t                        csid_path;
+	uint32_t                        csid_idx;
+	uint32_t                        last_used;
+};
+
 /**
  * struct cam_ife_hw_mgr - IFE HW Manager
  *
@@ -183,6 +209,9 @@ struct cam_ife_hw_mgr_ctx {
  * @ife_dev_caps           ife device capability per core
  * @work q                 work queue for IFE hw manager
  * @debug_cfg              debug configuration
+ * @topo_mutex             mutex for the topology cache
+ * @topo                   last CSID placement per input topology
+ * @topo_seq               acquire sequence used to age topology entries
  */
 struct cam_ife_hw_mgr {
 	struct cam_isp_hw_mgr          mgr_common;
@@ -201,6 +230,9 @@ struct cam_ife_hw_mgr {
 	struct cam_vfe_hw_get_hw_cap   ife_dev_caps[CAM_IFE_HW_NUM_MAX];
 	struct cam_req_mgr_core_workq *workq;
 	struct cam_ife_hw_mgr_debug    debug_cfg;
+	struct mutex                   topo_mutex;
+	struct cam_ife_hw_mgr_topo     topo[CAM_IFE_HW_TOPO_MAX];
+	uint32_t                       topo_seq;
 };
 
 /**
@@ -43,6 +43,10 @@
 static int g_num_pf_handled = 4;
 module_param(g_num_pf_handled, int, 0644);
 
+/* user buffers kept mapped per context bank after unmap, 0 disables */
+static int g_map_cache_size = 16;
+module_param(g_map_cache_size, int, 0644);
+
 struct firmware_alloc_info {
 	struct device *fw_dev;
 	void *fw_kva;
@@ -129,6 +133,8 @@ struct cam_context_bank_info {
 
 	struct list_head smmu_buf_list;
 	struct list_head smmu_buf_kernel_list;
+	struct list_head smmu_buf_cache_list;
+	int buf_cache_count;
 	struct mutex lock;
 	int handle;
 	enum cam_smmu_ops_param state;
@@ -247,6 +253,8 @@ static void cam_smmu_clean_user_buffer_list(int idx);
 
 static void cam_smmu_clean_kernel_buffer_list(int idx);
 
+static void cam_smmu_clean_buffer_cache(int idx);
+
 static void cam_smmu_print_user_list(int idx);
 
 static void cam_smmu_print_kernel_list(int idx);
@@ -605,6 +613,8 @@ void cam_smmu_reset_iommu_table(enum cam_smmu_init_dir ops)
 		iommu_cb_set.cb_info[i].handle = HANDLE_INIT;
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_list);
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_kernel_list);
+		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_cache_list);
+		iommu_cb_set.cb_info[i].buf_cache_count = 0;
 		iommu_cb_set.cb_info[i].state = CAM_SMMU_DETACH;
 		iommu_cb_set.cb_info[i].dev = NULL;
 		iommu_cb_set.cb_info[i].cb_count = 0;
@@ -1925,6 +1935,94 @@ static int cam_smmu_unmap_buf_and_remove_from_list(
 	return 0;
 }
 
+/*
+ * Buffers unmapped by user space are parked on the cache list with their
+ * attachment, IOVA and page tables intact, most recently used first. A
+ * later map of the same dma-buf with the same direction and region takes
+ * the entry back instead of mapping again. The parked entry keeps its
+ * dma-buf reference, so the buffer cannot be released underneath it;
+ * the memory is given back on eviction, detach or handle destroy.
+ */
+static bool cam_smmu_buffer_cache_get(int idx, int ion_fd,
+	enum dma_data_direction dma_dir, dma_addr_t *paddr_ptr,
+	size_t *len_ptr, enum cam_smmu_region_id region_id)
+{
+	struct cam_context_bank_info *cb = &iommu_cb_set.cb_info[idx];
+	struct cam_dma_buff_info *mapping;
+	struct dma_buf *buf;
+	bool found = false;
+
+	if (list_empty(&cb->smmu_buf_cache_list))
+		return false;
+
+	buf = dma_buf_get(ion_fd);
+	if (IS_ERR_OR_NULL(buf))
+		return false;
+
+	list_for_each_entry(mapping, &cb->smmu_buf_cache_list, list) {
+		if (mapping->buf != buf || mapping->dir != dma_dir ||
+			mapping->region_id != region_id)
+			continue;
+		if (region_id == CAM_SMMU_REGION_SHARED &&
+			*len_ptr > mapping->len)
+			break;
+
+		list_move(&mapping->list, &cb->smmu_buf_list);
+		cb->buf_cache_count--;
+		mapping->ion_fd = ion_fd;
+		mapping->ref_count = 1;
+		*paddr_ptr = mapping->paddr;
+		*len_ptr = mapping->len;
+		found = true;
+		CAM_DBG(CAM_SMMU, "reuse fd %d paddr %pK len %zu",
+			ion_fd, (void *)mapping->paddr, mapping->len);
+		break;
+	}
+
+	/* a cached entry holds its own reference */
+	dma_buf_put(buf);
+	return found;
+}
+
+static bool cam_smmu_buffer_cache_put(int idx,
+	struct cam_dma_buff_info *mapping_info)
+{
+	struct cam_context_bank_info *cb = &iommu_cb_set.cb_info[idx];
+	struct cam_dma_buff_info *victim;
+
+	if (g_map_cache_size <= 0)
+		return false;
+
+	list_move(&mapping_info->list, &cb->smmu_buf_cache_list);
+	cb->buf_cache_count++;
+
+	while (cb->buf_cache_count > g_map_cache_size) {
+		victim = list_last_entry(&cb->smmu_buf_cache_list,
+			struct cam_dma_buff_info, list);
+		cb->buf_cache_count--;
+		if (cam_smmu_unmap_buf_and_remove_from_list(victim, idx) < 0)
+			CAM_ERR(CAM_SMMU, "cache evict failed: addr = %lx",
+				(unsigned long)victim->paddr);
+	}
+
+	return true;
+}
+
+static void cam_smmu_clean_buffer_cache(int idx)
+{
+	struct cam_context_bank_info *cb = &iommu_cb_set.cb_info[idx];
+	struct cam_dma_buff_info *mapping_info, *temp;
+
+	list_for_each_entry_safe(mapping_info, temp,
+			&cb->smmu_buf_cache_list, list) {
+		if (cam_smmu_unmap_buf_and_remove_from_list(mapping_info,
+			idx) < 0)
+			CAM_ERR(CAM_SMMU, "cache clean failed: addr = %lx",
+				(unsigned long)mapping_info->paddr);
+	}
+	cb->buf_cache_count = 0;
+}
+
 static enum cam_smmu_buf_state cam_smmu_check_fd_in_list(int idx,
 	int ion_fd, dma_addr_t *paddr_ptr, size_t *len_ptr)
 {
@@ -2032,6 +2130,7 @@ int cam_smmu_ops(int handle, enum cam_smmu_ops_param ops)
 		break;
 	}
 	case CAM_SMMU_DETACH: {
+		cam_smmu_clean_buffer_cache(idx);
 		ret = cam_smmu_detach_device(idx);
 		break;
 	}
@@ -2643,6 +2742,10 @@ int cam_smmu_map_user_iova(int handle, int ion_fd,
 		goto get_addr_end;
 	}
 
+	if (cam_smmu_buffer_cache_get(idx, ion_fd, dma_dir, paddr_ptr,
+		len_ptr, region_id))
+		goto get_addr_end;
+
 	rc = cam_smmu_map_buffer_and_add_to_list(idx, ion_fd, dma_dir,
 			paddr_ptr, len_ptr, region_id);
 	if (rc < 0)
@@ -2891,6 +2994,11 @@ int cam_smmu_unmap_user_iova(int handle,
 		goto unmap_end;
 	}
 
+	if (cam_smmu_buffer_cache_put(idx, mapping_info)) {
+		CAM_DBG(CAM_SMMU, "SMMU: parking buffer idx = %d", idx);
+		goto unmap_end;
+	}
+
 	/* Unmapping one buffer from device */
 	CAM_DBG(CAM_SMMU, "SMMU: removing buffer idx = %d", idx);
 	rc = cam_smmu_unmap_buf_and_remove_from_list(mapping_info, idx);
@@ -3026,6 +3134,8 @@ int cam_smmu_destroy_handle(int handle)
 		return -EINVAL;
 	}
 
+	cam_smmu_clean_buffer_cache(idx);
+
 	if (!list_empty_careful(&iommu_cb_set.cb_info[idx].smmu_buf_list)) {
 		CAM_ERR(CAM_SMMU, "UMD %s buffer list is not clean",
 			iommu_cb_set.cb_info[idx].name);
@@ -612,6 +612,19 @@ struct msm_vfe_tasklet_queue_cmd {
 
 #define MSM_VFE_TASKLETQ_SIZE 400
 
+/* must be a power of two */
+#define MSM_VFE_IRQ_RING_SIZE 256
+
+/*
+ * Single producer (the VFE hard irq) single consumer (the VFE irq thread)
+ * queue; head is only written by the producer and tail by the consumer.
+ */
+struct msm_vfe_irq_ring {
+	unsigned int head;
+	unsigned int tail;
+	struct msm_vfe_tasklet_queue_cmd cmd[MSM_VFE_IRQ_RING_SIZE];
+};
+
 enum msm_vfe_overflow_state {
 	NO_OVERFLOW,
 	OVERFLOW_DETECTED,
@@ -810,6 +823,7 @@ struct vfe_device {
 
 	/* Tasklet info */
 	atomic_t irq_cnt;
+	struct msm_vfe_irq_ring irq_ring;
 
 	/* Data structures */
 	struct msm_vfe_hardware_info *hw_info;
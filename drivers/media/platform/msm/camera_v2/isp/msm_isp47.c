@@ -340,6 +340,7 @@ int msm_vfe47_init_hardware(struct vfe_device *vfe_dev)
 	vfe_dev->common_data->dual_vfe_res->vfe_base[vfe_dev->pdev->id] =
 		vfe_dev->vfe_base;
 
+	msm_isp_set_irq_affinity(vfe_dev);
 	rc = msm_camera_enable_irq(vfe_dev->vfe_irq, 1);
 	if (rc < 0)
 		goto irq_enable_fail;
@@ -370,6 +371,7 @@ void msm_vfe47_release_hardware(struct vfe_device *vfe_dev)
 				vfe_dev->irq0_mask, vfe_dev->irq1_mask,
 				MSM_ISP_IRQ_SET);
 	msm_camera_enable_irq(vfe_dev->vfe_irq, 0);
+	irq_set_affinity_hint(vfe_dev->vfe_irq->start, NULL);
 	tasklet_kill(&(vfe_dev->common_data->tasklets[vfe_dev->pdev->id].
 			tasklet));
 	msm_isp_flush_tasklet(vfe_dev);
@@ -2914,8 +2916,8 @@ int msm_vfe47_get_platform_data(struct vfe_device *vfe_dev)
 	if (rc)
 		goto get_clkcs_fail;
 
-	rc = msm_camera_register_irq(vfe_dev->pdev, vfe_dev->vfe_irq,
-		msm_isp_process_irq,
+	rc = msm_camera_register_threaded_irq(vfe_dev->pdev, vfe_dev->vfe_irq,
+		msm_isp_process_irq, msm_isp_irq_thread,
 		IRQF_TRIGGER_RISING, "vfe", vfe_dev);
 	if (rc < 0)
 		goto irq_register_fail;
@@ -11,6 +11,8 @@
  */
 #include <linux/mutex.h>
 #include <linux/io.h>
+#include <linux/interrupt.h>
+#include <linux/moduleparam.h>
 #include <media/v4l2-subdev.h>
 #include <linux/ratelimit.h>
 
@@ -26,6 +28,10 @@
 
 
 #define MAX_ISP_V4l2_EVENTS 100
+
+/* CPU to route each VFE irq and its thread to, -1 leaves it alone */
+static int vfe_irq_cpu[MAX_VFE] = { [0 ... MAX_VFE - 1] = -1 };
+module_param_array(vfe_irq_cpu, int, NULL, 0644);
 #define MAX_ISP_REG_LIST 100
 static DEFINE_MUTEX(bandwidth_mgr_mutex);
 static struct msm_isp_bandwidth_mgr isp_bandwidth_mgr;
@@ -2103,7 +2109,56 @@ void msm_isp_prepare_tasklet_debug_info(struct vfe_device *vfe_dev,
 		common_dev_tasklet_dump_lock, flags);
 }
 
-static void msm_isp_enqueue_tasklet_cmd(struct vfe_device *vfe_dev,
+void msm_isp_set_irq_affinity(struct vfe_device *vfe_dev)
+{
+	int cpu;
+
+	if (!vfe_dev->vfe_irq || vfe_dev->pdev->id >= MAX_VFE)
+		return;
+
+	cpu = vfe_irq_cpu[vfe_dev->pdev->id];
+	if (cpu < 0 || cpu >= nr_cpu_ids || !cpu_online(cpu))
+		return;
+
+	if (irq_set_affinity_hint(vfe_dev->vfe_irq->start, cpumask_of(cpu)))
+		pr_err("%s: VFE%d failed to route irq to cpu %d\n",
+			__func__, vfe_dev->pdev->id, cpu);
+}
+
+/*
+ * A VFE that is not split is the only producer of its own ring, and its
+ * irq thread the only consumer, so the hard irq hands over without taking
+ * a lock shared with the other VFEs.
+ */
+static irqreturn_t msm_isp_enqueue_irq_ring(struct vfe_device *vfe_dev,
+	uint32_t irq_status0, uint32_t irq_status1,
+	uint32_t ping_pong_status)
+{
+	struct msm_vfe_irq_ring *ring = &vfe_dev->irq_ring;
+	struct msm_vfe_tasklet_queue_cmd *queue_cmd;
+	unsigned int head = ring->head;
+
+	if (head - smp_load_acquire(&ring->tail) >= MSM_VFE_IRQ_RING_SIZE) {
+		pr_err_ratelimited("%s: Irq queue overflow: %d\n",
+			__func__, vfe_dev->pdev->id);
+		return IRQ_WAKE_THREAD;
+	}
+	atomic_add(1, &vfe_dev->irq_cnt);
+	trace_msm_cam_isp_status_dump("VFE_IRQ:", vfe_dev->pdev->id,
+		vfe_dev->axi_data.src_info[VFE_PIX_0].frame_id,
+		irq_status0, irq_status1);
+	queue_cmd = &ring->cmd[head & (MSM_VFE_IRQ_RING_SIZE - 1)];
+	queue_cmd->vfeInterruptStatus0 = irq_status0;
+	queue_cmd->vfeInterruptStatus1 = irq_status1;
+	queue_cmd->vfe_pingpong_status = ping_pong_status;
+	msm_isp_get_timestamp(&queue_cmd->ts, vfe_dev);
+	queue_cmd->vfe_dev = vfe_dev;
+	smp_store_release(&ring->head, head + 1);
+
+	return IRQ_WAKE_THREAD;
+}
+
+static irqreturn_t msm_isp_enqueue_tasklet_cmd(struct vfe_device *vfe_dev,
 	uint32_t irq_status0, uint32_t irq_status1,
 	uint32_t ping_pong_status)
 {
@@ -2111,10 +2166,12 @@ static void msm_isp_enqueue_tasklet_cmd(struct vfe_device *vfe_dev,
 	struct msm_vfe_tasklet_queue_cmd *queue_cmd = NULL;
 	struct msm_vfe_tasklet *tasklet;
 
-	if (vfe_dev->is_split)
-		tasklet = &vfe_dev->common_data->tasklets[MAX_VFE];
-	else
-		tasklet = &vfe_dev->common_data->tasklets[vfe_dev->pdev->id];
+	/* split VFEs share one queue to keep their irqs in order */
+	if (!vfe_dev->is_split)
+		return msm_isp_enqueue_irq_ring(vfe_dev, irq_status0,
+			irq_status1, ping_pong_status);
+
+	tasklet = &vfe_dev->common_data->tasklets[MAX_VFE];
 
 	spin_lock_irqsave(&tasklet->tasklet_lock, flags);
 	queue_cmd = &tasklet->tasklet_queue_cmd[tasklet->taskletq_idx];
@@ -2122,7 +2179,7 @@ static void msm_isp_enqueue_tasklet_cmd(struct vfe_device *vfe_dev,
 		pr_err_ratelimited("%s: Tasklet queue overflow: %d\n",
 			__func__, vfe_dev->pdev->id);
 		spin_unlock_irqrestore(&tasklet->tasklet_lock, flags);
-		return;
+		return IRQ_HANDLED;
 	}
 	atomic_add(1, &vfe_dev->irq_cnt);
 	trace_msm_cam_isp_status_dump("VFE_IRQ:", vfe_dev->pdev->id,
@@ -2140,6 +2197,8 @@ static void msm_isp_enqueue_tasklet_cmd(struct vfe_device *vfe_dev,
 	list_add_tail(&queue_cmd->list, &tasklet->tasklet_q);
 	spin_unlock_irqrestore(&tasklet->tasklet_lock, flags);
 	tasklet_schedule(&tasklet->tasklet);
+
+	return IRQ_HANDLED;
 }
 
 irqreturn_t msm_isp_process_irq(int irq_num, void *data)
@@ -2185,8 +2244,73 @@ irqreturn_t msm_isp_process_irq(int irq_num, void *data)
 		return IRQ_HANDLED;
 	}
 	msm_isp_prepare_irq_debug_info(vfe_dev, irq_status0, irq_status1);
-	msm_isp_enqueue_tasklet_cmd(vfe_dev, irq_status0, irq_status1,
+	return msm_isp_enqueue_tasklet_cmd(vfe_dev, irq_status0, irq_status1,
 					ping_pong_status);
+}
+
+static void msm_isp_process_queue_cmd(struct vfe_device *vfe_dev,
+	uint32_t irq_status0, uint32_t irq_status1,
+	uint32_t pingpong_status, struct msm_isp_timestamp *ts)
+{
+	struct msm_vfe_irq_ops *irq_ops;
+
+	if (vfe_dev->vfe_open_cnt == 0) {
+		pr_err("%s: VFE%d open cnt = %d, irq %x/%x\n",
+		__func__, vfe_dev->pdev->id, vfe_dev->vfe_open_cnt,
+		irq_status0, irq_status1);
+		return;
+	}
+	atomic_sub(1, &vfe_dev->irq_cnt);
+	msm_isp_prepare_tasklet_debug_info(vfe_dev,
+		irq_status0, irq_status1, *ts);
+	trace_msm_cam_isp_status_dump("VFE_TASKLET:", vfe_dev->pdev->id,
+		vfe_dev->axi_data.src_info[VFE_PIX_0].frame_id,
+		irq_status0, irq_status1);
+	irq_ops = &vfe_dev->hw_info->vfe_ops.irq_ops;
+	irq_ops->process_reset_irq(vfe_dev,
+		irq_status0, irq_status1);
+	irq_ops->process_halt_irq(vfe_dev,
+		irq_status0, irq_status1);
+	if (atomic_read(&vfe_dev->error_info.overflow_state)
+		!= NO_OVERFLOW) {
+		ISP_DBG("%s: Recovery in processing, Ignore IRQs!!!\n",
+			__func__);
+		return;
+	}
+	msm_isp_process_error_info(vfe_dev);
+	irq_ops->process_stats_irq(vfe_dev,
+		irq_status0, irq_status1,
+		pingpong_status, ts);
+	irq_ops->process_axi_irq(vfe_dev,
+		irq_status0, irq_status1,
+		pingpong_status, ts);
+	irq_ops->process_camif_irq(vfe_dev,
+		irq_status0, irq_status1, ts);
+	irq_ops->process_reg_update(vfe_dev,
+		irq_status0, irq_status1, ts);
+	irq_ops->process_epoch_irq(vfe_dev,
+		irq_status0, irq_status1, ts);
+}
+
+irqreturn_t msm_isp_irq_thread(int irq_num, void *data)
+{
+	struct vfe_device *vfe_dev = (struct vfe_device *) data;
+	struct msm_vfe_irq_ring *ring = &vfe_dev->irq_ring;
+	struct msm_vfe_tasklet_queue_cmd *queue_cmd;
+	struct msm_isp_timestamp ts;
+	uint32_t irq_status0, irq_status1, pingpong_status;
+	unsigned int tail = ring->tail;
+
+	while (tail != smp_load_acquire(&ring->head)) {
+		queue_cmd = &ring->cmd[tail & (MSM_VFE_IRQ_RING_SIZE - 1)];
+		irq_status0 = queue_cmd->vfeInterruptStatus0;
+		irq_status1 = queue_cmd->vfeInterruptStatus1;
+		pingpong_status = queue_cmd->vfe_pingpong_status;
+		ts = queue_cmd->ts;
+		smp_store_release(&ring->tail, ++tail);
+		msm_isp_process_queue_cmd(vfe_dev, irq_status0, irq_status1,
+			pingpong_status, &ts);
+	}
 
 	return IRQ_HANDLED;
 }
@@ -2196,7 +2320,6 @@ void msm_isp_do_tasklet(unsigned long data)
 	unsigned long flags;
 	struct msm_vfe_tasklet *tasklet = (struct msm_vfe_tasklet *)data;
 	struct vfe_device *vfe_dev;
-	struct msm_vfe_irq_ops *irq_ops;
 	struct msm_vfe_tasklet_queue_cmd *queue_cmd;
 	struct msm_isp_timestamp ts;
 	uint32_t irq_status0, irq_status1, pingpong_status;
@@ -2218,42 +2341,8 @@ void msm_isp_do_tasklet(unsigned long data)
 		pingpong_status = queue_cmd->vfe_pingpong_status;
 		ts = queue_cmd->ts;
 		spin_unlock_irqrestore(&tasklet->tasklet_lock, flags);
-		if (vfe_dev->vfe_open_cnt == 0) {
-			pr_err("%s: VFE%d open cnt = %d, irq %x/%x\n",
-			__func__, vfe_dev->pdev->id, vfe_dev->vfe_open_cnt,
-			irq_status0, irq_status1);
-			continue;
-		}
-		atomic_sub(1, &vfe_dev->irq_cnt);
-		msm_isp_prepare_tasklet_debug_info(vfe_dev,
-			irq_status0, irq_status1, ts);
-		trace_msm_cam_isp_status_dump("VFE_TASKLET:", vfe_dev->pdev->id,
-			vfe_dev->axi_data.src_info[VFE_PIX_0].frame_id,
-			irq_status0, irq_status1);
-		irq_ops = &vfe_dev->hw_info->vfe_ops.irq_ops;
-		irq_ops->process_reset_irq(vfe_dev,
-			irq_status0, irq_status1);
-		irq_ops->process_halt_irq(vfe_dev,
-			irq_status0, irq_status1);
-		if (atomic_read(&vfe_dev->error_info.overflow_state)
-			!= NO_OVERFLOW) {
-			ISP_DBG("%s: Recovery in processing, Ignore IRQs!!!\n",
-				__func__);
-			continue;
-		}
-		msm_isp_process_error_info(vfe_dev);
-		irq_ops->process_stats_irq(vfe_dev,
-			irq_status0, irq_status1,
-			pingpong_status, &ts);
-		irq_ops->process_axi_irq(vfe_dev,
-			irq_status0, irq_status1,
+		msm_isp_process_queue_cmd(vfe_dev, irq_status0, irq_status1,
 			pingpong_status, &ts);
-		irq_ops->process_camif_irq(vfe_dev,
-			irq_status0, irq_status1, &ts);
-		irq_ops->process_reg_update(vfe_dev,
-			irq_status0, irq_status1, &ts);
-		irq_ops->process_epoch_irq(vfe_dev,
-			irq_status0, irq_status1, &ts);
 	}
 }
 
@@ -2494,6 +2583,14 @@ void msm_isp_flush_tasklet(struct vfe_device *vfe_dev)
 		spin_unlock_irqrestore(&tasklet->tasklet_lock, flags);
 		tasklet_kill(&tasklet->tasklet);
 	}
+
+	/* the ring may only be emptied while its irq thread is idle */
+	if (vfe_dev->vfe_irq) {
+		disable_irq(vfe_dev->vfe_irq->start);
+		smp_store_release(&vfe_dev->irq_ring.tail,
+			READ_ONCE(vfe_dev->irq_ring.head));
+		enable_irq(vfe_dev->vfe_irq->start);
+	}
 	atomic_set(&vfe_dev->irq_cnt, 0);
 
 }
@@ -23,12 +23,28 @@
 #include "msm_vidc_debug.h"
 #include "msm_vidc_resources.h"
 
+/* Unmapped dynamic buffers kept mapped per client for reuse */
+#define SMEM_MAP_CACHE_SIZE 32
+
+struct smem_map_entry {
+	struct list_head list;
+	struct dma_buf *dma_buf;
+	struct ion_handle *handle;
+	struct dma_mapping_info mapping_info;
+	u32 iova;
+	unsigned long flags;
+	enum hal_buffer buffer_type;
+};
+
 struct smem_client {
 	int mem_type;
 	void *clnt;
 	struct msm_vidc_platform_resources *res;
 	enum session_type session_type;
 	bool tme_encode_mode;
+	struct mutex map_lock;
+	struct list_head map_cache;
+	int map_cache_count;
 };
 
 static int msm_ion_get_device_address(struct smem_client *smem_client,
@@ -289,6 +305,112 @@ void msm_smem_put_handle(struct smem_client *client, void *handle)
 	return msm_ion_put_handle(client->clnt, (struct ion_handle *)handle);
 }
 
+static void msm_smem_map_entry_release(struct smem_client *client,
+		struct smem_map_entry *entry)
+{
+	msm_ion_put_device_address(client, entry->handle, entry->flags,
+		&entry->mapping_info, entry->buffer_type);
+	msm_ion_put_handle(client->clnt, entry->handle);
+	msm_ion_put_dma_buf(entry->dma_buf);
+	kfree(entry);
+}
+
+/*
+ * Dynamic buffers are unmapped when firmware returns them and mapped again
+ * when the client queues them next, which for a recycled pool means the
+ * same dma-buf every few frames. Instead of dropping the attachment, keep
+ * the last few mappings and hand them back when the same dma-buf returns.
+ * Cached buffers are not kept since mapping the attachment is what syncs
+ * them for the device.
+ */
+static bool msm_smem_map_cache_get(struct smem_client *client,
+		struct dma_buf *dma_buf, struct msm_smem *smem)
+{
+	struct smem_map_entry *entry;
+	bool found = false;
+
+	mutex_lock(&client->map_lock);
+	list_for_each_entry(entry, &client->map_cache, list) {
+		if (entry->dma_buf != dma_buf ||
+			entry->buffer_type != smem->buffer_type)
+			continue;
+		if (dma_buf->size < smem->size)
+			break;
+
+		list_del(&entry->list);
+		client->map_cache_count--;
+		found = true;
+		break;
+	}
+	mutex_unlock(&client->map_lock);
+
+	if (!found)
+		return false;
+
+	smem->dma_buf = entry->dma_buf;
+	smem->handle = entry->handle;
+	smem->mapping_info = entry->mapping_info;
+	smem->flags |= entry->flags & SMEM_SECURE;
+	smem->device_addr = entry->iova + smem->offset;
+	kfree(entry);
+
+	return true;
+}
+
+static bool msm_smem_map_cache_put(struct smem_client *client,
+		struct msm_smem *smem)
+{
+	struct smem_map_entry *entry, *evict = NULL;
+
+	if (!is_iommu_present(client->res) || smem->flags & SMEM_CACHED ||
+		!smem->mapping_info.dev)
+		return false;
+
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry)
+		return false;
+
+	entry->dma_buf = smem->dma_buf;
+	entry->handle = smem->handle;
+	entry->mapping_info = smem->mapping_info;
+	entry->iova = smem->device_addr - smem->offset;
+	entry->flags = smem->flags;
+	entry->buffer_type = smem->buffer_type;
+
+	mutex_lock(&client->map_lock);
+	list_add(&entry->list, &client->map_cache);
+	if (++client->map_cache_count > SMEM_MAP_CACHE_SIZE) {
+		evict = list_last_entry(&client->map_cache,
+			struct smem_map_entry, list);
+		list_del(&evict->list);
+		client->map_cache_count--;
+	}
+	mutex_unlock(&client->map_lock);
+
+	if (evict)
+		msm_smem_map_entry_release(client, evict);
+
+	return true;
+}
+
+void msm_smem_flush_map_cache(void *clt)
+{
+	struct smem_client *client = clt;
+	struct smem_map_entry *entry, *next;
+	LIST_HEAD(stale);
+
+	if (!client)
+		return;
+
+	mutex_lock(&client->map_lock);
+	list_splice_init(&client->map_cache, &stale);
+	client->map_cache_count = 0;
+	mutex_unlock(&client->map_lock);
+
+	list_for_each_entry_safe(entry, next, &stale, list)
+		msm_smem_map_entry_release(client, entry);
+}
+
 static int msm_ion_map_dma_buf(struct msm_vidc_inst *inst,
 		struct msm_smem *smem)
 {
@@ -312,6 +434,11 @@ static int msm_ion_map_dma_buf(struct msm_vidc_inst *inst,
 	dma_buf = msm_ion_get_dma_buf(smem->fd);
 	if (!dma_buf)
 		return -EINVAL;
+	if (msm_smem_map_cache_get(inst->mem_client, dma_buf, smem)) {
+		/* the cached mapping already holds a reference */
+		msm_ion_put_dma_buf(dma_buf);
+		return 0;
+	}
 	ion_handle = msm_ion_get_handle(ion_client, dma_buf);
 	if (!ion_handle)
 		return -EINVAL;
@@ -393,6 +520,11 @@ static int msm_ion_unmap_dma_buf(struct msm_vidc_inst *inst,
 		return -EINVAL;
 	}
 
+	if (msm_smem_map_cache_put(inst->mem_client, smem)) {
+		memset(&smem->mapping_info, 0, sizeof(smem->mapping_info));
+		goto cached;
+	}
+
 	rc = msm_ion_put_device_address(inst->mem_client, smem->handle,
 			smem->flags, &smem->mapping_info, smem->buffer_type);
 	if (rc) {
@@ -403,6 +535,7 @@ static int msm_ion_unmap_dma_buf(struct msm_vidc_inst *inst,
 	msm_ion_put_handle(inst->mem_client->clnt, smem->handle);
 	msm_ion_put_dma_buf(smem->dma_buf);
 
+cached:
 	smem->device_addr = 0x0;
 	smem->handle = NULL;
 	smem->dma_buf = NULL;
@@ -764,6 +897,8 @@ void *msm_smem_new_client(enum smem_type mtype,
 			client->clnt = clnt;
 			client->res = res;
 			client->session_type = stype;
+			mutex_init(&client->map_lock);
+			INIT_LIST_HEAD(&client->map_cache);
 		}
 	} else {
 		dprintk(VIDC_ERR, "Failed to create new client: mtype = %d\n",
@@ -840,6 +975,7 @@ void msm_smem_delete_client(void *clt)
 		dprintk(VIDC_ERR, "Invalid  client passed\n");
 		return;
 	}
+	msm_smem_flush_map_cache(client);
 	switch (client->mem_type) {
 	case SMEM_ION:
 		ion_delete_client(client);
@@ -1265,12 +1265,16 @@ static void msm_vidc_stop_streaming(struct vb2_queue *q)
 	dprintk(VIDC_DBG, "Streamoff called on: %d capability\n", q->type);
 	switch (q->type) {
 	case V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE:
-		if (!inst->bufq[CAPTURE_PORT].vb2_bufq.streaming)
+		if (!inst->bufq[CAPTURE_PORT].vb2_bufq.streaming) {
 			rc = stop_streaming(inst);
+			msm_smem_flush_map_cache(inst->mem_client);
+		}
 		break;
 	case V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE:
-		if (!inst->bufq[OUTPUT_PORT].vb2_bufq.streaming)
+		if (!inst->bufq[OUTPUT_PORT].vb2_bufq.streaming) {
 			rc = stop_streaming(inst);
+			msm_smem_flush_map_cache(inst->mem_client);
+		}
 		break;
 	default:
 		dprintk(VIDC_ERR,
@@ -1773,6 +1777,7 @@ void *msm_vidc_open(int core_id, int session_type)
 	inst->clk_data.curr_freq = 0;
 	inst->clk_data.bitrate = 0;
 	inst->clk_data.core_id = VIDC_CORE_ID_DEFAULT;
+	spin_lock_init(&inst->clk_data.fb_lock);
 	inst->bit_depth = MSM_VIDC_BIT_DEPTH_8;
 	inst->pic_struct = MSM_VIDC_PIC_STRUCT_PROGRESSIVE;
 	inst->colour_space = MSM_VIDC_BT601_6_525;
@@ -23,6 +23,9 @@
 #define MSM_VIDC_MIN_UBWC_COMPRESSION_RATIO (1 << 16)
 #define MSM_VIDC_MAX_UBWC_COMPRESSION_RATIO (5 << 16)
 
+/* Smoothed ratios are voted in steps of 1/8 to avoid re-voting per frame */
+#define MSM_VIDC_UBWC_VOTE_STEP_SHIFT 13
+
 #define MAX_WIDTH_VALUE 5760
 #define MAX_HEIGHT_VALUE 2880
 
@@ -69,6 +72,28 @@ static inline unsigned long int get_ubwc_compression_ratio(
 	return compression_ratio;
 }
 
+static inline bool ubwc_stats_valid(
+	struct ubwc_cr_stats_info_type *info)
+{
+	return info->cr_stats_info0 || info->cr_stats_info1 ||
+		info->cr_stats_info2 || info->cr_stats_info3 ||
+		info->cr_stats_info4 || info->cr_stats_info5 ||
+		info->cr_stats_info6;
+}
+
+/*
+ * Running average that follows a move towards more bandwidth quickly
+ * and a move towards less bandwidth slowly.
+ */
+static inline u32 msm_vidc_smooth_ratio(u32 avg, u32 sample, bool up)
+{
+	if (!avg)
+		return sample;
+	if ((sample > avg) == up)
+		return (avg + sample) >> 1;
+	return (avg * 7 + sample) >> 3;
+}
+
 static inline int msm_vidc_get_mbs_per_frame(struct msm_vidc_inst *inst)
 {
 	int height, width;
@@ -110,7 +135,50 @@ void update_recon_stats(struct msm_vidc_inst *inst,
 			binfo->CF = CF;
 		}
 	}
+	if (ubwc_stats_valid(&recon_stats->ubwc_stats_info)) {
+		inst->clk_data.avg_cr = msm_vidc_smooth_ratio(
+			inst->clk_data.avg_cr, CR, false);
+		inst->clk_data.avg_cf = msm_vidc_smooth_ratio(
+			inst->clk_data.avg_cf, CF, true);
+		inst->clk_data.cr_samples++;
+	}
+	mutex_unlock(&inst->reconbufs.lock);
+}
+
+/*
+ * Once enough frames have reported UBWC statistics, vote from the running
+ * averages instead of the worst buffer seen. Ratios are rounded towards
+ * more bandwidth to the vote step, so steady content produces identical
+ * votes that the bus layer does not have to act on.
+ */
+static void fill_smoothed_stats(struct msm_vidc_inst *inst,
+	struct vidc_bus_vote_data *vote_data)
+{
+	struct clock_data *dcvs = &inst->clk_data;
+	u32 step = 1 << MSM_VIDC_UBWC_VOTE_STEP_SHIFT;
+	u32 cr, cf;
+
+	mutex_lock(&inst->reconbufs.lock);
+	if (dcvs->cr_samples >= DCVS_FTB_WINDOW) {
+		cr = round_down(dcvs->avg_cr, step);
+		cf = round_up(dcvs->avg_cf, step);
+		vote_data->compression_ratio = clamp_t(u32, cr,
+			MSM_VIDC_MIN_UBWC_COMPRESSION_RATIO,
+			MSM_VIDC_MAX_UBWC_COMPRESSION_RATIO);
+		vote_data->complexity_factor = clamp_t(u32, cf,
+			MSM_VIDC_MIN_UBWC_COMPLEXITY_FACTOR,
+			MSM_VIDC_MAX_UBWC_COMPLEXITY_FACTOR);
+	}
 	mutex_unlock(&inst->reconbufs.lock);
+
+	mutex_lock(&inst->input_crs.lock);
+	if (dcvs->input_cr_samples >= DCVS_FTB_WINDOW) {
+		cr = round_down(dcvs->avg_input_cr, step);
+		vote_data->input_cr = clamp_t(u32, cr,
+			MSM_VIDC_MIN_UBWC_COMPRESSION_RATIO,
+			MSM_VIDC_MAX_UBWC_COMPRESSION_RATIO);
+	}
+	mutex_unlock(&inst->input_crs.lock);
 }
 
 static int fill_dynamic_stats(struct msm_vidc_inst *inst,
@@ -166,6 +234,9 @@ static int fill_dynamic_stats(struct msm_vidc_inst *inst,
 		vote_data->use_dpb_read = true;
 	}
 
+	if (msm_vidc_bus_refine)
+		fill_smoothed_stats(inst, vote_data);
+
 	dprintk(VIDC_PROF,
 		"Input CR = %d Recon CR = %llu Complexity Factor = %llu\n",
 			vote_data->input_cr, vote_data->compression_ratio,
@@ -529,10 +600,79 @@ static unsigned long msm_vidc_max_freq(struct msm_vidc_core *core)
 	return freq;
 }
 
+/**
+ * msm_dcvs_fb_update() - account firmware busy time for feedback DCVS
+ * @inst: video instance
+ * @in: change in the number of input buffers held by firmware
+ * @out: change in the number of output buffers held by firmware
+ * @done: an input buffer was consumed, close the current sample
+ *
+ * Firmware does not report how long it took to process a frame, so the
+ * time is measured from the host side: firmware is counted busy while it
+ * holds both an input to work on and an output to write into. Each
+ * completed input closes a sample, which is converted to core cycles at
+ * the current clock so that samples taken at different rates compare.
+ */
+void msm_dcvs_fb_update(struct msm_vidc_inst *inst, int in, int out,
+	bool done)
+{
+	struct clock_data *dcvs = &inst->clk_data;
+	u64 now = ktime_to_us(ktime_get());
+	u64 cycles;
+
+	spin_lock(&dcvs->fb_lock);
+	if (dcvs->fb_pending_in > 0 && dcvs->fb_pending_out > 0)
+		dcvs->fb_busy_us += now - dcvs->fb_last_us;
+	dcvs->fb_last_us = now;
+	dcvs->fb_pending_in = max(dcvs->fb_pending_in + in, 0);
+	dcvs->fb_pending_out = max(dcvs->fb_pending_out + out, 0);
+
+	if (done && dcvs->fb_busy_us) {
+		cycles = div_u64(dcvs->fb_busy_us *
+			inst->core->curr_freq, USEC_PER_SEC);
+		/* rise fast, decay slowly: a late frame is worse than a
+		 * slightly high clock
+		 */
+		if (!dcvs->fb_samples)
+			dcvs->fb_cycles = cycles;
+		else if (cycles > dcvs->fb_cycles)
+			dcvs->fb_cycles = (dcvs->fb_cycles + cycles) >> 1;
+		else
+			dcvs->fb_cycles = (dcvs->fb_cycles * 7 + cycles) >> 3;
+		dcvs->fb_samples++;
+		dcvs->fb_busy_us = 0;
+	}
+	spin_unlock(&dcvs->fb_lock);
+}
+
+static unsigned long msm_dcvs_fb_freq(struct msm_vidc_inst *inst)
+{
+	struct clock_data *dcvs = &inst->clk_data;
+	u64 cycles, freq;
+	u32 fps, slack;
+
+	if (!msm_vidc_dcvs_feedback || !dcvs->dcvs_mode ||
+		msm_dcvs_count_active_instances(inst->core,
+			inst->session_type) > 1)
+		return 0;
+
+	spin_lock(&dcvs->fb_lock);
+	cycles = dcvs->fb_samples >= DCVS_FTB_WINDOW ? dcvs->fb_cycles : 0;
+	spin_unlock(&dcvs->fb_lock);
+	if (!cycles)
+		return 0;
+
+	fps = max(inst->prop.fps, dcvs->operating_rate >> 16);
+	slack = min_t(u32, msm_vidc_dcvs_slack, 90);
+	freq = div_u64(cycles * fps * 100, 100 - slack);
+
+	return min_t(u64, freq, msm_vidc_max_freq(inst->core));
+}
+
 static unsigned long msm_vidc_adjust_freq(struct msm_vidc_inst *inst)
 {
 	struct vidc_freq_data *temp;
-	unsigned long freq = 0;
+	unsigned long freq = 0, fb_freq;
 	bool is_turbo = false;
 
 	mutex_lock(&inst->freqs.lock);
@@ -548,6 +688,15 @@ static unsigned long msm_vidc_adjust_freq(struct msm_vidc_inst *inst)
 	if (is_turbo) {
 		return msm_vidc_max_freq(inst->core);
 	}
+
+	/* Measured frame time, when available, overrides the estimate. */
+	fb_freq = msm_dcvs_fb_freq(inst);
+	if (fb_freq) {
+		dprintk(VIDC_PROF, "%s Inst %pK : feedback Freq = %lu\n",
+			__func__, inst, fb_freq);
+		return fb_freq;
+	}
+
 	/* If current requirement is within DCVS limits, try DCVS. */
 
 	if (freq < inst->clk_data.load_norm) {
@@ -611,6 +760,11 @@ void msm_comm_update_input_cr(struct msm_vidc_inst *inst,
 		temp->input_cr = cr;
 		list_add_tail(&temp->list, &inst->input_crs.list);
 	}
+	if (cr) {
+		inst->clk_data.avg_input_cr = msm_vidc_smooth_ratio(
+			inst->clk_data.avg_input_cr, cr, false);
+		inst->clk_data.input_cr_samples++;
+	}
 exit:
 	mutex_unlock(&inst->input_crs.lock);
 }
@@ -1028,6 +1182,14 @@ void msm_clock_data_reset(struct msm_vidc_inst *inst)
 		dcvs->load_norm;
 
 	inst->clk_data.buffer_counter = 0;
+	spin_lock(&dcvs->fb_lock);
+	dcvs->fb_samples = 0;
+	dcvs->fb_cycles = 0;
+	spin_unlock(&dcvs->fb_lock);
+	mutex_lock(&inst->reconbufs.lock);
+	dcvs->avg_cr = dcvs->avg_cf = 0;
+	dcvs->cr_samples = 0;
+	mutex_unlock(&inst->reconbufs.lock);
 
 	msm_dcvs_print_dcvs_stats(dcvs);
 
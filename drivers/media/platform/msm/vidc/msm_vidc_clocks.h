@@ -38,6 +38,8 @@ void msm_vidc_clear_freq_entry(struct msm_vidc_inst *inst,
 void msm_comm_free_input_cr_table(struct msm_vidc_inst *inst);
 void msm_comm_update_input_cr(struct msm_vidc_inst *inst, u32 index,
 	u32 cr);
+void msm_dcvs_fb_update(struct msm_vidc_inst *inst, int in, int out,
+	bool done);
 void update_recon_stats(struct msm_vidc_inst *inst,
 	struct recon_stats_type *recon_stats);
 #endif
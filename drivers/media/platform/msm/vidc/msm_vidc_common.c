@@ -2525,6 +2525,7 @@ static void handle_ebd(enum hal_command_response cmd, void *data)
 	msm_comm_put_vidc_buffer(inst, mbuf);
 	msm_comm_vb2_buffer_done(inst, vb2);
 	msm_vidc_debugfs_update(inst, MSM_VIDC_DEBUGFS_EVENT_EBD);
+	msm_dcvs_fb_update(inst, -1, 0, true);
 	kref_put_mbuf(mbuf);
 exit:
 	put_inst(inst);
@@ -2737,6 +2738,7 @@ static void handle_fbd(enum hal_command_response cmd, void *data)
 	msm_comm_put_vidc_buffer(inst, mbuf);
 	msm_comm_vb2_buffer_done(inst, vb2);
 	msm_vidc_debugfs_update(inst, MSM_VIDC_DEBUGFS_EVENT_FBD);
+	msm_dcvs_fb_update(inst, 0, -1, false);
 	kref_put_mbuf(mbuf);
 
 exit:
@@ -4179,6 +4181,7 @@ static void log_frame(struct msm_vidc_inst *inst, struct vidc_frame_data *data,
 			data->device_addr, data->filled_len,
 			data->timestamp, data->flags);
 		msm_vidc_debugfs_update(inst, MSM_VIDC_DEBUGFS_EVENT_ETB);
+		msm_dcvs_fb_update(inst, 1, 0, false);
 
 	} else if (type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
 		dprintk(VIDC_DBG,
@@ -4186,6 +4189,7 @@ static void log_frame(struct msm_vidc_inst *inst, struct vidc_frame_data *data,
 			data->device_addr, data->alloc_len,
 			data->timestamp, data->flags);
 		msm_vidc_debugfs_update(inst, MSM_VIDC_DEBUGFS_EVENT_FTB);
+		msm_dcvs_fb_update(inst, 0, 1, false);
 	}
 }
 
@@ -30,6 +30,9 @@ bool msm_vidc_sys_idle_indicator = !true;
 bool msm_vidc_thermal_mitigation_disabled = !true;
 bool msm_vidc_clock_scaling = true;
 bool msm_vidc_syscache_disable = !true;
+bool msm_vidc_dcvs_feedback = !true;
+u32 msm_vidc_dcvs_slack = 20;
+bool msm_vidc_bus_refine = true;
 
 #define MAX_DBG_BUF_SIZE 4096
 
@@ -205,7 +208,11 @@ struct dentry *msm_vidc_debugfs_init_drv(void)
 	__debugfs_create(bool, "clock_scaling",
 			&msm_vidc_clock_scaling) &&
 	__debugfs_create(bool, "disable_video_syscache",
-			&msm_vidc_syscache_disable);
+			&msm_vidc_syscache_disable) &&
+	__debugfs_create(bool, "dcvs_feedback",
+			&msm_vidc_dcvs_feedback) &&
+	__debugfs_create(u32, "dcvs_slack", &msm_vidc_dcvs_slack) &&
+	__debugfs_create(bool, "bus_refine", &msm_vidc_bus_refine);
 
 #undef __debugfs_create
 
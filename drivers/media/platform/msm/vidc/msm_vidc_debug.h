@@ -62,6 +62,9 @@ extern bool msm_vidc_sys_idle_indicator;
 extern bool msm_vidc_thermal_mitigation_disabled;
 extern bool msm_vidc_clock_scaling;
 extern bool msm_vidc_syscache_disable;
+extern bool msm_vidc_dcvs_feedback;
+extern u32 msm_vidc_dcvs_slack;
+extern bool msm_vidc_bus_refine;
 
 #define VIDC_MSG_PRIO2STRING(__level) ({ \
 	char *__str; \
@@ -338,6 +338,18 @@ struct clock_data {
 	enum hal_work_mode work_mode;
 	bool low_latency_mode;
 	bool turbo_mode;
+	spinlock_t fb_lock;
+	int fb_pending_in;
+	int fb_pending_out;
+	u64 fb_last_us;
+	u64 fb_busy_us;
+	u64 fb_cycles;
+	u32 fb_samples;
+	u32 avg_cr;
+	u32 avg_cf;
+	u32 avg_input_cr;
+	u32 cr_samples;
+	u32 input_cr_samples;
 };
 
 struct profile_data {
@@ -500,6 +512,7 @@ struct context_bank_info *msm_smem_get_context_bank(void *clt,
 		bool is_secure, enum hal_buffer buffer_type);
 int msm_smem_map_dma_buf(struct msm_vidc_inst *inst, struct msm_smem *smem);
 int msm_smem_unmap_dma_buf(struct msm_vidc_inst *inst, struct msm_smem *smem);
+void msm_smem_flush_map_cache(void *clt);
 void *msm_smem_get_dma_buf(int fd);
 void msm_smem_put_dma_buf(void *dma_buf);
 void *msm_smem_get_handle(struct smem_client *client, void *dma_buf);
@@ -922,6 +922,15 @@ static int venus_hfi_vote_buses(void *dev, struct vidc_bus_vote_data *d, int n)
 		return -EINVAL;
 
 	mutex_lock(&device->lock);
+	/*
+	 * Votes are refreshed on every queued buffer; leave the bus
+	 * governors alone when nothing changed since the last one.
+	 */
+	if (n && n == device->bus_vote.data_count && device->bus_vote.data &&
+		!memcmp(device->bus_vote.data, d, n * sizeof(*d))) {
+		mutex_unlock(&device->lock);
+		return 0;
+	}
 	rc = __vote_buses(device, d, n);
 	mutex_unlock(&device->lock);
 
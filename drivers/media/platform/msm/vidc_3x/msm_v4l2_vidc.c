@@ -23,6 +23,7 @@
 #include <linux/types.h>
 #include <linux/version.h>
 #include <linux/io.h>
+#include <linux/msm_ion.h>
 #include <media/msm_vidc.h>
 #include "msm_vidc_common.h"
 #include "msm_vidc_debug.h"
@@ -53,6 +54,8 @@ static int msm_v4l2_open(struct file *filp)
 	struct msm_vidc_inst *vidc_inst;
 
 	trace_msm_v4l2_vidc_open_start("msm_v4l2_open start");
+	/* Buffer allocation follows right after, get the ION pools ready */
+	ion_system_heap_prefill_kick();
 	vidc_inst = msm_vidc_open(core->id, vid_dev->type);
 	if (!vidc_inst) {
 		dprintk(VIDC_ERR,
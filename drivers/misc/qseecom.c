@@ -3400,12 +3400,33 @@ int __qseecom_process_reentrancy(struct qseecom_command_scm_resp *resp,
 	}
 }
 
+/*
+ * The part of the shared buffer a command can touch: from the start of the
+ * lower of the request and response buffers to the end of the higher one.
+ * Cache maintenance is limited to it rather than the whole shared buffer,
+ * which for some clients is several hundred KB.
+ */
+static void __qseecom_cmd_span(struct qseecom_dev_handle *data,
+				struct qseecom_send_cmd_req *req,
+				void **start, size_t *len)
+{
+	uintptr_t req_start = (uintptr_t)req->cmd_req_buf;
+	uintptr_t rsp_start = (uintptr_t)req->resp_buf;
+	uintptr_t lo = min(req_start, rsp_start);
+	uintptr_t hi = max(req_start + req->cmd_req_len,
+			   rsp_start + req->resp_len);
+
+	*start = (void *)__qseecom_uvirt_to_kvirt(data, lo);
+	*len = hi - lo;
+}
+
 static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 				struct qseecom_send_cmd_req *req)
 {
 	int ret = 0;
 	int ret2 = 0;
-	u32 reqd_len_sb_in = 0;
+	void *span;
+	size_t span_len;
 	struct qseecom_client_send_data_ireq send_data_req = {0};
 	struct qseecom_client_send_data_64bit_ireq send_data_req_64bit = {0};
 	struct qseecom_command_scm_resp resp;
@@ -3416,7 +3437,7 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 	size_t cmd_len;
 	struct sglist_info *table = data->sglistinfo_ptr;
 
-	reqd_len_sb_in = req->cmd_req_len + req->resp_len;
+	__qseecom_cmd_span(data, req, &span, &span_len);
 	/* find app_id & img_name from list */
 	spin_lock_irqsave(&qseecom.registered_app_list_lock, flags);
 	list_for_each_entry(ptr_app, &qseecom.registered_app_list_head,
@@ -3494,8 +3515,7 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 		*(uint32_t *)cmd_buf = QSEOS_CLIENT_SEND_DATA_COMMAND_WHITELIST;
 
 	ret = msm_ion_do_cache_op(qseecom.ion_clnt, data->client.ihandle,
-					data->client.sb_virt,
-					reqd_len_sb_in,
+					span, span_len,
 					ION_IOC_CLEAN_INV_CACHES);
 	if (ret) {
 		pr_err("cache operation failed %d\n", ret);
@@ -3536,8 +3556,7 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 	}
 exit:
 	ret2 = msm_ion_do_cache_op(qseecom.ion_clnt, data->client.ihandle,
-				data->client.sb_virt, data->client.sb_length,
-				ION_IOC_INV_CACHES);
+				span, span_len, ION_IOC_INV_CACHES);
 	if (ret2) {
 		pr_err("cache operation failed %d\n", ret2);
 		return ret2;
@@ -31,9 +31,11 @@ static DEFINE_SPINLOCK(alloc_lock);
 #define PRE_ALLOC_DEBUGFS_FILE_OBJ	"status"
 
 static struct dentry *debug_base;
+static bool wcnss_prealloc_ready;
 
 struct wcnss_prealloc {
 	int occupied;
+	int bucket;
 	size_t size;
 	void *ptr;
 #ifdef CONFIG_SLUB_DEBUG
@@ -42,98 +44,145 @@ struct wcnss_prealloc {
 #endif
 };
 
-/* pre-alloced mem for WLAN driver */
-static struct wcnss_prealloc wcnss_allocs[] = {
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 128 * 1024, NULL},
-	{0, 128 * 1024, NULL},
+/* sizes of the pre-alloced buffers for WLAN driver, in ascending order */
+static const size_t wcnss_prealloc_sizes[] = {
+	8 * 1024,
+	16 * 1024,
+	32 * 1024,
+	64 * 1024,
+	128 * 1024,
 };
 
-int wcnss_prealloc_init(void)
+#define WCNSS_PREALLOC_BUCKETS		ARRAY_SIZE(wcnss_prealloc_sizes)
+#define WCNSS_PREALLOC_MAX_SLOTS	256
+
+/* number of buffers of each size, can be changed with the layout param */
+static unsigned int wcnss_prealloc_count[WCNSS_PREALLOC_BUCKETS] = {
+	8, 42, 10, 4, 2,
+};
+
+/*
+ * Usage of each bucket, by the size requested rather than by the buffer
+ * that served it, so that the pool can be resized to what the WLAN driver
+ * really asks for. Requests larger than the largest bucket are counted as
+ * misses of that bucket.
+ */
+struct wcnss_prealloc_stats {
+	unsigned int in_use;
+	unsigned int peak;
+	unsigned long gets;
+	unsigned long spills;
+	unsigned long misses;
+};
+
+static struct wcnss_prealloc_stats wcnss_stats[WCNSS_PREALLOC_BUCKETS];
+
+static struct wcnss_prealloc *wcnss_allocs;
+static int wcnss_nr_allocs;
+
+static int wcnss_prealloc_bucket(size_t size)
 {
 	int i;
 
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		wcnss_allocs[i].occupied = 0;
-		wcnss_allocs[i].ptr = kmalloc(wcnss_allocs[i].size, GFP_KERNEL);
-		if (!wcnss_allocs[i].ptr)
-			return -ENOMEM;
+	for (i = 0; i < WCNSS_PREALLOC_BUCKETS - 1; i++)
+		if (size <= wcnss_prealloc_sizes[i])
+			break;
+
+	return i;
+}
+
+static void wcnss_prealloc_free_slots(struct wcnss_prealloc *allocs, int nr)
+{
+	int i;
+
+	for (i = 0; i < nr; i++)
+		kfree(allocs[i].ptr);
+	kfree(allocs);
+}
+
+static struct wcnss_prealloc *
+wcnss_prealloc_alloc_slots(const unsigned int *count, int *nr)
+{
+	struct wcnss_prealloc *allocs;
+	int i, j, n = 0;
+
+	for (i = 0; i < WCNSS_PREALLOC_BUCKETS; i++)
+		n += count[i];
+
+	allocs = kcalloc(n ? n : 1, sizeof(*allocs), GFP_KERNEL);
+	if (!allocs)
+		return NULL;
+
+	n = 0;
+	for (i = 0; i < WCNSS_PREALLOC_BUCKETS; i++) {
+		for (j = 0; j < count[i]; j++, n++) {
+			allocs[n].size = wcnss_prealloc_sizes[i];
+			allocs[n].ptr = kmalloc(allocs[n].size, GFP_KERNEL);
+			if (!allocs[n].ptr) {
+				wcnss_prealloc_free_slots(allocs, n);
+				return NULL;
+			}
+		}
 	}
 
+	*nr = n;
+
+	return allocs;
+}
+
+int wcnss_prealloc_init(void)
+{
+	wcnss_allocs = wcnss_prealloc_alloc_slots(wcnss_prealloc_count,
+						  &wcnss_nr_allocs);
+	if (!wcnss_allocs)
+		return -ENOMEM;
+
 	return 0;
 }
 
 void wcnss_prealloc_deinit(void)
 {
-	int i = 0;
+	wcnss_prealloc_free_slots(wcnss_allocs, wcnss_nr_allocs);
+	wcnss_allocs = NULL;
+	wcnss_nr_allocs = 0;
+}
+
+/*
+ * Replace the pool by one with the given number of buffers per bucket. This
+ * only works while none of the buffers is handed out, i.e. before the WLAN
+ * driver is loaded or after it has released everything.
+ */
+static int wcnss_prealloc_resize(const unsigned int *count)
+{
+	struct wcnss_prealloc *allocs, *old;
+	unsigned long flags;
+	int i, nr, old_nr;
+
+	allocs = wcnss_prealloc_alloc_slots(count, &nr);
+	if (!allocs)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&alloc_lock, flags);
+	for (i = 0; i < wcnss_nr_allocs; i++)
+		if (wcnss_allocs[i].occupied)
+			break;
 
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		kfree(wcnss_allocs[i].ptr);
-		wcnss_allocs[i].ptr = NULL;
+	if (i < wcnss_nr_allocs) {
+		spin_unlock_irqrestore(&alloc_lock, flags);
+		wcnss_prealloc_free_slots(allocs, nr);
+		return -EBUSY;
 	}
+
+	old = wcnss_allocs;
+	old_nr = wcnss_nr_allocs;
+	wcnss_allocs = allocs;
+	wcnss_nr_allocs = nr;
+	memcpy(wcnss_prealloc_count, count, sizeof(wcnss_prealloc_count));
+	spin_unlock_irqrestore(&alloc_lock, flags);
+
+	wcnss_prealloc_free_slots(old, old_nr);
+
+	return 0;
 }
 
 #ifdef CONFIG_SLUB_DEBUG
@@ -156,37 +205,61 @@ void wcnss_prealloc_save_stack_trace(struct wcnss_prealloc *entry) {}
 
 void *wcnss_prealloc_get(size_t size)
 {
+	struct wcnss_prealloc_stats *stats;
 	int i = 0;
 	unsigned long flags;
 
 	spin_lock_irqsave(&alloc_lock, flags);
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
+	stats = &wcnss_stats[wcnss_prealloc_bucket(size)];
+	stats->gets++;
+	for (i = 0; i < wcnss_nr_allocs; i++) {
 		if (wcnss_allocs[i].occupied)
 			continue;
 
 		if (wcnss_allocs[i].size >= size) {
 			/* we found the slot */
 			wcnss_allocs[i].occupied = 1;
+			wcnss_allocs[i].bucket = stats - wcnss_stats;
+			if (wcnss_allocs[i].size > wcnss_prealloc_sizes[
+						wcnss_allocs[i].bucket])
+				stats->spills++;
+			stats->in_use++;
+			stats->peak = max(stats->peak, stats->in_use);
 			spin_unlock_irqrestore(&alloc_lock, flags);
 			wcnss_prealloc_save_stack_trace(&wcnss_allocs[i]);
 			return wcnss_allocs[i].ptr;
 		}
 	}
+
+	/*
+	 * The caller falls back to kmalloc. Whatever it allocates is not
+	 * given back through us, so only note that at this point one more
+	 * buffer of this size would have been needed.
+	 */
+	stats->misses++;
+	if (size <= wcnss_prealloc_sizes[WCNSS_PREALLOC_BUCKETS - 1])
+		stats->peak = max(stats->peak, stats->in_use + 1);
 	spin_unlock_irqrestore(&alloc_lock, flags);
 
 	return NULL;
 }
 EXPORT_SYMBOL(wcnss_prealloc_get);
 
+static void wcnss_prealloc_release(struct wcnss_prealloc *entry)
+{
+	entry->occupied = 0;
+	wcnss_stats[entry->bucket].in_use--;
+}
+
 int wcnss_prealloc_put(void *ptr)
 {
 	int i = 0;
 	unsigned long flags;
 
 	spin_lock_irqsave(&alloc_lock, flags);
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
+	for (i = 0; i < wcnss_nr_allocs; i++) {
 		if (wcnss_allocs[i].ptr == ptr) {
-			wcnss_allocs[i].occupied = 0;
+			wcnss_prealloc_release(&wcnss_allocs[i]);
 			spin_unlock_irqrestore(&alloc_lock, flags);
 			return 1;
 		}
@@ -202,7 +275,7 @@ void wcnss_prealloc_check_memory_leak(void)
 {
 	int i, j = 0;
 
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
+	for (i = 0; i < wcnss_nr_allocs; i++) {
 		if (!wcnss_allocs[i].occupied)
 			continue;
 
@@ -224,14 +297,17 @@ EXPORT_SYMBOL(wcnss_prealloc_check_memory_leak);
 int wcnss_pre_alloc_reset(void)
 {
 	int i, n = 0;
+	unsigned long flags;
 
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
+	spin_lock_irqsave(&alloc_lock, flags);
+	for (i = 0; i < wcnss_nr_allocs; i++) {
 		if (!wcnss_allocs[i].occupied)
 			continue;
 
-		wcnss_allocs[i].occupied = 0;
+		wcnss_prealloc_release(&wcnss_allocs[i]);
 		n++;
 	}
+	spin_unlock_irqrestore(&alloc_lock, flags);
 
 	return n;
 }
@@ -244,7 +320,7 @@ static int prealloc_memory_stats_show(struct seq_file *fp, void *data)
 	unsigned int tsize = 0, tused = 0, size = 0;
 
 	seq_puts(fp, "\nSlot_Size(Kb)\t\t[Used : Free]\n");
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
+	for (i = 0; i < wcnss_nr_allocs; i++) {
 		tsize += wcnss_allocs[i].size;
 		if (size != wcnss_allocs[i].size) {
 			if (size) {
@@ -276,6 +352,14 @@ static int prealloc_memory_stats_show(struct seq_file *fp, void *data)
 	seq_printf(fp, "\nMemory Status:\nTotal Memory: %dKb\n", tsize);
 	seq_printf(fp, "Used: %dKb\nFree: %dKb\n", tused, tsize - tused);
 
+	seq_puts(fp, "\nReq_Size(Kb)\tSlots\tInUse\tPeak\tGets\tSpills\tMisses\n");
+	for (i = 0; i < WCNSS_PREALLOC_BUCKETS; i++)
+		seq_printf(fp, "%zu Kb\t\t%u\t%u\t%u\t%lu\t%lu\t%lu\n",
+			   wcnss_prealloc_sizes[i] / 1024,
+			   wcnss_prealloc_count[i], wcnss_stats[i].in_use,
+			   wcnss_stats[i].peak, wcnss_stats[i].gets,
+			   wcnss_stats[i].spills, wcnss_stats[i].misses);
+
 	return 0;
 }
 
@@ -292,6 +376,75 @@ static const struct file_operations prealloc_memory_stats_fops = {
 	.release = single_release,
 };
 
+/*
+ * The layout parameter lists the number of buffers of each size, smallest
+ * first, e.g. "8,42,10,4,2". Reading it back gives the peak usage seen
+ * since boot, so that userspace can persist it and hand it back on the
+ * next boot before the WLAN driver is loaded. Buckets that were never used
+ * then stop taking memory, and sizes that ran short grow by what was missed.
+ */
+static int wcnss_prealloc_layout_set(const char *val,
+				     const struct kernel_param *kp)
+{
+	unsigned int count[WCNSS_PREALLOC_BUCKETS];
+	unsigned int total = 0;
+	char *buf, *cur, *tok;
+	int i = 0, ret = 0;
+
+	buf = kstrdup(val, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	cur = strim(buf);
+	while ((tok = strsep(&cur, ",")) != NULL) {
+		if (i == WCNSS_PREALLOC_BUCKETS ||
+		    kstrtouint(tok, 0, &count[i])) {
+			ret = -EINVAL;
+			goto out;
+		}
+		total += count[i++];
+	}
+
+	if (i != WCNSS_PREALLOC_BUCKETS || total > WCNSS_PREALLOC_MAX_SLOTS) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	if (wcnss_prealloc_ready)
+		ret = wcnss_prealloc_resize(count);
+	else
+		memcpy(wcnss_prealloc_count, count,
+		       sizeof(wcnss_prealloc_count));
+
+out:
+	kfree(buf);
+
+	return ret;
+}
+
+static int wcnss_prealloc_layout_get(char *buf,
+				     const struct kernel_param *kp)
+{
+	unsigned long flags;
+	int i, len = 0;
+
+	spin_lock_irqsave(&alloc_lock, flags);
+	for (i = 0; i < WCNSS_PREALLOC_BUCKETS; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%s%u",
+				 i ? "," : "", wcnss_stats[i].peak);
+	spin_unlock_irqrestore(&alloc_lock, flags);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+
+	return len;
+}
+
+static const struct kernel_param_ops wcnss_prealloc_layout_ops = {
+	.set = wcnss_prealloc_layout_set,
+	.get = wcnss_prealloc_layout_get,
+};
+
+module_param_cb(layout, &wcnss_prealloc_layout_ops, NULL, 0600);
+
 static int __init wcnss_pre_alloc_init(void)
 {
 	int ret;
@@ -301,6 +454,7 @@ static int __init wcnss_pre_alloc_init(void)
 		pr_err("%s: Failed to init the prealloc pool\n", __func__);
 		return ret;
 	}
+	wcnss_prealloc_ready = true;
 
 	debug_base = debugfs_create_dir(PRE_ALLOC_DEBUGFS_DIR, NULL);
 	if (IS_ERR_OR_NULL(debug_base)) {
@@ -581,6 +581,11 @@ struct msm_pcie_dev_t {
 	ulong				linkdown_counter;
 	ulong				link_turned_on_counter;
 	ulong				link_turned_off_counter;
+	ktime_t				link_off_time;
+	ulong				resume_lat_avg_us;
+	ulong				resume_lat_max_us;
+	ulong				idle_gap_avg_ms;
+	ulong				short_idle_counter;
 	ulong				rc_corr_counter;
 	ulong				rc_non_fatal_counter;
 	ulong				rc_fatal_counter;
@@ -1149,6 +1154,47 @@ static void pcie_parf_dump(struct msm_pcie_dev_t *dev)
 	}
 }
 
+/*
+ * A link that is turned off must stay off for several times its resume
+ * latency to save more than it costs, so a client inactivity timer much
+ * shorter than that mostly adds latency to bursty traffic.
+ */
+#define MSM_PCIE_IDLE_BREAKEVEN		10
+
+static ulong msm_pcie_idle_hint_ms(struct msm_pcie_dev_t *dev)
+{
+	return DIV_ROUND_UP(dev->resume_lat_avg_us * MSM_PCIE_IDLE_BREAKEVEN,
+			    USEC_PER_MSEC);
+}
+
+static void msm_pcie_account_resume(struct msm_pcie_dev_t *dev,
+				    ktime_t start)
+{
+	ktime_t now = ktime_get();
+	ulong lat_us = ktime_us_delta(now, start);
+	ulong gap_ms;
+
+	/* exponentially weighted, 1/8 of the newest sample */
+	if (dev->resume_lat_avg_us)
+		dev->resume_lat_avg_us += ((long)lat_us -
+					   (long)dev->resume_lat_avg_us) / 8;
+	else
+		dev->resume_lat_avg_us = lat_us;
+	dev->resume_lat_max_us = max(dev->resume_lat_max_us, lat_us);
+
+	if (!ktime_to_ns(dev->link_off_time))
+		return;
+
+	gap_ms = ktime_ms_delta(start, dev->link_off_time);
+	if (dev->idle_gap_avg_ms)
+		dev->idle_gap_avg_ms += ((long)gap_ms -
+					 (long)dev->idle_gap_avg_ms) / 8;
+	else
+		dev->idle_gap_avg_ms = gap_ms;
+	if (gap_ms < msm_pcie_idle_hint_ms(dev))
+		dev->short_idle_counter++;
+}
+
 static void msm_pcie_show_status(struct msm_pcie_dev_t *dev)
 {
 	PCIE_DBG_FS(dev, "PCIe: RC%d is %s enumerated\n",
@@ -1260,6 +1306,16 @@ static void msm_pcie_show_status(struct msm_pcie_dev_t *dev)
 		dev->link_turned_on_counter);
 	PCIE_DBG_FS(dev, "link_turned_off_counter: %lu\n",
 		dev->link_turned_off_counter);
+	PCIE_DBG_FS(dev, "resume_lat_avg_us: %lu\n",
+		dev->resume_lat_avg_us);
+	PCIE_DBG_FS(dev, "resume_lat_max_us: %lu\n",
+		dev->resume_lat_max_us);
+	PCIE_DBG_FS(dev, "idle_gap_avg_ms: %lu\n",
+		dev->idle_gap_avg_ms);
+	PCIE_DBG_FS(dev, "short_idle_counter: %lu\n",
+		dev->short_idle_counter);
+	PCIE_DBG_FS(dev, "idle_hint_ms: %lu\n",
+		msm_pcie_idle_hint_ms(dev));
 }
 
 static void msm_pcie_shadow_dump(struct msm_pcie_dev_t *dev, bool rc)
@@ -6344,6 +6400,7 @@ static int msm_pcie_pm_suspend(struct pci_dev *dev,
 					pcie_dev->pins_sleep);
 
 	msm_pcie_disable(pcie_dev, PM_PIPE_CLK | PM_CLK | PM_VREG);
+	pcie_dev->link_off_time = ktime_get();
 
 	PCIE_DBG(pcie_dev, "RC%d: exit\n", pcie_dev->rc_idx);
 
@@ -6392,6 +6449,7 @@ static int msm_pcie_pm_resume(struct pci_dev *dev,
 {
 	int ret;
 	struct msm_pcie_dev_t *pcie_dev = PCIE_BUS_PRIV_DATA(dev->bus);
+	ktime_t start = ktime_get();
 
 	PCIE_DBG(pcie_dev, "RC%d: entry\n", pcie_dev->rc_idx);
 
@@ -6414,6 +6472,7 @@ static int msm_pcie_pm_resume(struct pci_dev *dev,
 	}
 
 	pcie_dev->suspending = false;
+	msm_pcie_account_resume(pcie_dev, start);
 	PCIE_DBG(pcie_dev,
 		"dev->bus->number = %d dev->bus->primary = %d\n",
 		 dev->bus->number, dev->bus->primary);
@@ -6867,3 +6926,20 @@ int msm_pcie_shadow_control(struct pci_dev *dev, bool enable)
 	return ret;
 }
 EXPORT_SYMBOL(msm_pcie_shadow_control);
+
+int msm_pcie_pm_idle_hint(struct pci_dev *dev)
+{
+	struct msm_pcie_dev_t *pcie_dev;
+
+	if (!dev) {
+		pr_err("PCIe: the input pci dev is NULL.\n");
+		return -ENODEV;
+	}
+
+	pcie_dev = PCIE_BUS_PRIV_DATA(dev->bus);
+	if (!pcie_dev->resume_lat_avg_us)
+		return -EAGAIN;
+
+	return msm_pcie_idle_hint_ms(pcie_dev);
+}
+EXPORT_SYMBOL(msm_pcie_pm_idle_hint);
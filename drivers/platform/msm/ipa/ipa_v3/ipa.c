@@ -5410,6 +5410,11 @@ static int ipa3_pre_init(const struct ipa3_plat_drv_res *resource_p,
 	ipa3_ctx->use_64_bit_dma_mask = resource_p->use_64_bit_dma_mask;
 	ipa3_ctx->wan_rx_ring_size = resource_p->wan_rx_ring_size;
 	ipa3_ctx->lan_rx_ring_size = resource_p->lan_rx_ring_size;
+	ipa3_ctx->rx_page_pool = resource_p->rx_page_pool;
+	ipa3_ctx->rx_mod_bulk_kbps = IPA_RX_MOD_BULK_KBPS;
+	ipa3_ctx->rx_mod_defer_us = IPA_RX_MOD_DEFER_US;
+	ipa3_ctx->rx_mod_defer_max = IPA_RX_MOD_DEFER_MAX;
+	ipa3_ctx->nat_offload_scan_ms = IPA_NAT_OFFLOAD_SCAN_MS;
 	ipa3_ctx->skip_uc_pipe_reset = resource_p->skip_uc_pipe_reset;
 	ipa3_ctx->tethered_flow_control = resource_p->tethered_flow_control;
 	ipa3_ctx->ee = resource_p->ee;
@@ -6036,6 +6041,13 @@ static int get_ipa_dts_configuration(struct platform_device *pdev,
 		IPADBG(": found ipa_drv_res->lan-rx-ring-size = %u",
 			ipa_drv_res->lan_rx_ring_size);
 
+	ipa_drv_res->rx_page_pool =
+			of_property_read_bool(pdev->dev.of_node,
+			"qcom,rx-page-pool");
+	IPADBG(": rx page pool = %s\n",
+		ipa_drv_res->rx_page_pool
+		? "True" : "False");
+
 	ipa_drv_res->use_ipa_teth_bridge =
 			of_property_read_bool(pdev->dev.of_node,
 			"qcom,use-ipa-tethering-bridge");
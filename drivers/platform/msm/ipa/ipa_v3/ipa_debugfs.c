@@ -1990,6 +1990,44 @@ static ssize_t ipa_status_stats_read(struct file *file, char __user *ubuf,
 	return 0;
 }
 
+static ssize_t ipa3_read_rx_page_pool(struct file *file, char __user *ubuf,
+		size_t count, loff_t *ppos)
+{
+	struct ipa3_page_pool *pool;
+	struct ipa3_sys_context *sys;
+	int nbytes;
+	int cnt = 0;
+	int i;
+
+	for (i = 0; i < ipa3_ctx->ipa_num_pipes; i++) {
+		sys = ipa3_ctx->ep[i].sys;
+		if (!ipa3_ctx->ep[i].valid || !sys || !sys->page_pool)
+			continue;
+
+		pool = sys->page_pool;
+		nbytes = scnprintf(dbg_buff + cnt, IPA_MAX_MSG_LEN - cnt,
+			"client=%s ep=%d order=%u\n"
+			"alloc=%u\n"
+			"alloc_fail=%u\n"
+			"recycled=%u\n"
+			"busy=%u\n"
+			"released=%u\n"
+			"pooled=%u\n",
+			ipa_clients_strings[ipa3_ctx->ep[i].client], i,
+			pool->order,
+			pool->stats.alloc,
+			pool->stats.alloc_fail,
+			pool->stats.recycled,
+			pool->stats.busy,
+			pool->stats.released,
+			(pool->tail + pool->capacity - pool->head) %
+			pool->capacity);
+		cnt += nbytes;
+	}
+
+	return simple_read_from_buffer(ubuf, count, ppos, dbg_buff, cnt);
+}
+
 static ssize_t ipa3_print_active_clients_log(struct file *file,
 		char __user *ubuf, size_t count, loff_t *ppos)
 {
@@ -2190,6 +2228,10 @@ static const struct ipa3_debugfs_file debugfs_files[] = {
 		"status_stats", IPA_READ_ONLY_MODE, NULL, {
 			.read = ipa_status_stats_read,
 		}
+	}, {
+		"rx_page_pool", IPA_READ_ONLY_MODE, NULL, {
+			.read = ipa3_read_rx_page_pool,
+		}
 	}, {
 		"enable_low_prio_print", IPA_WRITE_ONLY_MODE, NULL, {
 			.write = ipa3_enable_ipc_low,
@@ -2270,6 +2312,41 @@ void ipa3_debugfs_init(void)
 		goto fail;
 	}
 
+	file = debugfs_create_u32("rx_mod_bulk_kbps", IPA_READ_WRITE_MODE,
+		dent, &ipa3_ctx->rx_mod_bulk_kbps);
+	if (!file) {
+		IPAERR("could not create rx_mod_bulk_kbps file\n");
+		goto fail;
+	}
+
+	file = debugfs_create_u32("rx_mod_defer_us", IPA_READ_WRITE_MODE,
+		dent, &ipa3_ctx->rx_mod_defer_us);
+	if (!file) {
+		IPAERR("could not create rx_mod_defer_us file\n");
+		goto fail;
+	}
+
+	file = debugfs_create_u32("rx_mod_defer_max", IPA_READ_WRITE_MODE,
+		dent, &ipa3_ctx->rx_mod_defer_max);
+	if (!file) {
+		IPAERR("could not create rx_mod_defer_max file\n");
+		goto fail;
+	}
+
+	file = debugfs_create_u32("nat_offload", IPA_READ_WRITE_MODE,
+		dent, &ipa3_ctx->nat_offload_enable);
+	if (!file) {
+		IPAERR("could not create nat_offload file\n");
+		goto fail;
+	}
+
+	file = debugfs_create_u32("nat_offload_scan_ms", IPA_READ_WRITE_MODE,
+		dent, &ipa3_ctx->nat_offload_scan_ms);
+	if (!file) {
+		IPAERR("could not create nat_offload_scan_ms file\n");
+		goto fail;
+	}
+
 	ipa_debugfs_init_stats(dent);
 
 	return;
@@ -16,6 +16,7 @@
 #include <linux/list.h>
 #include <linux/netdevice.h>
 #include <linux/msm_gsi.h>
+#include <net/rx_latency.h>
 #include "ipa_i.h"
 #include "ipa_trace.h"
 #include "ipahal/ipahal.h"
@@ -29,6 +30,9 @@
 #define POLLING_INACTIVITY_TX 40
 #define POLLING_MIN_SLEEP_TX 400
 #define POLLING_MAX_SLEEP_TX 500
+/* idle polling cycles before a pipe below the bulk rate re-arms its irq */
+#define POLLING_INACTIVITY_RX_LOW 2
+#define IPA_RX_MOD_WINDOW_MS 50
 /* 8K less 1 nominal MTU (1500 bytes) rounded to units of KB */
 #define IPA_MTU 1500
 #define IPA_GENERIC_AGGR_BYTE_LIMIT 6
@@ -83,6 +87,8 @@ static void ipa3_replenish_wlan_rx_cache(struct ipa3_sys_context *sys);
 static void ipa3_replenish_rx_cache(struct ipa3_sys_context *sys);
 static void ipa3_replenish_rx_work_func(struct work_struct *work);
 static void ipa3_fast_replenish_rx_cache(struct ipa3_sys_context *sys);
+static void ipa3_replenish_rx_page_pool(struct ipa3_sys_context *sys);
+static int ipa3_alloc_page_pool(struct ipa3_sys_context *sys);
 static void ipa3_wq_handle_rx(struct work_struct *work);
 static void ipa3_wq_rx_common(struct ipa3_sys_context *sys, u32 size);
 static void ipa3_wlan_wq_rx_common(struct ipa3_sys_context *sys,
@@ -700,6 +706,45 @@ int ipa3_send_cmd_timeout(u16 num_desc, struct ipa3_desc *descr, u32 timeout)
 	return result;
 }
 
+/**
+ * ipa3_rx_mod_update() - account a completed Rx buffer to the pipe's rate
+ * @sys: consumer pipe
+ * @len: bytes in the buffer
+ *
+ * The rate is measured over windows of IPA_RX_MOD_WINDOW_MS. As a window
+ * only closes on a completion, the first buffer after an idle period closes
+ * it with a low rate.
+ */
+static void ipa3_rx_mod_update(struct ipa3_sys_context *sys, u32 len)
+{
+	struct ipa3_rx_mod *mod = &sys->rx_mod;
+	ktime_t now = ktime_get();
+	s64 us;
+
+	mod->window_bytes += len;
+	us = ktime_us_delta(now, mod->window_start);
+	if (us < IPA_RX_MOD_WINDOW_MS * USEC_PER_MSEC)
+		return;
+
+	mod->rate_kbps = div64_u64((u64)mod->window_bytes * 8 * MSEC_PER_SEC,
+		us);
+	mod->bulk = mod->rate_kbps >= ipa3_ctx->rx_mod_bulk_kbps;
+	mod->window_start = now;
+	mod->window_bytes = 0;
+}
+
+static bool ipa3_rx_mod_is_bulk(struct ipa3_sys_context *sys)
+{
+	struct ipa3_rx_mod *mod = &sys->rx_mod;
+
+	/* nothing completed for two windows, the rate is stale */
+	if (ktime_us_delta(ktime_get(), mod->window_start) >
+	    2 * IPA_RX_MOD_WINDOW_MS * USEC_PER_MSEC)
+		return false;
+
+	return mod->bulk;
+}
+
 /**
  * ipa3_handle_rx_core() - The core functionality of packet reception. This
  * function is read from multiple code paths.
@@ -732,14 +777,16 @@ static int ipa3_handle_rx_core(struct ipa3_sys_context *sys, bool process_all,
 		if (ret)
 			break;
 
-		if (IPA_CLIENT_IS_MEMCPY_DMA_CONS(sys->ep->client))
+		if (IPA_CLIENT_IS_MEMCPY_DMA_CONS(sys->ep->client)) {
+			ipa3_rx_mod_update(sys, mem_info.size);
 			ipa3_dma_memcpy_notify(sys, &mem_info);
-		else if (IPA_CLIENT_IS_WLAN_CONS(sys->ep->client))
+		} else if (IPA_CLIENT_IS_WLAN_CONS(sys->ep->client)) {
 			ipa3_wlan_wq_rx_common(
 			(struct ipa3_sys_context *)(notify.chan_user_data),
 			mem_info.size);
-		else
+		} else {
 			ipa3_wq_rx_common(sys, mem_info.size);
+		}
 
 		++cnt;
 	}
@@ -795,6 +842,7 @@ static void ipa3_rx_switch_to_intr_mode(struct ipa3_sys_context *sys)
 static void ipa3_handle_rx(struct ipa3_sys_context *sys)
 {
 	int inactive_cycles = 0;
+	int max_inactive;
 	int cnt;
 
 	if (ipa3_ctx->use_ipa_pm)
@@ -808,6 +856,16 @@ static void ipa3_handle_rx(struct ipa3_sys_context *sys)
 		else
 			inactive_cycles = 0;
 
+		/*
+		 * Polling sleeps between cycles, which delays sparse traffic
+		 * more than the interrupt would; go back to interrupt mode
+		 * early unless the pipe is busy.
+		 */
+		max_inactive = ipa3_rx_mod_is_bulk(sys) ?
+			POLLING_INACTIVITY_RX : POLLING_INACTIVITY_RX_LOW;
+		if (inactive_cycles > max_inactive)
+			break;
+
 		trace_idle_sleep_enter3(sys->ep->client);
 		usleep_range(POLLING_MIN_SLEEP_RX, POLLING_MAX_SLEEP_RX);
 		trace_idle_sleep_exit3(sys->ep->client);
@@ -820,7 +878,7 @@ static void ipa3_handle_rx(struct ipa3_sys_context *sys)
 		if (sys->len - sys->len_pending_xfer == 0)
 			break;
 
-	} while (inactive_cycles <= POLLING_INACTIVITY_RX);
+	} while (1);
 
 	trace_poll_to_intr3(sys->ep->client);
 	ipa3_rx_switch_to_intr_mode(sys);
@@ -845,6 +903,15 @@ static void ipa3_switch_to_intr_rx_work_func(struct work_struct *work)
 		ipa3_handle_rx(sys);
 }
 
+static enum hrtimer_restart ipa3_rx_defer_timer_fn(struct hrtimer *param)
+{
+	struct ipa3_sys_context *sys = container_of(param,
+		struct ipa3_sys_context, rx_defer_timer);
+
+	sys->ep->client_notify(sys->ep->priv, IPA_CLIENT_START_POLL, 0);
+	return HRTIMER_NORESTART;
+}
+
 enum hrtimer_restart ipa3_ring_doorbell_timer_fn(struct hrtimer *param)
 {
 	struct ipa3_sys_context *sys = container_of(param,
@@ -968,6 +1035,9 @@ int ipa3_setup_sys_pipe(struct ipa_sys_connect_params *sys_in, u32 *clnt_hdl)
 		hrtimer_init(&ep->sys->db_timer, CLOCK_MONOTONIC,
 			HRTIMER_MODE_REL);
 		ep->sys->db_timer.function = ipa3_ring_doorbell_timer_fn;
+		hrtimer_init(&ep->sys->rx_defer_timer, CLOCK_MONOTONIC,
+			HRTIMER_MODE_REL);
+		ep->sys->rx_defer_timer.function = ipa3_rx_defer_timer_fn;
 
 		/* create IPA PM resources for handling polling mode */
 		if (ipa3_ctx->use_ipa_pm &&
@@ -1066,7 +1136,15 @@ int ipa3_setup_sys_pipe(struct ipa_sys_connect_params *sys_in, u32 *clnt_hdl)
 		}
 	}
 
-	if (IPA_CLIENT_IS_CONS(sys_in->client))
+	if (ep->sys->repl_hdlr == ipa3_replenish_rx_page_pool &&
+	    ipa3_alloc_page_pool(ep->sys)) {
+		IPAERR("ep=%d fail to alloc page pool\n", ipa_ep_idx);
+		ep->sys->repl_hdlr = ipa3_replenish_rx_cache;
+	}
+
+	if (ep->sys->page_pool)
+		ipa3_replenish_rx_page_pool(ep->sys);
+	else if (IPA_CLIENT_IS_CONS(sys_in->client))
 		ipa3_replenish_rx_cache(ep->sys);
 
 	if (IPA_CLIENT_IS_WLAN_CONS(sys_in->client)) {
@@ -1180,6 +1258,7 @@ int ipa3_teardown_sys_pipe(u32 clnt_hdl)
 		do {
 			usleep_range(95, 105);
 		} while (atomic_read(&ep->sys->curr_polling_state));
+		hrtimer_cancel(&ep->sys->rx_defer_timer);
 	}
 
 	if (IPA_CLIENT_IS_CONS(ep->client))
@@ -2052,6 +2131,252 @@ static void ipa3_fast_replenish_rx_cache(struct ipa3_sys_context *sys)
 	}
 }
 
+/*
+ * Amount of the page the HW may write to: the skb built on the page keeps
+ * NET_SKB_PAD of headroom and its shared info at the end.
+ */
+static inline u32 ipa3_page_pool_buf_sz(struct ipa3_sys_context *sys)
+{
+	return SKB_DATA_ALIGN(sys->rx_buff_sz + NET_SKB_PAD) +
+		SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+}
+
+static int ipa3_alloc_page_pool(struct ipa3_sys_context *sys)
+{
+	struct ipa3_page_pool *pool;
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return -ENOMEM;
+
+	/* room for the pages the stack holds on to besides those with HW */
+	pool->capacity = 2 * sys->rx_pool_sz + 1;
+	pool->ring = kcalloc(pool->capacity, sizeof(*pool->ring), GFP_KERNEL);
+	if (!pool->ring) {
+		kfree(pool);
+		return -ENOMEM;
+	}
+	pool->order = get_order(ipa3_page_pool_buf_sz(sys));
+	sys->page_pool = pool;
+
+	return 0;
+}
+
+static void ipa3_page_pool_release(struct ipa3_sys_context *sys,
+	struct ipa3_rx_page *rx_page)
+{
+	dma_unmap_page(ipa3_ctx->pdev, rx_page->dma_addr,
+		PAGE_SIZE << sys->page_pool->order, DMA_FROM_DEVICE);
+	put_page(rx_page->page);
+}
+
+static void ipa3_free_page_pool(struct ipa3_sys_context *sys)
+{
+	struct ipa3_page_pool *pool = sys->page_pool;
+
+	while (pool->head != pool->tail) {
+		ipa3_page_pool_release(sys, &pool->ring[pool->head]);
+		pool->head = (pool->head + 1) % pool->capacity;
+	}
+	kfree(pool->ring);
+	kfree(pool);
+	sys->page_pool = NULL;
+}
+
+/**
+ * ipa3_page_pool_get() - get a DMA mapped page for an Rx buffer
+ * @sys: sys pipe context owning the pool
+ * @rx_page: [out] the page and its DMA address
+ * @flag: allocation flags used when no page can be reused
+ *
+ * Reuses the oldest page of the pool when the stack has released all of its
+ * references, otherwise allocates and maps a new page.
+ *
+ * Return: 0 on success, -ENOMEM otherwise
+ */
+static int ipa3_page_pool_get(struct ipa3_sys_context *sys,
+	struct ipa3_rx_page *rx_page, gfp_t flag)
+{
+	struct ipa3_page_pool *pool = sys->page_pool;
+
+	spin_lock_bh(&sys->spinlock);
+	if (pool->head != pool->tail) {
+		*rx_page = pool->ring[pool->head];
+		if (page_ref_count(rx_page->page) == 1) {
+			pool->head = (pool->head + 1) % pool->capacity;
+			pool->stats.recycled++;
+			spin_unlock_bh(&sys->spinlock);
+			dma_sync_single_range_for_device(ipa3_ctx->pdev,
+				rx_page->dma_addr, NET_SKB_PAD,
+				sys->rx_buff_sz, DMA_FROM_DEVICE);
+			return 0;
+		}
+		pool->stats.busy++;
+	}
+	spin_unlock_bh(&sys->spinlock);
+
+	rx_page->page = __dev_alloc_pages(flag, pool->order);
+	if (!rx_page->page)
+		goto fail;
+
+	rx_page->dma_addr = dma_map_page(ipa3_ctx->pdev, rx_page->page, 0,
+		PAGE_SIZE << pool->order, DMA_FROM_DEVICE);
+	if (dma_mapping_error(ipa3_ctx->pdev, rx_page->dma_addr)) {
+		IPAERR("dma_map_page failure %pad\n", &rx_page->dma_addr);
+		__free_pages(rx_page->page, pool->order);
+		goto fail;
+	}
+	pool->stats.alloc++;
+
+	return 0;
+
+fail:
+	pool->stats.alloc_fail++;
+	return -ENOMEM;
+}
+
+/**
+ * ipa3_page_pool_put() - return a completed Rx page to the pool
+ * @sys: sys pipe context owning the pool
+ * @rx_page: the page, still DMA mapped
+ *
+ * The page is queued for reuse even if an skb built on it is still in
+ * flight; the pool only drops its own reference once it is full.
+ */
+static void ipa3_page_pool_put(struct ipa3_sys_context *sys,
+	struct ipa3_rx_page *rx_page)
+{
+	struct ipa3_page_pool *pool = sys->page_pool;
+	u32 next;
+
+	spin_lock_bh(&sys->spinlock);
+	next = (pool->tail + 1) % pool->capacity;
+	if (next == pool->head || page_is_pfmemalloc(rx_page->page)) {
+		pool->stats.released++;
+		spin_unlock_bh(&sys->spinlock);
+		ipa3_page_pool_release(sys, rx_page);
+		return;
+	}
+	pool->ring[pool->tail] = *rx_page;
+	pool->tail = next;
+	spin_unlock_bh(&sys->spinlock);
+}
+
+/**
+ * ipa3_page_pool_build_skb() - build the skb for a completed pool buffer
+ * @sys: sys pipe context owning the pool
+ * @rx_pkt: completed Rx packet
+ *
+ * The skb gets its own reference on the page and the page goes back to
+ * the pool right away, still DMA mapped.
+ *
+ * Return: the skb, or NULL if it could not be allocated
+ */
+static struct sk_buff *ipa3_page_pool_build_skb(struct ipa3_sys_context *sys,
+	struct ipa3_rx_pkt_wrapper *rx_pkt)
+{
+	struct ipa3_rx_page *rx_page = &rx_pkt->page_data;
+	struct sk_buff *skb;
+
+	dma_sync_single_range_for_cpu(ipa3_ctx->pdev, rx_page->dma_addr,
+		NET_SKB_PAD, rx_pkt->len, DMA_FROM_DEVICE);
+
+	skb = build_skb(page_address(rx_page->page),
+		PAGE_SIZE << sys->page_pool->order);
+	if (likely(skb)) {
+		page_ref_inc(rx_page->page);
+		skb_reserve(skb, NET_SKB_PAD);
+		skb_put(skb, rx_pkt->len);
+	} else {
+		IPAERR("failed to build skb\n");
+	}
+	ipa3_page_pool_put(sys, rx_page);
+
+	return skb;
+}
+
+/**
+ * ipa3_replenish_rx_page_pool() - Replenish the Rx buffers from the pool.
+ *
+ * Same as ipa3_replenish_rx_cache() but the buffers are pages taken from the
+ * pipe's page pool, which stay DMA mapped across reuse, and no skb is
+ * allocated until the buffer was filled by HW.
+ */
+static void ipa3_replenish_rx_page_pool(struct ipa3_sys_context *sys)
+{
+	struct ipa3_rx_pkt_wrapper *rx_pkt;
+	int ret;
+	int rx_len_cached = 0;
+	struct gsi_xfer_elem gsi_xfer_elem_one;
+	gfp_t flag = GFP_NOWAIT | __GFP_NOWARN;
+
+	rx_len_cached = sys->len;
+
+	while (rx_len_cached < sys->rx_pool_sz) {
+		rx_pkt = kmem_cache_zalloc(ipa3_ctx->rx_pkt_wrapper_cache,
+					   flag);
+		if (!rx_pkt) {
+			IPAERR("failed to alloc rx wrapper\n");
+			goto fail_kmem_cache_alloc;
+		}
+
+		INIT_LIST_HEAD(&rx_pkt->link);
+		INIT_WORK(&rx_pkt->work, ipa3_wq_rx_avail);
+		rx_pkt->sys = sys;
+
+		if (ipa3_page_pool_get(sys, &rx_pkt->page_data, flag))
+			goto fail_page_alloc;
+		rx_pkt->data.dma_addr = rx_pkt->page_data.dma_addr +
+			NET_SKB_PAD;
+
+		spin_lock_bh(&sys->spinlock);
+		list_add_tail(&rx_pkt->link, &sys->head_desc_list);
+		rx_len_cached = ++sys->len;
+		spin_unlock_bh(&sys->spinlock);
+
+		memset(&gsi_xfer_elem_one, 0,
+			sizeof(gsi_xfer_elem_one));
+		gsi_xfer_elem_one.addr = rx_pkt->data.dma_addr;
+		gsi_xfer_elem_one.len = sys->rx_buff_sz;
+		gsi_xfer_elem_one.flags |= GSI_XFER_FLAG_EOT;
+		gsi_xfer_elem_one.flags |= GSI_XFER_FLAG_EOB;
+		gsi_xfer_elem_one.type = GSI_XFER_ELEM_DATA;
+		gsi_xfer_elem_one.xfer_user_data = rx_pkt;
+
+		ret = gsi_queue_xfer(sys->ep->gsi_chan_hdl,
+				1, &gsi_xfer_elem_one, false);
+		if (ret != GSI_STATUS_SUCCESS) {
+			IPAERR("failed to provide buffer: %d\n",
+				ret);
+			goto fail_provide_rx_buffer;
+		}
+
+		/*
+		 * As doorbell is a costly operation, notify to GSI
+		 * of new buffers if threshold is exceeded
+		 */
+		if (++sys->len_pending_xfer >= IPA_REPL_XFER_THRESH) {
+			sys->len_pending_xfer = 0;
+			gsi_start_xfer(sys->ep->gsi_chan_hdl);
+		}
+	}
+
+	return;
+
+fail_provide_rx_buffer:
+	spin_lock_bh(&sys->spinlock);
+	list_del(&rx_pkt->link);
+	rx_len_cached = --sys->len;
+	spin_unlock_bh(&sys->spinlock);
+	ipa3_page_pool_put(sys, &rx_pkt->page_data);
+fail_page_alloc:
+	kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rx_pkt);
+fail_kmem_cache_alloc:
+	if (rx_len_cached - sys->len_pending_xfer == 0)
+		queue_delayed_work(sys->wq, &sys->replenish_rx_work,
+				msecs_to_jiffies(1));
+}
+
 static void ipa3_replenish_rx_work_func(struct work_struct *work)
 {
 	struct delayed_work *dwork;
@@ -2078,12 +2403,19 @@ static void ipa3_cleanup_rx(struct ipa3_sys_context *sys)
 	list_for_each_entry_safe(rx_pkt, r,
 				 &sys->head_desc_list, link) {
 		list_del(&rx_pkt->link);
-		dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
-			sys->rx_buff_sz, DMA_FROM_DEVICE);
-		sys->free_skb(rx_pkt->data.skb);
+		if (sys->page_pool) {
+			ipa3_page_pool_release(sys, &rx_pkt->page_data);
+		} else {
+			dma_unmap_single(ipa3_ctx->pdev, rx_pkt->data.dma_addr,
+				sys->rx_buff_sz, DMA_FROM_DEVICE);
+			sys->free_skb(rx_pkt->data.skb);
+		}
 		kmem_cache_free(ipa3_ctx->rx_pkt_wrapper_cache, rx_pkt);
 	}
 
+	if (sys->page_pool)
+		ipa3_free_page_pool(sys);
+
 	list_for_each_entry_safe(rx_pkt, r,
 				 &sys->rcycl_list, link) {
 		list_del(&rx_pkt->link);
@@ -2729,13 +3061,25 @@ static void ipa3_wq_rx_common(struct ipa3_sys_context *sys, u32 size)
 	if (size)
 		rx_pkt_expected->len = size;
 	spin_unlock_bh(&sys->spinlock);
-	rx_skb = rx_pkt_expected->data.skb;
-	dma_unmap_single(ipa3_ctx->pdev, rx_pkt_expected->data.dma_addr,
+	ipa3_rx_mod_update(sys, rx_pkt_expected->len);
+	if (sys->page_pool) {
+		rx_skb = ipa3_page_pool_build_skb(sys, rx_pkt_expected);
+		if (unlikely(!rx_skb)) {
+			sys->free_rx_wrapper(rx_pkt_expected);
+			sys->repl_hdlr(sys);
+			return;
+		}
+	} else {
+		rx_skb = rx_pkt_expected->data.skb;
+		dma_unmap_single(ipa3_ctx->pdev,
+			rx_pkt_expected->data.dma_addr,
 			sys->rx_buff_sz, DMA_FROM_DEVICE);
-	skb_set_tail_pointer(rx_skb, rx_pkt_expected->len);
-	rx_skb->len = rx_pkt_expected->len;
+		skb_set_tail_pointer(rx_skb, rx_pkt_expected->len);
+		rx_skb->len = rx_pkt_expected->len;
+	}
 	*(unsigned int *)rx_skb->cb = rx_skb->len;
 	rx_skb->truesize = rx_pkt_expected->len + sizeof(struct sk_buff);
+	rx_latency_stamp(rx_skb);
 	sys->pyld_hdlr(rx_skb, sys);
 	sys->free_rx_wrapper(rx_pkt_expected);
 	sys->repl_hdlr(sys);
@@ -2758,6 +3102,7 @@ static void ipa3_wlan_wq_rx_common(struct ipa3_sys_context *sys, u32 size)
 
 	if (size)
 		rx_pkt_expected->len = size;
+	ipa3_rx_mod_update(sys, rx_pkt_expected->len);
 
 	rx_skb = rx_pkt_expected->data.skb;
 	skb_set_tail_pointer(rx_skb, rx_pkt_expected->len);
@@ -2903,7 +3248,11 @@ static int ipa3_assign_policy(struct ipa_sys_connect_params *in,
 					sys->repl_hdlr =
 					   ipa3_replenish_rx_cache;
 				}
-				if (in->napi_enabled && in->recycle_enabled)
+				if (ipa3_ctx->rx_page_pool)
+					sys->repl_hdlr =
+					 ipa3_replenish_rx_page_pool;
+				else if (in->napi_enabled &&
+					in->recycle_enabled)
 					sys->repl_hdlr =
 					 ipa3_replenish_rx_cache_recycle;
 				in->ipa_ep_cfg.aggr.aggr_sw_eof_active
@@ -3930,6 +4279,50 @@ static int ipa_poll_gsi_pkt(struct ipa3_sys_context *sys,
 	return ret;
 }
 
+/*
+ * Budget charged for one completed buffer: the number of MTU sized packets
+ * it may hold, so that a buffer with a single small packet doesn't use up
+ * the budget of a full aggregate.
+ */
+static inline int ipa3_rx_poll_cost(u32 size)
+{
+	return clamp_t(int, DIV_ROUND_UP(size, IPA_MTU), 1,
+		IPA_WAN_AGGR_PKT_CNT);
+}
+
+/**
+ * ipa3_rx_poll_defer() - keep the interrupt masked after a NAPI poll
+ * @sys: consumer pipe in polling mode
+ * @cnt: budget used by the poll
+ *
+ * While the pipe receives at the bulk rate, a poll that drained the pipe
+ * is followed by another one after rx_mod_defer_us instead of an interrupt
+ * for every aggregate. Pipes below the bulk rate re-arm the interrupt at
+ * once to keep the latency low.
+ *
+ * Return: true if a poll was scheduled and the pipe stays in polling mode
+ */
+static bool ipa3_rx_poll_defer(struct ipa3_sys_context *sys, int cnt)
+{
+	struct ipa3_rx_mod *mod = &sys->rx_mod;
+	u32 defer_us = ipa3_ctx->rx_mod_defer_us;
+
+	if (cnt)
+		mod->dry_polls = 0;
+	else
+		mod->dry_polls++;
+
+	if (!defer_us || mod->dry_polls >= ipa3_ctx->rx_mod_defer_max ||
+	    !ipa3_rx_mod_is_bulk(sys)) {
+		mod->dry_polls = 0;
+		return false;
+	}
+
+	hrtimer_start(&sys->rx_defer_timer,
+		ns_to_ktime((u64)defer_us * NSEC_PER_USEC), HRTIMER_MODE_REL);
+	return true;
+}
+
 /**
  * ipa3_rx_poll() - Poll the rx packets from IPA HW. This
  * function is exectued in the softirq context
@@ -3937,6 +4330,10 @@ static int ipa_poll_gsi_pkt(struct ipa3_sys_context *sys,
  * if input budget is zero, the driver switches back to
  * interrupt mode.
  *
+ * Busy polling sockets may call this while the pipe is in interrupt mode,
+ * in which case nothing is polled and the interrupt will pick up new
+ * completions.
+ *
  * return number of polled packets, on error 0(zero)
  */
 int ipa3_rx_poll(u32 clnt_hdl, int weight)
@@ -3959,6 +4356,18 @@ int ipa3_rx_poll(u32 clnt_hdl, int weight)
 	memset(&notify, 0, sizeof(struct gsi_chan_xfer_notify));
 	ep = &ipa3_ctx->ep[clnt_hdl];
 
+	if (!atomic_read(&ep->sys->curr_polling_state)) {
+		ep->client_notify(ep->priv, IPA_CLIENT_COMP_NAPI, 0);
+		/*
+		 * An interrupt that came in meanwhile could not schedule
+		 * NAPI while it was held by the busy poll.
+		 */
+		smp_mb();
+		if (atomic_read(&ep->sys->curr_polling_state))
+			ep->client_notify(ep->priv, IPA_CLIENT_START_POLL, 0);
+		return 0;
+	}
+
 	while (cnt < weight &&
 		   atomic_read(&ep->sys->curr_polling_state)) {
 
@@ -3968,7 +4377,7 @@ int ipa3_rx_poll(u32 clnt_hdl, int weight)
 			break;
 
 		ipa3_wq_rx_common(ep->sys, mem_info.size);
-		cnt += IPA_WAN_AGGR_PKT_CNT;
+		cnt += ipa3_rx_poll_cost(mem_info.size);
 		total_cnt++;
 
 		if (ep->sys->len == 0) {
@@ -3980,14 +4389,18 @@ int ipa3_rx_poll(u32 clnt_hdl, int weight)
 
 	if (cnt < weight) {
 		ep->client_notify(ep->priv, IPA_CLIENT_COMP_NAPI, 0);
+		if (ipa3_rx_poll_defer(ep->sys, cnt))
+			return cnt;
 		ipa3_rx_switch_to_intr_mode(ep->sys);
 		if (ipa3_ctx->use_ipa_pm)
 			ipa_pm_deferred_deactivate(ep->sys->pm_hdl);
 		else
 			ipa3_dec_client_disable_clks_no_block(&log);
+		return cnt;
 	}
 
-	return cnt;
+	/* the last buffer may have been charged past the budget */
+	return weight;
 }
 
 static unsigned long tag_to_pointer_wa(uint64_t tag)
@@ -59,6 +59,10 @@
 #define IPA_DL_CHECKSUM_LENGTH (8)
 #define IPA_NUM_DESC_PER_SW_TX (3)
 #define IPA_GENERIC_RX_POOL_SZ 192
+#define IPA_RX_MOD_BULK_KBPS 50000
+#define IPA_RX_MOD_DEFER_US 100
+#define IPA_RX_MOD_DEFER_MAX 4
+#define IPA_NAT_OFFLOAD_SCAN_MS 5000
 #define IPA_UC_FINISH_MAX 6
 #define IPA_UC_WAIT_MIN_SLEEP 1000
 #define IPA_UC_WAII_MAX_SLEEP 1200
@@ -832,6 +836,71 @@ struct ipa3_repl_ctx {
 	u32 capacity;
 };
 
+/**
+ * struct ipa3_rx_page - RX buffer page owned by a page pool
+ * @page: compound page of ipa3_page_pool.order
+ * @dma_addr: DMA address of the page, kept mapped while in the pool
+ */
+struct ipa3_rx_page {
+	struct page *page;
+	dma_addr_t dma_addr;
+};
+
+/**
+ * struct ipa3_page_pool_stats - per pipe RX page pool counters
+ * @alloc: pages newly allocated and DMA mapped
+ * @alloc_fail: page allocation or DMA mapping failures
+ * @recycled: pages given back to HW without remapping
+ * @busy: replenish found the oldest page still held by the stack
+ * @released: pages unmapped and dropped because the pool was full
+ */
+struct ipa3_page_pool_stats {
+	u32 alloc;
+	u32 alloc_fail;
+	u32 recycled;
+	u32 busy;
+	u32 released;
+};
+
+/**
+ * struct ipa3_page_pool - DMA mapped RX pages for reuse
+ * @ring: pages returned by RX completions, oldest at @head
+ * @head: index of the next page to reuse
+ * @tail: index of the next free slot
+ * @capacity: number of slots in @ring
+ * @order: allocation order of the pages
+ * @stats: pool counters
+ *
+ * Completed pages are queued on @ring while the network stack may still
+ * hold a reference through the skb built on them. A page is reused only
+ * once the pool holds the last reference. The ring is protected by the
+ * sys spinlock.
+ */
+struct ipa3_page_pool {
+	struct ipa3_rx_page *ring;
+	u32 head;
+	u32 tail;
+	u32 capacity;
+	u32 order;
+	struct ipa3_page_pool_stats stats;
+};
+
+/**
+ * struct ipa3_rx_mod - adaptive Rx moderation state of a consumer pipe
+ * @window_start: start of the current rate measurement window
+ * @window_bytes: bytes received in the current window
+ * @rate_kbps: receive rate measured over the last window
+ * @bulk: the last window was received at rx_mod_bulk_kbps or more
+ * @dry_polls: consecutive deferred NAPI polls that found no completion
+ */
+struct ipa3_rx_mod {
+	ktime_t window_start;
+	u32 window_bytes;
+	u32 rate_kbps;
+	bool bulk;
+	u32 dry_polls;
+};
+
 /**
  * struct ipa3_sys_context - IPA GPI pipes context
  * @head_desc_list: header descriptors list
@@ -865,6 +934,8 @@ struct ipa3_sys_context {
 	struct work_struct repl_work;
 	void (*repl_hdlr)(struct ipa3_sys_context *sys);
 	struct ipa3_repl_ctx repl;
+	struct ipa3_page_pool *page_pool;
+	struct ipa3_rx_mod rx_mod;
 
 	/* ordering is important - mutable fields go above */
 	struct ipa3_ep_context *ep;
@@ -872,6 +943,7 @@ struct ipa3_sys_context {
 	struct list_head rcycl_list;
 	spinlock_t spinlock;
 	struct hrtimer db_timer;
+	struct hrtimer rx_defer_timer;
 	struct workqueue_struct *wq;
 	struct workqueue_struct *repl_wq;
 	struct ipa3_status_stats *status_stat;
@@ -983,11 +1055,13 @@ struct ipa3_desc {
  * @skb: skb
  * @dma_address: DMA address of this Rx packet
  * @link: linked to the Rx packets on that pipe
+ * @page_data: pool page backing this Rx packet when the pipe has a page pool
  * @len: how many bytes are copied into skb's flat buffer
  */
 struct ipa3_rx_pkt_wrapper {
 	struct list_head link;
 	struct ipa_rx_data data;
+	struct ipa3_rx_page page_data;
 	u32 len;
 	struct work_struct work;
 	struct ipa3_sys_context *sys;
@@ -1474,6 +1548,12 @@ struct ipa3_char_device_context {
  * @ipa_num_pipes: The number of pipes used by IPA HW
  * @skip_uc_pipe_reset: Indicates whether pipe reset via uC needs to be avoided
  * @ipa_client_apps_wan_cons_agg_gro: RMNET_IOCTL_INGRESS_FORMAT_AGG_DATA
+ * @rx_page_pool: Indicates whether WAN RX buffers come from a page pool
+ * @rx_mod_bulk_kbps: Rx rate from which a NAPI pipe defers its interrupt
+ * @rx_mod_defer_us: Delay before a deferred NAPI poll, 0 disables deferral
+ * @rx_mod_defer_max: Dry deferred polls before the interrupt is re-armed
+ * @nat_offload_enable: Add established tethered conntrack flows to NAT table
+ * @nat_offload_scan_ms: Period of the NAT table aging scan of offloaded flows
  * @apply_rg10_wa: Indicates whether to use register group 10 workaround
  * @gsi_ch20_wa: Indicates whether to apply GSI physical channel 20 workaround
  * @w_lock: Indicates the wakeup source.
@@ -1594,6 +1674,12 @@ struct ipa3_context {
 	struct ipa3_uc_ntn_ctx uc_ntn_ctx;
 	u32 wan_rx_ring_size;
 	u32 lan_rx_ring_size;
+	bool rx_page_pool;
+	u32 rx_mod_bulk_kbps;
+	u32 rx_mod_defer_us;
+	u32 rx_mod_defer_max;
+	u32 nat_offload_enable;
+	u32 nat_offload_scan_ms;
 	bool skip_uc_pipe_reset;
 	unsigned long gsi_dev_hdl;
 	u32 ee;
@@ -1653,6 +1739,7 @@ struct ipa3_plat_drv_res {
 	bool use_bw_vote;
 	u32 wan_rx_ring_size;
 	u32 lan_rx_ring_size;
+	bool rx_page_pool;
 	bool skip_uc_pipe_reset;
 	bool apply_rg10_wa;
 	bool gsi_ch20_wa;
@@ -2101,6 +2188,25 @@ int ipa3_del_ipv6ct_table(struct ipa_ioc_nat_ipv6ct_table_del *del);
 
 int ipa3_nat_mdfy_pdn(struct ipa_ioc_nat_pdn_entry *mdfy_pdn);
 
+#ifdef CONFIG_IPA3_NAT_OFFLOAD
+int ipa3_nat_offload_init(void);
+void ipa3_nat_offload_destroy(void);
+void ipa3_nat_offload_reset(void);
+#else
+static inline int ipa3_nat_offload_init(void)
+{
+	return 0;
+}
+
+static inline void ipa3_nat_offload_destroy(void)
+{
+}
+
+static inline void ipa3_nat_offload_reset(void)
+{
+}
+#endif
+
 /*
  * Messaging
  */
@@ -335,6 +335,10 @@ int ipa3_nat_ipv6ct_init_devices(void)
 		goto fail_init_ipv6ct_dev;
 	}
 
+	/* the tables stay usable from userspace without the offload */
+	if (ipa3_nat_offload_init())
+		IPAERR("unable to init NAT offload\n");
+
 	return 0;
 
 fail_init_ipv6ct_dev:
@@ -356,6 +360,7 @@ int ipa3_nat_ipv6ct_init_devices(void)
  */
 void ipa3_nat_ipv6ct_destroy_devices(void)
 {
+	ipa3_nat_offload_destroy();
 	ipa3_nat_ipv6ct_destroy_device(&ipa3_ctx->nat_mem.dev);
 	if (ipa3_ctx->ipa_hw_type >= IPA_HW_v4_0)
 		ipa3_nat_ipv6ct_destroy_device(&ipa3_ctx->ipv6ct_mem.dev);
@@ -1540,6 +1545,9 @@ int ipa3_del_nat_table(struct ipa_ioc_nat_ipv6ct_table_del *del)
 		}
 	}
 
+	/* entries added by the kernel go away with the table */
+	ipa3_nat_offload_reset();
+
 	ipa3_ctx->nat_mem.public_ip_addr = 0;
 	ipa3_ctx->nat_mem.index_table_addr = 0;
 	ipa3_ctx->nat_mem.index_table_expansion_addr = 0;
@@ -0,0 +1,519 @@
+/*
+ * Offload of tethered conntrack flows to the IPA NAT table
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * The NAT table is still allocated and initialized by userspace. While
+ * nat_offload is set in debugfs, IPv4 TCP and UDP connections that the
+ * kernel forwards with source NAT to one of the public addresses of the
+ * table are added to it once conntrack considers them assured. Further
+ * packets of the connection are then translated and routed by IPA without
+ * reaching the apps processor.
+ *
+ * A connection is only added to the base and index table entries its hash
+ * selects. When one of them is taken, the connection stays in software;
+ * the expansion tables are left to userspace.
+ *
+ * Every nat_offload_scan_ms the time stamps the hardware writes on each hit
+ * are compared with the previous scan. A connection that was hit gets its
+ * conntrack timeout refreshed as if the packets had been seen in software.
+ * An entry that was not hit for IPA_NAT_OFFLOAD_IDLE_MS, or whose
+ * connection is going away, is removed from the table.
+ */
+
+#include <linux/hashtable.h>
+#include <linux/ip.h>
+#include <linux/log2.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter_ipv4.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+#include <net/netfilter/nf_conntrack.h>
+#include <net/netfilter/nf_conntrack_helper.h>
+#include "ipa_i.h"
+#include "ipahal/ipahal.h"
+#include "ipahal/ipahal_nat.h"
+
+#define IPA_NAT_OFFLOAD_HASH_BITS 8
+#define IPA_NAT_OFFLOAD_IDLE_MS 30000
+
+/* base table, see enum ipa_nat_ipv6ct_table_type */
+#define IPA_NAT_OFFLOAD_BASE_TBL 0
+
+/**
+ * struct ipa3_nat_flow - a conntrack entry seen by the offload
+ * @node: link in ipa3_nat_offload.flows, keyed by @ct
+ * @link: link in ipa3_nat_offload.pending while waiting to be added
+ * @ct: the connection, a reference is held
+ * @timeout: conntrack timeout of the connection when it was queued
+ * @base_idx: base table entry, 0 while not in the table
+ * @index_idx: index table entry
+ * @time_stamp: HW time stamp of the entry at the last scan
+ * @last_hit: jiffies of the last scan that saw the time stamp change
+ */
+struct ipa3_nat_flow {
+	struct hlist_node node;
+	struct list_head link;
+	struct nf_conn *ct;
+	u32 timeout;
+	u16 base_idx;
+	u16 index_idx;
+	u32 time_stamp;
+	unsigned long last_hit;
+};
+
+static struct {
+	/* protects flows, pending and nr_flows, taken from the hook */
+	spinlock_t lock;
+	DECLARE_HASHTABLE(flows, IPA_NAT_OFFLOAD_HASH_BITS);
+	struct list_head pending;
+	u32 nr_flows;
+	struct workqueue_struct *wq;
+	struct work_struct add_work;
+	struct delayed_work scan_work;
+	bool registered;
+} ipa3_nat_offload;
+
+static u16 ipa3_nat_offload_csum_fold(u32 sum)
+{
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+
+	return sum;
+}
+
+/*
+ * Same hash as the HW lookup: 16 bit XOR of the tuple masked to the table
+ * size. Entry 0 is never used, a zero hash selects the last entry instead.
+ */
+static u16 ipa3_nat_offload_hash(u32 ip1, u32 ip2, u16 port1, u16 port2,
+	u8 proto, u16 mask)
+{
+	u16 hash = (u16)ip1 ^ (u16)(ip1 >> 16) ^ (u16)ip2 ^ (u16)(ip2 >> 16) ^
+		port1 ^ port2 ^ proto;
+
+	hash &= mask;
+
+	return hash ? hash : mask;
+}
+
+static int ipa3_nat_offload_pdn(u32 public_ip)
+{
+	struct ipa_pdn_entry *pdn_entries = ipa3_ctx->nat_mem.pdn_mem.base;
+	int i;
+
+	if (ipa3_ctx->ipa_hw_type < IPA_HW_v4_0)
+		return public_ip == ipa3_ctx->nat_mem.public_ip_addr ? 0 :
+			-ENOENT;
+
+	for (i = 0; pdn_entries && i < IPA_MAX_PDN_NUM; i++)
+		if (pdn_entries[i].public_ip == public_ip)
+			return i;
+
+	return -ENOENT;
+}
+
+static int ipa3_nat_offload_write_enable(u16 base_idx, bool enable)
+{
+	u8 buf[sizeof(struct ipa_ioc_nat_dma_cmd) +
+		sizeof(struct ipa_ioc_nat_dma_one)] __aligned(4) = { 0 };
+	struct ipa_ioc_nat_dma_cmd *cmd = (struct ipa_ioc_nat_dma_cmd *)buf;
+	size_t entry_size;
+	u32 offset;
+	u16 val;
+	int result;
+
+	ipahal_nat_entry_size(IPAHAL_NAT_IPV4, &entry_size);
+	ipahal_nat_ipv4_enable_word(&offset, &val);
+
+	cmd->entries = 1;
+	cmd->dma[0].table_index = 0;
+	cmd->dma[0].base_addr = IPA_NAT_OFFLOAD_BASE_TBL;
+	cmd->dma[0].offset = base_idx * entry_size + offset;
+	cmd->dma[0].data = enable ? val : 0;
+
+	IPA_ACTIVE_CLIENTS_INC_SIMPLE();
+	result = ipa3_table_dma_cmd(cmd);
+	IPA_ACTIVE_CLIENTS_DEC_SIMPLE();
+
+	return result;
+}
+
+static void ipa3_nat_offload_clear_entries(struct ipa3_nat_flow *flow)
+{
+	struct ipa3_nat_mem *nat = &ipa3_ctx->nat_mem;
+	size_t entry_size, index_size;
+
+	ipahal_nat_entry_size(IPAHAL_NAT_IPV4, &entry_size);
+	ipahal_nat_entry_size(IPAHAL_NAT_IPV4_INDEX, &index_size);
+
+	memset(nat->index_table_addr + flow->index_idx * index_size, 0,
+		index_size);
+	memset(nat->dev.base_table_addr + flow->base_idx * entry_size, 0,
+		entry_size);
+	wmb();
+
+	flow->base_idx = 0;
+}
+
+/*
+ * Writes the entries of @flow while they are disabled, then enables the
+ * base table entry through the HW so it never sees a partial entry.
+ * Called with the NAT device lock held.
+ */
+static int ipa3_nat_offload_add_flow(struct ipa3_nat_flow *flow)
+{
+	const struct nf_conntrack_tuple *orig =
+		&flow->ct->tuplehash[IP_CT_DIR_ORIGINAL].tuple;
+	const struct nf_conntrack_tuple *reply =
+		&flow->ct->tuplehash[IP_CT_DIR_REPLY].tuple;
+	struct ipa3_nat_mem *nat = &ipa3_ctx->nat_mem;
+	struct ipahal_nat_ipv4_rule rule = { 0 };
+	size_t entry_size, index_size;
+	void *entry, *index;
+	bool zeroed_entry, zeroed_index;
+	u32 public_ip, ip_sum;
+	u16 mask;
+	int pdn, result;
+
+	if (!nat->dev.is_hw_init || !nat->dev.is_sys_mem ||
+	    !is_power_of_2(nat->dev.table_entries + 1))
+		return -EPERM;
+	mask = nat->dev.table_entries;
+
+	public_ip = ntohl(reply->dst.u3.ip);
+	pdn = ipa3_nat_offload_pdn(public_ip);
+	if (pdn < 0)
+		return pdn;
+
+	rule.private_ip = ntohl(orig->src.u3.ip);
+	rule.private_port = ntohs(orig->src.u.all);
+	rule.target_ip = ntohl(orig->dst.u3.ip);
+	rule.target_port = ntohs(orig->dst.u.all);
+	rule.public_port = ntohs(reply->dst.u.all);
+	rule.protocol = orig->dst.protonum;
+	rule.pdn_index = pdn;
+
+	/* one's complement deltas from the private to the public tuple */
+	ip_sum = (public_ip >> 16) + (public_ip & 0xFFFF) +
+		(~rule.private_ip >> 16) + (~rule.private_ip & 0xFFFF);
+	rule.ip_chksum = ipa3_nat_offload_csum_fold(ip_sum);
+	rule.tcp_udp_chksum = ipa3_nat_offload_csum_fold(ip_sum +
+		rule.public_port + (u16)~rule.private_port);
+
+	flow->base_idx = ipa3_nat_offload_hash(rule.private_ip, rule.target_ip,
+		rule.private_port, rule.target_port, rule.protocol, mask);
+	flow->index_idx = ipa3_nat_offload_hash(rule.target_ip, 0,
+		rule.target_port, rule.public_port, rule.protocol, mask);
+	rule.indx_tbl_entry = flow->index_idx;
+
+	ipahal_nat_entry_size(IPAHAL_NAT_IPV4, &entry_size);
+	ipahal_nat_entry_size(IPAHAL_NAT_IPV4_INDEX, &index_size);
+	entry = nat->dev.base_table_addr + flow->base_idx * entry_size;
+	index = nat->index_table_addr + flow->index_idx * index_size;
+
+	ipahal_nat_is_entry_zeroed(IPAHAL_NAT_IPV4, entry, &zeroed_entry);
+	ipahal_nat_is_entry_zeroed(IPAHAL_NAT_IPV4_INDEX, index,
+		&zeroed_index);
+	if (!zeroed_entry || !zeroed_index) {
+		flow->base_idx = 0;
+		return -EBUSY;
+	}
+
+	ipahal_nat_ipv4_construct_entry(&rule, entry);
+	ipahal_nat_ipv4_construct_index_entry(flow->base_idx, index);
+	wmb();
+
+	result = ipa3_nat_offload_write_enable(flow->base_idx, true);
+	if (result) {
+		ipa3_nat_offload_clear_entries(flow);
+		return result;
+	}
+
+	flow->time_stamp = ipahal_nat_ipv4_time_stamp(entry);
+	flow->last_hit = jiffies;
+	IPADBG_LOW("offloaded %pI4h:%d -> %pI4h:%d at %d\n",
+		&rule.private_ip, rule.private_port,
+		&rule.target_ip, rule.target_port, flow->base_idx);
+
+	return 0;
+}
+
+/* Called with the NAT device lock held */
+static void ipa3_nat_offload_del_flow(struct ipa3_nat_flow *flow)
+{
+	if (flow->base_idx) {
+		if (ipa3_nat_offload_write_enable(flow->base_idx, false))
+			IPAERR("failed to disable NAT entry %d\n",
+				flow->base_idx);
+		ipa3_nat_offload_clear_entries(flow);
+	}
+
+	nf_ct_put(flow->ct);
+	kfree(flow);
+}
+
+static void ipa3_nat_offload_add_work(struct work_struct *work)
+{
+	struct ipa3_nat_flow *flow, *tmp;
+	LIST_HEAD(list);
+
+	mutex_lock(&ipa3_ctx->nat_mem.dev.lock);
+
+	spin_lock_bh(&ipa3_nat_offload.lock);
+	list_splice_init(&ipa3_nat_offload.pending, &list);
+	spin_unlock_bh(&ipa3_nat_offload.lock);
+
+	/*
+	 * A flow that could not be added stays hashed without entries, so it
+	 * is not queued again for every packet. The scan releases it.
+	 */
+	list_for_each_entry_safe(flow, tmp, &list, link) {
+		list_del_init(&flow->link);
+		if (!nf_ct_is_dying(flow->ct))
+			ipa3_nat_offload_add_flow(flow);
+	}
+
+	mutex_unlock(&ipa3_ctx->nat_mem.dev.lock);
+}
+
+static bool ipa3_nat_offload_flow_done(struct ipa3_nat_flow *flow,
+	unsigned long now)
+{
+	struct ipa3_nat_mem *nat = &ipa3_ctx->nat_mem;
+	struct nf_conn *ct = flow->ct;
+	size_t entry_size;
+	u32 ts;
+
+	if (!list_empty(&flow->link))
+		return false;
+
+	if (nf_ct_is_dying(ct) || !flow->base_idx)
+		return true;
+
+	ipahal_nat_entry_size(IPAHAL_NAT_IPV4, &entry_size);
+	ts = ipahal_nat_ipv4_time_stamp(nat->dev.base_table_addr +
+		flow->base_idx * entry_size);
+	if (ts != flow->time_stamp) {
+		flow->time_stamp = ts;
+		flow->last_hit = now;
+		if (!test_bit(IPS_FIXED_TIMEOUT_BIT, &ct->status))
+			WRITE_ONCE(ct->timeout, nfct_time_stamp +
+				flow->timeout);
+		return false;
+	}
+
+	return time_after(now, flow->last_hit +
+		msecs_to_jiffies(IPA_NAT_OFFLOAD_IDLE_MS));
+}
+
+static void ipa3_nat_offload_scan_work(struct work_struct *work)
+{
+	struct ipa3_nat_flow *flow;
+	struct hlist_node *tmp;
+	unsigned long now = jiffies;
+	LIST_HEAD(list);
+	int bkt;
+
+	mutex_lock(&ipa3_ctx->nat_mem.dev.lock);
+
+	spin_lock_bh(&ipa3_nat_offload.lock);
+	hash_for_each_safe(ipa3_nat_offload.flows, bkt, tmp, flow, node) {
+		if (ipa3_nat_offload_flow_done(flow, now)) {
+			hash_del(&flow->node);
+			ipa3_nat_offload.nr_flows--;
+			list_add(&flow->link, &list);
+		}
+	}
+	spin_unlock_bh(&ipa3_nat_offload.lock);
+
+	while (!list_empty(&list)) {
+		flow = list_first_entry(&list, struct ipa3_nat_flow, link);
+		list_del(&flow->link);
+		ipa3_nat_offload_del_flow(flow);
+	}
+
+	mutex_unlock(&ipa3_ctx->nat_mem.dev.lock);
+
+	queue_delayed_work(ipa3_nat_offload.wq, &ipa3_nat_offload.scan_work,
+		msecs_to_jiffies(max(ipa3_ctx->nat_offload_scan_ms, 100U)));
+}
+
+static bool ipa3_nat_offload_eligible(const struct nf_conn *ct)
+{
+	if (!test_bit(IPS_ASSURED_BIT, &ct->status) ||
+	    !test_bit(IPS_SRC_NAT_BIT, &ct->status) ||
+	    test_bit(IPS_DST_NAT_BIT, &ct->status) ||
+	    nf_ct_is_dying(ct))
+		return false;
+
+	/* helpers and their expectations need to see every packet */
+	if (ct->master || nfct_help(ct))
+		return false;
+
+	switch (nf_ct_protonum(ct)) {
+	case IPPROTO_TCP:
+		return ct->proto.tcp.state == TCP_CONNTRACK_ESTABLISHED;
+	case IPPROTO_UDP:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void ipa3_nat_offload_queue(struct nf_conn *ct)
+{
+	struct ipa3_nat_flow *flow;
+	s32 timeout;
+
+	hash_for_each_possible(ipa3_nat_offload.flows, flow, node,
+		(unsigned long)ct)
+		if (flow->ct == ct)
+			return;
+
+	if (ipa3_nat_offload.nr_flows >= ipa3_ctx->nat_mem.dev.table_entries)
+		return;
+
+	/* conntrack just refreshed the timeout for this packet */
+	timeout = ct->timeout - nfct_time_stamp;
+	if (timeout <= 0)
+		return;
+
+	flow = kzalloc(sizeof(*flow), GFP_ATOMIC);
+	if (!flow)
+		return;
+
+	nf_conntrack_get(&ct->ct_general);
+	flow->ct = ct;
+	flow->timeout = timeout;
+	hash_add(ipa3_nat_offload.flows, &flow->node, (unsigned long)ct);
+	list_add_tail(&flow->link, &ipa3_nat_offload.pending);
+	ipa3_nat_offload.nr_flows++;
+
+	queue_work(ipa3_nat_offload.wq, &ipa3_nat_offload.add_work);
+}
+
+static unsigned int ipa3_nat_offload_hook(void *priv, struct sk_buff *skb,
+	const struct nf_hook_state *state)
+{
+	enum ip_conntrack_info ctinfo;
+	struct nf_conn *ct;
+
+	if (!READ_ONCE(ipa3_ctx->nat_offload_enable) ||
+	    !ipa3_ctx->nat_mem.dev.is_hw_init)
+		return NF_ACCEPT;
+
+	ct = nf_ct_get(skb, &ctinfo);
+	if (!ct || (ctinfo != IP_CT_ESTABLISHED &&
+		    ctinfo != IP_CT_ESTABLISHED_REPLY))
+		return NF_ACCEPT;
+
+	if (!ipa3_nat_offload_eligible(ct))
+		return NF_ACCEPT;
+
+	spin_lock(&ipa3_nat_offload.lock);
+	ipa3_nat_offload_queue(ct);
+	spin_unlock(&ipa3_nat_offload.lock);
+
+	return NF_ACCEPT;
+}
+
+/* After the filter table, so only accepted connections are offloaded */
+static struct nf_hook_ops ipa3_nat_offload_ops = {
+	.hook		= ipa3_nat_offload_hook,
+	.pf		= NFPROTO_IPV4,
+	.hooknum	= NF_INET_FORWARD,
+	.priority	= NF_IP_PRI_LAST,
+};
+
+/**
+ * ipa3_nat_offload_reset() - Forget all offloaded flows
+ *
+ * Called with the NAT device lock held when the NAT table is deleted, which
+ * takes the entries of the offloaded flows along.
+ */
+void ipa3_nat_offload_reset(void)
+{
+	struct ipa3_nat_flow *flow;
+	struct hlist_node *tmp;
+	LIST_HEAD(list);
+	int bkt;
+
+	if (!ipa3_nat_offload.registered)
+		return;
+
+	spin_lock_bh(&ipa3_nat_offload.lock);
+	hash_for_each_safe(ipa3_nat_offload.flows, bkt, tmp, flow, node) {
+		hash_del(&flow->node);
+		list_move(&flow->link, &list);
+	}
+	ipa3_nat_offload.nr_flows = 0;
+	spin_unlock_bh(&ipa3_nat_offload.lock);
+
+	while (!list_empty(&list)) {
+		flow = list_first_entry(&list, struct ipa3_nat_flow, link);
+		list_del(&flow->link);
+		nf_ct_put(flow->ct);
+		kfree(flow);
+	}
+}
+
+/**
+ * ipa3_nat_offload_init() - Start offloading conntrack flows
+ *
+ * Returns:	0 on success, negative on failure
+ */
+int ipa3_nat_offload_init(void)
+{
+	int result;
+
+	spin_lock_init(&ipa3_nat_offload.lock);
+	hash_init(ipa3_nat_offload.flows);
+	INIT_LIST_HEAD(&ipa3_nat_offload.pending);
+	INIT_WORK(&ipa3_nat_offload.add_work, ipa3_nat_offload_add_work);
+	INIT_DELAYED_WORK(&ipa3_nat_offload.scan_work,
+		ipa3_nat_offload_scan_work);
+
+	ipa3_nat_offload.wq = alloc_ordered_workqueue("ipa_nat_offload", 0);
+	if (!ipa3_nat_offload.wq)
+		return -ENOMEM;
+
+	result = nf_register_hook(&ipa3_nat_offload_ops);
+	if (result) {
+		destroy_workqueue(ipa3_nat_offload.wq);
+		return result;
+	}
+	ipa3_nat_offload.registered = true;
+
+	queue_delayed_work(ipa3_nat_offload.wq, &ipa3_nat_offload.scan_work,
+		msecs_to_jiffies(ipa3_ctx->nat_offload_scan_ms));
+
+	return 0;
+}
+
+/**
+ * ipa3_nat_offload_destroy() - Stop offloading conntrack flows
+ */
+void ipa3_nat_offload_destroy(void)
+{
+	if (!ipa3_nat_offload.registered)
+		return;
+
+	nf_unregister_hook(&ipa3_nat_offload_ops);
+	cancel_work_sync(&ipa3_nat_offload.add_work);
+	cancel_delayed_work_sync(&ipa3_nat_offload.scan_work);
+
+	mutex_lock(&ipa3_ctx->nat_mem.dev.lock);
+	ipa3_nat_offload_reset();
+	mutex_unlock(&ipa3_ctx->nat_mem.dev.lock);
+
+	ipa3_nat_offload.registered = false;
+	destroy_workqueue(ipa3_nat_offload.wq);
+}
@@ -420,3 +420,49 @@ int ipahal_nat_stringify_entry(enum ipahal_nat_type nat_type, void *entry,
 	return result;
 }
 
+
+void ipahal_nat_ipv4_construct_entry(const struct ipahal_nat_ipv4_rule *rule,
+	void *entry)
+{
+	struct ipa_nat_hw_ipv4_entry hw_entry = { 0 };
+
+	hw_entry.private_ip = rule->private_ip;
+	hw_entry.target_ip = rule->target_ip;
+	hw_entry.public_port = rule->public_port;
+	hw_entry.private_port = rule->private_port;
+	hw_entry.target_port = rule->target_port;
+	hw_entry.ip_chksum = rule->ip_chksum;
+	hw_entry.protocol = rule->protocol;
+	hw_entry.indx_tbl_entry = rule->indx_tbl_entry;
+	if (ipahal_ctx->hw_type >= IPA_HW_v4_0)
+		hw_entry.pdn_index = rule->pdn_index;
+	hw_entry.tcp_udp_chksum = rule->tcp_udp_chksum;
+
+	memcpy(entry, &hw_entry, sizeof(hw_entry));
+}
+
+void ipahal_nat_ipv4_construct_index_entry(u16 tbl_entry, void *entry)
+{
+	struct ipa_nat_hw_indx_entry hw_entry = { 0 };
+
+	hw_entry.tbl_entry = tbl_entry;
+
+	memcpy(entry, &hw_entry, sizeof(hw_entry));
+}
+
+u32 ipahal_nat_ipv4_time_stamp(const void *entry)
+{
+	const struct ipa_nat_hw_ipv4_entry *hw_entry = entry;
+
+	return hw_entry->time_stamp;
+}
+
+void ipahal_nat_ipv4_enable_word(u32 *offset, u16 *enable)
+{
+	struct ipa_nat_hw_ipv4_entry hw_entry = { 0 };
+
+	hw_entry.enable = 1;
+
+	*offset = IPA_NAT_IPV4_FLAGS_OFST;
+	*enable = *(u16 *)((u8 *)&hw_entry + IPA_NAT_IPV4_FLAGS_OFST);
+}
@@ -27,6 +27,33 @@ enum ipahal_nat_type {
 	IPA_NAT_MAX
 };
 
+/*
+ * struct ipahal_nat_ipv4_rule - Content of an IPv4 NAT base table entry
+ *  Addresses and ports are in host byte order
+ * @private_ip: address of the host behind the NAT
+ * @target_ip: address of the remote host
+ * @private_port: port of the host behind the NAT
+ * @target_port: port of the remote host
+ * @public_port: port the private port is translated to
+ * @ip_chksum: IP header checksum delta of the translation
+ * @tcp_udp_chksum: TCP/UDP checksum delta of the translation
+ * @indx_tbl_entry: index table entry pointing back at this entry
+ * @protocol: IP protocol of the connection
+ * @pdn_index: PDN table entry holding the public address (IPAv4 and later)
+ */
+struct ipahal_nat_ipv4_rule {
+	u32 private_ip;
+	u32 target_ip;
+	u16 private_port;
+	u16 target_port;
+	u16 public_port;
+	u16 ip_chksum;
+	u16 tcp_udp_chksum;
+	u16 indx_tbl_entry;
+	u8 protocol;
+	u8 pdn_index;
+};
+
 /* NAT Function APIs */
 
 /*
@@ -76,4 +103,36 @@ int ipahal_nat_is_entry_valid(enum ipahal_nat_type nat_type, void *entry,
 int ipahal_nat_stringify_entry(enum ipahal_nat_type nat_type, void *entry,
 	char *buff, size_t buff_size);
 
+/*
+ * ipahal_nat_ipv4_construct_entry() - Builds a disabled IPv4 NAT base
+ *                                     table entry
+ * @rule: [in] The content of the entry
+ * @entry: [out] The NAT entry
+ */
+void ipahal_nat_ipv4_construct_entry(const struct ipahal_nat_ipv4_rule *rule,
+	void *entry);
+
+/*
+ * ipahal_nat_ipv4_construct_index_entry() - Builds an IPv4 NAT index
+ *                                           table entry
+ * @tbl_entry: [in] The base table entry the index entry points at
+ * @entry: [out] The NAT index entry
+ */
+void ipahal_nat_ipv4_construct_index_entry(u16 tbl_entry, void *entry);
+
+/*
+ * ipahal_nat_ipv4_time_stamp() - Gets the time stamp HW updates each time
+ *                                an IPv4 NAT base table entry is hit
+ * @entry: [in] The NAT entry
+ */
+u32 ipahal_nat_ipv4_time_stamp(const void *entry);
+
+/*
+ * ipahal_nat_ipv4_enable_word() - Gets the 16 bit word of an IPv4 NAT base
+ *                                 table entry holding its enable flag
+ * @offset: [out] Offset of the word within the entry
+ * @enable: [out] Value of the word for an enabled entry
+ */
+void ipahal_nat_ipv4_enable_word(u32 *offset, u16 *enable);
+
 #endif /* _IPAHAL_NAT_H_ */
@@ -58,6 +58,9 @@ struct ipa_nat_hw_ipv4_entry {
 	u32 tcp_udp_chksum : 16;
 };
 
+/* Offset of the 16 bit word holding the flags, see the layout above */
+#define IPA_NAT_IPV4_FLAGS_OFST 18
+
 /*--- IPV4 NAT Index Table Entry --
  *---------------------------------
  *|   3   |   2   |   1   |   0   |
@@ -27,6 +27,7 @@
 #include <linux/skbuff.h>
 #include <linux/version.h>
 #include <linux/workqueue.h>
+#include <net/busy_poll.h>
 #include <net/pkt_sched.h>
 #include <soc/qcom/subsystem_restart.h>
 #include <soc/qcom/subsystem_notif.h>
@@ -1291,6 +1292,9 @@ static void apps_ipa_packet_receive_notify(void *priv,
 		skb->protocol = htons(ETH_P_MAP);
 
 		if (ipa3_rmnet_res.ipa_napi_enable) {
+			/* lets sockets on the rmnet devices busy poll */
+			skb_mark_napi_id(skb,
+				&rmnet_ipa3_ctx->wwan_priv->napi);
 			trace_rmnet_ipa_netif_rcv_skb3(dev->stats.rx_packets);
 			result = netif_receive_skb(skb);
 		} else {
@@ -4287,8 +4291,7 @@ static int ipa3_rmnet_poll(struct napi_struct *napi, int budget)
 {
 	int rcvd_pkts = 0;
 
-	rcvd_pkts = ipa_rx_poll(rmnet_ipa3_ctx->ipa3_to_apps_hdl,
-					NAPI_WEIGHT);
+	rcvd_pkts = ipa_rx_poll(rmnet_ipa3_ctx->ipa3_to_apps_hdl, budget);
 	IPAWANDBG_LOW("rcvd packets: %d\n", rcvd_pkts);
 	return rcvd_pkts;
 }
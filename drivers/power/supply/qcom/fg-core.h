@@ -506,6 +506,7 @@ struct fg_chip {
 	int			charge_done;
 	int			charge_type;
 	int			online_status;
+	int			typec_mode;
 	int			last_soc;
 	int			last_batt_temp;
 	int			health;
@@ -2991,6 +2991,19 @@ static int fg_set_cycle_count(struct fg_chip *chip, int value)
 	return rc;
 }
 
+/*
+ * Drop the property values cached by fg_psy_get_property() so the next
+ * read goes to the hardware. Called whenever an interrupt or a charger
+ * state change says that they may have moved.
+ */
+static void fg_saved_data_invalidate(struct fg_chip *chip)
+{
+	int i;
+
+	for (i = 0; i < POWER_SUPPLY_PROP_MAX; i++)
+		chip->saved_data[i].last_req_expires = 0;
+}
+
 static void status_change_work(struct work_struct *work)
 {
 	struct fg_chip *chip = container_of(work,
@@ -2999,6 +3012,15 @@ static void status_change_work(struct work_struct *work)
 	int rc, batt_temp;
 	int msoc = 0;
 
+	if (usb_psy_initialized(chip)) {
+		rc = power_supply_get_property(chip->usb_psy,
+				POWER_SUPPLY_PROP_TYPEC_MODE, &prop);
+		if (!rc && prop.intval != chip->typec_mode) {
+			chip->typec_mode = prop.intval;
+			fg_saved_data_invalidate(chip);
+		}
+	}
+
 	if (!batt_psy_initialized(chip)) {
 		fg_dbg(chip, FG_STATUS, "Charger not available?!\n");
 		goto out;
@@ -4078,7 +4100,6 @@ static int fg_psy_get_property(struct power_supply *psy,
 {
 	struct fg_chip *chip = power_supply_get_drvdata(psy);
 	struct fg_saved_data *sd = chip->saved_data + psp;
-	union power_supply_propval typec_sts = { .intval = -1 };
 	int rc = 0;
 
 	switch (psp) {
@@ -4095,11 +4116,13 @@ static int fg_psy_get_property(struct power_supply *psy,
 		if (!sd->last_req_expires)
 			break;
 
-		if (usb_psy_initialized(chip))
-			power_supply_get_property(chip->usb_psy,
-				POWER_SUPPLY_PROP_TYPEC_MODE, &typec_sts);
-
-		if (typec_sts.intval == POWER_SUPPLY_TYPEC_NONE &&
+		/*
+		 * typec_mode is kept current by status_change_work(), which
+		 * also drops the saved values when it changes; reading it
+		 * from the charger here would cost the SPMI traffic that the
+		 * saved values are there to avoid.
+		 */
+		if (chip->typec_mode == POWER_SUPPLY_TYPEC_NONE &&
 			time_before(jiffies, sd->last_req_expires)) {
 			*pval = sd->val;
 			return 0;
@@ -4867,6 +4890,7 @@ static irqreturn_t fg_vbatt_low_irq_handler(int irq, void *data)
 	struct fg_chip *chip = data;
 
 	fg_dbg(chip, FG_IRQ, "irq %d triggered\n", irq);
+	fg_saved_data_invalidate(chip);
 	return IRQ_HANDLED;
 }
 
@@ -4885,6 +4909,7 @@ static irqreturn_t fg_batt_missing_irq_handler(int irq, void *data)
 
 	fg_dbg(chip, FG_IRQ, "irq %d triggered sts:%d\n", irq, status);
 	chip->battery_missing = (status & BT_MISS_BIT);
+	fg_saved_data_invalidate(chip);
 
 	if (chip->battery_missing) {
 		chip->profile_available = false;
@@ -4918,6 +4943,7 @@ static irqreturn_t fg_delta_batt_temp_irq_handler(int irq, void *data)
 		return IRQ_HANDLED;
 	}
 	fg_dbg(chip, FG_IRQ, "irq %d triggered bat_temp: %d\n", irq, batt_temp);
+	fg_saved_data_invalidate(chip);
 
 	rc = fg_esr_filter_config(chip, batt_temp, false);
 	if (rc < 0)
@@ -4986,6 +5012,7 @@ static irqreturn_t fg_delta_bsoc_irq_handler(int irq, void *data)
 	int rc;
 
 	fg_dbg(chip, FG_IRQ, "irq %d triggered\n", irq);
+	fg_saved_data_invalidate(chip);
 	rc = fg_charge_full_update(chip);
 	if (rc < 0)
 		pr_err("Error in charge_full_update, rc=%d\n", rc);
@@ -4999,6 +5026,7 @@ static irqreturn_t fg_delta_msoc_irq_handler(int irq, void *data)
 	int rc;
 
 	fg_dbg(chip, FG_IRQ, "irq %d triggered\n", irq);
+	fg_saved_data_invalidate(chip);
 	fg_cycle_counter_update(chip);
 
 	if (chip->cl.active)
@@ -5035,6 +5063,7 @@ static irqreturn_t fg_empty_soc_irq_handler(int irq, void *data)
 	struct fg_chip *chip = data;
 
 	fg_dbg(chip, FG_IRQ, "irq %d triggered\n", irq);
+	fg_saved_data_invalidate(chip);
 	if (batt_psy_initialized(chip))
 		power_supply_changed(chip->batt_psy);
 
@@ -5757,55 +5786,18 @@ static void soc_work_fn(struct work_struct *work)
 {	struct fg_chip *chip = container_of(work,
 				struct fg_chip,
 				soc_work.work);
-	int msoc = 0, esr_uohms = 0, curr_ua = 0, volt_uv = 0, temp = 0;
-	int soc = 0;
-	int cycle_count;
+	int msoc = 0, temp = 0;
 	int rc;
-	u8 buf_top[4], buf_auto[4], buf_profile[4];
 	static int prev_soc = -EINVAL;
 
-	rc = fg_get_prop_capacity(chip, &soc);
-	if (rc < 0)
-		pr_err("Error in getting capacity, rc=%d\n", rc);
-
 	rc = fg_get_msoc_raw(chip, &msoc);
 	if (rc < 0)
 		pr_err("Error in getting msoc, rc=%d\n", rc);
 
-	rc = fg_get_sram_prop(chip, FG_SRAM_ESR, &esr_uohms);
-	if (rc < 0)
-		pr_err("failed to get ESR, rc=%d\n", rc);
-
-	fg_get_battery_current(chip, &curr_ua);
-	if (rc < 0)
-		pr_err("failed to get current, rc=%d\n", rc);
-
-	rc = fg_get_battery_voltage(chip, &volt_uv);
-	if (rc < 0)
-		pr_err("failed to get voltage, rc=%d\n", rc);
-
 	rc = fg_get_battery_temp(chip, &temp);
 	if (rc < 0)
 		pr_err("failed to get temp, rc=%d\n", rc);
 
-	cycle_count = fg_get_cycle_count(chip);
-
-	rc = fg_sram_read(chip, 0, 0, buf_top, 4, FG_IMA_DEFAULT);
-	if (rc < 0) {
-		pr_err("sram read failed: address=0, rc=%d\n", rc);
-		return;
-	}
-	rc = fg_sram_read(chip, 19, 0, buf_auto, 4, FG_IMA_DEFAULT);
-	if (rc < 0) {
-		pr_err("sram read failed: address=19, rc=%d\n", rc);
-		return;
-	}
-	rc = fg_sram_read(chip, PROFILE_INTEGRITY_WORD, 0, buf_profile, 4, FG_IMA_DEFAULT);
-	if (rc < 0) {
-		pr_err("sram read failed: address=79, rc=%d\n", rc);
-		return;
-	}
-
 	if (temp < 480 && chip->last_batt_temp >= 480) {
 		/* follow the way that fg_notifier_cb use wake lock */
 		pm_stay_awake(chip->dev);
@@ -6098,6 +6090,7 @@ static int fg_gen3_probe(struct platform_device *pdev)
 	chip->prev_charge_status = -EINVAL;
 	chip->ki_coeff_full_soc = -EINVAL;
 	chip->online_status = -EINVAL;
+	chip->typec_mode = -EINVAL;
 	chip->batt_id_ohms = -EINVAL;
 	chip->regmap = dev_get_regmap(chip->dev->parent, NULL);
 	if (!chip->regmap) {
@@ -6181,7 +6174,7 @@ static int fg_gen3_probe(struct platform_device *pdev)
 	init_completion(&chip->soc_update);
 	init_completion(&chip->soc_ready);
 
-	INIT_DELAYED_WORK(&chip->soc_monitor_work, soc_monitor_work);
+	INIT_DEFERRABLE_WORK(&chip->soc_monitor_work, soc_monitor_work);
 	INIT_DELAYED_WORK(&chip->profile_load_work, profile_load_work);
 	INIT_DELAYED_WORK(&chip->pl_enable_work, pl_enable_work);
 	INIT_WORK(&chip->status_change_work, status_change_work);
@@ -6189,7 +6182,7 @@ static int fg_gen3_probe(struct platform_device *pdev)
 	INIT_DELAYED_WORK(&chip->ttf_work, ttf_work);
 	INIT_DELAYED_WORK(&chip->esr_timer_config_work, fg_esr_timer_config_work);
 	INIT_DELAYED_WORK(&chip->sram_dump_work, sram_dump_work);
-	INIT_DELAYED_WORK(&chip->soc_work, soc_work_fn);
+	INIT_DEFERRABLE_WORK(&chip->soc_work, soc_work_fn);
 	INIT_DELAYED_WORK(&chip->empty_restart_fg_work, empty_restart_fg_work);
 	INIT_WORK(&chip->esr_filter_work, esr_filter_work);
 	alarm_init(&chip->esr_filter_alarm, ALARM_BOOTTIME,
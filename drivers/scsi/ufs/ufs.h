@@ -206,6 +206,19 @@ enum device_desc_param {
 	DEVICE_DESC_PARAM_UD_LEN		= 0x1B,
 	DEVICE_DESC_PARAM_RTT_CAP		= 0x1C,
 	DEVICE_DESC_PARAM_FRQ_RTC		= 0x1D,
+	DEVICE_DESC_PARAM_EXT_UFS_FEATURE_SUP	= 0x4F,
+	DEVICE_DESC_PARAM_WB_PRESRV_USRSPC_EN	= 0x53,
+	DEVICE_DESC_PARAM_WB_TYPE		= 0x54,
+	DEVICE_DESC_PARAM_WB_SHARED_ALLOC_UNITS	= 0x55,
+};
+
+/* dExtendedUFSFeaturesSupport bits */
+#define UFS_DEV_WRITE_BOOSTER_SUP	(1 << 8)
+
+/* bWriteBoosterBufferType values */
+enum ufs_wb_buf_type {
+	WB_BUF_MODE_LU_DEDICATED	= 0x0,
+	WB_BUF_MODE_SHARED		= 0x1,
 };
 /*
  * Logical Unit Write Protect
@@ -510,6 +523,11 @@ struct ufs_dev_info {
 	/* query flags */
 	bool f_power_on_wp_en;
 
+	/* WriteBooster, only the shared buffer type is supported */
+	bool wb_supported;
+	bool wb_enabled;
+	bool wb_flush_enabled;
+
 	/* Keeps information if any of the LU is power on write protected */
 	bool is_lu_power_on_wp;
 	/* is Unit Attention Condition cleared on UFS Device LUN? */
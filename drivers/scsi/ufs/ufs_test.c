@@ -61,6 +61,9 @@
 		(LONG_TEST_SIZE_INTEGER(x) * 10))
 /* translation mask from sectors to block */
 #define SECTOR_TO_BLOCK_MASK 0x7
+/* long test latency tracking: issue times by req_id, log2 usec histogram */
+#define LAT_SLOTS	128
+#define LAT_BUCKETS	32
 
 #define TEST_OPS(test_name, upper_case_name)				\
 static int ufs_test_ ## test_name ## _show(struct seq_file *file,	\
@@ -151,6 +154,20 @@ struct ufs_test_data {
 	u32 sector_range;
 	/* total number of requests to be submitted in long test */
 	u32 long_test_num_reqs;
+	/* long test requests outstanding at once, 0 for QUEUE_MAX_REQUESTS */
+	u32 long_test_queue_depth;
+	struct dentry *long_test_queue_depth_dentry;
+
+	/* long test latencies, updated under test_iosched->lock */
+	ktime_t lat_issue[LAT_SLOTS];
+	unsigned long lat_hist[LAT_BUCKETS];
+	u64 lat_max_us;
+
+	/* results of the last long test, shown in long_test_results */
+	int res_testcase;
+	unsigned long res_iops;
+	unsigned long res_kib_per_sec;
+	struct dentry *long_test_results_dentry;
 
 	struct test_iosched *test_iosched;
 };
@@ -953,6 +970,48 @@ static int ufs_test_run_lun_depth_test(struct test_iosched *test_iosched)
 	return 0;
 }
 
+/* Caller must hold test_iosched->lock */
+static void long_test_account_latency(struct ufs_test_data *utd, int req_id)
+{
+	u64 us = ktime_us_delta(ktime_get(), utd->lat_issue[req_id % LAT_SLOTS]);
+
+	utd->lat_hist[min_t(int, fls64(us), LAT_BUCKETS - 1)]++;
+	if (us > utd->lat_max_us)
+		utd->lat_max_us = us;
+}
+
+/*
+ * Upper bound, in usec, of the latency below which @permille of the
+ * requests completed
+ */
+static u64 long_test_latency_permille(struct ufs_test_data *utd,
+		unsigned int permille)
+{
+	unsigned long total = 0, sum = 0;
+	int i;
+
+	for (i = 0; i < LAT_BUCKETS; i++)
+		total += utd->lat_hist[i];
+	if (!total)
+		return 0;
+
+	for (i = 0; i < LAT_BUCKETS - 1; i++) {
+		sum += utd->lat_hist[i];
+		if (sum * 1000 >= total * permille)
+			return 1ULL << i;
+	}
+	return utd->lat_max_us;
+}
+
+static void long_test_report_latency(struct ufs_test_data *utd)
+{
+	pr_info("%s: latency usec: p50 <= %llu, p90 <= %llu, p99 <= %llu, p99.9 <= %llu, max %llu",
+		__func__, long_test_latency_permille(utd, 500),
+		long_test_latency_permille(utd, 900),
+		long_test_latency_permille(utd, 990),
+		long_test_latency_permille(utd, 999), utd->lat_max_us);
+}
+
 static void long_test_free_end_io_fn(struct request *rq, int err)
 {
 	struct test_request *test_rq;
@@ -973,6 +1032,7 @@ static void long_test_free_end_io_fn(struct request *rq, int err)
 	test_iosched->dispatched_count--;
 	list_del_init(&test_rq->queuelist);
 	__blk_put_request(test_iosched->req_q, test_rq->rq);
+	long_test_account_latency(utd, test_rq->req_id);
 	spin_unlock_irqrestore(&test_iosched->lock, flags);
 
 	if (utd->test_stage == UFS_TEST_LONG_SEQUENTIAL_MIXED_STAGE2 &&
@@ -1010,8 +1070,9 @@ static int run_long_test(struct test_iosched *test_iosched)
 	int ret = 0;
 	int direction, num_bios_per_request = 1;
 	static unsigned int inserted_requests;
-	u32 sector, seed, num_bios, seq_sector_delta;
+	u32 sector, seed, num_bios, seq_sector_delta, depth;
 	struct ufs_test_data *utd = test_iosched->blk_dev_test_data;
+	unsigned long flags;
 
 	BUG_ON(!test_iosched);
 	sector = test_iosched->start_sector;
@@ -1024,8 +1085,14 @@ static int run_long_test(struct test_iosched *test_iosched)
 		test_iosched->test_count = 0;
 		utd->completed_req_count = 0;
 		inserted_requests = 0;
+		memset(utd->lat_hist, 0, sizeof(utd->lat_hist));
+		utd->lat_max_us = 0;
 	}
 
+	depth = utd->long_test_queue_depth;
+	if (!depth || depth > QUEUE_MAX_REQUESTS)
+		depth = QUEUE_MAX_REQUESTS;
+
 	/* Set test parameters */
 	switch (test_iosched->test_info.testcase) {
 	case  UFS_TEST_LONG_RANDOM_READ:
@@ -1070,7 +1137,8 @@ static int run_long_test(struct test_iosched *test_iosched)
 		* includes a safety margin) and then call the block layer
 		* to fetch them
 		*/
-		if (test_iosched->test_count >= QUEUE_MAX_REQUESTS) {
+		if (test_iosched->test_count >= QUEUE_MAX_REQUESTS ||
+		    test_iosched->dispatched_count >= depth) {
 			blk_post_runtime_resume(test_iosched->req_q, 0);
 			continue;
 		}
@@ -1090,6 +1158,10 @@ static int run_long_test(struct test_iosched *test_iosched)
 			break;
 		}
 
+		spin_lock_irqsave(&test_iosched->lock, flags);
+		utd->lat_issue[test_iosched->wr_rd_next_req_id % LAT_SLOTS] =
+			ktime_get();
+		spin_unlock_irqrestore(&test_iosched->lock, flags);
 		ret = test_iosched_add_wr_rd_test_req(test_iosched, 0,
 			direction, sector, num_bios_per_request,
 			TEST_PATTERN_5A, long_test_free_end_io_fn);
@@ -1099,6 +1171,10 @@ static int run_long_test(struct test_iosched *test_iosched)
 		}
 		inserted_requests++;
 		if (utd->test_stage == UFS_TEST_LONG_SEQUENTIAL_MIXED_STAGE2) {
+			spin_lock_irqsave(&test_iosched->lock, flags);
+			utd->lat_issue[test_iosched->wr_rd_next_req_id %
+				LAT_SLOTS] = ktime_get();
+			spin_unlock_irqrestore(&test_iosched->lock, flags);
 			ret = test_iosched_add_wr_rd_test_req(test_iosched, 0,
 				READ, sector, num_bios_per_request,
 				TEST_PATTERN_5A, long_test_free_end_io_fn);
@@ -1154,6 +1230,11 @@ static int long_rand_test_calc_iops(struct test_iosched *test_iosched)
 	iops = num_ios / mtime;
 
 	pr_info("%s: IOPS: %lu IOP/sec\n", __func__, iops);
+	long_test_report_latency(utd);
+
+	utd->res_testcase = utd->test_info.testcase;
+	utd->res_iops = iops;
+	utd->res_kib_per_sec = iops * (TEST_BIO_SIZE / 1024);
 
 	return ufs_test_post(test_iosched);
 }
@@ -1183,6 +1264,12 @@ static int long_seq_test_calc_throughput(struct test_iosched *test_iosched)
 
 	pr_info("%s: Throughput: %lu.%lu MiB/sec\n", __func__, integer,
 				fraction);
+	long_test_report_latency(utd);
+
+	utd->res_testcase = utd->test_info.testcase;
+	utd->res_iops = utd->completed_req_count * 1000UL /
+		ktime_to_ms(utd->test_info.test_duration);
+	utd->res_kib_per_sec = (integer * 10 + fraction) * 1024 / 10;
 
 	return ufs_test_post(test_iosched);
 }
@@ -1394,6 +1481,47 @@ TEST_OPS(long_sequential_mixed, LONG_SEQUENTIAL_MIXED);
 TEST_OPS(parallel_read_and_write, PARALLEL_READ_AND_WRITE);
 TEST_OPS(lun_depth, LUN_DEPTH);
 
+static int long_test_results_show(struct seq_file *file, void *data)
+{
+	struct ufs_test_data *utd = file->private;
+
+	if (!utd->res_testcase) {
+		seq_puts(file, "no long test has completed\n");
+		return 0;
+	}
+
+	seq_printf(file, "test: %s\n",
+		   ufs_test_get_test_case_str(utd->res_testcase));
+	seq_printf(file, "queue_depth: %u\n", utd->long_test_queue_depth ?
+		   min_t(u32, utd->long_test_queue_depth, QUEUE_MAX_REQUESTS) :
+		   QUEUE_MAX_REQUESTS);
+	seq_printf(file, "requests: %u\n", utd->completed_req_count);
+	seq_printf(file, "iops: %lu\n", utd->res_iops);
+	seq_printf(file, "kib_per_sec: %lu\n", utd->res_kib_per_sec);
+	seq_printf(file, "lat_p50_us: %llu\n",
+		   long_test_latency_permille(utd, 500));
+	seq_printf(file, "lat_p90_us: %llu\n",
+		   long_test_latency_permille(utd, 900));
+	seq_printf(file, "lat_p99_us: %llu\n",
+		   long_test_latency_permille(utd, 990));
+	seq_printf(file, "lat_p999_us: %llu\n",
+		   long_test_latency_permille(utd, 999));
+	seq_printf(file, "lat_max_us: %llu\n", utd->lat_max_us);
+	return 0;
+}
+
+static int long_test_results_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, long_test_results_show, inode->i_private);
+}
+
+static const struct file_operations long_test_results_ops = {
+	.open = long_test_results_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static void ufs_test_debugfs_cleanup(struct test_iosched *test_iosched)
 {
 	struct ufs_test_data *utd = test_iosched->blk_dev_test_data;
@@ -1433,6 +1561,20 @@ static int ufs_test_debugfs_init(struct ufs_test_data *utd)
 		goto exit_err;
 	}
 
+	utd->long_test_queue_depth_dentry = debugfs_create_u32(
+			"long_test_queue_depth", S_IRUGO | S_IWUSR, utils_root,
+			&utd->long_test_queue_depth);
+	utd->long_test_results_dentry = debugfs_create_file(
+			"long_test_results", S_IRUGO, utils_root, utd,
+			&long_test_results_ops);
+	if (!utd->long_test_queue_depth_dentry ||
+	    !utd->long_test_results_dentry) {
+		pr_err("%s: Could not create debugfs long test files.",
+				__func__);
+		ret = -ENOMEM;
+		goto exit_err;
+	}
+
 	ret = add_test(utd, write_read_test, WRITE_READ_TEST);
 	if (ret)
 		goto exit_err;
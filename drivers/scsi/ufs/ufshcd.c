@@ -45,6 +45,7 @@
 #include <linux/of.h>
 #include <linux/blkdev.h>
 #include <linux/hwinfo.h>
+#include <asm/unaligned.h>
 #include "ufshcd.h"
 #include "ufshci.h"
 #include "ufs_quirks.h"
@@ -243,6 +244,17 @@ static void ufshcd_update_uic_error_cnt(struct ufs_hba *hba, u32 reg, int type)
 /* Interrupt aggregation default timeout, unit: 40us */
 #define INT_AGGR_DEF_TO	0x02
 
+/* Flush the WriteBooster buffer once less than 30% of it is available */
+#define UFSHCD_WB_FLUSH_THLD	3
+
+/* Idle gap prediction defaults, in us */
+#define UFSHCD_IDLE_PREDICT_DEF_THLD_US		10000
+#define UFSHCD_IDLE_PREDICT_REF_STDDEV_US	500
+
+/* Adaptive interrupt aggregation default queue depth and sequential run */
+#define INT_AGGR_DEF_QD_THLD	4
+#define INT_AGGR_DEF_SEQ_THLD	8
+
 /* default value of auto suspend is 3 seconds */
 #define UFSHCD_AUTO_SUSPEND_DELAY_MS 3000 /* millisecs */
 
@@ -1317,6 +1329,177 @@ static inline void ufshcd_disable_intr_aggr(struct ufs_hba *hba)
 	ufshcd_writel(hba, 0, REG_UTP_TRANSFER_REQ_INT_AGG_CONTROL);
 }
 
+/**
+ * ufshcd_intr_aggr_cmd - check if a command may complete on an aggregated
+ *			  interrupt
+ * @hba: per adapter instance
+ * @cmd: SCSI command about to be issued
+ *
+ * In adaptive mode completions are only aggregated while the queue is deep
+ * or a sequential stream is being issued, so that a lone request never has
+ * to wait for the aggregation timeout.
+ */
+static bool ufshcd_intr_aggr_cmd(struct ufs_hba *hba, struct scsi_cmnd *cmd)
+{
+	struct ufs_intr_aggr *aggr = &hba->intr_aggr;
+	struct request *req = cmd->request;
+	sector_t pos;
+
+	if (!ufshcd_is_intr_aggr_allowed(hba))
+		return false;
+
+	switch (aggr->mode) {
+	case UFSHCD_INTR_AGGR_ON:
+		return true;
+	case UFSHCD_INTR_AGGR_ADAPTIVE:
+		break;
+	default:
+		return false;
+	}
+
+	if (req->cmd_type != REQ_TYPE_FS)
+		return false;
+
+	/* Racing updates from other CPUs can only skew the heuristic */
+	pos = blk_rq_pos(req);
+	if (pos == aggr->next_pos)
+		aggr->seq_reqs++;
+	else
+		aggr->seq_reqs = 0;
+	aggr->next_pos = pos + blk_rq_sectors(req);
+
+	return aggr->seq_reqs >= aggr->seq_thld ||
+	       hweight_long(READ_ONCE(hba->outstanding_reqs)) >= aggr->qd_thld;
+}
+
+static void ufshcd_update_intr_aggr(struct ufs_hba *hba)
+{
+	pm_runtime_get_sync(hba->dev);
+	ufshcd_hold(hba, false);
+	ufshcd_config_intr_aggr(hba, hba->intr_aggr.cnt, hba->intr_aggr.tmout);
+	ufshcd_release(hba, false);
+	pm_runtime_put_sync(hba->dev);
+}
+
+static ssize_t ufshcd_intr_aggr_mode_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", hba->intr_aggr.mode);
+}
+
+static ssize_t ufshcd_intr_aggr_mode_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	u32 value;
+
+	if (kstrtou32(buf, 0, &value) || value > UFSHCD_INTR_AGGR_ADAPTIVE)
+		return -EINVAL;
+
+	hba->intr_aggr.mode = value;
+	return count;
+}
+
+static ssize_t ufshcd_intr_aggr_cnt_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", hba->intr_aggr.cnt);
+}
+
+static ssize_t ufshcd_intr_aggr_cnt_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	u32 value;
+
+	if (kstrtou32(buf, 0, &value) || !value ||
+	    value > min_t(u32, hba->nutrs - 1,
+			  INT_AGGR_COUNTER_THRESHOLD_MASK >> 8))
+		return -EINVAL;
+
+	if (value != hba->intr_aggr.cnt) {
+		hba->intr_aggr.cnt = value;
+		ufshcd_update_intr_aggr(hba);
+	}
+	return count;
+}
+
+static ssize_t ufshcd_intr_aggr_tmout_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", hba->intr_aggr.tmout);
+}
+
+static ssize_t ufshcd_intr_aggr_tmout_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	u32 value;
+
+	if (kstrtou32(buf, 0, &value) || !value ||
+	    value > INT_AGGR_TIMEOUT_VAL_MASK)
+		return -EINVAL;
+
+	if (value != hba->intr_aggr.tmout) {
+		hba->intr_aggr.tmout = value;
+		ufshcd_update_intr_aggr(hba);
+	}
+	return count;
+}
+
+static void ufshcd_init_intr_aggr(struct ufs_hba *hba)
+{
+	struct ufs_intr_aggr *aggr = &hba->intr_aggr;
+
+	aggr->mode = UFSHCD_INTR_AGGR_ADAPTIVE;
+	aggr->cnt = hba->nutrs - 1;
+	aggr->tmout = INT_AGGR_DEF_TO;
+	aggr->qd_thld = INT_AGGR_DEF_QD_THLD;
+	aggr->seq_thld = INT_AGGR_DEF_SEQ_THLD;
+
+	if (!ufshcd_is_intr_aggr_allowed(hba))
+		return;
+
+	aggr->mode_attr.show = ufshcd_intr_aggr_mode_show;
+	aggr->mode_attr.store = ufshcd_intr_aggr_mode_store;
+	sysfs_attr_init(&aggr->mode_attr.attr);
+	aggr->mode_attr.attr.name = "intr_aggr_mode";
+	aggr->mode_attr.attr.mode = S_IRUGO | S_IWUSR;
+	if (device_create_file(hba->dev, &aggr->mode_attr))
+		dev_err(hba->dev, "Failed to create sysfs for intr_aggr_mode\n");
+
+	aggr->cnt_attr.show = ufshcd_intr_aggr_cnt_show;
+	aggr->cnt_attr.store = ufshcd_intr_aggr_cnt_store;
+	sysfs_attr_init(&aggr->cnt_attr.attr);
+	aggr->cnt_attr.attr.name = "intr_aggr_cnt";
+	aggr->cnt_attr.attr.mode = S_IRUGO | S_IWUSR;
+	if (device_create_file(hba->dev, &aggr->cnt_attr))
+		dev_err(hba->dev, "Failed to create sysfs for intr_aggr_cnt\n");
+
+	aggr->tmout_attr.show = ufshcd_intr_aggr_tmout_show;
+	aggr->tmout_attr.store = ufshcd_intr_aggr_tmout_store;
+	sysfs_attr_init(&aggr->tmout_attr.attr);
+	aggr->tmout_attr.attr.name = "intr_aggr_tmout";
+	aggr->tmout_attr.attr.mode = S_IRUGO | S_IWUSR;
+	if (device_create_file(hba->dev, &aggr->tmout_attr))
+		dev_err(hba->dev, "Failed to create sysfs for intr_aggr_tmout\n");
+}
+
+static void ufshcd_exit_intr_aggr(struct ufs_hba *hba)
+{
+	if (!ufshcd_is_intr_aggr_allowed(hba))
+		return;
+	device_remove_file(hba->dev, &hba->intr_aggr.mode_attr);
+	device_remove_file(hba->dev, &hba->intr_aggr.cnt_attr);
+	device_remove_file(hba->dev, &hba->intr_aggr.tmout_attr);
+}
+
 /**
  * ufshcd_enable_run_stop_reg - Enable run-stop registers,
  *			When run-stop registers are set to 1, it indicates the
@@ -1539,6 +1722,96 @@ static void ufshcd_ungate_work(struct work_struct *work)
 	ufshcd_scsi_unblock_requests(hba);
 }
 
+/*
+ * Predict the length of the idle period that is starting from the recent
+ * idle gaps, in the same way as the cpuidle prediction of lpm-levels: if
+ * the samples do not deviate much their average is used, otherwise the
+ * largest sample is dropped and the check is retried. Without a stable
+ * prediction the fixed hibern8 and clock gating delays are used.
+ */
+static bool ufshcd_idle_predict_long(struct ufs_hba *hba)
+{
+	struct ufs_idle_predict *predict = &hba->idle_predict;
+	u64 max, avg, stddev;
+	u32 thresh = U32_MAX;
+	int i, divisor;
+
+	if (predict->nr_hist < UFSHCD_IDLE_HIST_SIZE)
+		return false;
+
+again:
+	max = avg = stddev = divisor = 0;
+	for (i = 0; i < UFSHCD_IDLE_HIST_SIZE; i++) {
+		u32 value = predict->hist[i];
+
+		if (value <= thresh) {
+			avg += value;
+			divisor++;
+			if (value > max)
+				max = value;
+		}
+	}
+	do_div(avg, divisor);
+
+	for (i = 0; i < UFSHCD_IDLE_HIST_SIZE; i++) {
+		u32 value = predict->hist[i];
+
+		if (value <= thresh) {
+			s64 diff = (s64)value - avg;
+
+			stddev += diff * diff;
+		}
+	}
+	do_div(stddev, divisor);
+	stddev = int_sqrt(stddev);
+
+	if ((avg > stddev * 6 && divisor >= UFSHCD_IDLE_HIST_SIZE - 1) ||
+	    stddev <= UFSHCD_IDLE_PREDICT_REF_STDDEV_US)
+		return avg >= predict->thld_us;
+	else if (divisor > UFSHCD_IDLE_HIST_SIZE - 1) {
+		thresh = max - 1;
+		goto again;
+	}
+
+	return false;
+}
+
+/* host lock must be held, called when the host goes idle */
+static bool ufshcd_idle_predict_start(struct ufs_hba *hba)
+{
+	struct ufs_idle_predict *predict = &hba->idle_predict;
+
+	if (!predict->is_enabled)
+		return false;
+
+	/* clock gating and hibern8 on idle share one prediction */
+	if (!ktime_to_ns(predict->idle_start)) {
+		predict->idle_start = ktime_get();
+		predict->long_idle = ufshcd_idle_predict_long(hba);
+	}
+
+	return predict->long_idle;
+}
+
+/* host lock must be held, called when the host leaves idle */
+static void ufshcd_idle_predict_end(struct ufs_hba *hba)
+{
+	struct ufs_idle_predict *predict = &hba->idle_predict;
+	s64 gap;
+
+	if (!ktime_to_ns(predict->idle_start))
+		return;
+
+	gap = ktime_us_delta(ktime_get(), predict->idle_start);
+	predict->idle_start = ktime_set(0, 0);
+	predict->long_idle = false;
+
+	predict->hist[predict->hist_idx] = clamp_t(s64, gap, 0, U32_MAX);
+	predict->hist_idx = (predict->hist_idx + 1) % UFSHCD_IDLE_HIST_SIZE;
+	if (predict->nr_hist < UFSHCD_IDLE_HIST_SIZE)
+		predict->nr_hist++;
+}
+
 /**
  * ufshcd_hold - Enable clocks that were gated earlier due to ufshcd_release.
  * Also, exit from hibern8 mode and set the link as active.
@@ -1554,6 +1827,7 @@ int ufshcd_hold(struct ufs_hba *hba, bool async)
 		goto out;
 	spin_lock_irqsave(hba->host->host_lock, flags);
 	hba->clk_gating.active_reqs++;
+	ufshcd_idle_predict_end(hba);
 
 	if (ufshcd_eh_in_progress(hba)) {
 		spin_unlock_irqrestore(hba->host->host_lock, flags);
@@ -1738,6 +2012,7 @@ static void __ufshcd_release(struct ufs_hba *hba, bool no_sched)
 	hba->ufs_stats.clk_rel.ts = ktime_get();
 
 	hrtimer_start(&hba->clk_gating.gate_hrtimer,
+			ufshcd_idle_predict_start(hba) ? ktime_set(0, 0) :
 			ms_to_ktime(hba->clk_gating.delay_ms),
 			HRTIMER_MODE_REL);
 }
@@ -2011,6 +2286,7 @@ static int ufshcd_hibern8_hold(struct ufs_hba *hba, bool async)
 
 	spin_lock_irqsave(hba->host->host_lock, flags);
 	hba->hibern8_on_idle.active_reqs++;
+	ufshcd_idle_predict_end(hba);
 
 	if (ufshcd_eh_in_progress(hba)) {
 		spin_unlock_irqrestore(hba->host->host_lock, flags);
@@ -2099,6 +2375,10 @@ static void __ufshcd_hibern8_release(struct ufs_hba *hba, bool no_sched)
 	if (delay_in_jiffies == 1)
 		delay_in_jiffies++;
 
+	/* a long idle gap is expected, don't wait for it to be confirmed */
+	if (ufshcd_idle_predict_start(hba))
+		delay_in_jiffies = 0;
+
 	schedule_delayed_work(&hba->hibern8_on_idle.enter_work,
 			      delay_in_jiffies);
 }
@@ -2367,6 +2647,140 @@ static void ufshcd_exit_hibern8_on_idle(struct ufs_hba *hba)
 	device_remove_file(hba->dev, &hba->hibern8_on_idle.enable_attr);
 }
 
+static ssize_t ufshcd_idle_predict_enable_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", hba->idle_predict.is_enabled);
+}
+
+static ssize_t ufshcd_idle_predict_enable_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	struct ufs_idle_predict *predict = &hba->idle_predict;
+	unsigned long flags;
+	u32 value;
+
+	if (kstrtou32(buf, 0, &value))
+		return -EINVAL;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	predict->is_enabled = !!value;
+	/* start learning from scratch */
+	predict->idle_start = ktime_set(0, 0);
+	predict->long_idle = false;
+	predict->hist_idx = 0;
+	predict->nr_hist = 0;
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	return count;
+}
+
+static ssize_t ufshcd_idle_predict_thld_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", hba->idle_predict.thld_us);
+}
+
+static ssize_t ufshcd_idle_predict_thld_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	unsigned long flags;
+	u32 value;
+
+	if (kstrtou32(buf, 0, &value))
+		return -EINVAL;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	hba->idle_predict.thld_us = value;
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	return count;
+}
+
+static void ufshcd_init_idle_predict(struct ufs_hba *hba)
+{
+	struct ufs_idle_predict *predict = &hba->idle_predict;
+
+	predict->thld_us = UFSHCD_IDLE_PREDICT_DEF_THLD_US;
+
+	if (!ufshcd_is_clkgating_allowed(hba) &&
+	    !ufshcd_is_hibern8_on_idle_allowed(hba))
+		return;
+
+	predict->enable_attr.show = ufshcd_idle_predict_enable_show;
+	predict->enable_attr.store = ufshcd_idle_predict_enable_store;
+	sysfs_attr_init(&predict->enable_attr.attr);
+	predict->enable_attr.attr.name = "idle_predict_enable";
+	predict->enable_attr.attr.mode = S_IRUGO | S_IWUSR;
+	if (device_create_file(hba->dev, &predict->enable_attr))
+		dev_err(hba->dev, "Failed to create sysfs for idle_predict_enable\n");
+
+	predict->thld_attr.show = ufshcd_idle_predict_thld_show;
+	predict->thld_attr.store = ufshcd_idle_predict_thld_store;
+	sysfs_attr_init(&predict->thld_attr.attr);
+	predict->thld_attr.attr.name = "idle_predict_thld_us";
+	predict->thld_attr.attr.mode = S_IRUGO | S_IWUSR;
+	if (device_create_file(hba->dev, &predict->thld_attr))
+		dev_err(hba->dev, "Failed to create sysfs for idle_predict_thld_us\n");
+}
+
+static void ufshcd_exit_idle_predict(struct ufs_hba *hba)
+{
+	if (!ufshcd_is_clkgating_allowed(hba) &&
+	    !ufshcd_is_hibern8_on_idle_allowed(hba))
+		return;
+	device_remove_file(hba->dev, &hba->idle_predict.enable_attr);
+	device_remove_file(hba->dev, &hba->idle_predict.thld_attr);
+}
+
+static ssize_t ufshcd_prio_read_headq_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", hba->prio_read_headq);
+}
+
+static ssize_t ufshcd_prio_read_headq_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	u32 value;
+
+	if (kstrtou32(buf, 0, &value))
+		return -EINVAL;
+
+	WRITE_ONCE(hba->prio_read_headq, !!value);
+
+	return count;
+}
+
+/*
+ * Off by default, not every device schedules head of queue commands
+ * any differently from simple ones.
+ */
+static void ufshcd_init_prio_read_headq(struct ufs_hba *hba)
+{
+	hba->prio_read_headq_attr.show = ufshcd_prio_read_headq_show;
+	hba->prio_read_headq_attr.store = ufshcd_prio_read_headq_store;
+	sysfs_attr_init(&hba->prio_read_headq_attr.attr);
+	hba->prio_read_headq_attr.attr.name = "prio_read_headq";
+	hba->prio_read_headq_attr.attr.mode = S_IRUGO | S_IWUSR;
+	if (device_create_file(hba->dev, &hba->prio_read_headq_attr))
+		dev_err(hba->dev, "Failed to create sysfs for prio_read_headq\n");
+}
+
+static void ufshcd_exit_prio_read_headq(struct ufs_hba *hba)
+{
+	device_remove_file(hba->dev, &hba->prio_read_headq_attr);
+}
+
 static void ufshcd_hold_all(struct ufs_hba *hba)
 {
 	ufshcd_hold(hba, false);
@@ -2948,6 +3362,10 @@ static int ufshcd_compose_upiu(struct ufs_hba *hba, struct ufshcd_lrb *lrbp)
 		if (likely(lrbp->cmd)) {
 			ret = ufshcd_prepare_req_desc_hdr(hba, lrbp,
 				&upiu_flags, lrbp->cmd->sc_data_direction);
+			if (hba->prio_read_headq && lrbp->cmd->request &&
+			    (lrbp->cmd->request->cmd_flags & REQ_PRIO) &&
+			    lrbp->cmd->sc_data_direction == DMA_FROM_DEVICE)
+				upiu_flags |= UPIU_TASK_ATTR_HEADQ;
 			ufshcd_prepare_utp_scsi_cmd_upiu(lrbp, upiu_flags);
 		} else {
 			ret = -EINVAL;
@@ -3201,7 +3619,7 @@ static int ufshcd_queuecommand(struct Scsi_Host *host, struct scsi_cmnd *cmd)
 	lrbp->sense_buffer = cmd->sense_buffer;
 	lrbp->task_tag = tag;
 	lrbp->lun = ufshcd_scsi_to_upiu_lun(cmd->device->lun);
-	lrbp->intr_cmd = !ufshcd_is_intr_aggr_allowed(hba) ? true : false;
+	lrbp->intr_cmd = !ufshcd_intr_aggr_cmd(hba, cmd);
 	lrbp->command_type = UTP_CMD_TYPE_SCSI;
 	lrbp->req_abort_skip = false;
 
@@ -5064,7 +5482,8 @@ static int ufshcd_make_hba_operational(struct ufs_hba *hba)
 
 	/* Configure interrupt aggregation */
 	if (ufshcd_is_intr_aggr_allowed(hba))
-		ufshcd_config_intr_aggr(hba, hba->nutrs - 1, INT_AGGR_DEF_TO);
+		ufshcd_config_intr_aggr(hba, hba->intr_aggr.cnt,
+					hba->intr_aggr.tmout);
 	else
 		ufshcd_disable_intr_aggr(hba);
 
@@ -5514,8 +5933,15 @@ static int ufshcd_slave_configure(struct scsi_device *sdev)
 		scsi_set_cmd_timeout_override(sdev, hba->scsi_cmd_timeout * HZ);
 	}
 
-	sdev->autosuspend_delay = UFSHCD_AUTO_SUSPEND_DELAY_MS;
-	sdev->use_rpm_auto = 1;
+	/*
+	 * Block layer runtime PM only tracks requests of the legacy path, a
+	 * blk-mq queue could be suspended with requests in flight. The host
+	 * still saves power through clock gating and hibern8 on idle.
+	 */
+	if (!shost_use_blk_mq(sdev->host)) {
+		sdev->autosuspend_delay = UFSHCD_AUTO_SUSPEND_DELAY_MS;
+		sdev->use_rpm_auto = 1;
+	}
 
 	return 0;
 }
@@ -7939,6 +8365,136 @@ static int ufshcd_get_dev_ref_clk_gating_wait(struct ufs_hba *hba)
 	return err;
 }
 
+/**
+ * ufshcd_wb_probe - check if the device has a shared WriteBooster buffer
+ * @hba: per-adapter instance
+ * @desc_buf: device descriptor
+ */
+static void ufshcd_wb_probe(struct ufs_hba *hba, u8 *desc_buf)
+{
+	u32 ext_ufs_feature, alloc_units;
+
+	if (hba->desc_size.dev_desc < DEVICE_DESC_PARAM_WB_SHARED_ALLOC_UNITS + 4)
+		return;
+
+	ext_ufs_feature = get_unaligned_be32(desc_buf +
+				DEVICE_DESC_PARAM_EXT_UFS_FEATURE_SUP);
+	if (!(ext_ufs_feature & UFS_DEV_WRITE_BOOSTER_SUP))
+		return;
+
+	/* LU dedicated buffers need per LU flag queries, not supported */
+	if (desc_buf[DEVICE_DESC_PARAM_WB_TYPE] != WB_BUF_MODE_SHARED) {
+		dev_info(hba->dev, "%s: LU dedicated WriteBooster buffer not supported\n",
+			__func__);
+		return;
+	}
+
+	alloc_units = get_unaligned_be32(desc_buf +
+				DEVICE_DESC_PARAM_WB_SHARED_ALLOC_UNITS);
+	if (!alloc_units)
+		return;
+
+	hba->dev_info.wb_supported = true;
+}
+
+static int ufshcd_wb_ctrl(struct ufs_hba *hba, bool enable)
+{
+	int ret;
+
+	if (!hba->dev_info.wb_supported || hba->dev_info.wb_enabled == enable)
+		return 0;
+
+	ret = ufshcd_query_flag_retry(hba, enable ? UPIU_QUERY_OPCODE_SET_FLAG :
+				      UPIU_QUERY_OPCODE_CLEAR_FLAG,
+				      QUERY_FLAG_IDN_WB_EN, NULL);
+	if (ret) {
+		dev_err(hba->dev, "%s: WriteBooster %s failed %d\n",
+			__func__, enable ? "enable" : "disable", ret);
+		return ret;
+	}
+
+	hba->dev_info.wb_enabled = enable;
+	return 0;
+}
+
+static int ufshcd_wb_toggle_flush(struct ufs_hba *hba, bool enable)
+{
+	int ret;
+
+	if (!hba->dev_info.wb_supported ||
+	    hba->dev_info.wb_flush_enabled == enable)
+		return 0;
+
+	ret = ufshcd_query_flag_retry(hba, enable ? UPIU_QUERY_OPCODE_SET_FLAG :
+				      UPIU_QUERY_OPCODE_CLEAR_FLAG,
+				      QUERY_FLAG_IDN_WB_BUFF_FLUSH_EN, NULL);
+	if (ret) {
+		dev_err(hba->dev, "%s: WriteBooster flush %s failed %d\n",
+			__func__, enable ? "enable" : "disable", ret);
+		return ret;
+	}
+
+	hba->dev_info.wb_flush_enabled = enable;
+	return 0;
+}
+
+/* Is less than UFSHCD_WB_FLUSH_THLD (in 10% units) of the buffer left? */
+static bool ufshcd_wb_need_flush(struct ufs_hba *hba)
+{
+	u32 avail_buf;
+	int ret;
+
+	ret = ufshcd_query_attr_retry(hba, UPIU_QUERY_OPCODE_READ_ATTR,
+			QUERY_ATTR_IDN_AVAIL_WB_BUFF_SIZE, 0, 0, &avail_buf);
+	if (ret) {
+		dev_err(hba->dev, "%s: reading bAvailableWriteBoosterBufferSize failed %d\n",
+			__func__, ret);
+		return false;
+	}
+
+	return avail_buf < UFSHCD_WB_FLUSH_THLD;
+}
+
+/**
+ * ufshcd_wb_scale - follow the clock scaling decision with WriteBooster
+ * @hba: per-adapter instance
+ * @scale_up: clocks were scaled up
+ *
+ * Write bursts scale the clocks up, so the buffer is only used while the
+ * clocks are scaled up. Once the load drops the buffer is flushed to the
+ * normal storage if it is running low, the device also flushes it on its
+ * own while the link is in hibern8.
+ */
+static void ufshcd_wb_scale(struct ufs_hba *hba, bool scale_up)
+{
+	if (!hba->dev_info.wb_supported)
+		return;
+
+	ufshcd_wb_ctrl(hba, scale_up);
+	ufshcd_wb_toggle_flush(hba, !scale_up && ufshcd_wb_need_flush(hba));
+}
+
+static void ufshcd_wb_config(struct ufs_hba *hba)
+{
+	int ret;
+
+	if (!hba->dev_info.wb_supported)
+		return;
+
+	ret = ufshcd_query_flag_retry(hba, UPIU_QUERY_OPCODE_SET_FLAG,
+			QUERY_FLAG_IDN_WB_BUFF_FLUSH_DURING_HIBERN8, NULL);
+	if (ret)
+		dev_err(hba->dev, "%s: enabling WriteBooster flush during hibern8 failed %d\n",
+			__func__, ret);
+
+	/*
+	 * The link is brought up in its max power mode, which is where clock
+	 * scaling starts from as well. Without clock scaling the buffer stays
+	 * in use.
+	 */
+	ufshcd_wb_ctrl(hba, true);
+}
+
 static int ufs_read_device_desc_data(struct ufs_hba *hba)
 {
 	int err = 0;
@@ -7971,6 +8527,8 @@ static int ufs_read_device_desc_data(struct ufs_hba *hba)
 		desc_buf[DEVICE_DESC_PARAM_SPEC_VER] << 8 |
 		desc_buf[DEVICE_DESC_PARAM_SPEC_VER + 1];
 
+	ufshcd_wb_probe(hba, desc_buf);
+
 	update_hardware_info(TYPE_EMMC, hba->dev_info.w_manufacturer_id);
 	dev_info(hba->dev, "UFS manufacturer id: 0x%04X\n", hba->dev_info.w_manufacturer_id);
 
@@ -8078,6 +8636,7 @@ static int ufshcd_probe_hba(struct ufs_hba *hba)
 	/* UFS device is also active now */
 	ufshcd_set_ufs_dev_active(hba);
 	ufshcd_force_reset_auto_bkops(hba);
+	ufshcd_wb_config(hba);
 
 	if (ufshcd_get_max_pwr_mode(hba)) {
 		dev_err(hba->dev,
@@ -10076,6 +10635,9 @@ void ufshcd_remove(struct ufs_hba *hba)
 
 	ufshcd_exit_clk_gating(hba);
 	ufshcd_exit_hibern8_on_idle(hba);
+	ufshcd_exit_idle_predict(hba);
+	ufshcd_exit_prio_read_headq(hba);
+	ufshcd_exit_intr_aggr(hba);
 	ufshcd_exit_latency_hist(hba);
 	if (ufshcd_is_clkscaling_supported(hba)) {
 		device_remove_file(hba->dev, &hba->clk_scaling.enable_attr);
@@ -10381,6 +10943,8 @@ static int ufshcd_devfreq_scale(struct ufs_hba *hba, bool scale_up)
 		ufshcd_scale_gear(hba, true);
 clk_scaling_unprepare:
 	ufshcd_clock_scaling_unprepare(hba);
+	if (!ret)
+		ufshcd_wb_scale(hba, scale_up);
 out:
 	hba->ufs_stats.clk_rel.ctx = CLK_SCALE_WORK;
 	ufshcd_release_all(hba);
@@ -10712,6 +11276,17 @@ int ufshcd_init(struct ufs_hba *hba, void __iomem *mmio_base, unsigned int irq)
 	host->max_cmd_len = MAX_CDB_SIZE;
 	host->set_dbd_for_caching = 1;
 
+	/*
+	 * The transfer request slots sit behind a single doorbell and blk-mq
+	 * tags are allocated per hardware context, so a single context is
+	 * kept and its tags are used as the slot numbers. Every CPU gets its
+	 * own software queue in front of it.
+	 */
+	if (IS_ENABLED(CONFIG_SCSI_UFSHCD_MQ)) {
+		host->use_blk_mq = 1;
+		host->nr_hw_queues = 1;
+	}
+
 	hba->max_pwr_info.is_valid = false;
 
 	/* Initailize wait queue for task management */
@@ -10737,6 +11312,9 @@ int ufshcd_init(struct ufs_hba *hba, void __iomem *mmio_base, unsigned int irq)
 
 	ufshcd_init_clk_gating(hba);
 	ufshcd_init_hibern8_on_idle(hba);
+	ufshcd_init_idle_predict(hba);
+	ufshcd_init_prio_read_headq(hba);
+	ufshcd_init_intr_aggr(hba);
 
 	/*
 	 * In order to avoid any spurious interrupt immediately after
@@ -485,6 +485,67 @@ struct ufs_hibern8_on_idle {
 	bool is_enabled;
 };
 
+enum ufshcd_intr_aggr_mode {
+	UFSHCD_INTR_AGGR_OFF,
+	UFSHCD_INTR_AGGR_ON,
+	UFSHCD_INTR_AGGR_ADAPTIVE,
+};
+
+/**
+ * struct ufs_intr_aggr - UFS transfer request interrupt aggregation data
+ * @mode: which requests are aggregated, one of enum ufshcd_intr_aggr_mode
+ * @cnt: completion counter threshold programmed into UTRIACR
+ * @tmout: aggregation timeout programmed into UTRIACR, in 40us units
+ * @qd_thld: in adaptive mode, the least number of outstanding requests for
+ * a new request to be aggregated
+ * @seq_thld: in adaptive mode, the least number of back to back sequential
+ * requests for a new request to be aggregated
+ * @next_pos: sector following the last issued request
+ * @seq_reqs: number of back to back sequential requests issued
+ * @mode_attr: sysfs attribute to select the aggregation mode
+ * @cnt_attr: sysfs attribute to control cnt
+ * @tmout_attr: sysfs attribute to control tmout
+ */
+struct ufs_intr_aggr {
+	enum ufshcd_intr_aggr_mode mode;
+	u8 cnt;
+	u8 tmout;
+	u32 qd_thld;
+	u32 seq_thld;
+	sector_t next_pos;
+	u32 seq_reqs;
+	struct device_attribute mode_attr;
+	struct device_attribute cnt_attr;
+	struct device_attribute tmout_attr;
+};
+
+#define UFSHCD_IDLE_HIST_SIZE	8
+
+/**
+ * struct ufs_idle_predict - UFS idle gap prediction related data
+ * @is_enabled: enter hibern8 and gate clocks right away when a long idle
+ * gap is predicted, use the fixed delays otherwise
+ * @idle_start: time at which the host last went idle, zero while busy
+ * @hist: most recent idle gaps in us
+ * @hist_idx: slot of @hist to be written next
+ * @nr_hist: number of valid samples in @hist
+ * @thld_us: least predicted gap (in us) that enters low power right away
+ * @long_idle: the current idle period is predicted to be long
+ * @enable_attr: sysfs attribute to enable/disable prediction
+ * @thld_attr: sysfs attribute to control thld_us
+ */
+struct ufs_idle_predict {
+	bool is_enabled;
+	ktime_t idle_start;
+	u32 hist[UFSHCD_IDLE_HIST_SIZE];
+	int hist_idx;
+	int nr_hist;
+	u32 thld_us;
+	bool long_idle;
+	struct device_attribute enable_attr;
+	struct device_attribute thld_attr;
+};
+
 struct ufs_saved_pwr_info {
 	struct ufs_pa_layer_attr info;
 	bool is_valid;
@@ -756,6 +817,10 @@ enum ufshcd_card_state {
  * @pwr_info: holds current power mode
  * @max_pwr_info: keeps the device max valid pwm
  * @hibern8_on_idle: UFS Hibern8 on idle related data
+ * @intr_aggr: UFS transfer request interrupt aggregation related data
+ * @idle_predict: UFS idle gap prediction related data
+ * @prio_read_headq: send REQ_PRIO reads as head of queue commands
+ * @prio_read_headq_attr: sysfs attribute to control prio_read_headq
  * @urgent_bkops_lvl: keeps track of urgent bkops level for device
  * @is_urgent_bkops_lvl_checked: keeps track if the urgent bkops level for
  *  device is known or not.
@@ -937,6 +1002,10 @@ struct ufs_hba {
 
 	struct ufs_clk_gating clk_gating;
 	struct ufs_hibern8_on_idle hibern8_on_idle;
+	struct ufs_intr_aggr intr_aggr;
+	struct ufs_idle_predict idle_predict;
+	bool prio_read_headq;
+	struct device_attribute prio_read_headq_attr;
 	struct ufshcd_cmd_log cmd_log;
 
 	/* Control to enable/disable host capabilities */
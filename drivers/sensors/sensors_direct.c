@@ -0,0 +1,357 @@
+/* Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Direct channel for high rate sensor streams.
+ *
+ * Instead of one QMI message per sample, the SLPI writes samples into a
+ * ring in SMEM and only rings an SMP2P doorbell once the number of pending
+ * samples reaches the watermark set by the AP. The consumer either read()s
+ * the samples or maps the ring read-only and hands back its read index
+ * with write(). The ring layout is in <linux/sensors_direct.h>.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/gpio.h>
+#include <linux/interrupt.h>
+#include <linux/log2.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/of_gpio.h>
+#include <linux/platform_device.h>
+#include <linux/poll.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
+#include <linux/sensors_direct.h>
+#include <soc/qcom/smem.h>
+
+#define DRV_NAME		"sensors_direct"
+#define SNS_DIRECT_NR_EVENTS	1024
+#define SNS_DIRECT_WATERMARK	32
+
+struct sns_direct {
+	struct device *dev;
+	struct miscdevice misc;
+	struct sns_direct_ring *ring;
+	size_t ring_size;
+	int irq;
+	wait_queue_head_t wq;
+	struct mutex lock;
+	atomic_t opened;
+};
+
+static u32 sns_direct_pending(struct sns_direct *sd)
+{
+	struct sns_direct_ring *ring = sd->ring;
+	u32 pending = READ_ONCE(ring->write_idx) - ring->read_idx;
+
+	/* Samples must not be read before the index that covers them */
+	rmb();
+	return min(pending, ring->nr_events);
+}
+
+/*
+ * Arm the doorbell and check again, so samples that reached the watermark
+ * while the doorbell was not armed are not missed.
+ */
+static bool sns_direct_ready(struct sns_direct *sd)
+{
+	struct sns_direct_ring *ring = sd->ring;
+
+	if (sns_direct_pending(sd) >= ring->watermark)
+		return true;
+
+	WRITE_ONCE(ring->armed, 1);
+	mb();
+	return sns_direct_pending(sd) >= ring->watermark;
+}
+
+static irqreturn_t sns_direct_doorbell(int irq, void *data)
+{
+	struct sns_direct *sd = data;
+
+	wake_up_interruptible(&sd->wq);
+	return IRQ_HANDLED;
+}
+
+static void sns_direct_advance(struct sns_direct *sd, u32 read_idx)
+{
+	/* Done with the samples before handing their slots back */
+	mb();
+	WRITE_ONCE(sd->ring->read_idx, read_idx);
+}
+
+static ssize_t sns_direct_read(struct file *file, char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	struct sns_direct *sd = container_of(file->private_data,
+					     struct sns_direct, misc);
+	struct sns_direct_ring *ring = sd->ring;
+	u32 n, idx, chunk;
+	ssize_t ret = 0;
+
+	if (count < sizeof(struct sns_direct_event))
+		return -EINVAL;
+
+	if (!(file->f_flags & O_NONBLOCK)) {
+		ret = wait_event_interruptible(sd->wq, sns_direct_ready(sd));
+		if (ret)
+			return ret;
+	}
+
+	mutex_lock(&sd->lock);
+	n = min_t(u32, sns_direct_pending(sd),
+		  count / sizeof(struct sns_direct_event));
+	if (!n) {
+		mutex_unlock(&sd->lock);
+		return -EAGAIN;
+	}
+
+	idx = ring->read_idx & (ring->nr_events - 1);
+	chunk = min(n, ring->nr_events - idx);
+	if (copy_to_user(buf, &ring->events[idx],
+			 chunk * sizeof(struct sns_direct_event)) ||
+	    copy_to_user(buf + chunk * sizeof(struct sns_direct_event),
+			 &ring->events[0],
+			 (n - chunk) * sizeof(struct sns_direct_event))) {
+		ret = -EFAULT;
+	} else {
+		sns_direct_advance(sd, ring->read_idx + n);
+		ret = n * sizeof(struct sns_direct_event);
+	}
+	mutex_unlock(&sd->lock);
+
+	return ret;
+}
+
+/*
+ * Consumers that map the ring return the slots they are done with by
+ * writing their new read index.
+ */
+static ssize_t sns_direct_write(struct file *file, const char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	struct sns_direct *sd = container_of(file->private_data,
+					     struct sns_direct, misc);
+	u32 read_idx;
+	int ret = count;
+
+	if (count != sizeof(read_idx))
+		return -EINVAL;
+
+	if (copy_from_user(&read_idx, buf, sizeof(read_idx)))
+		return -EFAULT;
+
+	mutex_lock(&sd->lock);
+	if (read_idx - sd->ring->read_idx > sns_direct_pending(sd))
+		ret = -EINVAL;
+	else
+		sns_direct_advance(sd, read_idx);
+	mutex_unlock(&sd->lock);
+
+	return ret;
+}
+
+static unsigned int sns_direct_poll(struct file *file, poll_table *wait)
+{
+	struct sns_direct *sd = container_of(file->private_data,
+					     struct sns_direct, misc);
+
+	poll_wait(file, &sd->wq, wait);
+
+	return sns_direct_ready(sd) ? POLLIN | POLLRDNORM : 0;
+}
+
+static long sns_direct_ioctl(struct file *file, unsigned int cmd,
+			     unsigned long arg)
+{
+	struct sns_direct *sd = container_of(file->private_data,
+					     struct sns_direct, misc);
+	u32 watermark;
+
+	switch (cmd) {
+	case SNS_DIRECT_IOCTL_SET_WATERMARK:
+		if (get_user(watermark, (u32 __user *)arg))
+			return -EFAULT;
+		if (!watermark || watermark > sd->ring->nr_events)
+			return -EINVAL;
+		WRITE_ONCE(sd->ring->watermark, watermark);
+		return 0;
+	default:
+		return -ENOTTY;
+	}
+}
+
+static int sns_direct_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct sns_direct *sd = container_of(file->private_data,
+					     struct sns_direct, misc);
+	unsigned long size = vma->vm_end - vma->vm_start;
+	phys_addr_t phys = smem_virt_to_phys(sd->ring);
+
+	if (vma->vm_pgoff || size > PAGE_ALIGN(sd->ring_size) ||
+	    (vma->vm_flags & VM_WRITE) || !PAGE_ALIGNED(phys))
+		return -EINVAL;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+
+	return remap_pfn_range(vma, vma->vm_start, phys >> PAGE_SHIFT, size,
+			       vma->vm_page_prot);
+}
+
+/* The ring has a single reader */
+static int sns_direct_open(struct inode *inode, struct file *file)
+{
+	struct sns_direct *sd = container_of(file->private_data,
+					     struct sns_direct, misc);
+
+	if (atomic_cmpxchg(&sd->opened, 0, 1))
+		return -EBUSY;
+
+	return nonseekable_open(inode, file);
+}
+
+static int sns_direct_release(struct inode *inode, struct file *file)
+{
+	struct sns_direct *sd = container_of(file->private_data,
+					     struct sns_direct, misc);
+
+	WRITE_ONCE(sd->ring->armed, 0);
+	atomic_set(&sd->opened, 0);
+	return 0;
+}
+
+static const struct file_operations sns_direct_fops = {
+	.owner = THIS_MODULE,
+	.open = sns_direct_open,
+	.release = sns_direct_release,
+	.read = sns_direct_read,
+	.write = sns_direct_write,
+	.poll = sns_direct_poll,
+	.unlocked_ioctl = sns_direct_ioctl,
+	.compat_ioctl = sns_direct_ioctl,
+	.mmap = sns_direct_mmap,
+	.llseek = no_llseek,
+};
+
+static int sensors_direct_probe(struct platform_device *pdev)
+{
+	struct device_node *node = pdev->dev.of_node;
+	struct sns_direct *sd;
+	u32 smem_id, nr_events = SNS_DIRECT_NR_EVENTS;
+	int gpio, ret;
+
+	sd = devm_kzalloc(&pdev->dev, sizeof(*sd), GFP_KERNEL);
+	if (!sd)
+		return -ENOMEM;
+
+	sd->dev = &pdev->dev;
+	init_waitqueue_head(&sd->wq);
+	mutex_init(&sd->lock);
+
+	ret = of_property_read_u32(node, "qcom,smem-id", &smem_id);
+	if (ret) {
+		dev_err(&pdev->dev, "%s: qcom,smem-id missing\n", __func__);
+		return ret;
+	}
+
+	of_property_read_u32(node, "qcom,nr-events", &nr_events);
+	if (!is_power_of_2(nr_events)) {
+		dev_err(&pdev->dev, "%s: nr-events %u not a power of 2\n",
+			__func__, nr_events);
+		return -EINVAL;
+	}
+
+	gpio = of_get_named_gpio(node, "qcom,doorbell-gpio", 0);
+	if (gpio == -EPROBE_DEFER)
+		return gpio;
+	if (gpio < 0) {
+		dev_err(&pdev->dev, "%s: doorbell gpio missing %d\n",
+			__func__, gpio);
+		return gpio;
+	}
+
+	sd->ring_size = sizeof(struct sns_direct_ring) +
+			nr_events * sizeof(struct sns_direct_event);
+	sd->ring = smem_alloc(smem_id, PAGE_ALIGN(sd->ring_size), SMEM_DSPS, 0);
+	if (!sd->ring) {
+		dev_err(&pdev->dev, "%s: smem item %u unavailable\n",
+			__func__, smem_id);
+		return -EPROBE_DEFER;
+	}
+
+	/* Indices are owned by the hub once it is running, keep them */
+	if (sd->ring->magic != SNS_DIRECT_MAGIC ||
+	    sd->ring->nr_events != nr_events) {
+		sd->ring->version = SNS_DIRECT_VERSION;
+		sd->ring->nr_events = nr_events;
+		sd->ring->watermark = SNS_DIRECT_WATERMARK;
+		sd->ring->write_idx = 0;
+		sd->ring->read_idx = 0;
+		sd->ring->armed = 0;
+		sd->ring->dropped = 0;
+		wmb();
+		sd->ring->magic = SNS_DIRECT_MAGIC;
+	}
+
+	sd->irq = gpio_to_irq(gpio);
+	ret = devm_request_irq(&pdev->dev, sd->irq, sns_direct_doorbell,
+			       IRQF_TRIGGER_RISING | IRQF_TRIGGER_FALLING,
+			       DRV_NAME, sd);
+	if (ret) {
+		dev_err(&pdev->dev, "%s: doorbell irq %d failed %d\n",
+			__func__, sd->irq, ret);
+		return ret;
+	}
+
+	sd->misc.minor = MISC_DYNAMIC_MINOR;
+	sd->misc.name = DRV_NAME;
+	sd->misc.fops = &sns_direct_fops;
+	ret = misc_register(&sd->misc);
+	if (ret)
+		return ret;
+
+	platform_set_drvdata(pdev, sd);
+	return 0;
+}
+
+static int sensors_direct_remove(struct platform_device *pdev)
+{
+	struct sns_direct *sd = platform_get_drvdata(pdev);
+
+	misc_deregister(&sd->misc);
+	return 0;
+}
+
+static const struct of_device_id sensors_direct_dt_match[] = {
+	{.compatible = "qcom,sensors-direct-channel"},
+	{},
+};
+MODULE_DEVICE_TABLE(of, sensors_direct_dt_match);
+
+static struct platform_driver sensors_direct_driver = {
+	.probe = sensors_direct_probe,
+	.remove = sensors_direct_remove,
+	.driver = {
+		.name = DRV_NAME,
+		.owner = THIS_MODULE,
+		.of_match_table = sensors_direct_dt_match,
+	},
+};
+
+module_platform_driver(sensors_direct_driver);
+MODULE_DESCRIPTION("Sensors direct channel over SMEM and SMP2P");
+MODULE_LICENSE("GPL v2");
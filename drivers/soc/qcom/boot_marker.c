@@ -31,6 +31,10 @@
 #define MAX_STRING_LEN 256
 #define BOOT_MARKER_MAX_LEN 40
 
+/* Durations below this are not worth a marker */
+static unsigned int duration_threshold_us = 10000;
+module_param(duration_threshold_us, uint, 0644);
+
 struct boot_marker {
 	char marker_name[BOOT_MARKER_MAX_LEN];
 	unsigned long long int timer_value;
@@ -86,6 +90,32 @@ void place_marker(const char *name)
 }
 EXPORT_SYMBOL(place_marker);
 
+/**
+ * place_duration_marker() - record how long a boot step took
+ * @duration_us: duration of the step in microseconds
+ * @fmt: printf style marker name
+ *
+ * Steps shorter than duration_threshold_us are dropped. The marker value
+ * is the duration in sclk ticks, like the bootloader "D - " markers.
+ */
+void place_duration_marker(unsigned long long duration_us,
+		const char *fmt, ...)
+{
+	char name[BOOT_MARKER_MAX_LEN];
+	va_list args;
+
+	if (duration_us < duration_threshold_us)
+		return;
+
+	va_start(args, fmt);
+	vsnprintf(name, sizeof(name), fmt, args);
+	va_end(args);
+
+	_create_boot_marker(name, div_u64(duration_us * TIMER_KHZ,
+				USEC_PER_SEC));
+}
+EXPORT_SYMBOL(place_duration_marker);
+
 static ssize_t bootkpi_reader(struct file *fp, char __user *user_buffer,
 		size_t count, loff_t *position)
 {
@@ -13,6 +13,7 @@
 #include <linux/err.h>
 #include <linux/fs.h>
 #include <linux/gfp.h>
+#include <linux/hrtimer.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/ipc_logging.h>
@@ -53,6 +54,8 @@
 #define RPM_FIFO_ADDR_ALIGN_BYTES 3
 #define TRACER_PKT_FEATURE BIT(2)
 #define DEFERRED_CMDS_THRESHOLD 25
+#define TX_COALESCE_MAX_LCID 128
+#define TX_COALESCE_MAX_EXCLUDE 16
 #define NUM_LOG_PAGES	4
 
 /**
@@ -184,6 +187,16 @@ struct mailbox_config_info {
  * @deferred_cmds:		List of deferred commands that need to be
  *				processed in process context.
  * @deferred_cmds_cnt:		Number of deferred commands in queue.
+ * @rx_irq_thread:		Deferred commands are processed in the threaded
+ *				half of the rx irq instead of @kworker.
+ * @tx_coalesce_us:		Window in which data packet doorbells are
+ *				merged into one, 0 if disabled.
+ * @tx_irq_timer:		Timer raising a coalesced doorbell.
+ * @tx_irq_pending:		A data packet was written without a doorbell.
+ *				Protected by @write_lock.
+ * @tx_coalesce_lcids:		Local channels whose data may be coalesced.
+ * @tx_no_coalesce:		Channel names that always ring immediately.
+ * @num_tx_no_coalesce:		Number of entries in @tx_no_coalesce.
  * @rt_vote_lock:		Serialize access to RT rx votes
  * @rt_votes:			Vote count for RT rx thread priority
  * @num_pw_states:		Size of @ramp_time_us.
@@ -225,6 +238,13 @@ struct edge_info {
 	spinlock_t rx_lock;
 	struct list_head deferred_cmds;
 	uint32_t deferred_cmds_cnt;
+	bool rx_irq_thread;
+	uint32_t tx_coalesce_us;
+	struct hrtimer tx_irq_timer;
+	bool tx_irq_pending;
+	DECLARE_BITMAP(tx_coalesce_lcids, TX_COALESCE_MAX_LCID);
+	const char *tx_no_coalesce[TX_COALESCE_MAX_EXCLUDE];
+	int num_tx_no_coalesce;
 	spinlock_t rt_vote_lock;
 	uint32_t rt_votes;
 	uint32_t num_pw_states;
@@ -557,6 +577,58 @@ static int fifo_write_body(struct edge_info *einfo, const void *_data,
 	return len;
 }
 
+/**
+ * tx_irq() - signal the remote after a write, possibly coalesced
+ * @einfo:	The edge that was written to.
+ * @lazy:	The write may share a doorbell with later writes.
+ *
+ * Lazy writes on an edge with a coalescing window only arm a timer, so a
+ * burst of packets costs the remote one interrupt.  Any other write, or a
+ * lazy write that leaves the fifo more than half full, signals right away
+ * and covers whatever was pending.  Called with @write_lock held.
+ */
+static void tx_irq(struct edge_info *einfo, bool lazy)
+{
+	if (!lazy || !einfo->tx_coalesce_us ||
+	    fifo_write_avail(einfo) < einfo->tx_fifo_size / 2) {
+		if (einfo->tx_irq_pending) {
+			einfo->tx_irq_pending = false;
+			hrtimer_try_to_cancel(&einfo->tx_irq_timer);
+		}
+		send_irq(einfo);
+		return;
+	}
+
+	if (!einfo->tx_irq_pending) {
+		einfo->tx_irq_pending = true;
+		hrtimer_start(&einfo->tx_irq_timer,
+			      ns_to_ktime(einfo->tx_coalesce_us * NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+	}
+}
+
+/**
+ * tx_irq_timer_fn() - raise a doorbell deferred by tx_irq()
+ * @timer:	The edge's coalescing timer.
+ *
+ * Return: HRTIMER_NORESTART.
+ */
+static enum hrtimer_restart tx_irq_timer_fn(struct hrtimer *timer)
+{
+	struct edge_info *einfo = container_of(timer, struct edge_info,
+					       tx_irq_timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&einfo->write_lock, flags);
+	if (einfo->tx_irq_pending) {
+		einfo->tx_irq_pending = false;
+		send_irq(einfo);
+	}
+	spin_unlock_irqrestore(&einfo->write_lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
 /**
  * fifo_write() - Write data into an edge
  * @einfo:	The concerned edge to write to.
@@ -585,7 +657,7 @@ static int fifo_write(struct edge_info *einfo, const void *data, int len)
 	 */
 	wmb();
 	einfo->tx_ch_desc->write_index = write_index;
-	send_irq(einfo);
+	tx_irq(einfo, false);
 
 	return orig_len - len;
 }
@@ -599,6 +671,7 @@ static int fifo_write(struct edge_info *einfo, const void *data, int len)
  * @len2:	The length of the second buffer in bytes.
  * @data3:	The thirs buffer of data to write.
  * @len3:	The length of the third buffer in bytes.
+ * @lazy:	The doorbell for this write may be coalesced.
  *
  * A variant of fifo_write() which optimizes the usecase found in tx().  The
  * remote side expects all or none of the transmitted data to be available.
@@ -611,7 +684,7 @@ static int fifo_write(struct edge_info *einfo, const void *data, int len)
 static int fifo_write_complex(struct edge_info *einfo,
 			      const void *data1, int len1,
 			      const void *data2, int len2,
-			      const void *data3, int len3)
+			      const void *data3, int len3, bool lazy)
 {
 	int orig_len = len1 + len2 + len3;
 	uint32_t write_index = einfo->tx_ch_desc->write_index;
@@ -632,7 +705,7 @@ static int fifo_write_complex(struct edge_info *einfo,
 	 */
 	wmb();
 	einfo->tx_ch_desc->write_index = write_index;
-	send_irq(einfo);
+	tx_irq(einfo, lazy);
 
 	return orig_len - len1 - len2 - len3;
 }
@@ -842,7 +915,8 @@ static bool queue_cmd(struct edge_info *einfo, void *cmd, void *data)
 	d_cmd->data = data;
 	list_add_tail(&d_cmd->list_node, &einfo->deferred_cmds);
 	einfo->deferred_cmds_cnt++;
-	kthread_queue_work(&einfo->kworker, &einfo->kwork);
+	if (!einfo->rx_irq_thread)
+		kthread_queue_work(&einfo->kworker, &einfo->kwork);
 	return true;
 }
 
@@ -1286,6 +1360,29 @@ irqreturn_t irq_handler(int irq, void *priv)
 	__rx_worker(einfo, true);
 	einfo->rx_irq_count++;
 
+	if (einfo->rx_irq_thread && !list_empty(&einfo->deferred_cmds))
+		return IRQ_WAKE_THREAD;
+
+	return IRQ_HANDLED;
+}
+
+/**
+ * rx_irq_thread() - threaded half of the rx irq for deferred commands
+ * @irq:	The rx irq line.
+ * @priv:	Edge the irq was received on.
+ *
+ * Used instead of rx_worker() on edges with qcom,rx-irq-thread so that
+ * control commands, e.g. remote intents and tx done, are handled without
+ * a hop through the shared kthread worker.
+ *
+ * Return: IRQ_HANDLED.
+ */
+static irqreturn_t rx_irq_thread(int irq, void *priv)
+{
+	struct edge_info *einfo = (struct edge_info *)priv;
+
+	__rx_worker(einfo, false);
+
 	return IRQ_HANDLED;
 }
 
@@ -1441,6 +1538,14 @@ static int tx_cmd_ch_open(struct glink_transport_if *if_ptr, uint32_t lcid,
 	memcpy(buf, &cmd, sizeof(cmd));
 	memcpy(buf + sizeof(cmd), name, cmd.length);
 
+	if (einfo->tx_coalesce_us && lcid < TX_COALESCE_MAX_LCID) {
+		if (match_string(einfo->tx_no_coalesce,
+				 einfo->num_tx_no_coalesce, name) < 0)
+			set_bit(lcid, einfo->tx_coalesce_lcids);
+		else
+			clear_bit(lcid, einfo->tx_coalesce_lcids);
+	}
+
 	SMEM_IPC_LOG(einfo, __func__, cmd.id, cmd.lcid, cmd.length);
 	fifo_tx(einfo, buf, buf_size);
 
@@ -1480,6 +1585,9 @@ static int tx_cmd_ch_close(struct glink_transport_if *if_ptr, uint32_t lcid)
 	cmd.lcid = lcid;
 	cmd.reserved = 0;
 
+	if (lcid < TX_COALESCE_MAX_LCID)
+		clear_bit(lcid, einfo->tx_coalesce_lcids);
+
 	SMEM_IPC_LOG(einfo, __func__, cmd.id, cmd.lcid, cmd.reserved);
 	fifo_tx(einfo, &cmd, sizeof(cmd));
 
@@ -1604,6 +1712,11 @@ static int ssr(struct glink_transport_if *if_ptr)
 
 	synchronize_srcu(&einfo->use_ref);
 
+	if (einfo->tx_coalesce_us) {
+		hrtimer_cancel(&einfo->tx_irq_timer);
+		einfo->tx_irq_pending = false;
+	}
+
 	while (!list_empty(&einfo->deferred_cmds)) {
 		cmd = list_first_entry(&einfo->deferred_cmds,
 						struct deferred_cmd, list_node);
@@ -2103,7 +2216,9 @@ static int tx_data(struct glink_transport_if *if_ptr, uint16_t cmd_id,
 		tracer_pkt_log_event((void *)(pctx->data), GLINK_XPRT_TX);
 
 	ret = fifo_write_complex(einfo, &cmd, sizeof(cmd), data_start, size,
-							zeros, zeros_size);
+				 zeros, zeros_size,
+				 lcid < TX_COALESCE_MAX_LCID &&
+				 test_bit(lcid, einfo->tx_coalesce_lcids));
 	if (ret < 0) {
 		spin_unlock_irqrestore(&einfo->write_lock, flags);
 		srcu_read_unlock(&einfo->use_ref, rcu_id);
@@ -2564,8 +2679,24 @@ static int glink_smem_native_probe(struct platform_device *pdev)
 		goto reg_xprt_fail;
 	}
 
+	key = "qcom,tx-irq-coalesce-us";
+	of_property_read_u32(node, key, &einfo->tx_coalesce_us);
+	if (einfo->tx_coalesce_us) {
+		hrtimer_init(&einfo->tx_irq_timer, CLOCK_MONOTONIC,
+			     HRTIMER_MODE_REL);
+		einfo->tx_irq_timer.function = tx_irq_timer_fn;
+		key = "qcom,tx-irq-no-coalesce";
+		rc = of_property_read_string_array(node, key,
+					einfo->tx_no_coalesce,
+					TX_COALESCE_MAX_EXCLUDE);
+		einfo->num_tx_no_coalesce = rc > 0 ? rc : 0;
+	}
+
 	einfo->irq_line = irq_line;
-	rc = request_irq(irq_line, irq_handler,
+	einfo->rx_irq_thread = of_property_read_bool(node,
+						"qcom,rx-irq-thread");
+	rc = request_threaded_irq(irq_line, irq_handler,
+			einfo->rx_irq_thread ? rx_irq_thread : NULL,
 			IRQF_TRIGGER_RISING | IRQF_SHARED,
 			node->name, einfo);
 	if (rc < 0) {
@@ -76,6 +76,7 @@ if (ipc_router_glink_xprt_debug_mask) \
  * @disable_pil_loading: Disable PIL Loading of the subsystem.
  * @dynamic_wakeup_source: Dynamic wakeup source for this subsystem.
  * @low_latency_xprt: Flag to indicate low latency transport.
+ * @open_work: Work to load the remote subsystem and open the channel.
  */
 struct ipc_router_glink_xprt {
 	struct list_head list;
@@ -103,6 +104,7 @@ struct ipc_router_glink_xprt {
 
 	struct kthread_worker kworker;
 	struct task_struct *task;
+	struct work_struct open_work;
 };
 
 struct ipc_router_glink_xprt_work {
@@ -161,6 +163,7 @@ static DEFINE_MUTEX(glink_xprt_list_lock_lha1);
 static LIST_HEAD(glink_xprt_list);
 
 static struct workqueue_struct *glink_xprt_wq;
+static struct workqueue_struct *glink_xprt_open_wq;
 
 static void glink_xprt_link_state_cb(struct glink_link_state_cb_info *cb_info,
 				     void *priv);
@@ -638,6 +641,23 @@ static void glink_xprt_ch_open(struct ipc_router_glink_xprt *glink_xprtp)
 	}
 }
 
+/**
+ * glink_xprt_ch_open_worker() - Load the subsystem and open the channel
+ * @work: Pointer to the work item in the ipc_router_glink_xprt.
+ *
+ * Booting a subsystem through PIL blocks for the whole image load and
+ * the error-ready handshake. Run it from an unbound workqueue so that
+ * independent edges coming up at boot are loaded concurrently instead
+ * of one after another on the ordered link state workqueue.
+ */
+static void glink_xprt_ch_open_worker(struct work_struct *work)
+{
+	struct ipc_router_glink_xprt *glink_xprtp =
+		container_of(work, struct ipc_router_glink_xprt, open_work);
+
+	glink_xprt_ch_open(glink_xprtp);
+}
+
 /**
  * glink_xprt_link_state_worker() - Function to handle link state updates
  * @work: Pointer to the work item in the link_state_work_info.
@@ -660,7 +680,8 @@ static void glink_xprt_link_state_worker(struct work_struct *work)
 			if (strcmp(glink_xprtp->edge, xs_info->edge) ||
 			    strcmp(glink_xprtp->transport, xs_info->transport))
 				continue;
-			glink_xprt_ch_open(glink_xprtp);
+			queue_work(glink_xprt_open_wq,
+				   &glink_xprtp->open_work);
 		}
 		mutex_unlock(&glink_xprt_list_lock_lha1);
 	} else if (xs_info->link_state == GLINK_LINK_STATE_DOWN) {
@@ -669,8 +690,10 @@ static void glink_xprt_link_state_worker(struct work_struct *work)
 		mutex_lock(&glink_xprt_list_lock_lha1);
 		list_for_each_entry(glink_xprtp, &glink_xprt_list, list) {
 			if (strcmp(glink_xprtp->edge, xs_info->edge) ||
-			    strcmp(glink_xprtp->transport, xs_info->transport)
-			    || IS_ERR_OR_NULL(glink_xprtp->ch_hndl))
+			    strcmp(glink_xprtp->transport, xs_info->transport))
+				continue;
+			flush_work(&glink_xprtp->open_work);
+			if (IS_ERR_OR_NULL(glink_xprtp->ch_hndl))
 				continue;
 			glink_close(glink_xprtp->ch_hndl);
 			glink_xprtp->ch_hndl = NULL;
@@ -776,6 +799,7 @@ static int ipc_router_glink_config_init(
 
 	init_rwsem(&glink_xprtp->ss_reset_rwlock);
 	glink_xprtp->ss_reset = 0;
+	INIT_WORK(&glink_xprtp->open_work, glink_xprt_ch_open_worker);
 
 	scnprintf(xprt_wq_name, GLINK_NAME_SIZE, "%s_%s_%s",
 			glink_xprtp->ch_name, glink_xprtp->edge,
@@ -947,6 +971,14 @@ static int __init ipc_router_glink_xprt_init(void)
 		return -EFAULT;
 	}
 
+	glink_xprt_open_wq = alloc_workqueue("glink_xprt_open_wq",
+					     WQ_UNBOUND, 0);
+	if (!glink_xprt_open_wq) {
+		pr_err("%s: alloc_workqueue failed\n", __func__);
+		destroy_workqueue(glink_xprt_wq);
+		return -EFAULT;
+	}
+
 	rc = platform_driver_register(&ipc_router_glink_xprt_driver);
 	if (rc) {
 		IPC_RTR_ERR(
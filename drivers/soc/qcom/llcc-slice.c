@@ -289,6 +289,120 @@ int llcc_slice_deactivate(struct llcc_slice_desc *desc)
 }
 EXPORT_SYMBOL(llcc_slice_deactivate);
 
+static const struct llcc_slice_config *llcc_slice_get_cfg(
+		struct llcc_drv_data *drv, int sid)
+{
+	u32 i;
+
+	for (i = 0; i < drv->llcc_config_data_sz; i++)
+		if (drv->slice_data[i].slice_id == sid)
+			return &drv->slice_data[i];
+
+	return NULL;
+}
+
+static u32 llcc_slice_attr1_val(struct llcc_drv_data *drv,
+		const struct llcc_slice_config *cfg, u32 max_cap)
+{
+	u32 attr1_val;
+	u32 max_cap_cacheline;
+
+	attr1_val = cfg->cache_mode;
+	attr1_val |= (cfg->probe_target_ways << ATTR1_PROBE_TARGET_WAYS_SHIFT);
+	attr1_val |= (cfg->fixed_size << ATTR1_FIXED_SIZE_SHIFT);
+	attr1_val |= (cfg->priority << ATTR1_PRIORITY_SHIFT);
+
+	max_cap_cacheline = MAX_CAP_TO_BYTES(max_cap);
+
+	/* LLCC instances can vary for each target.
+	 * The SW writes to broadcast register which gets propagated
+	 * to each llcc instace (llcc0,.. llccN).
+	 * Since the size of the memory is divided equally amongst the
+	 * llcc instances, we need to configure the max cap accordingly.
+	 */
+	max_cap_cacheline = (max_cap_cacheline / drv->no_banks);
+	max_cap_cacheline >>= CACHE_LINE_SIZE_SHIFT;
+	attr1_val |= (max_cap_cacheline << ATTR1_MAX_CAP_SHIFT);
+
+	return attr1_val;
+}
+
+/**
+ * llcc_slice_resize - Change the capacity of the llcc slice
+ * @desc: Pointer to llcc slice descriptor
+ * @size: New capacity in KB, bounded by the max_cap of the slice config
+ *
+ * Lets a client shrink its slice while its workload does not benefit
+ * from it, leaving the capacity to other slices, and grow it back later.
+ * An active slice is deactivated around the update since the SCT must
+ * not change under an active slice. Clients that hand the slice size to
+ * firmware must resize before doing so.
+ *
+ * A value zero will be returned on success and a negative errno will
+ * be returned in error cases
+ */
+int llcc_slice_resize(struct llcc_slice_desc *desc, size_t size)
+{
+	const struct llcc_slice_config *cfg;
+	struct llcc_drv_data *drv;
+	u32 act_ctrl_val;
+	bool active;
+	int rc = 0;
+
+	if (desc == NULL || !size) {
+		pr_err("Input descriptor supplied is invalid
+");
+		return -EINVAL;
+	}
+
+	drv = dev_get_drvdata(desc->dev);
+	if (!drv) {
+		pr_err("Invalid device pointer in the desc
+");
+		return -EINVAL;
+	}
+
+	cfg = llcc_slice_get_cfg(drv, desc->llcc_slice_id);
+	if (!cfg || size > cfg->max_cap)
+		return -EINVAL;
+
+	mutex_lock(&drv->slice_mutex);
+	if (desc->llcc_slice_size == size)
+		goto out;
+
+	active = test_bit(desc->llcc_slice_id, drv->llcc_slice_map);
+	if (active) {
+		act_ctrl_val = ACT_CTRL_OPCODE_DEACTIVATE <<
+						ACT_CTRL_OPCODE_SHIFT;
+		act_ctrl_val |= ACT_CTRL_ACT_TRIG;
+		rc = llcc_update_act_ctrl(drv, desc->llcc_slice_id,
+					  act_ctrl_val, ACTIVATE);
+		if (rc)
+			goto out;
+	}
+
+	regmap_write(drv->llcc_map,
+		     drv->b_off + LLCC_TRP_ATTR1_CFGn(desc->llcc_slice_id),
+		     llcc_slice_attr1_val(drv, cfg, size));
+	desc->llcc_slice_size = size;
+
+	/* Make sure that the SCT is programmed before activating */
+	mb();
+
+	if (active) {
+		act_ctrl_val = ACT_CTRL_OPCODE_ACTIVATE <<
+						ACT_CTRL_OPCODE_SHIFT;
+		act_ctrl_val |= ACT_CTRL_ACT_TRIG;
+		rc = llcc_update_act_ctrl(drv, desc->llcc_slice_id,
+					  act_ctrl_val, DEACTIVATE);
+	}
+out:
+	mutex_unlock(&drv->slice_mutex);
+
+	return rc;
+}
+EXPORT_SYMBOL(llcc_slice_resize);
+
 /**
  * llcc_get_slice_id - return the slice id
  * @desc: Pointer to llcc slice descriptor
@@ -328,7 +442,6 @@ static void qcom_llcc_cfg_program(struct platform_device *pdev)
 	u32 attr0_cfg;
 	u32 attr1_val;
 	u32 attr0_val;
-	u32 max_cap_cacheline;
 	u32 sz;
 	const struct llcc_slice_config *llcc_table;
 	struct llcc_drv_data *drv = platform_get_drvdata(pdev);
@@ -342,24 +455,8 @@ static void qcom_llcc_cfg_program(struct platform_device *pdev)
 		attr1_cfg = b_off + LLCC_TRP_ATTR1_CFGn(llcc_table[i].slice_id);
 		attr0_cfg = b_off + LLCC_TRP_ATTR0_CFGn(llcc_table[i].slice_id);
 
-		attr1_val = llcc_table[i].cache_mode;
-		attr1_val |= (llcc_table[i].probe_target_ways <<
-				ATTR1_PROBE_TARGET_WAYS_SHIFT);
-		attr1_val |= (llcc_table[i].fixed_size <<
-				ATTR1_FIXED_SIZE_SHIFT);
-		attr1_val |= (llcc_table[i].priority << ATTR1_PRIORITY_SHIFT);
-
-		max_cap_cacheline = MAX_CAP_TO_BYTES(llcc_table[i].max_cap);
-
-		/* LLCC instances can vary for each target.
-		 * The SW writes to broadcast register which gets propagated
-		 * to each llcc instace (llcc0,.. llccN).
-		 * Since the size of the memory is divided equally amongst the
-		 * llcc instances, we need to configure the max cap accordingly.
-		 */
-		max_cap_cacheline = (max_cap_cacheline / drv->no_banks);
-		max_cap_cacheline >>= CACHE_LINE_SIZE_SHIFT;
-		attr1_val |= (max_cap_cacheline << ATTR1_MAX_CAP_SHIFT);
+		attr1_val = llcc_slice_attr1_val(drv, &llcc_table[i],
+						 llcc_table[i].max_cap);
 
 		attr0_val = llcc_table[i].res_ways & ATTR0_RES_WAYS_MASK;
 		attr0_val |= llcc_table[i].bonus_ways << ATR0_BONUS_WAYS_SHIFT;
@@ -510,7 +510,11 @@ static void bcm_update_acv_req(struct msm_bus_node_device_type *cur_rsc,
 	*vec_b = *acv;
 }
 
-static void bcm_update_bus_req(struct device *dev, int ctx)
+/*
+ * Returns true if the vote vector of any BCM backing the node changed and
+ * the node needs to go on the commit list.
+ */
+static bool bcm_update_bus_req(struct device *dev, int ctx)
 {
 	struct msm_bus_node_device_type *cur_dev = NULL;
 	struct msm_bus_node_device_type *bcm_dev = NULL;
@@ -519,6 +523,8 @@ static void bcm_update_bus_req(struct device *dev, int ctx)
 	int i, j;
 	uint64_t max_ib = 0;
 	uint64_t max_ab = 0;
+	uint64_t vec_a, vec_b;
+	bool changed = false;
 	int lnode_idx = 0;
 
 	cur_dev = to_msm_bus_node(dev);
@@ -569,6 +575,9 @@ static void bcm_update_bus_req(struct device *dev, int ctx)
 		max_ab = msm_bus_div64(max_ab, bcm_dev->bcmdev->unit_size);
 		max_ib = msm_bus_div64(max_ib, bcm_dev->bcmdev->unit_size);
 
+		vec_a = bcm_dev->node_vec[ctx].vec_a;
+		vec_b = bcm_dev->node_vec[ctx].vec_b;
+
 		if (bcm_dev->node_info->id == MSM_BUS_BCM_ACV) {
 			cur_rsc = to_msm_bus_node(bcm_dev->node_info->
 						rsc_devs[0]);
@@ -581,9 +590,13 @@ static void bcm_update_bus_req(struct device *dev, int ctx)
 			bcm_dev->node_vec[ctx].vec_a = max_ab;
 			bcm_dev->node_vec[ctx].vec_b = max_ib;
 		}
+
+		if (bcm_dev->node_vec[ctx].vec_a != vec_a ||
+				bcm_dev->node_vec[ctx].vec_b != vec_b)
+			changed = true;
 	}
 exit_bcm_update_bus_req:
-	return;
+	return changed;
 }
 
 static void bcm_query_bus_req(struct device *dev, int ctx)
@@ -760,6 +773,31 @@ static void aggregate_bus_req(struct msm_bus_node_device_type *bus_dev,
 	return;
 }
 
+/*
+ * Fold a change in one link node's vote into the node totals without
+ * walking every link node. The max only needs a rescan when the link node
+ * holding it lowers its vote. Returns true if the totals changed.
+ */
+static bool aggregate_lnode_req(struct msm_bus_node_device_type *bus_dev,
+			int ctx, uint64_t old_ib, uint64_t old_ab,
+			uint64_t new_ib, uint64_t new_ab)
+{
+	struct nodebw *bw = &bus_dev->node_bw[ctx];
+	uint64_t sum_ab = bw->sum_ab;
+	uint64_t max_ib = bw->max_ib;
+
+	if (old_ib == new_ib && old_ab == new_ab)
+		return false;
+
+	bw->sum_ab = bw->sum_ab - old_ab + new_ab;
+	if (new_ib >= bw->max_ib)
+		bw->max_ib = new_ib;
+	else if (old_ib == bw->max_ib)
+		aggregate_bus_req(bus_dev, ctx);
+
+	return bw->sum_ab != sum_ab || bw->max_ib != max_ib;
+}
+
 static void aggregate_bus_query_req(struct msm_bus_node_device_type *bus_dev,
 									int ctx)
 {
@@ -787,6 +825,10 @@ static void aggregate_bus_query_req(struct msm_bus_node_device_type *bus_dev,
 
 static void commit_data(void)
 {
+	/* Nothing to send if no BCM vote moved */
+	if (list_empty(&commit_list))
+		return;
+
 	msm_bus_commit_data(&commit_list);
 	INIT_LIST_HEAD(&commit_list);
 }
@@ -863,6 +905,8 @@ static int update_path(struct device *src_dev, int dest, uint64_t act_req_ib,
 	curr_idx = src_idx;
 
 	while (next_dev) {
+		uint64_t old_ib[NUM_CTX], old_ab[NUM_CTX];
+		bool changed = false;
 		int i;
 
 		dev_info = to_msm_bus_node(next_dev);
@@ -881,17 +925,32 @@ static int update_path(struct device *src_dev, int dest, uint64_t act_req_ib,
 			ret = -ENXIO;
 			goto exit_update_path;
 		}
+		for (i = 0; i < NUM_CTX; i++) {
+			old_ib[i] = lnode->lnode_ib[i];
+			old_ab[i] = lnode->lnode_ab[i];
+		}
 		lnode->lnode_ib[ACTIVE_CTX] = act_req_ib;
 		lnode->lnode_ab[ACTIVE_CTX] = act_req_bw;
 		lnode->lnode_ib[DUAL_CTX] = slp_req_ib;
 		lnode->lnode_ab[DUAL_CTX] = slp_req_bw;
 
-		for (i = 0; i < NUM_CTX; i++) {
-			aggregate_bus_req(dev_info, i);
-			bcm_update_bus_req(next_dev, i);
+		for (i = 0; i < NUM_CTX; i++)
+			changed |= aggregate_lnode_req(dev_info, i,
+					old_ib[i], old_ab[i],
+					lnode->lnode_ib[i], lnode->lnode_ab[i]);
+
+		/*
+		 * Only nodes whose BCM votes actually moved need to be
+		 * regenerated and committed.
+		 */
+		if (changed) {
+			changed = false;
+			for (i = 0; i < NUM_CTX; i++)
+				changed |= bcm_update_bus_req(next_dev, i);
 		}
 
-		add_node_to_clist(dev_info);
+		if (changed)
+			add_node_to_clist(dev_info);
 
 		next_dev = lnode->next_dev;
 		curr_idx = lnode->next;
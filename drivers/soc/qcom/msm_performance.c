@@ -44,19 +44,20 @@ static struct task_struct *events_notify_thread;
 
 /**************************sysfs start********************************/
 /*
- * Userspace sends cpu#:min_freq_value to vote for min_freq_value as the new
- * scaling_min. To withdraw its vote it needs to enter cpu#:0
+ * Parse a "cpu#:value cpu#:value ..." string into the min or max votes and
+ * reapply the policies whose vote changed, once per policy. The perf HAL
+ * rewrites the whole string many times per second during app launches,
+ * mostly with the values already in place, which then costs nothing.
  */
-static int set_cpu_min_freq(const char *buf, const struct kernel_param *kp)
+static int set_cpu_freq_limits(const char *buf, bool is_min)
 {
-#if 0
 	int i, j, ntokens = 0;
 	unsigned int val, cpu;
 	const char *cp = buf;
 	struct cpu_status *i_cpu_stats;
 	struct cpufreq_policy policy;
-	cpumask_var_t limit_mask;
-	int ret;
+	struct cpumask limit_mask;
+	unsigned int *limit;
 
 	while ((cp = strpbrk(cp + 1, " :")))
 		ntokens++;
@@ -66,7 +67,7 @@ static int set_cpu_min_freq(const char *buf, const struct kernel_param *kp)
 		return -EINVAL;
 
 	cp = buf;
-	cpumask_clear(limit_mask);
+	cpumask_clear(&limit_mask);
 	for (i = 0; i < ntokens; i += 2) {
 		if (sscanf(cp, "%u:%u", &cpu, &val) != 2)
 			return -EINVAL;
@@ -74,9 +75,11 @@ static int set_cpu_min_freq(const char *buf, const struct kernel_param *kp)
 			return -EINVAL;
 
 		i_cpu_stats = &per_cpu(cpu_stats, cpu);
-
-		i_cpu_stats->min = val;
-		cpumask_set_cpu(cpu, limit_mask);
+		limit = is_min ? &i_cpu_stats->min : &i_cpu_stats->max;
+		if (*limit != val) {
+			*limit = val;
+			cpumask_set_cpu(cpu, &limit_mask);
+		}
 
 		cp = strnchr(cp, strlen(cp), ' ');
 		cp++;
@@ -90,26 +93,35 @@ static int set_cpu_min_freq(const char *buf, const struct kernel_param *kp)
 	 * in the cluster
 	 */
 	get_online_cpus();
-	for_each_cpu(i, limit_mask) {
+	for_each_cpu(i, &limit_mask) {
 		i_cpu_stats = &per_cpu(cpu_stats, i);
 
 		if (cpufreq_get_policy(&policy, i))
 			continue;
 
-		if (cpu_online(i) && (policy.min != i_cpu_stats->min)) {
-			ret = cpufreq_update_policy(i);
-			if (ret)
+		limit = is_min ? &policy.min : &policy.max;
+		if (cpu_online(i) && *limit != (is_min ? i_cpu_stats->min :
+						 i_cpu_stats->max)) {
+			if (cpufreq_update_policy(i))
 				continue;
 		}
 		for_each_cpu(j, policy.related_cpus)
-			cpumask_clear_cpu(j, limit_mask);
+			cpumask_clear_cpu(j, &limit_mask);
 	}
 	put_online_cpus();
-#endif
 
 	return 0;
 }
 
+/*
+ * Userspace sends cpu#:min_freq_value to vote for min_freq_value as the new
+ * scaling_min. To withdraw its vote it needs to enter cpu#:0
+ */
+static int set_cpu_min_freq(const char *buf, const struct kernel_param *kp)
+{
+	return set_cpu_freq_limits(buf, true);
+}
+
 static int get_cpu_min_freq(char *buf, const struct kernel_param *kp)
 {
 	int cnt = 0, cpu;
@@ -134,57 +146,7 @@ module_param_cb(cpu_min_freq, &param_ops_cpu_min_freq, NULL, 0644);
  */
 static int set_cpu_max_freq(const char *buf, const struct kernel_param *kp)
 {
-#if 0
-	int i, j, ntokens = 0;
-	unsigned int val, cpu;
-	const char *cp = buf;
-	struct cpu_status *i_cpu_stats;
-	struct cpufreq_policy policy;
-	cpumask_var_t limit_mask;
-	int ret;
-
-	while ((cp = strpbrk(cp + 1, " :")))
-		ntokens++;
-
-	/* CPU:value pair */
-	if (!(ntokens % 2))
-		return -EINVAL;
-
-	cp = buf;
-	cpumask_clear(limit_mask);
-	for (i = 0; i < ntokens; i += 2) {
-		if (sscanf(cp, "%u:%u", &cpu, &val) != 2)
-			return -EINVAL;
-		if (cpu > (num_present_cpus() - 1))
-			return -EINVAL;
-
-		i_cpu_stats = &per_cpu(cpu_stats, cpu);
-
-		i_cpu_stats->max = val;
-		cpumask_set_cpu(cpu, limit_mask);
-
-		cp = strnchr(cp, strlen(cp), ' ');
-		cp++;
-	}
-
-	get_online_cpus();
-	for_each_cpu(i, limit_mask) {
-		i_cpu_stats = &per_cpu(cpu_stats, i);
-		if (cpufreq_get_policy(&policy, i))
-			continue;
-
-		if (cpu_online(i) && (policy.max != i_cpu_stats->max)) {
-			ret = cpufreq_update_policy(i);
-			if (ret)
-				continue;
-		}
-		for_each_cpu(j, policy.related_cpus)
-			cpumask_clear_cpu(j, limit_mask);
-	}
-	put_online_cpus();
-#endif
-
-	return 0;
+	return set_cpu_freq_limits(buf, false);
 }
 
 static int get_cpu_max_freq(char *buf, const struct kernel_param *kp)
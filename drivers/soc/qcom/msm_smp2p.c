@@ -1389,6 +1389,61 @@ int msm_smp2p_out_modify(struct msm_smp2p_out *handle, uint32_t set_mask,
 }
 EXPORT_SYMBOL(msm_smp2p_out_modify);
 
+/**
+ * msm_smp2p_out_modify_batch - Modifies several entries with one interrupt.
+ *
+ * @handles: Array of handles to the smem entry structures.
+ * @set_masks: Bits to set, one mask per handle.
+ * @clear_masks: Bits to clear, one mask per handle.
+ * @num: Number of entries in the arrays.
+ * @returns: 0 on success, standard Linux error code otherwise.
+ *
+ * Applies each modification as msm_smp2p_out_modify() does, all under one
+ * hold of the edge lock, and then raises a single interrupt so the remote
+ * processor sees the whole update in one wakeup. All handles must belong to
+ * the same remote processor. On failure the entries modified before the
+ * failing one keep their new value and are still signalled.
+ */
+int msm_smp2p_out_modify_batch(struct msm_smp2p_out **handles,
+		uint32_t *set_masks, uint32_t *clear_masks, int num)
+{
+	int ret = 0;
+	int i;
+	int remote_pid;
+	unsigned long flags;
+	struct smp2p_out_list_item *out_item;
+
+	if (!handles || !set_masks || !clear_masks || num <= 0 || !handles[0])
+		return -EINVAL;
+
+	remote_pid = handles[0]->remote_pid;
+	for (i = 1; i < num; i++)
+		if (!handles[i] || handles[i]->remote_pid != remote_pid)
+			return -EINVAL;
+
+	if ((remote_pid != SMP2P_REMOTE_MOCK_PROC) &&
+			!smp2p_int_cfgs[remote_pid].is_configured) {
+		SMP2P_INFO("%s before msm_smp2p_init(): pid[%d] name[%s]\n",
+			__func__, remote_pid, handles[0]->name);
+		return -EPROBE_DEFER;
+	}
+
+	out_item = &out_list[remote_pid];
+	spin_lock_irqsave(&out_item->out_item_lock_lha1, flags);
+	for (i = 0; i < num; i++) {
+		ret = out_item->ops_ptr->modify_entry(handles[i], set_masks[i],
+						clear_masks[i], false);
+		if (ret)
+			break;
+	}
+	if (i)
+		smp2p_send_interrupt(remote_pid);
+	spin_unlock_irqrestore(&out_item->out_item_lock_lha1, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL(msm_smp2p_out_modify_batch);
+
 /**
  * msm_smp2p_in_read - Read an entry on a remote processor.
  *
@@ -32,6 +32,7 @@
 #include <linux/of_address.h>
 #include <linux/io.h>
 #include <linux/dma-mapping.h>
+#include <linux/vmalloc.h>
 #include <soc/qcom/ramdump.h>
 #include <soc/qcom/subsystem_restart.h>
 #include <soc/qcom/secure_buffer.h>
@@ -93,6 +94,7 @@ struct pil_mdt {
  * @filesz: size of segment on disk
  * @num: segment number
  * @relocated: true if segment is relocated, false otherwise
+ * @readonly: true if the segment is not writable by the peripheral
  *
  * Loosely based on an elf program header. Contains all necessary information
  * to load and initialize a segment of the image in memory.
@@ -104,6 +106,7 @@ struct pil_seg {
 	int num;
 	struct list_head list;
 	bool relocated;
+	bool readonly;
 };
 
 /**
@@ -121,6 +124,10 @@ struct pil_seg {
  * non-relocatable images
  * @region: region allocated for relocatable images
  * @unvoted_flag: flag to keep track if we have unvoted or not.
+ * @cache_mdt: copy of the metadata the cached blobs were loaded with
+ * @cache_mdt_size: size of @cache_mdt
+ * @seg_cache: cached blob contents indexed by program header number
+ * @seg_cache_cnt: number of entries in @seg_cache
  *
  * This struct contains data for a pil_desc that should not be exposed outside
  * of this file. This structure points to the descriptor and the descriptor
@@ -143,6 +150,10 @@ struct pil_priv {
 	int id;
 	int unvoted_flag;
 	size_t region_size;
+	void *cache_mdt;
+	size_t cache_mdt_size;
+	void **seg_cache;
+	int seg_cache_cnt;
 };
 
 static int pil_do_minidump(struct pil_desc *desc, void *ramdump_dev)
@@ -534,6 +545,7 @@ static struct pil_seg *pil_init_seg(const struct pil_desc *desc,
 	seg->filesz = phdr->p_filesz;
 	seg->sz = phdr->p_memsz;
 	seg->relocated = reloc;
+	seg->readonly = !(phdr->p_flags & PF_W);
 	INIT_LIST_HEAD(&seg->list);
 
 	return seg;
@@ -818,6 +830,77 @@ static void unmap_fw_mem(void *vaddr, size_t size, void *data)
 	dma_unremap(info->dev, vaddr, size);
 }
 
+static void pil_free_seg_cache(struct pil_priv *priv)
+{
+	int i;
+
+	for (i = 0; i < priv->seg_cache_cnt; i++)
+		vfree(priv->seg_cache[i]);
+	kfree(priv->seg_cache);
+	priv->seg_cache = NULL;
+	priv->seg_cache_cnt = 0;
+	kfree(priv->cache_mdt);
+	priv->cache_mdt = NULL;
+	priv->cache_mdt_size = 0;
+}
+
+/*
+ * The metadata carries the hash of every blob, so blobs cached from a
+ * previous load stay valid for as long as the metadata is unchanged.
+ * The image is still authenticated by the secure world on every boot.
+ */
+static void pil_init_seg_cache(struct pil_desc *desc,
+			       const struct pil_mdt *mdt, size_t mdt_size)
+{
+	struct pil_priv *priv = desc->priv;
+
+	if (!desc->cache_segs)
+		return;
+
+	if (priv->cache_mdt && priv->cache_mdt_size == mdt_size &&
+			!memcmp(priv->cache_mdt, mdt, mdt_size))
+		return;
+
+	pil_free_seg_cache(priv);
+
+	priv->cache_mdt = kmemdup(mdt, mdt_size, GFP_KERNEL);
+	if (!priv->cache_mdt)
+		return;
+
+	priv->seg_cache = kcalloc(mdt->hdr.e_phnum, sizeof(*priv->seg_cache),
+				  GFP_KERNEL);
+	if (!priv->seg_cache) {
+		pil_free_seg_cache(priv);
+		return;
+	}
+	priv->cache_mdt_size = mdt_size;
+	priv->seg_cache_cnt = mdt->hdr.e_phnum;
+}
+
+static void *pil_get_cached_seg(struct pil_priv *priv, struct pil_seg *seg)
+{
+	if (seg->num >= priv->seg_cache_cnt)
+		return NULL;
+
+	return priv->seg_cache[seg->num];
+}
+
+static void pil_cache_seg(struct pil_priv *priv, struct pil_seg *seg,
+			  const void __iomem *buf)
+{
+	void *cache;
+
+	if (!seg->readonly || seg->num >= priv->seg_cache_cnt)
+		return;
+
+	cache = vmalloc(seg->filesz);
+	if (!cache)
+		return;
+
+	memcpy_fromio(cache, buf, seg->filesz);
+	priv->seg_cache[seg->num] = cache;
+}
+
 static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 {
 	int ret = 0, count;
@@ -833,8 +916,19 @@ static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 		.dev = desc->dev,
 	};
 	void *map_data = desc->map_data ? desc->map_data : &map_fw_info;
+	void *cache = pil_get_cached_seg(desc->priv, seg);
+
+	if (seg->filesz && cache) {
+		firmware_buf = desc->map_fw_mem(seg->paddr, seg->filesz,
+						map_data);
+		if (!firmware_buf) {
+			pil_err(desc, "Failed to map memory for firmware buffer\n");
+			return -ENOMEM;
+		}
 
-	if (seg->filesz) {
+		memcpy_toio(firmware_buf, cache, seg->filesz);
+		desc->unmap_fw_mem(firmware_buf, seg->filesz, map_data);
+	} else if (seg->filesz) {
 		snprintf(fw_name, ARRAY_SIZE(fw_name), "%s.b%02d",
 				desc->fw_name, num);
 		firmware_buf = desc->map_fw_mem(seg->paddr, seg->filesz,
@@ -846,6 +940,8 @@ static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 
 		ret = request_firmware_into_buf(&fw, fw_name, desc->dev,
 						firmware_buf, seg->filesz);
+		if (!ret && fw->size == seg->filesz)
+			pil_cache_seg(desc->priv, seg, firmware_buf);
 		desc->unmap_fw_mem(firmware_buf, seg->filesz, map_data);
 
 		if (ret) {
@@ -933,6 +1029,8 @@ static int pil_parse_devicetree(struct pil_desc *desc)
 
 	desc->sequential_load = of_property_read_bool(ofnode,
 						"qcom,sequential-fw-load");
+	desc->cache_segs = of_property_read_bool(ofnode,
+						"qcom,pil-cache-segments");
 	return 0;
 }
 
@@ -1108,6 +1206,8 @@ int pil_boot(struct pil_desc *desc)
 	if (ret)
 		goto release_fw;
 
+	pil_init_seg_cache(desc, mdt, fw->size);
+
 	desc->priv->unvoted_flag = 0;
 	ret = pil_proxy_vote(desc);
 	if (ret) {
@@ -1230,6 +1330,7 @@ int pil_boot(struct pil_desc *desc)
 			priv->region = NULL;
 		}
 		pil_release_mmap(desc);
+		pil_free_seg_cache(priv);
 		pil_notify_aop(desc, "off");
 	}
 	return ret;
@@ -1407,6 +1508,7 @@ void pil_desc_release(struct pil_desc *desc)
 		ida_simple_remove(&pil_ida, priv->id);
 		flush_delayed_work(&priv->proxy);
 		wakeup_source_trash(&priv->ws);
+		pil_free_seg_cache(priv);
 	}
 	desc->priv = NULL;
 	kfree(priv);
@@ -13,6 +13,7 @@
 
 #include <linux/atomic.h>
 #include <linux/delay.h>
+#include <linux/hashtable.h>
 #include <linux/interrupt.h>
 #include <linux/kernel.h>
 #include <linux/list.h>
@@ -33,6 +34,7 @@
 #define RPMH_MAX_FAST_RES		32
 #define RPMH_MAX_REQ_IN_BATCH		10
 #define RPMH_TIMEOUT			msecs_to_jiffies(10000)
+#define RPMH_REQ_HASH_BITS		6
 
 #define DEFINE_RPMH_MSG_ONSTACK(rc, s, q, c, name)	\
 	struct rpmh_msg name = {			\
@@ -52,11 +54,27 @@
 		.bit = -1,				\
 	}
 
+/**
+ * struct rpmh_req: cached votes for a single resource address
+ *
+ * @addr: resource address
+ * @sleep_val: vote applied when the subsystem goes to sleep
+ * @wake_val: vote applied when the subsystem wakes up
+ * @active_val: last active vote acknowledged by the controller
+ * @sent_val: last active vote handed to the controller
+ * @inflight: number of active votes for @addr pending a tx_done
+ * @list: node in the resources list, walked in order by rpmh_flush()
+ * @hnode: node in the resources hash, keyed by @addr
+ */
 struct rpmh_req {
 	u32 addr;
 	u32 sleep_val;
 	u32 wake_val;
+	u32 active_val;
+	u32 sent_val;
+	u32 inflight;
 	struct list_head list;
+	struct hlist_node hnode;
 };
 
 struct rpmh_msg {
@@ -67,11 +85,13 @@ struct rpmh_msg {
 	struct rpmh_client *rc;
 	int bit;
 	int err; /* relay error from mbox for sync calls */
+	bool tracked; /* counted in rpmh_req::inflight */
 };
 
 struct rpmh_mbox {
 	struct device_node *mbox_dn;
 	struct list_head resources;
+	DECLARE_HASHTABLE(req_hash, RPMH_REQ_HASH_BITS);
 	spinlock_t lock;
 	struct rpmh_msg *msg_pool;
 	DECLARE_BITMAP(fast_req, RPMH_MAX_FAST_RES);
@@ -133,6 +153,66 @@ static void free_msg_to_pool(struct rpmh_msg *rpm_msg)
 	spin_unlock_irqrestore(&rpm->lock, flags);
 }
 
+static struct rpmh_req *__find_req(struct rpmh_client *rc, u32 addr)
+{
+	struct rpmh_req *p;
+
+	hash_for_each_possible(rc->rpmh->req_hash, p, hnode, addr)
+		if (p->addr == addr)
+			return p;
+
+	return NULL;
+}
+
+/*
+ * An active vote is redundant if the controller has already acked the same
+ * value for the address, nothing is in flight for it and waking up from
+ * sleep will not leave the resource at a different value.
+ */
+static bool __is_active_redundant(struct rpmh_req *req, u32 data)
+{
+	if (req->inflight || req->active_val != data)
+		return false;
+
+	if (req->wake_val == UINT_MAX)
+		return req->sleep_val == UINT_MAX;
+
+	return req->wake_val == data;
+}
+
+static void __track_active(struct rpmh_client *rc, struct rpmh_msg *rpm_msg)
+{
+	struct rpmh_req *req;
+	int i;
+
+	for (i = 0; i < rpm_msg->msg.num_payload; i++) {
+		req = __find_req(rc, rpm_msg->msg.payload[i].addr);
+		if (!req)
+			continue;
+		req->sent_val = rpm_msg->msg.payload[i].data;
+		req->inflight++;
+	}
+	rpm_msg->tracked = true;
+}
+
+static void __untrack_active(struct rpmh_client *rc, struct rpmh_msg *rpm_msg,
+				int r)
+{
+	struct rpmh_req *req;
+	int i;
+
+	for (i = 0; i < rpm_msg->msg.num_payload; i++) {
+		req = __find_req(rc, rpm_msg->msg.payload[i].addr);
+		if (!req || !req->inflight)
+			continue;
+		if (r)
+			req->sent_val = UINT_MAX;
+		if (!--req->inflight)
+			req->active_val = req->sent_val;
+	}
+	rpm_msg->tracked = false;
+}
+
 static void rpmh_rx_cb(struct mbox_client *cl, void *msg)
 {
 	struct rpmh_msg *rpm_msg = container_of(msg, struct rpmh_msg, msg);
@@ -143,8 +223,10 @@ static void rpmh_rx_cb(struct mbox_client *cl, void *msg)
 static void rpmh_tx_done(struct mbox_client *cl, void *msg, int r)
 {
 	struct rpmh_msg *rpm_msg = container_of(msg, struct rpmh_msg, msg);
+	struct rpmh_mbox *rpm = rpm_msg->rc->rpmh;
 	atomic_t *wc = rpm_msg->wait_count;
 	struct completion *compl = rpm_msg->completion;
+	unsigned long flags;
 
 	rpm_msg->err = r;
 
@@ -168,7 +250,11 @@ static void rpmh_tx_done(struct mbox_client *cl, void *msg, int r)
 	 * into an issue that the stack allocated parent object may be
 	 * invalid before we can check the ->bit value.
 	 */
-	free_msg_to_pool(rpm_msg);
+	spin_lock_irqsave(&rpm->lock, flags);
+	if (rpm_msg->tracked)
+		__untrack_active(rpm_msg->rc, rpm_msg, r);
+	__free_msg_to_pool(rpm_msg);
+	spin_unlock_irqrestore(&rpm->lock, flags);
 
 	/* Signal the blocking thread we are done */
 	if (wc && atomic_dec_and_test(wc))
@@ -217,20 +303,6 @@ static inline void wait_for_tx_done(struct rpmh_client *rc,
 	} while (true);
 }
 
-static struct rpmh_req *__find_req(struct rpmh_client *rc, u32 addr)
-{
-	struct rpmh_req *p, *req = NULL;
-
-	list_for_each_entry(p, &rc->rpmh->resources, list) {
-		if (p->addr == addr) {
-			req = p;
-			break;
-		}
-	}
-
-	return req;
-}
-
 static struct rpmh_req *cache_rpm_request(struct rpmh_client *rc,
 			enum rpmh_state state, struct tcs_cmd *cmd)
 {
@@ -251,8 +323,10 @@ static struct rpmh_req *cache_rpm_request(struct rpmh_client *rc,
 
 	req->addr = cmd->addr;
 	req->sleep_val = req->wake_val = UINT_MAX;
+	req->active_val = req->sent_val = UINT_MAX;
 	INIT_LIST_HEAD(&req->list);
 	list_add_tail(&req->list, &rpm->resources);
+	hash_add(rpm->req_hash, &req->hnode, req->addr);
 
 existing:
 	switch (state) {
@@ -310,11 +384,16 @@ static int check_ctrlr_state(struct rpmh_client *rc, enum rpmh_state state)
  * Cache the RPMH request and send if the state is ACTIVE_ONLY.
  * SLEEP/WAKE_ONLY requests are not sent to the controller at
  * this time. Use rpmh_flush() to send them to the controller.
+ * Active requests that would not change any resource are completed
+ * without going to the controller.
  */
 int __rpmh_write(struct rpmh_client *rc, enum rpmh_state state,
 			struct rpmh_msg *rpm_msg)
 {
+	struct rpmh_mbox *rpm = rc->rpmh;
 	struct rpmh_req *req;
+	unsigned long flags;
+	bool redundant = true;
 	int ret = 0;
 	int i;
 
@@ -329,9 +408,29 @@ int __rpmh_write(struct rpmh_client *rc, enum rpmh_state state,
 
 	/* Send to mailbox only if active or awake */
 	if (state == RPMH_ACTIVE_ONLY_STATE || state == RPMH_AWAKE_STATE) {
+		spin_lock_irqsave(&rpm->lock, flags);
+		for (i = 0; redundant && i < rpm_msg->msg.num_payload; i++) {
+			req = __find_req(rc, rpm_msg->msg.payload[i].addr);
+			redundant = req && __is_active_redundant(req,
+					rpm_msg->msg.payload[i].data);
+		}
+		if (!redundant)
+			__track_active(rc, rpm_msg);
+		spin_unlock_irqrestore(&rpm->lock, flags);
+
+		if (redundant) {
+			rpmh_tx_done(&rc->client, &rpm_msg->msg, 0);
+			return 0;
+		}
+
 		ret = mbox_send_message(rc->chan, &rpm_msg->msg);
 		if (ret > 0)
 			ret = 0;
+		if (ret < 0) {
+			spin_lock_irqsave(&rpm->lock, flags);
+			__untrack_active(rc, rpm_msg, ret);
+			spin_unlock_irqrestore(&rpm->lock, flags);
+		}
 	} else {
 		/* Clean up our call by spoofing tx_done */
 		rpmh_tx_done(&rc->client, &rpm_msg->msg, ret);
@@ -620,6 +719,8 @@ int rpmh_write_batch(struct rpmh_client *rc, enum rpmh_state state,
 	struct rpmh_msg *rpm_msg[RPMH_MAX_REQ_IN_BATCH] = { NULL };
 	DECLARE_COMPLETION_ONSTACK(compl);
 	atomic_t wait_count = ATOMIC_INIT(0); /* overwritten */
+	struct rpmh_mbox *rpm;
+	unsigned long flags;
 	int count = 0;
 	int ret, i, j, k;
 	bool complete_set;
@@ -635,6 +736,7 @@ int rpmh_write_batch(struct rpmh_client *rc, enum rpmh_state state,
 	if (ret)
 		return ret;
 
+	rpm = rc->rpmh;
 	while (n[count++] > 0)
 		;
 	count--;
@@ -681,7 +783,13 @@ int rpmh_write_batch(struct rpmh_client *rc, enum rpmh_state state,
 		for (i = 0; i < count; i++) {
 			rpm_msg[i]->completion = &compl;
 			rpm_msg[i]->wait_count = &wait_count;
-			/* Bypass caching and write to mailbox directly */
+			/*
+			 * Bypass caching and write to mailbox directly, but
+			 * keep the active state of cached addresses in sync.
+			 */
+			spin_lock_irqsave(&rpm->lock, flags);
+			__track_active(rc, rpm_msg[i]);
+			spin_unlock_irqrestore(&rpm->lock, flags);
 			ret = mbox_send_message(rc->chan, &rpm_msg[i]->msg);
 			if (ret < 0) {
 				pr_err("Error(%d) sending RPM message addr=0x%x\n",
@@ -895,6 +1003,36 @@ int send_single(struct rpmh_client *rc, enum rpmh_state state, u32 addr,
 	return mbox_write_controller_data(rc->chan, &rpm_msg.msg);
 }
 
+/*
+ * Write a set of sleep or wake commands as one message. If the TCS has no
+ * contiguous room for the whole set, fall back to writing them one by one.
+ */
+static int send_set(struct rpmh_client *rc, enum rpmh_state state,
+				struct tcs_cmd *cmd, int n)
+{
+	DEFINE_RPMH_MSG_ONSTACK(rc, state, NULL, NULL, rpm_msg);
+	int ret, i;
+
+	if (!n)
+		return 0;
+
+	rpm_msg.msg.is_complete = (state == RPMH_WAKE_ONLY_STATE);
+	memcpy(rpm_msg.cmd, cmd, n * sizeof(*cmd));
+	rpm_msg.msg.num_payload = n;
+
+	ret = mbox_write_controller_data(rc->chan, &rpm_msg.msg);
+	if (ret != -ENOMEM || n == 1)
+		return ret;
+
+	for (i = 0; i < n; i++) {
+		ret = send_single(rc, state, cmd[i].addr, cmd[i].data);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 /**
  * rpmh_flush: Flushes the buffered active and sleep sets to TCS
  *
@@ -909,9 +1047,10 @@ int send_single(struct rpmh_client *rc, enum rpmh_state state, u32 addr,
 int rpmh_flush(struct rpmh_client *rc)
 {
 	DEFINE_RPMH_MSG_ONSTACK(rc, 0, NULL, NULL, rpm_msg);
+	struct tcs_cmd sleep[MAX_RPMH_PAYLOAD], wake[MAX_RPMH_PAYLOAD];
 	struct rpmh_req *p;
 	struct rpmh_mbox *rpm = rc->rpmh;
-	int ret;
+	int ret, n = 0;
 	unsigned long flags;
 
 	if (IS_ERR_OR_NULL(rc))
@@ -945,7 +1084,8 @@ int rpmh_flush(struct rpmh_client *rc)
 
 	/*
 	 * Nobody else should be calling this function other than sleep,
-	 * hence we can run without locks.
+	 * hence we can run without locks. Pack the sleep and wake votes
+	 * into as few controller writes as possible.
 	 */
 	list_for_each_entry(p, &rc->rpmh->resources, list) {
 		if (!is_req_valid(p)) {
@@ -953,15 +1093,28 @@ int rpmh_flush(struct rpmh_client *rc)
 				__func__, p->addr, p->sleep_val, p->wake_val);
 			continue;
 		}
-		ret = send_single(rc, RPMH_SLEEP_STATE, p->addr, p->sleep_val);
+		sleep[n].addr = wake[n].addr = p->addr;
+		sleep[n].data = p->sleep_val;
+		wake[n].data = p->wake_val;
+		sleep[n].complete = wake[n].complete = false;
+		if (++n < MAX_RPMH_PAYLOAD)
+			continue;
+		ret = send_set(rc, RPMH_SLEEP_STATE, sleep, n);
 		if (ret)
 			return ret;
-		ret = send_single(rc, RPMH_WAKE_ONLY_STATE, p->addr,
-						p->wake_val);
+		ret = send_set(rc, RPMH_WAKE_ONLY_STATE, wake, n);
 		if (ret)
 			return ret;
+		n = 0;
 	}
 
+	ret = send_set(rc, RPMH_SLEEP_STATE, sleep, n);
+	if (ret)
+		return ret;
+	ret = send_set(rc, RPMH_WAKE_ONLY_STATE, wake, n);
+	if (ret)
+		return ret;
+
 	spin_lock_irqsave(&rpm->lock, flags);
 	rpm->dirty = false;
 	spin_unlock_irqrestore(&rpm->lock, flags);
@@ -1033,6 +1186,7 @@ static struct rpmh_mbox *get_mbox(struct platform_device *pdev,
 
 	rpmh->mbox_dn = spec.np;
 	INIT_LIST_HEAD(&rpmh->resources);
+	hash_init(rpmh->req_hash);
 	spin_lock_init(&rpmh->lock);
 
 found:
@@ -71,6 +71,8 @@ int msm_smp2p_out_read(struct msm_smp2p_out *handle, uint32_t *data);
 int msm_smp2p_out_write(struct msm_smp2p_out *handle, uint32_t data);
 int msm_smp2p_out_modify(struct msm_smp2p_out *handle, uint32_t set_mask,
 	uint32_t clear_mask, bool send_irq);
+int msm_smp2p_out_modify_batch(struct msm_smp2p_out **handles,
+	uint32_t *set_masks, uint32_t *clear_masks, int num);
 int msm_smp2p_in_read(int remote_pid, const char *entry, uint32_t *data);
 int msm_smp2p_in_register(int remote_pid, const char *entry,
 	struct notifier_block *in_notifier);
@@ -24,6 +24,7 @@
 #include <linux/slab.h>
 #include <linux/swap.h>
 #include <linux/vmalloc.h>
+#include <linux/percpu.h>
 #include "ion_priv.h"
 
 static void *ion_page_pool_alloc_pages(struct ion_page_pool *pool)
@@ -92,6 +93,224 @@ static struct page *ion_page_pool_remove(struct ion_page_pool *pool, bool high)
 	return page;
 }
 
+#ifdef CONFIG_ION_POOL_PCP
+struct ion_page_pool_pcp {
+	spinlock_t lock;
+	int count;
+	struct list_head items;
+};
+
+/*
+ * Pages in the per-cpu caches stay accounted as indirectly reclaimable,
+ * so moving them between a cache and the pool lists needs no accounting.
+ */
+static struct page *ion_page_pool_pcp_get(struct ion_page_pool *pool)
+{
+	struct ion_page_pool_pcp *pcp;
+	struct page *page = NULL;
+
+	if (!pool->pcp)
+		return NULL;
+
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	if (pcp->count) {
+		page = list_first_entry(&pcp->items, struct page, lru);
+		list_del(&page->lru);
+		pcp->count--;
+	}
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
+
+	if (page) {
+		atomic_dec(&pool->pcp_count);
+		mod_node_page_state(page_pgdat(page),
+				    NR_INDIRECTLY_RECLAIMABLE_BYTES,
+				    -(1 << (PAGE_SHIFT + pool->order)));
+	}
+
+	return page;
+}
+
+/* Take a batch of lowmem pages from the pool, return one, cache the rest */
+static struct page *ion_page_pool_pcp_refill(struct ion_page_pool *pool)
+{
+	struct ion_page_pool_pcp *pcp;
+	struct page *page;
+	LIST_HEAD(batch);
+	int nr = 0;
+
+	if (!pool->pcp)
+		return NULL;
+
+	if (!mutex_trylock(&pool->mutex))
+		return NULL;
+	while (nr < pool->pcp_batch && pool->low_count) {
+		list_move_tail(pool->low_items.next, &batch);
+		pool->low_count--;
+		nr++;
+	}
+	mutex_unlock(&pool->mutex);
+
+	if (!nr)
+		return NULL;
+
+	page = list_first_entry(&batch, struct page, lru);
+	list_del(&page->lru);
+	mod_node_page_state(page_pgdat(page), NR_INDIRECTLY_RECLAIMABLE_BYTES,
+			    -(1 << (PAGE_SHIFT + pool->order)));
+	if (!--nr)
+		return page;
+
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	list_splice(&batch, &pcp->items);
+	pcp->count += nr;
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
+	atomic_add(nr, &pool->pcp_count);
+
+	return page;
+}
+
+/* Cache a freed lowmem page, flushing a batch to the pool when full */
+static bool ion_page_pool_pcp_put(struct ion_page_pool *pool,
+				  struct page *page)
+{
+	struct ion_page_pool_pcp *pcp;
+	LIST_HEAD(flush);
+	int nr = 0;
+
+	if (!pool->pcp || PageHighMem(page))
+		return false;
+
+	mod_node_page_state(page_pgdat(page), NR_INDIRECTLY_RECLAIMABLE_BYTES,
+			    (1 << (PAGE_SHIFT + pool->order)));
+
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	list_add(&page->lru, &pcp->items);
+	pcp->count++;
+	if (pcp->count > pool->pcp_high) {
+		/* Flush the coldest pages */
+		while (nr < pool->pcp_batch && pcp->count) {
+			list_move(pcp->items.prev, &flush);
+			pcp->count--;
+			nr++;
+		}
+	}
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
+	atomic_add(1 - nr, &pool->pcp_count);
+
+	if (nr) {
+		mutex_lock(&pool->mutex);
+		list_splice_tail(&flush, &pool->low_items);
+		pool->low_count += nr;
+		mutex_unlock(&pool->mutex);
+	}
+
+	return true;
+}
+
+/* Return the pages of every per-cpu cache to the pool */
+static void ion_page_pool_pcp_drain(struct ion_page_pool *pool)
+{
+	struct ion_page_pool_pcp *pcp;
+	LIST_HEAD(drain);
+	int cpu, nr = 0;
+
+	if (!pool->pcp || !atomic_read(&pool->pcp_count))
+		return;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+		spin_lock(&pcp->lock);
+		list_splice_init(&pcp->items, &drain);
+		nr += pcp->count;
+		pcp->count = 0;
+		spin_unlock(&pcp->lock);
+	}
+
+	if (!nr)
+		return;
+
+	atomic_sub(nr, &pool->pcp_count);
+	mutex_lock(&pool->mutex);
+	list_splice_tail(&drain, &pool->low_items);
+	pool->low_count += nr;
+	mutex_unlock(&pool->mutex);
+}
+
+static int ion_page_pool_pcp_total(struct ion_page_pool *pool)
+{
+	return atomic_read(&pool->pcp_count);
+}
+
+int ion_page_pool_enable_pcp(struct ion_page_pool *pool, int high, int batch)
+{
+	struct ion_page_pool_pcp *pcp;
+	int cpu;
+
+	if (high <= 0 || batch <= 0 || batch > high)
+		return -EINVAL;
+
+	pool->pcp = alloc_percpu(struct ion_page_pool_pcp);
+	if (!pool->pcp)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+		spin_lock_init(&pcp->lock);
+		INIT_LIST_HEAD(&pcp->items);
+		pcp->count = 0;
+	}
+	pool->pcp_high = high;
+	pool->pcp_batch = batch;
+
+	return 0;
+}
+
+static void ion_page_pool_pcp_init(struct ion_page_pool *pool)
+{
+	pool->pcp = NULL;
+	atomic_set(&pool->pcp_count, 0);
+}
+
+static void ion_page_pool_pcp_destroy(struct ion_page_pool *pool)
+{
+	ion_page_pool_pcp_drain(pool);
+	free_percpu(pool->pcp);
+	pool->pcp = NULL;
+}
+#else
+static inline struct page *ion_page_pool_pcp_get(struct ion_page_pool *pool)
+{
+	return NULL;
+}
+
+static inline struct page *ion_page_pool_pcp_refill(struct ion_page_pool *pool)
+{
+	return NULL;
+}
+
+static inline bool ion_page_pool_pcp_put(struct ion_page_pool *pool,
+					 struct page *page)
+{
+	return false;
+}
+
+static inline void ion_page_pool_pcp_drain(struct ion_page_pool *pool) { }
+
+static inline int ion_page_pool_pcp_total(struct ion_page_pool *pool)
+{
+	return 0;
+}
+
+static inline void ion_page_pool_pcp_init(struct ion_page_pool *pool) { }
+static inline void ion_page_pool_pcp_destroy(struct ion_page_pool *pool) { }
+#endif /* CONFIG_ION_POOL_PCP */
+
 void *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
 {
 	struct page *page = NULL;
@@ -100,6 +319,14 @@ void *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
 
 	*from_pool = true;
 
+	page = ion_page_pool_pcp_get(pool);
+	if (page)
+		return page;
+
+	page = ion_page_pool_pcp_refill(pool);
+	if (page)
+		return page;
+
 	if (mutex_trylock(&pool->mutex)) {
 		if (pool->high_count)
 			page = ion_page_pool_remove(pool, true);
@@ -139,6 +366,9 @@ void ion_page_pool_free(struct ion_page_pool *pool, struct page *page)
 {
 	int ret;
 
+	if (ion_page_pool_pcp_put(pool, page))
+		return;
+
 	ret = ion_page_pool_add(pool, page);
 	if (ret)
 		ion_page_pool_free_pages(pool, page);
@@ -151,7 +381,7 @@ void ion_page_pool_free_immediate(struct ion_page_pool *pool, struct page *page)
 
 int ion_page_pool_total(struct ion_page_pool *pool, bool high)
 {
-	int count = pool->low_count;
+	int count = pool->low_count + ion_page_pool_pcp_total(pool);
 
 	if (high)
 		count += pool->high_count;
@@ -173,6 +403,8 @@ int ion_page_pool_shrink(struct ion_page_pool *pool, gfp_t gfp_mask,
 	if (nr_to_scan == 0)
 		return ion_page_pool_total(pool, high);
 
+	ion_page_pool_pcp_drain(pool);
+
 	while (freed < nr_to_scan) {
 		struct page *page;
 
@@ -209,12 +441,14 @@ struct ion_page_pool *ion_page_pool_create(struct device *dev, gfp_t gfp_mask,
 	pool->order = order;
 	mutex_init(&pool->mutex);
 	plist_node_init(&pool->list, order);
+	ion_page_pool_pcp_init(pool);
 
 	return pool;
 }
 
 void ion_page_pool_destroy(struct ion_page_pool *pool)
 {
+	ion_page_pool_pcp_destroy(pool);
 	kfree(pool);
 }
 
@@ -459,6 +459,12 @@ void ion_carveout_free(struct ion_heap *heap, ion_phys_addr_t addr,
  * @gfp_mask:		gfp_mask to use from alloc
  * @order:		order of pages in the pool
  * @list:		plist node for list of pools
+ * @pcp:		optional per-cpu caches of lowmem pages in front of the
+ *			pool, NULL if not enabled
+ * @pcp_high:		number of pages a per-cpu cache may hold
+ * @pcp_batch:		number of pages moved between a per-cpu cache and
+ *			the pool at once
+ * @pcp_count:		number of pages held in all per-cpu caches
  *
  * Allows you to keep a pool of pre allocated pages to use from your heap.
  * Keeping a pool of pages that is ready for dma, ie any cached mapping have
@@ -475,6 +481,12 @@ struct ion_page_pool {
 	gfp_t gfp_mask;
 	unsigned int order;
 	struct plist_node list;
+#ifdef CONFIG_ION_POOL_PCP
+	struct ion_page_pool_pcp __percpu *pcp;
+	int pcp_high;
+	int pcp_batch;
+	atomic_t pcp_count;
+#endif
 };
 
 struct ion_page_pool *ion_page_pool_create(struct device *dev, gfp_t gfp_mask,
@@ -485,6 +497,26 @@ void *ion_page_pool_alloc_pool_only(struct ion_page_pool *a);
 void ion_page_pool_free(struct ion_page_pool *a, struct page *b);
 void ion_page_pool_free_immediate(struct ion_page_pool *, struct page *);
 int ion_page_pool_total(struct ion_page_pool *pool, bool high);
+
+#ifdef CONFIG_ION_POOL_PCP
+/**
+ * ion_page_pool_enable_pcp - put per-cpu caches in front of a pool
+ * @pool:		the pool
+ * @high:		maximum number of pages cached per cpu
+ * @batch:		number of pages refilled or flushed at once
+ *
+ * Only for pools whose pages are handed out with ion_page_pool_alloc().
+ * returns 0 on success or -ENOMEM
+ */
+int ion_page_pool_enable_pcp(struct ion_page_pool *pool, int high, int batch);
+#else
+static inline int ion_page_pool_enable_pcp(struct ion_page_pool *pool,
+					   int high, int batch)
+{
+	return 0;
+}
+#endif
+
 size_t ion_system_heap_secure_page_pool_total(struct ion_heap *heap, int vmid);
 
 #ifdef CONFIG_ION_POOL_CACHE_POLICY
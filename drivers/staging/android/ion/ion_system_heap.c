@@ -18,9 +18,13 @@
 #include <asm/page.h>
 #include <linux/dma-mapping.h>
 #include <linux/err.h>
+#include <linux/freezer.h>
 #include <linux/highmem.h>
+#include <linux/kthread.h>
 #include <linux/mm.h>
+#include <linux/moduleparam.h>
 #include <linux/msm_ion.h>
+#include <linux/psi.h>
 #include <linux/scatterlist.h>
 #include <linux/seq_file.h>
 #include <linux/slab.h>
@@ -46,6 +50,22 @@ static const unsigned int orders[] = {0};
 #endif
 
 static const int num_orders = ARRAY_SIZE(orders);
+
+/*
+ * Per-cpu cache sizes, in pages of the pool order, for the pools that
+ * take the bulk of gralloc and camera allocations.
+ */
+static int pool_pcp_high(unsigned int order)
+{
+	switch (order) {
+	case 0:
+		return 32;
+	case 4:
+		return 4;
+	default:
+		return 0;
+	}
+}
 static int order_to_index(unsigned int order)
 {
 	int i;
@@ -68,6 +88,13 @@ struct ion_system_heap {
 	struct ion_page_pool **secure_pools[VMID_LAST];
 	/* Prevents unnecessary page splitting */
 	struct mutex split_page_mutex;
+#ifdef CONFIG_ION_POOL_PREFILL
+	struct task_struct *prefill_thread;
+	wait_queue_head_t prefill_wait;
+	atomic_t prefill_pending;
+	struct psi_trigger *prefill_psi;
+	unsigned long prefill_backoff_until;
+#endif
 };
 
 struct page_info {
@@ -657,6 +684,174 @@ static int ion_system_heap_shrink(struct ion_heap *heap, gfp_t gfp_mask,
 	return nr_total;
 }
 
+#ifdef CONFIG_ION_POOL_PREFILL
+/*
+ * Background pool prefill.
+ *
+ * Pages taken from a pool are handed out without being zeroed or synced,
+ * since that was done when they were returned to it. Keeping the pools
+ * filled ahead of a camera or video session start therefore moves both
+ * off the allocation path. Only pages that can be had without reclaim are
+ * used, and prefilling stops for prefill_backoff_ms whenever PSI reports
+ * memory stalls.
+ */
+static unsigned int pool_prefill_kb;
+module_param(pool_prefill_kb, uint, 0644);
+
+static unsigned int prefill_backoff_ms = 1000;
+module_param(prefill_backoff_ms, uint, 0644);
+
+/* PSI memory "some" stall of 50ms within 1s window */
+#define PREFILL_PSI_THRESHOLD_US	50000
+#define PREFILL_PSI_WINDOW_US		1000000
+
+static struct ion_system_heap *prefill_heap;
+
+void ion_system_heap_prefill_kick(void)
+{
+	struct ion_system_heap *heap = READ_ONCE(prefill_heap);
+
+	if (!heap || !READ_ONCE(pool_prefill_kb))
+		return;
+
+	atomic_set(&heap->prefill_pending, 1);
+	wake_up(&heap->prefill_wait);
+}
+EXPORT_SYMBOL(ion_system_heap_prefill_kick);
+
+static void ion_system_heap_prefill_psi(void *data)
+{
+	struct ion_system_heap *heap = data;
+
+	WRITE_ONCE(heap->prefill_backoff_until,
+		   jiffies + msecs_to_jiffies(prefill_backoff_ms));
+}
+
+static bool ion_system_heap_prefill_throttled(struct ion_system_heap *heap)
+{
+	return time_before(jiffies, READ_ONCE(heap->prefill_backoff_until));
+}
+
+static unsigned long ion_system_heap_pools_total(struct ion_page_pool **pools)
+{
+	unsigned long total = 0;
+	int i;
+
+	for (i = 0; i < num_orders; i++)
+		total += ion_page_pool_total(pools[i], true);
+
+	return total;
+}
+
+static void ion_system_heap_prefill_pools(struct ion_system_heap *heap,
+					  struct ion_page_pool **pools)
+{
+	unsigned long target = READ_ONCE(pool_prefill_kb) >> (PAGE_SHIFT - 10);
+	struct device *dev = heap->heap.priv;
+	struct page *page;
+	gfp_t gfp_mask;
+	int i;
+
+	/* Largest orders first, as the allocator prefers them too */
+	for (i = 0; i < num_orders; i++) {
+		gfp_mask = orders[i] ? high_order_gfp_flags :
+			   (low_order_gfp_flags & ~__GFP_RECLAIM) |
+			   __GFP_NORETRY;
+
+		while (ion_system_heap_pools_total(pools) < target) {
+			if (ion_system_heap_prefill_throttled(heap) ||
+			    atomic_read(&heap->prefill_pending) ||
+			    kthread_should_stop())
+				return;
+
+			page = alloc_pages(gfp_mask, orders[i]);
+			if (!page)
+				break;
+
+			if (msm_ion_heap_high_order_page_zero(dev, page,
+							      orders[i])) {
+				__free_pages(page, orders[i]);
+				return;
+			}
+
+			ion_page_pool_free(pools[i], page);
+			cond_resched();
+		}
+	}
+}
+
+static int ion_system_heap_prefill_thread(void *data)
+{
+	struct ion_system_heap *heap = data;
+
+	set_freezable();
+	set_user_nice(current, MAX_NICE);
+
+	while (!kthread_should_stop()) {
+		wait_event_freezable(heap->prefill_wait,
+				     atomic_read(&heap->prefill_pending) ||
+				     kthread_should_stop());
+		/* A kick while filling restarts the pass with fresh totals */
+		if (!atomic_xchg(&heap->prefill_pending, 0))
+			continue;
+
+		ion_system_heap_prefill_pools(heap, heap->uncached_pools);
+		ion_system_heap_prefill_pools(heap, heap->cached_pools);
+	}
+
+	return 0;
+}
+
+static void ion_system_heap_prefill_init(struct ion_system_heap *heap)
+{
+	init_waitqueue_head(&heap->prefill_wait);
+	atomic_set(&heap->prefill_pending, 0);
+	heap->prefill_backoff_until = jiffies;
+
+	heap->prefill_psi = psi_kernel_trigger_create(PSI_MEM_SOME,
+					PREFILL_PSI_THRESHOLD_US,
+					PREFILL_PSI_WINDOW_US,
+					ion_system_heap_prefill_psi, heap);
+	if (IS_ERR(heap->prefill_psi)) {
+		pr_info("%s: prefill runs without PSI throttling\n", __func__);
+		heap->prefill_psi = NULL;
+	}
+
+	heap->prefill_thread = kthread_run(ion_system_heap_prefill_thread,
+					   heap, "ion_prefill");
+	if (IS_ERR(heap->prefill_thread)) {
+		pr_err("%s: failed to start prefill thread\n", __func__);
+		heap->prefill_thread = NULL;
+		if (heap->prefill_psi)
+			psi_kernel_trigger_destroy(heap->prefill_psi);
+		heap->prefill_psi = NULL;
+		return;
+	}
+
+	/* Only one system heap is expected to be prefilled */
+	if (!prefill_heap)
+		WRITE_ONCE(prefill_heap, heap);
+}
+
+static void ion_system_heap_prefill_exit(struct ion_system_heap *heap)
+{
+	if (prefill_heap == heap)
+		WRITE_ONCE(prefill_heap, NULL);
+	if (heap->prefill_thread)
+		kthread_stop(heap->prefill_thread);
+	if (heap->prefill_psi)
+		psi_kernel_trigger_destroy(heap->prefill_psi);
+}
+#else
+static inline void ion_system_heap_prefill_init(struct ion_system_heap *heap)
+{
+}
+
+static inline void ion_system_heap_prefill_exit(struct ion_system_heap *heap)
+{
+}
+#endif /* CONFIG_ION_POOL_PREFILL */
+
 static struct ion_heap_ops system_heap_ops = {
 	.allocate = ion_system_heap_allocate,
 	.free = ion_system_heap_free,
@@ -683,10 +878,12 @@ static void ion_system_heap_destroy_pools(struct ion_page_pool **pools)
  *
  * If this fails you don't need to destroy any pools. It's all or
  * nothing. If it succeeds you'll eventually need to use
- * ion_system_heap_destroy_pools to destroy the pools.
+ * ion_system_heap_destroy_pools to destroy the pools. With @pcp set, per-cpu
+ * caches are put in front of the order-0 and order-4 pools.
  */
 static int ion_system_heap_create_pools(struct device *dev,
-					struct ion_page_pool **pools)
+					struct ion_page_pool **pools,
+					bool pcp)
 {
 	int i;
 	for (i = 0; i < num_orders; i++) {
@@ -699,6 +896,11 @@ static int ion_system_heap_create_pools(struct device *dev,
 		if (!pool)
 			goto err_create_pool;
 		pools[i] = pool;
+
+		/* The per-cpu caches are optional, the pool works without */
+		if (pcp && pool_pcp_high(orders[i]))
+			ion_page_pool_enable_pcp(pool, pool_pcp_high(orders[i]),
+						 pool_pcp_high(orders[i]) / 2);
 	}
 	return 0;
 err_create_pool:
@@ -734,18 +936,19 @@ struct ion_heap *ion_system_heap_create(struct ion_platform_heap *data)
 			if (!heap->secure_pools[i])
 				goto err_create_secure_pools;
 			if (ion_system_heap_create_pools(
-					dev, heap->secure_pools[i]))
+					dev, heap->secure_pools[i], false))
 				goto err_create_secure_pools;
 		}
 	}
 
-	if (ion_system_heap_create_pools(dev, heap->uncached_pools))
+	if (ion_system_heap_create_pools(dev, heap->uncached_pools, true))
 		goto err_create_uncached_pools;
 
-	if (ion_system_heap_create_pools(dev, heap->cached_pools))
+	if (ion_system_heap_create_pools(dev, heap->cached_pools, true))
 		goto err_create_cached_pools;
 
 	mutex_init(&heap->split_page_mutex);
+	ion_system_heap_prefill_init(heap);
 
 	return &heap->heap;
 
@@ -774,6 +977,8 @@ void ion_system_heap_destroy(struct ion_heap *heap)
 							heap);
 	int i, j;
 
+	ion_system_heap_prefill_exit(sys_heap);
+
 	for (i = 0; i < VMID_LAST; i++) {
 		if (!is_secure_vmid_valid(i))
 			continue;
@@ -210,4 +210,18 @@ static bool is_buffer_hlos_assigned(struct ion_buffer *buffer)
 }
 #endif /* CONFIG_ION */
 
+#ifdef CONFIG_ION_POOL_PREFILL
+/**
+ * ion_system_heap_prefill_kick - refill the system heap pools in background
+ *
+ * Called when a multimedia session that is about to allocate many buffers
+ * is opened. Returns immediately.
+ */
+void ion_system_heap_prefill_kick(void);
+#else
+static inline void ion_system_heap_prefill_kick(void)
+{
+}
+#endif /* CONFIG_ION_POOL_PREFILL */
+
 #endif
@@ -49,6 +49,8 @@
 #include <linux/cpuset.h>
 #include <linux/vmpressure.h>
 #include <linux/freezer.h>
+#include <linux/psi.h>
+#include <linux/kstats.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/almk.h>
@@ -119,14 +121,21 @@ struct lmk_event {
 	unsigned long min_flt;
 	unsigned long maj_flt;
 	unsigned long rss_in_pages;
+	unsigned long reaped_pages;
 	short oom_score_adj;
 	short min_score_adj;
 	unsigned long long start_time;
 	struct list_head list;
 };
 
-void handle_lmk_event(struct task_struct *selected, int selected_tasksize,
-		      short min_score_adj)
+/* Totals for /proc/kstats, kept even when the event buffer is full */
+static struct kstats_lmk lmk_stats = {
+	.last_min_score_adj = OOM_SCORE_ADJ_MAX + 1,
+};
+
+static void __handle_lmk_event(struct task_struct *selected,
+			       int selected_tasksize, short min_score_adj,
+			       unsigned long reaped_pages)
 {
 	int head;
 	int tail;
@@ -135,6 +144,15 @@ void handle_lmk_event(struct task_struct *selected, int selected_tasksize,
 
 	spin_lock(&lmk_event_lock);
 
+	/* reap events are reported with a min_score_adj above the range */
+	if (min_score_adj > OOM_SCORE_ADJ_MAX) {
+		lmk_stats.reaped_pages += reaped_pages;
+	} else {
+		lmk_stats.kills++;
+		lmk_stats.killed_pages += selected_tasksize;
+		lmk_stats.last_min_score_adj = min_score_adj;
+	}
+
 	head = event_buffer.head;
 	tail = READ_ONCE(event_buffer.tail);
 
@@ -160,6 +178,7 @@ void handle_lmk_event(struct task_struct *selected, int selected_tasksize,
 	event->oom_score_adj = selected->signal->oom_score_adj;
 	event->start_time = nsec_to_clock_t(selected->real_start_time);
 	event->rss_in_pages = selected_tasksize;
+	event->reaped_pages = reaped_pages;
 	event->min_score_adj = min_score_adj;
 
 	event_buffer.head = (head + 1) & (MAX_BUFFERED_EVENTS - 1);
@@ -169,6 +188,30 @@ void handle_lmk_event(struct task_struct *selected, int selected_tasksize,
 	wake_up_interruptible(&event_wait);
 }
 
+void handle_lmk_event(struct task_struct *selected, int selected_tasksize,
+		      short min_score_adj)
+{
+	__handle_lmk_event(selected, selected_tasksize, min_score_adj, 0);
+}
+
+#ifdef CONFIG_KSTATS
+static int lmk_kstats_fill(void *buf, size_t max_len)
+{
+	spin_lock(&lmk_event_lock);
+	memcpy(buf, &lmk_stats, sizeof(lmk_stats));
+	spin_unlock(&lmk_event_lock);
+
+	return sizeof(lmk_stats);
+}
+
+static struct kstats_source lmk_kstats_source = {
+	.type		= KSTATS_TYPE_LMK,
+	.version	= 1,
+	.max_len	= sizeof(struct kstats_lmk),
+	.fill		= lmk_kstats_fill,
+};
+#endif
+
 static int lmk_event_show(struct seq_file *s, void *unused)
 {
 	struct lmk_event *events = (struct lmk_event *) event_buffer.buf;
@@ -188,11 +231,12 @@ static int lmk_event_show(struct seq_file *s, void *unused)
 
 	event = &events[tail];
 
-	seq_printf(s, "%lu %lu %lu %lu %lu %lu %hd %hd %llu\n%s\n",
+	seq_printf(s, "%lu %lu %lu %lu %lu %lu %hd %hd %llu %lu\n%s\n",
 		(unsigned long) event->pid, (unsigned long) event->uid,
 		(unsigned long) event->group_leader_pid, event->min_flt,
 		event->maj_flt, event->rss_in_pages, event->oom_score_adj,
-		event->min_score_adj, event->start_time, event->taskname);
+		event->min_score_adj, event->start_time, event->reaped_pages,
+		event->taskname);
 
 	event_buffer.tail = (tail + 1) & (MAX_BUFFERED_EVENTS - 1);
 
@@ -356,6 +400,232 @@ static struct notifier_block lmk_vmpr_nb = {
 	.notifier_call = lmk_vmpressure_notifier,
 };
 
+#ifdef CONFIG_ANDROID_LMK_PSI
+/*
+ * PSI kill mode: instead of the minfree table, the minimum oom_score_adj
+ * for a kill is derived from memory stall time and file cache thrashing.
+ *
+ * - Sustained full memory stalls (psi_full_thres_ms of stall within
+ *   psi_window_ms) allow kills down to psi_full_min_adj.
+ * - Partial memory stalls (psi_some_thres_ms within psi_window_ms) while
+ *   more than psi_thrash_pct percent of the file LRU was refaulted since
+ *   the previous event allow kills down to psi_some_min_adj.
+ *
+ * A level stays armed for one window after its trigger fired and is used by
+ * the next lowmem_scan() run. Thresholds are applied when psi_mode is
+ * (re)enabled.
+ */
+enum {
+	LMK_PSI_NONE,
+	LMK_PSI_THRASHING,
+	LMK_PSI_STALLED,
+};
+
+static u32 psi_window_ms = 1000;
+static u32 psi_full_thres_ms = 70;
+static u32 psi_some_thres_ms = 150;
+static u32 psi_thrash_pct = 30;
+static short psi_full_min_adj = 200;
+static short psi_some_min_adj = 900;
+module_param_named(psi_window_ms, psi_window_ms, uint, 0644);
+module_param_named(psi_full_thres_ms, psi_full_thres_ms, uint, 0644);
+module_param_named(psi_some_thres_ms, psi_some_thres_ms, uint, 0644);
+module_param_named(psi_thrash_pct, psi_thrash_pct, uint, 0644);
+module_param_named(psi_full_min_adj, psi_full_min_adj, short, 0644);
+module_param_named(psi_some_min_adj, psi_some_min_adj, short, 0644);
+
+static bool psi_mode;
+static DEFINE_MUTEX(lmk_psi_mutex);
+static struct psi_trigger *lmk_psi_full_trig;
+static struct psi_trigger *lmk_psi_some_trig;
+static int lmk_psi_level = LMK_PSI_NONE;
+static unsigned long lmk_psi_expires;
+static unsigned long lmk_psi_last_refault;
+
+static void lmk_psi_set_level(int level)
+{
+	/* Never downgrade an armed level before it expires */
+	if (level < READ_ONCE(lmk_psi_level) &&
+	    time_before(jiffies, READ_ONCE(lmk_psi_expires)))
+		return;
+
+	WRITE_ONCE(lmk_psi_expires,
+		   jiffies + msecs_to_jiffies(psi_window_ms));
+	WRITE_ONCE(lmk_psi_level, level);
+}
+
+static void lmk_psi_full_notify(void *data)
+{
+	lmk_psi_set_level(LMK_PSI_STALLED);
+}
+
+static void lmk_psi_some_notify(void *data)
+{
+	unsigned long refault = global_node_page_state(WORKINGSET_REFAULT);
+	unsigned long file = global_node_page_state(NR_ACTIVE_FILE) +
+			     global_node_page_state(NR_INACTIVE_FILE);
+	unsigned long delta = refault - lmk_psi_last_refault;
+
+	lmk_psi_last_refault = refault;
+
+	if (delta * 100 > file * psi_thrash_pct)
+		lmk_psi_set_level(LMK_PSI_THRASHING);
+}
+
+static short lmk_psi_min_adj(void)
+{
+	if (time_after_eq(jiffies, READ_ONCE(lmk_psi_expires)))
+		return OOM_SCORE_ADJ_MAX + 1;
+
+	switch (READ_ONCE(lmk_psi_level)) {
+	case LMK_PSI_STALLED:
+		return psi_full_min_adj;
+	case LMK_PSI_THRASHING:
+		return psi_some_min_adj;
+	default:
+		return OOM_SCORE_ADJ_MAX + 1;
+	}
+}
+
+static void lmk_psi_stop(void)
+{
+	psi_kernel_trigger_destroy(lmk_psi_full_trig);
+	psi_kernel_trigger_destroy(lmk_psi_some_trig);
+	lmk_psi_full_trig = NULL;
+	lmk_psi_some_trig = NULL;
+	WRITE_ONCE(lmk_psi_level, LMK_PSI_NONE);
+}
+
+static int lmk_psi_start(void)
+{
+	u32 window_us = psi_window_ms * USEC_PER_MSEC;
+	struct psi_trigger *full, *some;
+
+	lmk_psi_last_refault = global_node_page_state(WORKINGSET_REFAULT);
+
+	full = psi_kernel_trigger_create(PSI_MEM_FULL,
+			psi_full_thres_ms * USEC_PER_MSEC, window_us,
+			lmk_psi_full_notify, NULL);
+	if (IS_ERR(full))
+		return PTR_ERR(full);
+
+	some = psi_kernel_trigger_create(PSI_MEM_SOME,
+			psi_some_thres_ms * USEC_PER_MSEC, window_us,
+			lmk_psi_some_notify, NULL);
+	if (IS_ERR(some)) {
+		psi_kernel_trigger_destroy(full);
+		return PTR_ERR(some);
+	}
+
+	lmk_psi_full_trig = full;
+	lmk_psi_some_trig = some;
+
+	return 0;
+}
+
+/* Set once lowmem_init() ran; psi_mode given on the command line waits */
+static bool lmk_psi_ready;
+
+static int lmk_psi_mode_set(const char *val, const struct kernel_param *kp)
+{
+	bool enable;
+	int ret;
+
+	ret = strtobool(val, &enable);
+	if (ret)
+		return ret;
+
+	mutex_lock(&lmk_psi_mutex);
+	if (!lmk_psi_ready) {
+		psi_mode = enable;
+		goto unlock;
+	}
+
+	if (psi_mode)
+		lmk_psi_stop();
+	psi_mode = false;
+
+	if (enable) {
+		ret = lmk_psi_start();
+		if (ret)
+			pr_err("failed to create psi triggers: %d\n", ret);
+		else
+			psi_mode = true;
+	}
+unlock:
+	mutex_unlock(&lmk_psi_mutex);
+
+	return ret;
+}
+
+static void lmk_psi_init(void)
+{
+	mutex_lock(&lmk_psi_mutex);
+	lmk_psi_ready = true;
+	if (psi_mode && lmk_psi_start()) {
+		pr_err("failed to create psi triggers\n");
+		psi_mode = false;
+	}
+	mutex_unlock(&lmk_psi_mutex);
+}
+
+static const struct kernel_param_ops lmk_psi_mode_ops = {
+	.set = lmk_psi_mode_set,
+	.get = param_get_bool,
+};
+module_param_cb(psi_mode, &lmk_psi_mode_ops, &psi_mode, 0644);
+
+static inline bool lmk_psi_enabled(void)
+{
+	return READ_ONCE(psi_mode);
+}
+#else
+static inline void lmk_psi_init(void) { }
+
+static inline bool lmk_psi_enabled(void)
+{
+	return false;
+}
+
+static inline short lmk_psi_min_adj(void)
+{
+	return OOM_SCORE_ADJ_MAX + 1;
+}
+#endif
+
+/*
+ * Report the memory the oom reaper took away from our victims. This is
+ * logged as a second event for the victim, with the rss left after
+ * reaping and the number of pages reaped.
+ */
+static int lmk_oom_reap_notifier(struct notifier_block *nb,
+				 unsigned long action, void *data)
+{
+	struct oom_reap_info *info = data;
+	struct task_struct *tsk = info->tsk;
+	struct mm_struct *mm = tsk->signal->oom_mm;
+	bool lmk_victim;
+
+	task_lock(tsk);
+	lmk_victim = task_lmk_waiting(tsk);
+	task_unlock(tsk);
+
+	if (!lmk_victim)
+		return NOTIFY_DONE;
+
+	lowmem_print(2, "reaped %lukB from '%s' (%d)\n",
+		     info->reaped_pages * (PAGE_SIZE / 1024), tsk->comm,
+		     tsk->pid);
+	__handle_lmk_event(tsk, mm ? get_mm_rss(mm) : 0,
+			   OOM_SCORE_ADJ_MAX + 1, info->reaped_pages);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block lmk_oom_reap_nb = {
+	.notifier_call = lmk_oom_reap_notifier,
+};
+
 static int test_task_flag(struct task_struct *p, int flag)
 {
 	struct task_struct *t;
@@ -656,6 +926,11 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 	tune_lmk_param(&other_free, &other_file, sc);
 #endif
 
+	if (lmk_psi_enabled()) {
+		min_score_adj = lmk_psi_min_adj();
+		goto scan;
+	}
+
 	if (lowmem_adj_size < array_size)
 		array_size = lowmem_adj_size;
 	if (lowmem_minfree_size < array_size)
@@ -670,6 +945,8 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 
 	ret = adjust_minadj(&min_score_adj);
 
+scan:
+
 	lowmem_print(3, "lowmem_scan %lu, %x, ofree %d %d, ma %hd\n",
 		     sc->nr_to_scan, sc->gfp_mask, other_free,
 		     other_file, min_score_adj);
@@ -910,7 +1187,12 @@ static int __init lowmem_init(void)
 #endif
 	register_shrinker(&lowmem_shrinker);
 	vmpressure_notifier_register(&lmk_vmpr_nb);
+	register_oom_reap_notifier(&lmk_oom_reap_nb);
+	lmk_psi_init();
 	lmk_event_init();
+#ifdef CONFIG_KSTATS
+	kstats_register_source(&lmk_kstats_source);
+#endif
 	return 0;
 }
 device_initcall(lowmem_init);
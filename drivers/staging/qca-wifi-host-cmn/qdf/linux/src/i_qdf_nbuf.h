@@ -1394,6 +1394,40 @@ typedef struct __qdf_nbuf_qhead {
 	unsigned int qlen;
 } __qdf_nbuf_queue_t;
 
+/**
+ * typedef struct __qdf_nbuf_rx_pool_t - rx buffers kept DMA mapped
+ * @osdev: device the buffers are mapped for
+ * @lock: protects @bufs
+ * @bufs: free buffers, mapped and owned by the device side of the cache
+ * @size: bytes of each buffer mapped for the target, starting at skb->data
+ * @headroom: skb headroom in front of the mapped bytes
+ * @max_bufs: free buffers kept at most, extra ones are released
+ * @recycled: buffers handed out again without a new mapping
+ * @mapped: buffers that had to be allocated and mapped
+ */
+typedef struct __qdf_nbuf_rx_pool {
+	qdf_device_t osdev;
+	spinlock_t lock;
+	struct sk_buff_head bufs;
+	uint32_t size;
+	uint32_t headroom;
+	uint32_t max_bufs;
+	uint32_t recycled;
+	uint32_t mapped;
+} __qdf_nbuf_rx_pool_t;
+
+void __qdf_nbuf_rx_pool_init(__qdf_nbuf_rx_pool_t *pool, qdf_device_t osdev,
+			     uint32_t size, int reserve, int align,
+			     uint32_t max_bufs);
+void __qdf_nbuf_rx_pool_deinit(__qdf_nbuf_rx_pool_t *pool);
+struct sk_buff *__qdf_nbuf_rx_pool_alloc(__qdf_nbuf_rx_pool_t *pool);
+void __qdf_nbuf_rx_pool_sync_for_cpu(__qdf_nbuf_rx_pool_t *pool,
+				     struct sk_buff *skb, uint32_t nbytes);
+void __qdf_nbuf_rx_pool_put(__qdf_nbuf_rx_pool_t *pool,
+			    struct sk_buff *skb, uint32_t nbytes);
+void __qdf_nbuf_rx_pool_detach(__qdf_nbuf_rx_pool_t *pool,
+			       struct sk_buff *skb);
+
 /******************Functions *************/
 
 /**
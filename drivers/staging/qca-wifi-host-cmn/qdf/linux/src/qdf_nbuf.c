@@ -3786,6 +3786,234 @@ __qdf_nbuf_sync_for_cpu(qdf_device_t osdev,
 }
 qdf_export_symbol(__qdf_nbuf_sync_for_cpu);
 
+/*
+ * Rx buffer pool. Buffers of a CE rx ring stay DMA mapped for their whole
+ * life: the driver only syncs the bytes the target wrote for the CPU, and a
+ * buffer that the driver consumed itself goes back to the pool with just the
+ * range the CPU may have touched handed back to the device. Only buffers
+ * that leave for the network stack are unmapped, again without maintaining
+ * the cache lines that were never written.
+ */
+#if defined(A_SIMOS_DEVHOST)
+static inline void __qdf_nbuf_rx_pool_sync(__qdf_nbuf_rx_pool_t *pool,
+					   struct sk_buff *skb,
+					   uint32_t nbytes, bool for_cpu)
+{
+}
+
+static inline void __qdf_nbuf_rx_pool_unmap(__qdf_nbuf_rx_pool_t *pool,
+					    struct sk_buff *skb)
+{
+}
+#else
+static inline void __qdf_nbuf_rx_pool_sync(__qdf_nbuf_rx_pool_t *pool,
+					   struct sk_buff *skb,
+					   uint32_t nbytes, bool for_cpu)
+{
+	if (!nbytes)
+		return;
+
+	if (for_cpu)
+		dma_sync_single_for_cpu(pool->osdev->dev,
+					QDF_NBUF_CB_PADDR(skb), nbytes,
+					DMA_FROM_DEVICE);
+	else
+		dma_sync_single_for_device(pool->osdev->dev,
+					   QDF_NBUF_CB_PADDR(skb), nbytes,
+					   DMA_FROM_DEVICE);
+}
+
+static inline void __qdf_nbuf_rx_pool_unmap(__qdf_nbuf_rx_pool_t *pool,
+					    struct sk_buff *skb)
+{
+	/* the bytes of interest were synced by the caller already */
+	dma_unmap_single_attrs(pool->osdev->dev, QDF_NBUF_CB_PADDR(skb),
+			       pool->size, DMA_FROM_DEVICE,
+			       DMA_ATTR_SKIP_CPU_SYNC);
+}
+#endif
+
+/**
+ * __qdf_nbuf_rx_pool_init() - initialize an rx buffer pool
+ * @pool: pool to initialize
+ * @osdev: device the buffers are mapped for
+ * @size: bytes of each buffer the target may write
+ * @reserve: headroom to leave in front of the data, as for __qdf_nbuf_alloc()
+ * @align: alignment of the data before @reserve, as for __qdf_nbuf_alloc()
+ * @max_bufs: number of free buffers kept at most, typically the ring size
+ *
+ * All buffers of a pool share the same layout, so that a recycled buffer can
+ * be reset without keeping any state in the buffer itself.
+ *
+ * Return: none
+ */
+void __qdf_nbuf_rx_pool_init(__qdf_nbuf_rx_pool_t *pool, qdf_device_t osdev,
+			     uint32_t size, int reserve, int align,
+			     uint32_t max_bufs)
+{
+	memset(pool, 0, sizeof(*pool));
+	pool->osdev = osdev;
+	spin_lock_init(&pool->lock);
+	skb_queue_head_init(&pool->bufs);
+	pool->size = size;
+	/* skb heads are cache line aligned, so aligning the offset is enough */
+	pool->headroom = ALIGN(NET_SKB_PAD, align ? align : 1) + reserve;
+	pool->max_bufs = max_bufs;
+}
+qdf_export_symbol(__qdf_nbuf_rx_pool_init);
+
+/**
+ * __qdf_nbuf_rx_pool_release() - unmap and free a pool buffer
+ * @pool: pool the buffer belongs to
+ * @skb: buffer
+ *
+ * Return: none
+ */
+static void __qdf_nbuf_rx_pool_release(__qdf_nbuf_rx_pool_t *pool,
+				       struct sk_buff *skb)
+{
+	__qdf_nbuf_rx_pool_unmap(pool, skb);
+	QDF_NBUF_CB_PADDR(skb) = 0;
+	__qdf_nbuf_free(skb);
+}
+
+/**
+ * __qdf_nbuf_rx_pool_deinit() - release all free buffers of a pool
+ * @pool: pool to empty
+ *
+ * Buffers still posted to the ring must have been detached or put back
+ * before.
+ *
+ * Return: none
+ */
+void __qdf_nbuf_rx_pool_deinit(__qdf_nbuf_rx_pool_t *pool)
+{
+	struct sk_buff *skb;
+
+	spin_lock_bh(&pool->lock);
+	while ((skb = __skb_dequeue(&pool->bufs))) {
+		spin_unlock_bh(&pool->lock);
+		__qdf_nbuf_rx_pool_release(pool, skb);
+		spin_lock_bh(&pool->lock);
+	}
+	spin_unlock_bh(&pool->lock);
+}
+qdf_export_symbol(__qdf_nbuf_rx_pool_deinit);
+
+/**
+ * __qdf_nbuf_rx_pool_alloc() - get a mapped buffer to post to the ring
+ * @pool: pool to take the buffer from
+ *
+ * Return: buffer with its bus address in QDF_NBUF_CB_PADDR, or %NULL
+ */
+struct sk_buff *__qdf_nbuf_rx_pool_alloc(__qdf_nbuf_rx_pool_t *pool)
+{
+	struct sk_buff *skb;
+
+	spin_lock_bh(&pool->lock);
+	skb = __skb_dequeue(&pool->bufs);
+	if (skb)
+		pool->recycled++;
+	spin_unlock_bh(&pool->lock);
+	if (skb)
+		return skb;
+
+	skb = __qdf_nbuf_alloc(pool->osdev, pool->headroom + pool->size, 0, 0,
+			       0, __func__, __LINE__);
+	if (!skb)
+		return NULL;
+
+	if (skb_headroom(skb) > pool->headroom) {
+		__qdf_nbuf_free(skb);
+		return NULL;
+	}
+	skb_reserve(skb, pool->headroom - skb_headroom(skb));
+
+	if (__qdf_nbuf_map_nbytes_single(pool->osdev, skb, QDF_DMA_FROM_DEVICE,
+					 pool->size) != QDF_STATUS_SUCCESS) {
+		__qdf_nbuf_free(skb);
+		return NULL;
+	}
+
+	spin_lock_bh(&pool->lock);
+	pool->mapped++;
+	spin_unlock_bh(&pool->lock);
+
+	return skb;
+}
+qdf_export_symbol(__qdf_nbuf_rx_pool_alloc);
+
+/**
+ * __qdf_nbuf_rx_pool_sync_for_cpu() - make received bytes visible to the CPU
+ * @pool: pool the buffer belongs to
+ * @skb: buffer completed by the target
+ * @nbytes: number of bytes the target wrote, from the start of the mapping
+ *
+ * Return: none
+ */
+void __qdf_nbuf_rx_pool_sync_for_cpu(__qdf_nbuf_rx_pool_t *pool,
+				     struct sk_buff *skb, uint32_t nbytes)
+{
+	__qdf_nbuf_rx_pool_sync(pool, skb, min(nbytes, pool->size), true);
+}
+qdf_export_symbol(__qdf_nbuf_rx_pool_sync_for_cpu);
+
+/**
+ * __qdf_nbuf_rx_pool_put() - recycle a buffer the driver is done with
+ * @pool: pool the buffer belongs to
+ * @skb: buffer, still mapped
+ * @nbytes: bytes from the start of the mapping the CPU may have accessed
+ *
+ * Buffers that were cloned, grew fragments or are referenced elsewhere are
+ * released instead of recycled.
+ *
+ * Return: none
+ */
+void __qdf_nbuf_rx_pool_put(__qdf_nbuf_rx_pool_t *pool,
+			    struct sk_buff *skb, uint32_t nbytes)
+{
+	qdf_dma_addr_t paddr = QDF_NBUF_CB_PADDR(skb);
+
+	if (skb_cloned(skb) || skb_shared(skb) || skb_has_frag_list(skb) ||
+	    skb_shinfo(skb)->nr_frags || skb->destructor ||
+	    skb_queue_len(&pool->bufs) >= pool->max_bufs) {
+		__qdf_nbuf_rx_pool_release(pool, skb);
+		return;
+	}
+
+	/* back to the state __qdf_nbuf_rx_pool_alloc() handed it out in */
+	skb->data = skb->head + pool->headroom;
+	skb->len = 0;
+	skb->data_len = 0;
+	skb_reset_tail_pointer(skb);
+	memset(skb->cb, 0, sizeof(skb->cb));
+	QDF_NBUF_CB_PADDR(skb) = paddr;
+
+	__qdf_nbuf_rx_pool_sync(pool, skb, min(nbytes, pool->size), false);
+
+	spin_lock_bh(&pool->lock);
+	__skb_queue_head(&pool->bufs, skb);
+	spin_unlock_bh(&pool->lock);
+}
+qdf_export_symbol(__qdf_nbuf_rx_pool_put);
+
+/**
+ * __qdf_nbuf_rx_pool_detach() - take a buffer out of the pool for good
+ * @pool: pool the buffer belongs to
+ * @skb: buffer, synced for the CPU
+ *
+ * Called before the buffer is handed to the network stack.
+ *
+ * Return: none
+ */
+void __qdf_nbuf_rx_pool_detach(__qdf_nbuf_rx_pool_t *pool,
+			       struct sk_buff *skb)
+{
+	__qdf_nbuf_rx_pool_unmap(pool, skb);
+	QDF_NBUF_CB_PADDR(skb) = 0;
+}
+qdf_export_symbol(__qdf_nbuf_rx_pool_detach);
+
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3, 10, 0))
 /**
  * qdf_nbuf_update_radiotap_vht_flags() - Update radiotap header VHT flags
@@ -53,7 +53,9 @@ static atomic_t ssr_protect_entry_count;
 
 /**
  * struct ssr_protect - sub system restart(ssr) protection tracking table
- * @func: Function which needs ssr protection
+ * @func: Function which needs ssr protection, an entry is claimed by
+ *	setting it with cmpxchg() so that the data path entry points don't
+ *	serialize on a lock
  * @free: Flag to tell whether entry is free in table or not
  * @pid: Process id which needs ssr protection
  */
@@ -959,27 +961,27 @@ void cds_print_external_threads(void)
 void cds_ssr_protect(const char *caller_func)
 {
 	int count;
-	int i = 0;
+	int i = 0, start;
 	bool status = false;
-	unsigned long irq_flags;
 
 	count = atomic_inc_return(&ssr_protect_entry_count);
 
-	spin_lock_irqsave(&ssr_protect_lock, irq_flags);
-
+	/* start at a CPU specific entry to keep CPUs off each other's lines */
+	start = raw_smp_processor_id() % MAX_SSR_PROTECT_LOG;
 	while (i < MAX_SSR_PROTECT_LOG) {
-		if (ssr_protect_log[i].free) {
-			ssr_protect_log[i].func = caller_func;
-			ssr_protect_log[i].free = false;
-			ssr_protect_log[i].pid = current->pid;
+		struct ssr_protect *entry =
+			&ssr_protect_log[(start + i) % MAX_SSR_PROTECT_LOG];
+
+		if (!READ_ONCE(entry->func) &&
+		    !cmpxchg(&entry->func, NULL, caller_func)) {
+			entry->pid = current->pid;
+			entry->free = false;
 			status = true;
 			break;
 		}
 		i++;
 	}
 
-	spin_unlock_irqrestore(&ssr_protect_lock, irq_flags);
-
 	/*
 	 * Dump the protect log at intervals if count is consistently growing.
 	 * Long running functions should tend to dominate the protect log, so
@@ -1007,28 +1009,28 @@ void cds_ssr_unprotect(const char *caller_func)
 	int count;
 	int i = 0;
 	bool status = false;
-	unsigned long irq_flags;
 
 	count = atomic_dec_return(&ssr_protect_entry_count);
 
-	spin_lock_irqsave(&ssr_protect_lock, irq_flags);
-
+	/*
+	 * Only the owner ever releases an entry, so one that is being
+	 * claimed concurrently can't match current->pid here.
+	 */
 	while (i < MAX_SSR_PROTECT_LOG) {
-		if (!ssr_protect_log[i].free) {
-			if ((ssr_protect_log[i].pid == current->pid) &&
-			     !strcmp(ssr_protect_log[i].func, caller_func)) {
-				ssr_protect_log[i].func = NULL;
-				ssr_protect_log[i].free = true;
-				ssr_protect_log[i].pid =  0;
-				status = true;
-				break;
-			}
+		struct ssr_protect *entry = &ssr_protect_log[i];
+		const char *func = READ_ONCE(entry->func);
+
+		if (func && entry->pid == current->pid &&
+		    !strcmp(func, caller_func)) {
+			entry->free = true;
+			entry->pid =  0;
+			smp_store_release(&entry->func, NULL);
+			status = true;
+			break;
 		}
 		i++;
 	}
 
-	spin_unlock_irqrestore(&ssr_protect_lock, irq_flags);
-
 	if (!status)
 		cds_err("%s was not protected; PID:%d, entry_count:%d",
 			caller_func, current->pid, count);
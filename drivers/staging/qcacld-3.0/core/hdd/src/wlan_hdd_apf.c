@@ -61,6 +61,91 @@ wlan_hdd_apf_offload_policy[APF_MAX + 1] = {
 	[APF_PROG_LEN] = {.type = NLA_U32},
 };
 
+/*
+ * Userspace reinstalls its APF program on every screen or network state
+ * change by disabling the interpreter, rewriting the whole work memory and
+ * enabling it again, even though most of the program stays the same. Keep
+ * a shadow of what was last written to the work memory of each adapter so
+ * that only the bytes that changed are sent to the firmware. The interpreter
+ * disable is held back until a write really changes something, so that an
+ * unchanged program keeps filtering the whole time.
+ *
+ * The shadow is tied to the BSSID it was written for and is dropped once
+ * the adapter is associated elsewhere.
+ */
+static bool apf_incremental = true;
+module_param(apf_incremental, bool, S_IRUSR | S_IWUSR | S_IRGRP);
+
+struct hdd_apf_cache {
+	struct hdd_adapter *adapter;
+	struct qdf_mac_addr bssid;
+	uint8_t *mem;
+	uint32_t valid_len;
+	uint32_t program_len;
+	bool disable_pending;
+};
+
+static struct hdd_apf_cache hdd_apf_cache[WLAN_MAX_VDEVS];
+
+/**
+ * hdd_apf_cache_get() - find or claim the APF cache slot of an adapter
+ * @adapter: HDD adapter
+ * @claim: claim a free slot if the adapter has none yet
+ *
+ * Return: cache slot, NULL if the adapter has none
+ */
+static struct hdd_apf_cache *
+hdd_apf_cache_get(struct hdd_adapter *adapter, bool claim)
+{
+	struct hdd_apf_cache *free_slot = NULL;
+	int i;
+
+	for (i = 0; i < QDF_ARRAY_SIZE(hdd_apf_cache); i++) {
+		if (hdd_apf_cache[i].adapter == adapter)
+			return &hdd_apf_cache[i];
+		if (!free_slot && !hdd_apf_cache[i].adapter)
+			free_slot = &hdd_apf_cache[i];
+	}
+
+	if (!claim || !free_slot)
+		return NULL;
+
+	free_slot->adapter = adapter;
+
+	return free_slot;
+}
+
+/**
+ * hdd_apf_cache_invalidate() - forget the work memory shadow
+ * @cache: cache slot
+ *
+ * Return: None
+ */
+static void hdd_apf_cache_invalidate(struct hdd_apf_cache *cache)
+{
+	cache->valid_len = 0;
+	cache->program_len = 0;
+	qdf_zero_macaddr(&cache->bssid);
+}
+
+/**
+ * hdd_apf_cache_release() - release the APF cache slot of an adapter
+ * @adapter: HDD adapter
+ *
+ * Return: None
+ */
+static void hdd_apf_cache_release(struct hdd_adapter *adapter)
+{
+	struct hdd_apf_cache *cache = hdd_apf_cache_get(adapter, false);
+
+	if (!cache)
+		return;
+
+	if (cache->mem)
+		qdf_mem_free(cache->mem);
+	qdf_mem_zero(cache, sizeof(*cache));
+}
+
 void hdd_apf_context_init(struct hdd_adapter *adapter)
 {
 	qdf_event_create(&adapter->apf_context.qdf_apf_event);
@@ -72,6 +157,7 @@ void hdd_apf_context_destroy(struct hdd_adapter *adapter)
 {
 	qdf_event_destroy(&adapter->apf_context.qdf_apf_event);
 	qdf_spinlock_destroy(&adapter->apf_context.lock);
+	hdd_apf_cache_release(adapter);
 	qdf_mem_zero(&adapter->apf_context,
 		     sizeof(struct hdd_apf_context));
 }
@@ -317,8 +403,29 @@ static int hdd_set_reset_apf_offload(struct hdd_context *hdd_ctx,
 static int
 hdd_enable_disable_apf(struct hdd_adapter *adapter, bool apf_enable)
 {
+	struct hdd_apf_cache *cache = hdd_apf_cache_get(adapter, apf_incremental);
 	QDF_STATUS status;
 
+	if (cache) {
+		/*
+		 * The firmware never saw the disable, so there is nothing
+		 * to enable again. A disable is held back until the first
+		 * write that changes the work memory.
+		 */
+		if (apf_enable && cache->disable_pending) {
+			cache->disable_pending = false;
+			adapter->apf_context.apf_enabled = true;
+			return 0;
+		}
+
+		if (!apf_enable && apf_incremental &&
+		    adapter->apf_context.apf_enabled) {
+			cache->disable_pending = true;
+			adapter->apf_context.apf_enabled = false;
+			return 0;
+		}
+	}
+
 	status = sme_set_apf_enable_disable(hdd_adapter_get_mac_handle(adapter),
 					    adapter->session_id, apf_enable);
 	if (!QDF_IS_STATUS_SUCCESS(status)) {
@@ -332,6 +439,109 @@ hdd_enable_disable_apf(struct hdd_adapter *adapter, bool apf_enable)
 	return 0;
 }
 
+/**
+ * hdd_apf_flush_disable() - send a held back interpreter disable
+ * @adapter: HDD Adapter
+ *
+ * Return: 0 on success, errno on failure
+ */
+static int hdd_apf_flush_disable(struct hdd_adapter *adapter)
+{
+	struct hdd_apf_cache *cache = hdd_apf_cache_get(adapter, false);
+	QDF_STATUS status;
+
+	if (!cache || !cache->disable_pending)
+		return 0;
+
+	status = sme_set_apf_enable_disable(hdd_adapter_get_mac_handle(adapter),
+					    adapter->session_id, false);
+	if (!QDF_IS_STATUS_SUCCESS(status)) {
+		hdd_err("Unable to post sme apf disable message (status-%d)",
+			status);
+		return -EINVAL;
+	}
+	cache->disable_pending = false;
+
+	return 0;
+}
+
+/**
+ * hdd_apf_cache_diff() - trim a work memory write to the bytes that changed
+ * @adapter: HDD Adapter
+ * @params: write to trim, updated in place
+ *
+ * Compares the write against the shadow of the work memory and narrows
+ * @params down to the span between the first and the last changed byte.
+ * The shadow is updated with the new contents.
+ *
+ * Return: false if the write changes nothing and can be skipped
+ */
+static bool hdd_apf_cache_diff(struct hdd_adapter *adapter,
+			       struct wmi_apf_write_memory_params *params)
+{
+	struct hdd_station_ctx *sta_ctx = WLAN_HDD_GET_STATION_CTX_PTR(adapter);
+	struct hdd_apf_cache *cache;
+	uint32_t offset = params->addr_offset;
+	uint32_t len = params->length;
+	uint32_t first, last, known;
+
+	cache = hdd_apf_cache_get(adapter, true);
+	if (!cache)
+		return true;
+
+	if (offset > MAX_APF_MEMORY_LEN ||
+	    len > MAX_APF_MEMORY_LEN - offset) {
+		hdd_apf_cache_invalidate(cache);
+		return true;
+	}
+
+	if (!cache->mem) {
+		cache->mem = qdf_mem_malloc(MAX_APF_MEMORY_LEN);
+		if (!cache->mem)
+			return true;
+	}
+
+	if (!qdf_is_macaddr_equal(&cache->bssid, &sta_ctx->conn_info.bssId)) {
+		hdd_apf_cache_invalidate(cache);
+		qdf_copy_macaddr(&cache->bssid, &sta_ctx->conn_info.bssId);
+	}
+
+	/* bytes past the known part of the shadow always count as changed */
+	known = 0;
+	if (cache->valid_len > offset)
+		known = QDF_MIN(cache->valid_len - offset, len);
+
+	for (first = 0; first < known; first++)
+		if (cache->mem[offset + first] != params->buf[first])
+			break;
+
+	last = len;
+	if (known == len)
+		for (; last > first; last--)
+			if (cache->mem[offset + last - 1] !=
+			    params->buf[last - 1])
+				break;
+
+	qdf_mem_copy(cache->mem + offset, params->buf, len);
+	if (offset <= cache->valid_len)
+		cache->valid_len = QDF_MAX(cache->valid_len, offset + len);
+
+	if (first == last) {
+		if (cache->program_len == params->program_len)
+			return false;
+		/* only the program length moved, resend the last byte */
+		first = len - 1;
+		last = len;
+	}
+	cache->program_len = params->program_len;
+
+	params->addr_offset = offset + first;
+	params->length = last - first;
+	params->buf += first;
+
+	return true;
+}
+
 /**
  * hdd_apf_write_memory - Write into the apf work memory
  * @adapter: HDD Adapter
@@ -348,6 +558,7 @@ hdd_apf_write_memory(struct hdd_adapter *adapter, struct nlattr **tb)
 	struct wmi_apf_write_memory_params write_mem_params = {0};
 	struct hdd_context *hdd_ctx = WLAN_HDD_GET_CTX(adapter);
 	QDF_STATUS status;
+	uint8_t *buf;
 	int ret = 0;
 
 	write_mem_params.vdev_id = adapter->session_id;
@@ -392,6 +603,17 @@ hdd_apf_write_memory(struct hdd_adapter *adapter, struct nlattr **tb)
 		   write_mem_params.length);
 
 	write_mem_params.apf_version = hdd_ctx->apf_version;
+	buf = write_mem_params.buf;
+
+	if (apf_incremental &&
+	    !hdd_apf_cache_diff(adapter, &write_mem_params)) {
+		hdd_debug("APF work memory unchanged, write skipped");
+		goto out;
+	}
+
+	ret = hdd_apf_flush_disable(adapter);
+	if (ret)
+		goto out;
 
 	status = sme_apf_write_work_memory(hdd_adapter_get_mac_handle(adapter),
 					   &write_mem_params);
@@ -400,8 +622,15 @@ hdd_apf_write_memory(struct hdd_adapter *adapter, struct nlattr **tb)
 		ret = -EINVAL;
 	}
 
-	if (write_mem_params.buf)
-		qdf_mem_free(write_mem_params.buf);
+out:
+	if (ret) {
+		struct hdd_apf_cache *cache = hdd_apf_cache_get(adapter, false);
+
+		if (cache)
+			hdd_apf_cache_invalidate(cache);
+	}
+
+	qdf_mem_free(buf);
 
 	return ret;
 }
@@ -499,6 +728,11 @@ static int hdd_apf_read_memory(struct hdd_adapter *adapter, struct nlattr **tb)
 
 	read_mem_params.vdev_id = adapter->session_id;
 
+	/* the firmware only reads back memory of a stopped interpreter */
+	ret = hdd_apf_flush_disable(adapter);
+	if (ret)
+		return ret;
+
 	/* Read APF work memory offset */
 	if (!tb[APF_CURRENT_OFFSET]) {
 		hdd_err("attr apf memory offset failed");
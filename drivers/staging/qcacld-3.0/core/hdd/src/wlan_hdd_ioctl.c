@@ -5146,6 +5146,97 @@ static int drv_cmd_bt_coex_mode(struct hdd_adapter *adapter,
 	return ret;
 }
 
+/*
+ * BT profiles reported by SETBTPROFILE. While BT audio is streaming the
+ * firmware hands the medium to BT at a fixed period, and long A-MPDUs
+ * run into the BT slots and get retried as a whole. Shorter A-MPDUs fit
+ * into the WLAN slots and keep the throughput up.
+ */
+#define HDD_BT_PROFILE_A2DP		BIT(0)
+#define HDD_BT_PROFILE_LE_AUDIO		BIT(1)
+#define HDD_BT_PROFILE_SCO		BIT(2)
+#define HDD_BT_PROFILE_STREAMING	(HDD_BT_PROFILE_A2DP | \
+					 HDD_BT_PROFILE_LE_AUDIO)
+#define HDD_BT_STREAMING_TX_AGGR_SIZE	16
+
+static uint32_t hdd_bt_profiles;
+
+/**
+ * hdd_bt_profile_set_aggr() - size the A-MPDUs of an adapter for BT coex
+ * @adapter: STA adapter
+ * @hdd_ctx: HDD context
+ * @streaming: BT audio is streaming
+ *
+ * Return: 0 on success, errno on failure
+ */
+static int hdd_bt_profile_set_aggr(struct hdd_adapter *adapter,
+				   struct hdd_context *hdd_ctx,
+				   bool streaming)
+{
+	struct sir_set_tx_rx_aggregation_size request = {0};
+	QDF_STATUS status;
+
+	request.vdev_id = adapter->session_id;
+	request.aggr_type = WMI_VDEV_CUSTOM_AGGR_TYPE_AMPDU;
+	request.tx_aggregation_size = hdd_ctx->config->tx_aggregation_size;
+	request.rx_aggregation_size = hdd_ctx->config->rx_aggregation_size;
+	if (streaming)
+		request.tx_aggregation_size =
+			QDF_MIN(request.tx_aggregation_size,
+				HDD_BT_STREAMING_TX_AGGR_SIZE);
+
+	status = wma_set_tx_rx_aggregation_size(&request);
+	if (QDF_IS_STATUS_ERROR(status)) {
+		hdd_err("failed to set aggr sizes err %d", status);
+		return -EPERM;
+	}
+
+	return 0;
+}
+
+static int drv_cmd_set_bt_profile(struct hdd_adapter *adapter,
+				  struct hdd_context *hdd_ctx,
+				  uint8_t *command,
+				  uint8_t command_len,
+				  struct hdd_priv_data *priv_data)
+{
+	uint32_t profiles;
+	bool was_streaming, streaming;
+	int ret;
+
+	ret = kstrtou32(command + command_len + 1, 0, &profiles);
+	if (ret) {
+		hdd_err("Invalid SETBTPROFILE command");
+		return ret;
+	}
+
+	was_streaming = hdd_bt_profiles & HDD_BT_PROFILE_STREAMING;
+	streaming = profiles & HDD_BT_PROFILE_STREAMING;
+	hdd_debug("BT profiles 0x%x -> 0x%x", hdd_bt_profiles, profiles);
+	hdd_bt_profiles = profiles;
+
+	/* voice calls are latency bound, keep scans out of their way */
+	hdd_ctx->bt_coex_mode_set = profiles & HDD_BT_PROFILE_SCO;
+	if (hdd_ctx->bt_coex_mode_set)
+		wlan_hdd_scan_abort(adapter);
+
+	if (was_streaming == streaming)
+		return 0;
+
+	hdd_for_each_adapter(hdd_ctx, adapter) {
+		if (adapter->device_mode != QDF_STA_MODE ||
+		    !hdd_conn_is_connected(
+				WLAN_HDD_GET_STATION_CTX_PTR(adapter)))
+			continue;
+
+		ret = hdd_bt_profile_set_aggr(adapter, hdd_ctx, streaming);
+		if (ret)
+			break;
+	}
+
+	return ret;
+}
+
 static int drv_cmd_scan_active(struct hdd_adapter *adapter,
 			       struct hdd_context *hdd_ctx,
 			       uint8_t *command,
@@ -8121,6 +8212,7 @@ static const struct hdd_drv_cmd hdd_drv_cmds[] = {
 	{"SETOKCMODE",                drv_cmd_set_okc_mode, true},
 	{"GETROAMSCANCONTROL",        drv_cmd_get_roam_scan_control, false},
 	{"BTCOEXMODE",                drv_cmd_bt_coex_mode, true},
+	{"SETBTPROFILE",              drv_cmd_set_bt_profile, true},
 	{"SCAN-ACTIVE",               drv_cmd_scan_active, false},
 	{"SCAN-PASSIVE",              drv_cmd_scan_passive, false},
 	{"CONCSETDWELLTIME",          drv_cmd_conc_set_dwell_time, true},
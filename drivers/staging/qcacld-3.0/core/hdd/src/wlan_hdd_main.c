@@ -207,6 +207,28 @@ static int enable_11d = -1;
 static int enable_dfs_chan_scan = -1;
 static bool is_mode_change_psoc_idle_shutdown;
 
+/*
+ * Warm restart: once the psoc idle timer expires, keep the modules, rings
+ * and firmware up for up to warm_restart_hold_ms more, as long as at least
+ * warm_restart_free_mb of memory is available, so that turning wlan back on
+ * only has to bring up the interfaces. 0 MB disables it, 0 ms holds for as
+ * long as memory allows.
+ */
+#define HDD_WARM_RESTART_RECHECK_MS 10000
+static unsigned int warm_restart_free_mb;
+static unsigned int warm_restart_hold_ms = 30 * 60 * 1000;
+static unsigned long warm_restart_since;
+
+#ifdef MSM_PLATFORM
+/*
+ * Bus bandwidth tier hysteresis: a tier is only left downwards once the
+ * packet count stayed bus_bw_hyst_pct percent below its entry threshold for
+ * bus_bw_down_intervals consecutive compute intervals.
+ */
+static unsigned int bus_bw_down_intervals = 3;
+static unsigned int bus_bw_hyst_pct = 20;
+#endif
+
 /*
  * spinlock for synchronizing asynchronous request/response
  * (full description of use in wlan_hdd_main.h)
@@ -8735,6 +8757,80 @@ static void hdd_clear_rps_cpu_mask(struct hdd_context *hdd_ctx)
 		hdd_send_rps_disable_ind(adapter);
 }
 
+/**
+ * hdd_bus_bw_tier_threshold() - packets per interval to enter a tier
+ * @hdd_ctx: handle to hdd context
+ * @level: bus bandwidth tier
+ *
+ * Return: entry threshold of @level, 0 for PLD_BUS_WIDTH_NONE
+ */
+static uint64_t hdd_bus_bw_tier_threshold(struct hdd_context *hdd_ctx,
+					  enum pld_bus_width_type level)
+{
+	switch (level) {
+	case PLD_BUS_WIDTH_HIGH:
+		return hdd_ctx->config->busBandwidthHighThreshold;
+	case PLD_BUS_WIDTH_MEDIUM:
+		return hdd_ctx->config->busBandwidthMediumThreshold;
+	case PLD_BUS_WIDTH_LOW:
+		return hdd_ctx->config->busBandwidthLowThreshold;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * hdd_bus_bw_next_level() - pick the throughput tier for the next interval
+ * @hdd_ctx: handle to hdd context
+ * @total_pkts: tx + rx packets in the last interval
+ *
+ * Moving to a higher tier happens in the interval the load shows up, so a
+ * ramping transfer gets the bus, CPU and NAPI votes it needs right away.
+ * Moving down waits for the load to stay clearly below the entry threshold
+ * of the current tier for bus_bw_down_intervals intervals, which keeps a
+ * transfer that hovers around a threshold from flapping between tiers. Once
+ * traffic stops altogether all votes are dropped without waiting.
+ *
+ * Return: next bus bandwidth tier
+ */
+static enum pld_bus_width_type
+hdd_bus_bw_next_level(struct hdd_context *hdd_ctx, uint64_t total_pkts)
+{
+	static unsigned int down_cnt;
+	enum pld_bus_width_type level, cur = hdd_ctx->cur_vote_level;
+	uint64_t floor;
+
+	if (total_pkts > hdd_ctx->config->busBandwidthHighThreshold)
+		level = PLD_BUS_WIDTH_HIGH;
+	else if (total_pkts > hdd_ctx->config->busBandwidthMediumThreshold)
+		level = PLD_BUS_WIDTH_MEDIUM;
+	else if (total_pkts > hdd_ctx->config->busBandwidthLowThreshold)
+		level = PLD_BUS_WIDTH_LOW;
+	else
+		level = PLD_BUS_WIDTH_NONE;
+
+	/* cur_vote_level is -1 when a re-evaluation was forced */
+	if (hdd_ctx->cur_vote_level < 0 || level >= cur ||
+	    level == PLD_BUS_WIDTH_NONE) {
+		down_cnt = 0;
+		return level;
+	}
+
+	floor = hdd_bus_bw_tier_threshold(hdd_ctx, cur);
+	floor -= floor * min(bus_bw_hyst_pct, 100U) / 100;
+	if (total_pkts > floor) {
+		down_cnt = 0;
+		return cur;
+	}
+
+	if (++down_cnt < bus_bw_down_intervals)
+		return cur;
+
+	/* step down one tier at a time, the next one is re-checked */
+	down_cnt = 0;
+	return cur - 1;
+}
+
 #ifdef CLD_PM_QOS
 #define PLD_REMOVE_PM_QOS(x)
 #define PLD_REQUEST_PM_QOS(x, y)
@@ -8869,14 +8965,7 @@ static void hdd_pld_request_bus_bandwidth(struct hdd_context *hdd_ctx,
 	bool enable_pm_qos_high = false;
 
 	cpumask_clear(&pm_qos_cpu_mask);
-	if (total_pkts > hdd_ctx->config->busBandwidthHighThreshold)
-		next_vote_level = PLD_BUS_WIDTH_HIGH;
-	else if (total_pkts > hdd_ctx->config->busBandwidthMediumThreshold)
-		next_vote_level = PLD_BUS_WIDTH_MEDIUM;
-	else if (total_pkts > hdd_ctx->config->busBandwidthLowThreshold)
-		next_vote_level = PLD_BUS_WIDTH_LOW;
-	else
-		next_vote_level = PLD_BUS_WIDTH_NONE;
+	next_vote_level = hdd_bus_bw_next_level(hdd_ctx, total_pkts);
 
 	dptrace_high_tput_req =
 			next_vote_level > PLD_BUS_WIDTH_NONE ? true : false;
@@ -9337,6 +9426,8 @@ void wlan_hdd_display_tx_rx_histogram(struct hdd_context *hdd_ctx)
 					hdd_ctx->hdd_txrx_hist[i].
 						next_tx_level));
 	}
+
+	hdd_display_rx_wake_sources();
 }
 
 /**
@@ -9350,6 +9441,7 @@ void wlan_hdd_clear_tx_rx_histogram(struct hdd_context *hdd_ctx)
 	hdd_ctx->hdd_txrx_hist_idx = 0;
 	qdf_mem_zero(hdd_ctx->hdd_txrx_hist,
 		(sizeof(struct hdd_tx_rx_histogram) * NUM_TX_RX_HISTOGRAM));
+	hdd_clear_rx_wake_sources();
 }
 
 /* length of the netif queue log needed per adapter */
@@ -10479,6 +10571,46 @@ static int hdd_mode_change_psoc_idle_restart(struct device *dev)
 	return hdd_wlan_start_modules(hdd_ctx, false);
 }
 
+/**
+ * hdd_warm_restart_hold() - keep the psoc up after the idle timeout
+ * @hdd_ctx: pointer to hdd context
+ *
+ * Re-arms the idle work to check again later if the modules can stay up.
+ * No wakelock is held meanwhile; the enabled modules go through the regular
+ * suspend path like they do with interfaces up.
+ *
+ * Return: true if the shutdown is to be held back
+ */
+static bool hdd_warm_restart_hold(struct hdd_context *hdd_ctx)
+{
+	unsigned long avail_mb;
+
+	if (!warm_restart_free_mb)
+		return false;
+
+	if (!warm_restart_since)
+		warm_restart_since = qdf_system_ticks();
+
+	if (warm_restart_hold_ms &&
+	    qdf_system_ticks_to_msecs(qdf_system_ticks() -
+				      warm_restart_since) >= warm_restart_hold_ms)
+		return false;
+
+	avail_mb = si_mem_available() >> (20 - PAGE_SHIFT);
+	if (avail_mb < warm_restart_free_mb) {
+		hdd_info("Only %lu MB available, ending warm restart hold",
+			 avail_mb);
+		return false;
+	}
+
+	hdd_debug("Keeping psoc up for warm restart, %lu MB available",
+		  avail_mb);
+	qdf_sched_delayed_work(&hdd_ctx->psoc_idle_timeout_work,
+			       HDD_WARM_RESTART_RECHECK_MS);
+
+	return true;
+}
+
 /**
  * hdd_psoc_idle_timeout_callback() - Handler for psoc idle timeout
  * @priv: pointer to hdd context
@@ -10492,6 +10624,9 @@ static void hdd_psoc_idle_timeout_callback(void *priv)
 	if (wlan_hdd_validate_context(hdd_ctx))
 		return;
 
+	if (hdd_warm_restart_hold(hdd_ctx))
+		return;
+
 	hdd_info("Psoc idle timeout elapsed; starting psoc shutdown");
 
 	pld_idle_shutdown(hdd_ctx->parent_dev, hdd_psoc_idle_shutdown);
@@ -10565,6 +10700,8 @@ void hdd_psoc_idle_timer_start(struct hdd_context *hdd_ctx)
 	enum wake_lock_reason reason =
 		WIFI_POWER_EVENT_WAKELOCK_IFACE_CHANGE_TIMER;
 
+	warm_restart_since = 0;
+
 	if (!timeout_ms) {
 		hdd_info("psoc idle timer is disabled");
 		return;
@@ -10578,6 +10715,7 @@ void hdd_psoc_idle_timer_start(struct hdd_context *hdd_ctx)
 void hdd_psoc_idle_timer_stop(struct hdd_context *hdd_ctx)
 {
 	qdf_cancel_delayed_work(&hdd_ctx->psoc_idle_timeout_work);
+	warm_restart_since = 0;
 	hdd_debug("Stopped psoc idle timer");
 }
 
@@ -16729,3 +16867,11 @@ module_param(enable_dfs_chan_scan, int, S_IRUSR | S_IRGRP | S_IROTH);
 module_param(enable_11d, int, S_IRUSR | S_IRGRP | S_IROTH);
 
 module_param(country_code, charp, S_IRUSR | S_IRGRP | S_IROTH);
+
+#ifdef MSM_PLATFORM
+module_param(bus_bw_down_intervals, uint, S_IRUSR | S_IWUSR | S_IRGRP);
+module_param(bus_bw_hyst_pct, uint, S_IRUSR | S_IWUSR | S_IRGRP);
+#endif
+
+module_param(warm_restart_free_mb, uint, S_IRUSR | S_IWUSR | S_IRGRP);
+module_param(warm_restart_hold_ms, uint, S_IRUSR | S_IWUSR | S_IRGRP);
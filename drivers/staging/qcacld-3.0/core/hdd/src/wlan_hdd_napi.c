@@ -336,14 +336,15 @@ static int hdd_napi_perfd_cpufreq(enum qca_napi_tput_state req_state)
  * event handler to switch to the desired state.
  *
  * The policy implementation is limited to this function and
- * The current policy is: determine the NAPI mode based on the condition:
- *      (total number of packets > medium threshold)
- * - tx packets are included because:
+ * The current policy is: NAPI runs in HI mode while the bus bandwidth tier
+ * picked by hdd_pld_request_bus_bandwidth for this interval is
+ * PLD_BUS_WIDTH_HIGH. The tier is taken over rather than recomputed from the
+ * packet counts so that the NAPI placement, the rx thread affinity and the
+ * PM QoS and bus votes follow the same hysteresis and change together.
+ * - tx packets are included in the tier because:
  *   a- tx-completions arrive at one of the rx CEs
  *   b- in TCP, a lof of TX implies ~(tx/2) rx (ACKs)
  *   c- so that we can use the same normalized criteria in ini file
- * - medium-threshold (default: 500 packets / 10 ms), because
- *   we would like to be more reactive.
  *
  * Return: 0 : no action taken, or action return code
  *         !0: error, or action error code
@@ -354,7 +355,6 @@ int hdd_napi_apply_throughput_policy(struct hdd_context *hddctx,
 				     uint64_t rx_packets)
 {
 	int rc = 0;
-	uint64_t packets = tx_packets + rx_packets;
 	enum qca_napi_tput_state req_state;
 	struct qca_napi_data *napid = hdd_napi_get_all();
 	int enabled;
@@ -385,7 +385,7 @@ int hdd_napi_apply_throughput_policy(struct hdd_context *hddctx,
 		return rc;
 	}
 
-	if (packets > hddctx->config->busBandwidthHighThreshold)
+	if (hddctx->cur_vote_level >= PLD_BUS_WIDTH_HIGH)
 		req_state = QCA_NAPI_TPUT_HI;
 	else
 		req_state = QCA_NAPI_TPUT_LO;
@@ -27,6 +27,41 @@
 #include "wlan_hdd_packet_filter_api.h"
 #include "wlan_hdd_packet_filter_rules.h"
 
+/*
+ * Broadcast and multicast frames that make it past the default filters are
+ * buffered by the firmware and delivered together once this much time has
+ * passed since the first one, so that background traffic such as mDNS or
+ * SSDP wakes the host once per window instead of once per frame. ARP is
+ * left out as requests for our address need a timely answer.
+ */
+#define HDD_PKT_FILTER_COALESCE_MS 1000
+
+static struct pkt_filter_cfg hdd_coalesce_filter_rule = {
+	.filter_action = HDD_RCV_FILTER_SET,
+	.num_params = 2,
+	.params_data = {
+		{
+			.protocol_layer = HDD_FILTER_PROTO_TYPE_MAC,
+			.compare_flag = HDD_FILTER_CMP_TYPE_MASK_EQUAL,
+			.data_offset = 0,
+			.data_length = 1,
+			.compare_data = {0x01},
+			.data_mask = {0x01},
+		},
+		{
+			.protocol_layer = HDD_FILTER_PROTO_TYPE_MAC,
+			.compare_flag = HDD_FILTER_CMP_TYPE_NOT_EQUAL,
+			.data_offset = 12,
+			.data_length = 2,
+			.compare_data = {0x08, 0x06},
+		},
+	},
+};
+
+static int __wlan_hdd_set_filter(struct hdd_context *hdd_ctx,
+				 struct pkt_filter_cfg *request,
+				 uint8_t sessionId, uint32_t coalesce_time);
+
 int hdd_enable_default_pkt_filters(struct hdd_adapter *adapter)
 {
 	struct hdd_context *hdd_ctx;
@@ -58,6 +93,11 @@ int hdd_enable_default_pkt_filters(struct hdd_adapter *adapter)
 		i++;
 	}
 
+	/* the coalescing rule takes the id after the default ones */
+	hdd_coalesce_filter_rule.filter_id = filter_id;
+	__wlan_hdd_set_filter(hdd_ctx, &hdd_coalesce_filter_rule,
+			      adapter->session_id, HDD_PKT_FILTER_COALESCE_MS);
+
 	return 0;
 }
 
@@ -97,12 +137,27 @@ int hdd_disable_default_pkt_filters(struct hdd_adapter *adapter)
 		i++;
 	}
 
+	packet_filter_default_rules.filter_action = HDD_RCV_FILTER_CLEAR;
+	packet_filter_default_rules.filter_id = filter_id;
+	wlan_hdd_set_filter(hdd_ctx, &packet_filter_default_rules,
+			    adapter->session_id);
+
 	return 0;
 }
 
-int wlan_hdd_set_filter(struct hdd_context *hdd_ctx,
-				struct pkt_filter_cfg *request,
-				uint8_t sessionId)
+/**
+ * __wlan_hdd_set_filter() - set or clear a packet filter
+ * @hdd_ctx: HDD context
+ * @request: filter to set or clear
+ * @sessionId: session the filter applies to
+ * @coalesce_time: non-zero to have the firmware buffer the matching frames
+ *	for that many milliseconds instead of dropping them
+ *
+ * Return: 0 on success, error code otherwise
+ */
+static int __wlan_hdd_set_filter(struct hdd_context *hdd_ctx,
+				 struct pkt_filter_cfg *request,
+				 uint8_t sessionId, uint32_t coalesce_time)
 {
 	struct pmo_rcv_pkt_fltr_cfg *pmo_set_pkt_fltr_req = NULL;
 	struct pmo_rcv_pkt_fltr_clear_param *pmo_clr_pkt_fltr_param = NULL;
@@ -138,8 +193,10 @@ int wlan_hdd_set_filter(struct hdd_context *hdd_ctx,
 			goto out;
 		}
 		pmo_set_pkt_fltr_req->num_params = request->num_params;
-		pmo_set_pkt_fltr_req->coalesce_time = 0;
-		pmo_set_pkt_fltr_req->filter_type = PMO_RCV_FILTER_TYPE_FILTER_PKT;
+		pmo_set_pkt_fltr_req->coalesce_time = coalesce_time;
+		pmo_set_pkt_fltr_req->filter_type = coalesce_time ?
+					PMO_RCV_FILTER_TYPE_BUFFER_PKT :
+					PMO_RCV_FILTER_TYPE_FILTER_PKT;
 		for (i = 0; i < request->num_params; i++) {
 			pmo_set_pkt_fltr_req->params_data[i].protocol_layer =
 				request->params_data[i].protocol_layer;
@@ -259,3 +316,10 @@ int wlan_hdd_set_filter(struct hdd_context *hdd_ctx,
 
 	return status;
 }
+
+int wlan_hdd_set_filter(struct hdd_context *hdd_ctx,
+				struct pkt_filter_cfg *request,
+				uint8_t sessionId)
+{
+	return __wlan_hdd_set_filter(hdd_ctx, request, sessionId, 0);
+}
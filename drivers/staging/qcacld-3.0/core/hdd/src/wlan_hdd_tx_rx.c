@@ -33,6 +33,8 @@
 #include <linux/etherdevice.h>
 #include <linux/if_ether.h>
 #include <linux/inetdevice.h>
+#include <linux/kernel_stat.h>
+#include <linux/udp.h>
 #include <cds_sched.h>
 #include <cds_utils.h>
 
@@ -279,6 +281,50 @@ void hdd_deregister_tx_flow_control(struct hdd_adapter *adapter)
 	}
 }
 
+/*
+ * Asking the txrx layer for free descriptors takes its descriptor pool lock,
+ * which tx completion on other CPUs contends for. The low watermark leaves
+ * enough headroom to only ask for every HDD_TX_RESOURCE_CHECK_PKTS frames an
+ * adapter sends from a CPU.
+ */
+#define HDD_TX_RESOURCE_CHECK_PKTS 8
+
+/**
+ * struct hdd_tx_resource_check - per CPU tx resource check state
+ * @adapter: adapter that sent the last frame on this CPU
+ * @cnt: frames sent since the pool was last checked for @adapter
+ */
+struct hdd_tx_resource_check {
+	struct hdd_adapter *adapter;
+	unsigned int cnt;
+};
+
+static DEFINE_PER_CPU(struct hdd_tx_resource_check, hdd_tx_resource_check);
+
+/**
+ * hdd_tx_resource_check_due() - check whether the tx pool must be queried
+ * @adapter: adapter handle
+ *
+ * Return: true for the first frame of @adapter in a batch
+ */
+static bool hdd_tx_resource_check_due(struct hdd_adapter *adapter)
+{
+	struct hdd_tx_resource_check *check;
+	bool due;
+
+	check = get_cpu_ptr(&hdd_tx_resource_check);
+	if (check->adapter != adapter) {
+		check->adapter = adapter;
+		check->cnt = 0;
+	}
+	due = !check->cnt;
+	if (++check->cnt == HDD_TX_RESOURCE_CHECK_PKTS)
+		check->cnt = 0;
+	put_cpu_ptr(&hdd_tx_resource_check);
+
+	return due;
+}
+
 /**
  * hdd_get_tx_resource() - check tx resources and take action
  * @adapter: adapter handle
@@ -290,6 +336,9 @@ void hdd_deregister_tx_flow_control(struct hdd_adapter *adapter)
 void hdd_get_tx_resource(struct hdd_adapter *adapter,
 			uint8_t STAId, uint16_t timer_value)
 {
+	if (!hdd_tx_resource_check_due(adapter))
+		return;
+
 	if (false ==
 	    cdp_fc_get_tx_resource(cds_get_context(QDF_MODULE_ID_SOC), STAId,
 				   adapter->tx_flow_low_watermark,
@@ -1453,6 +1502,134 @@ static bool hdd_is_rx_wake_lock_needed(struct sk_buff *skb)
 	return false;
 }
 
+/*
+ * Rx wakelock holds are accounted per peer, ethertype, IP protocol and
+ * destination port. Only the busiest HDD_RX_WAKE_SOURCES are kept: a new
+ * source takes over the least counted entry and inherits its count, so the
+ * counts are upper bounds but the heavy hitters always stay in the table.
+ */
+#define HDD_RX_WAKE_SOURCES 16
+
+struct hdd_rx_wake_source {
+	struct qdf_mac_addr peer;
+	uint16_t ether_type;
+	uint16_t port;
+	uint8_t proto;
+	uint32_t count;
+};
+
+static struct hdd_rx_wake_source hdd_rx_wake_sources[HDD_RX_WAKE_SOURCES];
+static DEFINE_SPINLOCK(hdd_rx_wake_sources_lock);
+
+/**
+ * hdd_rx_wake_source_key() - fill in the wake source of a packet
+ * @skb: pointer to sk_buff, past eth_type_trans()
+ * @src: wake source to fill in
+ *
+ * Return: None
+ */
+static void hdd_rx_wake_source_key(struct sk_buff *skb,
+				   struct hdd_rx_wake_source *src)
+{
+	unsigned int l4_off = 0;
+	struct udphdr *uh;
+
+	qdf_mem_copy(src->peer.bytes, eth_hdr(skb)->h_source,
+		     QDF_MAC_ADDR_SIZE);
+	src->ether_type = ntohs(skb->protocol);
+	src->proto = 0;
+	src->port = 0;
+
+	if (skb->protocol == htons(ETH_P_IP) &&
+	    skb_headlen(skb) >= sizeof(struct iphdr)) {
+		struct iphdr *iph = (struct iphdr *)skb->data;
+
+		src->proto = iph->protocol;
+		l4_off = iph->ihl * 4;
+	} else if (skb->protocol == htons(ETH_P_IPV6) &&
+		   skb_headlen(skb) >= sizeof(struct ipv6hdr)) {
+		struct ipv6hdr *ip6h = (struct ipv6hdr *)skb->data;
+
+		src->proto = ip6h->nexthdr;
+		l4_off = sizeof(*ip6h);
+	}
+
+	/* tcp and udp both start with the source and destination ports */
+	if ((src->proto == IPPROTO_TCP || src->proto == IPPROTO_UDP) &&
+	    skb_headlen(skb) >= l4_off + sizeof(*uh)) {
+		uh = (struct udphdr *)(skb->data + l4_off);
+		src->port = ntohs(uh->dest);
+	}
+}
+
+/**
+ * hdd_rx_wake_source_account() - account an rx wakelock hold
+ * @skb: pointer to sk_buff, past eth_type_trans()
+ *
+ * Return: None
+ */
+static void hdd_rx_wake_source_account(struct sk_buff *skb)
+{
+	struct hdd_rx_wake_source key, *src, *min = NULL;
+	int i;
+
+	hdd_rx_wake_source_key(skb, &key);
+
+	spin_lock_bh(&hdd_rx_wake_sources_lock);
+	for (i = 0; i < HDD_RX_WAKE_SOURCES; i++) {
+		src = &hdd_rx_wake_sources[i];
+		if (src->count && src->ether_type == key.ether_type &&
+		    src->proto == key.proto && src->port == key.port &&
+		    qdf_is_macaddr_equal(&src->peer, &key.peer)) {
+			src->count++;
+			goto unlock;
+		}
+		if (!min || src->count < min->count)
+			min = src;
+	}
+
+	key.count = min->count + 1;
+	*min = key;
+unlock:
+	spin_unlock_bh(&hdd_rx_wake_sources_lock);
+}
+
+/**
+ * hdd_display_rx_wake_sources() - display the rx wakelock sources
+ *
+ * Return: None
+ */
+void hdd_display_rx_wake_sources(void)
+{
+	struct hdd_rx_wake_source *src;
+	int i;
+
+	hdd_debug("Rx wake sources: [peer] ethertype, proto, port: count");
+
+	spin_lock_bh(&hdd_rx_wake_sources_lock);
+	for (i = 0; i < HDD_RX_WAKE_SOURCES; i++) {
+		src = &hdd_rx_wake_sources[i];
+		if (src->count)
+			hdd_debug("[" QDF_MAC_ADDR_STR "] 0x%04x, %u, %u: %u",
+				  QDF_MAC_ADDR_ARRAY(src->peer.bytes),
+				  src->ether_type, src->proto, src->port,
+				  src->count);
+	}
+	spin_unlock_bh(&hdd_rx_wake_sources_lock);
+}
+
+/**
+ * hdd_clear_rx_wake_sources() - clear the rx wakelock sources
+ *
+ * Return: None
+ */
+void hdd_clear_rx_wake_sources(void)
+{
+	spin_lock_bh(&hdd_rx_wake_sources_lock);
+	qdf_mem_zero(hdd_rx_wake_sources, sizeof(hdd_rx_wake_sources));
+	spin_unlock_bh(&hdd_rx_wake_sources_lock);
+}
+
 #ifdef RECEIVE_OFFLOAD
 /**
  * hdd_resolve_rx_ol_mode() - Resolve Rx offload method, LRO or GRO
@@ -1462,6 +1639,18 @@ static bool hdd_is_rx_wake_lock_needed(struct sk_buff *skb)
  */
 static void hdd_resolve_rx_ol_mode(struct hdd_context *hdd_ctx)
 {
+	/*
+	 * Without the rx thread, GRO runs right in the CE NAPI poll and is
+	 * flushed once per poll, which covers what the software LRO does and
+	 * coalesces UDP as well. LRO is only kept for the other rx modes.
+	 */
+	if ((hdd_ctx->config->lro_enable || hdd_ctx->config->gro_enable) &&
+	    hdd_ctx->napi_enable && !hdd_ctx->enable_rxthread) {
+		hdd_debug("Rx offload GRO is enabled in NAPI context");
+		hdd_ctx->ol_enable = CFG_GRO_ENABLED;
+		return;
+	}
+
 	if (!(hdd_ctx->config->lro_enable ^
 	    hdd_ctx->config->gro_enable)) {
 #ifdef WLAN_DEBUG
@@ -1520,9 +1709,14 @@ static QDF_STATUS hdd_gro_rx(struct hdd_adapter *adapter, struct sk_buff *skb)
 	else
 		napi_to_use = &qca_napii->napi;
 
-	local_bh_disable();
-	napi_gro_receive(napi_to_use, skb);
-	local_bh_enable();
+	/* bottom halves are already off when called from the NAPI poll */
+	if (in_serving_softirq()) {
+		napi_gro_receive(napi_to_use, skb);
+	} else {
+		local_bh_disable();
+		napi_gro_receive(napi_to_use, skb);
+		local_bh_enable();
+	}
 
 	status = QDF_STATUS_SUCCESS;
 out:
@@ -1696,6 +1890,25 @@ void hdd_disable_rx_ol_for_low_tput(struct hdd_context *hdd_ctx, bool disable)
 		qdf_atomic_set(&hdd_ctx->disable_lro_in_low_tput, 0);
 }
 
+/**
+ * hdd_rx_is_udp() - Check whether a frame carries a UDP datagram
+ * @skb: pointer to sk_buff with the data at the network header
+ *
+ * Return: true for IPv4 and IPv6 UDP frames
+ */
+static bool hdd_rx_is_udp(struct sk_buff *skb)
+{
+	if (skb->protocol == htons(ETH_P_IP))
+		return pskb_may_pull(skb, sizeof(struct iphdr)) &&
+		       ((struct iphdr *)skb->data)->protocol == IPPROTO_UDP;
+
+	if (skb->protocol == htons(ETH_P_IPV6))
+		return pskb_may_pull(skb, sizeof(struct ipv6hdr)) &&
+		       ((struct ipv6hdr *)skb->data)->nexthdr == IPPROTO_UDP;
+
+	return false;
+}
+
 /**
  * hdd_can_handle_receive_offload() - Check for dynamic disablement
  * @hdd_ctx: hdd context
@@ -1711,7 +1924,17 @@ static bool hdd_can_handle_receive_offload(struct hdd_context *hdd_ctx,
 	if (!hdd_ctx->receive_offload_cb)
 		return false;
 
-	if (!QDF_NBUF_CB_RX_TCP_PROTO(skb) ||
+	/*
+	 * The GRO list of the CE NAPI instance may only be used from its own
+	 * poll, frames deferred to the rx thread are delivered without it.
+	 */
+	if (!hdd_ctx->enable_rxthread && !in_serving_softirq())
+		return false;
+
+	/* Unlike LRO, the GRO handler of the stack also coalesces UDP */
+	if (!(QDF_NBUF_CB_RX_TCP_PROTO(skb) ||
+	      (hdd_ctx->receive_offload_cb == hdd_gro_rx &&
+	       hdd_rx_is_udp(skb))) ||
 	    qdf_atomic_read(&hdd_ctx->disable_lro_in_concurrency) ||
 	    QDF_NBUF_CB_RX_PEER_CACHED_FRM(skb) ||
 	    qdf_atomic_read(&hdd_ctx->disable_lro_in_low_tput))
@@ -1741,6 +1964,137 @@ void hdd_disable_rx_ol_for_low_tput(struct hdd_context *hdd_ctx, bool disable)
 }
 #endif /* RECEIVE_OFFLOAD */
 
+#if defined(RECEIVE_OFFLOAD) && defined(QCA_CONFIG_SMP)
+/*
+ * In NAPI GRO mode all rx processing happens in the CE NAPI poll. If that
+ * keeps the CPU in softirq for HDD_RX_OVERLOAD_ENTER_CNT samples in a row,
+ * rx chains are handed to the cds rx thread instead, so that the rest of
+ * the stack runs on another core, until the softirq load stayed low for
+ * HDD_RX_OVERLOAD_EXIT_CNT samples.
+ */
+#define HDD_RX_OVERLOAD_SAMPLE_MS	100
+#define HDD_RX_OVERLOAD_ENTER_PCT	90
+#define HDD_RX_OVERLOAD_EXIT_PCT	50
+#define HDD_RX_OVERLOAD_ENTER_CNT	3
+#define HDD_RX_OVERLOAD_EXIT_CNT	10
+
+/**
+ * struct hdd_rx_overload - softirq load of one rx CPU
+ * @next_sample: jiffies of the next sample
+ * @softirq_ns: softirq time of the CPU at the last sample
+ * @clock_ns: local_clock() at the last sample
+ * @cnt: consecutive samples past the threshold of the current state
+ * @active: rx chains are deferred to the rx thread
+ */
+struct hdd_rx_overload {
+	unsigned long next_sample;
+	uint64_t softirq_ns;
+	uint64_t clock_ns;
+	uint8_t cnt;
+	bool active;
+};
+
+static DEFINE_PER_CPU(struct hdd_rx_overload, hdd_rx_overload);
+
+/**
+ * hdd_rx_is_overloaded() - Check the softirq load of the current CPU
+ *
+ * Must be called from softirq context.
+ *
+ * Return: true if rx chains should be deferred to the rx thread
+ */
+static bool hdd_rx_is_overloaded(void)
+{
+	struct hdd_rx_overload *ol = this_cpu_ptr(&hdd_rx_overload);
+	uint64_t now, softirq, pct;
+	bool past;
+
+	if (time_before(jiffies, ol->next_sample))
+		return ol->active;
+	ol->next_sample = jiffies + msecs_to_jiffies(HDD_RX_OVERLOAD_SAMPLE_MS);
+
+	now = local_clock();
+	softirq = cputime_to_nsecs(kcpustat_this_cpu->cpustat[CPUTIME_SOFTIRQ]);
+	if (ol->clock_ns && now > ol->clock_ns) {
+		pct = div64_u64((softirq - ol->softirq_ns) * 100,
+				now - ol->clock_ns);
+		past = ol->active ? pct < HDD_RX_OVERLOAD_EXIT_PCT :
+				    pct >= HDD_RX_OVERLOAD_ENTER_PCT;
+		if (!past)
+			ol->cnt = 0;
+		else if (++ol->cnt >= (ol->active ? HDD_RX_OVERLOAD_EXIT_CNT :
+						    HDD_RX_OVERLOAD_ENTER_CNT)) {
+			ol->active = !ol->active;
+			ol->cnt = 0;
+			hdd_debug("rx cpu %d %s rx thread", smp_processor_id(),
+				  ol->active ? "deferring to" : "bypassing");
+		}
+	}
+	ol->clock_ns = now;
+	ol->softirq_ns = softirq;
+
+	return ol->active;
+}
+
+/**
+ * hdd_rx_thread_cbk() - Deliver an rx chain deferred to the rx thread
+ * @context: adapter the chain was received on
+ * @rxpkt: chain of sk_buffs
+ * @staid: station id
+ *
+ * Return: none
+ */
+static void hdd_rx_thread_cbk(void *context, void *rxpkt, uint16_t staid)
+{
+	hdd_rx_packet_cbk(context, rxpkt);
+}
+
+/**
+ * hdd_rx_defer_to_thread() - Hand an rx chain to the rx thread on overload
+ * @hdd_ctx: hdd context
+ * @adapter: adapter the chain was received on
+ * @rxbuf: chain of sk_buffs
+ *
+ * Return: true if the chain was queued to the rx thread
+ */
+static bool hdd_rx_defer_to_thread(struct hdd_context *hdd_ctx,
+				   struct hdd_adapter *adapter,
+				   qdf_nbuf_t rxbuf)
+{
+	p_cds_sched_context sched_ctx;
+	struct cds_ol_rx_pkt *pkt;
+
+	if (hdd_ctx->enable_rxthread ||
+	    hdd_ctx->receive_offload_cb != hdd_gro_rx ||
+	    adapter->device_mode != QDF_STA_MODE ||
+	    !in_serving_softirq() || !hdd_rx_is_overloaded())
+		return false;
+
+	sched_ctx = get_cds_sched_ctxt();
+	if (!sched_ctx || !sched_ctx->ol_rx_thread)
+		return false;
+
+	pkt = cds_alloc_ol_rx_pkt(sched_ctx);
+	if (!pkt)
+		return false;
+
+	pkt->callback = hdd_rx_thread_cbk;
+	pkt->context = adapter;
+	pkt->Rxpkt = rxbuf;
+	pkt->staId = WLAN_HDD_GET_STATION_CTX_PTR(adapter)->conn_info.staId[0];
+	cds_indicate_rxpkt(sched_ctx, pkt);
+
+	return true;
+}
+#else
+static inline bool hdd_rx_defer_to_thread(struct hdd_context *hdd_ctx,
+					  struct hdd_adapter *adapter,
+					  qdf_nbuf_t rxbuf)
+{
+	return false;
+}
+#endif
+
 #ifdef WLAN_FEATURE_TSF_PLUS
 static inline void hdd_tsf_timestamp_rx(struct hdd_context *hdd_ctx,
 					qdf_nbuf_t netbuf,
@@ -1821,6 +2175,9 @@ QDF_STATUS hdd_rx_packet_cbk(void *context, qdf_nbuf_t rxBuf)
 		return QDF_STATUS_E_FAILURE;
 	}
 
+	if (hdd_rx_defer_to_thread(hdd_ctx, adapter, rxBuf))
+		return QDF_STATUS_SUCCESS;
+
 	cpu_index = wlan_hdd_get_cpu();
 
 	next = (struct sk_buff *)rxBuf;
@@ -1917,6 +2274,7 @@ QDF_STATUS hdd_rx_packet_cbk(void *context, qdf_nbuf_t rxBuf)
 			wake_lock = hdd_is_rx_wake_lock_needed(skb);
 
 		if (wake_lock) {
+			hdd_rx_wake_source_account(skb);
 			cds_host_diag_log_work(&hdd_ctx->rx_wake_lock,
 						   hdd_ctx->config->rx_wakelock_timeout,
 						   WIFI_POWER_EVENT_WAKELOCK_HOLD_RX);
@@ -1942,7 +2300,8 @@ QDF_STATUS hdd_rx_packet_cbk(void *context, qdf_nbuf_t rxBuf)
 			hdd_ctx->no_rx_offload_pkt_cnt++;
 			if (hdd_napi_enabled(HDD_NAPI_ANY) &&
 			    !hdd_ctx->enable_rxthread &&
-			    !QDF_NBUF_CB_RX_PEER_CACHED_FRM(skb)) {
+			    !QDF_NBUF_CB_RX_PEER_CACHED_FRM(skb) &&
+			    in_serving_softirq()) {
 				rxstat = netif_receive_skb(skb);
 			} else {
 				local_bh_disable();
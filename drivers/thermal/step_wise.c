@@ -22,11 +22,22 @@
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
 
+#include <linux/module.h>
 #include <linux/thermal.h>
 #include <trace/events/thermal.h>
 
 #include "thermal_core.h"
 
+/*
+ * Number of polling intervals to look ahead when extrapolating the
+ * temperature of a rising zone. A passive trip that the extrapolated
+ * temperature would cross is throttled one step at a time ahead of the
+ * actual crossing, instead of waiting for the trip (or a hardware limits
+ * clamp) to hit. Zero disables the lookahead.
+ */
+static unsigned int lookahead_polls;
+module_param(lookahead_polls, uint, 0644);
+
 /*
  * If the temperature is higher than a trip point,
  *    a. if the trend is THERMAL_TREND_RAISING, use higher cooling
@@ -123,6 +134,23 @@ static unsigned long get_target_state(struct thermal_instance *instance,
 	return next_target;
 }
 
+static bool trip_predicted(struct thermal_zone_device *tz,
+				enum thermal_trip_type type, int trip_temp)
+{
+	int slope;
+
+	if (!lookahead_polls || type != THERMAL_TRIP_PASSIVE ||
+		tz->last_temperature == THERMAL_TEMP_INVALID ||
+		tz->last_temperature == THERMAL_TEMP_INVALID_LOW)
+		return false;
+
+	slope = tz->temperature - tz->last_temperature;
+	if (slope <= 0)
+		return false;
+
+	return tz->temperature + slope * (int)lookahead_polls >= trip_temp;
+}
+
 static void update_passive_instance(struct thermal_zone_device *tz,
 				enum thermal_trip_type type, int value)
 {
@@ -141,6 +169,7 @@ static void thermal_zone_trip_update(struct thermal_zone_device *tz, int trip)
 	enum thermal_trend trend;
 	struct thermal_instance *instance;
 	bool throttle = false;
+	bool predicted;
 	int old_target;
 
 	if (trip == THERMAL_TRIPS_NONE) {
@@ -158,6 +187,8 @@ static void thermal_zone_trip_update(struct thermal_zone_device *tz, int trip)
 	}
 
 	trend = get_tz_trend(tz, trip);
+	predicted = trend == THERMAL_TREND_RAISING &&
+			trip_predicted(tz, trip_type, trip_temp);
 
 	dev_dbg(&tz->device,
 		"Trip%d[type=%d,temp=%d,hyst=%d]:trend=%d,throttle=%d\n",
@@ -177,7 +208,7 @@ static void thermal_zone_trip_update(struct thermal_zone_device *tz, int trip)
 		 * limit if the temperature is above the hysteresis
 		 * temperature.
 		 */
-		if (tz->temperature >= trip_temp ||
+		if (tz->temperature >= trip_temp || predicted ||
 			(tz->temperature > hyst_temp &&
 			 old_target != THERMAL_NO_TARGET))
 			throttle = true;
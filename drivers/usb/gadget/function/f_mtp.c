@@ -33,6 +33,9 @@
 #include <linux/device.h>
 #include <linux/miscdevice.h>
 #include <linux/ipc_logging.h>
+#include <linux/pipe_fs_i.h>
+#include <linux/scatterlist.h>
+#include <linux/splice.h>
 
 #include <linux/usb.h>
 #include <linux/usb_usual.h>
@@ -102,6 +105,17 @@ module_param(mtp_tx_req_len, uint, 0644);
 unsigned int mtp_tx_reqs = MTP_TX_REQ_MAX;
 module_param(mtp_tx_reqs, uint, 0644);
 
+/* send page cache pages directly if the UDC supports scatter-gather */
+static bool mtp_tx_zero_copy = true;
+module_param(mtp_tx_zero_copy, bool, 0644);
+
+/*
+ * Ask for a completion interrupt only every mtp_tx_intr_batch requests of a
+ * file transfer; the requests queued in between are completed together.
+ */
+static unsigned int mtp_tx_intr_batch = 1;
+module_param(mtp_tx_intr_batch, uint, 0644);
+
 static const char mtp_shortname[] = DRIVER_NAME "_usb";
 
 struct mtp_dev {
@@ -158,6 +172,20 @@ struct mtp_dev {
 
 static void *_mtp_ipc_log;
 
+/*
+ * Zero-copy state of a tx request. The file data of a request is spliced
+ * from the page cache and the pages are queued as a scatter-gather list,
+ * preceded by the MTP data header in req->buf if there is one. The pages
+ * are referenced until the request completes.
+ */
+struct mtp_tx_zc {
+	unsigned int nr_pages;
+	unsigned int max_pages;
+	unsigned int nr_sgs;
+	struct page **pages;
+	struct scatterlist sg[];
+};
+
 static struct usb_interface_descriptor mtp_interface_desc = {
 	.bLength                = USB_DT_INTERFACE_SIZE,
 	.bDescriptorType        = USB_DT_INTERFACE,
@@ -423,11 +451,46 @@ static struct usb_request *mtp_request_new(struct usb_ep *ep, int buffer_size)
 static void mtp_request_free(struct usb_request *req, struct usb_ep *ep)
 {
 	if (req) {
+		kfree(req->context);
 		kfree(req->buf);
 		usb_ep_free_request(ep, req);
 	}
 }
 
+static struct mtp_tx_zc *mtp_tx_zc_alloc(unsigned int len)
+{
+	/* a misaligned start can touch one more page */
+	unsigned int max_pages = DIV_ROUND_UP(len, PAGE_SIZE) + 1;
+	struct mtp_tx_zc *zc;
+
+	/* one more sg entry for the data header */
+	zc = kzalloc(sizeof(*zc) + (max_pages + 1) * sizeof(zc->sg[0]) +
+		     max_pages * sizeof(zc->pages[0]), GFP_KERNEL);
+	if (!zc)
+		return NULL;
+
+	zc->max_pages = max_pages;
+	zc->pages = (struct page **)&zc->sg[max_pages + 1];
+
+	return zc;
+}
+
+static void mtp_tx_zc_release(struct usb_request *req)
+{
+	struct mtp_tx_zc *zc = req->context;
+	unsigned int i;
+
+	if (!zc)
+		return;
+
+	for (i = 0; i < zc->nr_pages; i++)
+		put_page(zc->pages[i]);
+	zc->nr_pages = 0;
+	zc->nr_sgs = 0;
+	req->sg = NULL;
+	req->num_sgs = 0;
+}
+
 static inline int mtp_lock(atomic_t *excl)
 {
 	if (atomic_inc_return(excl) == 1) {
@@ -479,6 +542,8 @@ static void mtp_complete_in(struct usb_ep *ep, struct usb_request *req)
 	if (req->status != 0 && dev->state != STATE_OFFLINE)
 		dev->state = STATE_ERROR;
 
+	mtp_tx_zc_release(req);
+	req->no_interrupt = 0;
 	mtp_req_put(dev, &dev->tx_idle, req);
 
 	wake_up(&dev->write_wq);
@@ -562,6 +627,9 @@ static int mtp_create_bulk_endpoints(struct mtp_dev *dev,
 			goto retry_tx_alloc;
 		}
 		req->complete = mtp_complete_in;
+		/* without it, the request just falls back to copying */
+		if (cdev->gadget->sg_supported)
+			req->context = mtp_tx_zc_alloc(dev->mtp_tx_req_len);
 		mtp_req_put(dev, &dev->tx_idle, req);
 	}
 
@@ -816,6 +884,68 @@ static ssize_t mtp_write(struct file *fp, const char __user *buf,
 }
 
 /* read from a local file and write to USB */
+static int mtp_splice_actor(struct pipe_inode_info *pipe,
+			    struct splice_desc *sd)
+{
+	struct mtp_tx_zc *zc = sd->u.data;
+	int ret = 0, err;
+
+	while (pipe->nrbufs && zc->nr_pages < zc->max_pages) {
+		struct pipe_buffer *buf = pipe->bufs + pipe->curbuf;
+
+		err = pipe_buf_confirm(pipe, buf);
+		if (err)
+			return ret ? ret : err;
+		if (!pipe_buf_get(pipe, buf))
+			return ret ? ret : -EFAULT;
+
+		zc->pages[zc->nr_pages++] = buf->page;
+		sg_set_page(&zc->sg[zc->nr_sgs++], buf->page, buf->len,
+			    buf->offset);
+		ret += buf->len;
+
+		pipe_buf_release(pipe, buf);
+		pipe->curbuf = (pipe->curbuf + 1) & (pipe->buffers - 1);
+		pipe->nrbufs--;
+	}
+
+	return ret;
+}
+
+/*
+ * Fill @req with up to @len bytes of @filp at @offset without copying them,
+ * behind @hdr_size bytes of header already in req->buf. Returns the number
+ * of file bytes added, like vfs_read().
+ */
+static int mtp_splice_req(struct usb_request *req, struct file *filp,
+			  loff_t *offset, int hdr_size, int len)
+{
+	struct mtp_tx_zc *zc = req->context;
+	struct splice_desc sd = {
+		.total_len	= len,
+		.pos		= *offset,
+		.u.data		= zc,
+	};
+	int ret;
+
+	sg_init_table(zc->sg, zc->max_pages + 1);
+	if (hdr_size)
+		sg_set_buf(&zc->sg[zc->nr_sgs++], req->buf, hdr_size);
+
+	ret = splice_direct_to_actor(filp, &sd, mtp_splice_actor);
+	if (ret <= 0 || !zc->nr_pages) {
+		mtp_tx_zc_release(req);
+		return ret;
+	}
+
+	sg_mark_end(&zc->sg[zc->nr_sgs - 1]);
+	req->sg = zc->sg;
+	req->num_sgs = zc->nr_sgs;
+	*offset = sd.pos;
+
+	return ret;
+}
+
 static void send_file_work(struct work_struct *data)
 {
 	struct mtp_dev *dev = container_of(data, struct mtp_dev,
@@ -828,6 +958,8 @@ static void send_file_work(struct work_struct *data)
 	int xfer, ret, hdr_size;
 	int r = 0;
 	int sendZLP = 0;
+	bool zero_copy = mtp_tx_zero_copy;
+	unsigned int batch, queued = 0;
 	ktime_t start_time;
 
 	/* read our parameters */
@@ -856,6 +988,10 @@ static void send_file_work(struct work_struct *data)
 	if ((count & (dev->ep_in->maxpacket - 1)) == 0)
 		sendZLP = 1;
 
+	/* keep at least half of the requests able to signal completion */
+	batch = clamp_t(unsigned int, mtp_tx_intr_batch, 1,
+			max(dev->mtp_tx_reqs / 2, 1U));
+
 	while (count > 0 || sendZLP) {
 		/* so we exit after sending ZLP */
 		if (count == 0)
@@ -897,8 +1033,16 @@ static void send_file_work(struct work_struct *data)
 					__cpu_to_le32(dev->xfer_transaction_id);
 		}
 		start_time = ktime_get();
-		ret = vfs_read(filp, req->buf + hdr_size, xfer - hdr_size,
-								&offset);
+		ret = -EINVAL;
+		if (zero_copy && req->context)
+			ret = mtp_splice_req(req, filp, &offset, hdr_size,
+					     xfer - hdr_size);
+		/* files that cannot be spliced are copied as before */
+		if (ret == -EINVAL) {
+			zero_copy = false;
+			ret = vfs_read(filp, req->buf + hdr_size,
+				       xfer - hdr_size, &offset);
+		}
 		if (ret < 0) {
 			r = ret;
 			break;
@@ -912,6 +1056,13 @@ static void send_file_work(struct work_struct *data)
 		hdr_size = 0;
 
 		req->length = xfer;
+		/* the last request must interrupt, nothing follows to flush it */
+		if (++queued == batch || (count == xfer && !sendZLP)) {
+			req->no_interrupt = 0;
+			queued = 0;
+		} else {
+			req->no_interrupt = 1;
+		}
 		ret = usb_ep_queue(dev->ep_in, req, GFP_KERNEL);
 		if (ret < 0) {
 			mtp_log("xfer error %d\n", ret);
@@ -927,8 +1078,11 @@ static void send_file_work(struct work_struct *data)
 		req = 0;
 	}
 
-	if (req)
+	if (req) {
+		mtp_tx_zc_release(req);
+		req->no_interrupt = 0;
 		mtp_req_put(dev, &dev->tx_idle, req);
+	}
 
 	mtp_log("returning %d state:%d\n", r, dev->state);
 	/* write the result */
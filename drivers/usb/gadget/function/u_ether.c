@@ -79,6 +79,9 @@ struct eth_dev {
 	int			no_tx_req_used;
 	int			tx_skb_hold_count;
 	u32			tx_req_bufsize;
+	unsigned long		tx_rate_stamp;
+	unsigned		tx_rate_pkts;
+	bool			tx_busy;
 
 	struct sk_buff_head	rx_frames;
 
@@ -149,6 +152,15 @@ static inline int qlen(struct usb_gadget *gadget, unsigned qmult)
 static unsigned int u_ether_rx_pending_thld = U_ETHER_RX_PENDING_TSHOLD;
 module_param(u_ether_rx_pending_thld, uint, 0644);
 
+/*
+ * Above this many tx packets per second, SuperSpeed links get the same
+ * completion interrupt throttling as high speed ones; 0 never throttles.
+ */
+static unsigned int ss_tx_throttle_pps;
+module_param(ss_tx_throttle_pps, uint, 0644);
+MODULE_PARM_DESC(ss_tx_throttle_pps,
+		 "Tx packet rate above which SuperSpeed tx IRQs are throttled");
+
 /* REVISIT there must be a better way than having two sets
  * of debug calls ...
  */
@@ -719,6 +731,34 @@ static void tx_complete(struct usb_ep *ep, struct usb_request *req)
 		netif_wake_queue(dev->net);
 }
 
+/*
+ * At high speed every tx request is throttled. At SuperSpeed only busy
+ * links are, so that a lone packet is not left waiting for the next
+ * completion interrupt. The rate is sampled over windows of about 100ms.
+ */
+static bool eth_tx_throttle(struct eth_dev *dev)
+{
+	unsigned int pps = READ_ONCE(ss_tx_throttle_pps);
+	unsigned long now = jiffies;
+
+	if (!gadget_is_dualspeed(dev->gadget))
+		return false;
+	if (dev->gadget->speed == USB_SPEED_HIGH)
+		return true;
+	if (dev->gadget->speed < USB_SPEED_SUPER || !pps)
+		return false;
+
+	dev->tx_rate_pkts++;
+	if (time_after_eq(now, dev->tx_rate_stamp + HZ / 10)) {
+		dev->tx_busy = (u64)dev->tx_rate_pkts * HZ >=
+			       (u64)pps * (now - dev->tx_rate_stamp);
+		dev->tx_rate_pkts = 0;
+		dev->tx_rate_stamp = now;
+	}
+
+	return dev->tx_busy;
+}
+
 static inline int is_promisc(u16 cdc_filter)
 {
 	return cdc_filter & USB_CDC_PACKET_TYPE_PROMISCUOUS;
@@ -969,9 +1009,8 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 
 	req->length = length;
 
-	/* throttle highspeed IRQ rate back slightly */
-	if (gadget_is_dualspeed(dev->gadget) &&
-			 (dev->gadget->speed == USB_SPEED_HIGH)) {
+	/* throttle highspeed and busy superspeed IRQ rate back slightly */
+	if (eth_tx_throttle(dev)) {
 		spin_lock_irqsave(&dev->req_lock, flags);
 		dev->tx_qlen++;
 		if (dev->tx_qlen == MAX_TX_REQ_WITH_NO_INT) {
@@ -1023,6 +1062,9 @@ static void eth_start(struct eth_dev *dev, gfp_t gfp_flags)
 
 	/* and open the tx floodgates */
 	dev->tx_qlen = 0;
+	dev->tx_rate_pkts = 0;
+	dev->tx_rate_stamp = jiffies;
+	dev->tx_busy = false;
 	netif_wake_queue(dev->net);
 }
 
@@ -54,6 +54,11 @@
  *   - the s_anon list (see __d_drop)
  * dentry->d_sb->s_dentry_lru_lock protects:
  *   - the dcache lru lists and counters
+ *
+ * Unused negative dentries are kept on their own per-superblock LRU,
+ * dentry->d_sb->s_dentry_neg_lru, which is capped at
+ * sysctl_negative_dentry_limit entries and scanned before the regular
+ * LRU by the shrinker.
  * d_lock protects:
  *   - d_flags
  *   - d_name
@@ -129,6 +134,9 @@ struct dentry_stat_t dentry_stat = {
 static DEFINE_PER_CPU(long, nr_dentry);
 static DEFINE_PER_CPU(long, nr_dentry_unused);
 
+/* Max. unused negative dentries per superblock, 0 for no limit */
+unsigned long sysctl_negative_dentry_limit = 16384;
+
 #if defined(CONFIG_SYSCTL) && defined(CONFIG_PROC_FS)
 
 /*
@@ -380,24 +388,48 @@ static void dentry_unlink_inode(struct dentry * dentry)
  * The per-cpu "nr_dentry_unused" counters are updated with
  * the DCACHE_LRU_LIST bit.
  *
+ * The DCACHE_NEGATIVE_LRU bit is set whenever a dentry on the
+ * superblock LRU is on the negative rather than the regular list.
+ *
  * These helper functions make sure we always follow the
  * rules. d_lock must be held by the caller.
  */
 #define D_FLAG_VERIFY(dentry,x) WARN_ON_ONCE(((dentry)->d_flags & (DCACHE_LRU_LIST | DCACHE_SHRINK_LIST)) != (x))
+static inline struct list_lru *d_lru_list(struct dentry *dentry)
+{
+	if (dentry->d_flags & DCACHE_NEGATIVE_LRU)
+		return &dentry->d_sb->s_dentry_neg_lru;
+	return &dentry->d_sb->s_dentry_lru;
+}
+
+/*
+ * Is the dentry on the superblock LRU list that does not match its
+ * current positive or negative state?
+ */
+static inline bool d_lru_misplaced(unsigned d_flags)
+{
+	if ((d_flags & (DCACHE_LRU_LIST | DCACHE_SHRINK_LIST)) != DCACHE_LRU_LIST)
+		return false;
+	return !(d_flags & DCACHE_NEGATIVE_LRU) !=
+	       !((d_flags & DCACHE_ENTRY_TYPE) == DCACHE_MISS_TYPE);
+}
+
 static void d_lru_add(struct dentry *dentry)
 {
 	D_FLAG_VERIFY(dentry, 0);
 	dentry->d_flags |= DCACHE_LRU_LIST;
+	if (d_is_negative(dentry))
+		dentry->d_flags |= DCACHE_NEGATIVE_LRU;
 	this_cpu_inc(nr_dentry_unused);
-	WARN_ON_ONCE(!list_lru_add(&dentry->d_sb->s_dentry_lru, &dentry->d_lru));
+	WARN_ON_ONCE(!list_lru_add(d_lru_list(dentry), &dentry->d_lru));
 }
 
 static void d_lru_del(struct dentry *dentry)
 {
 	D_FLAG_VERIFY(dentry, DCACHE_LRU_LIST);
-	dentry->d_flags &= ~DCACHE_LRU_LIST;
+	WARN_ON_ONCE(!list_lru_del(d_lru_list(dentry), &dentry->d_lru));
+	dentry->d_flags &= ~(DCACHE_LRU_LIST | DCACHE_NEGATIVE_LRU);
 	this_cpu_dec(nr_dentry_unused);
-	WARN_ON_ONCE(!list_lru_del(&dentry->d_sb->s_dentry_lru, &dentry->d_lru));
 }
 
 static void d_shrink_del(struct dentry *dentry)
@@ -425,7 +457,7 @@ static void d_shrink_add(struct dentry *dentry, struct list_head *list)
 static void d_lru_isolate(struct list_lru_one *lru, struct dentry *dentry)
 {
 	D_FLAG_VERIFY(dentry, DCACHE_LRU_LIST);
-	dentry->d_flags &= ~DCACHE_LRU_LIST;
+	dentry->d_flags &= ~(DCACHE_LRU_LIST | DCACHE_NEGATIVE_LRU);
 	this_cpu_dec(nr_dentry_unused);
 	list_lru_isolate(lru, &dentry->d_lru);
 }
@@ -434,6 +466,7 @@ static void d_lru_shrink_move(struct list_lru_one *lru, struct dentry *dentry,
 			      struct list_head *list)
 {
 	D_FLAG_VERIFY(dentry, DCACHE_LRU_LIST);
+	dentry->d_flags &= ~DCACHE_NEGATIVE_LRU;
 	dentry->d_flags |= DCACHE_SHRINK_LIST;
 	list_lru_isolate_move(lru, &dentry->d_lru, list);
 }
@@ -445,6 +478,11 @@ static void dentry_lru_add(struct dentry *dentry)
 {
 	if (unlikely(!(dentry->d_flags & DCACHE_LRU_LIST)))
 		d_lru_add(dentry);
+	else if (unlikely(d_lru_misplaced(dentry->d_flags))) {
+		/* it was instantiated or unlinked while on the LRU */
+		d_lru_del(dentry);
+		d_lru_add(dentry);
+	}
 }
 
 /**
@@ -668,6 +706,7 @@ static inline bool fast_dput(struct dentry *dentry)
 {
 	int ret;
 	unsigned int d_flags;
+	bool misplaced;
 
 	/*
 	 * If we have a d_op->d_delete() operation, we sould not
@@ -726,10 +765,12 @@ static inline bool fast_dput(struct dentry *dentry)
 	 */
 	smp_rmb();
 	d_flags = ACCESS_ONCE(dentry->d_flags);
+	misplaced = d_lru_misplaced(d_flags);
 	d_flags &= DCACHE_REFERENCED | DCACHE_LRU_LIST | DCACHE_DISCONNECTED;
 
 	/* Nothing to do? Dropping the reference was all we needed? */
-	if (d_flags == (DCACHE_REFERENCED | DCACHE_LRU_LIST) && !d_unhashed(dentry))
+	if (d_flags == (DCACHE_REFERENCED | DCACHE_LRU_LIST) &&
+	    !d_unhashed(dentry) && !misplaced)
 		return 1;
 
 	/*
@@ -786,8 +827,13 @@ static inline bool fast_dput(struct dentry *dentry)
  * releasing its resources. If the parent dentries were scheduled for release
  * they too may now get deleted.
  */
+static void negative_dentry_trim(struct super_block *sb);
+
 void dput(struct dentry *dentry)
 {
+	struct super_block *sb;
+	bool negative;
+
 	if (unlikely(!dentry))
 		return;
 
@@ -820,9 +866,13 @@ void dput(struct dentry *dentry)
 	if (!(dentry->d_flags & DCACHE_REFERENCED))
 		dentry->d_flags |= DCACHE_REFERENCED;
 	dentry_lru_add(dentry);
+	negative = dentry->d_flags & DCACHE_NEGATIVE_LRU;
+	sb = dentry->d_sb;
 
 	dentry->d_lockref.count--;
 	spin_unlock(&dentry->d_lock);
+	if (negative)
+		negative_dentry_trim(sb);
 	return;
 
 kill_it:
@@ -1121,6 +1171,9 @@ static enum lru_status dentry_lru_isolate(struct list_head *item,
  * is done when we need more memory and called from the superblock shrinker
  * function.
  *
+ * Negative dentries are scanned first, so the regular LRU only sees what is
+ * left of @sc->nr_to_scan.
+ *
  * This function may fail to free any resources if all the dentries are in
  * use.
  */
@@ -1129,12 +1182,55 @@ long prune_dcache_sb(struct super_block *sb, struct shrink_control *sc)
 	LIST_HEAD(dispose);
 	long freed;
 
-	freed = list_lru_shrink_walk(&sb->s_dentry_lru, sc,
+	freed = list_lru_shrink_walk(&sb->s_dentry_neg_lru, sc,
 				     dentry_lru_isolate, &dispose);
+	freed += list_lru_shrink_walk(&sb->s_dentry_lru, sc,
+				      dentry_lru_isolate, &dispose);
 	shrink_dentry_list(&dispose);
 	return freed;
 }
 
+static enum lru_status dentry_lru_isolate_negative(struct list_head *item,
+		struct list_lru_one *lru, spinlock_t *lru_lock, void *arg)
+{
+	struct list_head *freeable = arg;
+	struct dentry	*dentry = container_of(item, struct dentry, d_lru);
+
+	if (!spin_trylock(&dentry->d_lock))
+		return LRU_SKIP;
+
+	/* Unlike the shrinker, the limit gives no second chances */
+	if (dentry->d_lockref.count)
+		d_lru_isolate(lru, dentry);
+	else
+		d_lru_shrink_move(lru, dentry, freeable);
+	spin_unlock(&dentry->d_lock);
+
+	return LRU_REMOVED;
+}
+
+/*
+ * Trim the negative dentry LRU of @sb back below the limit, plus some
+ * slack so that not every new negative dentry has to do it.
+ */
+static void negative_dentry_trim(struct super_block *sb)
+{
+	unsigned long limit = READ_ONCE(sysctl_negative_dentry_limit);
+	unsigned long nr;
+	LIST_HEAD(dispose);
+
+	if (!limit)
+		return;
+
+	nr = list_lru_count(&sb->s_dentry_neg_lru);
+	if (nr <= limit)
+		return;
+
+	list_lru_walk(&sb->s_dentry_neg_lru, dentry_lru_isolate_negative,
+		      &dispose, nr - limit + limit / 16);
+	shrink_dentry_list(&dispose);
+}
+
 static enum lru_status dentry_lru_isolate_shrink(struct list_head *item,
 		struct list_lru_one *lru, spinlock_t *lru_lock, void *arg)
 {
@@ -1168,11 +1264,14 @@ void shrink_dcache_sb(struct super_block *sb)
 	do {
 		LIST_HEAD(dispose);
 
+		list_lru_walk(&sb->s_dentry_neg_lru,
+			dentry_lru_isolate_shrink, &dispose, 1024);
 		list_lru_walk(&sb->s_dentry_lru,
 			dentry_lru_isolate_shrink, &dispose, 1024);
 		shrink_dentry_list(&dispose);
 		cond_resched();
-	} while (list_lru_count(&sb->s_dentry_lru) > 0);
+	} while (list_lru_count(&sb->s_dentry_lru) > 0 ||
+		 list_lru_count(&sb->s_dentry_neg_lru) > 0);
 }
 EXPORT_SYMBOL(shrink_dcache_sb);
 
@@ -57,6 +57,7 @@
 #include <linux/oom.h>
 #include <linux/compat.h>
 #include <linux/vmalloc.h>
+#include <linux/launch_prefetch.h>
 
 #include <asm/uaccess.h>
 #include <asm/mmu_context.h>
@@ -1764,6 +1765,8 @@ static int do_execveat_common(int fd, struct filename *filename,
 	}
 	bprm->interp = bprm->filename;
 
+	launch_prefetch_exec(bprm->filename);
+
 	retval = bprm_mm_init(bprm);
 	if (retval)
 		goto out_unmark;
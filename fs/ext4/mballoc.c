@@ -370,6 +370,8 @@ static void ext4_mb_generate_from_freelist(struct super_block *sb, void *bitmap,
 						ext4_group_t group);
 static void ext4_free_data_callback(struct super_block *sb,
 				struct ext4_journal_cb_entry *jce, int rc);
+static void ext4_mb_put_pa(struct ext4_allocation_context *ac,
+			struct super_block *sb, struct ext4_prealloc_space *pa);
 
 static inline void *mb_correct_addr_and_bit(int *bit, void *addr)
 {
@@ -3277,38 +3279,40 @@ static void ext4_mb_collect_stats(struct ext4_allocation_context *ac)
 
 /*
  * Called on failure; free up any blocks from the inode PA for this
- * context.  We don't need this for MB_GROUP_PA because we only change
- * pa_free in ext4_mb_release_context(), but on failure, we've already
- * zeroed out ac->ac_b_ex.fe_len, so group_pa->pa_free is not changed.
+ * context.  Blocks claimed from a MB_GROUP_PA cannot be given back to
+ * the pa, because other tasks may have claimed blocks behind them,
+ * so they are returned to the buddy instead.
  */
 static void ext4_discard_allocated_blocks(struct ext4_allocation_context *ac)
 {
 	struct ext4_prealloc_space *pa = ac->ac_pa;
+	struct ext4_free_extent *ex = &ac->ac_f_ex;
 	struct ext4_buddy e4b;
 	int err;
 
-	if (pa == NULL) {
-		if (ac->ac_f_ex.fe_len == 0)
-			return;
-		err = ext4_mb_load_buddy(ac->ac_sb, ac->ac_f_ex.fe_group, &e4b);
-		if (err) {
-			/*
-			 * This should never happen since we pin the
-			 * pages in the ext4_allocation_context so
-			 * ext4_mb_load_buddy() should never fail.
-			 */
-			WARN(1, "mb_load_buddy failed (%d)", err);
-			return;
-		}
-		ext4_lock_group(ac->ac_sb, ac->ac_f_ex.fe_group);
-		mb_free_blocks(ac->ac_inode, &e4b, ac->ac_f_ex.fe_start,
-			       ac->ac_f_ex.fe_len);
-		ext4_unlock_group(ac->ac_sb, ac->ac_f_ex.fe_group);
-		ext4_mb_unload_buddy(&e4b);
+	if (pa && pa->pa_type == MB_INODE_PA) {
+		pa->pa_free += ac->ac_b_ex.fe_len;
 		return;
 	}
-	if (pa->pa_type == MB_INODE_PA)
-		pa->pa_free += ac->ac_b_ex.fe_len;
+	if (pa)
+		ex = &ac->ac_b_ex;
+
+	if (ex->fe_len == 0)
+		return;
+	err = ext4_mb_load_buddy(ac->ac_sb, ex->fe_group, &e4b);
+	if (err) {
+		/*
+		 * This should never happen since we pin the
+		 * pages in the ext4_allocation_context so
+		 * ext4_mb_load_buddy() should never fail.
+		 */
+		WARN(1, "mb_load_buddy failed (%d)", err);
+		return;
+	}
+	ext4_lock_group(ac->ac_sb, ex->fe_group);
+	mb_free_blocks(ac->ac_inode, &e4b, ex->fe_start, ex->fe_len);
+	ext4_unlock_group(ac->ac_sb, ex->fe_group);
+	ext4_mb_unload_buddy(&e4b);
 }
 
 /*
@@ -3344,25 +3348,40 @@ static void ext4_mb_use_inode_pa(struct ext4_allocation_context *ac,
 /*
  * use blocks preallocated to locality group
  */
-static void ext4_mb_use_group_pa(struct ext4_allocation_context *ac,
+static bool ext4_mb_use_group_pa(struct ext4_allocation_context *ac,
 				struct ext4_prealloc_space *pa)
 {
 	unsigned int len = ac->ac_o_ex.fe_len;
+	ext4_fsblk_t start;
 
-	ext4_get_group_no_and_offset(ac->ac_sb, pa->pa_pstart,
+	/*
+	 * Several tasks may allocate from the same pa concurrently, so the
+	 * blocks are claimed from its tail under pa_lock. We don't correct
+	 * pa_pstart or pa_len here to avoid possible race when the group is
+	 * being loaded concurrently, instead we correct pa later, once no
+	 * claimed block is left unmarked in the on-disk bitmap -- see
+	 * ext4_mb_release_context()
+	 */
+	spin_lock(&pa->pa_lock);
+	if (pa->pa_deleted || pa->pa_free < len) {
+		spin_unlock(&pa->pa_lock);
+		return false;
+	}
+	start = pa->pa_pstart + EXT4_C2B(EXT4_SB(ac->ac_sb), pa->pa_claimed);
+	pa->pa_claimed += len;
+	pa->pa_free -= len;
+	pa->pa_inflight++;
+	spin_unlock(&pa->pa_lock);
+
+	ext4_get_group_no_and_offset(ac->ac_sb, start,
 					&ac->ac_b_ex.fe_group,
 					&ac->ac_b_ex.fe_start);
 	ac->ac_b_ex.fe_len = len;
 	ac->ac_status = AC_STATUS_FOUND;
 	ac->ac_pa = pa;
 
-	/* we don't correct pa_pstart or pa_plen here to avoid
-	 * possible race when the group is being loaded concurrently
-	 * instead we correct pa later, after blocks are marked
-	 * in on-disk bitmap -- see ext4_mb_release_context()
-	 * Other CPUs are prevented from allocating from this pa by lg_mutex
-	 */
-	mb_debug(1, "use %u/%u from group pa %p\n", pa->pa_lstart-len, len, pa);
+	mb_debug(1, "use %llu/%u from group pa %p\n", start, len, pa);
+	return true;
 }
 
 /*
@@ -3456,6 +3475,7 @@ ext4_mb_use_preallocated(struct ext4_allocation_context *ac)
 		order = PREALLOC_TB_SIZE - 1;
 
 	goal_block = ext4_grp_offs_to_block(ac->ac_sb, &ac->ac_g_ex);
+again:
 	/*
 	 * search for the prealloc space that is having
 	 * minimal distance from the goal block.
@@ -3476,9 +3496,24 @@ ext4_mb_use_preallocated(struct ext4_allocation_context *ac)
 		rcu_read_unlock();
 	}
 	if (cpa) {
-		ext4_mb_use_group_pa(ac, cpa);
-		ac->ac_criteria = 20;
-		return 1;
+		if (ext4_mb_use_group_pa(ac, cpa)) {
+			ac->ac_criteria = 20;
+			return 1;
+		}
+		/* the space went to another task meanwhile */
+		ext4_mb_put_pa(ac, ac->ac_sb, cpa);
+		cpa = NULL;
+	}
+
+	/*
+	 * A new group pa has to be carved out. Only one task per locality
+	 * group does that at a time, the others wait for it and then take
+	 * their blocks from what it preallocated.
+	 */
+	if (!ac->ac_lg_locked) {
+		mutex_lock(&lg->lg_mutex);
+		ac->ac_lg_locked = 1;
+		goto again;
 	}
 	return 0;
 }
@@ -3752,8 +3787,10 @@ ext4_mb_new_group_pa(struct ext4_allocation_context *ac)
 			pa->pa_pstart, pa->pa_len, pa->pa_lstart);
 	trace_ext4_mb_new_group_pa(ac, pa);
 
-	ext4_mb_use_group_pa(ac, pa);
+	pa->pa_claimed = 0;
+	pa->pa_inflight = 0;
 	atomic_add(pa->pa_free, &EXT4_SB(sb)->s_mb_preallocated);
+	ext4_mb_use_group_pa(ac, pa);
 
 	grp = ext4_get_group_info(sb, ac->ac_b_ex.fe_group);
 	lg = ac->ac_lg;
@@ -4206,11 +4243,11 @@ static void ext4_mb_group_or_file(struct ext4_allocation_context *ac)
 	 */
 	ac->ac_lg = raw_cpu_ptr(sbi->s_locality_groups);
 
-	/* we're going to use group allocation */
+	/*
+	 * we're going to use group allocation, lg_mutex is only taken
+	 * by ext4_mb_use_preallocated() when a new group pa is needed
+	 */
 	ac->ac_flags |= EXT4_MB_HINT_GROUP_ALLOC;
-
-	/* serialize all allocations in the group */
-	mutex_lock(&ac->ac_lg->lg_mutex);
 }
 
 static noinline_for_stack int
@@ -4344,8 +4381,9 @@ ext4_mb_discard_lg_preallocations(struct super_block *sb,
 
 /*
  * We have incremented pa_count. So it cannot be freed at this
- * point. Also we hold lg_mutex. So no parallel allocation is
- * possible from this lg. That means pa_free cannot be updated.
+ * point. Other tasks may still allocate from this pa and move it
+ * between buckets, so pa_free is sampled once and the pa is
+ * unlinked and relinked under a single hold of lg_prealloc_lock.
  *
  * A parallel ext4_mb_discard_group_preallocations is possible.
  * which can cause the lg_prealloc_list to be updated.
@@ -4357,13 +4395,19 @@ static void ext4_mb_add_n_trim(struct ext4_allocation_context *ac)
 	struct super_block *sb = ac->ac_sb;
 	struct ext4_locality_group *lg = ac->ac_lg;
 	struct ext4_prealloc_space *tmp_pa, *pa = ac->ac_pa;
+	ext4_grpblk_t free = READ_ONCE(pa->pa_free);
 
-	order = fls(pa->pa_free) - 1;
+	/* used up meanwhile, ext4_mb_put_pa() drops it */
+	if (!free)
+		return;
+
+	order = fls(free) - 1;
 	if (order > PREALLOC_TB_SIZE - 1)
 		/* The max size of hash table is PREALLOC_TB_SIZE */
 		order = PREALLOC_TB_SIZE - 1;
 	/* Add the prealloc space to lg */
 	spin_lock(&lg->lg_prealloc_lock);
+	list_del_rcu(&pa->pa_inode_list);
 	list_for_each_entry_rcu(tmp_pa, &lg->lg_prealloc_list[order],
 						pa_inode_list) {
 		spin_lock(&tmp_pa->pa_lock);
@@ -4371,7 +4415,7 @@ static void ext4_mb_add_n_trim(struct ext4_allocation_context *ac)
 			spin_unlock(&tmp_pa->pa_lock);
 			continue;
 		}
-		if (!added && pa->pa_free < tmp_pa->pa_free) {
+		if (!added && free < tmp_pa->pa_free) {
 			/* Add to the tail of the previous entry */
 			list_add_tail_rcu(&pa->pa_inode_list,
 						&tmp_pa->pa_inode_list);
@@ -4407,12 +4451,18 @@ static int ext4_mb_release_context(struct ext4_allocation_context *ac)
 	struct ext4_prealloc_space *pa = ac->ac_pa;
 	if (pa) {
 		if (pa->pa_type == MB_GROUP_PA) {
-			/* see comment in ext4_mb_use_group_pa() */
+			/*
+			 * see comment in ext4_mb_use_group_pa(), the last
+			 * allocation to finish moves the pa past every
+			 * block claimed so far
+			 */
 			spin_lock(&pa->pa_lock);
-			pa->pa_pstart += EXT4_C2B(sbi, ac->ac_b_ex.fe_len);
-			pa->pa_lstart += EXT4_C2B(sbi, ac->ac_b_ex.fe_len);
-			pa->pa_free -= ac->ac_b_ex.fe_len;
-			pa->pa_len -= ac->ac_b_ex.fe_len;
+			if (--pa->pa_inflight == 0) {
+				pa->pa_pstart += EXT4_C2B(sbi, pa->pa_claimed);
+				pa->pa_lstart += EXT4_C2B(sbi, pa->pa_claimed);
+				pa->pa_len -= pa->pa_claimed;
+				pa->pa_claimed = 0;
+			}
 			spin_unlock(&pa->pa_lock);
 		}
 	}
@@ -4423,19 +4473,15 @@ static int ext4_mb_release_context(struct ext4_allocation_context *ac)
 		 * make sure the list to which we are adding
 		 * doesn't grow big.
 		 */
-		if ((pa->pa_type == MB_GROUP_PA) && likely(pa->pa_free)) {
-			spin_lock(pa->pa_obj_lock);
-			list_del_rcu(&pa->pa_inode_list);
-			spin_unlock(pa->pa_obj_lock);
+		if ((pa->pa_type == MB_GROUP_PA) && likely(pa->pa_free))
 			ext4_mb_add_n_trim(ac);
-		}
 		ext4_mb_put_pa(ac, ac->ac_sb, pa);
 	}
 	if (ac->ac_bitmap_page)
 		put_page(ac->ac_bitmap_page);
 	if (ac->ac_buddy_page)
 		put_page(ac->ac_buddy_page);
-	if (ac->ac_flags & EXT4_MB_HINT_GROUP_ALLOC)
+	if (ac->ac_lg_locked)
 		mutex_unlock(&ac->ac_lg->lg_mutex);
 	ext4_mb_collect_stats(ac);
 	return 0;
@@ -111,6 +111,8 @@ struct ext4_prealloc_space {
 	ext4_lblk_t		pa_lstart;	/* log. block */
 	ext4_grpblk_t		pa_len;		/* len of preallocated chunk */
 	ext4_grpblk_t		pa_free;	/* how many blocks are free */
+	ext4_grpblk_t		pa_claimed;	/* group pa: handed out, not yet marked */
+	unsigned int		pa_inflight;	/* group pa: allocations in progress */
 	unsigned short		pa_type;	/* pa type. inode or group */
 	spinlock_t		*pa_obj_lock;
 	struct inode		*pa_inode;	/* hack, for history only */
@@ -139,7 +141,7 @@ struct ext4_free_extent {
 #define PREALLOC_TB_SIZE 10
 struct ext4_locality_group {
 	/* for allocator */
-	/* to serialize allocates */
+	/* to serialize creation of new group preallocations */
 	struct mutex		lg_mutex;
 	/* list of preallocations */
 	struct list_head	lg_prealloc_list[PREALLOC_TB_SIZE];
@@ -172,6 +174,7 @@ struct ext4_allocation_context {
 	__u8 ac_2order;		/* if request is to allocate 2^N blocks and
 				 * N > 0, the field stores N, otherwise 0 */
 	__u8 ac_op;		/* operation, for history only */
+	__u8 ac_lg_locked;	/* holds ac_lg->lg_mutex */
 	struct page *ac_bitmap_page;
 	struct page *ac_buddy_page;
 	struct ext4_prealloc_space *ac_pa;
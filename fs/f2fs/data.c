@@ -292,6 +292,8 @@ static struct bio *__bio_alloc(struct f2fs_io_info *fio, int npages)
 static inline void __submit_bio(struct f2fs_sb_info *sbi,
 				struct bio *bio, enum page_type type)
 {
+	f2fs_note_fg_io(sbi, bio);
+
 	if (!is_read_io(bio_op(bio))) {
 		unsigned int start;
 
@@ -2879,6 +2881,7 @@ static void f2fs_dio_submit_bio(struct bio *bio, struct inode *inode,
 
 	inc_page_count(F2FS_I_SB(inode),
 			write ? F2FS_DIO_WRITE : F2FS_DIO_READ);
+	f2fs_note_fg_io(F2FS_I_SB(inode), bio);
 
 	submit_bio(bio);
 	return;
@@ -190,6 +190,45 @@ bool f2fs_check_rb_tree_consistence(struct f2fs_sb_info *sbi,
 static struct kmem_cache *extent_tree_slab;
 static struct kmem_cache *extent_node_slab;
 
+/*
+ * Every change to an extent tree is made under both its rwlock and its
+ * seqcount, so that f2fs_lookup_extent_tree() can walk the tree without
+ * taking the lock and retry if it raced with a writer. Extent nodes are
+ * SLAB_TYPESAFE_BY_RCU, so a node freed under such a reader is at worst
+ * reused as another extent node until the reader leaves its RCU section.
+ */
+static inline void __lock_extent_tree(struct extent_tree *et)
+{
+	write_lock(&et->lock);
+	write_seqcount_begin(&et->seq);
+}
+
+static inline bool __trylock_extent_tree(struct extent_tree *et)
+{
+	if (!write_trylock(&et->lock))
+		return false;
+	write_seqcount_begin(&et->seq);
+	return true;
+}
+
+static inline void __unlock_extent_tree(struct extent_tree *et)
+{
+	write_seqcount_end(&et->seq);
+	write_unlock(&et->lock);
+}
+
+static void __add_extent_lru(struct f2fs_sb_info *sbi, struct extent_node *en)
+{
+	struct extent_lru *lru;
+
+	en->shard = raw_smp_processor_id() % EXTENT_LRU_SHARDS;
+	lru = &sbi->extent_lru[en->shard];
+
+	spin_lock(&lru->lock);
+	list_add_tail(&en->list, &lru->list);
+	spin_unlock(&lru->lock);
+}
+
 static struct extent_node *__attach_extent_node(struct f2fs_sb_info *sbi,
 				struct extent_tree *et, struct extent_info *ei,
 				struct rb_node *parent, struct rb_node **p)
@@ -201,10 +240,12 @@ static struct extent_node *__attach_extent_node(struct f2fs_sb_info *sbi,
 		return NULL;
 
 	en->ei = *ei;
+	en->shard = 0;
+	en->referenced = false;
 	INIT_LIST_HEAD(&en->list);
 	en->et = et;
 
-	rb_link_node(&en->rb_node, parent, p);
+	rb_link_node_rcu(&en->rb_node, parent, p);
 	rb_insert_color(&en->rb_node, &et->root);
 	atomic_inc(&et->node_cnt);
 	atomic_inc(&sbi->total_ext_node);
@@ -232,10 +273,12 @@ static void __detach_extent_node(struct f2fs_sb_info *sbi,
 static void __release_extent_node(struct f2fs_sb_info *sbi,
 			struct extent_tree *et, struct extent_node *en)
 {
-	spin_lock(&sbi->extent_lock);
+	struct extent_lru *lru = &sbi->extent_lru[en->shard];
+
+	spin_lock(&lru->lock);
 	f2fs_bug_on(sbi, list_empty(&en->list));
 	list_del_init(&en->list);
-	spin_unlock(&sbi->extent_lock);
+	spin_unlock(&lru->lock);
 
 	__detach_extent_node(sbi, et, en);
 }
@@ -256,6 +299,7 @@ static struct extent_tree *__grab_extent_tree(struct inode *inode)
 		et->root = RB_ROOT;
 		et->cached_en = NULL;
 		rwlock_init(&et->lock);
+		seqcount_init(&et->seq);
 		INIT_LIST_HEAD(&et->list);
 		atomic_set(&et->node_cnt, 0);
 		atomic_inc(&sbi->total_ext_tree);
@@ -338,18 +382,15 @@ static bool __f2fs_init_extent_tree(struct inode *inode, struct f2fs_extent *i_e
 
 	get_extent_info(&ei, i_ext);
 
-	write_lock(&et->lock);
+	__lock_extent_tree(et);
 	if (atomic_read(&et->node_cnt))
 		goto out;
 
 	en = __init_extent_tree(sbi, et, &ei);
-	if (en) {
-		spin_lock(&sbi->extent_lock);
-		list_add_tail(&en->list, &sbi->extent_list);
-		spin_unlock(&sbi->extent_lock);
-	}
+	if (en)
+		__add_extent_lru(sbi, en);
 out:
-	write_unlock(&et->lock);
+	__unlock_extent_tree(et);
 	return false;
 }
 
@@ -363,52 +404,93 @@ bool f2fs_init_extent_tree(struct inode *inode, struct f2fs_extent *i_ext)
 	return ret;
 }
 
+enum {
+	EXTENT_MISS,
+	EXTENT_LARGEST_HIT,
+	EXTENT_CACHED_HIT,
+	EXTENT_RBTREE_HIT,
+};
+
+static struct extent_node *__lookup_extent_node_rcu(struct extent_tree *et,
+							unsigned int ofs)
+{
+	struct rb_node *node = rcu_dereference_raw(et->root.rb_node);
+	struct extent_node *en;
+
+	while (node) {
+		en = rb_entry(node, struct extent_node, rb_node);
+
+		if (ofs < en->ei.fofs)
+			node = rcu_dereference_raw(node->rb_left);
+		else if (ofs >= en->ei.fofs + en->ei.len)
+			node = rcu_dereference_raw(node->rb_right);
+		else
+			return en;
+	}
+	return NULL;
+}
+
+static int __lookup_extent_tree_rcu(struct extent_tree *et, pgoff_t pgofs,
+							struct extent_info *ei)
+{
+	struct extent_node *en;
+
+	*ei = et->largest;
+	if (ei->fofs <= pgofs && ei->fofs + ei->len > pgofs)
+		return EXTENT_LARGEST_HIT;
+
+	en = READ_ONCE(et->cached_en);
+	if (en) {
+		*ei = en->ei;
+		if (ei->fofs <= pgofs && ei->fofs + ei->len > pgofs)
+			return EXTENT_CACHED_HIT;
+	}
+
+	en = __lookup_extent_node_rcu(et, pgofs);
+	if (!en)
+		return EXTENT_MISS;
+
+	*ei = en->ei;
+	/* only a hint for the shrinker, harmless if en was reused */
+	if (!READ_ONCE(en->referenced))
+		WRITE_ONCE(en->referenced, true);
+	return EXTENT_RBTREE_HIT;
+}
+
 static bool f2fs_lookup_extent_tree(struct inode *inode, pgoff_t pgofs,
 							struct extent_info *ei)
 {
 	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
 	struct extent_tree *et = F2FS_I(inode)->extent_tree;
-	struct extent_node *en;
-	bool ret = false;
+	struct extent_info tmp;
+	unsigned int seq;
+	int hit;
 
 	f2fs_bug_on(sbi, !et);
 
 	trace_f2fs_lookup_extent_tree_start(inode, pgofs);
 
-	read_lock(&et->lock);
+	rcu_read_lock();
+	do {
+		seq = read_seqcount_begin(&et->seq);
+		hit = __lookup_extent_tree_rcu(et, pgofs, &tmp);
+	} while (read_seqcount_retry(&et->seq, seq));
+	rcu_read_unlock();
 
-	if (et->largest.fofs <= pgofs &&
-			et->largest.fofs + et->largest.len > pgofs) {
-		*ei = et->largest;
-		ret = true;
+	if (hit == EXTENT_LARGEST_HIT)
 		stat_inc_largest_node_hit(sbi);
-		goto out;
-	}
-
-	en = (struct extent_node *)f2fs_lookup_rb_tree(&et->root,
-				(struct rb_entry *)et->cached_en, pgofs);
-	if (!en)
-		goto out;
-
-	if (en == et->cached_en)
+	else if (hit == EXTENT_CACHED_HIT)
 		stat_inc_cached_node_hit(sbi);
-	else
+	else if (hit == EXTENT_RBTREE_HIT)
 		stat_inc_rbtree_node_hit(sbi);
 
-	*ei = en->ei;
-	spin_lock(&sbi->extent_lock);
-	if (!list_empty(&en->list)) {
-		list_move_tail(&en->list, &sbi->extent_list);
-		et->cached_en = en;
-	}
-	spin_unlock(&sbi->extent_lock);
-	ret = true;
-out:
+	if (hit != EXTENT_MISS)
+		*ei = tmp;
+
 	stat_inc_total_hit(sbi);
-	read_unlock(&et->lock);
 
 	trace_f2fs_lookup_extent_tree_end(inode, pgofs, ei);
-	return ret;
+	return hit != EXTENT_MISS;
 }
 
 static struct extent_node *__try_merge_extent_node(struct f2fs_sb_info *sbi,
@@ -439,12 +521,11 @@ static struct extent_node *__try_merge_extent_node(struct f2fs_sb_info *sbi,
 
 	__try_update_largest_extent(et, en);
 
-	spin_lock(&sbi->extent_lock);
+	/* en->list only changes under et->lock, which we hold */
 	if (!list_empty(&en->list)) {
-		list_move_tail(&en->list, &sbi->extent_list);
-		et->cached_en = en;
+		en->referenced = true;
+		WRITE_ONCE(et->cached_en, en);
 	}
-	spin_unlock(&sbi->extent_lock);
 	return en;
 }
 
@@ -471,11 +552,9 @@ static struct extent_node *__insert_extent_tree(struct f2fs_sb_info *sbi,
 
 	__try_update_largest_extent(et, en);
 
-	/* update in global extent list */
-	spin_lock(&sbi->extent_lock);
-	list_add_tail(&en->list, &sbi->extent_list);
-	et->cached_en = en;
-	spin_unlock(&sbi->extent_lock);
+	/* update in extent lru list */
+	__add_extent_lru(sbi, en);
+	WRITE_ONCE(et->cached_en, en);
 	return en;
 }
 
@@ -497,10 +576,10 @@ static void f2fs_update_extent_tree_range(struct inode *inode,
 
 	trace_f2fs_update_extent_tree_range(inode, fofs, blkaddr, len);
 
-	write_lock(&et->lock);
+	__lock_extent_tree(et);
 
 	if (is_inode_flag_set(inode, FI_NO_EXTENT)) {
-		write_unlock(&et->lock);
+		__unlock_extent_tree(et);
 		return;
 	}
 
@@ -606,7 +685,7 @@ static void f2fs_update_extent_tree_range(struct inode *inode,
 		updated = true;
 	}
 
-	write_unlock(&et->lock);
+	__unlock_extent_tree(et);
 
 	if (updated)
 		f2fs_mark_inode_dirty_sync(inode, true);
@@ -617,7 +696,7 @@ unsigned int f2fs_shrink_extent_tree(struct f2fs_sb_info *sbi, int nr_shrink)
 	struct extent_tree *et, *next;
 	struct extent_node *en;
 	unsigned int node_cnt = 0, tree_cnt = 0;
-	int remained;
+	int remained, i;
 
 	if (!test_opt(sbi, EXTENT_CACHE))
 		return 0;
@@ -631,9 +710,9 @@ unsigned int f2fs_shrink_extent_tree(struct f2fs_sb_info *sbi, int nr_shrink)
 	/* 1. remove unreferenced extent tree */
 	list_for_each_entry_safe(et, next, &sbi->zombie_list, list) {
 		if (atomic_read(&et->node_cnt)) {
-			write_lock(&et->lock);
+			__lock_extent_tree(et);
 			node_cnt += __free_extent_tree(sbi, et);
-			write_unlock(&et->lock);
+			__unlock_extent_tree(et);
 		}
 		f2fs_bug_on(sbi, atomic_read(&et->node_cnt));
 		list_del_init(&et->list);
@@ -656,29 +735,46 @@ unsigned int f2fs_shrink_extent_tree(struct f2fs_sb_info *sbi, int nr_shrink)
 
 	remained = nr_shrink - (node_cnt + tree_cnt);
 
-	spin_lock(&sbi->extent_lock);
-	for (; remained > 0; remained--) {
-		if (list_empty(&sbi->extent_list))
-			break;
-		en = list_first_entry(&sbi->extent_list,
-					struct extent_node, list);
-		et = en->et;
-		if (!write_trylock(&et->lock)) {
-			/* refresh this extent node's position in extent list */
-			list_move_tail(&en->list, &sbi->extent_list);
-			continue;
-		}
+	/* spread the reclaim over all shards, starting where we left off */
+	for (i = 0; i < EXTENT_LRU_SHARDS && remained > 0; i++) {
+		unsigned int shard = sbi->extent_lru_scan++ % EXTENT_LRU_SHARDS;
+		struct extent_lru *lru = &sbi->extent_lru[shard];
+		int nr = DIV_ROUND_UP(remained, EXTENT_LRU_SHARDS - i);
+
+		remained -= nr;
+
+		spin_lock(&lru->lock);
+		for (; nr > 0; nr--) {
+			if (list_empty(&lru->list))
+				break;
+			en = list_first_entry(&lru->list,
+						struct extent_node, list);
+
+			/* give nodes hit by lookups a second chance */
+			if (READ_ONCE(en->referenced)) {
+				WRITE_ONCE(en->referenced, false);
+				list_move_tail(&en->list, &lru->list);
+				continue;
+			}
 
-		list_del_init(&en->list);
-		spin_unlock(&sbi->extent_lock);
+			et = en->et;
+			if (!__trylock_extent_tree(et)) {
+				/* refresh this extent node's position */
+				list_move_tail(&en->list, &lru->list);
+				continue;
+			}
+
+			list_del_init(&en->list);
+			spin_unlock(&lru->lock);
 
-		__detach_extent_node(sbi, et, en);
+			__detach_extent_node(sbi, et, en);
 
-		write_unlock(&et->lock);
-		node_cnt++;
-		spin_lock(&sbi->extent_lock);
+			__unlock_extent_tree(et);
+			node_cnt++;
+			spin_lock(&lru->lock);
+		}
+		spin_unlock(&lru->lock);
 	}
-	spin_unlock(&sbi->extent_lock);
 
 unlock_out:
 	mutex_unlock(&sbi->extent_tree_lock);
@@ -697,9 +793,9 @@ unsigned int f2fs_destroy_extent_node(struct inode *inode)
 	if (!et || !atomic_read(&et->node_cnt))
 		return 0;
 
-	write_lock(&et->lock);
+	__lock_extent_tree(et);
 	node_cnt = __free_extent_tree(sbi, et);
-	write_unlock(&et->lock);
+	__unlock_extent_tree(et);
 
 	return node_cnt;
 }
@@ -715,13 +811,13 @@ void f2fs_drop_extent_tree(struct inode *inode)
 
 	set_inode_flag(inode, FI_NO_EXTENT);
 
-	write_lock(&et->lock);
+	__lock_extent_tree(et);
 	__free_extent_tree(sbi, et);
 	if (et->largest.len) {
 		et->largest.len = 0;
 		updated = true;
 	}
-	write_unlock(&et->lock);
+	__unlock_extent_tree(et);
 	if (updated)
 		f2fs_mark_inode_dirty_sync(inode, true);
 }
@@ -799,10 +895,15 @@ void f2fs_update_extent_cache_range(struct dnode_of_data *dn,
 
 void f2fs_init_extent_cache_info(struct f2fs_sb_info *sbi)
 {
+	int i;
+
 	INIT_RADIX_TREE(&sbi->extent_tree_root, GFP_NOIO);
 	mutex_init(&sbi->extent_tree_lock);
-	INIT_LIST_HEAD(&sbi->extent_list);
-	spin_lock_init(&sbi->extent_lock);
+	for (i = 0; i < EXTENT_LRU_SHARDS; i++) {
+		INIT_LIST_HEAD(&sbi->extent_lru[i].list);
+		spin_lock_init(&sbi->extent_lru[i].lock);
+	}
+	sbi->extent_lru_scan = 0;
 	atomic_set(&sbi->total_ext_tree, 0);
 	INIT_LIST_HEAD(&sbi->zombie_list);
 	atomic_set(&sbi->total_zombie_tree, 0);
@@ -815,8 +916,9 @@ int __init f2fs_create_extent_cache(void)
 			sizeof(struct extent_tree));
 	if (!extent_tree_slab)
 		return -ENOMEM;
-	extent_node_slab = f2fs_kmem_cache_create("f2fs_extent_node",
-			sizeof(struct extent_node));
+	extent_node_slab = kmem_cache_create("f2fs_extent_node",
+			sizeof(struct extent_node), 0,
+			SLAB_RECLAIM_ACCOUNT | SLAB_TYPESAFE_BY_RCU, NULL);
 	if (!extent_node_slab) {
 		kmem_cache_destroy(extent_tree_slab);
 		return -ENOMEM;
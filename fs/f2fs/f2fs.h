@@ -198,6 +198,7 @@ enum {
 #define DEF_DISABLE_INTERVAL		5	/* 5 secs */
 #define DEF_DISABLE_QUICK_INTERVAL	1	/* 1 secs */
 #define DEF_UMOUNT_DISCARD_TIMEOUT	5	/* 5 secs */
+#define DEF_FSYNC_GROUP_US		500	/* 500 usecs */
 
 struct cp_control {
 	int reason;
@@ -573,10 +574,24 @@ struct extent_info {
 struct extent_node {
 	struct rb_node rb_node;		/* rb node located in rb-tree */
 	struct extent_info ei;		/* extent info */
-	struct list_head list;		/* node in global extent list of sbi */
+	unsigned short shard;		/* lru shard holding this node */
+	bool referenced;		/* hit since last seen by shrinker */
+	struct list_head list;		/* node in extent lru list of sbi */
 	struct extent_tree *et;		/* extent tree pointer */
 };
 
+/*
+ * Extent nodes are kept on one of several lru lists, chosen by the CPU
+ * which inserted them, so that concurrent updates of different files do
+ * not contend on a single lock.
+ */
+#define EXTENT_LRU_SHARDS	8
+
+struct extent_lru {
+	spinlock_t lock;		/* locking this lru list */
+	struct list_head list;		/* lru list for shrinker */
+} ____cacheline_aligned_in_smp;
+
 struct extent_tree {
 	nid_t ino;			/* inode number */
 	struct rb_root root;		/* root of extent info rb-tree */
@@ -584,6 +599,7 @@ struct extent_tree {
 	struct extent_info largest;	/* largested extent info */
 	struct list_head list;		/* to be used by sbi->zombie_list */
 	rwlock_t lock;			/* protect extent info rb-tree */
+	seqcount_t seq;			/* for lockless lookups */
 	atomic_t node_cnt;		/* # of extent node in rb-tree*/
 	bool largest_updated;		/* largest extent updated */
 };
@@ -901,6 +917,24 @@ struct flush_cmd_control {
 	struct llist_node *dispatch_list;	/* list for command dispatch */
 };
 
+/*
+ * Concurrent fsyncs are committed as a group: members write their node
+ * pages without submitting them, then the group leader submits the merged
+ * node bio once, waits for it and issues a single flush for everybody.
+ */
+struct fsync_group {
+	spinlock_t lock;
+	wait_queue_head_t wait;
+	atomic_t inflight;			/* # of fsyncs in progress */
+	unsigned long id;			/* # of the current group */
+	unsigned long done;			/* # of the last committed group */
+	unsigned int writers;			/* members writing node pages */
+	unsigned int seq_id;			/* last node write of the group */
+	bool open;				/* group accepts new members */
+	bool closing;				/* group is being committed */
+	int ret;				/* result of the last commit */
+};
+
 struct f2fs_sm_info {
 	struct sit_info *sit_info;		/* whole segment information */
 	struct free_segmap_info *free_info;	/* free segment information */
@@ -1219,8 +1253,8 @@ struct f2fs_sb_info {
 	/* for extent tree cache */
 	struct radix_tree_root extent_tree_root;/* cache extent cache entries */
 	struct mutex extent_tree_lock;	/* locking extent radix tree */
-	struct list_head extent_list;		/* lru list for shrinker */
-	spinlock_t extent_lock;			/* locking extent lru list */
+	struct extent_lru extent_lru[EXTENT_LRU_SHARDS];	/* lru lists */
+	unsigned int extent_lru_scan;		/* next shard to shrink */
 	atomic_t total_ext_tree;		/* extent tree count */
 	struct list_head zombie_list;		/* extent zombie tree list */
 	atomic_t total_zombie_tree;		/* extent zombie tree count */
@@ -1244,6 +1278,8 @@ struct f2fs_sb_info {
 	loff_t max_file_blocks;			/* max block index of file */
 	int dir_level;				/* directory level */
 	int readdir_ra;				/* readahead inode in readdir */
+	unsigned int fsync_group_us;		/* fsync group commit window */
+	struct fsync_group fsync_group;		/* fsync group commit */
 
 	block_t user_block_count;		/* # of user blocks */
 	block_t total_valid_block_count;	/* # of valid blocks */
@@ -1290,6 +1326,12 @@ struct f2fs_sb_info {
 	/* migration granularity of garbage collection, unit: segment */
 	unsigned int migration_granularity;
 
+	/* for idle-time background GC scheduling */
+	unsigned int gc_idle_sched;		/* only run BG_GC when idle */
+	unsigned int gc_idle_battery;		/* min. battery % on discharge */
+	struct task_struct *gc_task;		/* GC thread, for fg I/O check */
+	bool gc_fg_io;				/* fg I/O since BG_GC started */
+
 	/*
 	 * for stat information.
 	 * one is for the LFS mode, and the other is for the SSR mode.
@@ -2246,6 +2288,24 @@ static inline bool is_idle(struct f2fs_sb_info *sbi, int type)
 	return f2fs_time_over(sbi, type);
 }
 
+/*
+ * With gc_idle_sched set, reads and sync writes issued by anyone but the GC
+ * thread make a running background GC back off before its next block.
+ */
+static inline void f2fs_note_fg_io(struct f2fs_sb_info *sbi, struct bio *bio)
+{
+	if (!sbi->gc_idle_sched || READ_ONCE(sbi->gc_fg_io))
+		return;
+
+	if (!is_read_io(bio_op(bio)) && !rw_is_sync(bio_op(bio), bio->bi_opf))
+		return;
+
+	if (current == READ_ONCE(sbi->gc_task))
+		return;
+
+	WRITE_ONCE(sbi->gc_fg_io, true);
+}
+
 static inline void f2fs_radix_tree_insert(struct radix_tree_root *root,
 				unsigned long index, void *item)
 {
@@ -3062,7 +3122,7 @@ struct page *f2fs_get_node_page_ra(struct page *parent, int start);
 int f2fs_move_node_page(struct page *node_page, int gc_type);
 int f2fs_fsync_node_pages(struct f2fs_sb_info *sbi, struct inode *inode,
 			struct writeback_control *wbc, bool atomic,
-			unsigned int *seq_id);
+			bool defer_submit, unsigned int *seq_id);
 int f2fs_sync_node_pages(struct f2fs_sb_info *sbi,
 			struct writeback_control *wbc,
 			bool do_balance, enum iostat_type io_type);
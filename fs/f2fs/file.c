@@ -20,6 +20,7 @@
 #include <linux/uio.h>
 #include <linux/uuid.h>
 #include <linux/file.h>
+#include <linux/delay.h>
 
 #include "f2fs.h"
 #include "node.h"
@@ -205,6 +206,92 @@ static void try_to_fix_pino(struct inode *inode)
 	up_write(&fi->i_sem);
 }
 
+/*
+ * Join the open fsync group, or open a new one and become its leader. A
+ * group that is already being committed is not joined; its successor is
+ * formed once it has completed.
+ */
+static bool fsync_group_join(struct f2fs_sb_info *sbi, unsigned long *id,
+							bool *leader)
+{
+	struct fsync_group *fg = &sbi->fsync_group;
+
+	if (!sbi->fsync_group_us || f2fs_is_multi_device(sbi))
+		return false;
+
+	spin_lock(&fg->lock);
+	while (fg->closing) {
+		spin_unlock(&fg->lock);
+		wait_event(fg->wait, !READ_ONCE(fg->closing));
+		spin_lock(&fg->lock);
+	}
+	*leader = !fg->open;
+	if (*leader) {
+		fg->open = true;
+		fg->id++;
+		fg->seq_id = 0;
+	}
+	fg->writers++;
+	*id = fg->id;
+	spin_unlock(&fg->lock);
+
+	return true;
+}
+
+/*
+ * Called by every member once its node pages are written, or failed to be.
+ * Members wait for the leader, which gives other in-flight fsyncs up to
+ * fsync_group_us to join, then submits, waits for and flushes the node
+ * writes of the whole group.
+ */
+static int fsync_group_commit(struct f2fs_sb_info *sbi, unsigned long id,
+			bool leader, nid_t ino, unsigned int seq_id, int err)
+{
+	struct fsync_group *fg = &sbi->fsync_group;
+	unsigned int us = sbi->fsync_group_us;
+	int ret;
+
+	spin_lock(&fg->lock);
+	fg->seq_id = max(fg->seq_id, seq_id);
+	fg->writers--;
+	if (!leader) {
+		if (!fg->writers && fg->closing)
+			wake_up_all(&fg->wait);
+		spin_unlock(&fg->lock);
+
+		if (err)
+			return err;
+		wait_event(fg->wait, (long)(READ_ONCE(fg->done) - id) >= 0);
+		return READ_ONCE(fg->ret);
+	}
+	spin_unlock(&fg->lock);
+
+	/* only wait for company if other fsyncs are on their way */
+	if (us && atomic_read(&fg->inflight) > 1)
+		usleep_range(us, us + us / 4);
+
+	spin_lock(&fg->lock);
+	fg->open = false;
+	fg->closing = true;
+	spin_unlock(&fg->lock);
+
+	wait_event(fg->wait, !READ_ONCE(fg->writers));
+
+	f2fs_submit_merged_write(sbi, NODE);
+	ret = f2fs_wait_on_node_pages_writeback(sbi, fg->seq_id);
+	if (!ret && F2FS_OPTION(sbi).fsync_mode != FSYNC_MODE_NOBARRIER)
+		ret = f2fs_issue_flush(sbi, ino);
+
+	spin_lock(&fg->lock);
+	fg->ret = ret;
+	fg->done = id;
+	fg->closing = false;
+	spin_unlock(&fg->lock);
+	wake_up_all(&fg->wait);
+
+	return err ? err : ret;
+}
+
 static int f2fs_do_sync_file(struct file *file, loff_t start, loff_t end,
 						int datasync, bool atomic)
 {
@@ -219,6 +306,8 @@ static int f2fs_do_sync_file(struct file *file, loff_t start, loff_t end,
 		.for_reclaim = 0,
 	};
 	unsigned int seq_id = 0;
+	unsigned long group_id;
+	bool grouped = false, leader = false, flushed = false;
 
 	if (unlikely(f2fs_readonly(inode->i_sb) ||
 				is_sbi_flag_set(sbi, SBI_CP_DISABLED)))
@@ -292,17 +381,20 @@ static int f2fs_do_sync_file(struct file *file, loff_t start, loff_t end,
 		clear_inode_flag(inode, FI_UPDATE_WRITE);
 		goto out;
 	}
+
+	if (!atomic)
+		grouped = fsync_group_join(sbi, &group_id, &leader);
 sync_nodes:
 	atomic_inc(&sbi->wb_sync_req[NODE]);
-	ret = f2fs_fsync_node_pages(sbi, inode, &wbc, atomic, &seq_id);
+	ret = f2fs_fsync_node_pages(sbi, inode, &wbc, atomic, grouped, &seq_id);
 	atomic_dec(&sbi->wb_sync_req[NODE]);
 	if (ret)
-		goto out;
+		goto group_out;
 
 	/* if cp_error was enabled, we should avoid infinite loop */
 	if (unlikely(f2fs_cp_error(sbi))) {
 		ret = -EIO;
-		goto out;
+		goto group_out;
 	}
 
 	if (f2fs_need_inode_block_update(sbi, ino)) {
@@ -310,6 +402,15 @@ static int f2fs_do_sync_file(struct file *file, loff_t start, loff_t end,
 		f2fs_write_inode(inode, NULL);
 		goto sync_nodes;
 	}
+group_out:
+	if (grouped) {
+		/* the group commit waits for node writeback and flushes */
+		ret = fsync_group_commit(sbi, group_id, leader, ino,
+							seq_id, ret);
+		flushed = true;
+	}
+	if (ret)
+		goto out;
 
 	/*
 	 * If it's atomic_write, it's just fine to keep write ordering. So
@@ -319,7 +420,7 @@ static int f2fs_do_sync_file(struct file *file, loff_t start, loff_t end,
 	 * roll-forward recovery. It means we'll recover all or none node blocks
 	 * given fsync mark.
 	 */
-	if (!atomic) {
+	if (!atomic && !grouped) {
 		ret = f2fs_wait_on_node_pages_writeback(sbi, seq_id);
 		if (ret)
 			goto out;
@@ -329,7 +430,8 @@ static int f2fs_do_sync_file(struct file *file, loff_t start, loff_t end,
 	f2fs_remove_ino_entry(sbi, ino, APPEND_INO);
 	clear_inode_flag(inode, FI_APPEND_WRITE);
 flush_out:
-	if (!atomic && F2FS_OPTION(sbi).fsync_mode != FSYNC_MODE_NOBARRIER)
+	if (!atomic && !flushed &&
+			F2FS_OPTION(sbi).fsync_mode != FSYNC_MODE_NOBARRIER)
 		ret = f2fs_issue_flush(sbi, inode->i_ino);
 	if (!ret) {
 		f2fs_remove_ino_entry(sbi, ino, UPDATE_INO);
@@ -347,9 +449,17 @@ static int f2fs_do_sync_file(struct file *file, loff_t start, loff_t end,
 
 int f2fs_sync_file(struct file *file, loff_t start, loff_t end, int datasync)
 {
-	if (unlikely(f2fs_cp_error(F2FS_I_SB(file_inode(file)))))
+	struct f2fs_sb_info *sbi = F2FS_I_SB(file_inode(file));
+	int ret;
+
+	if (unlikely(f2fs_cp_error(sbi)))
 		return -EIO;
-	return f2fs_do_sync_file(file, start, end, datasync, false);
+
+	atomic_inc(&sbi->fsync_group.inflight);
+	ret = f2fs_do_sync_file(file, start, end, datasync, false);
+	atomic_dec(&sbi->fsync_group.inflight);
+
+	return ret;
 }
 
 static pgoff_t __get_first_dirty_index(struct address_space *mapping,
@@ -16,6 +16,7 @@
 #include <linux/pm_wakeup.h>
 #include <linux/msm_drm_notify.h>
 #include <linux/power_supply.h>
+#include <linux/psi.h>
 
 #include "f2fs.h"
 #include "node.h"
@@ -29,6 +30,8 @@ static LIST_HEAD(gc_sbi_list);
 static DEFINE_MUTEX(gc_wakelock_mutex);
 static DEFINE_MUTEX(gc_sbi_mutex);
 static struct wakeup_source gc_wakelock;
+static struct psi_trigger *gc_io_psi_trig;
+static unsigned long gc_io_pressure_until = INITIAL_JIFFIES;
 
 static inline void rapid_gc_set_wakelock(void)
 {
@@ -50,6 +53,50 @@ static inline void rapid_gc_set_wakelock(void)
 	mutex_unlock(&gc_wakelock_mutex);
 }
 
+static void gc_io_psi_notify(void *data)
+{
+	WRITE_ONCE(gc_io_pressure_until,
+		jiffies + usecs_to_jiffies(GC_IDLE_PSI_WINDOW_US));
+}
+
+static int gc_battery_capacity(void)
+{
+	union power_supply_propval val = { .intval = 100 };
+	struct power_supply *psy;
+
+	psy = power_supply_get_by_name("battery");
+	if (!psy)
+		return val.intval;
+
+	power_supply_get_property(psy, POWER_SUPPLY_PROP_CAPACITY, &val);
+	power_supply_put(psy);
+	return val.intval;
+}
+
+/*
+ * [Idle-time GC scheduling condition]
+ * 1. Nothing is in flight on the block device.
+ * 2. Running on external power, or the battery is above gc_idle_battery.
+ * 3. No io pressure was reported by PSI over the last window.
+ */
+static bool is_gc_idle_time(struct f2fs_sb_info *sbi)
+{
+	if (part_in_flight(sbi->sb->s_bdev->bd_part))
+		return false;
+
+	if (!power_supply_is_system_supplied() &&
+			gc_battery_capacity() < sbi->gc_idle_battery)
+		return false;
+
+	return !time_before(jiffies, READ_ONCE(gc_io_pressure_until));
+}
+
+static inline bool gc_preempted(struct f2fs_sb_info *sbi, int gc_type)
+{
+	return gc_type == BG_GC && sbi->gc_idle_sched &&
+					READ_ONCE(sbi->gc_fg_io);
+}
+
 static int gc_thread_func(void *data)
 {
 	struct f2fs_sb_info *sbi = data;
@@ -130,7 +177,8 @@ static int gc_thread_func(void *data)
 			goto next;
 		}
 
-		if (!is_idle(sbi, GC_TIME)) {
+		if (!is_idle(sbi, GC_TIME) ||
+				(sbi->gc_idle_sched && !is_gc_idle_time(sbi))) {
 			increase_sleep_time(gc_th, &wait_ms);
 			mutex_unlock(&sbi->gc_mutex);
 			stat_io_skip_bggc_count(sbi);
@@ -143,6 +191,7 @@ static int gc_thread_func(void *data)
 			increase_sleep_time(gc_th, &wait_ms);
 do_gc:
 		stat_inc_bggc_count(sbi);
+		WRITE_ONCE(sbi->gc_fg_io, false);
 
 		/* if return value is not zero, no victim was selected */
 		if (f2fs_gc(sbi, sbi->rapid_gc || test_opt(sbi, FORCE_FG_GC), true, NULL_SEGNO)) {
@@ -205,7 +254,9 @@ int f2fs_start_gc_thread(struct f2fs_sb_info *sbi)
 		err = PTR_ERR(gc_th->f2fs_gc_task);
 		kvfree(gc_th);
 		sbi->gc_thread = NULL;
+		goto out;
 	}
+	WRITE_ONCE(sbi->gc_task, gc_th->f2fs_gc_task);
 	set_task_ioprio(sbi->gc_thread->f2fs_gc_task,
 			IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0));
 out:
@@ -219,6 +270,7 @@ void f2fs_stop_gc_thread(struct f2fs_sb_info *sbi)
 	if (!gc_th)
 		return;
 	kthread_stop(gc_th->f2fs_gc_task);
+	WRITE_ONCE(sbi->gc_task, NULL);
 	kvfree(gc_th);
 	sbi->gc_mode = GC_NORMAL;
 	sbi->gc_thread = NULL;
@@ -341,10 +393,18 @@ void __init f2fs_init_rapid_gc(void)
 	INIT_WORK(&rapid_gc_fb_worker, rapid_gc_fb_work);
 	wakeup_source_init(&gc_wakelock, "f2fs_rapid_gc_wakelock");
 	msm_drm_register_client(&fb_notifier_block);
+
+	/* without PSI, idle-time GC relies on the other conditions */
+	gc_io_psi_trig = psi_kernel_trigger_create(PSI_IO_SOME,
+			GC_IDLE_PSI_THRESH_US, GC_IDLE_PSI_WINDOW_US,
+			gc_io_psi_notify, NULL);
+	if (IS_ERR(gc_io_psi_trig))
+		gc_io_psi_trig = NULL;
 }
 
 void __exit f2fs_destroy_rapid_gc(void)
 {
+	psi_kernel_trigger_destroy(gc_io_psi_trig);
 	msm_drm_unregister_client(&fb_notifier_block);
 	wakeup_source_trash(&gc_wakelock);
 }
@@ -486,6 +546,79 @@ static unsigned int count_bits(const unsigned long *addr,
 	return sum;
 }
 
+static bool skip_victim(struct f2fs_sb_info *sbi, unsigned int segno,
+				int gc_type, struct victim_sel_policy *p)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int secno = GET_SEC_FROM_SEG(sbi, segno);
+
+#ifdef CONFIG_F2FS_CHECK_FS
+	/*
+	 * skip selecting the invalid segno (that is failed due to block
+	 * validity check failure during GC) to avoid endless GC loop in
+	 * such cases.
+	 */
+	if (test_bit(segno, SIT_I(sbi)->invalid_segmap))
+		return true;
+#endif
+
+	if (sec_usage_check(sbi, secno))
+		return true;
+	/* Don't touch checkpointed data */
+	if (unlikely(is_sbi_flag_set(sbi, SBI_CP_DISABLED) &&
+				get_ckpt_valid_blocks(sbi, segno) &&
+				p->alloc_mode != SSR))
+		return true;
+	if (gc_type == BG_GC && test_bit(secno, dirty_i->victim_secmap))
+		return true;
+	return false;
+}
+
+/*
+ * LFS victims are looked up in the valid block index maintained by
+ * segment.c instead of scanning the dirty segmap. All sections of a bucket
+ * have the same utilization and are kept in the order they were last
+ * modified, so greedy takes the first usable section of the lowest bucket,
+ * while cost-benefit only has to weigh the oldest usable section of each
+ * bucket. Must hold seglist_lock.
+ */
+static unsigned int get_victim_from_index(struct f2fs_sb_info *sbi,
+				int gc_type, struct victim_sel_policy *p)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int bucket;
+
+	for_each_set_bit(bucket, dirty_i->victim_bucket_map,
+					NR_VICTIM_BUCKETS(sbi)) {
+		struct list_head *node;
+
+		list_for_each(node, &dirty_i->victim_bucket[bucket]) {
+			unsigned int secno = node - dirty_i->victim_node;
+			unsigned int start = GET_SEG_FROM_SEC(sbi, secno);
+			unsigned int end = start + sbi->segs_per_sec;
+			unsigned int segno;
+			unsigned long cost;
+
+			segno = find_next_bit(dirty_i->dirty_segmap[DIRTY],
+								end, start);
+			if (segno >= end || skip_victim(sbi, segno, gc_type, p))
+				continue;
+
+			cost = get_gc_cost(sbi, segno, p);
+			if (p->min_cost > cost) {
+				p->min_segno = segno;
+				p->min_cost = cost;
+			}
+			break;
+		}
+
+		if (p->gc_mode == GC_GREEDY && p->min_segno != NULL_SEGNO)
+			break;
+	}
+
+	return p->min_segno;
+}
+
 /*
  * This function is called from two paths.
  * One is garbage collection and the other is SSR segment selection.
@@ -546,6 +679,12 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 			goto got_it;
 	}
 
+	if (p.alloc_mode == LFS) {
+		if (get_victim_from_index(sbi, gc_type, &p) != NULL_SEGNO)
+			goto got_it;
+		goto out;
+	}
+
 	while (1) {
 		unsigned long cost;
 		unsigned int segno;
@@ -572,26 +711,7 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 			nsearched++;
 		}
 
-#ifdef CONFIG_F2FS_CHECK_FS
-		/*
-		 * skip selecting the invalid segno (that is failed due to block
-		 * validity check failure during GC) to avoid endless GC loop in
-		 * such cases.
-		 */
-		if (test_bit(segno, sm->invalid_segmap))
-			goto next;
-#endif
-
-		secno = GET_SEC_FROM_SEG(sbi, segno);
-
-		if (sec_usage_check(sbi, secno))
-			goto next;
-		/* Don't touch checkpointed data */
-		if (unlikely(is_sbi_flag_set(sbi, SBI_CP_DISABLED) &&
-					get_ckpt_valid_blocks(sbi, segno) &&
-					p.alloc_mode != SSR))
-			goto next;
-		if (gc_type == BG_GC && test_bit(secno, dirty_i->victim_secmap))
+		if (skip_victim(sbi, segno, gc_type, &p))
 			goto next;
 
 		cost = get_gc_cost(sbi, segno, &p);
@@ -721,6 +841,10 @@ static int gc_node_segment(struct f2fs_sb_info *sbi,
 		if (gc_type == BG_GC && has_not_enough_free_secs(sbi, 0, 0))
 			return submitted;
 
+		/* or once foreground I/O showed up */
+		if (gc_preempted(sbi, gc_type))
+			return submitted;
+
 		if (check_valid_map(sbi, segno, off) == 0)
 			continue;
 
@@ -1206,6 +1330,10 @@ static int gc_data_segment(struct f2fs_sb_info *sbi, struct f2fs_summary *sum,
 		if (gc_type == BG_GC && has_not_enough_free_secs(sbi, 0, 0))
 			return submitted;
 
+		/* or once foreground I/O showed up */
+		if (gc_preempted(sbi, gc_type))
+			return submitted;
+
 		if (check_valid_map(sbi, segno, off) == 0)
 			continue;
 
@@ -19,6 +19,13 @@
 
 #define DEF_GC_FAILED_PINNED_FILES	2048
 
+/* idle-time BG_GC: min. battery level while discharging, in percent */
+#define DEF_GC_IDLE_BATTERY		50
+
+/* idle-time BG_GC: io pressure above 50ms per second defers it */
+#define GC_IDLE_PSI_THRESH_US		50000
+#define GC_IDLE_PSI_WINDOW_US		1000000
+
 /* Search max. number of dirty segments to select a victim segment */
 #define DEF_MAX_VICTIM_SEARCH 4096 /* covers 8GB */
 
@@ -1647,7 +1647,7 @@ static int f2fs_write_node_page(struct page *page,
 
 int f2fs_fsync_node_pages(struct f2fs_sb_info *sbi, struct inode *inode,
 			struct writeback_control *wbc, bool atomic,
-			unsigned int *seq_id)
+			bool defer_submit, unsigned int *seq_id)
 {
 	pgoff_t index;
 	struct pagevec pvec;
@@ -1758,7 +1758,7 @@ int f2fs_fsync_node_pages(struct f2fs_sb_info *sbi, struct inode *inode,
 		goto retry;
 	}
 out:
-	if (nwritten)
+	if (nwritten && !defer_submit)
 		f2fs_submit_merged_write_cond(sbi, NULL, NULL, ino, NODE);
 	return ret ? -EIO: 0;
 }
@@ -764,6 +764,40 @@ int f2fs_flush_device_cache(struct f2fs_sb_info *sbi)
 	return ret;
 }
 
+/*
+ * Move the section of @segno to the victim bucket matching its valid blocks,
+ * or drop it from the index once none of its segments is dirty. A section
+ * always goes to the tail of its new bucket, which keeps every bucket in
+ * the order its sections were last modified. Must hold seglist_lock.
+ */
+static void __update_victim_index(struct f2fs_sb_info *sbi, unsigned int segno)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int secno = GET_SEC_FROM_SEG(sbi, segno);
+	unsigned int start = GET_SEG_FROM_SEC(sbi, secno);
+	unsigned int end = start + sbi->segs_per_sec;
+	unsigned short old = dirty_i->victim_bucket_of[secno];
+	unsigned short new = NULL_VICTIM_BUCKET;
+
+	if (find_next_bit(dirty_i->dirty_segmap[DIRTY], end, start) < end)
+		new = get_valid_blocks(sbi, start, true) / sbi->segs_per_sec;
+
+	if (old == new)
+		return;
+
+	if (old != NULL_VICTIM_BUCKET) {
+		list_del(&dirty_i->victim_node[secno]);
+		if (list_empty(&dirty_i->victim_bucket[old]))
+			clear_bit(old, dirty_i->victim_bucket_map);
+	}
+	if (new != NULL_VICTIM_BUCKET) {
+		list_add_tail(&dirty_i->victim_node[secno],
+					&dirty_i->victim_bucket[new]);
+		set_bit(new, dirty_i->victim_bucket_map);
+	}
+	dirty_i->victim_bucket_of[secno] = new;
+}
+
 static void __locate_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		enum dirty_type dirty_type)
 {
@@ -786,6 +820,8 @@ static void __locate_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		}
 		if (!test_and_set_bit(segno, dirty_i->dirty_segmap[t]))
 			dirty_i->nr_dirty[t]++;
+
+		__update_victim_index(sbi, segno);
 	}
 }
 
@@ -811,6 +847,8 @@ static void __remove_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 			clear_bit(segno, SIT_I(sbi)->invalid_segmap);
 #endif
 		}
+
+		__update_victim_index(sbi, segno);
 	}
 }
 
@@ -4269,6 +4307,34 @@ static int init_victim_secmap(struct f2fs_sb_info *sbi)
 	return 0;
 }
 
+static int init_victim_index(struct f2fs_sb_info *sbi)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int nr_buckets = NR_VICTIM_BUCKETS(sbi);
+	unsigned int i;
+
+	dirty_i->victim_bucket = f2fs_kvzalloc(sbi,
+			array_size(nr_buckets, sizeof(struct list_head)),
+			GFP_KERNEL);
+	dirty_i->victim_bucket_map = f2fs_kvzalloc(sbi,
+			f2fs_bitmap_size(nr_buckets), GFP_KERNEL);
+	dirty_i->victim_node = f2fs_kvzalloc(sbi,
+			array_size(MAIN_SECS(sbi), sizeof(struct list_head)),
+			GFP_KERNEL);
+	dirty_i->victim_bucket_of = f2fs_kvzalloc(sbi,
+			array_size(MAIN_SECS(sbi), sizeof(unsigned short)),
+			GFP_KERNEL);
+	if (!dirty_i->victim_bucket || !dirty_i->victim_bucket_map ||
+			!dirty_i->victim_node || !dirty_i->victim_bucket_of)
+		return -ENOMEM;
+
+	for (i = 0; i < nr_buckets; i++)
+		INIT_LIST_HEAD(&dirty_i->victim_bucket[i]);
+	for (i = 0; i < MAIN_SECS(sbi); i++)
+		dirty_i->victim_bucket_of[i] = NULL_VICTIM_BUCKET;
+	return 0;
+}
+
 static int build_dirty_segmap(struct f2fs_sb_info *sbi)
 {
 	struct dirty_seglist_info *dirty_i;
@@ -4292,6 +4358,9 @@ static int build_dirty_segmap(struct f2fs_sb_info *sbi)
 			return -ENOMEM;
 	}
 
+	if (init_victim_index(sbi))
+		return -ENOMEM;
+
 	init_dirty_segmap(sbi);
 	return init_victim_secmap(sbi);
 }
@@ -4449,6 +4518,16 @@ static void destroy_victim_secmap(struct f2fs_sb_info *sbi)
 	kvfree(dirty_i->victim_secmap);
 }
 
+static void destroy_victim_index(struct f2fs_sb_info *sbi)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+
+	kvfree(dirty_i->victim_bucket);
+	kvfree(dirty_i->victim_bucket_map);
+	kvfree(dirty_i->victim_node);
+	kvfree(dirty_i->victim_bucket_of);
+}
+
 static void destroy_dirty_segmap(struct f2fs_sb_info *sbi)
 {
 	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
@@ -4462,6 +4541,7 @@ static void destroy_dirty_segmap(struct f2fs_sb_info *sbi)
 		discard_dirty_segmap(sbi, i);
 
 	destroy_victim_secmap(sbi);
+	destroy_victim_index(sbi);
 	SM_I(sbi)->dirty_info = NULL;
 	kvfree(dirty_i);
 }
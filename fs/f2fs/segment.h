@@ -281,8 +281,20 @@ struct dirty_seglist_info {
 	struct mutex seglist_lock;		/* lock for segment bitmaps */
 	int nr_dirty[NR_DIRTY_TYPE];		/* # of dirty segments */
 	unsigned long *victim_secmap;		/* background GC victims */
+	struct list_head *victim_bucket;	/* dirty sections by valid blocks */
+	unsigned long *victim_bucket_map;	/* non-empty victim buckets */
+	struct list_head *victim_node;		/* per-section bucket link */
+	unsigned short *victim_bucket_of;	/* per-section bucket index */
 };
 
+/*
+ * Dirty sections are indexed by their average number of valid blocks per
+ * segment, so that LFS victim selection does not have to scan the dirty
+ * segmap. There is one bucket for each possible count.
+ */
+#define NR_VICTIM_BUCKETS(sbi)	((sbi)->blocks_per_seg + 1)
+#define NULL_VICTIM_BUCKET	USHRT_MAX
+
 /* victim selection function for cleaning and SSR */
 struct victim_selection {
 	int (*get_victim)(struct f2fs_sb_info *, unsigned int *,
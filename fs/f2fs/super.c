@@ -2777,6 +2777,7 @@ static void init_sb_info(struct f2fs_sb_info *sbi)
 	sbi->next_victim_seg[FG_GC] = NULL_SEGNO;
 	sbi->max_victim_search = DEF_MAX_VICTIM_SEARCH;
 	sbi->migration_granularity = sbi->segs_per_sec;
+	sbi->gc_idle_battery = DEF_GC_IDLE_BATTERY;
 
 	sbi->dir_level = DEF_DIR_LEVEL;
 	sbi->interval_time[CP_TIME] = DEF_CP_INTERVAL;
@@ -2794,6 +2795,10 @@ static void init_sb_info(struct f2fs_sb_info *sbi)
 	for (i = 0; i < META; i++)
 		atomic_set(&sbi->wb_sync_req[i], 0);
 
+	spin_lock_init(&sbi->fsync_group.lock);
+	init_waitqueue_head(&sbi->fsync_group.wait);
+	atomic_set(&sbi->fsync_group.inflight, 0);
+
 	INIT_LIST_HEAD(&sbi->s_list);
 	mutex_init(&sbi->umount_mutex);
 	init_rwsem(&sbi->io_order_lock);
@@ -3099,6 +3104,7 @@ static void f2fs_tuning_parameters(struct f2fs_sb_info *sbi)
 	}
 
 	sbi->readdir_ra = 1;
+	sbi->fsync_group_us = DEF_FSYNC_GROUP_US;
 }
 
 static int f2fs_fill_super(struct super_block *sb, void *data, int silent)
@@ -88,6 +88,8 @@
 #include <linux/flex_array.h>
 #include <linux/posix-timers.h>
 #include <linux/cpufreq_times.h>
+#include <linux/khugepaged.h>
+#include <linux/ksm.h>
 #ifdef CONFIG_HARDWALL
 #include <asm/hardwall.h>
 #endif
@@ -3139,6 +3141,82 @@ static int proc_pid_personality(struct seq_file *m, struct pid_namespace *ns,
 static const struct file_operations proc_task_operations;
 static const struct inode_operations proc_task_inode_operations;
 
+#ifdef CONFIG_KSM
+/*
+ * Writing 1 marks all private anonymous memory of the process mergeable
+ * by ksmd, writing 0 unmerges and unmarks it again.
+ */
+static ssize_t ksm_merge_write(struct file *file, const char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	struct task_struct *task;
+	struct mm_struct *mm;
+	bool mergeable;
+	int err;
+
+	err = kstrtobool_from_user(buf, count, &mergeable);
+	if (err)
+		return err;
+
+	task = get_proc_task(file_inode(file));
+	if (!task)
+		return -ESRCH;
+
+	mm = get_task_mm(task);
+	put_task_struct(task);
+	if (!mm)
+		return -EINVAL;
+
+	err = ksm_mm_set_mergeable(mm, mergeable);
+	mmput(mm);
+
+	return err ? err : count;
+}
+
+static const struct file_operations proc_ksm_merge_operations = {
+	.write		= ksm_merge_write,
+	.llseek		= noop_llseek,
+};
+#endif
+
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+/*
+ * Writing 1 applies MADV_HUGEPAGE to the anonymous heaps of the process so
+ * khugepaged collapses them, writing 0 applies MADV_NOHUGEPAGE instead.
+ */
+static ssize_t thp_heap_write(struct file *file, const char __user *buf,
+			      size_t count, loff_t *ppos)
+{
+	struct task_struct *task;
+	struct mm_struct *mm;
+	bool enable;
+	int err;
+
+	err = kstrtobool_from_user(buf, count, &enable);
+	if (err)
+		return err;
+
+	task = get_proc_task(file_inode(file));
+	if (!task)
+		return -ESRCH;
+
+	mm = get_task_mm(task);
+	put_task_struct(task);
+	if (!mm)
+		return -EINVAL;
+
+	err = khugepaged_mm_set_hugepage(mm, enable);
+	mmput(mm);
+
+	return err ? err : count;
+}
+
+static const struct file_operations proc_thp_heap_operations = {
+	.write		= thp_heap_write,
+	.llseek		= noop_llseek,
+};
+#endif
+
 static const struct pid_entry tgid_base_stuff[] = {
 	DIR("task",       S_IRUGO|S_IXUGO, proc_task_inode_operations, proc_task_operations),
 	DIR("fd",         S_IRUSR|S_IXUSR, proc_fd_inode_operations, proc_fd_operations),
@@ -3187,6 +3265,12 @@ static const struct pid_entry tgid_base_stuff[] = {
 #ifdef CONFIG_PROCESS_RECLAIM
 	REG("reclaim", 0222, proc_reclaim_operations),
 #endif
+#ifdef CONFIG_KSM
+	REG("ksm_merge", S_IWUSR, proc_ksm_merge_operations),
+#endif
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+	REG("thp_heap", S_IWUSR, proc_thp_heap_operations),
+#endif
 #ifdef CONFIG_PROC_PAGE_MONITOR
 	REG("clear_refs", S_IWUSR, proc_clear_refs_operations),
 	REG("smaps",      S_IRUGO, proc_pid_smaps_operations),
@@ -1,5 +1,6 @@
 #include <linux/init.h>
 #include <linux/kernel_stat.h>
+#include <linux/math64.h>
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
 
@@ -29,6 +30,41 @@ static int softirqs_open(struct inode *inode, struct file *file)
 	return single_open(file, show_softirqs, NULL);
 }
 
+/*
+ * /proc/softirqs_time  ... display the time spent in each softirq, in us
+ */
+static int show_softirqs_time(struct seq_file *p, void *v)
+{
+	int i, j;
+
+	seq_puts(p, "                    ");
+	for_each_possible_cpu(i)
+		seq_printf(p, "CPU%-8d", i);
+	seq_putc(p, '\n');
+
+	for (i = 0; i < NR_SOFTIRQS; i++) {
+		seq_printf(p, "%12s:", softirq_to_name[i]);
+		for_each_possible_cpu(j)
+			seq_printf(p, " %10llu",
+				   div_u64(kstat_softirq_time_cpu(i, j),
+					   NSEC_PER_USEC));
+		seq_putc(p, '\n');
+	}
+	return 0;
+}
+
+static int softirqs_time_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, show_softirqs_time, NULL);
+}
+
+static const struct file_operations proc_softirqs_time_operations = {
+	.open		= softirqs_time_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static const struct file_operations proc_softirqs_operations = {
 	.open		= softirqs_open,
 	.read		= seq_read,
@@ -39,6 +75,7 @@ static const struct file_operations proc_softirqs_operations = {
 static int __init proc_softirqs_init(void)
 {
 	proc_create("softirqs", 0, NULL, &proc_softirqs_operations);
+	proc_create("softirqs_time", 0, NULL, &proc_softirqs_time_operations);
 	return 0;
 }
 fs_initcall(proc_softirqs_init);
@@ -289,6 +289,8 @@ static void __fixup_perms_recursive(struct dentry *dentry, struct limit_search *
 {
 	struct dentry *child;
 	struct sdcardfs_inode_info *info;
+	struct qstr name = limit->name;
+	bool by_hash = false;
 
 	/*
 	 * All paths will terminate their recursion on hitting PERM_ANDROID_OBB,
@@ -296,6 +298,14 @@ static void __fixup_perms_recursive(struct dentry *dentry, struct limit_search *
 	 * at most 3.
 	 */
 	WARN(depth > 3, "%s: Max expected depth exceeded!\n", __func__);
+
+	/*
+	 * Children are hashed by their parent's d_hash, so hashing the name
+	 * the same way lets most of them be skipped without a string compare.
+	 */
+	if ((limit->flags & BY_NAME) && (dentry->d_flags & DCACHE_OP_HASH))
+		by_hash = !dentry->d_op->d_hash(dentry, &name);
+
 	spin_lock_nested(&dentry->d_lock, depth);
 	if (!d_inode(dentry)) {
 		spin_unlock(&dentry->d_lock);
@@ -305,6 +315,8 @@ static void __fixup_perms_recursive(struct dentry *dentry, struct limit_search *
 
 	if (needs_fixup(info->data->perm)) {
 		list_for_each_entry(child, &dentry->d_subdirs, d_child) {
+			if (by_hash && child->d_name.hash != name.hash)
+				continue;
 			spin_lock_nested(&child->d_lock, depth + 1);
 			if (!(limit->flags & BY_NAME) || qstr_case_eq(&child->d_name, &limit->name)) {
 				if (d_inode(child)) {
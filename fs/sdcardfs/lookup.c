@@ -20,6 +20,8 @@
 
 #include "sdcardfs.h"
 #include "linux/delay.h"
+#include "linux/ctype.h"
+#include "linux/hash.h"
 
 /* The dentry cache is just so we have properly sized dentries */
 static struct kmem_cache *sdcardfs_dentry_cachep;
@@ -220,31 +222,254 @@ int sdcardfs_interpose(struct dentry *dentry, struct super_block *sb,
 	return PTR_ERR(ret_dentry);
 }
 
+/*
+ * Case-folded name cache of a lower directory.
+ *
+ * A name that misses on the lower fs has to be looked for case-insensitively
+ * by reading the whole lower directory. The first such scan of a directory
+ * records every name it returns, so that later misses in it are answered
+ * from a hash table without reading the directory again. The cache belongs
+ * to the sdcardfs directory inode and only stays valid for as long as the
+ * mtime of the lower directory is unchanged.
+ */
+#define SDCARDFS_NAME_CACHE_MAX		32768
+#define SDCARDFS_NAME_CACHE_MAX_BITS	12
+
+struct sdcardfs_name_entry {
+	struct hlist_node hlist;
+	unsigned int hash;
+	unsigned int len;
+	char name[];
+};
+
+struct sdcardfs_name_cache {
+	struct rcu_head rcu;
+	struct timespec mtime;
+	unsigned int bits;
+	struct hlist_head buckets[];
+};
+
 struct sdcardfs_name_data {
 	struct dir_context ctx;
 	const struct qstr *to_find;
+	/* filled with the matching name, to_find->len + 1 bytes */
 	char *name;
 	bool found;
+	/* names gathered for the cache, until collect is cleared */
+	bool collect;
+	unsigned int nr_entries;
+	struct hlist_head entries;
 };
 
+static unsigned int sdcardfs_name_case_hash(const char *name, unsigned int len)
+{
+	unsigned long hash = init_name_hash(NULL);
+
+	while (len--)
+		hash = partial_name_hash(tolower(*name++), hash);
+	return end_name_hash(hash);
+}
+
+static void sdcardfs_free_name_entries(struct hlist_head *head)
+{
+	struct sdcardfs_name_entry *ne;
+	struct hlist_node *tmp;
+
+	hlist_for_each_entry_safe(ne, tmp, head, hlist) {
+		hlist_del(&ne->hlist);
+		kfree(ne);
+	}
+}
+
+static void sdcardfs_free_name_cache(struct rcu_head *head)
+{
+	struct sdcardfs_name_cache *cache =
+		container_of(head, struct sdcardfs_name_cache, rcu);
+	unsigned int i;
+
+	for (i = 0; i < (1U << cache->bits); i++)
+		sdcardfs_free_name_entries(&cache->buckets[i]);
+	kfree(cache);
+}
+
+void sdcardfs_drop_name_cache(struct inode *dir)
+{
+	struct sdcardfs_name_cache *cache;
+
+	cache = xchg(&SDCARDFS_I(dir)->name_cache, NULL);
+	if (cache)
+		call_rcu(&cache->rcu, sdcardfs_free_name_cache);
+}
+
+static void sdcardfs_install_name_cache(struct inode *dir,
+		struct sdcardfs_name_data *buf, const struct timespec *mtime)
+{
+	struct sdcardfs_name_cache *cache, *old;
+	struct sdcardfs_name_entry *ne;
+	struct hlist_node *tmp;
+	unsigned int bits, i;
+
+	bits = min_t(unsigned int, SDCARDFS_NAME_CACHE_MAX_BITS,
+		     ilog2(roundup_pow_of_two(max(buf->nr_entries, 1U))));
+
+	cache = kmalloc(sizeof(*cache) + (sizeof(struct hlist_head) << bits),
+			GFP_KERNEL);
+	if (!cache) {
+		sdcardfs_free_name_entries(&buf->entries);
+		return;
+	}
+
+	cache->mtime = *mtime;
+	cache->bits = bits;
+	for (i = 0; i < (1U << bits); i++)
+		INIT_HLIST_HEAD(&cache->buckets[i]);
+
+	hlist_for_each_entry_safe(ne, tmp, &buf->entries, hlist) {
+		hlist_del(&ne->hlist);
+		hlist_add_head(&ne->hlist,
+			       &cache->buckets[hash_32(ne->hash, bits)]);
+	}
+
+	/* xchg orders the initialization above before the cache is visible */
+	old = xchg(&SDCARDFS_I(dir)->name_cache, cache);
+	if (old)
+		call_rcu(&old->rcu, sdcardfs_free_name_cache);
+}
+
+/*
+ * Returns 0 and copies the lower name to @found, -ENOENT if the directory
+ * has no such name, or -EAGAIN if there is no usable cache.
+ */
+static int sdcardfs_name_cache_find(struct inode *dir, struct inode *lower_dir,
+		const struct qstr *name, char *found)
+{
+	struct sdcardfs_name_cache *cache;
+	struct sdcardfs_name_entry *ne;
+	unsigned int hash;
+	int err = -EAGAIN;
+
+	rcu_read_lock();
+	cache = rcu_dereference(SDCARDFS_I(dir)->name_cache);
+	if (!cache || !timespec_equal(&cache->mtime, &lower_dir->i_mtime))
+		goto out;
+
+	err = -ENOENT;
+	hash = sdcardfs_name_case_hash(name->name, name->len);
+	hlist_for_each_entry_rcu(ne, &cache->buckets[hash_32(hash, cache->bits)],
+				 hlist) {
+		if (ne->hash == hash && ne->len == name->len &&
+		    str_n_case_eq(ne->name, name->name, name->len)) {
+			memcpy(found, ne->name, ne->len);
+			found[ne->len] = '\0';
+			err = 0;
+			break;
+		}
+	}
+out:
+	rcu_read_unlock();
+	return err;
+}
+
+static void sdcardfs_name_collect(struct sdcardfs_name_data *buf,
+		const char *name, int namelen)
+{
+	struct sdcardfs_name_entry *ne;
+
+	if (namelen == 1 && name[0] == '.')
+		return;
+	if (namelen == 2 && name[0] == '.' && name[1] == '.')
+		return;
+
+	if (buf->nr_entries >= SDCARDFS_NAME_CACHE_MAX)
+		goto give_up;
+
+	ne = kmalloc(sizeof(*ne) + namelen + 1, GFP_KERNEL);
+	if (!ne)
+		goto give_up;
+
+	ne->hash = sdcardfs_name_case_hash(name, namelen);
+	ne->len = namelen;
+	memcpy(ne->name, name, namelen);
+	ne->name[namelen] = '\0';
+	hlist_add_head(&ne->hlist, &buf->entries);
+	buf->nr_entries++;
+	return;
+
+give_up:
+	sdcardfs_free_name_entries(&buf->entries);
+	buf->collect = false;
+}
+
 static int sdcardfs_name_match(struct dir_context *ctx, const char *name,
 		int namelen, loff_t offset, u64 ino, unsigned int d_type)
 {
 	struct sdcardfs_name_data *buf = container_of(ctx, struct sdcardfs_name_data, ctx);
 	struct qstr candidate = QSTR_INIT(name, namelen);
 
-	if (qstr_case_eq(buf->to_find, &candidate)) {
+	if (buf->collect)
+		sdcardfs_name_collect(buf, name, namelen);
+
+	if (!buf->found && qstr_case_eq(buf->to_find, &candidate)) {
 		buf->found = true;
-		buf->name = kmalloc(namelen + 1, GFP_KERNEL);
-		if (buf->name) {
-			memcpy(buf->name, name, namelen);
-			buf->name[namelen] = '\0';
-		}
-		return 1;
+		memcpy(buf->name, name, namelen);
+		buf->name[namelen] = '\0';
+		/* keep reading if the cache is being filled */
+		if (!buf->collect)
+			return 1;
 	}
 	return 0;
 }
 
+/*
+ * Look for a case-insensitive match of @name in the lower directory and
+ * copy it to @found, which has to hold name->len + 1 bytes.
+ */
+static int sdcardfs_find_ci_name(struct inode *dir, struct path *lower_parent_path,
+		const struct qstr *name, char *found)
+{
+	struct inode *lower_dir = d_inode(lower_parent_path->dentry);
+	struct sdcardfs_name_data buffer = {
+		.ctx.actor = sdcardfs_name_match,
+		.to_find = name,
+		.name = found,
+		.found = false,
+		.collect = true,
+	};
+	struct timespec mtime, now;
+	struct file *file;
+	int err;
+
+	err = sdcardfs_name_cache_find(dir, lower_dir, name, found);
+	if (err != -EAGAIN)
+		return err;
+
+	INIT_HLIST_HEAD(&buffer.entries);
+	file = dentry_open(lower_parent_path, O_RDONLY, current_cred());
+	if (IS_ERR(file))
+		return PTR_ERR(file);
+
+	mtime = lower_dir->i_mtime;
+	err = iterate_dir(file, &buffer.ctx);
+	fput(file);
+
+	/*
+	 * Only cache a directory that did not change while it was read. Its
+	 * last change must also be older than the current tick, as another
+	 * change within the same tick would leave the mtime as it is.
+	 */
+	now = current_time(lower_dir);
+	if (!err && buffer.collect &&
+	    timespec_equal(&mtime, &lower_dir->i_mtime) &&
+	    !timespec_equal(&mtime, &now))
+		sdcardfs_install_name_cache(dir, &buffer, &mtime);
+	else
+		sdcardfs_free_name_entries(&buffer.entries);
+
+	if (err)
+		return err;
+	return buffer.found ? 0 : -ENOENT;
+}
+
 /*
  * Main driver function for sdcardfs's lookup.
  *
@@ -282,40 +507,21 @@ static struct dentry *__sdcardfs_lookup(struct dentry *dentry,
 				&lower_path);
 	/* check for other cases */
 	if (err == -ENOENT) {
-		struct file *file;
-		const struct cred *cred = current_cred();
-
-		struct sdcardfs_name_data buffer = {
-			.ctx.actor = sdcardfs_name_match,
-			.to_find = name,
-			.found = false,
-		};
-
-		file = dentry_open(lower_parent_path, O_RDONLY, cred);
-		if (IS_ERR(file)) {
-			err = PTR_ERR(file);
-			goto err;
-		}
-
-		err = iterate_dir(file, &buffer.ctx);
-		fput(file);
-		if (err)
-			goto err;
+		char *ci_name = kmalloc(name->len + 1, GFP_KERNEL);
 
-		if (buffer.found) {
-			if (!buffer.name) {
-				err = -ENOMEM;
-				goto out;
-			}
+		if (!ci_name) {
+			err = -ENOMEM;
+			goto out;
+		}
 
+		err = sdcardfs_find_ci_name(d_inode(dentry->d_parent),
+					    lower_parent_path, name, ci_name);
+		if (!err)
 			err = vfs_path_lookup(lower_dir_dentry,
 						lower_dir_mnt,
-						buffer.name, 0,
+						ci_name, 0,
 						&lower_path);
-			kfree(buffer.name);
-		} else {
-			err = -ENOENT;
-		}
+		kfree(ci_name);
 	}
 
 	/* no error: handle positive dentries */
@@ -193,6 +193,7 @@ static struct hashtable_entry *alloc_hashtable_entry(const struct qstr *key,
 	return ret;
 }
 
+/* Returns 1 if the package was already mapped to this appid */
 static int insert_packagelist_appid_entry_locked(const struct qstr *key, appid_t value)
 {
 	struct hashtable_entry *hash_cur;
@@ -201,6 +202,8 @@ static int insert_packagelist_appid_entry_locked(const struct qstr *key, appid_t
 
 	hash_for_each_possible_rcu(package_to_appid, hash_cur, hlist, hash) {
 		if (qstr_case_eq(key, &hash_cur->key)) {
+			if (atomic_read(&hash_cur->value) == value)
+				return 1;
 			atomic_set(&hash_cur->value, value);
 			return 0;
 		}
@@ -230,6 +233,7 @@ static int insert_ext_gid_entry_locked(const struct qstr *key, appid_t value)
 	return 0;
 }
 
+/* Returns 1 if the package was already excluded for this user */
 static int insert_userid_exclude_entry_locked(const struct qstr *key, userid_t value)
 {
 	struct hashtable_entry *hash_cur;
@@ -240,7 +244,7 @@ static int insert_userid_exclude_entry_locked(const struct qstr *key, userid_t v
 	hash_for_each_possible_rcu(package_to_userid, hash_cur, hlist, hash) {
 		if (atomic_read(&hash_cur->value) == value &&
 				qstr_case_eq(key, &hash_cur->key))
-			return 0;
+			return 1;
 	}
 	new_entry = alloc_hashtable_entry(key, value);
 	if (!new_entry)
@@ -299,7 +303,7 @@ static int insert_packagelist_entry(const struct qstr *key, appid_t value)
 		fixup_all_perms_name(key);
 	mutex_unlock(&sdcardfs_super_list_lock);
 
-	return err;
+	return err < 0 ? err : 0;
 }
 
 static int insert_ext_gid_entry(const struct qstr *key, appid_t value)
@@ -323,7 +327,7 @@ static int insert_userid_exclude_entry(const struct qstr *key, userid_t value)
 		fixup_all_perms_name_userid(key, value);
 	mutex_unlock(&sdcardfs_super_list_lock);
 
-	return err;
+	return err < 0 ? err : 0;
 }
 
 static void free_hashtable_entry(struct hashtable_entry *entry)
@@ -332,7 +336,8 @@ static void free_hashtable_entry(struct hashtable_entry *entry)
 	kmem_cache_free(hashtable_entry_cachep, entry);
 }
 
-static void remove_packagelist_entry_locked(const struct qstr *key)
+/* Returns false if the package was not known */
+static bool remove_packagelist_entry_locked(const struct qstr *key)
 {
 	struct hashtable_entry *hash_cur;
 	unsigned int hash = key->hash;
@@ -352,16 +357,19 @@ static void remove_packagelist_entry_locked(const struct qstr *key)
 			break;
 		}
 	}
+	if (hlist_empty(&free_list))
+		return false;
 	synchronize_rcu();
 	hlist_for_each_entry_safe(hash_cur, h_t, &free_list, dlist)
 		free_hashtable_entry(hash_cur);
+	return true;
 }
 
 static void remove_packagelist_entry(const struct qstr *key)
 {
 	mutex_lock(&sdcardfs_super_list_lock);
-	remove_packagelist_entry_locked(key);
-	fixup_all_perms_name(key);
+	if (remove_packagelist_entry_locked(key))
+		fixup_all_perms_name(key);
 	mutex_unlock(&sdcardfs_super_list_lock);
 }
 
@@ -414,7 +422,8 @@ static void remove_userid_all_entry(userid_t userid)
 	mutex_unlock(&sdcardfs_super_list_lock);
 }
 
-static void remove_userid_exclude_entry_locked(const struct qstr *key, userid_t userid)
+/* Returns false if the package was not excluded for this user */
+static bool remove_userid_exclude_entry_locked(const struct qstr *key, userid_t userid)
 {
 	struct hashtable_entry *hash_cur;
 	unsigned int hash = key->hash;
@@ -425,16 +434,17 @@ static void remove_userid_exclude_entry_locked(const struct qstr *key, userid_t
 			hash_del_rcu(&hash_cur->hlist);
 			synchronize_rcu();
 			free_hashtable_entry(hash_cur);
-			break;
+			return true;
 		}
 	}
+	return false;
 }
 
 static void remove_userid_exclude_entry(const struct qstr *key, userid_t userid)
 {
 	mutex_lock(&sdcardfs_super_list_lock);
-	remove_userid_exclude_entry_locked(key, userid);
-	fixup_all_perms_name_userid(key, userid);
+	if (remove_userid_exclude_entry_locked(key, userid))
+		fixup_all_perms_name_userid(key, userid);
 	mutex_unlock(&sdcardfs_super_list_lock);
 }
 
@@ -146,6 +146,7 @@ extern int new_dentry_private_data(struct dentry *dentry);
 extern void free_dentry_private_data(struct dentry *dentry);
 extern struct dentry *sdcardfs_lookup(struct inode *dir, struct dentry *dentry,
 				unsigned int flags);
+extern void sdcardfs_drop_name_cache(struct inode *dir);
 extern struct inode *sdcardfs_iget(struct super_block *sb,
 				 struct inode *lower_inode, userid_t id);
 extern int sdcardfs_interpose(struct dentry *dentry, struct super_block *sb,
@@ -179,6 +180,9 @@ struct sdcardfs_inode_info {
 	spinlock_t top_lock;
 	struct sdcardfs_inode_data *top_data;
 
+	/* case-folded names of the lower directory, see lookup.c */
+	struct sdcardfs_name_cache __rcu *name_cache;
+
 	struct inode vfs_inode;
 };
 
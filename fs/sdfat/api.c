@@ -619,6 +619,20 @@ s32 fsapi_dfr_check_dfr_on(struct inode *inode, loff_t start, loff_t end, s32 ca
 }
 EXPORT_SYMBOL(fsapi_dfr_check_dfr_on);
 
+s32 fsapi_dfr_scan_extents(struct inode *inode, void *chunks, s32 max_chunks,
+		u32 max_clus, u32 threshold)
+{
+	s32 err;
+	struct super_block *sb = inode->i_sb;
+
+	mutex_lock(&(SDFAT_SB(sb)->s_vlock));
+	err = defrag_scan_extents(inode, (struct defrag_chunk_info *)chunks,
+			max_chunks, max_clus, threshold);
+	mutex_unlock(&(SDFAT_SB(sb)->s_vlock));
+	return err;
+}
+EXPORT_SYMBOL(fsapi_dfr_scan_extents);
+
 
 
 #ifdef CONFIG_SDFAT_DFR_DEBUG
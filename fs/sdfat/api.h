@@ -38,7 +38,8 @@ extern "C" {
 
 /* Read-ahead related                                */
 /* First config vars. should be pow of 2             */
-#define FCACHE_MAX_RA_SIZE	(PAGE_SIZE)
+#define FCACHE_MIN_RA_SIZE	(PAGE_SIZE)
+#define FCACHE_MAX_RA_SIZE	(128*1024)
 #define DCACHE_MAX_RA_SIZE	(128*1024)
 
 /*----------------------------------------------------------------------*/
@@ -301,6 +302,10 @@ typedef struct __FS_INFO_T {
 		cache_ent_t pool[FAT_CACHE_SIZE];
 		cache_ent_t lru_list;
 		cache_ent_t hash_list[FAT_CACHE_HASH_SIZE];
+		/* FAT read-ahead window, in sectors */
+		u64 ra_start;
+		u64 ra_next;
+		u32 ra_size;
 	} fcache;
 
 	/* meta cache */
@@ -391,6 +396,8 @@ void fsapi_dfr_free_clus(struct super_block *sb, u32 clus);
 
 s32 fsapi_dfr_check_dfr_required(struct super_block *sb, int *totalau, int *cleanau, int *fullau);
 s32 fsapi_dfr_check_dfr_on(struct inode *inode, loff_t start, loff_t end, s32 cancel, const char *caller);
+s32 fsapi_dfr_scan_extents(struct inode *inode, void *chunks, s32 max_chunks,
+		u32 max_clus, u32 threshold);
 
 
 #ifdef CONFIG_SDFAT_DFR_DEBUG
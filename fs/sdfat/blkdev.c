@@ -141,6 +141,27 @@ s32 bdev_readahead(struct super_block *sb, u64 secno, u64 num_secs)
 	return 0;
 }
 
+/*
+ * Make a readahead request that is submitted as a single I/O: the whole
+ * range stays plugged, so the buffers are merged into one request.
+ */
+s32 bdev_readahead_bulk(struct super_block *sb, u64 secno, u64 num_secs)
+{
+	FS_INFO_T *fsi = &(SDFAT_SB(sb)->fsi);
+	struct blk_plug plug;
+	u64 i;
+
+	if (!fsi->bd_opened)
+		return -EIO;
+
+	blk_start_plug(&plug);
+	for (i = 0; i < num_secs; i++)
+		sb_breadahead(sb, (sector_t)(secno + i));
+	blk_finish_plug(&plug);
+
+	return 0;
+}
+
 s32 bdev_mread(struct super_block *sb, u64 secno, struct buffer_head **bh, u64 num_secs, s32 read)
 {
 	FS_INFO_T *fsi = &(SDFAT_SB(sb)->fsi);
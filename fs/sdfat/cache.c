@@ -187,11 +187,47 @@ static s32 __fcache_ent_discard(struct super_block *sb, cache_ent_t *bp)
 	return 0;
 }
 
+/*
+ * FAT read-ahead.
+ *
+ * Cluster chains of files written sequentially mostly run forward through
+ * the FAT, so a miss inside the current window grows the next window up to
+ * FCACHE_MAX_RA_SIZE once its second half is reached, while a miss
+ * elsewhere starts over with a FCACHE_MIN_RA_SIZE window around it.
+ */
+static void __fcache_readahead(struct super_block *sb, u64 sec)
+{
+	FS_INFO_T *fsi = &(SDFAT_SB(sb)->fsi);
+	u32 min_ra = FCACHE_MIN_RA_SIZE >> sb->s_blocksize_bits;
+	u32 max_ra = FCACHE_MAX_RA_SIZE >> sb->s_blocksize_bits;
+	u64 fat_end = fsi->FAT1_start_sector + fsi->num_FAT_sectors;
+	u64 start;
+	u32 size;
+
+	if ((sec >= fsi->fcache.ra_start) && (sec < fsi->fcache.ra_next)) {
+		if (sec < fsi->fcache.ra_next - (fsi->fcache.ra_size >> 1))
+			return;
+		start = fsi->fcache.ra_next;
+		size = min(fsi->fcache.ra_size << 1, max_ra);
+	} else {
+		start = sec & ~((u64)min_ra - 1);
+		size = min_ra;
+	}
+
+	if ((start >= fsi->FAT1_start_sector) && (start < fat_end))
+		size = (u32)min_t(u64, size, fat_end - start);
+
+	fsi->fcache.ra_start = start;
+	fsi->fcache.ra_next = start + size;
+	fsi->fcache.ra_size = size;
+
+	bdev_readahead_bulk(sb, start, (u64)size);
+}
+
 u8 *fcache_getblk(struct super_block *sb, u64 sec)
 {
 	cache_ent_t *bp;
 	FS_INFO_T *fsi = &(SDFAT_SB(sb)->fsi);
-	u32 page_ra_count = FCACHE_MAX_RA_SIZE >> sb->s_blocksize_bits;
 
 	bp = __fcache_find(sb, sec);
 	if (bp) {
@@ -212,9 +248,7 @@ u8 *fcache_getblk(struct super_block *sb, u64 sec)
 	bp->flag = 0;
 	__fcache_insert_hash(sb, bp);
 
-	/* Naive FAT read-ahead (increase I/O unit to page_ra_count) */
-	if ((sec & (page_ra_count - 1)) == 0)
-		bdev_readahead(sb, sec, (u64)page_ra_count);
+	__fcache_readahead(sb, sec);
 
 	/*
 	 * patch 1.2.4 : buffer_head null pointer exception problem.
@@ -289,6 +323,9 @@ s32 meta_cache_init(struct super_block *sb)
 		fsi->fcache.pool[i].next = NULL;
 		push_to_mru(&(fsi->fcache.pool[i]), &fsi->fcache.lru_list);
 	}
+	fsi->fcache.ra_start = 0;
+	fsi->fcache.ra_next = 0;
+	fsi->fcache.ra_size = 0;
 
 	fsi->dcache.lru_list.next = &fsi->dcache.lru_list;
 	fsi->dcache.lru_list.prev = fsi->dcache.lru_list.next;
@@ -193,6 +193,7 @@ s32 bdev_open_dev(struct super_block *sb);
 s32 bdev_close_dev(struct super_block *sb);
 s32 bdev_check_bdi_valid(struct super_block *sb);
 s32 bdev_readahead(struct super_block *sb, u64 secno, u64 num_secs);
+s32 bdev_readahead_bulk(struct super_block *sb, u64 secno, u64 num_secs);
 s32 bdev_mread(struct super_block *sb, u64 secno, struct buffer_head **bh, u64 num_secs, s32 read);
 s32 bdev_mwrite(struct super_block *sb, u64 secno, struct buffer_head *bh, u64 num_secs, s32 sync);
 s32 bdev_sync_all(struct super_block *sb);
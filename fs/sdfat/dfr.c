@@ -1341,6 +1341,100 @@ defrag_check_defrag_on(
 }
 
 
+/**
+ * @fn		defrag_scan_extents
+ * @brief	build defrag requests for the fragments of given file
+ * @return	# of chunks built if the file has more extents than threshold,
+ *		0 if not, -errno otherwise
+ * @param	inode		inode
+ * @param	chunks		chunk array to fill
+ * @param	max_chunks	# of entries in chunks
+ * @param	max_clus	# of clusters the chunks may cover in total
+ * @param	threshold	# of extents a file may have without defrag
+ * @remark	protected by inode_lock, super_block and volume lock
+ */
+int
+defrag_scan_extents(
+	IN struct inode *inode,
+	OUT struct defrag_chunk_info *chunks,
+	IN int max_chunks,
+	IN unsigned int max_clus,
+	IN unsigned int threshold)
+{
+	struct super_block *sb = inode->i_sb;
+	FS_INFO_T *fsi = &(SDFAT_SB(sb)->fsi);
+	FILE_ID_T *fid = &(SDFAT_I(inode)->fid);
+	unsigned int clus_per_au = CLUS_PER_AU(sb);
+	unsigned int clus = 0, next = 0, prev = 0, start = 0;
+	unsigned int f_clus = 0, run = 1, nr_extents = 1, total = 0, walked = 0;
+	int nr = 0, err = 0;
+
+	/* Only FAT chains can be defragmented */
+	if ((fid->dir.dir == DIR_DELETED) || (fid->flags == 0x03))
+		return 0;
+
+	clus = start = fid->start_clu;
+	FAT32_CHECK_CLUSTER(fsi, clus, err);
+	if (err)
+		return 0;
+
+	while (1) {
+		err = fat_ent_get(sb, clus, &next);
+		if (err)
+			return err;
+
+		/* Extend the current run up to one AU */
+		if (!IS_CLUS_EOF(next) && (next == clus + 1) && (run < clus_per_au)) {
+			clus = next;
+			run++;
+			continue;
+		}
+
+		if (!IS_CLUS_EOF(next) && (next != clus + 1))
+			nr_extents++;
+
+		/* Runs of a whole AU are left where they are */
+		if ((run < clus_per_au) && (nr < max_chunks) &&
+				(total + run <= max_clus)) {
+			struct defrag_chunk_info *chunk = &chunks[nr++];
+
+			chunk->stat = 0;
+			chunk->f_clus = f_clus;
+			chunk->i_pos = SDFAT_I(inode)->i_pos;
+			chunk->d_clus = start;
+			chunk->nr_clus = run;
+			chunk->prev_clus = prev;
+			chunk->next_clus = next & FAT32_EOF;
+			chunk->au_clus = clus_per_au;
+			total += run;
+		}
+
+		if (IS_CLUS_EOF(next))
+			break;
+
+		walked += run;
+		if (walked > fsi->num_clusters) {
+			dfr_err("cluster chain loop, inode %p", inode);
+			return -EIO;
+		}
+
+		FAT32_CHECK_CLUSTER(fsi, next, err);
+		if (err)
+			return err;
+
+		prev = clus;
+		f_clus += run;
+		clus = start = next;
+		run = 1;
+	}
+
+	dfr_debug("inode %p, extents %d, chunks %d, clus %d",
+			inode, nr_extents, nr, total);
+
+	return (nr_extents > threshold) ? nr : 0;
+}
+
+
 #ifdef CONFIG_SDFAT_DFR_DEBUG
 /**
  * @fn		defrag_spo_test
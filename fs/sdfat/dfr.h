@@ -36,6 +36,11 @@
 
 #define	DFR_MAX_AU_MOVED		(16)	// Maximum # of AUs for a request
 
+#define	DFR_AUTO_INTERVAL		(30 * HZ)	// Period of the automatic defrag thread
+#define	DFR_AUTO_DEFAULT_EXTENTS	(16)	// Defrag files written in more extents than this
+#define	DFR_AUTO_MAX_CANDIDATES		(32)	// # of recently written files remembered
+#define	DFR_AUTO_MAX_CHUNKS		(64)	// Maximum # of chunks for an automatic request
+
 
 /* Debugging support*/
 #define dfr_err(fmt, args...) pr_err("DFR: " fmt "\n", args)
@@ -250,6 +255,8 @@ int defrag_free_cluster(struct super_block *sb, unsigned int clus);
 
 int defrag_check_defrag_required(struct super_block *sb, int *totalau, int *cleanau, int *fullau);
 int defrag_check_defrag_on(struct inode *inode, loff_t start, loff_t end, int cancel, const char *caller);
+int defrag_scan_extents(struct inode *inode, struct defrag_chunk_info *chunks,
+		int max_chunks, unsigned int max_clus, unsigned int threshold);
 
 #ifdef CONFIG_SDFAT_DFR_DEBUG
 void defrag_spo_test(struct super_block *sb, int flag, const char *caller);
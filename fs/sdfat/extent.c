@@ -342,8 +342,16 @@ s32 extent_get_clus(struct inode *inode, u32 cluster, u32 *fclus,
 			break;
 		}
 
-		if (!cache_contiguous(&cid, *dclus))
+		if (!cache_contiguous(&cid, *dclus)) {
+			/*
+			 * Remember every run walked over, not only the last
+			 * one, so a later lookup inside it skips the FAT.
+			 */
+			cid.nr_contig--;
+			if (cid.nr_contig)
+				extent_cache_add(inode, &cid);
 			cache_init(&cid, *fclus, *dclus);
+		}
 	}
 
 	extent_cache_add(inode, &cid);
@@ -51,6 +51,9 @@
 #include <linux/bio.h>
 #include <linux/blkdev.h>
 #include <linux/swap.h> /* for mark_page_accessed() */
+#include <linux/kthread.h>
+#include <linux/freezer.h>
+#include <linux/power_supply.h>
 #include <linux/vmalloc.h>
 #include <asm/current.h>
 #include <asm/unaligned.h>
@@ -1737,6 +1740,103 @@ defrag_check_fs_busy(
 }
 
 
+/**
+ * @fn		defrag_run_reqs
+ * @brief	validate given requests and wait for them to complete
+ * @return	0 on success, -errno otherwise
+ * @param	sb		super block
+ * @param	chunks	given chunks (header at REQ_HEADER_IDX)
+ * @param	len		# of chunks including the header
+ * @param	mode	defrag mode
+ * @param	umount_held	caller already holds sb->s_umount
+ * @remark	sb_dfr->stat must be DFR_SB_STAT_REQ, the caller cleans up
+ */
+static int
+defrag_run_reqs(
+	IN struct super_block *sb,
+	INOUT struct defrag_chunk_info *chunks,
+	IN unsigned int len,
+	IN int mode,
+	IN bool umount_held)
+{
+	struct sdfat_sb_info *sbi = SDFAT_SB(sb);
+	struct defrag_info *sb_dfr = &(sbi->dfr_info);
+	unsigned long timeout = 0;
+	int err = 0;
+
+	/* Initialize sb_dfr */
+	sb_dfr->chunks = chunks;
+	sb_dfr->nr_chunks = len;
+
+	/* Validate reqs & mark defrag/dirty */
+	err = defrag_validate_reqs(sb, sb_dfr->chunks);
+	if (err)
+		return err;
+
+	atomic_set(&sb_dfr->stat, DFR_SB_STAT_VALID);
+
+	/* Wait for defrag completion */
+	if (mode == DFR_MODE_ONESHOT)
+		timeout = 0;
+	else if (mode & DFR_MODE_BACKGROUND)
+		timeout = DFR_DEFAULT_TIMEOUT;
+	else
+		timeout = DFR_MIN_TIMEOUT;
+
+	dfr_debug("Wait for completion (timeout %ld)", timeout);
+	init_completion(&sbi->dfr_complete);
+	timeout = wait_for_completion_timeout(&sbi->dfr_complete, timeout);
+
+	if (!timeout) {
+		/* Force defrag_updat_fat() after timeout. */
+		dfr_debug("Force sync(), mode %d, left-timeout %ld", mode, timeout);
+
+		if (!umount_held)
+			down_read(&sb->s_umount);
+
+		sync_inodes_sb(sb);
+
+		__lock_super(sb);
+		fsapi_dfr_update_fat_next(sb);
+
+		fsapi_sync_fs(sb, 1);
+
+#ifdef	CONFIG_SDFAT_DFR_DEBUG
+		/* SPO test */
+		fsapi_dfr_spo_test(sb, DFR_SPO_FAT_NEXT, __func__);
+#endif
+
+		fsapi_dfr_update_fat_prev(sb, 1);
+		fsapi_sync_fs(sb, 1);
+
+		__unlock_super(sb);
+
+		if (!umount_held)
+			up_read(&sb->s_umount);
+	}
+
+#ifdef	CONFIG_SDFAT_DFR_DEBUG
+		/* SPO test */
+		fsapi_dfr_spo_test(sb, DFR_SPO_NORMAL, __func__);
+#endif
+
+	__lock_super(sb);
+	/* Send DISCARD to clean-ed AUs */
+	fsapi_dfr_check_discard(sb);
+
+#ifdef	CONFIG_SDFAT_DFR_DEBUG
+	/* SPO test */
+	fsapi_dfr_spo_test(sb, DFR_SPO_DISCARD, __func__);
+#endif
+
+	/* Unmark IGNORE flag to all victim AUs */
+	fsapi_dfr_unmark_ignore_all(sb);
+	__unlock_super(sb);
+
+	return 0;
+}
+
+
 /**
  * @fn		sdfat_ioctl_defrag_req
  * @brief	ioctl to send defrag requests
@@ -1756,7 +1856,6 @@ sdfat_ioctl_defrag_req(
 	struct defrag_chunk_info *chunks = NULL;
 	unsigned int len = 0;
 	int err = 0;
-	unsigned long timeout = 0;
 
 	/* Check overlapped defrag */
 	if (atomic_cmpxchg(&sb_dfr->stat, DFR_SB_STAT_IDLE, DFR_SB_STAT_REQ)) {
@@ -1810,72 +1909,9 @@ sdfat_ioctl_defrag_req(
 	err = copy_from_user(chunks, uarg, len * sizeof(struct defrag_chunk_info));
 	ERR_HANDLE(err);
 
-	/* Initialize sb_dfr */
-	sb_dfr->chunks = chunks;
-	sb_dfr->nr_chunks = len;
-
-	/* Validate reqs & mark defrag/dirty */
-	err = defrag_validate_reqs(sb, sb_dfr->chunks);
+	err = defrag_run_reqs(sb, chunks, len, head.mode, false);
 	ERR_HANDLE(err);
 
-	atomic_set(&sb_dfr->stat, DFR_SB_STAT_VALID);
-
-	/* Wait for defrag completion */
-	if (head.mode == DFR_MODE_ONESHOT)
-		timeout = 0;
-	else if (head.mode & DFR_MODE_BACKGROUND)
-		timeout = DFR_DEFAULT_TIMEOUT;
-	else
-		timeout = DFR_MIN_TIMEOUT;
-
-	dfr_debug("Wait for completion (timeout %ld)", timeout);
-	init_completion(&sbi->dfr_complete);
-	timeout = wait_for_completion_timeout(&sbi->dfr_complete, timeout);
-
-	if (!timeout) {
-		/* Force defrag_updat_fat() after timeout. */
-		dfr_debug("Force sync(), mode %d, left-timeout %ld", head.mode, timeout);
-
-		down_read(&sb->s_umount);
-
-		sync_inodes_sb(sb);
-
-		__lock_super(sb);
-		fsapi_dfr_update_fat_next(sb);
-
-		fsapi_sync_fs(sb, 1);
-
-#ifdef	CONFIG_SDFAT_DFR_DEBUG
-		/* SPO test */
-		fsapi_dfr_spo_test(sb, DFR_SPO_FAT_NEXT, __func__);
-#endif
-
-		fsapi_dfr_update_fat_prev(sb, 1);
-		fsapi_sync_fs(sb, 1);
-
-		__unlock_super(sb);
-
-		up_read(&sb->s_umount);
-	}
-
-#ifdef	CONFIG_SDFAT_DFR_DEBUG
-		/* SPO test */
-		fsapi_dfr_spo_test(sb, DFR_SPO_NORMAL, __func__);
-#endif
-
-	__lock_super(sb);
-	/* Send DISCARD to clean-ed AUs */
-	fsapi_dfr_check_discard(sb);
-
-#ifdef	CONFIG_SDFAT_DFR_DEBUG
-	/* SPO test */
-	fsapi_dfr_spo_test(sb, DFR_SPO_DISCARD, __func__);
-#endif
-
-	/* Unmark IGNORE flag to all victim AUs */
-	fsapi_dfr_unmark_ignore_all(sb);
-	__unlock_super(sb);
-
 	err = copy_to_user(uarg, sb_dfr->chunks, sizeof(struct defrag_chunk_info) * len);
 	ERR_HANDLE(err);
 
@@ -2004,6 +2040,192 @@ sdfat_ioctl_defrag_info(
 	return err;
 }
 
+
+/*----------------------------------------------------------------------*/
+/*  Automatic defragmentation                                           */
+/*----------------------------------------------------------------------*/
+/**
+ * @fn		defrag_auto_pop
+ * @brief	take the most recently written candidate file
+ * @return	true if a candidate was taken
+ * @param	sbi		sdfat sb info
+ * @param	i_pos	i_pos of the candidate
+ */
+static bool defrag_auto_pop(struct sdfat_sb_info *sbi, loff_t *i_pos)
+{
+	bool ret = false;
+
+	spin_lock(&sbi->dfr_auto_lock);
+	if (sbi->dfr_auto_nr) {
+		*i_pos = sbi->dfr_auto_cand[--sbi->dfr_auto_nr];
+		ret = true;
+	}
+	spin_unlock(&sbi->dfr_auto_lock);
+
+	return ret;
+}
+
+/**
+ * @fn		defrag_auto_idle
+ * @brief	check if the card has been idle since the last poll
+ *		and the device is charging
+ * @return	true if automatic defrag may run
+ * @param	sb		super block
+ */
+static bool defrag_auto_idle(struct super_block *sb)
+{
+	struct sdfat_sb_info *sbi = SDFAT_SB(sb);
+	struct hd_struct *part = sb->s_bdev->bd_part;
+	unsigned long ios;
+	bool idle;
+
+	ios = part_stat_read(part, ios[READ]) + part_stat_read(part, ios[WRITE]);
+	idle = (ios == sbi->dfr_auto_ios);
+	sbi->dfr_auto_ios = ios;
+
+	if (!idle || part_in_flight(part) ||
+			atomic_read(&sbi->stat_n_pages_queued))
+		return false;
+
+	return power_supply_is_system_supplied() > 0;
+}
+
+/**
+ * @fn		defrag_auto_run
+ * @brief	defrag one recently written file if it is fragmented
+ * @return	void
+ * @param	sb		super block
+ * @remark	called with sb->s_umount held for read
+ */
+static void defrag_auto_run(struct super_block *sb)
+{
+	struct sdfat_sb_info *sbi = SDFAT_SB(sb);
+	FS_INFO_T *fsi = &(sbi->fsi);
+	struct defrag_info *sb_dfr = &(sbi->dfr_info);
+	struct defrag_chunk_header *head = NULL;
+	struct defrag_chunk_info *chunks = NULL;
+	struct inode *inode = NULL;
+	size_t size = sizeof(struct defrag_chunk_info) * (DFR_AUTO_MAX_CHUNKS + 1);
+	/* dfr_new_idx starts from 1 and must stay below PAGE_SIZE / sizeof(int) */
+	unsigned int max_clus = (PAGE_SIZE / sizeof(int)) - 2;
+	int reserved_clus = 0, queued_pages = 0;
+	loff_t i_pos = 0;
+	int nr = 0, i = 0, err = 0;
+
+	if (!defrag_auto_pop(sbi, &i_pos))
+		return;
+
+	/* Leave the card alone when it is nearly full */
+	__lock_super(sb);
+	if (fsi->used_clusters != (unsigned int)(~0) &&
+			fsi->used_clusters * DFR_FULL_RATIO >=
+			fsi->num_clusters * DFR_DEFAULT_STOP_RATIO) {
+		__unlock_super(sb);
+		return;
+	}
+	inode = sdfat_iget(sb, i_pos);
+	__unlock_super(sb);
+	if (!inode)
+		return;
+
+	/* The engine only moves clean pages that are not mapped */
+	if (!S_ISREG(inode->i_mode) || mapping_mapped(inode->i_mapping))
+		goto out;
+
+	chunks = alloc_pages_exact(size, GFP_KERNEL | __GFP_ZERO);
+	if (!chunks)
+		goto out;
+
+	err = filemap_write_and_wait(inode->i_mapping);
+	if (err)
+		goto out;
+
+	inode_lock(inode);
+	__lock_super(sb);
+	nr = fsapi_dfr_scan_extents(inode, &chunks[REQ_HEADER_IDX + 1],
+			DFR_AUTO_MAX_CHUNKS, max_clus, sbi->dfr_auto_extents);
+	__unlock_super(sb);
+	inode_unlock(inode);
+	if (nr <= 0)
+		goto out;
+
+	/* Bring the victim pages into the page cache */
+	for (i = REQ_HEADER_IDX + 1; i <= nr; i++) {
+		pgoff_t index = chunks[i].f_clus * PAGES_PER_CLUS(sb);
+		pgoff_t last = index + chunks[i].nr_clus * PAGES_PER_CLUS(sb);
+		pgoff_t end = (i_size_read(inode) + PAGE_SIZE - 1) >> PAGE_SHIFT;
+
+		for (; index < min(last, end); index++) {
+			struct page *page = read_mapping_page(inode->i_mapping, index, NULL);
+
+			if (!IS_ERR(page))
+				put_page(page);
+		}
+	}
+
+	head = (struct defrag_chunk_header *)&chunks[REQ_HEADER_IDX];
+	head->mode = DFR_MODE_BACKGROUND;
+	head->nr_chunks = nr + 1;
+
+	if (atomic_cmpxchg(&sb_dfr->stat, DFR_SB_STAT_IDLE, DFR_SB_STAT_REQ))
+		goto out;
+
+	err = defrag_check_fs_busy(sb, &reserved_clus, &queued_pages);
+	if (err) {
+		err = -EBUSY;
+	} else {
+		dfr_debug("auto defrag started (inode %p, nr_req %d)", inode, nr);
+		err = defrag_run_reqs(sb, chunks, nr + 1, DFR_MODE_BACKGROUND, true);
+	}
+
+	defrag_cleanup_reqs(sb, err);
+	atomic_set(&sb_dfr->stat, DFR_SB_STAT_IDLE);
+	dfr_debug("auto defrag done (err %d)", err);
+
+out:
+	if (chunks)
+		free_pages_exact(chunks, size);
+	iput(inode);
+}
+
+/**
+ * @fn		defrag_auto_thread
+ * @brief	periodically defrag recently written files while idle
+ * @return	0
+ * @param	data	super block
+ */
+static int defrag_auto_thread(void *data)
+{
+	struct super_block *sb = data;
+	struct sdfat_sb_info *sbi = SDFAT_SB(sb);
+
+	set_freezable();
+
+	while (!kthread_should_stop()) {
+		schedule_timeout_interruptible(DFR_AUTO_INTERVAL);
+		if (try_to_freeze() || kthread_should_stop())
+			continue;
+
+		if (!READ_ONCE(sbi->dfr_auto) || !READ_ONCE(sbi->dfr_auto_nr))
+			continue;
+
+		if (!defrag_auto_idle(sb))
+			continue;
+
+		/* Never hold off remount or umount */
+		if (!down_read_trylock(&sb->s_umount))
+			continue;
+		if (!sb_rdonly(sb))
+			defrag_auto_run(sb);
+		up_read(&sb->s_umount);
+
+		/* Do not count our own I/O against the next idle check */
+		defrag_auto_idle(sb);
+	}
+
+	return 0;
+}
+
 #endif	/* CONFIG_SDFAT_DFR */
 
 static inline int __do_dfr_map_cluster(struct inode *inode, u32 clu_offset, unsigned int *clus_ptr)
@@ -2049,6 +2271,69 @@ static inline int __dfr_writepage_end_io(struct page *page)
 	return 0;
 }
 
+static inline void __dfr_auto_note(struct inode *inode)
+{
+#ifdef	CONFIG_SDFAT_DFR
+	struct sdfat_sb_info *sbi = SDFAT_SB(inode->i_sb);
+	loff_t i_pos = SDFAT_I(inode)->i_pos;
+	unsigned int i;
+
+	if (!sbi->dfr_auto_task || !READ_ONCE(sbi->dfr_auto))
+		return;
+
+	/* Files with fewer clusters cannot exceed the extent threshold */
+	if (i_size_read(inode) <=
+			(loff_t)sbi->fsi.cluster_size * sbi->dfr_auto_extents)
+		return;
+
+	spin_lock(&sbi->dfr_auto_lock);
+	for (i = 0; i < sbi->dfr_auto_nr; i++)
+		if (sbi->dfr_auto_cand[i] == i_pos)
+			break;
+	if (i == sbi->dfr_auto_nr && i < DFR_AUTO_MAX_CANDIDATES)
+		sbi->dfr_auto_cand[sbi->dfr_auto_nr++] = i_pos;
+	spin_unlock(&sbi->dfr_auto_lock);
+#endif
+}
+
+static inline void __start_dfr_auto_if_required(struct super_block *sb)
+{
+#ifdef	CONFIG_SDFAT_DFR
+	struct sdfat_sb_info *sbi = SDFAT_SB(sb);
+	struct task_struct *task;
+
+	spin_lock_init(&sbi->dfr_auto_lock);
+	sbi->dfr_auto = 1;
+	sbi->dfr_auto_extents = DFR_AUTO_DEFAULT_EXTENTS;
+
+	/* The engine only handles FAT32 with the smart allocator */
+	if (!sbi->options.defrag || (sbi->fsi.vol_type != FAT32) ||
+			!(sbi->options.improved_allocation & SDFAT_ALLOC_SMART) ||
+			!PAGES_PER_CLUS(sb) || sb_rdonly(sb))
+		return;
+
+	task = kthread_run(defrag_auto_thread, sb, "sdfat_dfr-%s", sb->s_id);
+	if (IS_ERR(task)) {
+		sdfat_msg(sb, KERN_WARNING, "failed to start automatic defrag (%ld)",
+				PTR_ERR(task));
+		return;
+	}
+	sbi->dfr_auto_task = task;
+#endif
+}
+
+static inline void __stop_dfr_auto_if_required(struct super_block *sb)
+{
+#ifdef	CONFIG_SDFAT_DFR
+	struct sdfat_sb_info *sbi = SDFAT_SB(sb);
+
+	if (sbi->dfr_auto_task) {
+		kthread_stop(sbi->dfr_auto_task);
+		sbi->dfr_auto_task = NULL;
+	}
+#endif
+}
+
 static inline void __init_dfr_info(struct inode *inode)
 {
 #ifdef	CONFIG_SDFAT_DFR
@@ -3054,6 +3339,9 @@ static int sdfat_file_release(struct inode *inode, struct file *filp)
 	sdfat_debug_bug_on(SDFAT_I(inode)->fid.size != i_size_read(inode));
 	SDFAT_I(inode)->fid.size = i_size_read(inode);
 	fsapi_sync_fs(sb, 0);
+
+	if (filp->f_mode & FMODE_WRITE)
+		__dfr_auto_note(inode);
 	return 0;
 }
 
@@ -4214,6 +4502,7 @@ static void sdfat_put_super(struct super_block *sb)
 	if (__is_sb_dirty(sb))
 		sdfat_write_super(sb);
 
+	__stop_dfr_auto_if_required(sb);
 	__free_dfr_mem_if_required(sb);
 	err = fsapi_umount(sb);
 
@@ -4581,6 +4870,42 @@ static ssize_t fullau_show(struct sdfat_sb_info *sbi, char *buf)
 }
 SDFAT_ATTR(fullau, 0444, fullau_show, NULL);
 
+#ifdef	CONFIG_SDFAT_DFR
+static ssize_t dfr_auto_show(struct sdfat_sb_info *sbi, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%u\n", sbi->dfr_auto);
+}
+
+static ssize_t dfr_auto_store(struct sdfat_sb_info *sbi, const char *buf, size_t len)
+{
+	unsigned int val;
+
+	if (kstrtouint(buf, 10, &val))
+		return -EINVAL;
+
+	WRITE_ONCE(sbi->dfr_auto, !!val);
+	return len;
+}
+SDFAT_ATTR(dfr_auto, 0644, dfr_auto_show, dfr_auto_store);
+
+static ssize_t dfr_auto_extents_show(struct sdfat_sb_info *sbi, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%u\n", sbi->dfr_auto_extents);
+}
+
+static ssize_t dfr_auto_extents_store(struct sdfat_sb_info *sbi, const char *buf, size_t len)
+{
+	unsigned int val;
+
+	if (kstrtouint(buf, 10, &val) || !val)
+		return -EINVAL;
+
+	WRITE_ONCE(sbi->dfr_auto_extents, val);
+	return len;
+}
+SDFAT_ATTR(dfr_auto_extents, 0644, dfr_auto_extents_show, dfr_auto_extents_store);
+#endif
+
 static struct attribute *sdfat_attrs[] = {
 	&sdfat_attr_type.attr,
 	&sdfat_attr_eio.attr,
@@ -4588,6 +4913,10 @@ static struct attribute *sdfat_attrs[] = {
 	&sdfat_attr_totalau.attr,
 	&sdfat_attr_cleanau.attr,
 	&sdfat_attr_fullau.attr,
+#ifdef	CONFIG_SDFAT_DFR
+	&sdfat_attr_dfr_auto.attr,
+	&sdfat_attr_dfr_auto_extents.attr,
+#endif
 	NULL,
 };
 
@@ -5094,6 +5423,8 @@ static int sdfat_fill_super(struct super_block *sb, void *data, int silent)
 		goto failed_mount3;
 	}
 
+	__start_dfr_auto_if_required(sb);
+
 	sdfat_log_msg(sb, KERN_INFO, "mounted successfully!");
 	/* FOR BIGDATA */
 	sdfat_statistics_set_mnt(&sbi->fsi);
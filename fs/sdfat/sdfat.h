@@ -176,6 +176,15 @@ struct sdfat_sb_info {
 	unsigned int dfr_hint_idx;
 	int dfr_reserved_clus;
 
+	/* Automatic defrag of recently written files */
+	struct task_struct *dfr_auto_task;
+	unsigned int dfr_auto;
+	unsigned int dfr_auto_extents;
+	spinlock_t dfr_auto_lock;
+	loff_t dfr_auto_cand[DFR_AUTO_MAX_CANDIDATES];
+	unsigned int dfr_auto_nr;
+	unsigned long dfr_auto_ios;
+
 #ifdef	CONFIG_SDFAT_DFR_DEBUG
 	int dfr_spo_flag;
 #endif  /* CONFIG_SDFAT_DFR_DEBUG */
@@ -141,6 +141,11 @@ struct backing_dev_info {
 	struct list_head bdi_list;
 	unsigned long ra_pages;	/* max readahead in PAGE_SIZE units */
 	unsigned long io_pages;	/* max allowed IO size */
+	unsigned int ra_adaptive; /* scale per-file readahead windows */
+	atomic_long_t ra_hit_pages;	/* readahead pages used */
+	atomic_long_t ra_miss_pages;	/* readahead pages wasted */
+	atomic_long_t ra_grown;		/* per-file windows grown */
+	atomic_long_t ra_shrunk;	/* per-file windows shrunk */
 	unsigned int capabilities; /* Device capabilities */
 	congested_fn *congested_fn; /* Function pointer if device is md/dm */
 	void *congested_data;	/* Pointer to aux data for congested func */
@@ -214,6 +214,8 @@ enum rq_flag_bits {
 	__REQ_HASHED,		/* on IO scheduler merge hash */
 	__REQ_MQ_INFLIGHT,	/* track inflight for MQ */
 	__REQ_URGENT,		/* urgent request */
+	__REQ_MQ_ASYNC,		/* counted against the MQ async depth */
+	__REQ_WBT,		/* counted against the writeback depth */
 	__REQ_NR_BITS,		/* stops here */
 };
 
@@ -263,6 +265,8 @@ enum rq_flag_bits {
 #define REQ_PM			(1ULL << __REQ_PM)
 #define REQ_HASHED		(1ULL << __REQ_HASHED)
 #define REQ_MQ_INFLIGHT		(1ULL << __REQ_MQ_INFLIGHT)
+#define REQ_MQ_ASYNC		(1ULL << __REQ_MQ_ASYNC)
+#define REQ_WBT			(1ULL << __REQ_WBT)
 
 enum req_op {
 	REQ_OP_READ,
@@ -36,6 +36,7 @@ struct sg_io_hdr;
 struct bsg_job;
 struct blkcg_gq;
 struct blk_flush_queue;
+struct rq_wb;
 struct pr_ops;
 
 #define BLKDEV_MIN_RQ	4
@@ -156,6 +157,9 @@ struct request {
 	struct request_list *rl;		/* rl this rq is alloced from */
 	unsigned long long start_time_ns;
 	unsigned long long io_start_time_ns;    /* when passed to hardware */
+#endif
+#ifdef CONFIG_BLK_WBT
+	u64 wbt_issue_ns;			/* read issue time, for wbt */
 #endif
 	/* Number of scatter-gather DMA addr+len pairs after
 	 * physical address coalescing is performed.
@@ -486,6 +490,15 @@ struct request_queue {
 	struct bio_set		*bio_split;
 
 	bool			mq_sysfs_init_done;
+
+#ifdef CONFIG_BLK_MQ_INTERACTIVE
+	unsigned int		mq_async_depth;
+	atomic_t		mq_async_inflight;
+	wait_queue_head_t	mq_async_wait;
+#endif
+#ifdef CONFIG_BLK_WBT
+	struct rq_wb		*rq_wb;
+#endif
 };
 
 #define QUEUE_FLAG_QUEUED	1	/* uses generic tag queueing */
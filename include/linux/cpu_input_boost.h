@@ -16,6 +16,8 @@
 #ifdef CONFIG_CPU_INPUT_BOOST
 void cpu_input_boost_kick(void);
 void cpu_input_boost_kick_max(unsigned int duration_ms);
+void cpu_input_boost_frame_event(void);
+bool cpu_input_boost_active(void);
 #else
 static inline void cpu_input_boost_kick(void)
 {
@@ -23,6 +25,25 @@ static inline void cpu_input_boost_kick(void)
 static inline void cpu_input_boost_kick_max(unsigned int duration_ms)
 {
 }
+static inline void cpu_input_boost_frame_event(void)
+{
+}
+static inline bool cpu_input_boost_active(void)
+{
+	return false;
+}
+#endif
+
+#if defined(CONFIG_CPU_INPUT_BOOST) && defined(CONFIG_BOOST_BROKER)
+void cpu_input_boost_set(bool boost);
+void cpu_input_boost_screen_event(bool awake);
+#else
+static inline void cpu_input_boost_set(bool boost)
+{
+}
+static inline void cpu_input_boost_screen_event(bool awake)
+{
+}
 #endif
 
 #endif /* _CPU_INPUT_BOOST_H_ */
@@ -116,6 +116,7 @@ static inline int cpuset_do_slab_mem_spread(void)
 }
 
 extern int current_cpuset_is_being_rebound(void);
+extern bool current_cpuset_is_top_app(void);
 
 extern void rebuild_sched_domains(void);
 
@@ -255,6 +256,11 @@ static inline int current_cpuset_is_being_rebound(void)
 	return 0;
 }
 
+static inline bool current_cpuset_is_top_app(void)
+{
+	return false;
+}
+
 static inline void rebuild_sched_domains(void)
 {
 	partition_sched_domains(1, NULL, NULL);
@@ -32,4 +32,18 @@ void devfreq_register_boost_device(enum df_device device, struct devfreq *df)
 }
 #endif
 
+#if defined(CONFIG_DEVFREQ_BOOST) && defined(CONFIG_BOOST_BROKER)
+void devfreq_boost_set(enum df_device device, bool boost);
+void devfreq_boost_screen_event(bool awake);
+#else
+static inline
+void devfreq_boost_set(enum df_device device, bool boost)
+{
+}
+static inline
+void devfreq_boost_screen_event(bool awake)
+{
+}
+#endif
+
 #endif /* _DEVFREQ_BOOST_H_ */
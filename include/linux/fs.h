@@ -898,6 +898,8 @@ struct file_ra_state {
 	unsigned int ra_pages;		/* Maximum readahead window */
 	unsigned int mmap_miss;		/* Cache miss stat for mmap accesses */
 	loff_t prev_pos;		/* Cache last read() position */
+	unsigned int hit_pages;		/* Readahead pages used, and */
+	unsigned int miss_pages;	/* wasted, since last resize */
 };
 
 /*
@@ -1464,6 +1466,7 @@ struct super_block {
 	 * own individual cachelines.
 	 */
 	struct list_lru		s_dentry_lru ____cacheline_aligned_in_smp;
+	struct list_lru		s_dentry_neg_lru ____cacheline_aligned_in_smp;
 	struct list_lru		s_inode_lru ____cacheline_aligned_in_smp;
 	struct rcu_head		rcu;
 	struct work_struct	destroy_work;
@@ -150,6 +150,15 @@ static inline void clear_user_highpage(struct page *page, unsigned long vaddr)
 }
 #endif
 
+#ifdef CONFIG_ZERO_PAGE_POOL
+extern struct page *zero_pool_get(void);
+#else
+static inline struct page *zero_pool_get(void)
+{
+	return NULL;
+}
+#endif
+
 #ifndef __HAVE_ARCH_ALLOC_ZEROED_USER_HIGHPAGE
 /**
  * __alloc_zeroed_user_highpage - Allocate a zeroed HIGHMEM page for a VMA with caller-specified movable GFP flags
@@ -170,9 +179,15 @@ __alloc_zeroed_user_highpage(gfp_t movableflags,
 			struct vm_area_struct *vma,
 			unsigned long vaddr)
 {
-	struct page *page = alloc_page_vma(GFP_HIGHUSER | movableflags,
-			vma, vaddr);
+	struct page *page;
+
+	if (movableflags & __GFP_MOVABLE) {
+		page = zero_pool_get();
+		if (page)
+			return page;
+	}
 
+	page = alloc_page_vma(GFP_HIGHUSER | movableflags, vma, vaddr);
 	if (page)
 		clear_user_highpage(page, vaddr);
 
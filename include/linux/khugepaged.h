@@ -14,6 +14,7 @@ extern void __khugepaged_exit(struct mm_struct *mm);
 extern int khugepaged_enter_vma_merge(struct vm_area_struct *vma,
 				      unsigned long vm_flags);
 extern void khugepaged_min_free_kbytes_update(void);
+extern int khugepaged_mm_set_hugepage(struct mm_struct *mm, bool enable);
 
 #define khugepaged_enabled()					       \
 	(transparent_hugepage_flags &				       \
@@ -75,6 +76,11 @@ static inline int khugepaged_enter_vma_merge(struct vm_area_struct *vma,
 static inline void khugepaged_min_free_kbytes_update(void)
 {
 }
+static inline int khugepaged_mm_set_hugepage(struct mm_struct *mm,
+					     bool enable)
+{
+	return -EINVAL;
+}
 #endif /* CONFIG_TRANSPARENT_HUGEPAGE */
 
 #endif /* _LINUX_KHUGEPAGED_H */
@@ -21,6 +21,7 @@ int ksm_madvise(struct vm_area_struct *vma, unsigned long start,
 		unsigned long end, int advice, unsigned long *vm_flags);
 int __ksm_enter(struct mm_struct *mm);
 void __ksm_exit(struct mm_struct *mm);
+int ksm_mm_set_mergeable(struct mm_struct *mm, bool mergeable);
 
 static inline int ksm_fork(struct mm_struct *mm, struct mm_struct *oldmm)
 {
@@ -0,0 +1,37 @@
+#ifndef _LINUX_KSTATS_H
+#define _LINUX_KSTATS_H
+
+#include <linux/list.h>
+#include <linux/types.h>
+#include <uapi/linux/kstats.h>
+
+/**
+ * struct kstats_source - a record type of the /proc/kstats snapshot
+ * @type: one of enum kstats_type
+ * @version: of the payload layout
+ * @max_len: upper bound of the payload length
+ * @fill: collects the payload into @buf of @max_len bytes; returns its
+ *	length or a negative errno, in which case the record is left out.
+ *	Called in process context, sources are filled one at a time.
+ */
+struct kstats_source {
+	struct list_head list;
+	u16 type;
+	u16 version;
+	size_t max_len;
+	int (*fill)(void *buf, size_t max_len);
+};
+
+#ifdef CONFIG_KSTATS
+extern void kstats_register_source(struct kstats_source *src);
+extern void kstats_unregister_source(struct kstats_source *src);
+#else
+static inline void kstats_register_source(struct kstats_source *src)
+{
+}
+static inline void kstats_unregister_source(struct kstats_source *src)
+{
+}
+#endif
+
+#endif /* _LINUX_KSTATS_H */
@@ -0,0 +1,13 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LINUX_LAUNCH_PREFETCH_H
+#define _LINUX_LAUNCH_PREFETCH_H
+
+#ifdef CONFIG_LAUNCH_PREFETCH
+void launch_prefetch_exec(const char *filename);
+#else
+static inline void launch_prefetch_exec(const char *filename)
+{
+}
+#endif
+
+#endif /* _LINUX_LAUNCH_PREFETCH_H */
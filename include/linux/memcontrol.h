@@ -127,6 +127,8 @@ struct mem_cgroup_per_node {
 	struct rb_node		tree_node;	/* RB tree node */
 	unsigned long		usage_in_excess;/* Set to the value by which */
 						/* the soft limit is exceeded*/
+	unsigned int		soft_tier;	/* soft_reclaim_tier when */
+						/* inserted in the tree    */
 	bool			on_tree;
 	struct mem_cgroup	*memcg;		/* Back pointer, we cannot */
 						/* use container_of	   */
@@ -193,6 +195,10 @@ struct mem_cgroup {
 	struct work_struct high_work;
 
 	unsigned long soft_limit;
+	/* Soft limit reclaim takes higher tiers first, 0 is the default */
+	unsigned int soft_reclaim_tier;
+	/* Reclaim leaves the page cache alone while it can scan anon */
+	bool protect_file;
 
 	/* vmpressure notifications */
 	struct vmpressure vmpressure;
@@ -298,6 +304,11 @@ static inline void mem_cgroup_events(struct mem_cgroup *memcg,
 
 bool mem_cgroup_low(struct mem_cgroup *root, struct mem_cgroup *memcg);
 
+static inline bool mem_cgroup_protect_file(struct mem_cgroup *memcg)
+{
+	return memcg && READ_ONCE(memcg->protect_file);
+}
+
 int mem_cgroup_try_charge(struct page *page, struct mm_struct *mm,
 			  gfp_t gfp_mask, struct mem_cgroup **memcgp,
 			  bool compound);
@@ -619,6 +630,11 @@ static inline bool mem_cgroup_low(struct mem_cgroup *root,
 	return false;
 }
 
+static inline bool mem_cgroup_protect_file(struct mem_cgroup *memcg)
+{
+	return false;
+}
+
 static inline int mem_cgroup_try_charge(struct page *page, struct mm_struct *mm,
 					gfp_t gfp_mask,
 					struct mem_cgroup **memcgp,
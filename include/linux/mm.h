@@ -2502,6 +2502,7 @@ extern bool process_shares_mm(struct task_struct *p, struct mm_struct *mm);
 
 #ifdef CONFIG_SYSCTL
 extern int sysctl_drop_caches;
+extern int sysctl_fault_io_boost;
 int drop_caches_sysctl_handler(struct ctl_table *, int,
 					void __user *, size_t *, loff_t *);
 #endif
@@ -2665,6 +2666,23 @@ struct reclaim_param {
 };
 extern struct reclaim_param reclaim_task_anon(struct task_struct *task,
 		int nr_to_reclaim);
+
+static inline void mm_reclaim_stat_init(struct mm_struct *mm)
+{
+	atomic_long_set(&mm->swap_refaults, 0);
+	mm->reclaim_refault_base = 0;
+	mm->reclaim_nr = 0;
+	mm->reclaim_stamp = 0;
+	mm->reclaim_cold_pct = 100;
+}
+
+static inline void mm_count_swap_refault(struct mm_struct *mm)
+{
+	atomic_long_inc(&mm->swap_refaults);
+}
+#else
+static inline void mm_reclaim_stat_init(struct mm_struct *mm) {}
+static inline void mm_count_swap_refault(struct mm_struct *mm) {}
 #endif
 
 #endif /* __KERNEL__ */
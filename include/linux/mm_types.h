@@ -370,6 +370,9 @@ struct vm_area_struct {
 	struct mempolicy *vm_policy;	/* NUMA policy for the VMA */
 #endif
 	struct vm_userfaultfd_ctx vm_userfaultfd_ctx;
+	/* Adaptive fault-around state, see do_read_fault() */
+	pgoff_t vm_fault_around_last;
+	unsigned char vm_fault_around_order;
 #ifdef CONFIG_SPECULATIVE_PAGE_FAULT
 	seqcount_t vm_sequence;
 	atomic_t vm_ref_count;		/* see vma_get(), vma_put() */
@@ -540,6 +543,19 @@ struct mm_struct {
 #endif
 #ifdef CONFIG_HUGETLB_PAGE
 	atomic_long_t hugetlb_usage;
+#endif
+#ifdef CONFIG_PROCESS_RECLAIM
+	/* Anon pages faulted back in from swap */
+	atomic_long_t swap_refaults;
+	/*
+	 * process_reclaim efficiency accounting: pages reclaimed in the
+	 * current refault window, swap_refaults and jiffies at its start,
+	 * and the running estimate of how many reclaimed pages stay cold.
+	 */
+	unsigned long reclaim_refault_base;
+	unsigned long reclaim_nr;
+	unsigned long reclaim_stamp;
+	unsigned int reclaim_cold_pct;
 #endif
 	struct work_struct async_put_work;
 };
@@ -16,6 +16,7 @@
 
 #include <linux/devfreq.h>
 #include <linux/notifier.h>
+#include <linux/spinlock.h>
 
 #define DEVFREQ_FLAG_WAKEUP_MAXFREQ	0x2
 #define DEVFREQ_FLAG_FAST_HINT		0x4
@@ -55,6 +56,11 @@ struct devfreq_msm_adreno_tz_data {
 		unsigned int *index;
 		uint64_t *ib;
 	} bus;
+	struct {
+		spinlock_t lock;
+		u64 max_ns;	/* longest frame GPU time since last sample */
+		u32 nr;		/* frames completed since last sample */
+	} frame;
 	unsigned int device_id;
 	bool is_64;
 	bool disable_busy_time_burst;
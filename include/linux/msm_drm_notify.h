@@ -42,4 +42,6 @@ struct msm_drm_notifier {
 
 int msm_drm_register_client(struct notifier_block *nb);
 int msm_drm_unregister_client(struct notifier_block *nb);
+unsigned int msm_drm_get_refresh_rate(void);
+void msm_drm_set_refresh_rate(unsigned int refresh_rate);
 #endif
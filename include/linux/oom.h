@@ -93,6 +93,17 @@ extern void dump_tasks(struct mem_cgroup *memcg,
 
 extern void wake_oom_reaper(struct task_struct *tsk);
 
+struct notifier_block;
+
+/* Passed to oom reap notifiers once the reaper is done with a victim */
+struct oom_reap_info {
+	struct task_struct *tsk;
+	unsigned long reaped_pages;
+};
+
+extern int register_oom_reap_notifier(struct notifier_block *nb);
+extern int unregister_oom_reap_notifier(struct notifier_block *nb);
+
 /* sysctls */
 extern int sysctl_oom_dump_tasks;
 extern int sysctl_oom_kill_allocating_task;
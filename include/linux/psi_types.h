@@ -123,6 +123,10 @@ struct psi_trigger {
 
 	/* Refcounting to prevent premature destruction */
 	struct kref refcount;
+
+	/* Optional in-kernel consumer, called from the psimon thread */
+	void (*notify)(void *data);
+	void *notify_data;
 };
 
 struct psi_group {
@@ -1155,11 +1155,19 @@ struct idle_state {
 	unsigned long power;	 /* power consumption in this idle state */
 };
 
+/*
+ * Utilization buckets of the capacity state lookup table: each entry holds
+ * the lowest capacity state able to serve the bucket's lowest utilization.
+ */
+#define SGE_CAP_LUT_SHIFT	5
+#define SGE_CAP_LUT_SIZE	((SCHED_CAPACITY_SCALE >> SGE_CAP_LUT_SHIFT) + 1)
+
 struct sched_group_energy {
 	unsigned int nr_idle_states;	/* number of idle states */
 	struct idle_state *idle_states;	/* ptr to idle state array */
 	unsigned int nr_cap_states;	/* number of capacity states */
 	struct capacity_state *cap_states; /* ptr to capacity state array */
+	u8 cap_idx_lut[SGE_CAP_LUT_SIZE]; /* util bucket -> first cap state */
 };
 
 extern bool sched_is_energy_aware(void);
@@ -1737,6 +1745,10 @@ struct task_struct {
 	struct list_head grp_list;
 	u64 cpu_cycles;
 	bool misfit;
+	/* Repeated wakee tracking for automatic colocation */
+	struct task_struct *coloc_wakee;
+	u64 coloc_wakee_ts;
+	unsigned int coloc_wakee_count;
 #endif
 
 #ifdef CONFIG_CGROUP_SCHED
@@ -1811,6 +1823,7 @@ struct task_struct {
 	/* unserialized, strictly 'current' */
 	unsigned in_execve:1; /* bit to tell LSMs we're in execve */
 	unsigned in_iowait:1;
+	unsigned in_fault_io_boost:1; /* reads are for a foreground fault */
 #if !defined(TIF_RESTORE_SIGMASK)
 	unsigned restore_sigmask:1;
 #endif
@@ -42,6 +42,8 @@ struct kmem_cache_cpu {
 	unsigned long tid;	/* Globally unique transaction id */
 	struct page *page;	/* The slab from which we are allocating */
 	struct page *partial;	/* Partially allocated frozen slabs */
+	unsigned int slow_allocs;	/* Allocations that took the slowpath */
+	unsigned int slow_frees;	/* Frees that took the slowpath */
 #ifdef CONFIG_SLUB_STATS
 	unsigned stat[NR_SLUB_STAT_ITEMS];
 #endif
@@ -69,6 +71,9 @@ struct kmem_cache {
 	int offset;		/* Free pointer offset. */
 	/* Number of per cpu partial objects to keep around */
 	unsigned int cpu_partial;
+	/* cpu_partial before adaptive scaling, and last slowpath count */
+	unsigned int cpu_partial_base;
+	unsigned int slow_allocs_last;
 	struct kmem_cache_order_objects oo;
 
 	/* Allocation and freeing of slabs */
@@ -95,6 +95,13 @@ int llcc_slice_activate(struct llcc_slice_desc *desc);
  */
 int llcc_slice_deactivate(struct llcc_slice_desc *desc);
 
+/**
+ * llcc_slice_resize - Change the capacity of the llcc slice
+ * @desc: Pointer to llcc slice descriptor
+ * @size: New capacity in KB
+ */
+int llcc_slice_resize(struct llcc_slice_desc *desc, size_t size);
+
 /**
  * qcom_llcc_probe - program the sct table
  * @pdev: platform device pointer
@@ -137,6 +144,11 @@ static inline int llcc_slice_deactivate(struct llcc_slice_desc *desc)
 {
 	return -EINVAL;
 }
+
+static inline int llcc_slice_resize(struct llcc_slice_desc *desc, size_t size)
+{
+	return -EINVAL;
+}
 static inline int qcom_llcc_probe(struct platform_device *pdev,
 		      const struct llcc_slice_config *table, u32 sz)
 {
@@ -0,0 +1,86 @@
+#ifndef _NET_RX_LATENCY_H
+#define _NET_RX_LATENCY_H
+
+#include <linux/jump_label.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+
+struct sock;
+
+/*
+ * Receive latency instrumentation. Drivers stamp skb->tstamp when the
+ * hardware completes a buffer and every later stage accounts the time since
+ * then into a log2 histogram of the interface the packet arrived on. Only
+ * interfaces that called netdev_rx_latency_alloc() are accounted.
+ */
+enum rx_latency_stage {
+	RX_LAT_RMNET,		/* delivered to an rmnet_data interface */
+	RX_LAT_GRO,		/* flushed out of GRO */
+	RX_LAT_SOCK,		/* queued to the receiving socket */
+	RX_LAT_NR_STAGES,
+};
+
+/* Bucket 0 counts packets below 1 usec, bucket n those below 2^n usec */
+#define RX_LAT_NR_BUCKETS	20
+
+struct rx_latency_stats {
+	u64	hist[RX_LAT_NR_STAGES][RX_LAT_NR_BUCKETS];
+	u64	sum_us[RX_LAT_NR_STAGES];
+};
+
+#ifdef CONFIG_NET_RX_LATENCY
+extern struct static_key_false rx_latency_enabled;
+
+int netdev_rx_latency_alloc(struct net_device *dev);
+void netdev_rx_latency_free(struct net_device *dev);
+void __rx_latency_record(struct net_device *dev, const struct sk_buff *skb,
+			 enum rx_latency_stage stage);
+void __rx_latency_record_sk(const struct sock *sk, const struct sk_buff *skb);
+
+static inline void rx_latency_stamp(struct sk_buff *skb)
+{
+	if (static_branch_unlikely(&rx_latency_enabled))
+		__net_timestamp(skb);
+}
+
+static inline void rx_latency_record(struct net_device *dev,
+				     const struct sk_buff *skb,
+				     enum rx_latency_stage stage)
+{
+	if (static_branch_unlikely(&rx_latency_enabled) && dev->rx_lat)
+		__rx_latency_record(dev, skb, stage);
+}
+
+static inline void rx_latency_record_sk(const struct sock *sk,
+					const struct sk_buff *skb)
+{
+	if (static_branch_unlikely(&rx_latency_enabled) && skb->skb_iif)
+		__rx_latency_record_sk(sk, skb);
+}
+#else
+static inline int netdev_rx_latency_alloc(struct net_device *dev)
+{
+	return 0;
+}
+
+static inline void netdev_rx_latency_free(struct net_device *dev)
+{
+}
+
+static inline void rx_latency_stamp(struct sk_buff *skb)
+{
+}
+
+static inline void rx_latency_record(struct net_device *dev,
+				     const struct sk_buff *skb,
+				     enum rx_latency_stage stage)
+{
+}
+
+static inline void rx_latency_record_sk(const struct sock *sk,
+					const struct sk_buff *skb)
+{
+}
+#endif
+
+#endif /* _NET_RX_LATENCY_H */
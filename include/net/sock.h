@@ -70,6 +70,7 @@
 #include <net/checksum.h>
 #include <net/tcp_states.h>
 #include <linux/net_tstamp.h>
+#include <net/rx_latency.h>
 
 /*
  * This structure really needs to be cleaned up.
@@ -1972,6 +1973,7 @@ static inline void skb_set_owner_r(struct sk_buff *skb, struct sock *sk)
 	skb->destructor = sock_rfree;
 	atomic_add(skb->truesize, &sk->sk_rmem_alloc);
 	sk_mem_charge(sk, skb->truesize);
+	rx_latency_record_sk(sk, skb);
 }
 
 void sk_reset_timer(struct sock *sk, struct timer_list *timer,
@@ -265,6 +265,9 @@ unsigned int udp_poll(struct file *file, struct socket *sock, poll_table *wait);
 struct sk_buff *skb_udp_tunnel_segment(struct sk_buff *skb,
 				       netdev_features_t features,
 				       bool is_ipv6);
+struct sk_buff *__udp_gso_segment(struct sk_buff *gso_skb,
+				  netdev_features_t features);
+int udp_cmsg_send(struct sock *sk, struct msghdr *msg, u16 *gso_size);
 int udp_lib_getsockopt(struct sock *sk, int level, int optname,
 		       char __user *optval, int __user *optlen);
 int udp_lib_setsockopt(struct sock *sk, int level, int optname,
@@ -320,6 +323,53 @@ do {									\
 #define __UDPX_INC_STATS(sk, field) __UDP_INC_STATS(sock_net(sk), field, 0)
 #endif
 
+/* GRO aggregates are only built for sockets with UDP_GRO set, anything
+ * else gets the datagrams one by one.
+ */
+static inline bool udp_unexpected_gso(struct sock *sk, struct sk_buff *skb)
+{
+	return (!udp_sk(sk)->gro_enabled || udp_sk(sk)->encap_type) &&
+	       skb_is_gso(skb) &&
+	       skb_shinfo(skb)->gso_type & SKB_GSO_UDP_L4;
+}
+
+static inline struct sk_buff *udp_rcv_segment(struct sock *sk,
+					      struct sk_buff *skb)
+{
+	struct sk_buff *segs, *seg;
+
+	/* the GSO CB lays after the UDP one, no need to save and restore any
+	 * CB fragment
+	 */
+	segs = __skb_gso_segment(skb, NETIF_F_SG | NETIF_F_HW_CSUM, false);
+	if (unlikely(IS_ERR_OR_NULL(segs))) {
+		atomic_add(skb_shinfo(skb)->gso_segs, &sk->sk_drops);
+		__UDPX_INC_STATS(sk, UDP_MIB_INERRORS);
+		kfree_skb(skb);
+		return NULL;
+	}
+
+	/* GRO has verified the checksum of every segment it merged */
+	for (seg = segs; seg; seg = seg->next) {
+		seg->ip_summed = CHECKSUM_UNNECESSARY;
+		seg->csum_level = 0;
+	}
+
+	consume_skb(skb);
+	return segs;
+}
+
+static inline void udp_cmsg_recv(struct msghdr *msg, struct sock *sk,
+				 struct sk_buff *skb)
+{
+	int gso_size;
+
+	if (skb_shinfo(skb)->gso_type & SKB_GSO_UDP_L4) {
+		gso_size = skb_shinfo(skb)->gso_size;
+		put_cmsg(msg, SOL_UDP, UDP_GRO, sizeof(gso_size), &gso_size);
+	}
+}
+
 /* /proc */
 int udp_seq_open(struct inode *inode, struct file *file);
 
@@ -44,7 +44,13 @@ static inline phys_addr_t msm_timer_get_pa(void) { return 0; }
 #ifdef CONFIG_MSM_BOOT_TIME_MARKER
 static inline int boot_marker_enabled(void) { return 1; }
 void place_marker(const char *name);
+__printf(2, 3)
+void place_duration_marker(unsigned long long duration_us,
+		const char *fmt, ...);
 #else
 static inline void place_marker(char *name) { };
 static inline int boot_marker_enabled(void) { return 0; }
+static inline __printf(2, 3)
+void place_duration_marker(unsigned long long duration_us,
+		const char *fmt, ...) { }
 #endif
@@ -174,6 +174,42 @@ TRACE_EVENT(block_rq_complete,
 		  __entry->nr_sector, __entry->errors)
 );
 
+/**
+ * block_rq_latency - block IO operation accounted as done
+ * @rq: block IO operation request
+ * @latency: time from allocation to completion, in nanoseconds
+ *
+ * Emitted once per accounted request, so that a hist trigger keyed on
+ * the device can aggregate completion latency per disk.
+ */
+TRACE_EVENT(block_rq_latency,
+
+	TP_PROTO(struct request *rq, u64 latency),
+
+	TP_ARGS(rq, latency),
+
+	TP_STRUCT__entry(
+		__field(  dev_t,	dev			)
+		__field(  unsigned int,	nr_sector		)
+		__field(  u64,		latency			)
+		__array(  char,		rwbs,	RWBS_LEN	)
+	),
+
+	TP_fast_assign(
+		__entry->dev	   = rq->rq_disk ? disk_devt(rq->rq_disk) : 0;
+		__entry->nr_sector = blk_rq_sectors(rq);
+		__entry->latency   = latency;
+
+		blk_fill_rwbs(__entry->rwbs, req_op(rq), rq->cmd_flags,
+			      blk_rq_bytes(rq));
+	),
+
+	TP_printk("%d,%d %s %u latency=%llu [ns]",
+		  MAJOR(__entry->dev), MINOR(__entry->dev),
+		  __entry->rwbs, __entry->nr_sector,
+		  (unsigned long long)__entry->latency)
+);
+
 DECLARE_EVENT_CLASS(block_rq,
 
 	TP_PROTO(struct request_queue *q, struct request *rq),
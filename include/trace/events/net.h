@@ -33,7 +33,7 @@ TRACE_EVENT(net_dev_start_xmit,
 		__field(	u8,			tx_flags	)
 		__field(	u16,			gso_size	)
 		__field(	u16,			gso_segs	)
-		__field(	u16,			gso_type	)
+		__field(	u32,			gso_type	)
 	),
 
 	TP_fast_assign(
@@ -162,7 +162,7 @@ DECLARE_EVENT_CLASS(net_dev_rx_verbose_template,
 		__field(	int,			mac_header	)
 		__field(	unsigned char,		nr_frags	)
 		__field(	u16,			gso_size	)
-		__field(	u16,			gso_type	)
+		__field(	u32,			gso_type	)
 	),
 
 	TP_fast_assign(
@@ -82,6 +82,36 @@ DEFINE_EVENT(spf, spf_pmd_changed,
 	TP_ARGS(caller, vma, address)
 );
 
+/*
+ * Time spent handling a page fault, emitted once the fault returns so
+ * that a hist trigger can aggregate fault latency per task.
+ */
+TRACE_EVENT(mm_fault_latency,
+
+	TP_PROTO(unsigned long address, unsigned int flags, int ret,
+		 u64 latency),
+
+	TP_ARGS(address, flags, ret, latency),
+
+	TP_STRUCT__entry(
+		__field(unsigned long, address)
+		__field(unsigned int, flags)
+		__field(int, ret)
+		__field(u64, latency)
+	),
+
+	TP_fast_assign(
+		__entry->address	= address;
+		__entry->flags		= flags;
+		__entry->ret		= ret;
+		__entry->latency	= latency;
+	),
+
+	TP_printk("address:%lx flags:%x ret:%x latency:%llu [ns]",
+		  __entry->address, __entry->flags, __entry->ret,
+		  (unsigned long long)__entry->latency)
+);
+
 #endif /* _TRACE_PAGEFAULT_H */
 
 /* This part must be outside protection */
@@ -1156,6 +1156,14 @@ DEFINE_EVENT(sched_stat_template, sched_stat_wait,
 	     TP_PROTO(struct task_struct *tsk, u64 delay),
 	     TP_ARGS(tsk, delay));
 
+/*
+ * Tracepoint for the time a task of any class spent runnable on a
+ * runqueue before getting the CPU, sampled by sched_info.
+ */
+DEFINE_EVENT(sched_stat_template, sched_run_delay,
+	     TP_PROTO(struct task_struct *tsk, u64 delay),
+	     TP_ARGS(tsk, delay));
+
 /*
  * Tracepoint for accounting sleep time (time the task is not runnable,
  * including iowait, see below).
@@ -1513,6 +1521,43 @@ TRACE_EVENT(sched_load_avg_cpu,
 		  __entry->util_avg_pelt, __entry->util_avg_walt)
 );
 
+#ifdef CONFIG_SCHED_SIGNAL_REPLAY
+/*
+ * Tracepoint for each step of the PELT/WALT signal replay harness.
+ */
+TRACE_EVENT(sched_replay_step,
+
+	TP_PROTO(u64 time_us, u32 run_us, unsigned long util_pelt,
+		 unsigned long util_walt, unsigned long freq_pelt,
+		 unsigned long freq_walt),
+
+	TP_ARGS(time_us, run_us, util_pelt, util_walt, freq_pelt, freq_walt),
+
+	TP_STRUCT__entry(
+		__field( u64,		time_us			)
+		__field( u32,		run_us			)
+		__field( unsigned long,	util_pelt		)
+		__field( unsigned long,	util_walt		)
+		__field( unsigned long,	freq_pelt		)
+		__field( unsigned long,	freq_walt		)
+	),
+
+	TP_fast_assign(
+		__entry->time_us	= time_us;
+		__entry->run_us		= run_us;
+		__entry->util_pelt	= util_pelt;
+		__entry->util_walt	= util_walt;
+		__entry->freq_pelt	= freq_pelt;
+		__entry->freq_walt	= freq_walt;
+	),
+
+	TP_printk("time_us=%llu run_us=%u util_pelt=%lu util_walt=%lu "
+		  "freq_pelt=%lu freq_walt=%lu",
+		  __entry->time_us, __entry->run_us, __entry->util_pelt,
+		  __entry->util_walt, __entry->freq_pelt, __entry->freq_walt)
+);
+#endif /* CONFIG_SCHED_SIGNAL_REPLAY */
+
 /*
  * Tracepoint for sched_tune_config settings
  */
@@ -0,0 +1,91 @@
+#ifndef _UAPI_LINUX_KSTATS_H
+#define _UAPI_LINUX_KSTATS_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+#define KSTATS_MAGIC		0x4b535453	/* "KSTS" */
+#define KSTATS_VERSION		1
+
+/*
+ * A snapshot of /proc/kstats is a struct kstats_header followed by
+ * nr_records records. Each record is a struct kstats_record followed by
+ * len bytes of payload, padded to 8 bytes; a reader skips record types
+ * it does not know. Timestamps are CLOCK_BOOTTIME in nanoseconds.
+ */
+struct kstats_header {
+	__u32 magic;
+	__u16 version;
+	__u16 nr_records;
+	__u32 len;		/* of the whole snapshot, header included */
+	__u32 reserved;
+	__u64 timestamp_ns;	/* when the snapshot was started */
+};
+
+struct kstats_record {
+	__u16 type;
+	__u16 version;		/* of the payload layout of this type */
+	__u32 len;		/* of the payload */
+	__u64 timestamp_ns;	/* when the payload was collected */
+};
+
+enum kstats_type {
+	/* __u64 counters in the order of /proc/vmstat */
+	KSTATS_TYPE_VMSTAT	= 1,
+	/* struct kstats_psi */
+	KSTATS_TYPE_PSI		= 2,
+	/* struct kstats_cpu for each possible CPU */
+	KSTATS_TYPE_CPU		= 3,
+	/* struct kstats_lmk */
+	KSTATS_TYPE_LMK		= 4,
+};
+
+enum kstats_psi_state {
+	KSTATS_PSI_IO_SOME,
+	KSTATS_PSI_IO_FULL,
+	KSTATS_PSI_MEM_SOME,
+	KSTATS_PSI_MEM_FULL,
+	KSTATS_PSI_CPU_SOME,
+	KSTATS_PSI_CPU_FULL,	/* always 0 */
+	KSTATS_PSI_NR_STATES,
+};
+
+/* System wide pressure, averages in hundredths of a percent */
+struct kstats_psi {
+	__u64 total_us[KSTATS_PSI_NR_STATES];
+	__u32 avg10[KSTATS_PSI_NR_STATES];
+	__u32 avg60[KSTATS_PSI_NR_STATES];
+	__u32 avg300[KSTATS_PSI_NR_STATES];
+};
+
+struct kstats_cpu {
+	__u32 cpu;
+	__u32 online;
+	__u32 cur_freq_khz;	/* 0 if unknown */
+	__u32 reserved;
+	__u64 user_ns;
+	__u64 nice_ns;
+	__u64 system_ns;
+	__u64 idle_ns;
+	__u64 iowait_ns;
+	__u64 irq_ns;
+	__u64 softirq_ns;
+};
+
+struct kstats_lmk {
+	__u64 kills;
+	__u64 killed_pages;	/* rss of the killed tasks */
+	__u64 reaped_pages;
+	__s32 last_min_score_adj;
+	__u32 reserved;
+};
+
+/*
+ * Takes a new snapshot into the buffer that mmap() of the file maps and
+ * returns its length, so that sampling takes a single syscall and no
+ * copy. read() from offset 0 takes a new snapshot as well.
+ */
+#define KSTATS_IOCTL_MAGIC	'k'
+#define KSTATS_IOCTL_SNAPSHOT	_IO(KSTATS_IOCTL_MAGIC, 1)
+
+#endif /* _UAPI_LINUX_KSTATS_H */
@@ -335,6 +335,7 @@ enum kgsl_timestamp_type {
 #define KGSL_PROP_L3_PWR_CONSTRAINT     0x22
 #define KGSL_PROP_SECURE_BUFFER_ALIGNMENT 0x23
 #define KGSL_PROP_SECURE_CTXT_SUPPORT 0x24
+#define KGSL_PROP_CONTEXT_EVENTFD	0x25
 
 struct kgsl_shadowprop {
 	unsigned long gpuaddr;
@@ -1119,6 +1120,17 @@ struct kgsl_device_constraint {
 	size_t size;
 };
 
+/**
+ * struct kgsl_context_eventfd - Argument to KGSL_PROP_CONTEXT_EVENTFD
+ * @context_id: Context to attach the eventfd to
+ * @fd: eventfd to signal each time the retired timestamp of the context
+ * advances, or -1 to detach the current one
+ */
+struct kgsl_context_eventfd {
+	unsigned int context_id;
+	int fd;
+};
+
 /* Constraint Type*/
 #define KGSL_CONSTRAINT_NONE 0
 #define KGSL_CONSTRAINT_PWRLEVEL 1
@@ -1622,4 +1634,57 @@ struct kgsl_gpu_sparse_command {
 #define IOCTL_KGSL_GPU_SPARSE_COMMAND \
 	_IOWR(KGSL_IOC_TYPE, 0x55, struct kgsl_gpu_sparse_command)
 
+/**
+ * struct kgsl_perfcounter_sample - Argument for IOCTL_KGSL_PERFCOUNTER_SAMPLE
+ * @reads: Array of struct kgsl_perfcounter_read_group listing the
+ * groupid/countable pairs to sample, the value field is ignored
+ * @count: Number of pairs in @reads, 0 to stop sampling
+ * @id: GPU object to write the samples to
+ * @period_us: Sampling period in microseconds
+ *
+ * The counters must already be reserved with IOCTL_KGSL_PERFCOUNTER_GET and
+ * the GPU object must be uncached or write combined. The object starts with
+ * a struct kgsl_perfcounter_sample_header, followed by a ring of samples. Each
+ * sample is a struct kgsl_perfcounter_sample_entry with @count values. Only
+ * one sampling session can be active on a device.
+ */
+struct kgsl_perfcounter_sample {
+	uint64_t __user reads;
+	unsigned int count;
+	unsigned int id;
+	unsigned int period_us;
+	unsigned int __pad;
+};
+
+#define IOCTL_KGSL_PERFCOUNTER_SAMPLE \
+	_IOW(KGSL_IOC_TYPE, 0x56, struct kgsl_perfcounter_sample)
+
+/**
+ * struct kgsl_perfcounter_sample_header - Header of a sample ring
+ * @write_index: Number of samples written so far, the latest sample is at
+ * (write_index - 1) % max_samples. Updated after the sample is written.
+ * @max_samples: Number of samples in the ring
+ * @sample_size: Size of one sample in bytes
+ * @count: Number of counter values in each sample
+ */
+struct kgsl_perfcounter_sample_header {
+	unsigned int write_index;
+	unsigned int max_samples;
+	unsigned int sample_size;
+	unsigned int count;
+};
+
+/**
+ * struct kgsl_perfcounter_sample_entry - A single counter sample
+ * @time: CPU monotonic clock time of the sample in nanoseconds
+ * @context_id: Context that was active on the GPU when the sample was taken
+ * @values: Counter values, in the order they were passed in
+ */
+struct kgsl_perfcounter_sample_entry {
+	uint64_t time;
+	unsigned int context_id;
+	unsigned int __pad;
+	uint64_t values[];
+};
+
 #endif /* _UAPI_MSM_KGSL_H */
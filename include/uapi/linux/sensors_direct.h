@@ -0,0 +1,46 @@
+#ifndef _UAPI_SENSORS_DIRECT_H_
+#define _UAPI_SENSORS_DIRECT_H_
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+#define SNS_DIRECT_MAGIC	0x534e5344	/* "SNSD" */
+#define SNS_DIRECT_VERSION	1
+
+/*
+ * One sensor sample as written by the sensor hub. The timestamp is in
+ * QTimer ticks, the meaning of data[] depends on the sensor type behind
+ * sensor_handle.
+ */
+struct sns_direct_event {
+	__u64 timestamp;
+	__u32 sensor_handle;
+	__u32 reserved;
+	__s32 data[4];
+};
+
+/*
+ * Ring shared with the sensor hub, followed by nr_events events. Both
+ * indices run freely and are reduced modulo nr_events, a power of two.
+ * The hub only writes write_idx, dropped and clears armed; the AP only
+ * writes read_idx, watermark and sets armed. The hub rings the doorbell
+ * once at least watermark events are pending while armed is set, and
+ * clears armed when it does so.
+ */
+struct sns_direct_ring {
+	__u32 magic;
+	__u32 version;
+	__u32 nr_events;
+	__u32 watermark;
+	__u32 write_idx;
+	__u32 read_idx;
+	__u32 armed;
+	__u32 dropped;
+	struct sns_direct_event events[];
+};
+
+#define SNS_DIRECT_IOCTL_MAGIC 'S'
+
+#define SNS_DIRECT_IOCTL_SET_WATERMARK _IOW(SNS_DIRECT_IOCTL_MAGIC, 1, __u32)
+
+#endif	/* _UAPI_SENSORS_DIRECT_H_ */
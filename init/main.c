@@ -89,6 +89,7 @@
 #include <asm/setup.h>
 #include <asm/sections.h>
 #include <asm/cacheflush.h>
+#include <soc/qcom/boot_stats.h>
 
 static int kernel_init(void *);
 
@@ -795,15 +796,23 @@ int __init_or_module do_one_initcall(initcall_t fn)
 	int count = preempt_count();
 	int ret;
 	char msgbuf[64];
+	ktime_t calltime = 0;
 
 	if (initcall_blacklisted(fn))
 		return -EPERM;
 
+	if (boot_marker_enabled())
+		calltime = ktime_get();
+
 	if (initcall_debug)
 		ret = do_one_initcall_debug(fn);
 	else
 		ret = fn();
 
+	if (boot_marker_enabled())
+		place_duration_marker(ktime_us_delta(ktime_get(), calltime),
+				      "D - %pf - ", fn);
+
 	msgbuf[0] = 0;
 
 	if (preempt_count() != count) {
@@ -1289,6 +1289,21 @@ int current_cpuset_is_being_rebound(void)
 	return ret;
 }
 
+/*
+ * Whether current runs in the cpuset Android keeps the foreground app in.
+ * Only the name is looked at, that is all the framework defines.
+ */
+bool current_cpuset_is_top_app(void)
+{
+	bool ret;
+
+	rcu_read_lock();
+	ret = !strcmp(task_cs(current)->css.cgroup->kn->name, "top-app");
+	rcu_read_unlock();
+
+	return ret;
+}
+
 static int update_relax_domain_level(struct cpuset *cs, s64 val)
 {
 #ifdef CONFIG_SMP
@@ -1546,6 +1561,7 @@ static void cpuset_attach(struct cgroup_taskset *tset)
 	struct cgroup_subsys_state *css;
 	struct cpuset *cs;
 	struct cpuset *oldcs = cpuset_attach_old_cs;
+	bool mems_updated;
 
 	cgroup_taskset_first(tset, &css);
 	cs = css_cs(css);
@@ -1559,6 +1575,7 @@ static void cpuset_attach(struct cgroup_taskset *tset)
 		guarantee_online_cpus(cs, cpus_attach);
 
 	guarantee_online_mems(cs, &cpuset_attach_nodemask_to);
+	mems_updated = !nodes_equal(cs->effective_mems, oldcs->effective_mems);
 
 	cgroup_taskset_for_each(task, css, tset) {
 		/*
@@ -1567,15 +1584,24 @@ static void cpuset_attach(struct cgroup_taskset *tset)
 		 */
 		WARN_ON_ONCE(update_cpus_allowed(cs, task, cpus_attach));
 
-		cpuset_change_task_nodemask(task, &cpuset_attach_nodemask_to);
+		/* mems_allowed only changes under cpuset_mutex */
+		if (!nodes_equal(task->mems_allowed, cpuset_attach_nodemask_to))
+			cpuset_change_task_nodemask(task,
+						    &cpuset_attach_nodemask_to);
 		cpuset_update_task_spread_flag(cs, task);
 	}
 
 	/*
 	 * Change mm for all threadgroup leaders. This is expensive and may
-	 * sleep and should be moved outside migration path proper.
+	 * sleep and should be moved outside migration path proper. Skip it
+	 * when the memory nodes do not change and nothing is to be migrated,
+	 * as with the Android top-app/foreground/background cpusets, which
+	 * only differ in their CPUs: rebinding takes each mmap_sem for write.
 	 */
 	cpuset_attach_nodemask_to = cs->effective_mems;
+	if (!mems_updated && !is_memory_migrate(cs))
+		goto out;
+
 	cgroup_taskset_for_each_leader(leader, css, tset) {
 		struct mm_struct *mm = get_task_mm(leader);
 
@@ -1598,6 +1624,7 @@ static void cpuset_attach(struct cgroup_taskset *tset)
 		}
 	}
 
+out:
 	cs->old_mems_allowed = cpuset_attach_nodemask_to;
 
 	cs->attach_in_progress--;
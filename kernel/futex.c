@@ -178,6 +178,13 @@
 static int  __read_mostly futex_cmpxchg_enabled;
 #endif
 
+/*
+ * When set, non-RT waiters are queued by their normal priority (i.e. nice
+ * level) instead of all sharing MAX_RT_PRIO, so that a wake of a single
+ * waiter picks the most important one rather than the oldest one.
+ */
+unsigned int __read_mostly sysctl_futex_prio_wake;
+
 /*
  * Futex flags used to encode options to functions and preserve them across
  * restarts.
@@ -2349,8 +2356,15 @@ static inline void __queue_me(struct futex_q *q, struct futex_hash_bucket *hb)
 	 * - or MAX_RT_PRIO for non-RT threads.
 	 * Thus, all RT-threads are woken first in priority order, and
 	 * the others are woken last, in FIFO order.
+	 *
+	 * With sysctl_futex_prio_wake set, non-RT threads keep their nice
+	 * based normal priority as well and are woken in that order, FIFO
+	 * only among threads of equal priority.
 	 */
-	prio = min(current->normal_prio, MAX_RT_PRIO);
+	if (READ_ONCE(sysctl_futex_prio_wake))
+		prio = current->normal_prio;
+	else
+		prio = min(current->normal_prio, MAX_RT_PRIO);
 
 	plist_node_init(&q->list, prio);
 	plist_add(&q->list, &hb->chain);
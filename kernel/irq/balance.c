@@ -0,0 +1,211 @@
+/*
+ * linux/kernel/irq/balance.c
+ *
+ * Periodic in-kernel interrupt affinity balancer.
+ *
+ * Every interval the rate of each balanceable interrupt is sampled from
+ * its kstat counters, and the busiest ones are pinned, one CPU each, to
+ * the least loaded of the allowed CPUs. An interrupt stays where it is
+ * unless moving it takes at least half of its rate off its current CPU,
+ * so the placement settles instead of bouncing every interval.
+ */
+
+#include <linux/cpu.h>
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/jiffies.h>
+#include <linux/kernel_stat.h>
+#include <linux/moduleparam.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+
+#include "internals.h"
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "irq_balance."
+
+/* Number of interrupts placed per interval, busiest first */
+#define IRQ_BALANCE_MAX		16
+
+struct irq_balance_entry {
+	unsigned int irq;
+	unsigned int rate;
+};
+
+static unsigned int interval_ms;	/* 0 disables the balancer */
+static unsigned int min_rate = 500;	/* interrupts per second */
+module_param(min_rate, uint, 0644);
+
+static struct cpumask allowed_cpus = { CPU_BITS_ALL };
+
+static unsigned int *last_count;
+static unsigned int last_nr;
+static unsigned long last_stamp;
+static unsigned long cpu_load[NR_CPUS];
+static bool balance_ready;
+
+static void irq_balance_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(irq_balance_work, irq_balance_fn);
+
+static int irq_balance_sample(struct irq_balance_entry *top,
+			      unsigned long elapsed)
+{
+	struct irq_desc *desc;
+	unsigned int irq;
+	int nr = 0;
+
+	for_each_irq_desc(irq, desc) {
+		struct irq_data *d = irq_desc_get_irq_data(desc);
+		unsigned int count, rate;
+		int i;
+
+		if (irq >= last_nr)
+			break;
+
+		count = kstat_irqs(irq);
+		rate = div64_ul((u64)(count - last_count[irq]) * HZ, elapsed);
+		last_count[irq] = count;
+
+		if (rate < READ_ONCE(min_rate) || !desc->action ||
+		    irqd_is_per_cpu(d) || !irqd_can_balance(d) ||
+		    irqd_affinity_is_managed(d))
+			continue;
+
+		/* Keep @top sorted by decreasing rate */
+		if (nr == IRQ_BALANCE_MAX) {
+			if (rate <= top[nr - 1].rate)
+				continue;
+			nr--;
+		}
+		for (i = nr; i > 0 && top[i - 1].rate < rate; i--)
+			top[i] = top[i - 1];
+		top[i].irq = irq;
+		top[i].rate = rate;
+		nr++;
+	}
+
+	return nr;
+}
+
+static void irq_balance_place(struct irq_balance_entry *top, int nr,
+			      const struct cpumask *allowed)
+{
+	int i, cpu;
+
+	for_each_cpu(cpu, allowed)
+		cpu_load[cpu] = 0;
+
+	for (i = 0; i < nr; i++) {
+		const struct cpumask *aff = irq_get_affinity_mask(top[i].irq);
+		int cur = -1, best = -1;
+
+		if (cpumask_weight(aff) == 1) {
+			cur = cpumask_first(aff);
+			if (!cpumask_test_cpu(cur, allowed))
+				cur = -1;
+		}
+
+		for_each_cpu(cpu, allowed) {
+			if (best < 0 || cpu_load[cpu] < cpu_load[best])
+				best = cpu;
+		}
+
+		if (cur >= 0 && cpu_load[cur] <= cpu_load[best] +
+						  top[i].rate / 2)
+			best = cur;
+
+		cpu_load[best] += top[i].rate;
+		if (best != cur)
+			irq_set_affinity(top[i].irq, cpumask_of(best));
+	}
+}
+
+static void irq_balance_fn(struct work_struct *work)
+{
+	struct irq_balance_entry top[IRQ_BALANCE_MAX];
+	unsigned int interval = READ_ONCE(interval_ms);
+	struct cpumask allowed;
+	unsigned long now = jiffies;
+	unsigned long elapsed = now - last_stamp;
+	int nr;
+
+	if (!interval)
+		return;
+
+	last_stamp = now;
+	if (elapsed) {
+		nr = irq_balance_sample(top, elapsed);
+
+		get_online_cpus();
+		cpumask_and(&allowed, &allowed_cpus, cpu_online_mask);
+		cpumask_andnot(&allowed, &allowed, cpu_isolated_mask);
+		if (!cpumask_empty(&allowed))
+			irq_balance_place(top, nr, &allowed);
+		put_online_cpus();
+	}
+
+	queue_delayed_work(system_power_efficient_wq, &irq_balance_work,
+			   msecs_to_jiffies(interval));
+}
+
+static int set_interval_ms(const char *val, const struct kernel_param *kp)
+{
+	int ret = param_set_uint(val, kp);
+
+	if (!ret && balance_ready && interval_ms)
+		mod_delayed_work(system_power_efficient_wq, &irq_balance_work,
+				 msecs_to_jiffies(interval_ms));
+	return ret;
+}
+
+static const struct kernel_param_ops interval_ms_ops = {
+	.set = set_interval_ms,
+	.get = param_get_uint,
+};
+module_param_cb(interval_ms, &interval_ms_ops, &interval_ms, 0644);
+
+static int set_cpus(const char *val, const struct kernel_param *kp)
+{
+	struct cpumask mask;
+	int ret;
+
+	ret = cpulist_parse(val, &mask);
+	if (ret)
+		return ret;
+	if (cpumask_empty(&mask))
+		return -EINVAL;
+
+	cpumask_copy(&allowed_cpus, &mask);
+	return 0;
+}
+
+static int get_cpus(char *buf, const struct kernel_param *kp)
+{
+	return scnprintf(buf, PAGE_SIZE, "%*pbl\n",
+			 cpumask_pr_args(&allowed_cpus));
+}
+
+static const struct kernel_param_ops cpus_ops = {
+	.set = set_cpus,
+	.get = get_cpus,
+};
+module_param_cb(cpus, &cpus_ops, NULL, 0644);
+
+static int __init irq_balance_init(void)
+{
+	last_count = kcalloc(nr_irqs, sizeof(*last_count), GFP_KERNEL);
+	if (!last_count)
+		return -ENOMEM;
+
+	last_nr = nr_irqs;
+	last_stamp = jiffies;
+	balance_ready = true;
+	if (interval_ms)
+		queue_delayed_work(system_power_efficient_wq,
+				   &irq_balance_work,
+				   msecs_to_jiffies(interval_ms));
+	return 0;
+}
+late_initcall(irq_balance_init);
@@ -0,0 +1,242 @@
+/*
+ * Unified kernel statistics snapshot
+ *
+ * Sampling the performance counters of this platform used to mean
+ * opening and parsing a dozen text files, each read at a slightly
+ * different time. /proc/kstats instead returns one binary snapshot, laid
+ * out as in <linux/kstats.h>, that subsystems contribute records to by
+ * registering a struct kstats_source. Every open file has its own
+ * snapshot buffer: read() from offset 0 or the KSTATS_IOCTL_SNAPSHOT
+ * ioctl refill it, and the buffer can be mapped read-only so that the
+ * ioctl is all a sample costs. Nothing runs between samples.
+ */
+
+#define pr_fmt(fmt) "kstats: " fmt
+
+#include <linux/cpufreq.h>
+#include <linux/cpumask.h>
+#include <linux/cputime.h>
+#include <linux/fs.h>
+#include <linux/init.h>
+#include <linux/kernel_stat.h>
+#include <linux/kstats.h>
+#include <linux/ktime.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/proc_fs.h>
+#include <linux/slab.h>
+#include <linux/tick.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#define KSTATS_BUF_SIZE		(64 * 1024)
+
+static LIST_HEAD(kstats_sources);
+static DEFINE_MUTEX(kstats_lock);
+
+struct kstats_file {
+	struct mutex lock;
+	void *buf;
+	size_t len;
+};
+
+void kstats_register_source(struct kstats_source *src)
+{
+	mutex_lock(&kstats_lock);
+	list_add_tail(&src->list, &kstats_sources);
+	mutex_unlock(&kstats_lock);
+}
+EXPORT_SYMBOL(kstats_register_source);
+
+void kstats_unregister_source(struct kstats_source *src)
+{
+	mutex_lock(&kstats_lock);
+	list_del(&src->list);
+	mutex_unlock(&kstats_lock);
+}
+EXPORT_SYMBOL(kstats_unregister_source);
+
+static int kstats_snapshot(struct kstats_file *kf)
+{
+	struct kstats_header *hdr = kf->buf;
+	struct kstats_record *rec;
+	struct kstats_source *src;
+	size_t off = sizeof(*hdr);
+	int len, ret = 0;
+
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->magic = KSTATS_MAGIC;
+	hdr->version = KSTATS_VERSION;
+	hdr->timestamp_ns = ktime_get_boot_ns();
+
+	mutex_lock(&kstats_lock);
+	list_for_each_entry(src, &kstats_sources, list) {
+		if (off + sizeof(*rec) + src->max_len > KSTATS_BUF_SIZE) {
+			pr_warn_once("snapshot buffer too small\n");
+			ret = -ENOSPC;
+			break;
+		}
+
+		rec = kf->buf + off;
+		rec->timestamp_ns = ktime_get_boot_ns();
+		len = src->fill(rec + 1, src->max_len);
+		if (len < 0)
+			continue;
+
+		rec->type = src->type;
+		rec->version = src->version;
+		rec->len = len;
+		off += sizeof(*rec) + ALIGN(len, 8);
+		hdr->nr_records++;
+	}
+	mutex_unlock(&kstats_lock);
+
+	hdr->len = off;
+	kf->len = off;
+
+	return ret;
+}
+
+static ssize_t kstats_read(struct file *file, char __user *ubuf,
+			   size_t count, loff_t *ppos)
+{
+	struct kstats_file *kf = file->private_data;
+	ssize_t ret;
+
+	mutex_lock(&kf->lock);
+	if (!*ppos) {
+		ret = kstats_snapshot(kf);
+		if (ret)
+			goto out;
+	}
+	ret = simple_read_from_buffer(ubuf, count, ppos, kf->buf, kf->len);
+out:
+	mutex_unlock(&kf->lock);
+
+	return ret;
+}
+
+static long kstats_ioctl(struct file *file, unsigned int cmd,
+			 unsigned long arg)
+{
+	struct kstats_file *kf = file->private_data;
+	long ret;
+
+	if (cmd != KSTATS_IOCTL_SNAPSHOT)
+		return -ENOTTY;
+
+	mutex_lock(&kf->lock);
+	ret = kstats_snapshot(kf);
+	if (!ret)
+		ret = kf->len;
+	mutex_unlock(&kf->lock);
+
+	return ret;
+}
+
+static int kstats_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct kstats_file *kf = file->private_data;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range(vma, kf->buf, vma->vm_pgoff);
+}
+
+static int kstats_open(struct inode *inode, struct file *file)
+{
+	struct kstats_file *kf;
+
+	kf = kzalloc(sizeof(*kf), GFP_KERNEL);
+	if (!kf)
+		return -ENOMEM;
+
+	kf->buf = vmalloc_user(KSTATS_BUF_SIZE);
+	if (!kf->buf) {
+		kfree(kf);
+		return -ENOMEM;
+	}
+	mutex_init(&kf->lock);
+
+	file->private_data = kf;
+	return 0;
+}
+
+static int kstats_release(struct inode *inode, struct file *file)
+{
+	struct kstats_file *kf = file->private_data;
+
+	vfree(kf->buf);
+	kfree(kf);
+	return 0;
+}
+
+static const struct file_operations kstats_fops = {
+	.open		= kstats_open,
+	.read		= kstats_read,
+	.unlocked_ioctl	= kstats_ioctl,
+	.compat_ioctl	= kstats_ioctl,
+	.mmap		= kstats_mmap,
+	.llseek		= default_llseek,
+	.release	= kstats_release,
+};
+
+static u64 kstats_cputime_ns(int cpu, enum cpu_usage_stat idx)
+{
+	return cputime_to_nsecs((cputime_t)kcpustat_cpu(cpu).cpustat[idx]);
+}
+
+/* Per CPU times and current frequency, the section of each CPU */
+static int kstats_cpu_fill(void *buf, size_t max_len)
+{
+	struct kstats_cpu *kc = buf;
+	u64 us;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		memset(kc, 0, sizeof(*kc));
+		kc->cpu = cpu;
+		kc->online = cpu_online(cpu);
+		if (kc->online)
+			kc->cur_freq_khz = cpufreq_quick_get(cpu);
+
+		kc->user_ns = kstats_cputime_ns(cpu, CPUTIME_USER);
+		kc->nice_ns = kstats_cputime_ns(cpu, CPUTIME_NICE);
+		kc->system_ns = kstats_cputime_ns(cpu, CPUTIME_SYSTEM);
+		kc->irq_ns = kstats_cputime_ns(cpu, CPUTIME_IRQ);
+		kc->softirq_ns = kstats_cputime_ns(cpu, CPUTIME_SOFTIRQ);
+
+		/* as in /proc/stat, prefer the nohz idle accounting */
+		us = kc->online ? get_cpu_idle_time_us(cpu, NULL) : -1ULL;
+		kc->idle_ns = us == -1ULL ?
+			kstats_cputime_ns(cpu, CPUTIME_IDLE) :
+			us * NSEC_PER_USEC;
+		us = kc->online ? get_cpu_iowait_time_us(cpu, NULL) : -1ULL;
+		kc->iowait_ns = us == -1ULL ?
+			kstats_cputime_ns(cpu, CPUTIME_IOWAIT) :
+			us * NSEC_PER_USEC;
+
+		kc++;
+	}
+
+	return (void *)kc - buf;
+}
+
+static struct kstats_source kstats_cpu_source = {
+	.type		= KSTATS_TYPE_CPU,
+	.version	= 1,
+	.fill		= kstats_cpu_fill,
+};
+
+static int __init kstats_init(void)
+{
+	kstats_cpu_source.max_len = num_possible_cpus() *
+				    sizeof(struct kstats_cpu);
+	kstats_register_source(&kstats_cpu_source);
+
+	proc_create("kstats", 0400, NULL, &kstats_fops);
+	return 0;
+}
+fs_initcall(kstats_init);
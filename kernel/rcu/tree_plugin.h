@@ -59,6 +59,8 @@ DEFINE_PER_CPU(char, rcu_cpu_has_work);
 static cpumask_var_t rcu_nocb_mask; /* CPUs to have callbacks offloaded. */
 static bool have_rcu_nocb_mask;	    /* Was rcu_nocb_mask allocated? */
 static bool __read_mostly rcu_nocb_poll;    /* Offload kthread are to poll. */
+static cpumask_var_t rcu_nocb_affinity_mask; /* CPUs to run rcuo kthreads. */
+static bool have_rcu_nocb_affinity_mask; /* Was it allocated? */
 #endif /* #ifdef CONFIG_RCU_NOCB_CPU */
 
 /*
@@ -1756,6 +1758,20 @@ static int __init parse_rcu_nocb_poll(char *arg)
 }
 early_param("rcu_nocb_poll", parse_rcu_nocb_poll);
 
+/*
+ * Parse the boot-time rcu_nocb_affinity CPU list, restricting the rcuo
+ * kthreads to those CPUs, for example the little cluster, so that the
+ * callbacks offloaded from the other CPUs are never invoked there.
+ */
+static int __init rcu_nocb_affinity_setup(char *str)
+{
+	alloc_bootmem_cpumask_var(&rcu_nocb_affinity_mask);
+	have_rcu_nocb_affinity_mask = true;
+	cpulist_parse(str, rcu_nocb_affinity_mask);
+	return 1;
+}
+__setup("rcu_nocb_affinity=", rcu_nocb_affinity_setup);
+
 /*
  * Wake up any no-CBs CPUs' kthreads that were waiting on the just-ended
  * grace period.
@@ -2383,6 +2399,9 @@ static void rcu_spawn_one_nocb_kthread(struct rcu_state *rsp, int cpu)
 	t = kthread_run(rcu_nocb_kthread, rdp_spawn,
 			"rcuo%c/%d", rsp->abbr, cpu);
 	BUG_ON(IS_ERR(t));
+	if (have_rcu_nocb_affinity_mask &&
+	    cpumask_intersects(rcu_nocb_affinity_mask, cpu_possible_mask))
+		set_cpus_allowed_ptr(t, rcu_nocb_affinity_mask);
 	WRITE_ONCE(rdp_spawn->nocb_kthread, t);
 }
 
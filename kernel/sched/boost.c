@@ -95,25 +95,27 @@ void clear_boost_kick(int cpu)
  * When policy = SCHED_BOOST_NONE, type is either none or RESTRAINED
  * When policy = SCHED_BOOST_ON_ALL or SCHED_BOOST_ON_BIG, type can
  * neither be none nor RESTRAINED.
+ *
+ * The same mapping is used for boost levels attached to individual
+ * cgroups, so it is kept separate from the global boost policy.
  */
-static void set_boost_policy(int type)
+enum sched_boost_policy sched_boost_type_policy(int type)
 {
-	if (type == SCHED_BOOST_NONE || type == RESTRAINED_BOOST) {
-		boost_policy = SCHED_BOOST_NONE;
-		return;
-	}
+	if (type == SCHED_BOOST_NONE || type == RESTRAINED_BOOST)
+		return SCHED_BOOST_NONE;
 
-	if (boost_policy_dt) {
-		boost_policy = boost_policy_dt;
-		return;
-	}
+	if (boost_policy_dt)
+		return boost_policy_dt;
 
-	if (sysctl_sched_is_big_little) {
-		boost_policy = SCHED_BOOST_ON_BIG;
-		return;
-	}
+	if (sysctl_sched_is_big_little)
+		return SCHED_BOOST_ON_BIG;
+
+	return SCHED_BOOST_ON_ALL;
+}
 
-	boost_policy = SCHED_BOOST_ON_ALL;
+static void set_boost_policy(int type)
+{
+	boost_policy = sched_boost_type_policy(type);
 }
 
 enum sched_boost_policy sched_boost_policy(void)
@@ -561,11 +561,47 @@ void resched_cpu(int cpu)
  * selecting an idle cpu will add more delays to the timers than intended
  * (as that cpu's timer base may not be uptodate wrt jiffies etc).
  */
+#ifdef CONFIG_SCHED_WALT
+/*
+ * When sysctl_sched_timer_consolidate is set, unpinned timers armed on a
+ * CPU outside the min capacity cluster are moved to that cluster: to a
+ * busy CPU of it if there is one, or else to its first usable CPU, so
+ * that stray driver timers do not keep waking up the big cores.
+ */
+static int nohz_consolidate_target(int cpu)
+{
+	int i, target = -1;
+
+	if (!sysctl_sched_timer_consolidate || is_min_capacity_cpu(cpu))
+		return -1;
+
+	for_each_online_cpu(i) {
+		if (!is_min_capacity_cpu(i) || !is_housekeeping_cpu(i) ||
+		    cpu_isolated(i))
+			continue;
+
+		if (!idle_cpu(i))
+			return i;
+
+		if (target < 0)
+			target = i;
+	}
+
+	return target;
+}
+#else
+static inline int nohz_consolidate_target(int cpu) { return -1; }
+#endif
+
 int get_nohz_timer_target(void)
 {
 	int i, cpu = smp_processor_id();
 	struct sched_domain *sd;
 
+	i = nohz_consolidate_target(cpu);
+	if (i >= 0)
+		return i;
+
 	if (!idle_cpu(cpu) && is_housekeeping_cpu(cpu))
 		return cpu;
 
@@ -2222,6 +2258,7 @@ try_to_wake_up(struct task_struct *p, unsigned int state, int wake_flags)
 	grp = task_related_thread_group(p);
 	if (update_preferred_cluster(grp, p, old_load))
 		set_preferred_cluster(grp);
+	walt_note_wakeup_pair(current, p, wallclock);
 	rcu_read_unlock();
 	check_group = grp != NULL;
 
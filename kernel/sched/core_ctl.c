@@ -17,6 +17,7 @@
 #include <linux/cpumask.h>
 #include <linux/cpufreq.h>
 #include <linux/kthread.h>
+#include <linux/psi.h>
 #include <linux/sched.h>
 #include <linux/sched/rt.h>
 #include <linux/syscore_ops.h>
@@ -28,6 +29,9 @@
 #define MAX_CPUS_PER_CLUSTER 6
 #define MAX_CLUSTERS 2
 
+/* Tracking window of the PSI cpu-some unisolation trigger */
+#define PSI_UNISOLATE_WINDOW_US 500000
+
 struct cluster_data {
 	bool inited;
 	unsigned int min_cpus;
@@ -58,6 +62,11 @@ struct cluster_data {
 	unsigned int first_cpu;
 	unsigned int boost;
 	struct kobject kobj;
+#ifdef CONFIG_PSI
+	unsigned int psi_thres_us;
+	struct psi_trigger *psi_trig;
+	s64 psi_ts;
+#endif
 };
 
 struct cpu_data {
@@ -86,6 +95,11 @@ static bool initialized;
 static unsigned int get_active_cpu_count(const struct cluster_data *cluster);
 static void cpuset_next(struct cluster_data *cluster);
 
+#ifdef CONFIG_PSI
+static DEFINE_MUTEX(psi_trig_lock);
+static void core_ctl_psi_notify(void *data);
+#endif
+
 /* ========================= sysfs interface =========================== */
 
 static ssize_t store_min_cpus(struct cluster_data *state,
@@ -282,6 +296,51 @@ static ssize_t show_enable(const struct cluster_data *state, char *buf)
 	return scnprintf(buf, PAGE_SIZE, "%u\n", state->enable);
 }
 
+#ifdef CONFIG_PSI
+static ssize_t store_psi_thres_us(struct cluster_data *state,
+				const char *buf, size_t count)
+{
+	struct psi_trigger *trig = NULL, *old;
+	unsigned int val;
+
+	if (sscanf(buf, "%u\n", &val) != 1)
+		return -EINVAL;
+
+	if (val > PSI_UNISOLATE_WINDOW_US)
+		return -EINVAL;
+
+	mutex_lock(&psi_trig_lock);
+	if (val == state->psi_thres_us) {
+		mutex_unlock(&psi_trig_lock);
+		return count;
+	}
+
+	if (val) {
+		trig = psi_kernel_trigger_create(PSI_CPU_SOME, val,
+						 PSI_UNISOLATE_WINDOW_US,
+						 core_ctl_psi_notify, state);
+		if (IS_ERR(trig)) {
+			mutex_unlock(&psi_trig_lock);
+			return PTR_ERR(trig);
+		}
+	}
+
+	old = state->psi_trig;
+	state->psi_trig = trig;
+	state->psi_thres_us = val;
+	mutex_unlock(&psi_trig_lock);
+
+	psi_kernel_trigger_destroy(old);
+
+	return count;
+}
+
+static ssize_t show_psi_thres_us(const struct cluster_data *state, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%u\n", state->psi_thres_us);
+}
+#endif
+
 static ssize_t show_need_cpus(const struct cluster_data *state, char *buf)
 {
 	return snprintf(buf, PAGE_SIZE, "%u\n", state->need_cpus);
@@ -416,6 +475,9 @@ core_ctl_attr_ro(active_cpus);
 core_ctl_attr_ro(global_state);
 core_ctl_attr_rw(not_preferred);
 core_ctl_attr_rw(enable);
+#ifdef CONFIG_PSI
+core_ctl_attr_rw(psi_thres_us);
+#endif
 
 static struct attribute *default_attrs[] = {
 	&min_cpus.attr,
@@ -430,6 +492,9 @@ static struct attribute *default_attrs[] = {
 	&active_cpus.attr,
 	&global_state.attr,
 	&not_preferred.attr,
+#ifdef CONFIG_PSI
+	&psi_thres_us.attr,
+#endif
 	NULL
 };
 
@@ -544,6 +609,37 @@ static bool adjustment_possible(const struct cluster_data *cluster,
 						cluster->nr_isolated_cpus));
 }
 
+#ifdef CONFIG_PSI
+/*
+ * CPU stall time crossed the cluster's PSI threshold: keep all of its CPUs
+ * unisolated for at least one PSI window, without waiting for the next
+ * core_ctl_check() evaluation.
+ */
+static void core_ctl_psi_notify(void *data)
+{
+	struct cluster_data *cluster = data;
+	unsigned long flags;
+
+	spin_lock_irqsave(&state_lock, flags);
+	cluster->psi_ts = ktime_to_ms(ktime_get());
+	spin_unlock_irqrestore(&state_lock, flags);
+
+	apply_need(cluster);
+}
+
+static bool core_ctl_psi_stalled(const struct cluster_data *cluster, s64 now)
+{
+	return cluster->psi_trig && cluster->psi_ts &&
+	       now - cluster->psi_ts < PSI_UNISOLATE_WINDOW_US / USEC_PER_MSEC;
+}
+#else
+static inline bool core_ctl_psi_stalled(const struct cluster_data *cluster,
+					s64 now)
+{
+	return false;
+}
+#endif
+
 static bool eval_need(struct cluster_data *cluster)
 {
 	unsigned long flags;
@@ -559,7 +655,10 @@ static bool eval_need(struct cluster_data *cluster)
 
 	spin_lock_irqsave(&state_lock, flags);
 
-	if (cluster->boost || !cluster->enable) {
+	now = ktime_to_ms(ktime_get());
+
+	if (cluster->boost || !cluster->enable ||
+	    core_ctl_psi_stalled(cluster, now)) {
 		need_cpus = cluster->max_cpus;
 	} else {
 		cluster->active_cpus = get_active_cpu_count(cluster);
@@ -583,7 +682,6 @@ static bool eval_need(struct cluster_data *cluster)
 	need_flag = adjustment_possible(cluster, new_need);
 
 	last_need = cluster->need_cpus;
-	now = ktime_to_ms(ktime_get());
 
 	if (new_need > cluster->active_cpus) {
 		ret = 1;
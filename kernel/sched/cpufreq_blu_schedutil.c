@@ -38,6 +38,7 @@ struct sugov_tunables {
 	bool pl;
 	bool iowait_boost_enable;
 	bool exp_util;
+	bool adaptive_rate_limit;
 };
 
 struct sugov_policy {
@@ -51,6 +52,8 @@ struct sugov_policy {
 	s64 min_rate_limit_ns;
 	s64 up_rate_delay_ns;
 	s64 down_rate_delay_ns;
+	int last_change_dir;
+	u64 last_change_time;
 	u64 last_ws;
 	u64 curr_cycles;
 	u64 last_cyc_update_time;
@@ -137,6 +140,49 @@ static bool sugov_up_down_rate_limit(struct sugov_policy *sg_policy, u64 time,
 	return false;
 }
 
+/*
+ * Adaptive rate limits: a frequency change that gets reverted within one
+ * WALT window was premature, so the rate limit of its direction is backed
+ * off. A change that holds lets the rate limit of its direction decay back
+ * towards a floor derived from the driver's transition latency.
+ */
+#define ADAPTIVE_RL_LATENCY_MULT	2
+#define ADAPTIVE_RL_MIN_NS		(100 * NSEC_PER_USEC)
+
+static void sugov_adapt_rate_limits(struct sugov_policy *sg_policy, u64 time,
+				    unsigned int next_freq)
+{
+	int dir = next_freq > sg_policy->next_freq ? 1 : -1;
+	s64 floor_ns, ceil_ns, *delay;
+
+	if (!sg_policy->tunables->adaptive_rate_limit ||
+	    sg_policy->next_freq == UINT_MAX)
+		goto out;
+
+	floor_ns = max_t(s64, ADAPTIVE_RL_MIN_NS,
+			 (s64)sg_policy->policy->cpuinfo.transition_latency *
+			 ADAPTIVE_RL_LATENCY_MULT);
+	ceil_ns = max_t(s64, floor_ns, sched_ravg_window);
+
+	if (sg_policy->last_change_dir && dir != sg_policy->last_change_dir &&
+	    time - sg_policy->last_change_time < sched_ravg_window) {
+		delay = sg_policy->last_change_dir > 0 ?
+			&sg_policy->up_rate_delay_ns :
+			&sg_policy->down_rate_delay_ns;
+		*delay = min(*delay + max(*delay >> 2, floor_ns), ceil_ns);
+	} else {
+		delay = dir > 0 ? &sg_policy->up_rate_delay_ns :
+			&sg_policy->down_rate_delay_ns;
+		*delay = max(*delay - (*delay >> 3), floor_ns);
+	}
+
+	sg_policy->min_rate_limit_ns = min(sg_policy->up_rate_delay_ns,
+					   sg_policy->down_rate_delay_ns);
+out:
+	sg_policy->last_change_dir = dir;
+	sg_policy->last_change_time = time;
+}
+
 static void sugov_update_commit(struct sugov_policy *sg_policy, u64 time,
 				unsigned int next_freq)
 {
@@ -151,6 +197,8 @@ static void sugov_update_commit(struct sugov_policy *sg_policy, u64 time,
 	if (sg_policy->next_freq == next_freq)
 		return;
 
+	sugov_adapt_rate_limits(sg_policy, time, next_freq);
+
 	sg_policy->next_freq = next_freq;
 	sg_policy->last_freq_update_time = time;
 
@@ -728,6 +776,44 @@ static ssize_t exp_util_store(struct gov_attr_set *attr_set, const char *buf,
 	return count;
 }
 
+static ssize_t adaptive_rate_limit_show(struct gov_attr_set *attr_set,
+					char *buf)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", tunables->adaptive_rate_limit);
+}
+
+static ssize_t adaptive_rate_limit_store(struct gov_attr_set *attr_set,
+					 const char *buf, size_t count)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+	struct sugov_policy *sg_policy;
+	unsigned long flags;
+	bool enable;
+
+	if (kstrtobool(buf, &enable))
+		return -EINVAL;
+
+	tunables->adaptive_rate_limit = enable;
+
+	/* Start learning from, or fall back to, the static rate limits */
+	list_for_each_entry(sg_policy, &attr_set->policy_list, tunables_hook) {
+		raw_spin_lock_irqsave(&sg_policy->update_lock, flags);
+		sg_policy->up_rate_delay_ns =
+			tunables->up_rate_limit_us * NSEC_PER_USEC;
+		sg_policy->down_rate_delay_ns =
+			tunables->down_rate_limit_us * NSEC_PER_USEC;
+		sg_policy->min_rate_limit_ns =
+			min(sg_policy->up_rate_delay_ns,
+			    sg_policy->down_rate_delay_ns);
+		sg_policy->last_change_dir = 0;
+		raw_spin_unlock_irqrestore(&sg_policy->update_lock, flags);
+	}
+
+	return count;
+}
+
 static struct governor_attr up_rate_limit_us = __ATTR_RW(up_rate_limit_us);
 static struct governor_attr down_rate_limit_us = __ATTR_RW(down_rate_limit_us);
 static struct governor_attr hispeed_load = __ATTR_RW(hispeed_load);
@@ -735,6 +821,7 @@ static struct governor_attr hispeed_freq = __ATTR_RW(hispeed_freq);
 static struct governor_attr pl = __ATTR_RW(pl);
 static struct governor_attr iowait_boost_enable = __ATTR_RW(iowait_boost_enable);
 static struct governor_attr exp_util = __ATTR_RW(exp_util);
+static struct governor_attr adaptive_rate_limit = __ATTR_RW(adaptive_rate_limit);
 
 static struct attribute *sugov_attributes[] = {
 	&up_rate_limit_us.attr,
@@ -744,6 +831,7 @@ static struct attribute *sugov_attributes[] = {
 	&pl.attr,
 	&iowait_boost_enable.attr,
 	&exp_util.attr,
+	&adaptive_rate_limit.attr,
 	NULL
 };
 
@@ -862,6 +950,7 @@ static void sugov_tunables_save(struct cpufreq_policy *policy,
 	cached->up_rate_limit_us = tunables->up_rate_limit_us;
 	cached->down_rate_limit_us = tunables->down_rate_limit_us;
 	cached->iowait_boost_enable = tunables->iowait_boost_enable;	
+	cached->adaptive_rate_limit = tunables->adaptive_rate_limit;
 }
 
 static void sugov_tunables_free(struct sugov_tunables *tunables)
@@ -888,6 +977,7 @@ static void sugov_tunables_restore(struct cpufreq_policy *policy)
 	tunables->up_rate_limit_us = cached->up_rate_limit_us;
 	tunables->down_rate_limit_us = cached->down_rate_limit_us;
 	tunables->iowait_boost_enable = cached->iowait_boost_enable;
+	tunables->adaptive_rate_limit = cached->adaptive_rate_limit;
 	sg_policy->up_rate_delay_ns = cached->up_rate_limit_us;
 	sg_policy->down_rate_delay_ns = cached->down_rate_limit_us;
 	update_min_rate_limit_us(sg_policy);
@@ -1016,6 +1106,8 @@ static int sugov_start(struct cpufreq_policy *policy)
 		sg_policy->tunables->down_rate_limit_us * NSEC_PER_USEC;
 	update_min_rate_limit_us(sg_policy);
 	sg_policy->last_freq_update_time = 0;
+	sg_policy->last_change_dir = 0;
+	sg_policy->last_change_time = 0;
 	sg_policy->next_freq = UINT_MAX;
 	sg_policy->work_in_progress = false;
 	sg_policy->need_freq_update = false;
@@ -28,6 +28,7 @@ struct sugov_tunables {
 	unsigned int hispeed_load;
 	unsigned int hispeed_freq;
 	bool pl;
+	bool pred_ramp;
 	bool exp_util;
 };
 
@@ -301,6 +302,7 @@ static void sugov_calc_avg_cap(struct sugov_policy *sg_policy, u64 curr_ws,
 }
 
 #define NL_RATIO 75
+#define PRED_RAMP_RATIO 125
 #define DEFAULT_HISPEED_LOAD 90
 static void sugov_walt_adjust(struct sugov_cpu *sg_cpu, unsigned long *util,
 			      unsigned long *max)
@@ -324,8 +326,28 @@ static void sugov_walt_adjust(struct sugov_cpu *sg_cpu, unsigned long *util,
 	if (is_hiload && nl >= mult_frac(cpu_util, NL_RATIO, 100))
 		*util = *max;
 
-	if (sg_policy->tunables->pl)
+	if (sg_policy->tunables->pl) {
 		*util = max(*util, sg_cpu->walt_load.pl);
+		return;
+	}
+
+	/*
+	 * In pred_ramp mode the predicted demand of the runnable tasks is
+	 * only honoured while it is clearly ahead of the last window's
+	 * utilization, i.e. while the load is ramping up. Once the window
+	 * catches up with the prediction the regular signal takes over
+	 * again, so the steady-state frequency floor is not raised.
+	 */
+	if (sg_policy->tunables->pred_ramp &&
+	    sg_cpu->walt_load.pl > mult_frac(cpu_util, PRED_RAMP_RATIO, 100))
+		*util = max(*util, min(sg_cpu->walt_load.pl, *max));
+}
+
+static inline bool sugov_skip_pl_update(struct sugov_policy *sg_policy,
+					unsigned int flags)
+{
+	return !sg_policy->tunables->pl && !sg_policy->tunables->pred_ramp &&
+	       (flags & SCHED_CPUFREQ_PL);
 }
 
 #ifdef CONFIG_NO_HZ_COMMON
@@ -353,7 +375,7 @@ static void sugov_update_single(struct update_util_data *hook, u64 time,
 
 	flags &= ~SCHED_CPUFREQ_RT_DL;
 
-	if (!sg_policy->tunables->pl && flags & SCHED_CPUFREQ_PL)
+	if (sugov_skip_pl_update(sg_policy, flags))
 		return;
 
 	sugov_set_iowait_boost(sg_cpu, time, flags);
@@ -450,7 +472,7 @@ static void sugov_update_shared(struct update_util_data *hook, u64 time,
 	unsigned long util, max, hs_util;
 	unsigned int next_f;
 
-	if (!sg_policy->tunables->pl && flags & SCHED_CPUFREQ_PL)
+	if (sugov_skip_pl_update(sg_policy, flags))
 		return;
 
 	sugov_get_util(&util, &max, sg_cpu->cpu);
@@ -676,6 +698,24 @@ static ssize_t pl_store(struct gov_attr_set *attr_set, const char *buf,
 	return count;
 }
 
+static ssize_t pred_ramp_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", tunables->pred_ramp);
+}
+
+static ssize_t pred_ramp_store(struct gov_attr_set *attr_set, const char *buf,
+			       size_t count)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	if (kstrtobool(buf, &tunables->pred_ramp))
+		return -EINVAL;
+
+	return count;
+}
+
 static ssize_t exp_util_show(struct gov_attr_set *attr_set, char *buf)
 {
 	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
@@ -699,6 +739,7 @@ static struct governor_attr down_rate_limit_us = __ATTR_RW(down_rate_limit_us);
 static struct governor_attr hispeed_load = __ATTR_RW(hispeed_load);
 static struct governor_attr hispeed_freq = __ATTR_RW(hispeed_freq);
 static struct governor_attr pl = __ATTR_RW(pl);
+static struct governor_attr pred_ramp = __ATTR_RW(pred_ramp);
 static struct governor_attr exp_util = __ATTR_RW(exp_util);
 
 static struct attribute *sugov_attributes[] = {
@@ -707,6 +748,7 @@ static struct attribute *sugov_attributes[] = {
 	&hispeed_load.attr,
 	&hispeed_freq.attr,
 	&pl.attr,
+	&pred_ramp.attr,
 	&exp_util.attr,
 	NULL
 };
@@ -820,6 +862,7 @@ static void sugov_tunables_save(struct cpufreq_policy *policy,
 	}
 
 	cached->pl = tunables->pl;
+	cached->pred_ramp = tunables->pred_ramp;
 	cached->exp_util = tunables->exp_util;
 	cached->hispeed_load = tunables->hispeed_load;
 	cached->hispeed_freq = tunables->hispeed_freq;
@@ -845,6 +888,7 @@ static void sugov_tunables_restore(struct cpufreq_policy *policy)
 		return;
 
 	tunables->pl = cached->pl;
+	tunables->pred_ramp = cached->pred_ramp;
 	tunables->exp_util = cached->exp_util;
 	tunables->hispeed_load = cached->hispeed_load;
 	tunables->hispeed_freq = cached->hispeed_freq;
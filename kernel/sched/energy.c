@@ -52,6 +52,25 @@ static void free_resources(void)
 
 static int update_topology;
 
+/*
+ * Rebuild the util bucket -> capacity state lookup table used by the EAS
+ * wakeup path. Must be called whenever the capacities of @sge change.
+ */
+static void sge_update_cap_lut(struct sched_group_energy *sge)
+{
+	int bucket, idx = 0;
+
+	for (bucket = 0; bucket < SGE_CAP_LUT_SIZE; bucket++) {
+		unsigned long util = bucket << SGE_CAP_LUT_SHIFT;
+
+		while (idx < sge->nr_cap_states - 1 &&
+		       sge->cap_states[idx].cap < util)
+			idx++;
+
+		sge->cap_idx_lut[bucket] = idx;
+	}
+}
+
 /*
  * Ideally this should be arch specific implementation,
  * let's define here to help rebuild sched_domain with new capacities.
@@ -230,11 +249,10 @@ static int sched_energy_probe(struct platform_device *pdev)
 		 */
 		sge_l0 = sge_array[cpu][SD_LEVEL0];
 		if (sge_l0 && sge_l0->nr_cap_states > 0) {
-			int i;
+			int i, sd_level;
 			int ncapstates = sge_l0->nr_cap_states;
 
 			for (i = 0; i < ncapstates; i++) {
-				int sd_level;
 				unsigned long freq, cap;
 
 				/*
@@ -261,6 +279,13 @@ static int sched_energy_probe(struct platform_device *pdev)
 					sge_l0->cap_states[i].power);
 			}
 
+			for_each_possible_sd_level(sd_level) {
+				sge = sge_array[cpu][sd_level];
+				if (!sge)
+					break;
+				sge_update_cap_lut(sge);
+			}
+
 			is_sge_valid = true;
 			dev_info(&pdev->dev,
 				"cpu=%d eff=%d [freq=%ld cap=%ld power_d0=%ld] -> [freq=%ld cap=%ld power_d0=%ld]\n",
@@ -5821,12 +5821,20 @@ static int find_new_capacity(struct energy_env *eenv, int cpu_idx)
 	const struct sched_group_energy *sge = eenv->sg->sge;
 	int idx, max_idx = sge->nr_cap_states - 1;
 	unsigned long util = group_max_util(eenv, cpu_idx);
+	unsigned long bucket;
 
 	/* default is max_cap if we don't find a match */
 	eenv->cpu[cpu_idx].cap_idx = max_idx;
 	eenv->cpu[cpu_idx].cap = sge->cap_states[max_idx].cap;
 
-	for (idx = 0; idx < sge->nr_cap_states; idx++) {
+	/*
+	 * No capacity state below the one cached for util's bucket can
+	 * satisfy util, so start the search from there.
+	 */
+	bucket = min_t(unsigned long, util >> SGE_CAP_LUT_SHIFT,
+		       SGE_CAP_LUT_SIZE - 1);
+
+	for (idx = sge->cap_idx_lut[bucket]; idx < sge->nr_cap_states; idx++) {
 		if (sge->cap_states[idx].cap >= util) {
 			/* Keep track of SG's capacity */
 			eenv->cpu[cpu_idx].cap_idx = idx;
@@ -9017,19 +9025,40 @@ void init_max_cpu_capacity(struct max_cpu_capacity *mcc)
 	mcc->cpu = -1;
 }
 
-static void update_cpu_capacity(struct sched_domain *sd, int cpu)
+static unsigned long calc_cpu_capacity_orig(struct sched_domain *sd, int cpu)
 {
 	unsigned long capacity = arch_scale_cpu_capacity(sd, cpu);
+
+	capacity *= arch_scale_max_freq_capacity(sd, cpu);
+	capacity >>= SCHED_CAPACITY_SHIFT;
+
+	return min(capacity, thermal_cap(cpu));
+}
+
+/*
+ * Pick up a new thermal limit right away instead of waiting for the next
+ * load balance to run update_cpu_capacity(), so that wakeup placement
+ * stops treating a throttled CPU as running at its nominal capacity.
+ */
+void refresh_cpu_capacity_orig(int cpu)
+{
+	struct rq *rq = cpu_rq(cpu);
+	unsigned long capacity = calc_cpu_capacity_orig(NULL, cpu);
+
+	WRITE_ONCE(rq->cpu_capacity_orig, capacity);
+	if (rq->cpu_capacity > capacity)
+		WRITE_ONCE(rq->cpu_capacity, capacity ?: 1);
+}
+
+static void update_cpu_capacity(struct sched_domain *sd, int cpu)
+{
+	unsigned long capacity = calc_cpu_capacity_orig(sd, cpu);
 	struct sched_group *sdg = sd->groups;
 	struct max_cpu_capacity *mcc;
 	unsigned long max_capacity;
 	int max_cap_cpu;
 	unsigned long flags;
 
-	capacity *= arch_scale_max_freq_capacity(sd, cpu);
-	capacity >>= SCHED_CAPACITY_SHIFT;
-
-	capacity = min(capacity, thermal_cap(cpu));
 	cpu_rq(cpu)->cpu_capacity_orig = capacity;
 
 	mcc = &cpu_rq(cpu)->rd->max_cpu_capacity;
@@ -0,0 +1,443 @@
+/*
+ * Scheduler latency benchmark modelled on Android frame workloads
+ *
+ * Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Every frame_period_us a vsync thread wakes a UI thread, which does
+ * ui_work_us of work, makes a synchronous call through a chain of
+ * binder_hops binder-like threads, and then hands the frame to a render
+ * thread. The frame misses its deadline when the render thread is not
+ * done within the period. Optionally nnoise background threads alternate
+ * noise_work_us of work with noise_sleep_us of sleep.
+ *
+ * Work is a fixed amount of computation, calibrated at load time against
+ * the fastest run on the loading CPU, so that frequency and placement
+ * decisions show up in the results. Once nframes frames have run, the
+ * wakeup latency of every stage, the deadline misses and the average
+ * frequency of each CPU are printed.
+ */
+
+#define pr_fmt(fmt) "frameperf: " fmt
+
+#include <linux/completion.h>
+#include <linux/cpufreq.h>
+#include <linux/delay.h>
+#include <linux/hrtimer.h>
+#include <linux/kthread.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+
+#define FRAMEPERF_MAX_HOPS	4
+#define FRAMEPERF_BUCKETS	24	/* log2 usec wakeup latency buckets */
+#define FRAMEPERF_CALIB_LOOPS	100000
+
+static unsigned int frame_period_us = 16667;
+module_param(frame_period_us, uint, 0444);
+MODULE_PARM_DESC(frame_period_us, "Frame period (us)");
+
+static unsigned int nframes = 600;
+module_param(nframes, uint, 0444);
+MODULE_PARM_DESC(nframes, "Number of frames to run");
+
+static unsigned int ui_work_us = 4000;
+module_param(ui_work_us, uint, 0444);
+MODULE_PARM_DESC(ui_work_us, "UI thread work per frame (us)");
+
+static unsigned int render_work_us = 6000;
+module_param(render_work_us, uint, 0444);
+MODULE_PARM_DESC(render_work_us, "Render thread work per frame (us)");
+
+static unsigned int binder_hops = 2;
+module_param(binder_hops, uint, 0444);
+MODULE_PARM_DESC(binder_hops, "Binder-like threads called by the UI thread");
+
+static unsigned int binder_work_us = 300;
+module_param(binder_work_us, uint, 0444);
+MODULE_PARM_DESC(binder_work_us, "Work per binder hop (us)");
+
+static unsigned int nnoise;
+module_param(nnoise, uint, 0444);
+MODULE_PARM_DESC(nnoise, "Number of background noise threads");
+
+static unsigned int noise_work_us = 2000;
+module_param(noise_work_us, uint, 0444);
+MODULE_PARM_DESC(noise_work_us, "Noise thread work per cycle (us)");
+
+static unsigned int noise_sleep_us = 2000;
+module_param(noise_sleep_us, uint, 0444);
+MODULE_PARM_DESC(noise_sleep_us, "Noise thread sleep per cycle (us)");
+
+/*
+ * A point where a thread is woken: the waker stamps @woken_at before
+ * completing @go, the wakee accounts the delay once it runs.
+ */
+struct frameperf_stage {
+	const char *name;
+	int nice;
+	struct task_struct *task;
+	void (*run)(struct frameperf_stage *st);
+	struct completion go;
+	ktime_t woken_at;
+	unsigned long nr;
+	u64 lat_sum_us;
+	u64 lat_max_us;
+	unsigned long lat_hist[FRAMEPERF_BUCKETS];
+};
+
+static struct frameperf_stage ui_stage, render_stage, reply_stage;
+static struct frameperf_stage binder_stage[FRAMEPERF_MAX_HOPS];
+static struct completion frame_done;
+static ktime_t frame_end;
+
+static struct task_struct *vsync_task;
+static struct task_struct **noise_tasks;
+static bool frameperf_stop;
+static unsigned long loops_per_us;
+
+static unsigned long deadline_misses;
+static u64 frame_max_us;
+static u64 freq_sum[NR_CPUS];
+static unsigned long freq_samples;
+
+static noinline void frameperf_work_loops(unsigned long loops)
+{
+	unsigned long v = 1;
+
+	while (loops--)
+		v = v * 1103515245 + 12345;
+	/* keep the result alive */
+	barrier_data(&v);
+}
+
+static void frameperf_work(unsigned int us)
+{
+	frameperf_work_loops(us * loops_per_us);
+}
+
+static void frameperf_calibrate(void)
+{
+	u64 best_ns = U64_MAX, ns;
+	ktime_t start;
+	int i;
+
+	for (i = 0; i < 20; i++) {
+		start = ktime_get();
+		frameperf_work_loops(FRAMEPERF_CALIB_LOOPS);
+		ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+		best_ns = min(best_ns, max_t(u64, ns, 1));
+	}
+
+	loops_per_us = max_t(u64, 1, div64_u64(FRAMEPERF_CALIB_LOOPS *
+					       NSEC_PER_USEC, best_ns));
+}
+
+static void frameperf_kick(struct frameperf_stage *st)
+{
+	st->woken_at = ktime_get();
+	complete(&st->go);
+}
+
+static void frameperf_account(struct frameperf_stage *st)
+{
+	u64 us = ktime_us_delta(ktime_get(), st->woken_at);
+
+	st->nr++;
+	st->lat_sum_us += us;
+	st->lat_max_us = max(st->lat_max_us, us);
+	st->lat_hist[min_t(int, fls64(us), FRAMEPERF_BUCKETS - 1)]++;
+}
+
+/* Upper bound of the latency (us) below which @permille of wakeups fell */
+static u64 frameperf_permille(struct frameperf_stage *st,
+			      unsigned int permille)
+{
+	unsigned long sum = 0;
+	int i;
+
+	for (i = 0; i < FRAMEPERF_BUCKETS - 1; i++) {
+		sum += st->lat_hist[i];
+		if (sum * 1000 >= (u64)st->nr * permille)
+			return 1ULL << i;
+	}
+	return st->lat_max_us;
+}
+
+static void frameperf_ui_run(struct frameperf_stage *st)
+{
+	frameperf_work(ui_work_us);
+
+	if (binder_hops) {
+		frameperf_kick(&binder_stage[0]);
+		wait_for_completion(&reply_stage.go);
+		frameperf_account(&reply_stage);
+	}
+
+	frameperf_kick(&render_stage);
+}
+
+static void frameperf_binder_run(struct frameperf_stage *st)
+{
+	int hop = st - binder_stage;
+
+	frameperf_work(binder_work_us);
+
+	if (hop + 1 < binder_hops)
+		frameperf_kick(&binder_stage[hop + 1]);
+	else
+		frameperf_kick(&reply_stage);
+}
+
+static void frameperf_render_run(struct frameperf_stage *st)
+{
+	frameperf_work(render_work_us);
+
+	frame_end = ktime_get();
+	complete(&frame_done);
+}
+
+static int frameperf_stage_fn(void *arg)
+{
+	struct frameperf_stage *st = arg;
+
+	set_user_nice(current, st->nice);
+
+	for (;;) {
+		wait_for_completion(&st->go);
+		if (READ_ONCE(frameperf_stop))
+			break;
+		frameperf_account(st);
+		st->run(st);
+	}
+
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(HZ);
+	return 0;
+}
+
+static int frameperf_noise_fn(void *arg)
+{
+	/* Background apps run at THREAD_PRIORITY_BACKGROUND */
+	set_user_nice(current, 10);
+
+	while (!kthread_should_stop()) {
+		frameperf_work(noise_work_us);
+		usleep_range(noise_sleep_us, noise_sleep_us + 100);
+	}
+	return 0;
+}
+
+static void frameperf_sample_freq(void)
+{
+	int cpu;
+
+	for_each_online_cpu(cpu)
+		freq_sum[cpu] += cpufreq_quick_get(cpu);
+	freq_samples++;
+}
+
+static void frameperf_print_stage(struct frameperf_stage *st)
+{
+	if (!st->nr)
+		return;
+
+	pr_info("%-8s wakeups %lu avg %llu us p50 <= %llu us p99 <= %llu us max %llu us\n",
+		st->name, st->nr, div64_u64(st->lat_sum_us, st->nr),
+		frameperf_permille(st, 500), frameperf_permille(st, 990),
+		st->lat_max_us);
+}
+
+static void frameperf_report(unsigned int frames)
+{
+	unsigned int i;
+	int cpu;
+
+	pr_info("period %u us, ui %u us, render %u us, %u hops of %u us, %u noise threads, %lu loops/us\n",
+		frame_period_us, ui_work_us, render_work_us, binder_hops,
+		binder_work_us, nnoise, loops_per_us);
+	pr_info("frames %u, deadline misses %lu, longest frame %llu us\n",
+		frames, deadline_misses, frame_max_us);
+
+	frameperf_print_stage(&ui_stage);
+	for (i = 0; i < binder_hops; i++)
+		frameperf_print_stage(&binder_stage[i]);
+	frameperf_print_stage(&reply_stage);
+	frameperf_print_stage(&render_stage);
+
+	if (!freq_samples)
+		return;
+	for_each_possible_cpu(cpu) {
+		if (freq_sum[cpu])
+			pr_info("cpu%d average frequency %llu kHz\n", cpu,
+				div64_u64(freq_sum[cpu], freq_samples));
+	}
+}
+
+static int frameperf_vsync_fn(void *arg)
+{
+	ktime_t next = ktime_add_us(ktime_get(), frame_period_us);
+	unsigned int frames;
+	u64 us;
+
+	for (frames = 0; frames < nframes && !kthread_should_stop();
+	     frames++) {
+		set_current_state(TASK_UNINTERRUPTIBLE);
+		schedule_hrtimeout(&next, HRTIMER_MODE_ABS);
+
+		frameperf_kick(&ui_stage);
+		wait_for_completion(&frame_done);
+
+		us = ktime_us_delta(frame_end, next);
+		frame_max_us = max(frame_max_us, us);
+		if (us > frame_period_us)
+			deadline_misses++;
+		frameperf_sample_freq();
+
+		/* A late frame makes the following vsyncs drop, as on device */
+		next = ktime_add_us(next, frame_period_us);
+		while (ktime_before(next, ktime_get()))
+			next = ktime_add_us(next, frame_period_us);
+	}
+
+	frameperf_report(frames);
+
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(HZ);
+	return 0;
+}
+
+static int frameperf_start_stage(struct frameperf_stage *st, const char *name,
+				 int nice,
+				 void (*run)(struct frameperf_stage *st))
+{
+	st->name = name;
+	st->nice = nice;
+	st->run = run;
+	init_completion(&st->go);
+
+	st->task = kthread_run(frameperf_stage_fn, st, "frameperf_%s", name);
+	if (IS_ERR(st->task)) {
+		int ret = PTR_ERR(st->task);
+
+		st->task = NULL;
+		return ret;
+	}
+	return 0;
+}
+
+static void frameperf_stop_stage(struct frameperf_stage *st)
+{
+	if (!st->task)
+		return;
+
+	complete(&st->go);
+	kthread_stop(st->task);
+	st->task = NULL;
+}
+
+static void frameperf_cleanup(void)
+{
+	unsigned int i;
+
+	if (vsync_task)
+		kthread_stop(vsync_task);
+
+	WRITE_ONCE(frameperf_stop, true);
+	frameperf_stop_stage(&ui_stage);
+	for (i = 0; i < FRAMEPERF_MAX_HOPS; i++)
+		frameperf_stop_stage(&binder_stage[i]);
+	frameperf_stop_stage(&render_stage);
+
+	if (noise_tasks) {
+		for (i = 0; i < nnoise; i++) {
+			if (noise_tasks[i])
+				kthread_stop(noise_tasks[i]);
+		}
+		kfree(noise_tasks);
+	}
+}
+
+static const char * const binder_names[FRAMEPERF_MAX_HOPS] = {
+	"binder0", "binder1", "binder2", "binder3",
+};
+
+static int __init frameperf_init(void)
+{
+	struct task_struct *task;
+	unsigned int i;
+	int ret;
+
+	if (!frame_period_us || binder_hops > FRAMEPERF_MAX_HOPS)
+		return -EINVAL;
+
+	frameperf_calibrate();
+	init_completion(&frame_done);
+	reply_stage.name = "reply";
+	init_completion(&reply_stage.go);
+
+	/* UI and render threads run at THREAD_PRIORITY_URGENT_DISPLAY */
+	ret = frameperf_start_stage(&ui_stage, "ui", -8, frameperf_ui_run);
+	if (ret)
+		goto err;
+	ret = frameperf_start_stage(&render_stage, "render", -8,
+				    frameperf_render_run);
+	if (ret)
+		goto err;
+	for (i = 0; i < binder_hops; i++) {
+		ret = frameperf_start_stage(&binder_stage[i], binder_names[i],
+					    0, frameperf_binder_run);
+		if (ret)
+			goto err;
+	}
+
+	if (nnoise) {
+		noise_tasks = kcalloc(nnoise, sizeof(*noise_tasks),
+				      GFP_KERNEL);
+		if (!noise_tasks) {
+			ret = -ENOMEM;
+			goto err;
+		}
+		for (i = 0; i < nnoise; i++) {
+			task = kthread_run(frameperf_noise_fn, NULL,
+					   "frameperf_noise%u", i);
+			if (IS_ERR(task)) {
+				ret = PTR_ERR(task);
+				goto err;
+			}
+			noise_tasks[i] = task;
+		}
+	}
+
+	task = kthread_run(frameperf_vsync_fn, NULL, "frameperf_vsync");
+	if (IS_ERR(task)) {
+		ret = PTR_ERR(task);
+		goto err;
+	}
+	vsync_task = task;
+	return 0;
+
+err:
+	frameperf_cleanup();
+	return ret;
+}
+
+static void __exit frameperf_exit(void)
+{
+	frameperf_cleanup();
+}
+
+module_init(frameperf_init);
+module_exit(frameperf_exit);
+
+MODULE_LICENSE("GPL v2");
+MODULE_DESCRIPTION("Scheduler frame workload latency benchmark");
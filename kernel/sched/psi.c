@@ -140,6 +140,7 @@
 #include <linux/file.h>
 #include <linux/poll.h>
 #include <linux/psi.h>
+#include <linux/kstats.h>
 #include "sched.h"
 
 static int psi_bug __read_mostly;
@@ -537,6 +538,8 @@ static u64 update_triggers(struct psi_group *group, u64 now)
 		/* Generate an event */
 		if (cmpxchg(&t->event, 0, 1) == 0)
 			wake_up_interruptible(&t->event_wait);
+		if (t->notify)
+			t->notify(t->notify_data);
 		t->last_event_time = now;
 	}
 
@@ -1004,23 +1007,11 @@ static int psi_cpu_open(struct inode *inode, struct file *file)
 	return single_open(file, psi_cpu_show, NULL);
 }
 
-struct psi_trigger *psi_trigger_create(struct psi_group *group,
-			char *buf, size_t nbytes, enum psi_res res)
+static struct psi_trigger *__psi_trigger_create(struct psi_group *group,
+			enum psi_states state, u32 threshold_us, u32 window_us,
+			void (*notify)(void *data), void *data)
 {
 	struct psi_trigger *t;
-	enum psi_states state;
-	u32 threshold_us;
-	u32 window_us;
-
-	if (static_branch_likely(&psi_disabled))
-		return ERR_PTR(-EOPNOTSUPP);
-
-	if (sscanf(buf, "some %u %u", &threshold_us, &window_us) == 2)
-		state = PSI_IO_SOME + res * 2;
-	else if (sscanf(buf, "full %u %u", &threshold_us, &window_us) == 2)
-		state = PSI_IO_FULL + res * 2;
-	else
-		return ERR_PTR(-EINVAL);
 
 	if (state >= PSI_NONIDLE)
 		return ERR_PTR(-EINVAL);
@@ -1045,6 +1036,8 @@ struct psi_trigger *psi_trigger_create(struct psi_group *group,
 
 	t->event = 0;
 	t->last_event_time = 0;
+	t->notify = notify;
+	t->notify_data = data;
 	init_waitqueue_head(&t->event_wait);
 	kref_init(&t->refcount);
 
@@ -1079,6 +1072,43 @@ struct psi_trigger *psi_trigger_create(struct psi_group *group,
 	return t;
 }
 
+struct psi_trigger *psi_trigger_create(struct psi_group *group,
+			char *buf, size_t nbytes, enum psi_res res)
+{
+	enum psi_states state;
+	u32 threshold_us;
+	u32 window_us;
+
+	if (static_branch_likely(&psi_disabled))
+		return ERR_PTR(-EOPNOTSUPP);
+
+	if (sscanf(buf, "some %u %u", &threshold_us, &window_us) == 2)
+		state = PSI_IO_SOME + res * 2;
+	else if (sscanf(buf, "full %u %u", &threshold_us, &window_us) == 2)
+		state = PSI_IO_FULL + res * 2;
+	else
+		return ERR_PTR(-EINVAL);
+
+	return __psi_trigger_create(group, state, threshold_us, window_us,
+				    NULL, NULL);
+}
+
+/*
+ * Create a system-wide trigger for an in-kernel consumer. @notify is called
+ * from the psimon thread, with the trigger lock held, every time the trigger
+ * fires and must not sleep for long.
+ */
+struct psi_trigger *psi_kernel_trigger_create(enum psi_states state,
+			u32 threshold_us, u32 window_us,
+			void (*notify)(void *data), void *data)
+{
+	if (static_branch_likely(&psi_disabled))
+		return ERR_PTR(-EOPNOTSUPP);
+
+	return __psi_trigger_create(&psi_system, state, threshold_us,
+				    window_us, notify, data);
+}
+
 static void psi_trigger_destroy(struct kref *ref)
 {
 	struct psi_trigger *t = container_of(ref, struct psi_trigger, refcount);
@@ -1146,6 +1176,14 @@ static void psi_trigger_destroy(struct kref *ref)
 	kfree(t);
 }
 
+void psi_kernel_trigger_destroy(struct psi_trigger *t)
+{
+	if (static_branch_likely(&psi_disabled) || !t)
+		return;
+
+	kref_put(&t->refcount, psi_trigger_destroy);
+}
+
 void psi_trigger_replace(void **trigger_ptr, struct psi_trigger *new)
 {
 	struct psi_trigger *old = *trigger_ptr;
@@ -1281,12 +1319,60 @@ static const struct file_operations psi_cpu_fops = {
 	.release        = psi_fop_release,
 };
 
+#ifdef CONFIG_KSTATS
+static int psi_kstats_fill(void *buf, size_t max_len)
+{
+	struct psi_group *group = &psi_system;
+	struct kstats_psi *kp = buf;
+	u64 now;
+	int s;
+
+	if (static_branch_likely(&psi_disabled))
+		return -EOPNOTSUPP;
+
+	mutex_lock(&group->avgs_lock);
+	now = sched_clock();
+	collect_percpu_times(group, PSI_AVGS, NULL);
+	if (now >= group->avg_next_update)
+		group->avg_next_update = update_averages(group, now);
+
+	/*
+	 * The psi states are in the order of enum kstats_psi_state, which
+	 * also has room for a full CPU state that this kernel lacks.
+	 */
+	memset(kp, 0, sizeof(*kp));
+	for (s = 0; s < NR_PSI_STATES - 1; s++) {
+		kp->total_us[s] = div_u64(group->total[PSI_AVGS][s],
+					  NSEC_PER_USEC);
+		kp->avg10[s] = LOAD_INT(group->avg[s][0]) * 100 +
+			       LOAD_FRAC(group->avg[s][0]);
+		kp->avg60[s] = LOAD_INT(group->avg[s][1]) * 100 +
+			       LOAD_FRAC(group->avg[s][1]);
+		kp->avg300[s] = LOAD_INT(group->avg[s][2]) * 100 +
+				LOAD_FRAC(group->avg[s][2]);
+	}
+	mutex_unlock(&group->avgs_lock);
+
+	return sizeof(*kp);
+}
+
+static struct kstats_source psi_kstats_source = {
+	.type		= KSTATS_TYPE_PSI,
+	.version	= 1,
+	.max_len	= sizeof(struct kstats_psi),
+	.fill		= psi_kstats_fill,
+};
+#endif
+
 static int __init psi_proc_init(void)
 {
 	proc_mkdir("pressure", NULL);
 	proc_create("pressure/io", 0, NULL, &psi_io_fops);
 	proc_create("pressure/memory", 0, NULL, &psi_memory_fops);
 	proc_create("pressure/cpu", 0, NULL, &psi_cpu_fops);
+#ifdef CONFIG_KSTATS
+	kstats_register_source(&psi_kstats_source);
+#endif
 	return 0;
 }
 module_init(psi_proc_init);
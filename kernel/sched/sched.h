@@ -837,6 +837,14 @@ struct rq {
 	bool notif_pending;
 	u64 last_cc_update;
 	u64 cycles;
+
+	/*
+	 * Window rollover snapshot, published under rq->lock and read
+	 * locklessly by the cluster-wide frequency aggregation.
+	 */
+	seqcount_t rollover_seqcnt;
+	u64 rollover_ws;
+	u64 rollover_grp_prev_runnable_sum;
 #endif
 
 #ifdef CONFIG_IRQ_TIME_ACCOUNTING
@@ -2426,6 +2434,7 @@ struct related_thread_group {
 	struct sched_cluster *preferred_cluster;
 	struct rcu_head rcu;
 	u64 last_update;
+	u64 last_auto_wakeup;
 };
 
 extern struct list_head cluster_head;
@@ -2712,6 +2721,8 @@ static inline int same_freq_domain(int src_cpu, int dst_cpu)
 #define	CPU_RESERVED	1
 
 extern int sched_boost(void);
+extern enum sched_boost_policy sched_boost_policy(void);
+extern enum sched_boost_policy sched_boost_type_policy(int type);
 extern int preferred_cluster(struct sched_cluster *cluster,
 						struct task_struct *p);
 extern struct sched_cluster *rq_cluster(struct rq *rq);
@@ -2720,6 +2731,8 @@ extern void clear_top_tasks_bitmap(unsigned long *bitmap);
 
 #if defined(CONFIG_SCHED_TUNE) && defined(CONFIG_CGROUP_SCHEDTUNE)
 extern bool task_sched_boost(struct task_struct *p);
+extern enum sched_boost_policy task_sched_boost_policy(struct task_struct *p,
+						       int *type);
 extern int sync_cgroup_colocation(struct task_struct *p, bool insert);
 extern bool schedtune_task_colocated(struct task_struct *p);
 extern void update_cgroup_boost_settings(void);
@@ -2736,6 +2749,13 @@ static inline bool task_sched_boost(struct task_struct *p)
 	return true;
 }
 
+static inline enum sched_boost_policy
+task_sched_boost_policy(struct task_struct *p, int *type)
+{
+	*type = sched_boost();
+	return sched_boost_policy();
+}
+
 static inline void update_cgroup_boost_settings(void) { }
 static inline void restore_cgroup_boost_settings(void) { }
 #endif
@@ -2784,12 +2804,12 @@ static inline void walt_fixup_cum_window_demand(struct rq *rq, s64 delta)
 extern void update_cpu_cluster_capacity(const cpumask_t *cpus);
 
 extern unsigned long thermal_cap(int cpu);
+extern void refresh_cpu_capacity_orig(int cpu);
 
 extern void clear_walt_request(int cpu);
 
 extern int got_boost_kick(void);
 extern void clear_boost_kick(int cpu);
-extern enum sched_boost_policy sched_boost_policy(void);
 extern void sched_boost_parse_dt(void);
 extern void clear_ed_task(struct task_struct *p, struct rq *rq);
 extern bool early_detection_notify(struct rq *rq, u64 wallclock);
@@ -2812,15 +2832,16 @@ extern void walt_update_min_max_capacity(void);
 
 static inline enum sched_boost_policy task_boost_policy(struct task_struct *p)
 {
-	enum sched_boost_policy boost_on_big = task_sched_boost(p) ?
-				sched_boost_policy() : SCHED_BOOST_NONE;
+	int boost_type;
+	enum sched_boost_policy boost_on_big =
+				task_sched_boost_policy(p, &boost_type);
 
 	if (boost_on_big) {
 		/*
 		 * Filter out tasks less than min task util threshold
 		 * under conservative boost.
 		 */
-		if (sysctl_sched_boost == CONSERVATIVE_BOOST &&
+		if (boost_type == CONSERVATIVE_BOOST &&
 				task_util(p) <=
 				sysctl_sched_min_task_util_for_boost_colocation)
 			boost_on_big = SCHED_BOOST_NONE;
@@ -0,0 +1,356 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * PELT/WALT signal replay harness.
+ *
+ * Replays a single-task run/sleep trace through simplified models of the
+ * PELT and WALT utilization signals and of schedutil's frequency selection,
+ * then reports the resulting frequency residency and the energy estimated
+ * from the energy model of the selected CPU. This allows the two signals
+ * to be compared for one workload without rebuilding the kernel.
+ *
+ * The trace is written to <debugfs>/sched_replay/trace as lines of
+ *
+ *	<duration_us> <running_us>
+ *
+ * each describing a segment of <duration_us> wall time in which the task
+ * first runs for <running_us> at maximum capacity and then sleeps. Such a
+ * trace is easily derived from sched_switch events of a captured trace.
+ * Opening the file with O_TRUNC (e.g. "cat trace.txt > trace") starts a
+ * new replay. Results are read from <debugfs>/sched_replay/result and the
+ * energy model CPU is selected with <debugfs>/sched_replay/cpu, which should
+ * be set before a replay is started.
+ *
+ * Each step emits the sched_replay_step tracepoint.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/kernel.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/sched_energy.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+
+#include "sched.h"
+#include "walt.h"
+#include <trace/events/sched.h>
+
+/* PELT period and decay factor: y^32 ~= 0.5, y ~= 1002/1024 */
+#define REPLAY_STEP_US		1024
+#define REPLAY_PELT_Y		1002
+
+/* schedutil's 1.25 frequency headroom */
+#define REPLAY_HEADROOM(util)	((util) + ((util) >> 2))
+
+#define REPLAY_MAX_CAP_STATES	32
+#define REPLAY_LINE_MAX		64
+
+enum replay_signal {
+	REPLAY_PELT,
+	REPLAY_WALT,
+	NR_REPLAY_SIGNALS,
+};
+
+static const char * const replay_signal_names[NR_REPLAY_SIGNALS] = {
+	"pelt", "walt",
+};
+
+struct replay_state {
+	/* Position inside the current step */
+	u32 step_pos;
+	u32 step_run;
+	u64 now_us;
+
+	/* PELT model */
+	unsigned long pelt_util;
+
+	/* WALT model */
+	u32 win_pos;
+	u32 win_run;
+	u32 hist[RAVG_HIST_SIZE_MAX];
+	unsigned long walt_util;
+
+	/* Results */
+	u64 residency_us[NR_REPLAY_SIGNALS][REPLAY_MAX_CAP_STATES];
+	u64 energy_nj[NR_REPLAY_SIGNALS];
+
+	/* Partial input line carried over between writes */
+	char line[REPLAY_LINE_MAX];
+	int line_len;
+};
+
+static DEFINE_MUTEX(replay_mutex);
+static struct replay_state *replay;
+static u32 replay_cpu;
+
+static struct sched_group_energy *replay_sge(void)
+{
+	if (replay_cpu >= nr_cpu_ids || !cpu_possible(replay_cpu))
+		return NULL;
+
+	return sge_array[replay_cpu][SD_LEVEL0];
+}
+
+static void replay_update_pelt(struct replay_state *rs)
+{
+	unsigned long contrib = (rs->step_run << SCHED_CAPACITY_SHIFT) /
+				REPLAY_STEP_US;
+
+	rs->pelt_util = (rs->pelt_util * REPLAY_PELT_Y +
+			 contrib * (1024 - REPLAY_PELT_Y)) >> 10;
+}
+
+/*
+ * Mirrors the default WINDOW_STATS_MAX_RECENT_AVG policy: the demand is
+ * the larger of the most recent window and the average of the history.
+ */
+static void replay_update_walt(struct replay_state *rs)
+{
+	u32 window_us = sched_ravg_window / NSEC_PER_USEC;
+	u32 hist_size = min_t(u32, sched_ravg_hist_size, RAVG_HIST_SIZE_MAX);
+	u64 sum = 0;
+	int i;
+
+	rs->win_pos += REPLAY_STEP_US;
+	rs->win_run += rs->step_run;
+	if (rs->win_pos < window_us)
+		return;
+
+	for (i = hist_size - 1; i > 0; i--)
+		rs->hist[i] = rs->hist[i - 1];
+	rs->hist[0] = min(rs->win_run, window_us);
+
+	for (i = 0; i < hist_size; i++)
+		sum += rs->hist[i];
+
+	rs->walt_util = ((u64)max_t(u32, rs->hist[0],
+				    div_u64(sum, hist_size)) <<
+			 SCHED_CAPACITY_SHIFT) / window_us;
+
+	rs->win_pos -= window_us;
+	rs->win_run = 0;
+}
+
+static int replay_find_cap_state(struct sched_group_energy *sge,
+				 unsigned long util)
+{
+	unsigned long req = REPLAY_HEADROOM(util);
+	int nr = min_t(int, sge->nr_cap_states, REPLAY_MAX_CAP_STATES);
+	int idx;
+
+	for (idx = 0; idx < nr - 1; idx++)
+		if (sge->cap_states[idx].cap >= req)
+			break;
+
+	return idx;
+}
+
+static void replay_account(struct replay_state *rs,
+			   struct sched_group_energy *sge,
+			   enum replay_signal sig, int idx)
+{
+	struct capacity_state *cs = &sge->cap_states[idx];
+	unsigned long max_cap = sge->cap_states[sge->nr_cap_states - 1].cap;
+	u64 busy;
+
+	/* Running time was captured at max capacity, stretch it to this OPP */
+	busy = min_t(u64, REPLAY_STEP_US,
+		     div_u64((u64)rs->step_run * max_cap, max(cs->cap, 1UL)));
+
+	rs->residency_us[sig][idx] += REPLAY_STEP_US;
+	rs->energy_nj[sig] += busy * cs->power;
+	if (sge->nr_idle_states)
+		rs->energy_nj[sig] += (REPLAY_STEP_US - busy) *
+				      sge->idle_states[0].power;
+}
+
+static void replay_end_step(struct replay_state *rs,
+			    struct sched_group_energy *sge)
+{
+	int idx[NR_REPLAY_SIGNALS];
+
+	replay_update_pelt(rs);
+	replay_update_walt(rs);
+
+	idx[REPLAY_PELT] = replay_find_cap_state(sge, rs->pelt_util);
+	idx[REPLAY_WALT] = replay_find_cap_state(sge, rs->walt_util);
+	replay_account(rs, sge, REPLAY_PELT, idx[REPLAY_PELT]);
+	replay_account(rs, sge, REPLAY_WALT, idx[REPLAY_WALT]);
+
+	rs->now_us += REPLAY_STEP_US;
+	trace_sched_replay_step(rs->now_us, rs->step_run,
+				rs->pelt_util, rs->walt_util,
+				sge->cap_states[idx[REPLAY_PELT]].frequency,
+				sge->cap_states[idx[REPLAY_WALT]].frequency);
+
+	rs->step_pos = 0;
+	rs->step_run = 0;
+}
+
+static void replay_feed(struct replay_state *rs, struct sched_group_energy *sge,
+			bool running, u64 us)
+{
+	while (us) {
+		u32 chunk = min_t(u64, us, REPLAY_STEP_US - rs->step_pos);
+
+		rs->step_pos += chunk;
+		if (running)
+			rs->step_run += chunk;
+		us -= chunk;
+
+		if (rs->step_pos == REPLAY_STEP_US)
+			replay_end_step(rs, sge);
+	}
+}
+
+static int replay_parse_line(struct replay_state *rs,
+			     struct sched_group_energy *sge, char *line)
+{
+	u64 duration, running;
+
+	line = strim(line);
+	if (!*line)
+		return 0;
+
+	if (sscanf(line, "%llu %llu", &duration, &running) != 2 ||
+	    running > duration)
+		return -EINVAL;
+
+	replay_feed(rs, sge, true, running);
+	replay_feed(rs, sge, false, duration - running);
+
+	return 0;
+}
+
+static ssize_t replay_trace_write(struct file *filp, const char __user *ubuf,
+				  size_t cnt, loff_t *ppos)
+{
+	struct sched_group_energy *sge;
+	size_t done = 0;
+	int ret = 0;
+
+	mutex_lock(&replay_mutex);
+
+	sge = replay_sge();
+	if (!replay || !sge || !sge->nr_cap_states) {
+		ret = -ENODEV;
+		goto unlock;
+	}
+
+	while (done < cnt) {
+		char c;
+
+		if (get_user(c, ubuf + done)) {
+			ret = -EFAULT;
+			goto unlock;
+		}
+		done++;
+
+		if (c != '\n') {
+			if (replay->line_len >= REPLAY_LINE_MAX - 1) {
+				ret = -EINVAL;
+				goto unlock;
+			}
+			replay->line[replay->line_len++] = c;
+			continue;
+		}
+
+		replay->line[replay->line_len] = '\0';
+		replay->line_len = 0;
+		ret = replay_parse_line(replay, sge, replay->line);
+		if (ret)
+			goto unlock;
+	}
+
+	*ppos += done;
+unlock:
+	mutex_unlock(&replay_mutex);
+
+	return ret ? ret : done;
+}
+
+static int replay_trace_open(struct inode *inode, struct file *filp)
+{
+	if (!(filp->f_flags & O_TRUNC))
+		return 0;
+
+	mutex_lock(&replay_mutex);
+	if (replay)
+		memset(replay, 0, sizeof(*replay));
+	mutex_unlock(&replay_mutex);
+
+	return 0;
+}
+
+static const struct file_operations replay_trace_fops = {
+	.open		= replay_trace_open,
+	.write		= replay_trace_write,
+	.llseek		= noop_llseek,
+};
+
+static int replay_result_show(struct seq_file *m, void *v)
+{
+	struct sched_group_energy *sge;
+	int sig, idx, nr;
+
+	mutex_lock(&replay_mutex);
+
+	sge = replay_sge();
+	if (!replay || !sge || !sge->nr_cap_states)
+		goto unlock;
+
+	nr = min_t(int, sge->nr_cap_states, REPLAY_MAX_CAP_STATES);
+
+	seq_printf(m, "cpu: %u replayed_us: %llu\n", replay_cpu,
+		   replay->now_us);
+	for (sig = 0; sig < NR_REPLAY_SIGNALS; sig++) {
+		seq_printf(m, "%s: energy_uj: %llu\n", replay_signal_names[sig],
+			   div_u64(replay->energy_nj[sig], NSEC_PER_USEC));
+		for (idx = 0; idx < nr; idx++)
+			seq_printf(m, "%s: freq: %lu residency_us: %llu\n",
+				   replay_signal_names[sig],
+				   sge->cap_states[idx].frequency,
+				   replay->residency_us[sig][idx]);
+	}
+
+unlock:
+	mutex_unlock(&replay_mutex);
+
+	return 0;
+}
+
+static int replay_result_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, replay_result_show, NULL);
+}
+
+static const struct file_operations replay_result_fops = {
+	.open		= replay_result_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init sched_replay_init(void)
+{
+	struct dentry *dir;
+
+	replay = kzalloc(sizeof(*replay), GFP_KERNEL);
+	if (!replay)
+		return -ENOMEM;
+
+	dir = debugfs_create_dir("sched_replay", NULL);
+	if (!dir) {
+		kfree(replay);
+		replay = NULL;
+		return -ENOMEM;
+	}
+
+	debugfs_create_u32("cpu", 0644, dir, &replay_cpu);
+	debugfs_create_file("trace", 0200, dir, NULL, &replay_trace_fops);
+	debugfs_create_file("result", 0444, dir, NULL, &replay_result_fops);
+
+	return 0;
+}
+late_initcall(sched_replay_init);
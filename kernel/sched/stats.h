@@ -1,4 +1,6 @@
 
+#include <trace/events/sched.h>
+
 #ifdef CONFIG_SCHEDSTATS
 
 /*
@@ -174,8 +176,10 @@ static void sched_info_arrive(struct rq *rq, struct task_struct *t)
 {
 	unsigned long long now = rq_clock(rq), delta = 0;
 
-	if (t->sched_info.last_queued)
+	if (t->sched_info.last_queued) {
 		delta = now - t->sched_info.last_queued;
+		trace_sched_run_delay(t, delta);
+	}
 	sched_info_reset_dequeued(t);
 	t->sched_info.run_delay += delta;
 	t->sched_info.last_arrival = now;
@@ -212,6 +212,16 @@ struct schedtune {
 	 */
 	bool sched_boost_enabled_backup;
 
+	/*
+	 * Sched boost level that applies to tasks of this cgroup only. When
+	 * set it takes precedence over the global sched_boost level, so that
+	 * boosting one group does not move tasks of every other group to the
+	 * big cluster. The matching placement policy is resolved once on
+	 * write so that the placement hot path only has to load it.
+	 */
+	int sched_boost_level;
+	enum sched_boost_policy sched_boost_level_policy;
+
 	/*
 	 * Controls whether tasks of this cgroup should be colocated with each
 	 * other and tasks of other cgroups that have the same flag turned on.
@@ -285,6 +295,8 @@ root_schedtune = {
 	.sched_boost_no_override = false,
 	.sched_boost_enabled = true,
 	.sched_boost_enabled_backup = true,
+	.sched_boost_level = NO_BOOST,
+	.sched_boost_level_policy = SCHED_BOOST_NONE,
 	.colocate = false,
 	.colocate_update_disabled = false,
 #endif
@@ -392,6 +404,8 @@ static inline void init_sched_boost(struct schedtune *st)
 	st->sched_boost_no_override = false;
 	st->sched_boost_enabled = true;
 	st->sched_boost_enabled_backup = st->sched_boost_enabled;
+	st->sched_boost_level = NO_BOOST;
+	st->sched_boost_level_policy = SCHED_BOOST_NONE;
 	st->colocate = false;
 	st->colocate_update_disabled = false;
 }
@@ -431,6 +445,32 @@ bool task_sched_boost(struct task_struct *p)
 	return st->sched_boost_enabled;
 }
 
+/*
+ * Resolve the boost placement policy of @p. A boost level attached to the
+ * task's cgroup wins over the global one; otherwise the global level only
+ * applies if the cgroup is eligible for sched boost. The boost type behind
+ * the returned policy is stored in @type.
+ */
+enum sched_boost_policy task_sched_boost_policy(struct task_struct *p,
+						int *type)
+{
+	struct schedtune *st = task_schedtune(p);
+	int level = READ_ONCE(st->sched_boost_level);
+
+	if (level != NO_BOOST) {
+		*type = level;
+		return READ_ONCE(st->sched_boost_level_policy);
+	}
+
+	if (!st->sched_boost_enabled) {
+		*type = NO_BOOST;
+		return SCHED_BOOST_NONE;
+	}
+
+	*type = sched_boost();
+	return sched_boost_policy();
+}
+
 static u64
 sched_boost_override_read(struct cgroup_subsys_state *css,
 			struct cftype *cft)
@@ -732,6 +772,34 @@ static int sched_boost_enabled_write(struct cgroup_subsys_state *css,
 	return 0;
 }
 
+static u64 sched_boost_level_read(struct cgroup_subsys_state *css,
+			struct cftype *cft)
+{
+	struct schedtune *st = css_st(css);
+
+	return st->sched_boost_level;
+}
+
+static int sched_boost_level_write(struct cgroup_subsys_state *css,
+			struct cftype *cft, u64 level)
+{
+	struct schedtune *st = css_st(css);
+
+	if (level > RESTRAINED_BOOST)
+		return -EINVAL;
+
+	/*
+	 * Readers are lockless; a placement racing with this update may pair
+	 * the new level with the old policy, which only affects that one
+	 * placement decision.
+	 */
+	WRITE_ONCE(st->sched_boost_level_policy,
+		   sched_boost_type_policy(level));
+	WRITE_ONCE(st->sched_boost_level, level);
+
+	return 0;
+}
+
 static u64 sched_colocate_read(struct cgroup_subsys_state *css,
 			struct cftype *cft)
 {
@@ -1053,6 +1121,11 @@ static struct cftype files[] = {
 		.read_u64 = sched_boost_enabled_read,
 		.write_u64 = sched_boost_enabled_write,
 	},
+	{
+		.name = "sched_boost_level",
+		.read_u64 = sched_boost_level_read,
+		.write_u64 = sched_boost_level_write,
+	},
 	{
 		.name = "colocate",
 		.read_u64 = sched_colocate_read,
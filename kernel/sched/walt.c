@@ -142,6 +142,16 @@ __read_mostly unsigned int sysctl_sched_cpu_high_irqload = (10 * NSEC_PER_MSEC);
 unsigned int sysctl_sched_walt_rotate_big_tasks;
 unsigned int walt_rotation_enabled;
 
+/*
+ * When set, the window rollover irq work rolls over and aggregates one
+ * runqueue at a time using the per-rq rollover snapshots instead of
+ * holding every runqueue lock in the system at once.
+ */
+unsigned int sysctl_sched_walt_percpu_rollover;
+
+/* Move unpinned timers off the big cores, see get_nohz_timer_target(). */
+unsigned int sysctl_sched_timer_consolidate;
+
 /*
  * sched_window_stats_policy and sched_ravg_hist_size have a 'sysctl' copy
  * associated with them. This is required for atomic update of those variables
@@ -1967,6 +1977,28 @@ update_task_rq_cpu_cycles(struct task_struct *p, struct rq *rq, int event,
 	trace_sched_get_task_cpu_cycles(cpu, event, rq->cc.cycles, rq->cc.time, p);
 }
 
+static inline void walt_publish_rollover(struct rq *rq)
+{
+	write_seqcount_begin(&rq->rollover_seqcnt);
+	rq->rollover_ws = rq->window_start;
+	rq->rollover_grp_prev_runnable_sum = rq->grp_time.prev_runnable_sum;
+	write_seqcount_end(&rq->rollover_seqcnt);
+}
+
+static inline u64 walt_read_rollover(struct rq *rq, u64 *ws)
+{
+	unsigned int seq;
+	u64 load;
+
+	do {
+		seq = read_seqcount_begin(&rq->rollover_seqcnt);
+		*ws = rq->rollover_ws;
+		load = rq->rollover_grp_prev_runnable_sum;
+	} while (read_seqcount_retry(&rq->rollover_seqcnt, seq));
+
+	return load;
+}
+
 static inline void run_walt_irq_work(u64 old_window_start, struct rq *rq)
 {
 	u64 result;
@@ -1974,6 +2006,8 @@ static inline void run_walt_irq_work(u64 old_window_start, struct rq *rq)
 	if (old_window_start == rq->window_start)
 		return;
 
+	walt_publish_rollover(rq);
+
 	result = atomic64_cmpxchg(&walt_irq_work_lastq_ws, old_window_start,
 				   rq->window_start);
 	if (result == old_window_start)
@@ -2569,7 +2603,15 @@ static void transfer_busy_time(struct rq *rq, struct related_thread_group *grp,
 /* Maximum allowed threshold before freq aggregation must be enabled */
 #define MAX_FREQ_AGGR_THRESH 1000
 
-struct related_thread_group *related_thread_groups[MAX_NUM_CGROUP_COLOC_ID];
+/*
+ * Groups above the userspace visible id range are reserved for colocation
+ * groups formed automatically from repeated wakeup pairs.
+ */
+#define AUTO_COLOC_ID_FIRST	MAX_NUM_CGROUP_COLOC_ID
+#define NR_AUTO_COLOC_GROUPS	4
+#define NR_RELATED_THREAD_GROUPS (AUTO_COLOC_ID_FIRST + NR_AUTO_COLOC_GROUPS)
+
+struct related_thread_group *related_thread_groups[NR_RELATED_THREAD_GROUPS];
 static LIST_HEAD(active_related_thread_groups);
 DEFINE_RWLOCK(related_thread_group_lock);
 
@@ -2766,7 +2808,7 @@ int alloc_related_thread_groups(void)
 	struct related_thread_group *grp;
 
 	/* groupd_id = 0 is invalid as it's special id to remove group. */
-	for (i = 1; i < MAX_NUM_CGROUP_COLOC_ID; i++) {
+	for (i = 1; i < NR_RELATED_THREAD_GROUPS; i++) {
 		grp = kzalloc(sizeof(*grp), GFP_NOWAIT);
 		if (!grp) {
 			ret = -ENOMEM;
@@ -2784,7 +2826,7 @@ int alloc_related_thread_groups(void)
 	return 0;
 
 err:
-	for (i = 1; i < MAX_NUM_CGROUP_COLOC_ID; i++) {
+	for (i = 1; i < NR_RELATED_THREAD_GROUPS; i++) {
 		grp = lookup_related_thread_group(i);
 		if (grp) {
 			kfree(grp);
@@ -2896,7 +2938,7 @@ static int __sched_set_group_id(struct task_struct *p, unsigned int group_id)
 	unsigned long flags;
 	struct related_thread_group *grp = NULL;
 
-	if (group_id >= MAX_NUM_CGROUP_COLOC_ID)
+	if (group_id >= NR_RELATED_THREAD_GROUPS)
 		return -EINVAL;
 
 	raw_spin_lock_irqsave(&p->pi_lock, flags);
@@ -2925,12 +2967,30 @@ static int __sched_set_group_id(struct task_struct *p, unsigned int group_id)
 	return rc;
 }
 
+static inline bool is_auto_coloc_group(struct related_thread_group *grp)
+{
+	return grp->id >= AUTO_COLOC_ID_FIRST;
+}
+
 int sched_set_group_id(struct task_struct *p, unsigned int group_id)
 {
-	/* DEFAULT_CGROUP_COLOC_ID is a reserved id */
-	if (group_id == DEFAULT_CGROUP_COLOC_ID)
+	struct related_thread_group *grp;
+	bool auto_grp;
+
+	/* DEFAULT_CGROUP_COLOC_ID and automatic groups are reserved ids */
+	if (group_id == DEFAULT_CGROUP_COLOC_ID ||
+			group_id >= MAX_NUM_CGROUP_COLOC_ID)
 		return -EINVAL;
 
+	/* An explicit group id always overrides an automatic one */
+	rcu_read_lock();
+	grp = task_related_thread_group(p);
+	auto_grp = grp && is_auto_coloc_group(grp);
+	rcu_read_unlock();
+
+	if (auto_grp && group_id)
+		__sched_set_group_id(p, 0);
+
 	return __sched_set_group_id(p, group_id);
 }
 
@@ -2983,6 +3043,248 @@ int sync_cgroup_colocation(struct task_struct *p, bool insert)
 }
 #endif
 
+/*
+ * Automatic colocation of tasks that keep waking each other up.
+ *
+ * Producer/consumer pairs such as the UI and render threads of an app or an
+ * audio HAL and AudioFlinger wake each other up every frame or buffer. When
+ * a task wakes the same wakee sysctl_sched_auto_coloc_wakeups times in a row,
+ * with no more than a window between wakeups, both are placed in one of the
+ * reserved automatic groups so that their combined demand drives colocation
+ * and the cluster frequency. Tasks already in a userspace or cgroup group are
+ * left alone. An automatic group that has not seen a wakeup between its
+ * members for AUTO_COLOC_IDLE_NS is dissolved again.
+ *
+ * Group membership can't change from the wakeup path as it would need
+ * p->pi_lock of both tasks, so candidate pairs are handed over to a work
+ * item through a per-cpu slot.
+ */
+unsigned int __read_mostly sysctl_sched_auto_coloc_wakeups;
+
+#define AUTO_COLOC_IDLE_NS	(1000 * NSEC_PER_MSEC)
+#define AUTO_COLOC_EXPIRE_MS	500
+
+struct auto_coloc_pair {
+	raw_spinlock_t lock;
+	struct task_struct *waker;
+	struct task_struct *wakee;
+};
+
+static DEFINE_PER_CPU(struct auto_coloc_pair, auto_coloc_pairs);
+static struct irq_work auto_coloc_irq_work;
+static struct work_struct auto_coloc_work;
+static struct delayed_work auto_coloc_expire_work;
+
+static void auto_coloc_queue_pair(struct task_struct *waker,
+				  struct task_struct *wakee)
+{
+	struct auto_coloc_pair *pair = this_cpu_ptr(&auto_coloc_pairs);
+	bool queued = false;
+
+	raw_spin_lock(&pair->lock);
+	if (!pair->waker) {
+		get_task_struct(waker);
+		get_task_struct(wakee);
+		pair->waker = waker;
+		pair->wakee = wakee;
+		queued = true;
+	}
+	raw_spin_unlock(&pair->lock);
+
+	if (queued)
+		irq_work_queue(&auto_coloc_irq_work);
+}
+
+/*
+ * Called from try_to_wake_up() with p->pi_lock held and inside an RCU read
+ * side section.
+ */
+void walt_note_wakeup_pair(struct task_struct *waker,
+			   struct task_struct *wakee, u64 wallclock)
+{
+	struct related_thread_group *waker_grp, *wakee_grp;
+
+	if (!sysctl_sched_auto_coloc_wakeups || in_interrupt() ||
+			waker == wakee ||
+			(waker->flags | wakee->flags) & (PF_KTHREAD | PF_EXITING))
+		return;
+
+	waker_grp = task_related_thread_group(waker);
+	wakee_grp = task_related_thread_group(wakee);
+
+	if (waker_grp && waker_grp == wakee_grp) {
+		if (is_auto_coloc_group(waker_grp))
+			WRITE_ONCE(waker_grp->last_auto_wakeup, wallclock);
+		return;
+	}
+
+	/* At most one of the two may be grouped, and only automatically */
+	if ((waker_grp && wakee_grp) ||
+			(waker_grp && !is_auto_coloc_group(waker_grp)) ||
+			(wakee_grp && !is_auto_coloc_group(wakee_grp)))
+		return;
+
+	/* The wakee pointer is only compared, never dereferenced */
+	if (waker->coloc_wakee != wakee ||
+			wallclock - waker->coloc_wakee_ts > sched_ravg_window) {
+		waker->coloc_wakee = wakee;
+		waker->coloc_wakee_count = 0;
+	}
+	waker->coloc_wakee_ts = wallclock;
+
+	if (++waker->coloc_wakee_count < sysctl_sched_auto_coloc_wakeups)
+		return;
+
+	waker->coloc_wakee_count = 0;
+	auto_coloc_queue_pair(waker, wakee);
+}
+
+static struct related_thread_group *auto_coloc_get_free_group(void)
+{
+	struct related_thread_group *grp;
+	int i;
+
+	for (i = AUTO_COLOC_ID_FIRST; i < NR_RELATED_THREAD_GROUPS; i++) {
+		grp = lookup_related_thread_group(i);
+		if (list_empty(&grp->list))
+			return grp;
+	}
+
+	return NULL;
+}
+
+static void auto_coloc_pair(struct task_struct *waker,
+			    struct task_struct *wakee)
+{
+	struct related_thread_group *waker_grp, *wakee_grp, *grp;
+
+	rcu_read_lock();
+	waker_grp = task_related_thread_group(waker);
+	wakee_grp = task_related_thread_group(wakee);
+	rcu_read_unlock();
+
+	/* Membership may have changed since the pair was queued */
+	if (waker_grp && wakee_grp)
+		return;
+
+	grp = waker_grp ? : wakee_grp;
+	if (grp && !is_auto_coloc_group(grp))
+		return;
+
+	if (!grp) {
+		grp = auto_coloc_get_free_group();
+		if (!grp)
+			return;
+
+		WRITE_ONCE(grp->last_auto_wakeup, sched_ktime_clock());
+	}
+
+	if (!waker_grp && __sched_set_group_id(waker, grp->id))
+		return;
+	if (!wakee_grp)
+		__sched_set_group_id(wakee, grp->id);
+
+	mod_delayed_work(system_power_efficient_wq, &auto_coloc_expire_work,
+			 msecs_to_jiffies(AUTO_COLOC_EXPIRE_MS));
+}
+
+static void auto_coloc_work_fn(struct work_struct *work)
+{
+	struct auto_coloc_pair *pair;
+	struct task_struct *waker, *wakee;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		pair = &per_cpu(auto_coloc_pairs, cpu);
+
+		raw_spin_lock_irq(&pair->lock);
+		waker = pair->waker;
+		wakee = pair->wakee;
+		pair->waker = pair->wakee = NULL;
+		raw_spin_unlock_irq(&pair->lock);
+
+		if (!waker)
+			continue;
+
+		auto_coloc_pair(waker, wakee);
+		put_task_struct(waker);
+		put_task_struct(wakee);
+	}
+}
+
+static void auto_coloc_irq_work_fn(struct irq_work *irq_work)
+{
+	schedule_work(&auto_coloc_work);
+}
+
+static void auto_coloc_dissolve(struct related_thread_group *grp)
+{
+	struct task_struct *p;
+	unsigned long flags;
+	bool done;
+
+	for (;;) {
+		read_lock_irqsave(&related_thread_group_lock, flags);
+		raw_spin_lock(&grp->lock);
+		p = list_first_entry_or_null(&grp->tasks, struct task_struct,
+					     grp_list);
+		if (p)
+			get_task_struct(p);
+		raw_spin_unlock(&grp->lock);
+		read_unlock_irqrestore(&related_thread_group_lock, flags);
+
+		if (!p)
+			break;
+
+		__sched_set_group_id(p, 0);
+
+		/* Exiting tasks are left for sched_exit() to remove */
+		done = rcu_access_pointer(p->grp) == grp;
+		put_task_struct(p);
+		if (done)
+			break;
+	}
+}
+
+static void auto_coloc_expire_fn(struct work_struct *work)
+{
+	struct related_thread_group *grp;
+	u64 now = sched_ktime_clock();
+	bool active = false;
+	int i;
+
+	for (i = AUTO_COLOC_ID_FIRST; i < NR_RELATED_THREAD_GROUPS; i++) {
+		grp = lookup_related_thread_group(i);
+		if (list_empty(&grp->list))
+			continue;
+
+		if (now - READ_ONCE(grp->last_auto_wakeup) > AUTO_COLOC_IDLE_NS)
+			auto_coloc_dissolve(grp);
+		else
+			active = true;
+	}
+
+	if (active)
+		queue_delayed_work(system_power_efficient_wq,
+				   &auto_coloc_expire_work,
+				   msecs_to_jiffies(AUTO_COLOC_EXPIRE_MS));
+}
+
+static int __init auto_coloc_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		raw_spin_lock_init(&per_cpu(auto_coloc_pairs, cpu).lock);
+
+	init_irq_work(&auto_coloc_irq_work, auto_coloc_irq_work_fn);
+	INIT_WORK(&auto_coloc_work, auto_coloc_work_fn);
+	INIT_DELAYED_WORK(&auto_coloc_expire_work, auto_coloc_expire_fn);
+
+	return 0;
+}
+early_initcall(auto_coloc_init);
+
 void update_cpu_cluster_capacity(const cpumask_t *cpus)
 {
 	int i;
@@ -3064,8 +3366,11 @@ void sched_update_cpu_freq_min_max(const cpumask_t *cpus, u32 fmin, u32 fmax)
 	}
 	spin_unlock_irqrestore(&cpu_freq_min_max_lock, flags);
 
-	if (update_capacity)
+	if (update_capacity) {
 		update_cpu_cluster_capacity(cpus);
+		for_each_cpu(i, cpus)
+			refresh_cpu_capacity_orig(i);
+	}
 }
 
 void note_task_waking(struct task_struct *p, u64 wallclock)
@@ -3247,6 +3552,67 @@ int sched_little_cluster_coloc_fmin_khz_handler(struct ctl_table *table,
 	return ret;
 }
 
+/*
+ * Window rollover variant of walt_irq_work() which never holds more than
+ * one runqueue lock at a time. Each CPU is rolled over under its own lock
+ * and publishes its group load in the rollover snapshot; the per-cluster
+ * aggregation then only reads the snapshots.
+ */
+static void walt_irq_work_percpu(void)
+{
+	struct sched_cluster *cluster;
+	struct rq *rq;
+	int cpu;
+	u64 wc, ws, total_grp_load = 0;
+
+	wc = sched_ktime_clock();
+	walt_load_reported_window = atomic64_read(&walt_irq_work_lastq_ws);
+
+	for_each_sched_cluster(cluster) {
+		u64 aggr_grp_load = 0;
+
+		for_each_cpu(cpu, &cluster->cpus) {
+			rq = cpu_rq(cpu);
+
+			raw_spin_lock(&rq->lock);
+			if (rq->curr) {
+				update_task_ravg(rq->curr, rq,
+						TASK_UPDATE, wc, 0);
+				account_load_subtractions(rq);
+			}
+			walt_publish_rollover(rq);
+			raw_spin_unlock(&rq->lock);
+		}
+
+		for_each_cpu(cpu, &cluster->cpus) {
+			u64 load = walt_read_rollover(cpu_rq(cpu), &ws);
+
+			/* Skip CPUs that have not rolled over yet */
+			if (ws >= walt_load_reported_window)
+				aggr_grp_load += load;
+		}
+
+		raw_spin_lock(&cluster->load_lock);
+		cluster->aggr_grp_load = aggr_grp_load;
+		total_grp_load = aggr_grp_load;
+		cluster->coloc_boost_load = 0;
+		raw_spin_unlock(&cluster->load_lock);
+	}
+
+	if (total_grp_load)
+		walt_update_coloc_boost_load();
+
+	for_each_cpu(cpu, cpu_possible_mask) {
+		rq = cpu_rq(cpu);
+
+		raw_spin_lock(&rq->lock);
+		cpufreq_update_util(rq, SCHED_CPUFREQ_WALT);
+		raw_spin_unlock(&rq->lock);
+	}
+
+	core_ctl_check(this_rq()->window_start);
+}
+
 /*
  * Runs in hard-irq context. This should ideally run just after the latest
  * window roll-over.
@@ -3265,6 +3631,16 @@ void walt_irq_work(struct irq_work *irq_work)
 	if (irq_work == &walt_migration_irq_work)
 		is_migration = true;
 
+	/*
+	 * Migration fixups need a consistent view of both the source and
+	 * destination clusters, so only the rollover work may take the
+	 * per-CPU path.
+	 */
+	if (!is_migration && sysctl_sched_walt_percpu_rollover) {
+		walt_irq_work_percpu();
+		return;
+	}
+
 	for_each_cpu(cpu, cpu_possible_mask) {
 		if (level == 0)
 			raw_spin_lock(&cpu_rq(cpu)->lock);
@@ -3422,6 +3798,9 @@ void walt_sched_init(struct rq *rq)
 	}
 	rq->cum_window_demand = 0;
 	rq->notif_pending = false;
+	seqcount_init(&rq->rollover_seqcnt);
+	rq->rollover_ws = 0;
+	rq->rollover_grp_prev_runnable_sum = 0;
 
 	walt_cpu_util_freq_divisor =
 	    (sched_ravg_window >> SCHED_CAPACITY_SHIFT) * 100;
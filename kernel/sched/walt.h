@@ -302,12 +302,16 @@ static inline void walt_update_last_enqueue(struct task_struct *p)
 extern void walt_rotate_work_init(void);
 extern void walt_rotation_checkpoint(int nr_big);
 extern unsigned int walt_rotation_enabled;
+extern void walt_note_wakeup_pair(struct task_struct *waker,
+				  struct task_struct *wakee, u64 wallclock);
 
 #else /* CONFIG_SCHED_WALT */
 
 static inline void walt_sched_init(struct rq *rq) { }
 static inline void walt_rotate_work_init(void) { }
 static inline void walt_rotation_checkpoint(int nr_big) { }
+static inline void walt_note_wakeup_pair(struct task_struct *waker,
+				struct task_struct *wakee, u64 wallclock) { }
 static inline void walt_update_last_enqueue(struct task_struct *p) { }
 static inline void walt_fixup_cumulative_runnable_avg(struct rq *rq,
 						      struct task_struct *p,
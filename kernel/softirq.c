@@ -26,6 +26,7 @@
 #include <linux/smpboot.h>
 #include <linux/tick.h>
 #include <linux/irq.h>
+#include <linux/moduleparam.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/irq.h>
@@ -234,6 +235,19 @@ static inline bool lockdep_softirq_start(void) { return false; }
 static inline void lockdep_softirq_end(bool in_hardirq) { }
 #endif
 
+/*
+ * Per vector time budget in microseconds, 0 to disable. A long softirq
+ * vector that runs past it on top of an RT or negative nice task is not
+ * restarted from that task's context but left to ksoftirqd.
+ */
+static unsigned int softirq_budget_us;
+module_param(softirq_budget_us, uint, 0644);
+
+static inline bool softirq_protect_current(void)
+{
+	return rt_task(current) || task_nice(current) < 0;
+}
+
 #define softirq_deferred_for_rt(pending)		\
 ({							\
 	__u32 deferred = 0;				\
@@ -253,6 +267,8 @@ asmlinkage __visible void __softirq_entry __do_softirq(void)
 	bool in_hardirq;
 	__u32 deferred;
 	__u32 pending;
+	__u32 over_budget = 0;
+	u64 budget_ns = (u64)READ_ONCE(softirq_budget_us) * NSEC_PER_USEC;
 	int softirq_bit;
 
 	/*
@@ -280,6 +296,7 @@ asmlinkage __visible void __softirq_entry __do_softirq(void)
 	while ((softirq_bit = ffs(pending))) {
 		unsigned int vec_nr;
 		int prev_count;
+		u64 start, delta;
 
 		h += softirq_bit - 1;
 
@@ -289,8 +306,13 @@ asmlinkage __visible void __softirq_entry __do_softirq(void)
 		kstat_incr_softirqs_this_cpu(vec_nr);
 
 		trace_softirq_entry(vec_nr);
+		start = sched_clock();
 		h->action(h);
+		delta = sched_clock() - start;
 		trace_softirq_exit(vec_nr);
+		kstat_add_softirq_time_this_cpu(vec_nr, delta);
+		if (budget_ns && delta > budget_ns)
+			over_budget |= BIT(vec_nr) & LONG_SOFTIRQ_MASK;
 		if (unlikely(prev_count != preempt_count())) {
 			pr_err("huh, entered softirq %u %s %p with preempt_count %08x, exited with %08x?\n",
 			       vec_nr, softirq_to_name[vec_nr], h->action,
@@ -308,6 +330,11 @@ asmlinkage __visible void __softirq_entry __do_softirq(void)
 	pending = local_softirq_pending();
 	deferred = softirq_deferred_for_rt(pending);
 
+	if ((pending & over_budget) && softirq_protect_current()) {
+		deferred |= pending & over_budget;
+		pending &= ~over_budget;
+	}
+
 	if (pending) {
 		if (time_before(jiffies, end) && !need_resched() &&
 		    --max_restart)
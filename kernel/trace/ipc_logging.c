@@ -297,8 +297,16 @@ void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 
 	if (ilctxt->disabled)
 		return;
-	read_lock_irqsave(&context_list_lock_lha1, flags);
-	spin_lock(&ilctxt->context_lock_lhb1);
+	/*
+	 * The context is refcounted and only its own lock is needed here;
+	 * taking the global context list lock on every message made all
+	 * writers on all CPUs bounce the same cache line.
+	 */
+	spin_lock_irqsave(&ilctxt->context_lock_lhb1, flags);
+	if (ilctxt->destroyed) {
+		spin_unlock_irqrestore(&ilctxt->context_lock_lhb1, flags);
+		return;
+	}
 	while (ilctxt->write_avail <= ectxt->offset)
 		msg_drop(ilctxt);
 
@@ -317,8 +325,8 @@ void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 
 		ilctxt->write_page = get_next_page(ilctxt, ilctxt->write_page);
 		if (WARN_ON(ilctxt->write_page == NULL)) {
-			spin_unlock(&ilctxt->context_lock_lhb1);
-			read_unlock_irqrestore(&context_list_lock_lha1, flags);
+			spin_unlock_irqrestore(&ilctxt->context_lock_lhb1,
+					       flags);
 			return;
 		}
 		ilctxt->write_page->hdr.write_offset = 0;
@@ -331,9 +339,10 @@ void ipc_log_write(void *ctxt, struct encode_context *ectxt)
 	}
 	ilctxt->write_page->hdr.write_offset += bytes_to_write;
 	ilctxt->write_avail -= ectxt->offset;
-	complete(&ilctxt->read_avail);
-	spin_unlock(&ilctxt->context_lock_lhb1);
-	read_unlock_irqrestore(&context_list_lock_lha1, flags);
+	/* Readers only block once they drained the log and reinit it */
+	if (!completion_done(&ilctxt->read_avail))
+		complete(&ilctxt->read_avail);
+	spin_unlock_irqrestore(&ilctxt->context_lock_lhb1, flags);
 }
 EXPORT_SYMBOL(ipc_log_write);
 
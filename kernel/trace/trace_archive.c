@@ -0,0 +1,258 @@
+/*
+ * trace_archive.c - compressed overflow tier for the top level ring buffer
+ *
+ * When enabled through tracing/trace_archive/size_kb, a periodic worker
+ * watches how full each CPU's ring buffer is. Once it is three quarters
+ * full, complete pages are pulled out of it, LZO compressed and kept in a
+ * per CPU archive, oldest pages being dropped once the archive exceeds its
+ * share of size_kb. The events thus survive well past the point where the
+ * ring buffer would have overwritten them, for a fraction of the memory.
+ *
+ * tracing/trace_archive/cpuN returns the archived pages of that CPU,
+ * decompressed, oldest first and in the same binary page format as
+ * per_cpu/cpuN/trace_pipe_raw, so the usual tools can parse them. Newer
+ * events are still in the live ring buffer.
+ */
+#include <linux/lzo.h>
+#include <linux/slab.h>
+#include <linux/tracefs.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+
+#include "trace.h"
+
+#define ARCHIVE_INTERVAL	(HZ / 2)
+
+struct archive_chunk {
+	struct list_head	list;
+	size_t			len;
+	unsigned char		data[];
+};
+
+struct archive_cpu {
+	struct list_head	chunks;
+	size_t			bytes;
+};
+
+static DEFINE_MUTEX(archive_lock);
+static struct archive_cpu archive_cpus[NR_CPUS];
+static unsigned long archive_size_kb;
+static void *archive_wrkmem;
+static unsigned char *archive_cbuf;
+
+static void archive_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(archive_work, archive_work_fn);
+
+static void archive_trim(struct archive_cpu *ac, size_t limit)
+{
+	struct archive_chunk *chunk;
+
+	while (ac->bytes > limit && !list_empty(&ac->chunks)) {
+		chunk = list_first_entry(&ac->chunks, struct archive_chunk,
+					 list);
+		list_del(&chunk->list);
+		ac->bytes -= chunk->len;
+		kfree(chunk);
+	}
+}
+
+static void archive_store(struct archive_cpu *ac, void *page, size_t limit)
+{
+	struct archive_chunk *chunk;
+	size_t len;
+
+	if (lzo1x_1_compress(page, PAGE_SIZE, archive_cbuf, &len,
+			     archive_wrkmem) != LZO_E_OK)
+		return;
+
+	chunk = kmalloc(sizeof(*chunk) + len, GFP_KERNEL);
+	if (!chunk)
+		return;
+
+	chunk->len = len;
+	memcpy(chunk->data, archive_cbuf, len);
+	list_add_tail(&chunk->list, &ac->chunks);
+	ac->bytes += len;
+	archive_trim(ac, limit);
+}
+
+static void archive_cpu_buffer(struct ring_buffer *buffer, int cpu,
+			       size_t limit)
+{
+	unsigned long size = ring_buffer_size(buffer, cpu);
+	void *page;
+
+	if (ring_buffer_bytes_cpu(buffer, cpu) < size / 4 * 3)
+		return;
+
+	page = ring_buffer_alloc_read_page(buffer, cpu);
+	if (!page)
+		return;
+
+	/* Drain down to half full, complete pages only */
+	while (ring_buffer_bytes_cpu(buffer, cpu) > size / 2) {
+		if (ring_buffer_read_page(buffer, &page, PAGE_SIZE, cpu, 1) < 0)
+			break;
+		archive_store(&archive_cpus[cpu], page, limit);
+	}
+
+	ring_buffer_free_read_page(buffer, page);
+}
+
+static void archive_work_fn(struct work_struct *work)
+{
+	struct trace_array *tr = top_trace_array();
+	struct ring_buffer *buffer;
+	size_t limit;
+	int cpu;
+
+	mutex_lock(&archive_lock);
+	if (!archive_size_kb || !tr) {
+		mutex_unlock(&archive_lock);
+		return;
+	}
+
+	limit = (archive_size_kb << 10) / num_possible_cpus();
+	buffer = tr->trace_buffer.buffer;
+	for_each_online_cpu(cpu)
+		archive_cpu_buffer(buffer, cpu, limit);
+	mutex_unlock(&archive_lock);
+
+	schedule_delayed_work(&archive_work, ARCHIVE_INTERVAL);
+}
+
+static ssize_t
+archive_cpu_read(struct file *filp, char __user *ubuf, size_t cnt,
+		 loff_t *ppos)
+{
+	struct archive_cpu *ac = &archive_cpus[(long)filp->private_data];
+	struct archive_chunk *chunk;
+	loff_t idx = *ppos >> PAGE_SHIFT;
+	size_t offs = *ppos & ~PAGE_MASK;
+	size_t len = PAGE_SIZE;
+	void *page;
+	ssize_t ret = 0;
+
+	page = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	if (!page)
+		return -ENOMEM;
+
+	mutex_lock(&archive_lock);
+	list_for_each_entry(chunk, &ac->chunks, list) {
+		if (idx--)
+			continue;
+
+		if (lzo1x_decompress_safe(chunk->data, chunk->len, page,
+					  &len) != LZO_E_OK) {
+			ret = -EIO;
+			break;
+		}
+
+		cnt = min(cnt, PAGE_SIZE - offs);
+		if (copy_to_user(ubuf, page + offs, cnt)) {
+			ret = -EFAULT;
+			break;
+		}
+
+		*ppos += cnt;
+		ret = cnt;
+		break;
+	}
+	mutex_unlock(&archive_lock);
+
+	kfree(page);
+	return ret;
+}
+
+static const struct file_operations archive_cpu_fops = {
+	.open		= tracing_open_generic,
+	.read		= archive_cpu_read,
+	.llseek		= generic_file_llseek,
+};
+
+static ssize_t
+archive_size_read(struct file *filp, char __user *ubuf, size_t cnt,
+		  loff_t *ppos)
+{
+	char buf[32];
+	int r;
+
+	r = snprintf(buf, sizeof(buf), "%lu\n", archive_size_kb);
+	return simple_read_from_buffer(ubuf, cnt, ppos, buf, r);
+}
+
+static ssize_t
+archive_size_write(struct file *filp, const char __user *ubuf, size_t cnt,
+		   loff_t *ppos)
+{
+	unsigned long val;
+	int cpu, ret;
+
+	ret = kstrtoul_from_user(ubuf, cnt, 10, &val);
+	if (ret)
+		return ret;
+
+	mutex_lock(&archive_lock);
+	if (val && !archive_wrkmem) {
+		archive_wrkmem = vmalloc(LZO1X_1_MEM_COMPRESS);
+		archive_cbuf = vmalloc(lzo1x_worst_compress(PAGE_SIZE));
+		if (!archive_wrkmem || !archive_cbuf) {
+			vfree(archive_wrkmem);
+			vfree(archive_cbuf);
+			archive_wrkmem = NULL;
+			archive_cbuf = NULL;
+			mutex_unlock(&archive_lock);
+			return -ENOMEM;
+		}
+	}
+
+	for_each_possible_cpu(cpu)
+		archive_trim(&archive_cpus[cpu],
+			     (val << 10) / num_possible_cpus());
+
+	if (val && !archive_size_kb)
+		schedule_delayed_work(&archive_work, ARCHIVE_INTERVAL);
+	archive_size_kb = val;
+	mutex_unlock(&archive_lock);
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static const struct file_operations archive_size_fops = {
+	.open		= tracing_open_generic,
+	.read		= archive_size_read,
+	.write		= archive_size_write,
+	.llseek		= generic_file_llseek,
+};
+
+static __init int trace_archive_init(void)
+{
+	struct dentry *d_tracer, *dir;
+	char name[16];
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		INIT_LIST_HEAD(&archive_cpus[cpu].chunks);
+
+	d_tracer = tracing_init_dentry();
+	if (IS_ERR(d_tracer))
+		return 0;
+
+	dir = tracefs_create_dir("trace_archive", d_tracer);
+	if (!dir) {
+		pr_warn("Could not create tracefs 'trace_archive' directory\n");
+		return 0;
+	}
+
+	trace_create_file("size_kb", 0644, dir, NULL, &archive_size_fops);
+	for_each_possible_cpu(cpu) {
+		snprintf(name, sizeof(name), "cpu%d", cpu);
+		trace_create_file(name, 0444, dir, (void *)(long)cpu,
+				  &archive_cpu_fops);
+	}
+
+	return 0;
+}
+fs_initcall(trace_archive_init);
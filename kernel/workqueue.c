@@ -52,6 +52,9 @@
 #include <linux/delay.h>
 #include <linux/nmi.h>
 #include <linux/kvm_para.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/log2.h>
 
 #include "workqueue_internal.h"
 
@@ -240,6 +243,8 @@ struct wq_device;
  * The externally visible workqueue.  It relays the issued work items to
  * the appropriate worker_pool through its pool_workqueues.
  */
+#define WQ_LAT_BUCKETS		16
+
 struct workqueue_struct {
 	struct list_head	pwqs;		/* WR: all pwqs of this wq */
 	struct list_head	list;		/* PR: list of all workqueues */
@@ -269,6 +274,12 @@ struct workqueue_struct {
 #endif
 	char			name[WQ_NAME_LEN]; /* I: workqueue name */
 
+#ifdef CONFIG_WQ_LATENCY_STATS
+	/* queue-to-execution latency, bucket i counts [2^i, 2^(i+1)) usecs */
+	atomic_long_t		lat_hist[WQ_LAT_BUCKETS];
+	atomic64_t		lat_max_ns;
+#endif
+
 	/*
 	 * Destruction of workqueue_struct is sched-RCU protected to allow
 	 * walking the workqueues list without grabbing wq_pool_mutex.
@@ -1330,6 +1341,9 @@ static void insert_work(struct pool_workqueue *pwq, struct work_struct *work,
 	set_work_pwq(work, pwq, extra_flags);
 	list_add_tail(&work->entry, head);
 	get_pwq(pwq);
+#ifdef CONFIG_WQ_LATENCY_STATS
+	work->queue_ns = sched_clock();
+#endif
 
 	/*
 	 * Ensure either wq_worker_sleeping() sees the above
@@ -2041,6 +2055,29 @@ static bool manage_workers(struct worker *worker)
  * CONTEXT:
  * spin_lock_irq(pool->lock) which is released and regrabbed.
  */
+#ifdef CONFIG_WQ_LATENCY_STATS
+static void wq_account_latency(struct workqueue_struct *wq,
+			       struct work_struct *work)
+{
+	u64 delta = sched_clock() - work->queue_ns;
+	u64 max = atomic64_read(&wq->lat_max_ns);
+	unsigned long us = div_u64(delta, NSEC_PER_USEC);
+	int bucket = us ? min_t(int, ilog2(us), WQ_LAT_BUCKETS - 1) : 0;
+
+	atomic_long_inc(&wq->lat_hist[bucket]);
+	while (delta > max) {
+		u64 old = atomic64_cmpxchg(&wq->lat_max_ns, max, delta);
+
+		if (old == max)
+			break;
+		max = old;
+	}
+}
+#else
+static inline void wq_account_latency(struct workqueue_struct *wq,
+				      struct work_struct *work) { }
+#endif
+
 static void process_one_work(struct worker *worker, struct work_struct *work)
 __releases(&pool->lock)
 __acquires(&pool->lock)
@@ -2085,6 +2122,7 @@ __acquires(&pool->lock)
 	worker->current_func = work->func;
 	worker->current_pwq = pwq;
 	work_color = get_work_color(work);
+	wq_account_latency(pwq->wq, work);
 
 	list_del_init(&work->entry);
 
@@ -5396,6 +5434,55 @@ static void workqueue_sysfs_unregister(struct workqueue_struct *wq)
 static void workqueue_sysfs_unregister(struct workqueue_struct *wq)	{ }
 #endif	/* CONFIG_SYSFS */
 
+#ifdef CONFIG_WQ_LATENCY_STATS
+/*
+ * One line per workqueue which ran work: the name, the worst latency
+ * seen in usecs, then the counts of the log2 usec histogram buckets.
+ */
+static int wq_latency_show(struct seq_file *m, void *v)
+{
+	struct workqueue_struct *wq;
+	int i;
+
+	rcu_read_lock_sched();
+	list_for_each_entry_rcu(wq, &workqueues, list) {
+		u64 max = atomic64_read(&wq->lat_max_ns);
+
+		if (!max)
+			continue;
+
+		seq_printf(m, "%-24s %10llu", wq->name,
+			   div_u64(max, NSEC_PER_USEC));
+		for (i = 0; i < WQ_LAT_BUCKETS; i++)
+			seq_printf(m, " %lu", atomic_long_read(&wq->lat_hist[i]));
+		seq_putc(m, '\n');
+	}
+	rcu_read_unlock_sched();
+
+	return 0;
+}
+
+static int wq_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wq_latency_show, NULL);
+}
+
+static const struct file_operations wq_latency_fops = {
+	.open		= wq_latency_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init wq_latency_init(void)
+{
+	debugfs_create_file("workqueue_latency", 0444, NULL, NULL,
+			    &wq_latency_fops);
+	return 0;
+}
+late_initcall(wq_latency_init);
+#endif	/* CONFIG_WQ_LATENCY_STATS */
+
 /*
  * Workqueue watchdog.
  *
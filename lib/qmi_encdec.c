@@ -282,12 +282,10 @@ EXPORT_SYMBOL(qmi_kernel_encode);
 static int qmi_encode_basic_elem(void *buf_dst, void *buf_src,
 				 uint32_t elem_len, uint32_t elem_size)
 {
-	uint32_t i, rc = 0;
+	uint32_t rc = elem_len * elem_size;
 
-	for (i = 0; i < elem_len; i++) {
-		QMI_ENCDEC_ENCODE_N_BYTES(buf_dst, buf_src, elem_size);
-		rc += elem_size;
-	}
+	/* Wire format of a basic array matches its in-memory layout */
+	QMI_ENCDEC_ENCODE_N_BYTES(buf_dst, buf_src, rc);
 
 	return rc;
 }
@@ -613,12 +611,10 @@ EXPORT_SYMBOL(qmi_kernel_decode);
 static int qmi_decode_basic_elem(void *buf_dst, void *buf_src,
 				 uint32_t elem_len, uint32_t elem_size)
 {
-	uint32_t i, rc = 0;
+	uint32_t rc = elem_len * elem_size;
 
-	for (i = 0; i < elem_len; i++) {
-		QMI_ENCDEC_DECODE_N_BYTES(buf_dst, buf_src, elem_size);
-		rc += elem_size;
-	}
+	/* Wire format of a basic array matches its in-memory layout */
+	QMI_ENCDEC_DECODE_N_BYTES(buf_dst, buf_src, rc);
 
 	return rc;
 }
@@ -727,6 +723,7 @@ static int qmi_decode_string_elem(struct elem_info *ei_array, void *buf_dst,
 /**
  * find_ei() - Find element info corresponding to TLV Type
  * @ei_array: Struct info array of the message being decoded.
+ * @start: Element to start the search from.
  * @type: TLV Type of the element being searched.
  *
  * @return: Pointer to struct info, if found
@@ -734,18 +731,25 @@ static int qmi_decode_string_elem(struct elem_info *ei_array, void *buf_dst,
  * Every element that got encoded in the QMI message will have a type
  * information associated with it. While decoding the QMI message,
  * this function is used to find the struct info regarding the element
- * that corresponds to the type being decoded.
+ * that corresponds to the type being decoded. Senders normally encode
+ * TLVs in the order of the element info array, so the search starts
+ * right after the previously decoded element and wraps around.
  */
 static struct elem_info *find_ei(struct elem_info *ei_array,
-				   uint32_t type)
+				 struct elem_info *start, uint32_t type)
 {
-	struct elem_info *temp_ei = ei_array;
+	struct elem_info *temp_ei = start;
 
 	while (temp_ei->data_type != QMI_EOTI) {
 		if (temp_ei->tlv_type == (uint8_t)type)
 			return temp_ei;
 		temp_ei = temp_ei + 1;
 	}
+
+	for (temp_ei = ei_array; temp_ei != start; temp_ei++) {
+		if (temp_ei->tlv_type == (uint8_t)type)
+			return temp_ei;
+	}
 	return NULL;
 }
 
@@ -767,6 +771,7 @@ static int _qmi_kernel_decode(struct elem_info *ei_array,
 			      int dec_level)
 {
 	struct elem_info *temp_ei = ei_array;
+	struct elem_info *next_ei = ei_array;
 	uint8_t opt_flag_value = 1;
 	uint32_t data_len_value = 0, data_len_sz = 0;
 	uint8_t *buf_dst = out_c_struct;
@@ -789,7 +794,7 @@ static int _qmi_kernel_decode(struct elem_info *ei_array,
 			QMI_DECODE_LOG_TLV(tlv_type, tlv_len);
 			buf_src += (TLV_TYPE_SIZE + TLV_LEN_SIZE);
 			decoded_bytes += (TLV_TYPE_SIZE + TLV_LEN_SIZE);
-			temp_ei = find_ei(ei_array, tlv_type);
+			temp_ei = find_ei(ei_array, next_ei, tlv_type);
 			if (!temp_ei && (tlv_type < OPTIONAL_TLV_TYPE_START)) {
 				pr_err("%s: Inval element info\n", __func__);
 				return -EINVAL;
@@ -870,6 +875,7 @@ static int _qmi_kernel_decode(struct elem_info *ei_array,
 			return -EINVAL;
 		}
 		temp_ei = temp_ei + 1;
+		next_ei = temp_ei;
 	}
 	return decoded_bytes;
 }
@@ -172,6 +172,39 @@ static DEVICE_ATTR_RW(name);
 
 BDI_SHOW(read_ahead_kb, K(bdi->ra_pages))
 
+static ssize_t read_ahead_adaptive_store(struct device *dev,
+					 struct device_attribute *attr,
+					 const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	bool adaptive;
+	ssize_t ret;
+
+	ret = kstrtobool(buf, &adaptive);
+	if (ret < 0)
+		return ret;
+
+	bdi->ra_adaptive = adaptive;
+
+	return count;
+}
+BDI_SHOW(read_ahead_adaptive, bdi->ra_adaptive)
+
+static ssize_t read_ahead_stats_show(struct device *dev,
+				     struct device_attribute *attr,
+				     char *page)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+
+	return snprintf(page, PAGE_SIZE-1,
+			"hit_kb %lu\nmiss_kb %lu\ngrown %lu\nshrunk %lu\n",
+			K(atomic_long_read(&bdi->ra_hit_pages)),
+			K(atomic_long_read(&bdi->ra_miss_pages)),
+			atomic_long_read(&bdi->ra_grown),
+			atomic_long_read(&bdi->ra_shrunk));
+}
+static DEVICE_ATTR_RO(read_ahead_stats);
+
 static ssize_t min_ratio_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t count)
 {
@@ -223,6 +256,8 @@ static DEVICE_ATTR_RO(stable_pages_required);
 
 static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_read_ahead_kb.attr,
+	&dev_attr_read_ahead_adaptive.attr,
+	&dev_attr_read_ahead_stats.attr,
 	&dev_attr_min_ratio.attr,
 	&dev_attr_max_ratio.attr,
 	&dev_attr_stable_pages_required.attr,
@@ -832,6 +867,11 @@ int bdi_init(struct backing_dev_info *bdi)
 	bdi->min_ratio = 0;
 	bdi->max_ratio = 100;
 	bdi->max_prop_frac = FPROP_FRAC_BASE;
+	bdi->ra_adaptive = 1;
+	atomic_long_set(&bdi->ra_hit_pages, 0);
+	atomic_long_set(&bdi->ra_miss_pages, 0);
+	atomic_long_set(&bdi->ra_grown, 0);
+	atomic_long_set(&bdi->ra_shrunk, 0);
 	INIT_LIST_HEAD(&bdi->bdi_list);
 	INIT_LIST_HEAD(&bdi->wb_list);
 	init_waitqueue_head(&bdi->wb_waitq);
@@ -45,6 +45,10 @@ struct cma cma_areas[MAX_CMA_AREAS];
 unsigned cma_area_count;
 static DEFINE_MUTEX(cma_mutex);
 
+/* Bounds of the back-off while cma_alloc() waits for busy pages */
+#define CMA_BUSY_SLEEP_MIN_MS	10
+#define CMA_BUSY_SLEEP_MAX_MS	100
+
 phys_addr_t cma_get_base(const struct cma *cma)
 {
 	return PFN_PHYS(cma->base_pfn);
@@ -455,9 +459,10 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 	unsigned long start = 0;
 	unsigned long bitmap_maxno, bitmap_no, bitmap_count;
 	struct page *page = NULL;
-	int retry_after_sleep = 0;
+	unsigned int waited_ms = 0;
+	unsigned int sleep_ms = CMA_BUSY_SLEEP_MIN_MS;
+	unsigned int max_wait_ms = 2 * CMA_BUSY_SLEEP_MAX_MS;
 	int ret = -ENOMEM;
-	int max_retries = 2;
 	int available_regions = 0;
 
 	if (!cma || !cma->count)
@@ -485,27 +490,30 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 				bitmap_maxno, start, bitmap_count, mask,
 				offset);
 		if (bitmap_no >= bitmap_maxno) {
-			if ((retry_after_sleep < max_retries) &&
+			if ((waited_ms < max_wait_ms) &&
 						(ret == -EBUSY)) {
 				start = 0;
 				/*
-				 * update max retries if available free regions
+				 * update max wait if available free regions
 				 * are less.
 				 */
 				if (available_regions < 3)
-					max_retries = 5;
+					max_wait_ms = 5 * CMA_BUSY_SLEEP_MAX_MS;
 				available_regions = 0;
 				/*
 				 * Page may be momentarily pinned by some other
 				 * process which has been scheduled out, eg.
 				 * in exit path, during unmap call, or process
 				 * fork and so cannot be freed there. Sleep
-				 * for 100ms and retry twice to see if it has
-				 * been freed later.
+				 * and retry to see if it has been freed later,
+				 * starting with short sleeps as most such pins
+				 * go away quickly.
 				 */
 				mutex_unlock(&cma->lock);
-				msleep(100);
-				retry_after_sleep++;
+				sleep_ms = min(sleep_ms, max_wait_ms - waited_ms);
+				msleep(sleep_ms);
+				waited_ms += sleep_ms;
+				sleep_ms = min(2 * sleep_ms, CMA_BUSY_SLEEP_MAX_MS);
 				continue;
 			} else {
 				mutex_unlock(&cma->lock);
@@ -535,6 +543,8 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 		if (ret != -EBUSY)
 			break;
 
+		cma->busy_count++;
+
 		pr_debug("%s(): memory range at %p is busy, retrying\n",
 			 __func__, pfn_to_page(pfn));
 
@@ -544,6 +554,8 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 	}
 
 	trace_cma_alloc(pfn, page, count, align);
+	if (waited_ms)
+		cma->busy_wait_ms += waited_ms;
 
 	if (ret) {
 		pr_info("%s: alloc failed, req-size: %zu pages, ret: %d\n",
@@ -7,6 +7,8 @@ struct cma {
 	unsigned long   *bitmap;
 	unsigned int order_per_bit; /* Order of pages represented by one bit */
 	struct mutex    lock;
+	unsigned long	busy_count;	/* ranges found busy by cma_alloc() */
+	unsigned long	busy_wait_ms;	/* time slept waiting for them */
 #ifdef CONFIG_CMA_DEBUGFS
 	struct hlist_head mem_head;
 	spinlock_t mem_head_lock;
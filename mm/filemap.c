@@ -2238,6 +2238,7 @@ static struct file *do_sync_mmap_readahead(struct vm_area_struct *vma,
 	 * mmap read-around
 	 */
 	fpin = maybe_unlock_mmap_for_io(vma, flags, fpin);
+	ra_retire_window(mapping, ra);
 	ra->start = max_t(long, 0, offset - ra->ra_pages / 2);
 	ra->size = ra->ra_pages;
 	ra->async_size = ra->ra_pages / 4;
@@ -2297,6 +2298,13 @@ static struct file *do_async_mmap_readahead(struct vm_area_struct *vma,
  *
  * We never return with VM_FAULT_RETRY and a bit from VM_FAULT_ERROR set.
  */
+/*
+ * With this set, the reads that a major fault of the foreground app
+ * issues are flagged REQ_PRIO so that the I/O schedulers and the storage
+ * driver serve them ahead of background I/O.
+ */
+int sysctl_fault_io_boost __read_mostly;
+
 int filemap_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 {
 	int error;
@@ -2330,8 +2338,12 @@ int filemap_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 		count_vm_event(PGMAJFAULT);
 		mem_cgroup_count_vm_event(vma->vm_mm, PGMAJFAULT);
 		ret = VM_FAULT_MAJOR;
+		if (READ_ONCE(sysctl_fault_io_boost) &&
+		    current_cpuset_is_top_app())
+			current->in_fault_io_boost = 1;
 		fpin = do_sync_mmap_readahead(vma, vmf->flags, ra,
 						file, offset);
+		current->in_fault_io_boost = 0;
 retry_find:
 		page = pagecache_get_page(mapping, offset,
 					  FGP_CREAT|FGP_FOR_MMAP,
@@ -77,6 +77,9 @@ extern int __do_page_cache_readahead(struct address_space *mapping,
 		struct file *filp, pgoff_t offset, unsigned long nr_to_read,
 		unsigned long lookahead_size);
 
+extern void ra_retire_window(struct address_space *mapping,
+		struct file_ra_state *ra);
+
 /*
  * Submit IO for the read-ahead request in file_ra_state.
  */
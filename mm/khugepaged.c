@@ -70,6 +70,8 @@ static DECLARE_WAIT_QUEUE_HEAD(khugepaged_wait);
  */
 static unsigned int khugepaged_max_ptes_none __read_mostly;
 static unsigned int khugepaged_max_ptes_swap __read_mostly;
+/* run khugepaged as SCHED_IDLE so collapsing only uses idle time */
+static bool khugepaged_idle_only __read_mostly;
 
 #define MM_SLOTS_HASH_BITS 10
 static __read_mostly DEFINE_HASHTABLE(mm_slots_hash, MM_SLOTS_HASH_BITS);
@@ -106,6 +108,18 @@ static struct khugepaged_scan khugepaged_scan = {
 	.mm_head = LIST_HEAD_INIT(khugepaged_scan.mm_head),
 };
 
+static void khugepaged_set_policy(struct task_struct *p)
+{
+	struct sched_param param = { .sched_priority = 0 };
+
+	if (khugepaged_idle_only) {
+		sched_setscheduler_nocheck(p, SCHED_IDLE, &param);
+	} else {
+		sched_setscheduler_nocheck(p, SCHED_NORMAL, &param);
+		set_user_nice(p, MAX_NICE);
+	}
+}
+
 #ifdef CONFIG_SYSFS
 static ssize_t scan_sleep_millisecs_show(struct kobject *kobj,
 					 struct kobj_attribute *attr,
@@ -283,6 +297,36 @@ static struct kobj_attribute khugepaged_max_ptes_swap_attr =
 	__ATTR(max_ptes_swap, 0644, khugepaged_max_ptes_swap_show,
 	       khugepaged_max_ptes_swap_store);
 
+static ssize_t khugepaged_idle_only_show(struct kobject *kobj,
+					 struct kobj_attribute *attr,
+					 char *buf)
+{
+	return sprintf(buf, "%d\n", khugepaged_idle_only);
+}
+
+static ssize_t khugepaged_idle_only_store(struct kobject *kobj,
+					  struct kobj_attribute *attr,
+					  const char *buf, size_t count)
+{
+	bool idle_only;
+	int err;
+
+	err = kstrtobool(buf, &idle_only);
+	if (err)
+		return -EINVAL;
+
+	mutex_lock(&khugepaged_mutex);
+	khugepaged_idle_only = idle_only;
+	if (khugepaged_thread)
+		khugepaged_set_policy(khugepaged_thread);
+	mutex_unlock(&khugepaged_mutex);
+
+	return count;
+}
+static struct kobj_attribute khugepaged_idle_only_attr =
+	__ATTR(idle_only, 0644, khugepaged_idle_only_show,
+	       khugepaged_idle_only_store);
+
 static struct attribute *khugepaged_attr[] = {
 	&khugepaged_defrag_attr.attr,
 	&khugepaged_max_ptes_none_attr.attr,
@@ -292,6 +336,7 @@ static struct attribute *khugepaged_attr[] = {
 	&scan_sleep_millisecs_attr.attr,
 	&alloc_sleep_millisecs_attr.attr,
 	&khugepaged_max_ptes_swap_attr.attr,
+	&khugepaged_idle_only_attr.attr,
 	NULL,
 };
 
@@ -342,6 +387,44 @@ int hugepage_madvise(struct vm_area_struct *vma,
 	return 0;
 }
 
+/**
+ * khugepaged_mm_set_hugepage - apply MADV_(NO)HUGEPAGE to the heaps of @mm
+ * @mm: the address space to update
+ * @enable: true for MADV_HUGEPAGE, false for MADV_NOHUGEPAGE
+ *
+ * Only private anonymous VMAs that can hold at least one aligned huge page
+ * are touched, which in practice are the managed heaps of a runtime, and
+ * they are queued to khugepaged right away.
+ */
+int khugepaged_mm_set_hugepage(struct mm_struct *mm, bool enable)
+{
+	int advice = enable ? MADV_HUGEPAGE : MADV_NOHUGEPAGE;
+	struct vm_area_struct *vma;
+	unsigned long vm_flags;
+	int err = 0;
+
+	down_write(&mm->mmap_sem);
+	for (vma = mm->mmap; vma; vma = vma->vm_next) {
+		if (!vma_is_anonymous(vma) || (vma->vm_flags & VM_SHARED))
+			continue;
+		if (round_up(vma->vm_start, HPAGE_PMD_SIZE) + HPAGE_PMD_SIZE >
+		    vma->vm_end)
+			continue;
+
+		vm_flags = vma->vm_flags;
+		err = hugepage_madvise(vma, &vm_flags, advice);
+		if (err)
+			break;
+
+		vm_write_begin(vma);
+		WRITE_ONCE(vma->vm_flags, vm_flags);
+		vm_write_end(vma);
+	}
+	up_write(&mm->mmap_sem);
+
+	return err;
+}
+
 int __init khugepaged_init(void)
 {
 	mm_slot_cache = kmem_cache_create("khugepaged_mm_slot",
@@ -1902,7 +1985,7 @@ static int khugepaged(void *none)
 	struct mm_slot *mm_slot;
 
 	set_freezable();
-	set_user_nice(current, MAX_NICE);
+	khugepaged_set_policy(current);
 
 	while (!kthread_should_stop()) {
 		khugepaged_do_scan();
@@ -227,6 +227,15 @@ static unsigned int ksm_thread_sleep_millisecs = 20;
 /* Boolean to indicate whether to use deferred timer or not */
 static bool use_deferred_timer;
 
+/* Whether zero-filled pages are merged with the zero page */
+static bool ksm_use_zero_pages;
+
+/* Checksum of an empty (zeroed) page */
+static unsigned int zero_checksum;
+
+/* Number of zero-filled pages replaced by the zero page */
+static unsigned long ksm_zero_pages;
+
 #ifdef CONFIG_NUMA
 /* Zeroed when merging across nodes is not allowed */
 static unsigned int ksm_merge_across_nodes = 1;
@@ -437,6 +446,42 @@ static int break_ksm(struct vm_area_struct *vma, unsigned long addr)
 	return (ret & VM_FAULT_OOM) ? -ENOMEM : 0;
 }
 
+/**
+ * ksm_mm_set_mergeable - mark all private anonymous memory of @mm mergeable
+ * @mm: the address space, which must be pinned by the caller
+ * @mergeable: true to mark it, false to unmerge and unmark it
+ *
+ * This is madvise(MADV_MERGEABLE) applied to every private anonymous VMA
+ * on behalf of the process, for memory managers that want ksmd to scan
+ * the heaps of applications which never asked for it.
+ */
+int ksm_mm_set_mergeable(struct mm_struct *mm, bool mergeable)
+{
+	int advice = mergeable ? MADV_MERGEABLE : MADV_UNMERGEABLE;
+	struct vm_area_struct *vma;
+	unsigned long vm_flags;
+	int err = 0;
+
+	down_write(&mm->mmap_sem);
+	for (vma = mm->mmap; vma; vma = vma->vm_next) {
+		if (!vma_is_anonymous(vma))
+			continue;
+
+		vm_flags = vma->vm_flags;
+		err = ksm_madvise(vma, vma->vm_start, vma->vm_end, advice,
+				  &vm_flags);
+		if (err)
+			break;
+
+		vm_write_begin(vma);
+		WRITE_ONCE(vma->vm_flags, vm_flags);
+		vm_write_end(vma);
+	}
+	up_write(&mm->mmap_sem);
+
+	return err;
+}
+
 static struct vm_area_struct *find_mergeable_vma(struct mm_struct *mm,
 		unsigned long addr)
 {
@@ -945,6 +990,7 @@ static int replace_page(struct vm_area_struct *vma, struct page *page,
 	struct mm_struct *mm = vma->vm_mm;
 	pmd_t *pmd;
 	pte_t *ptep;
+	pte_t newpte;
 	spinlock_t *ptl;
 	unsigned long addr;
 	int err = -EFAULT;
@@ -969,12 +1015,25 @@ static int replace_page(struct vm_area_struct *vma, struct page *page,
 		goto out_mn;
 	}
 
-	get_page(kpage);
-	page_add_anon_rmap(kpage, vma, addr, false);
+	/*
+	 * The zero page is only passed in with ksm_use_zero_pages set; it is
+	 * mapped as a special pte and, like any zero page mapping, is not
+	 * accounted in the RSS.
+	 */
+	if (!is_zero_pfn(page_to_pfn(kpage))) {
+		get_page(kpage);
+		page_add_anon_rmap(kpage, vma, addr, false);
+		newpte = mk_pte(kpage, vma->vm_page_prot);
+	} else {
+		newpte = pte_mkspecial(pfn_pte(page_to_pfn(kpage),
+					       vma->vm_page_prot));
+		dec_mm_counter(mm, MM_ANONPAGES);
+		ksm_zero_pages++;
+	}
 
 	flush_cache_page(vma, addr, pte_pfn(*ptep));
 	ptep_clear_flush_notify(vma, addr, ptep);
-	set_pte_at_notify(mm, addr, ptep, mk_pte(kpage, vma->vm_page_prot));
+	set_pte_at_notify(mm, addr, ptep, newpte);
 
 	page_remove_rmap(page, false);
 	if (!page_mapped(page))
@@ -1485,6 +1544,26 @@ static void cmp_and_merge_page(struct page *page, struct rmap_item *rmap_item)
 		return;
 	}
 
+	/*
+	 * Same checksum as an empty page: try to map the zero page instead,
+	 * which frees the page without growing the stable tree. If the page
+	 * turns out not to be empty, carry on as usual.
+	 */
+	if (ksm_use_zero_pages && checksum == zero_checksum) {
+		struct mm_struct *mm = rmap_item->mm;
+		struct vm_area_struct *vma;
+
+		down_read(&mm->mmap_sem);
+		vma = find_mergeable_vma(mm, rmap_item->address);
+		err = -EFAULT;
+		if (vma && !(vma->vm_flags & VM_LOCKED))
+			err = try_to_merge_one_page(vma, page,
+					ZERO_PAGE(rmap_item->address));
+		up_read(&mm->mmap_sem);
+		if (!err)
+			return;
+	}
+
 	tree_rmap_item =
 		unstable_tree_search_insert(rmap_item, page, &tree_page);
 	if (tree_rmap_item) {
@@ -2281,6 +2360,36 @@ static ssize_t deferred_timer_store(struct kobject *kobj,
 }
 KSM_ATTR(deferred_timer);
 
+static ssize_t use_zero_pages_show(struct kobject *kobj,
+				   struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_use_zero_pages);
+}
+
+static ssize_t use_zero_pages_store(struct kobject *kobj,
+				    struct kobj_attribute *attr,
+				    const char *buf, size_t count)
+{
+	bool value;
+	int err;
+
+	err = kstrtobool(buf, &value);
+	if (err)
+		return -EINVAL;
+
+	ksm_use_zero_pages = value;
+
+	return count;
+}
+KSM_ATTR(use_zero_pages);
+
+static ssize_t zero_pages_show(struct kobject *kobj,
+			       struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", ksm_zero_pages);
+}
+KSM_ATTR_RO(zero_pages);
+
 #ifdef CONFIG_NUMA
 static ssize_t merge_across_nodes_show(struct kobject *kobj,
 				struct kobj_attribute *attr, char *buf)
@@ -2394,6 +2503,8 @@ static struct attribute *ksm_attrs[] = {
 	&pages_volatile_attr.attr,
 	&full_scans_attr.attr,
 	&deferred_timer_attr.attr,
+	&use_zero_pages_attr.attr,
+	&zero_pages_attr.attr,
 #ifdef CONFIG_NUMA
 	&merge_across_nodes_attr.attr,
 #endif
@@ -2411,6 +2522,9 @@ static int __init ksm_init(void)
 	struct task_struct *ksm_thread;
 	int err;
 
+	/* The correct value depends on page size and endianness */
+	zero_checksum = calc_checksum(ZERO_PAGE(0));
+
 	err = ksm_slab_init();
 	if (err)
 		goto out;
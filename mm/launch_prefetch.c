@@ -0,0 +1,557 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Page cache warmup from application launch manifests.
+ *
+ * A cold application launch is dominated by many small synchronous read
+ * faults on its APK, odex and shared library files. The ranges touched by
+ * previous launches (as captured e.g. from the filemap tracepoints) can be
+ * loaded as a named manifest and replayed as a few large asynchronous
+ * readahead batches as soon as the next launch starts.
+ *
+ * A manifest is loaded by writing it to /proc/launch_prefetch/manifest,
+ * the first line being its name and each following line one range:
+ *
+ *	<offset> <length> <path>
+ *
+ * It is published, replacing any manifest of the same name, when the file
+ * is closed; a manifest without ranges removes the named one. Overlapping
+ * and nearby ranges of the same file are coalesced at that point.
+ *
+ * Writing a name to /proc/launch_prefetch/launch replays that manifest,
+ * which is also done when a program whose basename matches the name is
+ * executed. Replay is skipped or cancelled while memory is under pressure
+ * as reported by PSI. /proc/launch_prefetch/status lists the manifests.
+ */
+
+#define pr_fmt(fmt) "launch_prefetch: " fmt
+
+#include <linux/blkdev.h>
+#include <linux/fs.h>
+#include <linux/kref.h>
+#include <linux/launch_prefetch.h>
+#include <linux/mm.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/pagemap.h>
+#include <linux/proc_fs.h>
+#include <linux/psi.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+
+#define LP_NAME_MAX		64
+#define LP_LINE_MAX		(PATH_MAX + 64)
+#define LP_MAX_MANIFESTS	64
+#define LP_MAX_PATHS		512
+#define LP_MAX_RANGES		8192
+
+/* Ranges closer than this are read as one */
+static unsigned int merge_gap_kb = 64;
+module_param(merge_gap_kb, uint, 0644);
+
+/* Upper bound of a single replay */
+static unsigned int max_replay_kb = 64 * 1024;
+module_param(max_replay_kb, uint, 0644);
+
+/* Memory stall that cancels replays, and for how long it does */
+static unsigned int psi_thres_ms = 100;
+static unsigned int psi_window_ms = 1000;
+module_param(psi_thres_ms, uint, 0444);
+module_param(psi_window_ms, uint, 0444);
+
+struct lp_range {
+	unsigned int path;
+	pgoff_t index;
+	unsigned long nr;
+};
+
+struct lp_manifest {
+	struct list_head list;
+	struct kref ref;
+	char name[LP_NAME_MAX];
+	char **paths;
+	unsigned int nr_paths;
+	struct lp_range *ranges;
+	unsigned int nr_ranges;
+	unsigned int max_ranges;
+	unsigned long nr_pages;
+	atomic_t nr_replays;
+	atomic_t nr_cancelled;
+};
+
+/* Open manifest file, parse state */
+struct lp_loader {
+	struct lp_manifest *m;
+	char line[LP_LINE_MAX];
+	int line_len;
+	bool named;
+	int err;
+};
+
+struct lp_replay {
+	struct work_struct work;
+	struct lp_manifest *m;
+};
+
+static DEFINE_MUTEX(lp_mutex);
+static LIST_HEAD(lp_manifests);
+static unsigned int lp_nr_manifests;
+
+static struct psi_trigger *lp_psi_trig;
+static unsigned long lp_stall_expires;
+static atomic_t lp_stall_seq = ATOMIC_INIT(0);
+
+static void lp_psi_notify(void *data)
+{
+	WRITE_ONCE(lp_stall_expires,
+		   jiffies + msecs_to_jiffies(psi_window_ms));
+	atomic_inc(&lp_stall_seq);
+}
+
+static bool lp_stalled(void)
+{
+	return time_before(jiffies, READ_ONCE(lp_stall_expires));
+}
+
+static void lp_manifest_free(struct lp_manifest *m)
+{
+	unsigned int i;
+
+	for (i = 0; i < m->nr_paths; i++)
+		kfree(m->paths[i]);
+	kfree(m->paths);
+	vfree(m->ranges);
+	kfree(m);
+}
+
+static void lp_manifest_release(struct kref *ref)
+{
+	lp_manifest_free(container_of(ref, struct lp_manifest, ref));
+}
+
+static void lp_manifest_put(struct lp_manifest *m)
+{
+	kref_put(&m->ref, lp_manifest_release);
+}
+
+/* Must be called with lp_mutex held */
+static struct lp_manifest *lp_find(const char *name)
+{
+	struct lp_manifest *m;
+
+	list_for_each_entry(m, &lp_manifests, list)
+		if (!strcmp(m->name, name))
+			return m;
+
+	return NULL;
+}
+
+static void lp_replay_fn(struct work_struct *work)
+{
+	struct lp_replay *rp = container_of(work, typeof(*rp), work);
+	struct lp_manifest *m = rp->m;
+	unsigned long budget = (unsigned long)max_replay_kb >> (PAGE_SHIFT - 10);
+	int seq = atomic_read(&lp_stall_seq);
+	unsigned int i, cur = UINT_MAX;
+	struct file *filp = NULL;
+	struct blk_plug plug;
+
+	atomic_inc(&m->nr_replays);
+	if (lp_stalled()) {
+		atomic_inc(&m->nr_cancelled);
+		goto out;
+	}
+
+	blk_start_plug(&plug);
+	for (i = 0; i < m->nr_ranges && budget; i++) {
+		struct lp_range *r = &m->ranges[i];
+		unsigned long nr = min(r->nr, budget);
+
+		if (atomic_read(&lp_stall_seq) != seq) {
+			atomic_inc(&m->nr_cancelled);
+			break;
+		}
+
+		if (r->path != cur) {
+			if (filp)
+				fput(filp);
+			cur = r->path;
+			filp = filp_open(m->paths[cur], O_RDONLY | O_LARGEFILE, 0);
+			if (IS_ERR(filp))
+				filp = NULL;
+		}
+		if (!filp)
+			continue;
+
+		force_page_cache_readahead(filp->f_mapping, filp, r->index, nr);
+		budget -= nr;
+		cond_resched();
+	}
+	blk_finish_plug(&plug);
+
+	if (filp)
+		fput(filp);
+out:
+	lp_manifest_put(m);
+	kfree(rp);
+}
+
+static int lp_replay(const char *name)
+{
+	struct lp_manifest *m;
+	struct lp_replay *rp;
+
+	rp = kmalloc(sizeof(*rp), GFP_KERNEL);
+	if (!rp)
+		return -ENOMEM;
+
+	mutex_lock(&lp_mutex);
+	m = lp_find(name);
+	if (m)
+		kref_get(&m->ref);
+	mutex_unlock(&lp_mutex);
+
+	if (!m) {
+		kfree(rp);
+		return -ENOENT;
+	}
+
+	INIT_WORK(&rp->work, lp_replay_fn);
+	rp->m = m;
+	queue_work(system_unbound_wq, &rp->work);
+
+	return 0;
+}
+
+void launch_prefetch_exec(const char *filename)
+{
+	if (!READ_ONCE(lp_nr_manifests))
+		return;
+
+	lp_replay(kbasename(filename));
+}
+
+static int lp_range_cmp(const void *a, const void *b)
+{
+	const struct lp_range *ra = a, *rb = b;
+
+	if (ra->path != rb->path)
+		return ra->path < rb->path ? -1 : 1;
+	if (ra->index != rb->index)
+		return ra->index < rb->index ? -1 : 1;
+	return 0;
+}
+
+/* Sort the ranges by file and offset and merge close ones */
+static void lp_manifest_coalesce(struct lp_manifest *m)
+{
+	unsigned long gap = (unsigned long)merge_gap_kb >> (PAGE_SHIFT - 10);
+	struct lp_range *out;
+	unsigned int i;
+
+	if (!m->nr_ranges)
+		return;
+
+	sort(m->ranges, m->nr_ranges, sizeof(*m->ranges), lp_range_cmp, NULL);
+
+	out = m->ranges;
+	for (i = 1; i < m->nr_ranges; i++) {
+		struct lp_range *r = &m->ranges[i];
+
+		if (r->path == out->path &&
+		    r->index <= out->index + out->nr + gap) {
+			out->nr = max(out->nr, r->index + r->nr - out->index);
+			continue;
+		}
+		*++out = *r;
+	}
+	m->nr_ranges = out - m->ranges + 1;
+
+	m->nr_pages = 0;
+	for (i = 0; i < m->nr_ranges; i++)
+		m->nr_pages += m->ranges[i].nr;
+}
+
+static int lp_add_path(struct lp_manifest *m, const char *path)
+{
+	char **paths;
+	int i;
+
+	/* Captured ranges are mostly grouped by file, look back first */
+	for (i = m->nr_paths - 1; i >= 0; i--)
+		if (!strcmp(m->paths[i], path))
+			return i;
+
+	if (m->nr_paths >= LP_MAX_PATHS)
+		return -E2BIG;
+
+	paths = krealloc(m->paths, (m->nr_paths + 1) * sizeof(*paths),
+			 GFP_KERNEL);
+	if (!paths)
+		return -ENOMEM;
+	m->paths = paths;
+
+	paths[m->nr_paths] = kstrdup(path, GFP_KERNEL);
+	if (!paths[m->nr_paths])
+		return -ENOMEM;
+
+	return m->nr_paths++;
+}
+
+static int lp_add_range(struct lp_manifest *m, char *line)
+{
+	unsigned long long off, len;
+	struct lp_range *r;
+	char *path;
+	int n, idx;
+
+	if (sscanf(line, "%llu %llu %n", &off, &len, &n) != 2 || !len)
+		return -EINVAL;
+
+	path = strim(line + n);
+	if (*path != '/')
+		return -EINVAL;
+
+	idx = lp_add_path(m, path);
+	if (idx < 0)
+		return idx;
+
+	if (m->nr_ranges == m->max_ranges) {
+		unsigned int max = m->max_ranges ? m->max_ranges * 2 : 64;
+		struct lp_range *ranges;
+
+		if (m->nr_ranges >= LP_MAX_RANGES)
+			return -E2BIG;
+		max = min_t(unsigned int, max, LP_MAX_RANGES);
+
+		ranges = vmalloc(max * sizeof(*ranges));
+		if (!ranges)
+			return -ENOMEM;
+		if (m->ranges)
+			memcpy(ranges, m->ranges,
+			       m->nr_ranges * sizeof(*ranges));
+		vfree(m->ranges);
+		m->ranges = ranges;
+		m->max_ranges = max;
+	}
+
+	r = &m->ranges[m->nr_ranges++];
+	r->path = idx;
+	r->index = off >> PAGE_SHIFT;
+	r->nr = ((off + len + PAGE_SIZE - 1) >> PAGE_SHIFT) - r->index;
+
+	return 0;
+}
+
+static int lp_parse_line(struct lp_loader *ld, char *line)
+{
+	line = strim(line);
+	if (!*line)
+		return 0;
+
+	if (!ld->named) {
+		if (strlen(line) >= LP_NAME_MAX || strchr(line, ' '))
+			return -EINVAL;
+		strlcpy(ld->m->name, line, LP_NAME_MAX);
+		ld->named = true;
+		return 0;
+	}
+
+	return lp_add_range(ld->m, line);
+}
+
+static ssize_t lp_manifest_write(struct file *filp, const char __user *ubuf,
+				 size_t cnt, loff_t *ppos)
+{
+	struct lp_loader *ld = filp->private_data;
+	size_t done = 0;
+	char buf[128];
+	int ret = 0;
+
+	if (ld->err)
+		return ld->err;
+
+	while (done < cnt) {
+		size_t len = min(cnt - done, sizeof(buf));
+		size_t i;
+
+		if (copy_from_user(buf, ubuf + done, len)) {
+			ret = -EFAULT;
+			break;
+		}
+
+		for (i = 0; i < len && !ret; i++) {
+			if (buf[i] != '\n') {
+				if (ld->line_len >= LP_LINE_MAX - 1)
+					ret = -EINVAL;
+				else
+					ld->line[ld->line_len++] = buf[i];
+				continue;
+			}
+
+			ld->line[ld->line_len] = '\0';
+			ld->line_len = 0;
+			ret = lp_parse_line(ld, ld->line);
+		}
+		if (ret)
+			break;
+		done += len;
+	}
+
+	if (ret) {
+		/* A partially loaded manifest is never published */
+		ld->err = ret;
+		return ret;
+	}
+
+	*ppos += done;
+	return done;
+}
+
+static int lp_manifest_open(struct inode *inode, struct file *filp)
+{
+	struct lp_loader *ld;
+
+	ld = kzalloc(sizeof(*ld), GFP_KERNEL);
+	if (!ld)
+		return -ENOMEM;
+
+	ld->m = kzalloc(sizeof(*ld->m), GFP_KERNEL);
+	if (!ld->m) {
+		kfree(ld);
+		return -ENOMEM;
+	}
+	kref_init(&ld->m->ref);
+
+	filp->private_data = ld;
+	return 0;
+}
+
+static int lp_manifest_release_file(struct inode *inode, struct file *filp)
+{
+	struct lp_loader *ld = filp->private_data;
+	struct lp_manifest *m = ld->m, *old;
+
+	/* The last line need not be terminated */
+	if (!ld->err && ld->line_len) {
+		ld->line[ld->line_len] = '\0';
+		ld->err = lp_parse_line(ld, ld->line);
+	}
+
+	if (ld->err || !ld->named) {
+		lp_manifest_free(m);
+		goto out;
+	}
+
+	lp_manifest_coalesce(m);
+
+	mutex_lock(&lp_mutex);
+	old = lp_find(m->name);
+	if (old) {
+		list_del(&old->list);
+		lp_nr_manifests--;
+	}
+	if (!m->nr_ranges) {
+		lp_manifest_free(m);
+	} else if (lp_nr_manifests >= LP_MAX_MANIFESTS) {
+		pr_warn("too many manifests, dropping %s\n", m->name);
+		lp_manifest_free(m);
+	} else {
+		list_add(&m->list, &lp_manifests);
+		lp_nr_manifests++;
+	}
+	mutex_unlock(&lp_mutex);
+
+	if (old)
+		lp_manifest_put(old);
+out:
+	kfree(ld);
+	return 0;
+}
+
+static const struct file_operations lp_manifest_fops = {
+	.open		= lp_manifest_open,
+	.write		= lp_manifest_write,
+	.release	= lp_manifest_release_file,
+	.llseek		= noop_llseek,
+};
+
+static ssize_t lp_launch_write(struct file *filp, const char __user *ubuf,
+			       size_t cnt, loff_t *ppos)
+{
+	char name[LP_NAME_MAX + 1];
+	int ret;
+
+	if (cnt >= sizeof(name))
+		return -EINVAL;
+	if (copy_from_user(name, ubuf, cnt))
+		return -EFAULT;
+	name[cnt] = '\0';
+
+	ret = lp_replay(strim(name));
+
+	return ret ? ret : cnt;
+}
+
+static const struct file_operations lp_launch_fops = {
+	.write		= lp_launch_write,
+	.llseek		= noop_llseek,
+};
+
+static int lp_status_show(struct seq_file *m, void *v)
+{
+	struct lp_manifest *lm;
+
+	mutex_lock(&lp_mutex);
+	list_for_each_entry(lm, &lp_manifests, list)
+		seq_printf(m, "%s: files: %u ranges: %u kb: %lu replays: %d cancelled: %d\n",
+			   lm->name, lm->nr_paths, lm->nr_ranges,
+			   lm->nr_pages << (PAGE_SHIFT - 10),
+			   atomic_read(&lm->nr_replays),
+			   atomic_read(&lm->nr_cancelled));
+	mutex_unlock(&lp_mutex);
+
+	return 0;
+}
+
+static int lp_status_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, lp_status_show, NULL);
+}
+
+static const struct file_operations lp_status_fops = {
+	.open		= lp_status_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init launch_prefetch_init(void)
+{
+	struct proc_dir_entry *dir;
+
+	dir = proc_mkdir("launch_prefetch", NULL);
+	if (!dir)
+		return -ENOMEM;
+
+	proc_create("manifest", 0200, dir, &lp_manifest_fops);
+	proc_create("launch", 0200, dir, &lp_launch_fops);
+	proc_create("status", 0444, dir, &lp_status_fops);
+
+	lp_psi_trig = psi_kernel_trigger_create(PSI_MEM_SOME,
+			psi_thres_ms * USEC_PER_MSEC,
+			psi_window_ms * USEC_PER_MSEC,
+			lp_psi_notify, NULL);
+	if (IS_ERR(lp_psi_trig)) {
+		pr_warn("no psi trigger, replays are not cancelled (%ld)\n",
+			PTR_ERR(lp_psi_trig));
+		lp_psi_trig = NULL;
+	}
+
+	return 0;
+}
+late_initcall(launch_prefetch_init);
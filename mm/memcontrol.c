@@ -406,11 +406,22 @@ static void __mem_cgroup_insert_exceeded(struct mem_cgroup_per_node *mz,
 	mz->usage_in_excess = new_usage_in_excess;
 	if (!mz->usage_in_excess)
 		return;
+	/*
+	 * The tree is ordered by tier first, so that the rightmost node is
+	 * the largest excess of the highest tier. The tier is sampled here
+	 * as the memcg's one may change while the node is on the tree.
+	 */
+	mz->soft_tier = READ_ONCE(mz->memcg->soft_reclaim_tier);
 	while (*p) {
 		parent = *p;
 		mz_node = rb_entry(parent, struct mem_cgroup_per_node,
 					tree_node);
-		if (mz->usage_in_excess < mz_node->usage_in_excess)
+		if (mz->soft_tier != mz_node->soft_tier) {
+			if (mz->soft_tier < mz_node->soft_tier)
+				p = &(*p)->rb_left;
+			else
+				p = &(*p)->rb_right;
+		} else if (mz->usage_in_excess < mz_node->usage_in_excess)
 			p = &(*p)->rb_left;
 		/*
 		 * We can't avoid mem cgroups that are over their soft
@@ -3303,6 +3314,43 @@ static int mem_cgroup_swappiness_write(struct cgroup_subsys_state *css,
 	return 0;
 }
 
+static u64 mem_cgroup_soft_reclaim_tier_read(struct cgroup_subsys_state *css,
+					     struct cftype *cft)
+{
+	return mem_cgroup_from_css(css)->soft_reclaim_tier;
+}
+
+static int mem_cgroup_soft_reclaim_tier_write(struct cgroup_subsys_state *css,
+					      struct cftype *cft, u64 val)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(css);
+
+	if (val > UINT_MAX)
+		return -EINVAL;
+
+	/* Picked up the next time the memcg is put on the soft limit tree */
+	WRITE_ONCE(memcg->soft_reclaim_tier, val);
+	return 0;
+}
+
+static u64 mem_cgroup_protect_file_read(struct cgroup_subsys_state *css,
+					struct cftype *cft)
+{
+	return mem_cgroup_from_css(css)->protect_file;
+}
+
+static int mem_cgroup_protect_file_write(struct cgroup_subsys_state *css,
+					 struct cftype *cft, u64 val)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(css);
+
+	if (val > 1)
+		return -EINVAL;
+
+	WRITE_ONCE(memcg->protect_file, val);
+	return 0;
+}
+
 static void __mem_cgroup_threshold(struct mem_cgroup *memcg, bool swap)
 {
 	struct mem_cgroup_threshold_ary *t;
@@ -4022,6 +4070,18 @@ static struct cftype mem_cgroup_legacy_files[] = {
 		.read_u64 = mem_cgroup_swappiness_read,
 		.write_u64 = mem_cgroup_swappiness_write,
 	},
+	{
+		.name = "soft_reclaim_tier",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = mem_cgroup_soft_reclaim_tier_read,
+		.write_u64 = mem_cgroup_soft_reclaim_tier_write,
+	},
+	{
+		.name = "protect_file_cache",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = mem_cgroup_protect_file_read,
+		.write_u64 = mem_cgroup_protect_file_write,
+	},
 	{
 		.name = "move_charge_at_immigrate",
 		.read_u64 = mem_cgroup_move_charge_read,
@@ -2760,8 +2760,7 @@ int do_swap_page(struct fault_env *fe, pte_t orig_pte)
 	delayacct_set_flag(DELAYACCT_PF_SWAPIN);
 	page = lookup_swap_cache(entry);
 	if (!page) {
-		page = swapin_readahead(entry,
-					GFP_HIGHUSER_MOVABLE, vma, fe->address);
+		page = swapin_readahead_vma(entry, GFP_HIGHUSER_MOVABLE, fe);
 		if (!page) {
 			/*
 			 * Back out if the VMA has changed in our back during
@@ -2854,6 +2853,7 @@ int do_swap_page(struct fault_env *fe, pte_t orig_pte)
 
 	inc_mm_counter_fast(vma->vm_mm, MM_ANONPAGES);
 	dec_mm_counter_fast(vma->vm_mm, MM_SWAPENTS);
+	mm_count_swap_refault(vma->vm_mm);
 	pte = mk_pte(page, fe->vma_page_prot);
 	if ((fe->flags & FAULT_FLAG_WRITE) && reuse_swap_page(page, NULL)) {
 		pte = maybe_mkwrite(pte_mkdirty(pte), fe->vma_flags);
@@ -3305,6 +3305,58 @@ static unsigned long fault_around_bytes __read_mostly =
 	rounddown_pow_of_two(65536);
 #endif
 
+/*
+ * With fault_around_adaptive set, each VMA scales its fault-around window
+ * between a single page and FAULT_AROUND_MAX_SCALE times fault_around_bytes:
+ * a read fault landing shortly past the previous one doubles it, any other
+ * read fault halves it. MADV_RANDOM and MADV_SEQUENTIAL pin it to either end.
+ */
+#define FAULT_AROUND_MAX_SCALE	8
+static bool fault_around_adaptive __read_mostly;
+
+static unsigned long fault_around_max_pages(unsigned long base)
+{
+	return min_t(unsigned long, base * FAULT_AROUND_MAX_SCALE,
+		     PTRS_PER_PTE);
+}
+
+static unsigned long vma_fault_around_pages(struct vm_area_struct *vma)
+{
+	unsigned long base = READ_ONCE(fault_around_bytes) >> PAGE_SHIFT;
+	unsigned char order;
+
+	if (!fault_around_adaptive || base <= 1)
+		return base;
+	if (vma->vm_flags & VM_RAND_READ)
+		return 1;
+	if (vma->vm_flags & VM_SEQ_READ)
+		return fault_around_max_pages(base);
+
+	order = READ_ONCE(vma->vm_fault_around_order);
+	if (!order)
+		return base;
+	return min(1UL << (order - 1), fault_around_max_pages(base));
+}
+
+static void vma_fault_around_update(struct vm_area_struct *vma, pgoff_t pgoff,
+				    unsigned long nr_pages)
+{
+	unsigned long base = READ_ONCE(fault_around_bytes) >> PAGE_SHIFT;
+	pgoff_t last = READ_ONCE(vma->vm_fault_around_last);
+
+	if (!fault_around_adaptive || base <= 1 ||
+	    (vma->vm_flags & (VM_RAND_READ | VM_SEQ_READ)))
+		return;
+
+	if (pgoff > last && pgoff - last <= 2 * nr_pages)
+		nr_pages = min(nr_pages * 2, fault_around_max_pages(base));
+	else if (nr_pages > 1)
+		nr_pages /= 2;
+
+	WRITE_ONCE(vma->vm_fault_around_order, ilog2(nr_pages) + 1);
+	WRITE_ONCE(vma->vm_fault_around_last, pgoff);
+}
+
 #ifdef CONFIG_DEBUG_FS
 static int fault_around_bytes_get(void *data, u64 *val)
 {
@@ -3338,6 +3390,10 @@ static int __init fault_around_debugfs(void)
 			&fault_around_bytes_fops);
 	if (!ret)
 		pr_warn("Failed to create fault_around_bytes in debugfs");
+	ret = debugfs_create_bool("fault_around_adaptive", 0644, NULL,
+			&fault_around_adaptive);
+	if (!ret)
+		pr_warn("Failed to create fault_around_adaptive in debugfs");
 	return 0;
 }
 late_initcall(fault_around_debugfs);
@@ -3358,22 +3414,21 @@ late_initcall(fault_around_debugfs);
  * This function doesn't cross the VMA boundaries, in order to call map_pages()
  * only once.
  *
- * fault_around_pages() defines how many pages we'll try to map.
- * do_fault_around() expects it to return a power of two less than or equal to
- * PTRS_PER_PTE.
+ * @nr_pages defines how many pages we'll try to map. do_fault_around()
+ * expects it to be a power of two less than or equal to PTRS_PER_PTE.
  *
  * The virtual address of the area that we map is naturally aligned to the
- * fault_around_pages() value (and therefore to page order).  This way it's
+ * @nr_pages value (and therefore to page order).  This way it's
  * easier to guarantee that we don't cross page table boundaries.
  */
-static int do_fault_around(struct fault_env *fe, pgoff_t start_pgoff)
+static int do_fault_around(struct fault_env *fe, pgoff_t start_pgoff,
+			   unsigned long nr_pages)
 {
-	unsigned long address = fe->address, nr_pages, mask;
+	unsigned long address = fe->address, mask;
 	pgoff_t end_pgoff;
 	int off, ret = 0;
 
 	fe->fault_address = address;
-	nr_pages = READ_ONCE(fault_around_bytes) >> PAGE_SHIFT;
 	mask = ~(nr_pages * PAGE_SIZE - 1) & PAGE_MASK;
 
 	fe->address = max(address & mask, fe->vma->vm_start);
@@ -3428,16 +3483,19 @@ static int do_fault_around(struct fault_env *fe, pgoff_t start_pgoff)
 static int do_read_fault(struct fault_env *fe, pgoff_t pgoff)
 {
 	struct vm_area_struct *vma = fe->vma;
+	unsigned long nr_pages = vma_fault_around_pages(vma);
 	struct page *fault_page;
 	int ret = 0;
 
+	vma_fault_around_update(vma, pgoff, nr_pages);
+
 	/*
 	 * Let's call ->map_pages() first and use ->fault() as fallback
 	 * if page by the offset is not ready to be mapped (cold cache or
 	 * something).
 	 */
-	if (vma->vm_ops->map_pages && fault_around_bytes >> PAGE_SHIFT > 1) {
-		ret = do_fault_around(fe, pgoff);
+	if (vma->vm_ops->map_pages && nr_pages > 1) {
+		ret = do_fault_around(fe, pgoff, nr_pages);
 		if (ret)
 			return ret;
 	}
@@ -4149,10 +4207,14 @@ bool can_reuse_spf_vma(struct vm_area_struct *vma, unsigned long address)
 int handle_mm_fault(struct vm_area_struct *vma, unsigned long address,
 		unsigned int flags)
 {
+	u64 start = 0;
 	int ret;
 
 	__set_current_state(TASK_RUNNING);
 
+	if (trace_mm_fault_latency_enabled())
+		start = sched_clock();
+
 	count_vm_event(PGFAULT);
 	mem_cgroup_count_vm_event(vma->vm_mm, PGFAULT);
 
@@ -4211,6 +4273,10 @@ int handle_mm_fault(struct vm_area_struct *vma, unsigned long address,
 		ret = VM_FAULT_SIGBUS;
 	}
 
+	if (start)
+		trace_mm_fault_latency(address, flags, ret,
+				       sched_clock() - start);
+
 	return ret;
 }
 EXPORT_SYMBOL_GPL(handle_mm_fault);
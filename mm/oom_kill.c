@@ -459,11 +459,33 @@ static struct task_struct *oom_reaper_th;
 static DECLARE_WAIT_QUEUE_HEAD(oom_reaper_wait);
 static struct task_struct *oom_reaper_list;
 static DEFINE_SPINLOCK(oom_reaper_lock);
+static BLOCKING_NOTIFIER_HEAD(oom_reap_notify_list);
 
-static bool __oom_reap_task_mm(struct task_struct *tsk, struct mm_struct *mm)
+int register_oom_reap_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_register(&oom_reap_notify_list, nb);
+}
+EXPORT_SYMBOL_GPL(register_oom_reap_notifier);
+
+int unregister_oom_reap_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_unregister(&oom_reap_notify_list, nb);
+}
+EXPORT_SYMBOL_GPL(unregister_oom_reap_notifier);
+
+static unsigned long oom_reap_mm_rss(struct mm_struct *mm)
+{
+	return get_mm_counter(mm, MM_ANONPAGES) +
+		get_mm_counter(mm, MM_FILEPAGES) +
+		get_mm_counter(mm, MM_SHMEMPAGES);
+}
+
+static bool __oom_reap_task_mm(struct task_struct *tsk, struct mm_struct *mm,
+			       unsigned long *reaped)
 {
 	struct mmu_gather tlb;
 	struct vm_area_struct *vma;
+	unsigned long rss;
 	bool ret = true;
 
 	/*
@@ -525,6 +547,7 @@ static bool __oom_reap_task_mm(struct task_struct *tsk, struct mm_struct *mm)
 	 */
 	set_bit(MMF_UNSTABLE, &mm->flags);
 
+	rss = oom_reap_mm_rss(mm);
 	for (vma = mm->mmap ; vma; vma = vma->vm_next) {
 		if (!can_madv_dontneed_vma(vma))
 			continue;
@@ -551,6 +574,7 @@ static bool __oom_reap_task_mm(struct task_struct *tsk, struct mm_struct *mm)
 			K(get_mm_counter(mm, MM_ANONPAGES)),
 			K(get_mm_counter(mm, MM_FILEPAGES)),
 			K(get_mm_counter(mm, MM_SHMEMPAGES)));
+	*reaped += rss - min(rss, oom_reap_mm_rss(mm));
 	up_read(&mm->mmap_sem);
 
 	trace_finish_task_reaping(tsk->pid);
@@ -564,13 +588,20 @@ static void oom_reap_task(struct task_struct *tsk)
 {
 	int attempts = 0;
 	struct mm_struct *mm = tsk->signal->oom_mm;
+	struct oom_reap_info info = {
+		.tsk = tsk,
+		.reaped_pages = 0,
+	};
 
 	/* Retry the down_read_trylock(mmap_sem) a few times */
-	while (attempts++ < MAX_OOM_REAP_RETRIES && !__oom_reap_task_mm(tsk, mm))
+	while (attempts++ < MAX_OOM_REAP_RETRIES &&
+	       !__oom_reap_task_mm(tsk, mm, &info.reaped_pages))
 		schedule_timeout_idle(HZ/10);
 
-	if (attempts <= MAX_OOM_REAP_RETRIES)
+	if (attempts <= MAX_OOM_REAP_RETRIES) {
+		blocking_notifier_call_chain(&oom_reap_notify_list, 0, &info);
 		goto done;
+	}
 
 
 	pr_info("oom_reaper: unable to reap pid:%d (%s)\n",
@@ -652,6 +683,18 @@ subsys_initcall(oom_init)
 static inline void wake_oom_reaper(struct task_struct *tsk)
 {
 }
+
+int register_oom_reap_notifier(struct notifier_block *nb)
+{
+	return 0;
+}
+EXPORT_SYMBOL_GPL(register_oom_reap_notifier);
+
+int unregister_oom_reap_notifier(struct notifier_block *nb)
+{
+	return 0;
+}
+EXPORT_SYMBOL_GPL(unregister_oom_reap_notifier);
 #endif /* CONFIG_MMU */
 
 static void __mark_oom_victim(struct task_struct *tsk)
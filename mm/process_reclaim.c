@@ -64,6 +64,16 @@ module_param_named(swap_eff_win, swap_eff_win, int, 0644);
 static int swap_opt_eff = 50;
 module_param_named(swap_opt_eff, swap_opt_eff, int, 0644);
 
+/*
+ * Per task reclaim efficiency: pages reclaimed from a task are compared
+ * with the swap-ins of that task over the following refault_win_ms. A
+ * task whose reclaimed pages keep getting faulted back in has a low cold
+ * percentage and its share of each reclaim run shrinks accordingly, so
+ * that reclaim prefers tasks whose pages stay cold.
+ */
+static int refault_win_ms = 10000;
+module_param_named(refault_win_ms, refault_win_ms, int, 0644);
+
 static atomic_t skip_reclaim = ATOMIC_INIT(0);
 /* Not atomic since only a single instance of swap_fn run at a time */
 static int monitor_eff;
@@ -71,6 +81,8 @@ static int monitor_eff;
 struct selected_task {
 	struct task_struct *p;
 	int tasksize;
+	/* tasksize weighted by how cold reclaimed pages of the task stay */
+	int score;
 	short oom_score_adj;
 };
 
@@ -80,11 +92,47 @@ int selected_cmp(const void *a, const void *b)
 	const struct selected_task *y = b;
 	int ret;
 
-	ret = x->tasksize < y->tasksize ? -1 : 1;
+	ret = x->score < y->score ? -1 : 1;
 
 	return ret;
 }
 
+/*
+ * Close the refault window of @mm once it expired and fold the fraction
+ * of reclaimed pages that were not faulted back in into the running cold
+ * estimate. Called with the task lock of the mm owner held.
+ */
+static void update_reclaim_eff(struct mm_struct *mm)
+{
+	unsigned long refaults;
+	unsigned int cold;
+
+	if (!mm->reclaim_nr ||
+	    time_before(jiffies, mm->reclaim_stamp +
+			msecs_to_jiffies(refault_win_ms)))
+		return;
+
+	refaults = atomic_long_read(&mm->swap_refaults) -
+			mm->reclaim_refault_base;
+	cold = 100 - min(refaults * 100 / mm->reclaim_nr, 100UL);
+
+	mm->reclaim_cold_pct = (mm->reclaim_cold_pct + cold) / 2;
+	mm->reclaim_nr = 0;
+}
+
+static void account_reclaim(struct mm_struct *mm, int nr_reclaimed)
+{
+	if (nr_reclaimed <= 0)
+		return;
+
+	/* Start a new refault window */
+	if (!mm->reclaim_nr) {
+		mm->reclaim_refault_base = atomic_long_read(&mm->swap_refaults);
+		mm->reclaim_stamp = jiffies;
+	}
+	mm->reclaim_nr += nr_reclaimed;
+}
+
 static int test_task_flag(struct task_struct *p, int flag)
 {
 	struct task_struct *t = p;
@@ -110,11 +158,13 @@ static void swap_fn(struct work_struct *work)
 	struct reclaim_param rp;
 
 	/* Pick the best MAX_SWAP_TASKS tasks in terms of anon size */
-	struct selected_task selected[MAX_SWAP_TASKS] = {{0, 0, 0},};
+	struct selected_task selected[MAX_SWAP_TASKS] = {{0, 0, 0, 0},};
 	int si = 0;
 	int i;
 	int tasksize;
+	int score;
 	int total_sz = 0;
+	int total_score = 0;
 	int total_scan = 0;
 	int total_reclaimed = 0;
 	int nr_to_reclaim;
@@ -142,30 +192,37 @@ static void swap_fn(struct work_struct *work)
 		}
 
 		tasksize = get_mm_counter(p->mm, MM_ANONPAGES);
+		update_reclaim_eff(p->mm);
+		score = div_u64((u64)max(tasksize, 0) * p->mm->reclaim_cold_pct,
+				100);
 		task_unlock(p);
 
-		if (tasksize <= 0)
+		if (tasksize <= 0 || score <= 0)
 			continue;
 
 		if (si == MAX_SWAP_TASKS) {
 			sort(&selected[0], MAX_SWAP_TASKS,
 					sizeof(struct selected_task),
 					&selected_cmp, NULL);
-			if (tasksize < selected[0].tasksize)
+			if (score < selected[0].score)
 				continue;
 			selected[0].p = p;
 			selected[0].oom_score_adj = oom_score_adj;
 			selected[0].tasksize = tasksize;
+			selected[0].score = score;
 		} else {
 			selected[si].p = p;
 			selected[si].oom_score_adj = oom_score_adj;
 			selected[si].tasksize = tasksize;
+			selected[si].score = score;
 			si++;
 		}
 	}
 
-	for (i = 0; i < si; i++)
+	for (i = 0; i < si; i++) {
 		total_sz += selected[i].tasksize;
+		total_score += selected[i].score;
+	}
 
 	/* Skip reclaim if total size is too less */
 	if (total_sz < SWAP_CLUSTER_MAX) {
@@ -180,13 +237,18 @@ static void swap_fn(struct work_struct *work)
 
 	while (si--) {
 		nr_to_reclaim =
-			(selected[si].tasksize * per_swap_size) / total_sz;
+			(selected[si].score * per_swap_size) / total_score;
 		/* scan atleast a page */
 		if (!nr_to_reclaim)
 			nr_to_reclaim = 1;
 
 		rp = reclaim_task_anon(selected[si].p, nr_to_reclaim);
 
+		task_lock(selected[si].p);
+		if (selected[si].p->mm)
+			account_reclaim(selected[si].p->mm, rp.nr_reclaimed);
+		task_unlock(selected[si].p);
+
 		trace_process_reclaim(selected[si].tasksize,
 				selected[si].oom_score_adj, rp.nr_scanned,
 				rp.nr_reclaimed, per_swap_size, total_sz,
@@ -280,6 +280,92 @@ static unsigned long get_next_ra_size(struct file_ra_state *ra,
 	return min(newsize, max);
 }
 
+/*
+ * Adaptive readahead window.
+ *
+ * A window that is pushed forward by sequential access has been consumed
+ * and is counted as hit. When a window is given up for an unrelated one,
+ * the pages of it that were used (referenced, active or mapped) are
+ * counted as hits and the remainder, including pages that were already
+ * evicted again, as misses. Once about two windows worth of samples have
+ * been gathered, ra->ra_pages is halved if most readahead was wasted and
+ * doubled if nearly all of it was used while the window was saturated,
+ * within [bdi->ra_pages / 8, bdi->ra_pages * 4].
+ */
+#define RA_ADAPT_MIN_SHIFT	3
+#define RA_ADAPT_MAX_SHIFT	2
+
+static void ra_account(struct backing_dev_info *bdi, struct file_ra_state *ra,
+		       unsigned long hit, unsigned long miss)
+{
+	unsigned long base = bdi->ra_pages;
+	unsigned long total, new_pages = ra->ra_pages;
+
+	atomic_long_add(hit, &bdi->ra_hit_pages);
+	atomic_long_add(miss, &bdi->ra_miss_pages);
+
+	if (!bdi->ra_adaptive || !base || !ra->ra_pages)
+		return;
+
+	ra->hit_pages += hit;
+	ra->miss_pages += miss;
+	total = ra->hit_pages + ra->miss_pages;
+	if (total < 2 * ra->ra_pages)
+		return;
+
+	if (ra->miss_pages > ra->hit_pages)
+		new_pages = max_t(unsigned long, ra->ra_pages / 2,
+				  max(base >> RA_ADAPT_MIN_SHIFT, 1UL));
+	else if (ra->miss_pages * 8 < total && ra->size >= ra->ra_pages)
+		new_pages = min(2UL * ra->ra_pages, base << RA_ADAPT_MAX_SHIFT);
+
+	if (new_pages > ra->ra_pages)
+		atomic_long_inc(&bdi->ra_grown);
+	else if (new_pages < ra->ra_pages)
+		atomic_long_inc(&bdi->ra_shrunk);
+
+	ra->ra_pages = new_pages;
+	ra->hit_pages = 0;
+	ra->miss_pages = 0;
+}
+
+/*
+ * Account the current readahead window of @ra before it is replaced by
+ * one that does not continue it.
+ */
+void ra_retire_window(struct address_space *mapping, struct file_ra_state *ra)
+{
+	pgoff_t index = ra->start, end = ra->start + ra->size;
+	unsigned long used = 0;
+	struct pagevec pvec;
+	unsigned int i, nr;
+
+	if (!ra->size)
+		return;
+
+	pagevec_init(&pvec, 0);
+	while (index < end) {
+		nr = pagevec_lookup(&pvec, mapping, index,
+				    min_t(pgoff_t, end - index, PAGEVEC_SIZE));
+		if (!nr)
+			break;
+
+		for (i = 0; i < nr; i++) {
+			struct page *page = pvec.pages[i];
+
+			if (page->index >= end)
+				break;
+			if (PageReferenced(page) || PageActive(page) ||
+			    page_mapped(page))
+				used++;
+		}
+		index = pvec.pages[nr - 1]->index + 1;
+		pagevec_release(&pvec);
+	}
+
+	ra_account(inode_to_bdi(mapping->host), ra, used, ra->size - used);
+}
+
 /*
  * On-demand readahead design.
  *
@@ -364,6 +450,7 @@ static int try_context_readahead(struct address_space *mapping,
 	if (size >= offset)
 		size *= 2;
 
+	ra_retire_window(mapping, ra);
 	ra->start = offset;
 	ra->size = min(size + req_size, max);
 	ra->async_size = 1;
@@ -404,6 +491,7 @@ ondemand_readahead(struct address_space *mapping,
 	 */
 	if ((offset == (ra->start + ra->size - ra->async_size) ||
 	     offset == (ra->start + ra->size))) {
+		ra_account(bdi, ra, ra->size, 0);
 		ra->start += ra->size;
 		ra->size = get_next_ra_size(ra, max_pages);
 		ra->async_size = ra->size;
@@ -463,6 +551,7 @@ ondemand_readahead(struct address_space *mapping,
 	return __do_page_cache_readahead(mapping, filp, offset, req_size, 0);
 
 initial_readahead:
+	ra_retire_window(mapping, ra);
 	ra->start = offset;
 	ra->size = get_init_ra_size(req_size, max_pages);
 	ra->async_size = ra->size > req_size ? ra->size - req_size : ra->size;
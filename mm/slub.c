@@ -2728,6 +2728,7 @@ static __always_inline void *slab_alloc_node(struct kmem_cache *s,
 	if (unlikely(!object || !node_match(page, node))) {
 		object = __slab_alloc(s, gfpflags, node, addr, c);
 		stat(s, ALLOC_SLOWPATH);
+		this_cpu_inc(s->cpu_slab->slow_allocs);
 	} else {
 		void *next_object = get_freepointer_safe(s, object);
 
@@ -2843,6 +2844,7 @@ static void __slab_free(struct kmem_cache *s, struct page *page,
 	unsigned long uninitialized_var(flags);
 
 	stat(s, FREE_SLOWPATH);
+	this_cpu_inc(s->cpu_slab->slow_frees);
 
 	if (kmem_cache_debug(s) &&
 	    !free_debug_processing(s, page, head, tail, cnt, addr))
@@ -3651,6 +3653,7 @@ static int kmem_cache_open(struct kmem_cache *s, unsigned long flags)
 		s->cpu_partial = 13;
 	else
 		s->cpu_partial = 30;
+	s->cpu_partial_base = s->cpu_partial;
 
 #ifdef CONFIG_NUMA
 	s->remote_node_defrag_ratio = 1000;
@@ -3780,6 +3783,77 @@ static int __init setup_slub_min_objects(char *str)
 
 __setup("slub_min_objects=", setup_slub_min_objects);
 
+/*
+ * Adaptive per cpu partial sizing: every slub_adaptive_partial ms, caches
+ * that took the allocation slowpath at least SLUB_PARTIAL_HOT_RATE times per
+ * second double their cpu_partial, up to SLUB_PARTIAL_MAX_SCALE times its
+ * base value, while caches that did not take it at all halve it, down to
+ * half the base value. 0, the default, keeps cpu_partial fixed.
+ */
+#define SLUB_PARTIAL_HOT_RATE	1000
+#define SLUB_PARTIAL_MAX_SCALE	8
+
+static unsigned int slub_adaptive_partial;
+
+static int __init setup_slub_adaptive_partial(char *str)
+{
+	get_option(&str, &slub_adaptive_partial);
+
+	return 1;
+}
+
+__setup("slub_adaptive_partial=", setup_slub_adaptive_partial);
+
+static void slub_adapt_partial_fn(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(slub_adapt_partial_work, slub_adapt_partial_fn);
+
+static void slub_adapt_partial(struct kmem_cache *s)
+{
+	unsigned int allocs = 0, delta, rate, objects;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		allocs += per_cpu_ptr(s->cpu_slab, cpu)->slow_allocs;
+
+	delta = allocs - s->slow_allocs_last;
+	s->slow_allocs_last = allocs;
+
+	if (!kmem_cache_has_cpu_partial(s) || !s->cpu_partial_base)
+		return;
+
+	rate = div_u64((u64)delta * MSEC_PER_SEC, slub_adaptive_partial);
+	objects = s->cpu_partial;
+	if (rate >= SLUB_PARTIAL_HOT_RATE)
+		objects = min(objects * 2,
+			      s->cpu_partial_base * SLUB_PARTIAL_MAX_SCALE);
+	else if (!delta)
+		objects = max(objects / 2, s->cpu_partial_base / 2);
+
+	WRITE_ONCE(s->cpu_partial, objects);
+}
+
+static void slub_adapt_partial_fn(struct work_struct *work)
+{
+	struct kmem_cache *s;
+
+	mutex_lock(&slab_mutex);
+	list_for_each_entry(s, &slab_caches, list)
+		slub_adapt_partial(s);
+	mutex_unlock(&slab_mutex);
+
+	schedule_delayed_work(&slub_adapt_partial_work,
+			      msecs_to_jiffies(slub_adaptive_partial));
+}
+
+static int __init slub_adapt_partial_init(void)
+{
+	if (slub_adaptive_partial)
+		schedule_delayed_work(&slub_adapt_partial_work,
+				      msecs_to_jiffies(slub_adaptive_partial));
+	return 0;
+}
+late_initcall(slub_adapt_partial_init);
+
 void *__kmalloc(size_t size, gfp_t flags)
 {
 	struct kmem_cache *s;
@@ -4967,11 +5041,36 @@ static ssize_t cpu_partial_store(struct kmem_cache *s, const char *buf,
 		return -EINVAL;
 
 	s->cpu_partial = objects;
+	s->cpu_partial_base = objects;
 	flush_all(s);
 	return length;
 }
 SLAB_ATTR(cpu_partial);
 
+static ssize_t slow_allocs_show(struct kmem_cache *s, char *buf)
+{
+	unsigned long sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		sum += per_cpu_ptr(s->cpu_slab, cpu)->slow_allocs;
+
+	return sprintf(buf, "%lu\n", sum);
+}
+SLAB_ATTR_RO(slow_allocs);
+
+static ssize_t slow_frees_show(struct kmem_cache *s, char *buf)
+{
+	unsigned long sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		sum += per_cpu_ptr(s->cpu_slab, cpu)->slow_frees;
+
+	return sprintf(buf, "%lu\n", sum);
+}
+SLAB_ATTR_RO(slow_frees);
+
 static ssize_t ctor_show(struct kmem_cache *s, char *buf)
 {
 	if (!s->ctor)
@@ -5382,6 +5481,8 @@ static struct attribute *slab_attrs[] = {
 	&order_attr.attr,
 	&min_partial_attr.attr,
 	&cpu_partial_attr.attr,
+	&slow_allocs_attr.attr,
+	&slow_frees_attr.attr,
 	&objects_attr.attr,
 	&objects_partial_attr.attr,
 	&partial_attr.attr,
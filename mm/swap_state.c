@@ -412,11 +412,17 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 }
 
 #ifdef CONFIG_SWAP_ENABLE_READAHEAD
-static unsigned long swapin_nr_pages(unsigned long offset)
+/*
+ * Size the next readahead window from the readahead hits since the last
+ * one. @offset is a swap offset or, for VMA readahead, a virtual page
+ * number; @prev_offset and @last_readahead_pages keep the state of the
+ * respective flavour.
+ */
+static unsigned long __swapin_nr_pages(unsigned long offset,
+				       unsigned long *prev_offset,
+				       atomic_t *last_readahead_pages)
 {
-	static unsigned long prev_offset;
 	unsigned int pages, max_pages, last_ra;
-	static atomic_t last_readahead_pages;
 
 	max_pages = 1 << READ_ONCE(page_cluster);
 	if (max_pages <= 1)
@@ -434,9 +440,9 @@ static unsigned long swapin_nr_pages(unsigned long offset)
 		 * stuck here forever, so check for an adjacent offset instead
 		 * (and don't even bother to check whether swap type is same).
 		 */
-		if (offset != prev_offset + 1 && offset != prev_offset - 1)
+		if (offset != *prev_offset + 1 && offset != *prev_offset - 1)
 			pages = 1;
-		prev_offset = offset;
+		*prev_offset = offset;
 	} else {
 		unsigned int roundup = 4;
 		while (roundup < pages)
@@ -448,13 +454,21 @@ static unsigned long swapin_nr_pages(unsigned long offset)
 		pages = max_pages;
 
 	/* Don't shrink readahead too fast */
-	last_ra = atomic_read(&last_readahead_pages) / 2;
+	last_ra = atomic_read(last_readahead_pages) / 2;
 	if (pages < last_ra)
 		pages = last_ra;
-	atomic_set(&last_readahead_pages, pages);
+	atomic_set(last_readahead_pages, pages);
 
 	return pages;
 }
+
+static unsigned long swapin_nr_pages(unsigned long offset)
+{
+	static unsigned long prev_offset;
+	static atomic_t last_readahead_pages;
+
+	return __swapin_nr_pages(offset, &prev_offset, &last_readahead_pages);
+}
 #endif
 
 /**
@@ -519,3 +533,96 @@ struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 #endif
 	return read_swap_cache_async(entry, gfp_mask, vma, addr);
 }
+
+/* vm.swap_vma_readahead: read around the fault address on fast swap */
+int sysctl_swap_vma_readahead;
+
+#define SWAP_VMA_RA_MAX	16
+
+/**
+ * swapin_readahead_vma - swap in a page and its virtual neighbours
+ * @entry: swap entry of the faulting pte
+ * @gfp_mask: memory allocation flags
+ * @fe: fault being handled, with the pte unmapped
+ *
+ * On fast swap devices such as zram, swap slots next to each other are
+ * usually unrelated, so swapin_readahead() does not read ahead at all and
+ * an app coming back from swap takes one major fault per page. When
+ * vm.swap_vma_readahead is set, read the faulting page and then the
+ * swapped out ptes around it in the same VMA and page table instead, in
+ * a window sized by the readahead hits like the swap offset one.
+ *
+ * Speculative faults and slow swap fall back to swapin_readahead().
+ */
+struct page *swapin_readahead_vma(swp_entry_t entry, gfp_t gfp_mask,
+				  struct fault_env *fe)
+{
+	struct vm_area_struct *vma = fe->vma;
+#ifdef CONFIG_SWAP_ENABLE_READAHEAD
+	static unsigned long prev_vpn;
+	static atomic_t last_readahead_pages;
+	swp_entry_t entries[SWAP_VMA_RA_MAX];
+	unsigned long addrs[SWAP_VMA_RA_MAX];
+	unsigned long fault_addr = fe->address & PAGE_MASK;
+	unsigned long addr, start, end, pmd_start, window;
+	struct blk_plug plug;
+	struct page *page, *ra_page;
+	spinlock_t *ptl;
+	pte_t *orig_pte, *pte;
+	int i, nr = 0;
+
+	if (!READ_ONCE(sysctl_swap_vma_readahead) || !is_swap_fast(entry) ||
+	    (fe->flags & FAULT_FLAG_SPECULATIVE))
+		return swapin_readahead(entry, gfp_mask, vma, fe->address);
+
+	page = read_swap_cache_async(entry, gfp_mask, vma, fe->address);
+	if (!page)
+		return NULL;
+
+	window = min_t(unsigned long, SWAP_VMA_RA_MAX,
+		       __swapin_nr_pages(fault_addr >> PAGE_SHIFT, &prev_vpn,
+					 &last_readahead_pages));
+	if (window <= 1)
+		return page;
+
+	/* An aligned window, clipped to the VMA and to this page table */
+	pmd_start = fault_addr & PMD_MASK;
+	addr = fault_addr & ~(window * PAGE_SIZE - 1);
+	start = max3(addr, vma->vm_start, pmd_start);
+	end = min3(addr + window * PAGE_SIZE, vma->vm_end,
+		   pmd_start + PMD_SIZE);
+
+	orig_pte = pte = pte_offset_map_lock(vma->vm_mm, fe->pmd, start, &ptl);
+	for (addr = start; addr < end; addr += PAGE_SIZE, pte++) {
+		pte_t ptent = *pte;
+		swp_entry_t ent;
+
+		if (addr == fault_addr || pte_none(ptent) ||
+		    pte_present(ptent))
+			continue;
+		ent = pte_to_swp_entry(ptent);
+		if (unlikely(non_swap_entry(ent)))
+			continue;
+		entries[nr] = ent;
+		addrs[nr++] = addr;
+	}
+	pte_unmap_unlock(orig_pte, ptl);
+
+	/* The entries may have been freed since, which is caught below */
+	blk_start_plug(&plug);
+	for (i = 0; i < nr; i++) {
+		ra_page = read_swap_cache_async(entries[i], gfp_mask, vma,
+						addrs[i]);
+		if (!ra_page)
+			continue;
+		SetPageReadahead(ra_page);
+		put_page(ra_page);
+	}
+	blk_finish_plug(&plug);
+
+	lru_add_drain();	/* Push any new pages onto the LRU now */
+	return page;
+#else
+	return read_swap_cache_async(entry, gfp_mask, vma, fe->address);
+#endif
+}
@@ -2254,6 +2254,17 @@ static void get_scan_count(struct lruvec *lruvec, struct mem_cgroup *memcg,
 		goto out;
 	}
 
+	/*
+	 * A memcg can ask for its page cache, e.g. the code of the
+	 * foreground app, to be left alone as long as there is anon to
+	 * swap instead. Like memory.low, this gives way once direct reclaim
+	 * is about to fail.
+	 */
+	if (mem_cgroup_protect_file(memcg) && !sc->may_thrash) {
+		scan_balance = SCAN_ANON;
+		goto out;
+	}
+
 	/*
 	 * Prevent the reclaimer from falling into the cache trap: as
 	 * cache pages start out inactive, every cache fault will tip
@@ -3551,17 +3562,41 @@ static void kswapd_try_to_sleep(pg_data_t *pgdat, int alloc_order, int reclaim_o
  * If there are applications that are active memory-allocators
  * (most normal use), this basically shouldn't matter.
  */
-static int kswapd(void *p)
+/*
+ * Number of kswapd threads per node. The additional threads run the same
+ * loop as the primary one and are woken together with it. Concurrent
+ * balance_pgdat() passes split the work between them: the memcg iterator
+ * hands each reclaimer a different memcg for a given priority, and LRU
+ * pages are isolated in SWAP_CLUSTER_MAX batches under the lru_lock.
+ */
+int kswapd_threads = 1;
+
+/*
+ * Additional kswapd threads stay off the big cores, which are better left
+ * to the tasks that are allocating.
+ */
+static const struct cpumask *kswapd_extra_cpumask(pg_data_t *pgdat)
+{
+	const struct cpumask *mask = cpumask_of_node(pgdat->node_id);
+
+	if (cpumask_intersects(cpu_lp_mask, mask) &&
+	    cpumask_intersects(cpu_lp_mask, cpu_online_mask))
+		return cpu_lp_mask;
+
+	return mask;
+}
+
+static int __kswapd(pg_data_t *pgdat, bool extra)
 {
 	unsigned int alloc_order, reclaim_order;
 	unsigned int classzone_idx = MAX_NR_ZONES - 1;
-	pg_data_t *pgdat = (pg_data_t*)p;
 	struct task_struct *tsk = current;
 
 	struct reclaim_state reclaim_state = {
 		.reclaimed_slab = 0,
 	};
-	const struct cpumask *cpumask = cpumask_of_node(pgdat->node_id);
+	const struct cpumask *cpumask = extra ? kswapd_extra_cpumask(pgdat) :
+					cpumask_of_node(pgdat->node_id);
 
 	lockdep_set_current_reclaim_state(GFP_KERNEL);
 
@@ -3584,8 +3619,10 @@ static int kswapd(void *p)
 	tsk->flags |= PF_MEMALLOC | PF_SWAPWRITE | PF_KSWAPD;
 	set_freezable();
 
-	pgdat->kswapd_order = 0;
-	pgdat->kswapd_classzone_idx = MAX_NR_ZONES;
+	if (!extra) {
+		pgdat->kswapd_order = 0;
+		pgdat->kswapd_classzone_idx = MAX_NR_ZONES;
+	}
 	for ( ; ; ) {
 		bool ret;
 
@@ -3596,11 +3633,20 @@ static int kswapd(void *p)
 		kswapd_try_to_sleep(pgdat, alloc_order, reclaim_order,
 					classzone_idx);
 
-		/* Read the new order and classzone_idx */
+		/*
+		 * Read the new order and classzone_idx. Only the primary
+		 * thread consumes the request; additional threads may find
+		 * it already reset and then reclaim for all zones.
+		 */
 		alloc_order = reclaim_order = pgdat->kswapd_order;
-		classzone_idx = kswapd_classzone_idx(pgdat, 0);
-		pgdat->kswapd_order = 0;
-		pgdat->kswapd_classzone_idx = MAX_NR_ZONES;
+		if (!extra) {
+			classzone_idx = kswapd_classzone_idx(pgdat, 0);
+			pgdat->kswapd_order = 0;
+			pgdat->kswapd_classzone_idx = MAX_NR_ZONES;
+		} else {
+			classzone_idx = kswapd_classzone_idx(pgdat,
+							     MAX_NR_ZONES - 1);
+		}
 
 		ret = try_to_freeze();
 		if (kthread_should_stop())
@@ -3635,6 +3681,16 @@ static int kswapd(void *p)
 	return 0;
 }
 
+static int kswapd(void *p)
+{
+	return __kswapd(p, false);
+}
+
+static int kswapd_extra_thread(void *p)
+{
+	return __kswapd(p, true);
+}
+
 /*
  * A zone is low on free memory, so wake its kswapd task to service it.
  */
@@ -3723,14 +3779,75 @@ static int cpu_callback(struct notifier_block *nfb, unsigned long action,
 
 			mask = cpumask_of_node(pgdat->node_id);
 
-			if (cpumask_any_and(cpu_online_mask, mask) < nr_cpu_ids)
+			if (cpumask_any_and(cpu_online_mask, mask) < nr_cpu_ids) {
+				int i;
+
 				/* One of our CPUs online: restore mask */
 				set_cpus_allowed_ptr(pgdat->kswapd, mask);
+				for (i = 0; i < MAX_KSWAPD_THREADS - 1; i++)
+					if (pgdat->kswapd_extra[i])
+						set_cpus_allowed_ptr(
+							pgdat->kswapd_extra[i],
+							kswapd_extra_cpumask(pgdat));
+			}
 		}
 	}
 	return NOTIFY_OK;
 }
 
+/*
+ * Start or stop additional kswapd threads of a node to match
+ * kswapd_threads. Caller must hold mem_hotplug_begin/end() or
+ * get/put_online_mems().
+ */
+static void kswapd_update_extra(int nid)
+{
+	pg_data_t *pgdat = NODE_DATA(nid);
+	int nr_extra = READ_ONCE(kswapd_threads) - 1;
+	struct task_struct *tsk;
+	int i;
+
+	for (i = 0; i < MAX_KSWAPD_THREADS - 1; i++) {
+		if (i < nr_extra && !pgdat->kswapd_extra[i]) {
+			tsk = kthread_run(kswapd_extra_thread, pgdat,
+					  "kswapd%d:%d", nid, i + 1);
+			if (IS_ERR(tsk)) {
+				pr_err("Failed to start kswapd%d:%d\n",
+				       nid, i + 1);
+				break;
+			}
+			pgdat->kswapd_extra[i] = tsk;
+		} else if (i >= nr_extra && pgdat->kswapd_extra[i]) {
+			kthread_stop(pgdat->kswapd_extra[i]);
+			pgdat->kswapd_extra[i] = NULL;
+		}
+	}
+}
+
+static DEFINE_MUTEX(kswapd_threads_mutex);
+
+int kswapd_threads_sysctl_handler(struct ctl_table *table, int write,
+				  void __user *buffer, size_t *length,
+				  loff_t *ppos)
+{
+	int nid, ret;
+
+	mutex_lock(&kswapd_threads_mutex);
+	ret = proc_dointvec_minmax(table, write, buffer, length, ppos);
+	if (ret || !write)
+		goto out;
+
+	get_online_mems();
+	for_each_node_state(nid, N_MEMORY)
+		if (NODE_DATA(nid)->kswapd)
+			kswapd_update_extra(nid);
+	put_online_mems();
+out:
+	mutex_unlock(&kswapd_threads_mutex);
+
+	return ret;
+}
+
 /*
  * This kswapd start function will be called by init and node-hot-add.
  * On node-hot-add, kswapd will moved to proper cpus if cpus are hot-added.
@@ -3750,7 +3867,10 @@ int kswapd_run(int nid)
 		pr_err("Failed to start kswapd on node %d\n", nid);
 		ret = PTR_ERR(pgdat->kswapd);
 		pgdat->kswapd = NULL;
+		return ret;
 	}
+
+	kswapd_update_extra(nid);
 	return ret;
 }
 
@@ -3761,6 +3881,14 @@ int kswapd_run(int nid)
 void kswapd_stop(int nid)
 {
 	struct task_struct *kswapd = NODE_DATA(nid)->kswapd;
+	int i;
+
+	for (i = 0; i < MAX_KSWAPD_THREADS - 1; i++) {
+		if (NODE_DATA(nid)->kswapd_extra[i]) {
+			kthread_stop(NODE_DATA(nid)->kswapd_extra[i]);
+			NODE_DATA(nid)->kswapd_extra[i] = NULL;
+		}
+	}
 
 	if (kswapd) {
 		kthread_stop(kswapd);
@@ -27,6 +27,7 @@
 #include <linux/mm_inline.h>
 #include <linux/page_ext.h>
 #include <linux/page_owner.h>
+#include <linux/kstats.h>
 
 #include "internal.h"
 
@@ -1475,10 +1476,34 @@ enum writeback_stat_item {
 	NR_VM_WRITEBACK_STAT_ITEMS,
 };
 
+/* Fills @v with the values of vmstat_text[] */
+static void vmstat_fill(unsigned long *v)
+{
+	int i;
+
+	for (i = 0; i < NR_VM_ZONE_STAT_ITEMS; i++)
+		v[i] = global_page_state(i);
+	v += NR_VM_ZONE_STAT_ITEMS;
+
+	for (i = 0; i < NR_VM_NODE_STAT_ITEMS; i++)
+		v[i] = global_node_page_state(i);
+	v += NR_VM_NODE_STAT_ITEMS;
+
+	global_dirty_limits(v + NR_DIRTY_BG_THRESHOLD,
+			    v + NR_DIRTY_THRESHOLD);
+	v += NR_VM_WRITEBACK_STAT_ITEMS;
+
+#ifdef CONFIG_VM_EVENT_COUNTERS
+	all_vm_events(v);
+	v[PGPGIN] /= 2;		/* sectors -> kbytes */
+	v[PGPGOUT] /= 2;
+#endif
+}
+
 static void *vmstat_start(struct seq_file *m, loff_t *pos)
 {
 	unsigned long *v;
-	int i, stat_items_size;
+	int stat_items_size;
 
 	if (*pos >= ARRAY_SIZE(vmstat_text))
 		return NULL;
@@ -1494,26 +1519,33 @@ static void *vmstat_start(struct seq_file *m, loff_t *pos)
 	m->private = v;
 	if (!v)
 		return ERR_PTR(-ENOMEM);
-	for (i = 0; i < NR_VM_ZONE_STAT_ITEMS; i++)
-		v[i] = global_page_state(i);
-	v += NR_VM_ZONE_STAT_ITEMS;
+	vmstat_fill(v);
+	return (unsigned long *)m->private + *pos;
+}
 
-	for (i = 0; i < NR_VM_NODE_STAT_ITEMS; i++)
-		v[i] = global_node_page_state(i);
-	v += NR_VM_NODE_STAT_ITEMS;
+#ifdef CONFIG_KSTATS
+static int vmstat_kstats_fill(void *buf, size_t max_len)
+{
+	unsigned long *v = buf;
+	u64 *out = buf;
+	int i;
 
-	global_dirty_limits(v + NR_DIRTY_BG_THRESHOLD,
-			    v + NR_DIRTY_THRESHOLD);
-	v += NR_VM_WRITEBACK_STAT_ITEMS;
+	vmstat_fill(v);
+	/* widen in place, from the end so nothing is overwritten unread */
+	for (i = ARRAY_SIZE(vmstat_text) - 1; i >= 0; i--)
+		out[i] = v[i];
 
-#ifdef CONFIG_VM_EVENT_COUNTERS
-	all_vm_events(v);
-	v[PGPGIN] /= 2;		/* sectors -> kbytes */
-	v[PGPGOUT] /= 2;
-#endif
-	return (unsigned long *)m->private + *pos;
+	return ARRAY_SIZE(vmstat_text) * sizeof(u64);
 }
 
+static struct kstats_source vmstat_kstats_source = {
+	.type		= KSTATS_TYPE_VMSTAT,
+	.version	= 1,
+	.max_len	= ARRAY_SIZE(vmstat_text) * sizeof(u64),
+	.fill		= vmstat_kstats_fill,
+};
+#endif
+
 static void *vmstat_next(struct seq_file *m, void *arg, loff_t *pos)
 {
 	(*pos)++;
@@ -1796,6 +1828,9 @@ static int __init setup_vmstat(void)
 	proc_create("pagetypeinfo", 0400, NULL, &pagetypeinfo_file_ops);
 	proc_create("vmstat", S_IRUGO, NULL, &proc_vmstat_file_operations);
 	proc_create("zoneinfo", S_IRUGO, NULL, &proc_zoneinfo_file_operations);
+#ifdef CONFIG_KSTATS
+	kstats_register_source(&vmstat_kstats_source);
+#endif
 #endif
 	return 0;
 }
@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Pool of pre-zeroed pages for anonymous faults.
+ *
+ * Every anonymous fault clears its page synchronously before mapping it,
+ * which is most of the cost of faulting in a freshly grown heap. This
+ * keeps a small pool of movable pages that a SCHED_IDLE kthread has
+ * already cleared while the system had nothing better to do, and hands
+ * them out from __alloc_zeroed_user_highpage() for movable allocations.
+ *
+ * The pool is refilled once it drops below half of zero_pool.pages, and
+ * only while free memory is comfortably above the reserves; its pages are
+ * given back to the page allocator by a shrinker under memory pressure.
+ */
+
+#define pr_fmt(fmt) "zero_pool: " fmt
+
+#include <linux/freezer.h>
+#include <linux/highmem.h>
+#include <linux/kthread.h>
+#include <linux/list.h>
+#include <linux/mm.h>
+#include <linux/moduleparam.h>
+#include <linux/sched.h>
+#include <linux/shrinker.h>
+#include <linux/spinlock.h>
+#include <linux/swap.h>
+#include <linux/vmstat.h>
+#include <linux/wait.h>
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "zero_pool."
+
+/* Target size of the pool, in pages; 0 disables it */
+static unsigned int pages = 512;
+module_param(pages, uint, 0644);
+
+static LIST_HEAD(zero_pool);
+static unsigned long zero_pool_count;
+static DEFINE_SPINLOCK(zero_pool_lock);
+static DECLARE_WAIT_QUEUE_HEAD(zero_pool_wait);
+static struct task_struct *zero_pool_task;
+
+static bool zero_pool_mem_ok(void)
+{
+	return global_page_state(NR_FREE_PAGES) >
+		2 * totalreserve_pages + READ_ONCE(pages);
+}
+
+static bool zero_pool_needs_refill(void)
+{
+	return READ_ONCE(zero_pool_count) < READ_ONCE(pages) / 2 &&
+		zero_pool_mem_ok();
+}
+
+/**
+ * zero_pool_get - take a pre-zeroed movable page out of the pool
+ *
+ * Returns NULL when the pool is empty, in which case the caller allocates
+ * and clears a page itself.
+ */
+struct page *zero_pool_get(void)
+{
+	struct page *page = NULL;
+
+	if (!READ_ONCE(zero_pool_count))
+		return NULL;
+
+	spin_lock(&zero_pool_lock);
+	if (!list_empty(&zero_pool)) {
+		page = list_first_entry(&zero_pool, struct page, lru);
+		list_del(&page->lru);
+		zero_pool_count--;
+	}
+	spin_unlock(&zero_pool_lock);
+
+	if (zero_pool_task && zero_pool_needs_refill())
+		wake_up(&zero_pool_wait);
+
+	return page;
+}
+
+static void zero_pool_refill(void)
+{
+	struct page *page;
+
+	while (READ_ONCE(zero_pool_count) < READ_ONCE(pages) &&
+	       zero_pool_mem_ok() && !kthread_should_stop()) {
+		page = alloc_page(GFP_HIGHUSER_MOVABLE | __GFP_NORETRY |
+				  __GFP_NOWARN);
+		if (!page)
+			break;
+
+		clear_highpage(page);
+
+		spin_lock(&zero_pool_lock);
+		list_add(&page->lru, &zero_pool);
+		zero_pool_count++;
+		spin_unlock(&zero_pool_lock);
+
+		cond_resched();
+	}
+}
+
+static int zero_pool_thread(void *data)
+{
+	struct sched_param param = { .sched_priority = 0 };
+
+	sched_setscheduler_nocheck(current, SCHED_IDLE, &param);
+	set_freezable();
+
+	while (!kthread_should_stop()) {
+		wait_event_freezable(zero_pool_wait,
+				     zero_pool_needs_refill() ||
+				     kthread_should_stop());
+		zero_pool_refill();
+	}
+
+	return 0;
+}
+
+static unsigned long zero_pool_shrink_count(struct shrinker *shrink,
+					    struct shrink_control *sc)
+{
+	return READ_ONCE(zero_pool_count);
+}
+
+static unsigned long zero_pool_shrink_scan(struct shrinker *shrink,
+					   struct shrink_control *sc)
+{
+	unsigned long freed = 0;
+	struct page *page;
+	LIST_HEAD(list);
+
+	spin_lock(&zero_pool_lock);
+	while (freed < sc->nr_to_scan && !list_empty(&zero_pool)) {
+		page = list_first_entry(&zero_pool, struct page, lru);
+		list_move(&page->lru, &list);
+		zero_pool_count--;
+		freed++;
+	}
+	spin_unlock(&zero_pool_lock);
+
+	while (!list_empty(&list)) {
+		page = list_first_entry(&list, struct page, lru);
+		list_del(&page->lru);
+		__free_page(page);
+	}
+
+	return freed ? freed : SHRINK_STOP;
+}
+
+static struct shrinker zero_pool_shrinker = {
+	.count_objects = zero_pool_shrink_count,
+	.scan_objects = zero_pool_shrink_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
+static int __init zero_pool_init(void)
+{
+	struct task_struct *task;
+	int ret;
+
+	ret = register_shrinker(&zero_pool_shrinker);
+	if (ret)
+		return ret;
+
+	task = kthread_run(zero_pool_thread, NULL, "kzeropoold");
+	if (IS_ERR(task)) {
+		pr_err("failed to start kzeropoold\n");
+		unregister_shrinker(&zero_pool_shrinker);
+		return PTR_ERR(task);
+	}
+
+	zero_pool_task = task;
+	return 0;
+}
+late_initcall(zero_pool_init);
@@ -55,6 +55,7 @@
 #include <linux/wait.h>
 #include <linux/pagemap.h>
 #include <linux/fs.h>
+#include <linux/sort.h>
 
 #define ZSPAGE_MAGIC	0x58
 
@@ -209,6 +210,11 @@ struct size_class {
 
 	unsigned int index;
 	struct zs_size_stat stats;
+#ifdef CONFIG_ZSMALLOC_PCP_CACHE
+	/* Per-cpu cache of allocated objects, NULL for uncached classes */
+	struct zs_mag __percpu *mag;
+	unsigned int mag_limit;
+#endif
 };
 
 /* huge object: pages_per_zspage == 1 && maxobj_per_zspage == 1 */
@@ -247,6 +253,19 @@ struct link_free {
 	};
 };
 
+/* Upper bound of workers a parallel compaction pass is spread across */
+#define ZS_COMPACT_MAX_WORKERS	4
+
+struct zs_compact_target {
+	struct size_class *class;
+	unsigned long freeable;
+};
+
+struct zs_compact_worker {
+	struct work_struct work;
+	struct zs_pool *pool;
+};
+
 struct zs_pool {
 	const char *name;
 
@@ -261,6 +280,14 @@ struct zs_pool {
 	/* Compact classes */
 	struct shrinker shrinker;
 
+	/* Parallel compaction pass, serialized by compact_lock */
+	struct mutex compact_lock;
+	struct zs_compact_worker compact_workers[ZS_COMPACT_MAX_WORKERS];
+	struct zs_compact_target compact_targets[ZS_SIZE_CLASSES];
+	int nr_compact_targets;
+	atomic_t compact_next;
+	atomic_long_t compact_freed;
+
 #ifdef CONFIG_ZSMALLOC_STAT
 	struct dentry *stat_dentry;
 #endif
@@ -1518,6 +1545,247 @@ static unsigned long obj_malloc(struct size_class *class,
 }
 
 
+#ifdef CONFIG_ZSMALLOC_PCP_CACHE
+/*
+ * Per-cpu object caches ("magazines").
+ *
+ * During swap-out bursts kswapd and direct reclaimers all allocate from the
+ * same few size classes and contend on class->lock. Each non-huge class
+ * therefore keeps a small per-cpu stack of objects that are allocated as
+ * far as the class is concerned, complete with handle. zs_malloc() pops
+ * from it, zs_free() pushes to it, and the class lock is only taken to
+ * refill or flush ZS_MAG_BATCH objects at a time. A cache holds at most
+ * ZS_MAG_BYTES worth of objects. The caches are drained before compaction
+ * and thereby by the pool shrinker.
+ */
+#define ZS_MAG_SIZE	16
+#define ZS_MAG_BATCH	(ZS_MAG_SIZE / 2)
+#define ZS_MAG_BYTES	(2 * PAGE_SIZE)
+
+static void __zs_free(struct zs_pool *pool, unsigned long handle);
+
+struct zs_mag {
+	spinlock_t lock;
+	unsigned int count;
+	unsigned long handles[ZS_MAG_SIZE];
+};
+
+/* Handles reserved for a refill done under the class lock */
+struct zs_refill {
+	unsigned int nr_prepared;
+	unsigned int nr_filled;
+	unsigned long handles[ZS_MAG_BATCH];
+};
+
+static int zs_mag_init(struct size_class *class)
+{
+	int cpu;
+
+	/* A huge object takes a whole page, caching it buys nothing */
+	if (class->objs_per_zspage == 1 && class->pages_per_zspage == 1)
+		return 0;
+
+	class->mag = alloc_percpu(struct zs_mag);
+	if (!class->mag)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(class->mag, cpu)->lock);
+
+	class->mag_limit = clamp_t(unsigned int, ZS_MAG_BYTES / class->size,
+				   ZS_MAG_BATCH, ZS_MAG_SIZE);
+
+	return 0;
+}
+
+static void zs_mag_destroy(struct size_class *class)
+{
+	free_percpu(class->mag);
+	class->mag = NULL;
+}
+
+static unsigned long zs_mag_pop(struct size_class *class)
+{
+	unsigned long handle = 0;
+	unsigned long flags;
+	struct zs_mag *mag;
+
+	if (!class->mag)
+		return 0;
+
+	local_irq_save(flags);
+	mag = this_cpu_ptr(class->mag);
+	spin_lock(&mag->lock);
+	if (mag->count)
+		handle = mag->handles[--mag->count];
+	spin_unlock(&mag->lock);
+	local_irq_restore(flags);
+
+	return handle;
+}
+
+static struct size_class *zs_handle_class(struct zs_pool *pool,
+					  unsigned long handle)
+{
+	struct page *page;
+	unsigned int obj_idx;
+	int class_idx;
+	enum fullness_group fullness;
+
+	/* Pin the object so that migration cannot move it under us */
+	pin_tag(handle);
+	obj_to_location(handle_to_obj(handle), &page, &obj_idx);
+	get_zspage_mapping(get_zspage(page), &class_idx, &fullness);
+	unpin_tag(handle);
+
+	return pool->size_class[class_idx];
+}
+
+/*
+ * Try to keep the freed object in the per-cpu cache of its class. If the
+ * cache is full, ZS_MAG_BATCH cached objects are flushed back to the class
+ * to make room.
+ */
+static bool zs_mag_push(struct zs_pool *pool, unsigned long handle)
+{
+	struct size_class *class = zs_handle_class(pool, handle);
+	unsigned long flush[ZS_MAG_BATCH];
+	unsigned int nr_flush = 0;
+	unsigned long flags;
+	struct zs_mag *mag;
+	int i;
+
+	if (!class->mag)
+		return false;
+
+	local_irq_save(flags);
+	mag = this_cpu_ptr(class->mag);
+	spin_lock(&mag->lock);
+	if (mag->count >= class->mag_limit) {
+		nr_flush = min_t(unsigned int, ZS_MAG_BATCH, mag->count);
+		mag->count -= nr_flush;
+		memcpy(flush, &mag->handles[mag->count],
+		       nr_flush * sizeof(flush[0]));
+	}
+	mag->handles[mag->count++] = handle;
+	spin_unlock(&mag->lock);
+	local_irq_restore(flags);
+
+	for (i = 0; i < nr_flush; i++)
+		__zs_free(pool, flush[i]);
+
+	return true;
+}
+
+static void zs_refill_prepare(struct zs_pool *pool, struct size_class *class,
+			      struct zs_refill *refill, gfp_t gfp)
+{
+	refill->nr_prepared = 0;
+	refill->nr_filled = 0;
+
+	if (!class->mag)
+		return;
+
+	/* Leave room in the cache for the objects being refilled */
+	while (refill->nr_prepared < ZS_MAG_BATCH - 1) {
+		unsigned long handle;
+
+		handle = cache_alloc_handle(pool, gfp | __GFP_NOWARN);
+		if (!handle)
+			break;
+		refill->handles[refill->nr_prepared++] = handle;
+	}
+}
+
+/* Allocate prepared objects from zspages that already exist */
+static void zs_refill_locked(struct size_class *class,
+			     struct zs_refill *refill)
+{
+	while (refill->nr_filled < refill->nr_prepared) {
+		unsigned long handle = refill->handles[refill->nr_filled];
+		struct zspage *zspage = find_get_zspage(class);
+
+		if (!zspage)
+			break;
+
+		record_obj(handle, obj_malloc(class, zspage, handle));
+		fix_fullness_group(class, zspage);
+		refill->nr_filled++;
+	}
+}
+
+static void zs_refill_finish(struct zs_pool *pool, struct size_class *class,
+			     struct zs_refill *refill)
+{
+	unsigned long flags;
+	struct zs_mag *mag;
+	unsigned int i = 0;
+
+	if (refill->nr_filled) {
+		local_irq_save(flags);
+		mag = this_cpu_ptr(class->mag);
+		spin_lock(&mag->lock);
+		while (i < refill->nr_filled && mag->count < class->mag_limit)
+			mag->handles[mag->count++] = refill->handles[i++];
+		spin_unlock(&mag->lock);
+		local_irq_restore(flags);
+	}
+
+	/* Objects that did not fit go back, unused handles are released */
+	for (; i < refill->nr_filled; i++)
+		__zs_free(pool, refill->handles[i]);
+	for (; i < refill->nr_prepared; i++)
+		cache_free_handle(pool, refill->handles[i]);
+}
+
+/* Return every cached object of @class to the class */
+static void zs_mag_drain(struct zs_pool *pool, struct size_class *class)
+{
+	unsigned long handles[ZS_MAG_SIZE];
+	unsigned int nr, i;
+	unsigned long flags;
+	struct zs_mag *mag;
+	int cpu;
+
+	if (!class->mag)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		mag = per_cpu_ptr(class->mag, cpu);
+
+		spin_lock_irqsave(&mag->lock, flags);
+		nr = mag->count;
+		memcpy(handles, mag->handles, nr * sizeof(handles[0]));
+		mag->count = 0;
+		spin_unlock_irqrestore(&mag->lock, flags);
+
+		for (i = 0; i < nr; i++)
+			__zs_free(pool, handles[i]);
+	}
+}
+#else
+struct zs_refill { };
+
+static inline int zs_mag_init(struct size_class *class) { return 0; }
+static inline void zs_mag_destroy(struct size_class *class) { }
+static inline unsigned long zs_mag_pop(struct size_class *class)
+{
+	return 0;
+}
+static inline bool zs_mag_push(struct zs_pool *pool, unsigned long handle)
+{
+	return false;
+}
+static inline void zs_refill_prepare(struct zs_pool *pool,
+		struct size_class *class, struct zs_refill *refill, gfp_t gfp) { }
+static inline void zs_refill_locked(struct size_class *class,
+		struct zs_refill *refill) { }
+static inline void zs_refill_finish(struct zs_pool *pool,
+		struct size_class *class, struct zs_refill *refill) { }
+static inline void zs_mag_drain(struct zs_pool *pool,
+		struct size_class *class) { }
+#endif /* CONFIG_ZSMALLOC_PCP_CACHE */
+
 /**
  * zs_malloc - Allocate block of given size from pool.
  * @pool: pool to allocate from
@@ -1534,17 +1802,24 @@ unsigned long zs_malloc(struct zs_pool *pool, size_t size, gfp_t gfp)
 	struct size_class *class;
 	enum fullness_group newfg;
 	struct zspage *zspage;
+	struct zs_refill refill;
 
 	if (unlikely(!size || size > ZS_MAX_ALLOC_SIZE))
 		return 0;
 
+	/* extra space in chunk to keep the handle */
+	size += ZS_HANDLE_SIZE;
+	class = pool->size_class[get_size_class_index(size)];
+
+	handle = zs_mag_pop(class);
+	if (handle)
+		return handle;
+
 	handle = cache_alloc_handle(pool, gfp);
 	if (!handle)
 		return 0;
 
-	/* extra space in chunk to keep the handle */
-	size += ZS_HANDLE_SIZE;
-	class = pool->size_class[get_size_class_index(size)];
+	zs_refill_prepare(pool, class, &refill, gfp);
 
 	spin_lock(&class->lock);
 	zspage = find_get_zspage(class);
@@ -1553,8 +1828,10 @@ unsigned long zs_malloc(struct zs_pool *pool, size_t size, gfp_t gfp)
 		/* Now move the zspage to another fullness group, if required */
 		fix_fullness_group(class, zspage);
 		record_obj(handle, obj);
+		zs_refill_locked(class, &refill);
 		spin_unlock(&class->lock);
 
+		zs_refill_finish(pool, class, &refill);
 		return handle;
 	}
 
@@ -1563,6 +1840,7 @@ unsigned long zs_malloc(struct zs_pool *pool, size_t size, gfp_t gfp)
 	zspage = alloc_zspage(pool, class, gfp);
 	if (!zspage) {
 		cache_free_handle(pool, handle);
+		zs_refill_finish(pool, class, &refill);
 		return 0;
 	}
 
@@ -1578,8 +1856,10 @@ unsigned long zs_malloc(struct zs_pool *pool, size_t size, gfp_t gfp)
 
 	/* We completely set up zspage so mark them as movable */
 	SetZsPageMovable(pool, zspage);
+	zs_refill_locked(class, &refill);
 	spin_unlock(&class->lock);
 
+	zs_refill_finish(pool, class, &refill);
 	return handle;
 }
 EXPORT_SYMBOL_GPL(zs_malloc);
@@ -1609,7 +1889,7 @@ static void obj_free(struct size_class *class, unsigned long obj)
 	zs_stat_dec(class, OBJ_USED, 1);
 }
 
-void zs_free(struct zs_pool *pool, unsigned long handle)
+static void __zs_free(struct zs_pool *pool, unsigned long handle)
 {
 	struct zspage *zspage;
 	struct page *f_page;
@@ -1620,9 +1900,6 @@ void zs_free(struct zs_pool *pool, unsigned long handle)
 	enum fullness_group fullness;
 	bool isolated;
 
-	if (unlikely(!handle))
-		return;
-
 	pin_tag(handle);
 	obj = handle_to_obj(handle);
 	obj_to_location(obj, &f_page, &f_objidx);
@@ -1652,6 +1929,17 @@ void zs_free(struct zs_pool *pool, unsigned long handle)
 	unpin_tag(handle);
 	cache_free_handle(pool, handle);
 }
+
+void zs_free(struct zs_pool *pool, unsigned long handle)
+{
+	if (unlikely(!handle))
+		return;
+
+	if (zs_mag_push(pool, handle))
+		return;
+
+	__zs_free(pool, handle);
+}
 EXPORT_SYMBOL_GPL(zs_free);
 
 static void zs_object_copy(struct size_class *class, unsigned long dst,
@@ -2391,20 +2679,121 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 	return pages_freed;
 }
 
+/*
+ * Parallel compaction: classes worth compacting are sorted by the number of
+ * pages compaction could free and handed out in that order to up to
+ * ZS_COMPACT_MAX_WORKERS low priority workers on an unbound workqueue.
+ */
+static bool parallel_compact;
+module_param(parallel_compact, bool, 0644);
+
+static struct workqueue_struct *zs_compact_wq;
+
+static void zs_compact_worker_fn(struct work_struct *work)
+{
+	struct zs_compact_worker *worker = container_of(work,
+					struct zs_compact_worker, work);
+	struct zs_pool *pool = worker->pool;
+	unsigned long pages_freed = 0;
+	long nice = task_nice(current);
+	int i;
+
+	/* Compaction is background work, keep out of the way of foreground */
+	set_user_nice(current, MAX_NICE);
+	while ((i = atomic_inc_return(&pool->compact_next) - 1) <
+	       pool->nr_compact_targets)
+		pages_freed += __zs_compact(pool,
+					    pool->compact_targets[i].class);
+	set_user_nice(current, nice);
+
+	atomic_long_add(pages_freed, &pool->compact_freed);
+}
+
+static int zs_compact_target_cmp(const void *a, const void *b)
+{
+	const struct zs_compact_target *ta = a, *tb = b;
+
+	if (ta->freeable == tb->freeable)
+		return 0;
+
+	return ta->freeable > tb->freeable ? -1 : 1;
+}
+
+static void zs_init_compact_workers(struct zs_pool *pool)
+{
+	int i;
+
+	mutex_init(&pool->compact_lock);
+	for (i = 0; i < ZS_COMPACT_MAX_WORKERS; i++) {
+		pool->compact_workers[i].pool = pool;
+		INIT_WORK(&pool->compact_workers[i].work, zs_compact_worker_fn);
+	}
+}
+
+static unsigned long zs_compact_parallel(struct zs_pool *pool)
+{
+	struct zs_compact_target *targets = pool->compact_targets;
+	struct size_class *class;
+	unsigned long freeable;
+	int i, nr = 0, nr_workers;
+
+	for (i = ZS_SIZE_CLASSES - 1; i >= 0; i--) {
+		class = pool->size_class[i];
+		if (!class)
+			continue;
+		if (class->index != i)
+			continue;
+		zs_mag_drain(pool, class);
+
+		spin_lock(&class->lock);
+		freeable = zs_can_compact(class);
+		spin_unlock(&class->lock);
+		if (!freeable)
+			continue;
+
+		targets[nr].class = class;
+		targets[nr].freeable = freeable;
+		nr++;
+	}
+
+	sort(targets, nr, sizeof(*targets), zs_compact_target_cmp, NULL);
+	pool->nr_compact_targets = nr;
+	atomic_set(&pool->compact_next, 0);
+	atomic_long_set(&pool->compact_freed, 0);
+
+	nr_workers = min3(nr, (int)num_online_cpus(), ZS_COMPACT_MAX_WORKERS);
+	for (i = 0; i < nr_workers; i++)
+		queue_work(zs_compact_wq, &pool->compact_workers[i].work);
+	for (i = 0; i < nr_workers; i++)
+		flush_work(&pool->compact_workers[i].work);
+
+	return atomic_long_read(&pool->compact_freed);
+}
+
 unsigned long zs_compact(struct zs_pool *pool)
 {
 	int i;
 	struct size_class *class;
 	unsigned long pages_freed = 0;
 
+	/* A concurrent caller falls back to a serial pass */
+	if (READ_ONCE(parallel_compact) && zs_compact_wq &&
+	    mutex_trylock(&pool->compact_lock)) {
+		pages_freed = zs_compact_parallel(pool);
+		mutex_unlock(&pool->compact_lock);
+		goto out;
+	}
+
 	for (i = ZS_SIZE_CLASSES - 1; i >= 0; i--) {
 		class = pool->size_class[i];
 		if (!class)
 			continue;
 		if (class->index != i)
 			continue;
+		zs_mag_drain(pool, class);
 		pages_freed += __zs_compact(pool, class);
 	}
+out:
 	atomic_long_add(pages_freed, &pool->stats.pages_compacted);
 
 	return pages_freed;
@@ -2492,6 +2881,7 @@ struct zs_pool *zs_create_pool(const char *name)
 		return NULL;
 
 	init_deferred_free(pool);
+	zs_init_compact_workers(pool);
 
 	pool->name = kstrdup(name, GFP_KERNEL);
 	if (!pool->name)
@@ -2571,6 +2961,8 @@ struct zs_pool *zs_create_pool(const char *name)
 		for (fullness = ZS_EMPTY; fullness < NR_ZS_FULLNESS;
 							fullness++)
 			INIT_LIST_HEAD(&class->fullness_list[fullness]);
+		if (zs_mag_init(class))
+			goto err;
 
 		prev_class = class;
 	}
@@ -2615,6 +3007,9 @@ void zs_destroy_pool(struct zs_pool *pool)
 		if (class->index != i)
 			continue;
 
+		zs_mag_drain(pool, class);
+		zs_mag_destroy(class);
+
 		for (fg = ZS_EMPTY; fg < NR_ZS_FULLNESS; fg++) {
 			if (!list_empty(&class->fullness_list[fg])) {
 				pr_info("Freeing non-empty class with size %db, fullness group %d\n",
@@ -2649,6 +3044,12 @@ static int __init zs_init(void)
 
 	zs_stat_init();
 
+	/* Without the workqueue zs_compact() always compacts serially */
+	zs_compact_wq = alloc_workqueue("zs_compact",
+					WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+	if (!zs_compact_wq)
+		pr_warn("failed to create compaction workqueue\n");
+
 	return 0;
 
 notifier_fail:
@@ -2666,6 +3067,8 @@ static void __exit zs_exit(void)
 	zsmalloc_unmount();
 	zs_unregister_cpu_notifier();
 
+	if (zs_compact_wq)
+		destroy_workqueue(zs_compact_wq);
 	zs_stat_exit();
 }
 
@@ -41,6 +41,9 @@
 #include <linux/swapops.h>
 #include <linux/writeback.h>
 #include <linux/pagemap.h>
+#include <linux/blkdev.h>
+#include <linux/sort.h>
+#include <linux/workqueue.h>
 
 /*********************************
 * statistics
@@ -67,6 +70,8 @@ static u64 zswap_reject_alloc_fail;
 static u64 zswap_reject_kmemcache_fail;
 /* Duplicate store was encountered (rare) */
 static u64 zswap_duplicate_entry;
+/* Pages written back to the backing swap device */
+static u64 zswap_written_back_pages;
 
 /*********************************
 * tunables
@@ -113,6 +118,26 @@ static bool zswap_same_filled_pages_enabled = true;
 module_param_named(same_filled_pages_enabled, zswap_same_filled_pages_enabled,
 		   bool, 0644);
 
+/*
+ * Write cold and incompressible entries back to the swap device that backs
+ * them, so that they no longer take up pool memory. Devices flagged
+ * SWP_FAST are skipped, as writing to them saves nothing.
+ */
+static bool zswap_writeback_enabled;
+module_param_named(writeback_enabled, zswap_writeback_enabled, bool, 0644);
+
+/* Entries not loaded for this many seconds are written back */
+static unsigned int zswap_writeback_min_age = 300;
+module_param_named(writeback_min_age, zswap_writeback_min_age, uint, 0644);
+
+/* Maximum number of pages written back per swap device and pass */
+static unsigned int zswap_writeback_batch = 256;
+module_param_named(writeback_batch, zswap_writeback_batch, uint, 0644);
+
+/* Seconds between writeback passes */
+static unsigned int zswap_writeback_interval = 60;
+module_param_named(writeback_interval, zswap_writeback_interval, uint, 0644);
+
 /* zpool is shared by all of zswap backend  */
 static struct zpool *zswap_pool;
 
@@ -148,6 +173,8 @@ struct zswap_pool {
  * pool - the zswap_pool the entry's data is in
  * handle - zpool allocation handle that stores the compressed page data
  * value - value of the same-value filled pages which have same content
+ * lru - link in the writeback LRU of the tree, empty if not on it
+ * stored - jiffies at store or last load, for the writeback age
  */
 struct zswap_entry {
 	pgoff_t offset;
@@ -158,16 +185,20 @@ struct zswap_entry {
 		unsigned long handle;
 		unsigned long value;
 	};
+	struct list_head lru;
+	unsigned long stored;
 };
 
 /*
  * The tree lock in the zswap_tree struct protects a few things:
  * - the tree
  * - the refcount field of each entry in the tree
+ * - the writeback LRU, oldest entries at the tail
  */
 struct zswap_tree {
 	struct btree_head head;
 	spinlock_t lock;
+	struct list_head lru;
 };
 
 static struct zswap_tree *zswap_trees[MAX_SWAPFILES];
@@ -237,6 +268,7 @@ static struct zswap_entry *zswap_entry_cache_alloc(gfp_t gfp)
 	if (!entry)
 		return NULL;
 	entry->refcount = 1;
+	INIT_LIST_HEAD(&entry->lru);
 	return entry;
 }
 
@@ -258,6 +290,7 @@ static struct zswap_entry *zswap_search(struct btree_head *head, pgoff_t offset)
 static void zswap_erase(struct btree_head *head, struct zswap_entry *entry)
 {
 	btree_remove(head, btree_pgofft_geo, &entry->offset);
+	list_del_init(&entry->lru);
 }
 
 /*
@@ -293,7 +326,10 @@ static void zswap_entry_put(struct btree_head *head,
 
 	BUG_ON(refcount < 0);
 	if (refcount == 0) {
-		zswap_erase(head, entry);
+		/* The offset may have been reused by a newer entry */
+		if (zswap_search(head, entry->offset) == entry)
+			zswap_erase(head, entry);
+		list_del_init(&entry->lru);
 		zswap_free_entry(entry);
 	}
 }
@@ -740,6 +776,217 @@ enum zswap_get_swap_ret {
 	ZSWAP_SWAPCACHE_FAIL,
 };
 
+/* Serializes writeback passes against zswap_frontswap_invalidate_area() */
+static DEFINE_MUTEX(zswap_writeback_mutex);
+static void zswap_writeback_work_fn(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(zswap_writeback_work, zswap_writeback_work_fn);
+
+/* Decompress the data of a non same-filled entry into @page */
+static void zswap_decompress_entry(struct zswap_entry *entry,
+				   struct page *page)
+{
+	struct crypto_comp *tfm;
+	unsigned int dlen = PAGE_SIZE;
+	u8 *src, *dst;
+	int ret;
+
+	src = (u8 *)zpool_map_handle(entry->pool->zpool, entry->handle,
+			ZPOOL_MM_RO);
+	dst = kmap_atomic(page);
+
+	if (entry->length == PAGE_SIZE) {
+		ret = 0;
+		copy_page(dst, src);
+	} else {
+		tfm = *get_cpu_ptr(entry->pool->tfm);
+		ret = crypto_comp_decompress(tfm, src, entry->length, dst, &dlen);
+		put_cpu_ptr(entry->pool->tfm);
+	}
+
+	kunmap_atomic(dst);
+	zpool_unmap_handle(entry->pool->zpool, entry->handle);
+	BUG_ON(ret);
+}
+
+/*
+ * zswap_get_swap_cache_page
+ *
+ * This is an adaption of read_swap_cache_async()
+ *
+ * This function tries to find a page with the given swap entry
+ * in the swapper_space address space (the swap cache).  If the page
+ * is found, it is returned in retpage.  Otherwise, a page is allocated,
+ * added to the swap cache, and returned in retpage.
+ *
+ * If success, the swap cache page is returned in retpage
+ * Returns ZSWAP_SWAPCACHE_EXIST if page was already in the swap cache
+ * Returns ZSWAP_SWAPCACHE_NEW if the new page needs to be populated,
+ *     the new page is added to swapcache and locked
+ * Returns ZSWAP_SWAPCACHE_FAIL on error
+ */
+static int zswap_get_swap_cache_page(swp_entry_t entry,
+				struct page **retpage)
+{
+	bool page_was_allocated;
+
+	*retpage = __read_swap_cache_async(entry, GFP_KERNEL,
+			NULL, 0, &page_was_allocated);
+	if (page_was_allocated)
+		return ZSWAP_SWAPCACHE_NEW;
+	if (!*retpage)
+		return ZSWAP_SWAPCACHE_FAIL;
+	return ZSWAP_SWAPCACHE_EXIST;
+}
+
+/*
+ * Write the data of @entry to its slot on the backing swap device and drop
+ * the entry. The caller holds a reference to @entry, which is dropped.
+ */
+static int zswap_writeback_entry(struct zswap_tree *tree, unsigned type,
+				 struct zswap_entry *entry)
+{
+	swp_entry_t swpentry = swp_entry(type, entry->offset);
+	struct page *page;
+	struct writeback_control wbc = {
+		.sync_mode = WB_SYNC_NONE,
+	};
+	int ret;
+
+	switch (zswap_get_swap_cache_page(swpentry, &page)) {
+	case ZSWAP_SWAPCACHE_FAIL: /* no memory or invalidate happened */
+		ret = -ENOMEM;
+		goto fail;
+
+	case ZSWAP_SWAPCACHE_EXIST:
+		/* page is already in the swap cache, ignore for now */
+		put_page(page);
+		ret = -EEXIST;
+		goto fail;
+
+	case ZSWAP_SWAPCACHE_NEW: /* page is locked */
+		zswap_decompress_entry(entry, page);
+		SetPageUptodate(page);
+	}
+
+	/* move it to the tail of the inactive list after end_writeback */
+	SetPageReclaim(page);
+
+	/* start writeback */
+	__swap_writepage(page, &wbc, end_swap_bio_write);
+	put_page(page);
+	zswap_written_back_pages++;
+
+	spin_lock(&tree->lock);
+	/*
+	 * If the entry is still in the tree, drop its initial reference. A
+	 * load now finds no entry and reads the page from the device.
+	 */
+	if (zswap_search(&tree->head, entry->offset) == entry) {
+		zswap_erase(&tree->head, entry);
+		zswap_entry_put(&tree->head, entry);
+	}
+	zswap_entry_put(&tree->head, entry);
+	spin_unlock(&tree->lock);
+
+	return 0;
+
+fail:
+	spin_lock(&tree->lock);
+	/* still stored, retry on a later pass */
+	if (zswap_search(&tree->head, entry->offset) == entry &&
+	    list_empty(&entry->lru)) {
+		entry->stored = jiffies;
+		list_add(&entry->lru, &tree->lru);
+	}
+	zswap_entry_put(&tree->head, entry);
+	spin_unlock(&tree->lock);
+
+	return ret;
+}
+
+static int zswap_entry_offset_cmp(const void *a, const void *b)
+{
+	const struct zswap_entry *ea = *(struct zswap_entry **)a;
+	const struct zswap_entry *eb = *(struct zswap_entry **)b;
+
+	if (ea->offset == eb->offset)
+		return 0;
+
+	return ea->offset < eb->offset ? -1 : 1;
+}
+
+/*
+ * Take up to @nr_batch writeback candidates from the tail of the LRU,
+ * sort them by swap offset, and submit them under one plug so that
+ * adjacent slots are merged into large requests.
+ */
+static void zswap_writeback_tree(struct zswap_tree *tree, unsigned type,
+				 struct zswap_entry **batch,
+				 unsigned int nr_batch)
+{
+	unsigned long min_age = zswap_writeback_min_age * HZ;
+	struct zswap_entry *entry;
+	struct blk_plug plug;
+	unsigned int nr = 0, i;
+
+	spin_lock(&tree->lock);
+	while (nr < nr_batch && !list_empty(&tree->lru)) {
+		entry = list_last_entry(&tree->lru, struct zswap_entry, lru);
+
+		/* Incompressible entries are always at the tail */
+		if (entry->length != PAGE_SIZE &&
+		    time_before(jiffies, entry->stored + min_age))
+			break;
+
+		list_del_init(&entry->lru);
+		zswap_entry_get(entry);
+		batch[nr++] = entry;
+	}
+	spin_unlock(&tree->lock);
+
+	if (!nr)
+		return;
+
+	sort(batch, nr, sizeof(*batch), zswap_entry_offset_cmp, NULL);
+
+	blk_start_plug(&plug);
+	for (i = 0; i < nr; i++) {
+		zswap_writeback_entry(tree, type, batch[i]);
+		cond_resched();
+	}
+	blk_finish_plug(&plug);
+}
+
+static void zswap_writeback_work_fn(struct work_struct *work)
+{
+	unsigned int nr_batch = READ_ONCE(zswap_writeback_batch);
+	struct zswap_entry **batch = NULL;
+	unsigned type;
+
+	if (!READ_ONCE(zswap_writeback_enabled) || !nr_batch)
+		goto out;
+
+	batch = kmalloc_array(nr_batch, sizeof(*batch), GFP_KERNEL);
+	if (!batch)
+		goto out;
+
+	mutex_lock(&zswap_writeback_mutex);
+	for (type = 0; type < MAX_SWAPFILES; type++) {
+		struct zswap_tree *tree = zswap_trees[type];
+
+		if (!tree || is_swap_fast(swp_entry(type, 0)))
+			continue;
+
+		zswap_writeback_tree(tree, type, batch, nr_batch);
+	}
+	mutex_unlock(&zswap_writeback_mutex);
+
+	kfree(batch);
+out:
+	schedule_delayed_work(&zswap_writeback_work,
+			      max(zswap_writeback_interval, 1U) * HZ);
+}
+
 static int zswap_is_page_same_filled(void *ptr, unsigned long *value)
 {
 	unsigned int pos;
@@ -864,6 +1111,14 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 	/* map */
 	spin_lock(&tree->lock);
 	ret = zswap_insert_or_replace(&tree->head, entry);
+	if (!ret && entry->length) {
+		entry->stored = jiffies;
+		/* Nothing is gained by keeping incompressible pages around */
+		if (entry->length == PAGE_SIZE)
+			list_add_tail(&entry->lru, &tree->lru);
+		else
+			list_add(&entry->lru, &tree->lru);
+	}
 	spin_unlock(&tree->lock);
 	if (ret < 0)  {
 		zswap_reject_alloc_fail++;
@@ -894,10 +1149,7 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 {
 	struct zswap_tree *tree = zswap_trees[type];
 	struct zswap_entry *entry;
-	struct crypto_comp *tfm;
-	u8 *src, *dst;
-	unsigned int dlen;
-	int ret;
+	u8 *dst;
 
 	/* find */
 	spin_lock(&tree->lock);
@@ -907,6 +1159,11 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 		spin_unlock(&tree->lock);
 		return -1;
 	}
+	/* a loaded entry is not cold, unless being written back */
+	if (!list_empty(&entry->lru) && entry->length != PAGE_SIZE) {
+		entry->stored = jiffies;
+		list_move(&entry->lru, &tree->lru);
+	}
 	spin_unlock(&tree->lock);
 
 	if (!entry->length) {
@@ -917,23 +1174,7 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 	}
 
 	/* decompress */
-	dlen = PAGE_SIZE;
-	src = (u8 *)zpool_map_handle(entry->pool->zpool, entry->handle,
-			ZPOOL_MM_RO);
-	dst = kmap_atomic(page);
-
-	if (entry->length == PAGE_SIZE) {
-		ret = 0;
-		copy_page(dst, src);
-	} else {
-		tfm = *get_cpu_ptr(entry->pool->tfm);
-		ret = crypto_comp_decompress(tfm, src, entry->length, dst, &dlen);
-		put_cpu_ptr(entry->pool->tfm);
-	}
-
-	kunmap_atomic(dst);
-	zpool_unmap_handle(entry->pool->zpool, entry->handle);
-	BUG_ON(ret);
+	zswap_decompress_entry(entry, page);
 
 freeentry:
 	spin_lock(&tree->lock);
@@ -991,6 +1232,7 @@ static void zswap_frontswap_invalidate_area(unsigned type)
 	if (!tree)
 		return;
 
+	mutex_lock(&zswap_writeback_mutex);
 	/* walk the tree and free everything */
 	spin_lock(&tree->lock);
 	btree_visitor(&tree->head, btree_pgofft_geo, 0, do_free_entry, NULL);
@@ -998,6 +1240,7 @@ static void zswap_frontswap_invalidate_area(unsigned type)
 	spin_unlock(&tree->lock);
 	kfree(tree);
 	zswap_trees[type] = NULL;
+	mutex_unlock(&zswap_writeback_mutex);
 }
 
 static void zswap_frontswap_init(unsigned type)
@@ -1015,6 +1258,7 @@ static void zswap_frontswap_init(unsigned type)
 		return;
 	}
 	spin_lock_init(&tree->lock);
+	INIT_LIST_HEAD(&tree->lru);
 	zswap_trees[type] = tree;
 }
 
@@ -1051,6 +1295,8 @@ static int __init zswap_debugfs_init(void)
 			zswap_debugfs_root, &zswap_reject_compress_poor);
 	debugfs_create_u64("duplicate_entry", S_IRUGO,
 			zswap_debugfs_root, &zswap_duplicate_entry);
+	debugfs_create_u64("written_back_pages", S_IRUGO,
+			zswap_debugfs_root, &zswap_written_back_pages);
 	debugfs_create_u64("pool_total_size_kb", S_IRUGO,
 			zswap_debugfs_root, &zswap_pool_total_size_kb);
 	debugfs_create_atomic_t("stored_pages", S_IRUGO,
@@ -1120,6 +1366,8 @@ static int __init init_zswap(void)
 	}
 
 	frontswap_register_ops(&zswap_frontswap_ops);
+	schedule_delayed_work(&zswap_writeback_work,
+			      max(zswap_writeback_interval, 1U) * HZ);
 	if (zswap_debugfs_init())
 		pr_warn("debugfs initialization failed\n");
 	return 0;
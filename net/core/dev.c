@@ -144,6 +144,7 @@
 #include <linux/crash_dump.h>
 #include <linux/tcp.h>
 #include <net/tcp.h>
+#include <net/rx_latency.h>
 
 #include "net-sysfs.h"
 
@@ -4537,6 +4538,8 @@ static int napi_gro_complete(struct sk_buff *skb)
 
 	BUILD_BUG_ON(sizeof(struct napi_gro_cb) > sizeof(skb->cb));
 
+	rx_latency_record(skb->dev, skb, RX_LAT_GRO);
+
 	if (NAPI_GRO_CB(skb)->count == 1) {
 		skb_shinfo(skb)->gso_size = 0;
 		goto out;
@@ -7976,6 +7979,7 @@ void free_netdev(struct net_device *dev)
 #endif
 
 	kfree(rcu_dereference_protected(dev->ingress_queue, 1));
+	netdev_rx_latency_free(dev);
 
 	/* Flush device addresses */
 	dev_addr_flush(dev);
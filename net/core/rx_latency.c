@@ -0,0 +1,217 @@
+/*
+ * Receive latency histograms
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * While enabled, drivers stamp skb->tstamp as soon as the hardware has
+ * completed a receive buffer. The time elapsed since then is accounted each
+ * time the packet passes one of the rx_latency_stage points, into a log2
+ * histogram of the interface it was received on. As every stage measures
+ * from the same origin, the difference between two stages is the delay
+ * added in between.
+ *
+ * <debugfs>/rx_latency/enable turns the instrumentation on and off and
+ * <debugfs>/rx_latency/histograms shows the histograms of every interface
+ * that has them. Writing to the latter clears them.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/kernel.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+#include <net/net_namespace.h>
+#include <net/rx_latency.h>
+#include <net/sock.h>
+
+DEFINE_STATIC_KEY_FALSE(rx_latency_enabled);
+EXPORT_SYMBOL_GPL(rx_latency_enabled);
+
+static DEFINE_MUTEX(rx_latency_mutex);
+
+static const char * const rx_latency_stage_names[RX_LAT_NR_STAGES] = {
+	"rmnet", "gro", "sock",
+};
+
+/**
+ * netdev_rx_latency_alloc - account receive latency for an interface
+ * @dev: network device
+ *
+ * The histograms are freed along with the device by free_netdev().
+ */
+int netdev_rx_latency_alloc(struct net_device *dev)
+{
+	dev->rx_lat = alloc_percpu(struct rx_latency_stats);
+
+	return dev->rx_lat ? 0 : -ENOMEM;
+}
+EXPORT_SYMBOL_GPL(netdev_rx_latency_alloc);
+
+void netdev_rx_latency_free(struct net_device *dev)
+{
+	free_percpu(dev->rx_lat);
+	dev->rx_lat = NULL;
+}
+
+void __rx_latency_record(struct net_device *dev, const struct sk_buff *skb,
+			 enum rx_latency_stage stage)
+{
+	s64 delta;
+	u64 us;
+
+	/* not stamped by the driver, or the stamp lies in the future */
+	if (!ktime_to_ns(skb->tstamp))
+		return;
+	delta = ktime_to_ns(net_timedelta(skb->tstamp));
+	if (delta < 0)
+		return;
+
+	us = div_u64(delta, NSEC_PER_USEC);
+	this_cpu_inc(dev->rx_lat->hist[stage][min_t(int, fls64(us),
+						     RX_LAT_NR_BUCKETS - 1)]);
+	this_cpu_add(dev->rx_lat->sum_us[stage], us);
+}
+EXPORT_SYMBOL_GPL(__rx_latency_record);
+
+/*
+ * Sockets may be fed from the backlog after the device went away, so the
+ * interface is looked up by index rather than through skb->dev.
+ */
+void __rx_latency_record_sk(const struct sock *sk, const struct sk_buff *skb)
+{
+	struct net_device *dev;
+
+	rcu_read_lock();
+	dev = dev_get_by_index_rcu(sock_net(sk), skb->skb_iif);
+	if (dev && dev->rx_lat)
+		__rx_latency_record(dev, skb, RX_LAT_SOCK);
+	rcu_read_unlock();
+}
+EXPORT_SYMBOL_GPL(__rx_latency_record_sk);
+
+static int rx_latency_enable_get(void *data, u64 *val)
+{
+	*val = static_branch_unlikely(&rx_latency_enabled);
+	return 0;
+}
+
+static int rx_latency_enable_set(void *data, u64 val)
+{
+	mutex_lock(&rx_latency_mutex);
+	if (val)
+		static_branch_enable(&rx_latency_enabled);
+	else
+		static_branch_disable(&rx_latency_enabled);
+	mutex_unlock(&rx_latency_mutex);
+
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(rx_latency_enable_fops, rx_latency_enable_get,
+			rx_latency_enable_set, "%llu\n");
+
+static void rx_latency_show_dev(struct seq_file *m, struct net_device *dev)
+{
+	u64 hist[RX_LAT_NR_BUCKETS];
+	int stage, cpu, i;
+
+	seq_printf(m, "%s:\n", dev->name);
+	for (stage = 0; stage < RX_LAT_NR_STAGES; stage++) {
+		u64 nr = 0, sum = 0;
+
+		memset(hist, 0, sizeof(hist));
+		for_each_possible_cpu(cpu) {
+			struct rx_latency_stats *stats;
+
+			stats = per_cpu_ptr(dev->rx_lat, cpu);
+			for (i = 0; i < RX_LAT_NR_BUCKETS; i++)
+				hist[i] += stats->hist[stage][i];
+			sum += stats->sum_us[stage];
+		}
+
+		for (i = 0; i < RX_LAT_NR_BUCKETS; i++)
+			nr += hist[i];
+
+		seq_printf(m, "  %-6s packets: %llu mean_us: %llu hist:",
+			   rx_latency_stage_names[stage], nr,
+			   nr ? div64_u64(sum, nr) : 0);
+		for (i = 0; i < RX_LAT_NR_BUCKETS; i++)
+			seq_printf(m, " %llu", hist[i]);
+		seq_putc(m, '\n');
+	}
+}
+
+static int rx_latency_show(struct seq_file *m, void *v)
+{
+	struct net_device *dev;
+	struct net *net;
+	int i;
+
+	seq_puts(m, "buckets_us:");
+	for (i = 0; i < RX_LAT_NR_BUCKETS - 1; i++)
+		seq_printf(m, " <%u", 1U << i);
+	seq_printf(m, " >=%u\n", 1U << (RX_LAT_NR_BUCKETS - 2));
+
+	rcu_read_lock();
+	for_each_net_rcu(net)
+		for_each_netdev_rcu(net, dev)
+			if (dev->rx_lat)
+				rx_latency_show_dev(m, dev);
+	rcu_read_unlock();
+
+	return 0;
+}
+
+static int rx_latency_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, rx_latency_show, NULL);
+}
+
+static ssize_t rx_latency_write(struct file *filp, const char __user *ubuf,
+				size_t cnt, loff_t *ppos)
+{
+	struct net_device *dev;
+	struct net *net;
+	int cpu;
+
+	rcu_read_lock();
+	for_each_net_rcu(net)
+		for_each_netdev_rcu(net, dev)
+			if (dev->rx_lat)
+				for_each_possible_cpu(cpu)
+					memset(per_cpu_ptr(dev->rx_lat, cpu),
+					       0, sizeof(*dev->rx_lat));
+	rcu_read_unlock();
+
+	return cnt;
+}
+
+static const struct file_operations rx_latency_fops = {
+	.open		= rx_latency_open,
+	.read		= seq_read,
+	.write		= rx_latency_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init rx_latency_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("rx_latency", NULL);
+	if (!dir)
+		return -ENOMEM;
+
+	debugfs_create_file("enable", 0644, dir, NULL,
+			    &rx_latency_enable_fops);
+	debugfs_create_file("histograms", 0644, dir, NULL, &rx_latency_fops);
+
+	return 0;
+}
+late_initcall(rx_latency_init);
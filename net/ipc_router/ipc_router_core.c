@@ -26,6 +26,7 @@
 #include <linux/uaccess.h>
 #include <linux/debugfs.h>
 #include <linux/rwsem.h>
+#include <linux/rculist.h>
 #include <linux/ipc_logging.h>
 #include <linux/uaccess.h>
 #include <linux/ipc_router.h>
@@ -163,6 +164,7 @@ struct msm_ipc_routing_table_entry {
 	struct rw_semaphore lock_lha4;
 	unsigned long num_tx_bytes;
 	unsigned long num_rx_bytes;
+	struct rcu_head rcu;
 };
 
 #define LOG_CTX_NAME_LEN 32
@@ -449,14 +451,17 @@ static void ipc_router_log_msg(void *log_ctx, u32 xchng_type,
 	}
 }
 
-/* Must be called with routing_table_lock_lha3 locked. */
+/*
+ * Must be called with routing_table_lock_lha3 locked or under
+ * rcu_read_lock().
+ */
 static struct msm_ipc_routing_table_entry *lookup_routing_table(
 	u32 node_id)
 {
 	u32 key = (node_id % RT_HASH_SIZE);
 	struct msm_ipc_routing_table_entry *rt_entry;
 
-	list_for_each_entry(rt_entry, &routing_table[key], list) {
+	list_for_each_entry_rcu(rt_entry, &routing_table[key], list) {
 		if (rt_entry->node_id == node_id)
 			return rt_entry;
 	}
@@ -499,7 +504,7 @@ static struct msm_ipc_routing_table_entry *create_routing_table_entry(
 		rt_entry->neighbor_node_id = xprt_info->remote_node_id;
 
 	key = (node_id % RT_HASH_SIZE);
-	list_add_tail(&rt_entry->list, &routing_table[key]);
+	list_add_tail_rcu(&rt_entry->list, &routing_table[key]);
 out_create_rtentry1:
 	kref_get(&rt_entry->ref);
 out_create_rtentry2:
@@ -514,18 +519,19 @@ static struct msm_ipc_routing_table_entry *create_routing_table_entry(
  * @return: a reference to the routing table entry on success, NULL on failure.
  *
  * This function is used to obtain a reference to the rounting table entry
- * corresponding to a node id.
+ * corresponding to a node id. It is on the path of every data packet, so
+ * the lookup is done under RCU rather than the routing table lock.
  */
 static struct msm_ipc_routing_table_entry *ipc_router_get_rtentry_ref(
 	u32 node_id)
 {
 	struct msm_ipc_routing_table_entry *rt_entry;
 
-	down_read(&routing_table_lock_lha3);
+	rcu_read_lock();
 	rt_entry = lookup_routing_table(node_id);
-	if (rt_entry)
-		kref_get(&rt_entry->ref);
-	up_read(&routing_table_lock_lha3);
+	if (rt_entry && !kref_get_unless_zero(&rt_entry->ref))
+		rt_entry = NULL;
+	rcu_read_unlock();
 	return rt_entry;
 }
 
@@ -543,9 +549,10 @@ void ipc_router_release_rtentry(struct kref *ref)
 
 	/* All references to a routing entry will be put only under SSR.
 	 * As part of SSR, all the internals of the routing table entry
-	 * are cleaned. So just free the routing table entry.
+	 * are cleaned. So just free the routing table entry once lockless
+	 * lookups are done with it.
 	 */
-	kfree(rt_entry);
+	kfree_rcu(rt_entry, rcu);
 }
 
 struct rr_packet *rr_read(struct msm_ipc_router_xprt_info *xprt_info)
@@ -2300,7 +2307,7 @@ static void msm_ipc_cleanup_routing_table(
 			cleanup_rmt_ports(xprt_info, rt_entry);
 			rt_entry->xprt_info = NULL;
 			up_write(&rt_entry->lock_lha4);
-			list_del(&rt_entry->list);
+			list_del_rcu(&rt_entry->list);
 			kref_put(&rt_entry->ref, ipc_router_release_rtentry);
 		}
 	}
@@ -0,0 +1,380 @@
+/* Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ *
+ * RMNET Data downlink benchmark
+ *
+ * Injects synthetic MAP aggregated downlink frames into a physical device
+ * associated with rmnet_data, from a NAPI context of its own, the same way
+ * rmnet_ipa hands frames over from its poll loop. Deaggregation, MAP
+ * processing, GRO and the stack above the VND all run as they do for real
+ * traffic, so changes to any of them can be compared without a network.
+ *
+ * Usage, with the physical device associated and mux_id mapped to a VND:
+ *	echo rmnet_ipa0 > /sys/module/rmnet_data/parameters/bench_dev
+ *	echo 100000 > /sys/module/rmnet_data/parameters/bench_run
+ *	cat /sys/module/rmnet_data/parameters/bench_result
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+#include <linux/ip.h>
+#include <linux/udp.h>
+#include <linux/completion.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <net/ip.h>
+#include <net/rmnet_config.h>
+#include "rmnet_data_private.h"
+#include "rmnet_data_config.h"
+#include "rmnet_map.h"
+#include "rmnet_data_stats.h"
+
+RMNET_LOG_MODULE(RMNET_DATA_LOGMASK_HANDLER);
+
+#define RMNET_BENCH_TIMEOUT	(60 * HZ)
+#define RMNET_BENCH_WEIGHT	64
+
+static char bench_dev[IFNAMSIZ];
+module_param_string(bench_dev, bench_dev, sizeof(bench_dev), 0644);
+MODULE_PARM_DESC(bench_dev, "Physical device the benchmark injects into");
+
+static unsigned int bench_mux_id;
+module_param(bench_mux_id, uint, 0644);
+MODULE_PARM_DESC(bench_mux_id, "MAP mux id of the injected packets");
+
+static unsigned int bench_pkts_per_agg = 16;
+module_param(bench_pkts_per_agg, uint, 0644);
+MODULE_PARM_DESC(bench_pkts_per_agg, "Packets per aggregated frame");
+
+static unsigned int bench_pkt_len = 1400;
+module_param(bench_pkt_len, uint, 0644);
+MODULE_PARM_DESC(bench_pkt_len, "IPv4/UDP packet length in bytes");
+
+struct rmnet_bench {
+	struct net_device napi_dev;
+	struct napi_struct napi;
+	struct completion done;
+	struct net_device *dev;
+	struct rmnet_phys_ep_config *config;
+	unsigned char *frame;
+	unsigned int frame_len;
+	unsigned int remaining;
+
+	/* Results of the last run */
+	unsigned int frames;
+	unsigned int pkts;
+	u64 elapsed_ns;
+	u64 deagg_ns;
+	u64 rx_ns;
+	u64 flush_ns;
+	unsigned long vnd_rx;
+	unsigned long drops[RMNET_STATS_SKBFREE_MAX];
+};
+
+static DEFINE_MUTEX(rmnet_bench_lock);
+static struct rmnet_bench *rmnet_bench;
+
+/* rmnet_bench_build_frame() - Build the aggregated frame template
+ * @b:          Benchmark state
+ * @trailer:    Length of the downlink checksum trailer, 0 if not configured
+ *
+ * Each packet is a MAP data header followed by an IPv4/UDP packet with a
+ * valid header checksum. Source ports differ so flows are not all merged
+ * by GRO. The checksum trailer, if any, is left zeroed: the valid bit not
+ * being set makes rmnet fall back to the stack's checksum validation.
+ *
+ * Return:
+ *      - 0 on success
+ *      - -ENOMEM if the template could not be allocated
+ */
+static int rmnet_bench_build_frame(struct rmnet_bench *b, unsigned int trailer)
+{
+	unsigned int pkt_len = bench_pkt_len;
+	struct rmnet_map_header_s *maph;
+	struct iphdr *iph;
+	struct udphdr *uh;
+	unsigned char *p;
+	unsigned int i;
+
+	b->frame = kzalloc(b->frame_len, GFP_KERNEL);
+	if (!b->frame)
+		return -ENOMEM;
+
+	p = b->frame;
+	for (i = 0; i < bench_pkts_per_agg; i++) {
+		maph = (struct rmnet_map_header_s *)p;
+		maph->mux_id = bench_mux_id;
+		maph->pkt_len = htons(pkt_len);
+
+		iph = (struct iphdr *)(maph + 1);
+		iph->version = 4;
+		iph->ihl = 5;
+		iph->tot_len = htons(pkt_len);
+		iph->ttl = 64;
+		iph->protocol = IPPROTO_UDP;
+		iph->saddr = htonl(0xc0000201);	/* 192.0.2.1 */
+		iph->daddr = htonl(0xc0000202);	/* 192.0.2.2 */
+		iph->check = ip_fast_csum((u8 *)iph, iph->ihl);
+
+		uh = (struct udphdr *)(iph + 1);
+		uh->source = htons(10000 + i % 4);
+		uh->dest = htons(9);
+		uh->len = htons(pkt_len - sizeof(*iph));
+
+		p += sizeof(*maph) + pkt_len + trailer;
+	}
+
+	return 0;
+}
+
+/* rmnet_bench_inject() - Inject one aggregated frame
+ * @b:          Benchmark state
+ *
+ * The frame is first run through deaggregation alone on a copy to measure
+ * that stage, then a second copy goes through netif_receive_skb() on the
+ * physical device, which covers the whole rmnet ingress path and the stack.
+ */
+static void rmnet_bench_inject(struct rmnet_bench *b)
+{
+	struct sk_buff *skb, *skbn;
+	u64 start;
+
+	skb = netdev_alloc_skb(b->dev, b->frame_len);
+	if (!skb)
+		return;
+	memcpy(skb_put(skb, b->frame_len), b->frame, b->frame_len);
+
+	start = local_clock();
+	while ((skbn = rmnet_map_deaggregate(skb, b->config)) != 0)
+		kfree_skb(skbn);
+	b->deagg_ns += local_clock() - start;
+	kfree_skb(skb);
+
+	skb = netdev_alloc_skb(b->dev, b->frame_len);
+	if (!skb)
+		return;
+	memcpy(skb_put(skb, b->frame_len), b->frame, b->frame_len);
+	skb->protocol = htons(ETH_P_MAP);
+	skb_reset_network_header(skb);
+
+	start = local_clock();
+	netif_receive_skb(skb);
+	b->rx_ns += local_clock() - start;
+
+	b->frames++;
+	b->pkts += bench_pkts_per_agg;
+}
+
+static int rmnet_bench_poll(struct napi_struct *napi, int budget)
+{
+	struct rmnet_bench *b = container_of(napi, struct rmnet_bench, napi);
+	int work = 0;
+	u64 start;
+
+	rcu_read_lock();
+	while (work < budget && b->remaining) {
+		rmnet_bench_inject(b);
+		b->remaining--;
+		work++;
+	}
+	rcu_read_unlock();
+
+	start = local_clock();
+	napi_gro_flush(napi, false);
+	b->flush_ns += local_clock() - start;
+
+	if (!b->remaining) {
+		napi_complete_done(napi, work);
+		complete(&b->done);
+	}
+
+	return work;
+}
+
+/* rmnet_bench_run() - Run the benchmark
+ * @frames:     Number of aggregated frames to inject
+ *
+ * Return:
+ *      - 0 on success
+ *      - -ENODEV if bench_dev is not a device associated with rmnet_data
+ *      - -EINVAL if the packet layout does not fit a single frame
+ *      - -ETIMEDOUT if the injection did not finish in time
+ */
+static int rmnet_bench_run(struct rmnet_bench *b, unsigned int frames)
+{
+	unsigned long before[RMNET_STATS_SKBFREE_MAX];
+	struct net_device *vnd;
+	unsigned int trailer = 0;
+	unsigned long vnd_rx = 0;
+	u64 start;
+	int i, rc;
+
+	if (!bench_pkts_per_agg || bench_pkt_len < sizeof(struct iphdr) +
+	    sizeof(struct udphdr) || bench_pkt_len > RMNET_DATA_MAX_PACKET_SIZE ||
+	    bench_mux_id >= RMNET_DATA_MAX_LOGICAL_EP)
+		return -EINVAL;
+
+	b->dev = dev_get_by_name(&init_net, bench_dev);
+	if (!b->dev)
+		return -ENODEV;
+
+	rcu_read_lock();
+	b->config = _rmnet_get_phys_ep_config(b->dev);
+	rcu_read_unlock();
+	if (!b->config ||
+	    !(b->config->ingress_data_format & RMNET_INGRESS_FORMAT_MAP)) {
+		rc = -ENODEV;
+		goto out;
+	}
+
+	if ((b->config->ingress_data_format & RMNET_INGRESS_FORMAT_MAP_CKSUMV3) ||
+	    (b->config->ingress_data_format & RMNET_INGRESS_FORMAT_MAP_CKSUMV4))
+		trailer = sizeof(struct rmnet_map_dl_checksum_trailer_s);
+
+	b->frame_len = bench_pkts_per_agg * (sizeof(struct rmnet_map_header_s) +
+					     bench_pkt_len + trailer);
+	if (b->frame_len > U16_MAX) {
+		rc = -EINVAL;
+		goto out;
+	}
+
+	rc = rmnet_bench_build_frame(b, trailer);
+	if (rc)
+		goto out;
+
+	vnd = b->config->muxed_ep[bench_mux_id].egress_dev;
+	if (vnd)
+		vnd_rx = vnd->stats.rx_packets;
+	rmnet_stats_skb_free_get(before);
+
+	b->frames = 0;
+	b->pkts = 0;
+	b->deagg_ns = 0;
+	b->rx_ns = 0;
+	b->flush_ns = 0;
+	b->remaining = frames;
+	reinit_completion(&b->done);
+
+	start = local_clock();
+	local_bh_disable();
+	napi_schedule(&b->napi);
+	local_bh_enable();
+
+	if (!wait_for_completion_timeout(&b->done, RMNET_BENCH_TIMEOUT)) {
+		/* Let the poll loop run dry before the template goes away */
+		b->remaining = 0;
+		wait_for_completion(&b->done);
+		rc = -ETIMEDOUT;
+	}
+	b->elapsed_ns = local_clock() - start;
+
+	b->vnd_rx = vnd ? vnd->stats.rx_packets - vnd_rx : 0;
+	rmnet_stats_skb_free_get(b->drops);
+	for (i = 0; i < RMNET_STATS_SKBFREE_MAX; i++)
+		b->drops[i] -= before[i];
+	/* The aggregated buffers themselves are freed, not dropped */
+	b->drops[RMNET_STATS_SKBFREE_MAPINGRESS_AGGBUF] = 0;
+
+	kfree(b->frame);
+	b->frame = NULL;
+out:
+	dev_put(b->dev);
+	b->dev = NULL;
+	return rc;
+}
+
+static int set_bench_run(const char *val, const struct kernel_param *kp)
+{
+	unsigned int frames;
+	int rc;
+
+	rc = kstrtouint(val, 0, &frames);
+	if (rc)
+		return rc;
+
+	if (!rmnet_bench || !frames)
+		return -EINVAL;
+
+	mutex_lock(&rmnet_bench_lock);
+	rc = rmnet_bench_run(rmnet_bench, frames);
+	mutex_unlock(&rmnet_bench_lock);
+
+	return rc;
+}
+
+static const struct kernel_param_ops bench_run_ops = {
+	.set = set_bench_run,
+};
+module_param_cb(bench_run, &bench_run_ops, NULL, 0200);
+MODULE_PARM_DESC(bench_run, "Inject this many aggregated frames");
+
+static int get_bench_result(char *buf, const struct kernel_param *kp)
+{
+	struct rmnet_bench *b = rmnet_bench;
+	unsigned int pkts;
+	int len, i;
+
+	if (!b)
+		return -ENODEV;
+
+	mutex_lock(&rmnet_bench_lock);
+	pkts = max(b->pkts, 1U);
+	len = scnprintf(buf, PAGE_SIZE,
+			"frames %u pkts %u elapsed_us %llu pps %llu\n"
+			"ns/pkt deagg %llu rx %llu gro_flush %llu\n"
+			"vnd_rx %lu\n",
+			b->frames, b->pkts, div_u64(b->elapsed_ns, NSEC_PER_USEC),
+			div64_u64((u64)b->pkts * NSEC_PER_SEC,
+				  max_t(u64, b->elapsed_ns, 1)),
+			div_u64(b->deagg_ns, pkts), div_u64(b->rx_ns, pkts),
+			div_u64(b->flush_ns, pkts), b->vnd_rx);
+	for (i = 0; i < RMNET_STATS_SKBFREE_MAX; i++)
+		if (b->drops[i])
+			len += scnprintf(buf + len, PAGE_SIZE - len,
+					 "drop %d %lu\n", i, b->drops[i]);
+	mutex_unlock(&rmnet_bench_lock);
+
+	return len;
+}
+
+static const struct kernel_param_ops bench_result_ops = {
+	.get = get_bench_result,
+};
+module_param_cb(bench_result, &bench_result_ops, NULL, 0444);
+MODULE_PARM_DESC(bench_result, "Results of the last benchmark run");
+
+/* rmnet_bench_init() - Set up the benchmark NAPI context
+ *
+ * Return:
+ *      - 0 on success
+ *      - -ENOMEM if the benchmark state could not be allocated
+ */
+int rmnet_bench_init(void)
+{
+	struct rmnet_bench *b;
+
+	b = kzalloc(sizeof(*b), GFP_KERNEL);
+	if (!b)
+		return -ENOMEM;
+
+	init_completion(&b->done);
+	init_dummy_netdev(&b->napi_dev);
+	netif_napi_add(&b->napi_dev, &b->napi, rmnet_bench_poll,
+		       RMNET_BENCH_WEIGHT);
+	napi_enable(&b->napi);
+
+	rmnet_bench = b;
+	return 0;
+}
@@ -33,6 +33,8 @@
  * @mux_id: Virtual channel ID used by MAP protocol
  * @egress_dev: Next device to deliver the packet to. Exact usage of this
  *            parmeter depends on the rmnet_mode
+ * @gro_batch_bytes: Bytes given to GRO from the aggregated frame being
+ *            deaggregated, not yet accounted by the GRO flush logic
  */
 struct rmnet_logical_ep_conf_s {
 	struct net_device *egress_dev;
@@ -40,6 +42,7 @@ struct rmnet_logical_ep_conf_s {
 	long curr_time_limit;
 	unsigned int flush_byte_count;
 	unsigned int curr_byte_threshold;
+	unsigned int gro_batch_bytes;
 	u8 refcount;
 	u8 rmnet_mode;
 	u8 mux_id;
@@ -64,6 +67,12 @@ struct rmnet_logical_ep_conf_s {
  * @tail_spacing: Guaranteed padding (bytes) when de-aggregating ingress frames
  * @agg_time: Wall clock time when aggregated frame was created
  * @agg_last: Last time the aggregation routing was invoked
+ * @agg_window_start: Start of the current uplink rate measurement window
+ * @agg_window_bytes: Bytes sent to aggregation in the current window
+ * @agg_window_pkts: Packets sent to aggregation in the current window
+ * @agg_window_acks: Pure TCP ACKs sent to aggregation in the current window
+ * @agg_timer_ns: Adaptive flush timer derived from the last window, 0 if unset
+ * @agg_size_limit: Adaptive byte limit derived from the last window
  */
 struct rmnet_phys_ep_config {
 	struct net_device *dev;
@@ -86,6 +95,12 @@ struct rmnet_phys_ep_config {
 	u8 agg_count;
 	struct timespec agg_time;
 	struct timespec agg_last;
+	struct timespec agg_window_start;
+	u32 agg_window_bytes;
+	u32 agg_window_pkts;
+	u32 agg_window_acks;
+	u32 agg_timer_ns;
+	u32 agg_size_limit;
 	struct hrtimer hrtimer;
 };
 
@@ -18,9 +18,12 @@
 #include <linux/rmnet_data.h>
 #include <linux/net_map.h>
 #include <linux/netdev_features.h>
+#include <linux/percpu.h>
+#include <linux/smp.h>
 #include <linux/ip.h>
 #include <linux/ipv6.h>
 #include <net/rmnet_config.h>
+#include <net/rx_latency.h>
 #include "rmnet_data_private.h"
 #include "rmnet_data_config.h"
 #include "rmnet_data_vnd.h"
@@ -49,6 +52,14 @@ static bool dynamic_gro_on __read_mostly = 1;
 module_param(dynamic_gro_on, bool, 0644);
 MODULE_PARM_DESC(dynamic_gro_on, "Toggle to turn on dynamic gro logic");
 
+static bool gro_batch_on __read_mostly = 1;
+module_param(gro_batch_on, bool, 0644);
+MODULE_PARM_DESC(gro_batch_on, "Run GRO flush logic once per agg frame");
+
+static unsigned int steer_cpus __read_mostly;
+module_param(steer_cpus, uint, 0644);
+MODULE_PARM_DESC(steer_cpus, "Mask of CPUs ingress flows are spread over");
+
 /* Time in nano seconds. This number must be less that a second. */
 static long lower_flush_time __read_mostly = 10000L;
 module_param(lower_flush_time, long, 0644);
@@ -223,10 +234,9 @@ static void rmnet_vnd_tx_fixup(struct sk_buff *skb, struct net_device *dev)
  * Determines whether to pass the skb to the GRO handler napi_gro_receive() or
  * handle normally by passing to netif_receive_skb().
  *
- * Warning:
- * This assumes that only TCP packets can be coalesced by the GRO handler which
- * is not true in general. We lose the ability to use GRO for cases like UDP
- * encapsulation protocols.
+ * TCP and UDP packets are passed to GRO. UDP datagrams are only coalesced for
+ * sockets that set UDP_GRO and for UDP encapsulation protocols, anything else
+ * is flushed out by the GRO handler right away.
  *
  * Return:
  *      - RMNET_DATA_GRO_RCV_FAIL if packet is sent to netif_receive_skb()
@@ -236,11 +246,13 @@ static int rmnet_check_skb_can_gro(struct sk_buff *skb)
 {
 	switch (skb->data[0] & 0xF0) {
 	case RMNET_DATA_IP_VERSION_4:
-		if (ip_hdr(skb)->protocol == IPPROTO_TCP)
+		if (ip_hdr(skb)->protocol == IPPROTO_TCP ||
+		    ip_hdr(skb)->protocol == IPPROTO_UDP)
 			return RMNET_DATA_GRO_RCV_PASS;
 		break;
 	case RMNET_DATA_IP_VERSION_6:
-		if (ipv6_hdr(skb)->nexthdr == IPPROTO_TCP)
+		if (ipv6_hdr(skb)->nexthdr == IPPROTO_TCP ||
+		    ipv6_hdr(skb)->nexthdr == IPPROTO_UDP)
 			return RMNET_DATA_GRO_RCV_PASS;
 		/* Fall through */
 	}
@@ -325,7 +337,179 @@ static void rmnet_optional_gro_flush(struct napi_struct *napi,
 	}
 }
 
+/* Flow steering
+ *
+ * With steer_cpus set, packets delivered to a VND are spread over the CPUs of
+ * the mask by their flow hash, so that the network stack does not run on the
+ * CPU of the physical device alone. All packets of a flow are queued to the
+ * same CPU, which keeps them in order as long as the mask is not changed.
+ * The checksum offload result of the MAP trailer has already been applied to
+ * the packet at this point, so the target CPU does not verify it again.
+ *
+ * Every CPU has a backlog modeled on the one of RPS: packets are queued to
+ * input_queue, and the NAPI context of the CPU is scheduled through an IPI
+ * when it is not running yet. The NAPI context processes the packets in
+ * process_queue without holding the queue lock.
+ */
+struct rmnet_steer_cpu {
+	struct sk_buff_head input_queue;
+	struct sk_buff_head process_queue;
+	struct napi_struct napi;
+	struct call_single_data csd;
+};
+
+static DEFINE_PER_CPU_ALIGNED(struct rmnet_steer_cpu, rmnet_steer_cpus);
+
+static void rmnet_steer_receive(struct napi_struct *napi, struct sk_buff *skb)
+{
+	gro_result_t gro_res;
+
+	if (rmnet_check_skb_can_gro(skb) &&
+	    (skb->dev->features & NETIF_F_GRO)) {
+		gro_res = napi_gro_receive(napi, skb);
+		trace_rmnet_gro_downlink(gro_res);
+	} else {
+		netif_receive_skb(skb);
+	}
+}
+
+static int rmnet_steer_poll(struct napi_struct *napi, int budget)
+{
+	struct rmnet_steer_cpu *sc = container_of(napi, struct rmnet_steer_cpu,
+						  napi);
+	struct sk_buff *skb;
+	int work = 0;
+
+	while (1) {
+		while ((skb = __skb_dequeue(&sc->process_queue))) {
+			rmnet_steer_receive(napi, skb);
+			if (++work >= budget)
+				return work;
+		}
+
+		napi_gro_flush(napi, false);
+
+		spin_lock_irq(&sc->input_queue.lock);
+		if (skb_queue_empty(&sc->input_queue)) {
+			/* Only the owner of the queue lock clears the state */
+			napi->state = 0;
+			spin_unlock_irq(&sc->input_queue.lock);
+			break;
+		}
+		skb_queue_splice_tail_init(&sc->input_queue,
+					   &sc->process_queue);
+		spin_unlock_irq(&sc->input_queue.lock);
+	}
+
+	return work;
+}
+
+static void rmnet_steer_ipi(void *data)
+{
+	struct rmnet_steer_cpu *sc = data;
+
+	__napi_schedule_irqoff(&sc->napi);
+}
+
+/* rmnet_steer_cpu() - Select the CPU a packet is processed on
+ * @skb:     Packet being delivered
+ *
+ * Return:
+ *      - CPU of the steer_cpus mask the flow of the packet is assigned to
+ *      - -1 if the packet should be processed on the current CPU
+ */
+static int rmnet_steer_cpu(struct sk_buff *skb)
+{
+	unsigned long mask;
+	unsigned int idx;
+	int cpu;
+
+	mask = READ_ONCE(steer_cpus) & cpumask_bits(cpu_online_mask)[0];
+	if (!mask)
+		return -1;
+
+	idx = reciprocal_scale(skb_get_hash(skb), hweight_long(mask));
+	for_each_set_bit(cpu, &mask, BITS_PER_LONG)
+		if (!idx--)
+			break;
+
+	return cpu == smp_processor_id() ? -1 : cpu;
+}
+
+/* rmnet_steer_skb() - Queue a packet to the backlog of its flow's CPU
+ * @skb:     Packet being delivered
+ *
+ * Return:
+ *      - true if the packet was queued or dropped
+ *      - false if the packet should be delivered on the current CPU
+ */
+static bool rmnet_steer_skb(struct sk_buff *skb)
+{
+	struct rmnet_steer_cpu *sc;
+	unsigned long flags;
+	int cpu;
+
+	cpu = rmnet_steer_cpu(skb);
+	if (cpu < 0)
+		return false;
+
+	sc = &per_cpu(rmnet_steer_cpus, cpu);
+	spin_lock_irqsave(&sc->input_queue.lock, flags);
+	if (unlikely(skb_queue_len(&sc->input_queue) +
+		     skb_queue_len(&sc->process_queue) >=
+		     READ_ONCE(netdev_max_backlog))) {
+		spin_unlock_irqrestore(&sc->input_queue.lock, flags);
+		rmnet_kfree_skb(skb, RMNET_STATS_SKBFREE_STEER_BACKLOG);
+		return true;
+	}
+
+	__skb_queue_tail(&sc->input_queue, skb);
+	if (!__test_and_set_bit(NAPI_STATE_SCHED, &sc->napi.state) &&
+	    smp_call_function_single_async(cpu, &sc->csd))
+		/* CPU went offline, drain the backlog from here */
+		__napi_schedule_irqoff(&sc->napi);
+	spin_unlock_irqrestore(&sc->input_queue.lock, flags);
+
+	return true;
+}
+
+void rmnet_steer_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct rmnet_steer_cpu *sc = &per_cpu(rmnet_steer_cpus, cpu);
+
+		skb_queue_head_init(&sc->input_queue);
+		__skb_queue_head_init(&sc->process_queue);
+		sc->napi.poll = rmnet_steer_poll;
+		sc->napi.weight = NAPI_POLL_WEIGHT;
+		sc->csd.func = rmnet_steer_ipi;
+		sc->csd.info = sc;
+	}
+}
+
+/* rmnet_gro_batch_flush() - Run the GRO flush logic for a batch of packets
+ * @ep:      Logical endpoint the batched packets were delivered on
+ *
+ * Packets deaggregated from the same frame are handed to GRO back to back,
+ * the flush decision is only taken once the whole frame has been processed.
+ */
+static void rmnet_gro_batch_flush(struct rmnet_logical_ep_conf_s *ep)
+{
+	unsigned int bytes = ep->gro_batch_bytes;
+
+	if (!bytes)
+		return;
+
+	ep->gro_batch_bytes = 0;
+	rmnet_optional_gro_flush(get_current_napi_context(), ep, bytes);
+}
+
 /* __rmnet_deliver_skb() - Deliver skb
+ * @skb:       Packet being delivered
+ * @ep:        Logical endpoint the packet is delivered on
+ * @gro_batch: Defer the GRO flush logic to rmnet_gro_batch_flush()
  *
  * Determines where to deliver skb. Options are: consume by network stack,
  * pass to bridge handler, or pass to virtual network device
@@ -335,7 +519,8 @@ static void rmnet_optional_gro_flush(struct napi_struct *napi,
  *      - RX_HANDLER_PASS if packet is to be consumed by network stack as-is
  */
 static rx_handler_result_t __rmnet_deliver_skb
-	(struct sk_buff *skb, struct rmnet_logical_ep_conf_s *ep)
+	(struct sk_buff *skb, struct rmnet_logical_ep_conf_s *ep,
+	 bool gro_batch)
 {
 	struct napi_struct *napi = NULL;
 	gro_result_t gro_res;
@@ -347,10 +532,14 @@ static rx_handler_result_t __rmnet_deliver_skb
 		skb_reset_transport_header(skb);
 		skb_reset_network_header(skb);
 		rmnet_vnd_rx_fixup(skb, skb->dev);
+		rx_latency_record(skb->dev, skb, RX_LAT_RMNET);
 
 		skb->pkt_type = PACKET_HOST;
 		skb_set_mac_header(skb, 0);
 
+		if (rmnet_steer_skb(skb))
+			return RX_HANDLER_CONSUMED;
+
 		if (rmnet_check_skb_can_gro(skb) &&
 		    (skb->dev->features & NETIF_F_GRO)) {
 			napi = get_current_napi_context();
@@ -359,7 +548,10 @@ static rx_handler_result_t __rmnet_deliver_skb
 			skb_get_hash(skb);
 			gro_res = napi_gro_receive(napi, skb);
 			trace_rmnet_gro_downlink(gro_res);
-			rmnet_optional_gro_flush(napi, ep, skb_size);
+			if (gro_batch)
+				ep->gro_batch_bytes += skb_size;
+			else
+				rmnet_optional_gro_flush(napi, ep, skb_size);
 		} else{
 			netif_receive_skb(skb);
 		}
@@ -405,7 +597,7 @@ static rx_handler_result_t rmnet_ingress_deliver_packet
 
 	skb->dev = config->local_ep.egress_dev;
 
-	return __rmnet_deliver_skb(skb, &config->local_ep);
+	return __rmnet_deliver_skb(skb, &config->local_ep, false);
 }
 
 /* MAP handler */
@@ -413,6 +605,7 @@ static rx_handler_result_t rmnet_ingress_deliver_packet
 /* _rmnet_map_ingress_handler() - Actual MAP ingress handler
  * @skb:        Packet being received
  * @config:     Physical endpoint configuration for the ingress device
+ * @batch_ep:   Logical endpoint with pending GRO batch, NULL if not batching
  *
  * Most MAP ingress functions are processed here. Packets are processed
  * individually; aggregated packets should use rmnet_map_ingress_handler()
@@ -422,7 +615,8 @@ static rx_handler_result_t rmnet_ingress_deliver_packet
  *      - result of __rmnet_deliver_skb() for all other cases
  */
 static rx_handler_result_t _rmnet_map_ingress_handler
-	(struct sk_buff *skb, struct rmnet_phys_ep_config *config)
+	(struct sk_buff *skb, struct rmnet_phys_ep_config *config,
+	 struct rmnet_logical_ep_conf_s **batch_ep)
 {
 	struct rmnet_logical_ep_conf_s *ep;
 	u8 mux_id;
@@ -486,9 +680,16 @@ static rx_handler_result_t _rmnet_map_ingress_handler
 
 	/* Subtract MAP header */
 	skb_pull(skb, sizeof(struct rmnet_map_header_s));
-	skb_trim(skb, len);
+	pskb_trim(skb, len);
 	__rmnet_data_set_skb_proto(skb);
-	return __rmnet_deliver_skb(skb, ep);
+
+	if (batch_ep) {
+		if (*batch_ep && *batch_ep != ep)
+			rmnet_gro_batch_flush(*batch_ep);
+		*batch_ep = ep;
+	}
+
+	return __rmnet_deliver_skb(skb, ep, !!batch_ep);
 }
 
 /* rmnet_map_ingress_handler() - MAP ingress handler
@@ -507,18 +708,23 @@ static rx_handler_result_t _rmnet_map_ingress_handler
 static rx_handler_result_t rmnet_map_ingress_handler
 	(struct sk_buff *skb, struct rmnet_phys_ep_config *config)
 {
+	struct rmnet_logical_ep_conf_s *batch_ep = NULL;
 	struct sk_buff *skbn;
+	bool gro_batch = gro_batch_on;
 	int rc;
 
 	if (config->ingress_data_format & RMNET_INGRESS_FORMAT_DEAGGREGATION) {
 		trace_rmnet_start_deaggregation(skb);
 		while ((skbn = rmnet_map_deaggregate(skb, config)) != 0) {
-			_rmnet_map_ingress_handler(skbn, config);
+			_rmnet_map_ingress_handler(skbn, config,
+						   gro_batch ? &batch_ep : NULL);
 		}
+		if (batch_ep)
+			rmnet_gro_batch_flush(batch_ep);
 		rmnet_kfree_skb(skb, RMNET_STATS_SKBFREE_MAPINGRESS_AGGBUF);
 		rc = RX_HANDLER_CONSUMED;
 	} else {
-		rc = _rmnet_map_ingress_handler(skb, config);
+		rc = _rmnet_map_ingress_handler(skb, config, NULL);
 	}
 
 	return rc;
@@ -612,7 +818,9 @@ static int rmnet_map_egress_handler(struct sk_buff *skb,
 			if (unlikely(__skb_linearize(skb)))
 				return RMNET_MAP_SUCCESS;
 
-		rmnet_map_aggregate(skb, config);
+		rmnet_map_aggregate(skb, config,
+				    rmnet_map_ul_classify(skb,
+							  required_headroom));
 		return RMNET_MAP_CONSUMED;
 	}
 
@@ -20,4 +20,6 @@ void rmnet_egress_handler(struct sk_buff *skb,
 
 rx_handler_result_t rmnet_rx_handler(struct sk_buff **pskb);
 
+void rmnet_steer_init(void);
+
 #endif /* _RMNET_DATA_HANDLERS_H_ */
@@ -43,6 +43,8 @@ static int __init rmnet_init(void)
 {
 	rmnet_config_init();
 	rmnet_vnd_init();
+	rmnet_steer_init();
+	rmnet_bench_init();
 
 	LOGL("%s", "RMNET Data driver loaded successfully");
 	return 0;
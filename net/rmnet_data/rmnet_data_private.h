@@ -73,4 +73,13 @@ extern unsigned int rmnet_data_log_module_mask;
 				  ##__VA_ARGS__); \
 			} while (0)
 
+#ifdef CONFIG_RMNET_DATA_BENCH
+int rmnet_bench_init(void);
+#else
+static inline int rmnet_bench_init(void)
+{
+	return 0;
+}
+#endif /* CONFIG_RMNET_DATA_BENCH */
+
 #endif /* _RMNET_DATA_PRIVATE_H_ */
@@ -70,6 +70,18 @@ void rmnet_kfree_skb(struct sk_buff *skb, unsigned int reason)
 	kfree_skb(skb);
 }
 
+/* rmnet_stats_skb_free_get() - Snapshot the skb free counters
+ * @counts:     Array of RMNET_STATS_SKBFREE_MAX entries to fill
+ */
+void rmnet_stats_skb_free_get(unsigned long *counts)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&rmnet_skb_free_lock, flags);
+	memcpy(counts, skb_free, sizeof(skb_free));
+	spin_unlock_irqrestore(&rmnet_skb_free_lock, flags);
+}
+
 void rmnet_stats_queue_xmit(int rc, unsigned int reason)
 {
 	unsigned long flags;
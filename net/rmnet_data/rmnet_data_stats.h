@@ -40,6 +40,7 @@ enum rmnet_skb_free_e {
 	RMNET_STATS_SKBFREE_INGRESS_BAD_MAP_CKSUM,
 	RMNET_STATS_SKBFREE_MAPC_UNSUPPORTED,
 	RMNET_STATS_SKBFREE_MAPINGRESS_MUX_NO_EP,
+	RMNET_STATS_SKBFREE_STEER_BACKLOG,
 	RMNET_STATS_SKBFREE_MAX
 };
 
@@ -54,6 +55,7 @@ enum rmnet_queue_xmit_e {
 };
 
 void rmnet_kfree_skb(struct sk_buff *skb, unsigned int reason);
+void rmnet_stats_skb_free_get(unsigned long *counts);
 void rmnet_stats_queue_xmit(int rc, unsigned int reason);
 void rmnet_stats_deagg_pkts(int aggcount);
 void rmnet_stats_agg_pkts(int aggcount);
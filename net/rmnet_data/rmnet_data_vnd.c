@@ -20,6 +20,7 @@
 #include <linux/if_arp.h>
 #include <linux/spinlock.h>
 #include <net/pkt_sched.h>
+#include <net/rx_latency.h>
 #include <linux/atomic.h>
 #include <linux/net_map.h>
 #include "rmnet_data_config.h"
@@ -558,6 +559,13 @@ int rmnet_vnd_create_dev(int id, struct net_device **new_device,
 		return RMNET_CONFIG_NOMEM;
 	}
 
+	if (netdev_rx_latency_alloc(dev)) {
+		LOGE("Failed to allocate latency stats for id %d", id);
+		free_netdev(dev);
+		*new_device = 0;
+		return RMNET_CONFIG_NOMEM;
+	}
+
 	if (!prefix) {
 		/* Configuring DL checksum offload on rmnet_data interfaces */
 		dev->hw_features = NETIF_F_RXCSUM;
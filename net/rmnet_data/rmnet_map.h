@@ -131,6 +131,13 @@ enum rmnet_map_agg_state_e {
 #define RMNET_MAP_NO_PAD_BYTES        0
 #define RMNET_MAP_ADD_PAD_BYTES       1
 
+/* Uplink traffic classes used by the adaptive aggregation */
+enum rmnet_map_ul_class_e {
+	RMNET_MAP_UL_BULK,
+	RMNET_MAP_UL_ACK,
+	RMNET_MAP_UL_URGENT
+};
+
 uint8_t rmnet_map_demultiplex(struct sk_buff *skb);
 struct sk_buff *rmnet_map_deaggregate(struct sk_buff *skb,
 				      struct rmnet_phys_ep_config *config);
@@ -140,12 +147,13 @@ struct rmnet_map_header_s *rmnet_map_add_map_header(struct sk_buff *skb,
 rx_handler_result_t rmnet_map_command(struct sk_buff *skb,
 				      struct rmnet_phys_ep_config *config);
 void rmnet_map_aggregate(struct sk_buff *skb,
-			 struct rmnet_phys_ep_config *config);
+			 struct rmnet_phys_ep_config *config, int ul_class);
 
 int rmnet_map_checksum_downlink_packet(struct sk_buff *skb);
 int rmnet_map_checksum_uplink_packet(struct sk_buff *skb,
 				     struct net_device *orig_dev,
 				     u32 egress_data_format);
 int rmnet_ul_aggregation_skip(struct sk_buff *skb, int offset);
+int rmnet_map_ul_classify(struct sk_buff *skb, int offset);
 enum hrtimer_restart rmnet_map_flush_packet_queue(struct hrtimer *t);
 #endif /* _RMNET_MAP_H_ */
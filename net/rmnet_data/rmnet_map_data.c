@@ -20,6 +20,7 @@
 #include <linux/spinlock.h>
 #include <linux/workqueue.h>
 #include <linux/time.h>
+#include <linux/math64.h>
 #include <linux/net_map.h>
 #include <linux/ip.h>
 #include <linux/ipv6.h>
@@ -29,6 +30,7 @@
 #include <net/ip.h>
 #include <net/checksum.h>
 #include <net/ip6_checksum.h>
+#include <net/dsfield.h>
 #include <net/rmnet_config.h>
 #include "rmnet_data_config.h"
 #include "rmnet_map.h"
@@ -48,6 +50,38 @@ long agg_bypass_time __read_mostly = 10000000L;
 module_param(agg_bypass_time, long, 0644);
 MODULE_PARM_DESC(agg_bypass_time, "Skip agg when apart spaced more than this");
 
+static bool deaggr_zero_copy __read_mostly = 1;
+module_param(deaggr_zero_copy, bool, 0644);
+MODULE_PARM_DESC(deaggr_zero_copy, "Reference page backed agg bufs on deagg");
+
+static bool agg_adaptive __read_mostly = 1;
+module_param(agg_adaptive, bool, 0644);
+MODULE_PARM_DESC(agg_adaptive, "Tune UL agg timer and size to the UL rate");
+
+static unsigned int agg_timer_min __read_mostly = 200000;
+module_param(agg_timer_min, uint, 0644);
+MODULE_PARM_DESC(agg_timer_min, "Adaptive agg flush timer floor in ns");
+
+static unsigned int agg_timer_max __read_mostly = 3000000;
+module_param(agg_timer_max, uint, 0644);
+MODULE_PARM_DESC(agg_timer_max, "Agg flush timer in ns at or above agg_rate_high");
+
+static unsigned int agg_rate_high __read_mostly = 12500000;
+module_param(agg_rate_high, uint, 0644);
+MODULE_PARM_DESC(agg_rate_high, "UL rate in bytes/s that gets the full agg timer");
+
+static unsigned int agg_ack_ratio __read_mostly = 50;
+module_param(agg_ack_ratio, uint, 0644);
+MODULE_PARM_DESC(agg_ack_ratio, "Percent of pure TCP ACKs that selects agg_timer_min");
+
+static unsigned int agg_window_ms __read_mostly = 100;
+module_param(agg_window_ms, uint, 0644);
+MODULE_PARM_DESC(agg_window_ms, "UL rate measurement window in ms");
+
+static unsigned int agg_small_pkt_len __read_mostly = 256;
+module_param(agg_small_pkt_len, uint, 0644);
+MODULE_PARM_DESC(agg_small_pkt_len, "UDP packets up to this size flush the agg buf");
+
 struct agg_work {
 	struct work_struct work;
 	struct rmnet_phys_ep_config *config;
@@ -56,6 +90,16 @@ struct agg_work {
 #define RMNET_MAP_DEAGGR_SPACING  64
 #define RMNET_MAP_DEAGGR_HEADROOM (RMNET_MAP_DEAGGR_SPACING / 2)
 
+/* Bytes copied to the linear area on zero-copy deaggregation. Covers the MAP
+ * header along with the largest IP and transport headers that are parsed.
+ */
+#define RMNET_MAP_DEAGGR_PULL     128
+
+/* Smallest adaptive byte limit, keeps a full MTU sized packet per frame */
+#define RMNET_MAP_AGG_MIN_SIZE    1600
+
+#define RMNET_MAP_DSCP_EF         46
+
 /* rmnet_map_add_map_header() - Adds MAP header to front of skb->data
  * @skb:        Socket buffer ("packet") to modify
  * @hdrlen:     Number of bytes of header data which should not be included in
@@ -110,11 +154,54 @@ struct rmnet_map_header_s *rmnet_map_add_map_header(struct sk_buff *skb,
 	return map_header;
 }
 
+/* rmnet_map_deaggregate_frag() - Deaggregates a packet without copying it
+ * @skb:        Source socket buffer with its data in a page fragment
+ * @packet_len: Length of the MAP frame at the start of skb->data
+ *
+ * Only the headers are copied into the new buffer. The rest of the frame is
+ * attached as a page fragment referencing the aggregated buffer, which stays
+ * allocated until the last packet referencing it is freed.
+ *
+ * Return:
+ *     - Pointer to new skb
+ *     - 0 (null) if the allocation failed
+ */
+static struct sk_buff *rmnet_map_deaggregate_frag(struct sk_buff *skb,
+						  u32 packet_len)
+{
+	struct sk_buff *skbn;
+	struct page *page;
+	u32 offset;
+
+	skbn = alloc_skb(RMNET_MAP_DEAGGR_PULL + RMNET_MAP_DEAGGR_SPACING,
+			 GFP_ATOMIC);
+	if (!skbn)
+		return 0;
+
+	skbn->dev = skb->dev;
+	skb_reserve(skbn, RMNET_MAP_DEAGGR_HEADROOM);
+	memcpy(skb_put(skbn, RMNET_MAP_DEAGGR_PULL), skb->data,
+	       RMNET_MAP_DEAGGR_PULL);
+
+	page = virt_to_head_page(skb->data);
+	offset = skb->data + RMNET_MAP_DEAGGR_PULL -
+		 (unsigned char *)page_address(page);
+	get_page(page);
+	skb_add_rx_frag(skbn, 0, page, offset,
+			packet_len - RMNET_MAP_DEAGGR_PULL,
+			packet_len - RMNET_MAP_DEAGGR_PULL);
+
+	return skbn;
+}
+
 /* rmnet_map_deaggregate() - Deaggregates a single packet
  * @skb:        Source socket buffer containing multiple MAP frames
  * @config:     Physical endpoint configuration of the ingress device
  *
  * A whole new buffer is allocated for each portion of an aggregated frame.
+ * If the aggregated frame lives in a page fragment, data packets larger than
+ * their headers reference it instead of being copied, see
+ * rmnet_map_deaggregate_frag().
  * Caller should keep calling deaggregate() on the source skb until 0 is
  * returned, indicating that there are no more packets to deaggregate. Caller
  * is responsible for freeing the original skb.
@@ -145,15 +232,30 @@ struct sk_buff *rmnet_map_deaggregate(struct sk_buff *skb,
 		return 0;
 	}
 
-	skbn = alloc_skb(packet_len + RMNET_MAP_DEAGGR_SPACING, GFP_ATOMIC);
-	if (!skbn)
-		return 0;
-
-	skbn->dev = skb->dev;
-	skb_reserve(skbn, RMNET_MAP_DEAGGR_HEADROOM);
-	skb_put(skbn, packet_len);
-	memcpy(skbn->data, skb->data, packet_len);
+	if (deaggr_zero_copy && skb->head_frag && !maph->cd_bit &&
+	    packet_len > RMNET_MAP_DEAGGR_PULL &&
+	    packet_len <= skb_headlen(skb)) {
+		skbn = rmnet_map_deaggregate_frag(skb, packet_len);
+		if (!skbn)
+			return 0;
+	} else {
+		skbn = alloc_skb(packet_len + RMNET_MAP_DEAGGR_SPACING,
+				 GFP_ATOMIC);
+		if (!skbn)
+			return 0;
+
+		skbn->dev = skb->dev;
+		skb_reserve(skbn, RMNET_MAP_DEAGGR_HEADROOM);
+		skb_put(skbn, packet_len);
+		memcpy(skbn->data, skb->data, packet_len);
+	}
 	skb_pull(skb, packet_len);
+	/* Keep the driver's receive stamp for SO_TIMESTAMP and rx_latency */
+	skbn->tstamp = skb->tstamp;
+#ifdef CONFIG_NET_RX_BUSY_POLL
+	/* Sockets receiving from the VND busy poll the physical device */
+	skbn->napi_id = skb->napi_id;
+#endif
 
 	/* Some hardware can send us empty frames. Catch them */
 	if (ntohs(maph->pkt_len) == 0) {
@@ -231,31 +333,115 @@ enum hrtimer_restart rmnet_map_flush_packet_queue(struct hrtimer *t)
 	return HRTIMER_NORESTART;
 }
 
+/* rmnet_map_agg_account() - Updates the adaptive aggregation limits
+ * @skb:        current packet being transmitted
+ * @config:     Physical endpoint configuration of the egress device
+ * @ul_class:   uplink traffic class of the packet
+ *
+ * Measures the uplink rate and the share of pure TCP ACKs over windows of
+ * agg_window_ms. At the end of each window the flush timer is scaled linearly
+ * from agg_timer_min up to agg_timer_max at agg_rate_high, and the byte limit
+ * is set to what that rate fills in one timer period. ACK dominated uplink,
+ * i.e. a download, always uses agg_timer_min so ACKs are not held back.
+ *
+ * Must be called with the agg_lock held, after agg_last was updated.
+ */
+static void rmnet_map_agg_account(struct sk_buff *skb,
+				  struct rmnet_phys_ep_config *config,
+				  int ul_class)
+{
+	u64 ns, rate, timer, limit;
+	struct timespec diff;
+
+	config->agg_window_bytes += skb->len;
+	config->agg_window_pkts++;
+	if (ul_class == RMNET_MAP_UL_ACK)
+		config->agg_window_acks++;
+
+	if (!config->agg_window_start.tv_sec &&
+	    !config->agg_window_start.tv_nsec) {
+		config->agg_window_start = config->agg_last;
+		return;
+	}
+
+	diff = timespec_sub(config->agg_last, config->agg_window_start);
+	ns = timespec_to_ns(&diff);
+	if (ns < (u64)agg_window_ms * NSEC_PER_MSEC)
+		return;
+
+	rate = div64_u64((u64)config->agg_window_bytes * NSEC_PER_SEC, ns);
+	if (agg_timer_max <= agg_timer_min || !agg_rate_high ||
+	    config->agg_window_acks * 100ULL >=
+	    (u64)config->agg_window_pkts * agg_ack_ratio)
+		timer = agg_timer_min;
+	else
+		timer = agg_timer_min +
+			div_u64((u64)(agg_timer_max - agg_timer_min) *
+				min_t(u64, rate, agg_rate_high),
+				agg_rate_high);
+
+	limit = div_u64(rate * timer, NSEC_PER_SEC);
+	config->agg_timer_ns = max_t(u64, timer, 1);
+	config->agg_size_limit = clamp_t(u64, limit, RMNET_MAP_AGG_MIN_SIZE,
+					 U16_MAX);
+
+	config->agg_window_start = config->agg_last;
+	config->agg_window_bytes = 0;
+	config->agg_window_pkts = 0;
+	config->agg_window_acks = 0;
+}
+
 /* rmnet_map_aggregate() - Software aggregates multiple packets.
  * @skb:        current packet being transmitted
  * @config:     Physical endpoint configuration of the ingress device
+ * @ul_class:   uplink traffic class of the packet, see rmnet_map_ul_classify()
  *
  * Aggregates multiple SKBs into a single large SKB for transmission. MAP
  * protocol is used to separate the packets in the buffer. This function
  * consumes the argument SKB and should not be further processed by any other
  * function.
+ *
+ * With agg_adaptive set, the flush timer and byte limit follow the measured
+ * uplink rate, and latency sensitive packets are sent right away together
+ * with whatever was aggregated before them.
  */
 void rmnet_map_aggregate(struct sk_buff *skb,
-			 struct rmnet_phys_ep_config *config) {
+			 struct rmnet_phys_ep_config *config, int ul_class) {
 	u8 *dest_buff;
 	unsigned long flags;
 	struct sk_buff *agg_skb;
 	struct timespec diff, last;
 	int size, rc, agg_count = 0;
+	bool adaptive = agg_adaptive, accounted = false, urgent;
+	u32 size_limit, timer_ns;
+	long time_limit;
 
 	if (!skb || !config)
 		return;
 
+	urgent = adaptive && ul_class == RMNET_MAP_UL_URGENT;
+
 new_packet:
 	spin_lock_irqsave(&config->agg_lock, flags);
 	memcpy(&last, &config->agg_last, sizeof(struct timespec));
 	getnstimeofday(&config->agg_last);
 
+	size_limit = config->egress_agg_size;
+	timer_ns = agg_timer_max;
+	time_limit = agg_time_limit;
+	if (adaptive) {
+		if (!accounted) {
+			rmnet_map_agg_account(skb, config, ul_class);
+			accounted = true;
+		}
+		if (config->agg_timer_ns) {
+			size_limit = min_t(u32, size_limit,
+					   config->agg_size_limit);
+			timer_ns = config->agg_timer_ns;
+			time_limit = min_t(long, time_limit, timer_ns);
+		}
+	}
+
 	if (!config->agg_skb) {
 		/* Check to see if we should agg first. If the traffic is very
 		 * sparse, don't aggregate. We will need to tune this later
@@ -264,7 +450,7 @@ void rmnet_map_aggregate(struct sk_buff *skb,
 		size = config->egress_agg_size - skb->len;
 
 		if ((diff.tv_sec > 0) || (diff.tv_nsec > agg_bypass_time) ||
-		    (size <= 0)) {
+		    (size <= 0) || urgent) {
 			spin_unlock_irqrestore(&config->agg_lock, flags);
 			LOGL("delta t: %ld.%09lu\tcount: bypass", diff.tv_sec,
 			     diff.tv_nsec);
@@ -298,9 +484,9 @@ void rmnet_map_aggregate(struct sk_buff *skb,
 	}
 	diff = timespec_sub(config->agg_last, config->agg_time);
 
-	if (skb->len > (config->egress_agg_size - config->agg_skb->len) ||
+	if (config->agg_skb->len + skb->len > size_limit ||
 	    (config->agg_count >= config->egress_agg_count) ||
-	    (diff.tv_sec > 0) || (diff.tv_nsec > agg_time_limit)) {
+	    (diff.tv_sec > 0) || (diff.tv_nsec > time_limit)) {
 		rmnet_stats_agg_pkts(config->agg_count);
 		agg_skb = config->agg_skb;
 		agg_count = config->agg_count;
@@ -324,10 +510,28 @@ void rmnet_map_aggregate(struct sk_buff *skb,
 	config->agg_count++;
 	dev_kfree_skb_any(skb);
 
+	if (urgent) {
+		/* Send the latency sensitive packet without waiting */
+		rmnet_stats_agg_pkts(config->agg_count);
+		agg_skb = config->agg_skb;
+		agg_count = config->agg_count;
+		config->agg_skb = 0;
+		config->agg_count = 0;
+		memset(&config->agg_time, 0, sizeof(struct timespec));
+		config->agg_state = RMNET_MAP_AGG_IDLE;
+		spin_unlock_irqrestore(&config->agg_lock, flags);
+		hrtimer_cancel(&config->hrtimer);
+		trace_rmnet_map_aggregate(agg_skb, agg_count);
+		rc = dev_queue_xmit(agg_skb);
+		rmnet_stats_queue_xmit(rc,
+				       RMNET_STATS_QUEUE_XMIT_AGG_FILL_BUFFER);
+		return;
+	}
+
 schedule:
 	if (config->agg_state != RMNET_MAP_TXFER_SCHEDULED) {
 		config->agg_state = RMNET_MAP_TXFER_SCHEDULED;
-		hrtimer_start(&config->hrtimer, ns_to_ktime(3000000),
+		hrtimer_start(&config->hrtimer, ns_to_ktime(timer_ns),
 			      HRTIMER_MODE_REL);
 	}
 	spin_unlock_irqrestore(&config->agg_lock, flags);
@@ -581,7 +785,7 @@ static int rmnet_map_validate_ipv6_packet_checksum
  */
 int rmnet_map_checksum_downlink_packet(struct sk_buff *skb)
 {
-	struct rmnet_map_dl_checksum_trailer_s *cksum_trailer;
+	struct rmnet_map_dl_checksum_trailer_s *cksum_trailer, trailer;
 	unsigned int data_len;
 	unsigned char *map_payload;
 	unsigned char ip_version;
@@ -592,9 +796,12 @@ int rmnet_map_checksum_downlink_packet(struct sk_buff *skb)
 	    sizeof(struct rmnet_map_dl_checksum_trailer_s))))
 		return RMNET_MAP_CHECKSUM_ERR_BAD_BUFFER;
 
-	cksum_trailer = (struct rmnet_map_dl_checksum_trailer_s *)
-			(skb->data + data_len
-			+ sizeof(struct rmnet_map_header_s));
+	/* The trailer is in a page fragment for zero-copy deaggregation */
+	cksum_trailer = skb_header_pointer(skb,
+			data_len + sizeof(struct rmnet_map_header_s),
+			sizeof(trailer), &trailer);
+	if (unlikely(!cksum_trailer))
+		return RMNET_MAP_CHECKSUM_ERR_BAD_BUFFER;
 
 	if (unlikely(!ntohs(cksum_trailer->valid)))
 		return RMNET_MAP_CHECKSUM_VALID_FLAG_NOT_SET;
@@ -757,6 +964,61 @@ int rmnet_map_checksum_uplink_packet(struct sk_buff *skb,
 	return ret;
 }
 
+/* rmnet_map_ul_classify() - Classifies an uplink packet for aggregation
+ * @skb:        Packet with its MAP headers, linear up to the IP payload
+ * @offset:     Offset of the IP header in skb->data
+ *
+ * Return:
+ *   - RMNET_MAP_UL_URGENT for DSCP EF packets and small UDP packets
+ *   - RMNET_MAP_UL_ACK for TCP segments without payload, SYN or FIN
+ *   - RMNET_MAP_UL_BULK for everything else
+ */
+int rmnet_map_ul_classify(struct sk_buff *skb, int offset)
+{
+	unsigned char *packet_start = skb->data + offset;
+	unsigned int len = skb->len - offset;
+	unsigned int hdrlen, payload;
+	struct tcphdr *th;
+	u8 dsfield, proto;
+
+	if (skb_headlen(skb) < offset + sizeof(struct ipv6hdr))
+		return RMNET_MAP_UL_BULK;
+
+	if ((skb->data[offset]) >> 4 == 0x04) {
+		struct iphdr *ip4h = (struct iphdr *)(packet_start);
+
+		dsfield = ipv4_get_dsfield(ip4h);
+		proto = ip4h->protocol;
+		hdrlen = ip4h->ihl * 4;
+		payload = ntohs(ip4h->tot_len) - hdrlen;
+	} else if ((skb->data[offset]) >> 4 == 0x06) {
+		struct ipv6hdr *ip6h = (struct ipv6hdr *)(packet_start);
+
+		dsfield = ipv6_get_dsfield(ip6h);
+		proto = ip6h->nexthdr;
+		hdrlen = sizeof(struct ipv6hdr);
+		payload = ntohs(ip6h->payload_len);
+	} else {
+		return RMNET_MAP_UL_BULK;
+	}
+
+	if ((dsfield >> 2) == RMNET_MAP_DSCP_EF)
+		return RMNET_MAP_UL_URGENT;
+
+	if (proto == IPPROTO_UDP && len <= agg_small_pkt_len)
+		return RMNET_MAP_UL_URGENT;
+
+	if (proto != IPPROTO_TCP ||
+	    skb_headlen(skb) < offset + hdrlen + sizeof(struct tcphdr))
+		return RMNET_MAP_UL_BULK;
+
+	th = (struct tcphdr *)(packet_start + hdrlen);
+	if (th->ack && !th->syn && !th->fin && payload == th->doff * 4)
+		return RMNET_MAP_UL_ACK;
+
+	return RMNET_MAP_UL_BULK;
+}
+
 int rmnet_ul_aggregation_skip(struct sk_buff *skb, int offset)
 {
 	unsigned char *packet_start = skb->data + offset;
@@ -63,6 +63,12 @@ static inline void chacha20_init(struct chacha20_ctx *ctx,
 void chacha20(struct chacha20_ctx *ctx, u8 *dst, const u8 *src, u32 len,
 	      simd_context_t *simd_context);
 
+/* Generates nblocks of keystream for each of four independent contexts, the
+ * one of ctx[i] being written to stream + i * stride.
+ */
+void chacha20_x4(struct chacha20_ctx ctx[4], u8 *stream, const size_t stride,
+		 u32 nblocks, simd_context_t *simd_context);
+
 void hchacha20(u32 derived_key[CHACHA20_KEY_WORDS],
 	       const u8 nonce[HCHACHA20_NONCE_SIZE],
 	       const u8 key[HCHACHA20_KEY_SIZE], simd_context_t *simd_context);
@@ -6,6 +6,7 @@
 #ifndef _ZINC_CHACHA20POLY1305_H
 #define _ZINC_CHACHA20POLY1305_H
 
+#include <zinc/chacha20.h>
 #include <linux/simd.h>
 #include <linux/types.h>
 
@@ -17,6 +18,21 @@ enum chacha20poly1305_lengths {
 	CHACHA20POLY1305_AUTHTAG_SIZE = 16
 };
 
+enum chacha20poly1305_batch_lengths {
+	CHACHA20POLY1305_BATCH_SIZE = 4,
+	CHACHA20POLY1305_BATCH_BLOCKS = 3
+};
+
+/* The leading keystream of one message of a batch, block 0 of which keys
+ * poly1305. Filled by chacha20poly1305_batch_init() and consumed by the
+ * _batch variants of the in-place functions.
+ */
+struct chacha20poly1305_batch_stream {
+	u8 block[CHACHA20POLY1305_BATCH_BLOCKS * CHACHA20_BLOCK_SIZE];
+	u32 len;
+	u32 pos;
+} __aligned(16);
+
 void chacha20poly1305_encrypt(u8 *dst, const u8 *src, const size_t src_len,
 			      const u8 *ad, const size_t ad_len,
 			      const u64 nonce,
@@ -27,6 +43,19 @@ bool __must_check chacha20poly1305_encrypt_sg_inplace(
 	const size_t ad_len, const u64 nonce,
 	const u8 key[CHACHA20POLY1305_KEY_SIZE], simd_context_t *simd_context);
 
+void chacha20poly1305_batch_init(
+	struct chacha20poly1305_batch_stream stream[CHACHA20POLY1305_BATCH_SIZE],
+	const u64 nonce[CHACHA20POLY1305_BATCH_SIZE], const size_t nr,
+	const size_t max_len, const u8 key[CHACHA20POLY1305_KEY_SIZE],
+	simd_context_t *simd_context);
+
+bool __must_check chacha20poly1305_encrypt_sg_inplace_batch(
+	struct scatterlist *src, const size_t src_len, const u8 *ad,
+	const size_t ad_len, const u64 nonce,
+	const u8 key[CHACHA20POLY1305_KEY_SIZE],
+	struct chacha20poly1305_batch_stream *stream,
+	simd_context_t *simd_context);
+
 bool __must_check
 chacha20poly1305_decrypt(u8 *dst, const u8 *src, const size_t src_len,
 			 const u8 *ad, const size_t ad_len, const u64 nonce,
@@ -37,6 +66,13 @@ bool __must_check chacha20poly1305_decrypt_sg_inplace(
 	const size_t ad_len, const u64 nonce,
 	const u8 key[CHACHA20POLY1305_KEY_SIZE], simd_context_t *simd_context);
 
+bool __must_check chacha20poly1305_decrypt_sg_inplace_batch(
+	struct scatterlist *src, size_t src_len, const u8 *ad,
+	const size_t ad_len, const u64 nonce,
+	const u8 key[CHACHA20POLY1305_KEY_SIZE],
+	struct chacha20poly1305_batch_stream *stream,
+	simd_context_t *simd_context);
+
 void xchacha20poly1305_encrypt(u8 *dst, const u8 *src, const size_t src_len,
 			       const u8 *ad, const size_t ad_len,
 			       const u8 nonce[XCHACHA20POLY1305_NONCE_SIZE],
@@ -15,6 +15,10 @@ asmlinkage void chacha20_arm(u8 *out, const u8 *in, const size_t len,
 asmlinkage void hchacha20_arm(const u32 state[16], u32 out[8]);
 asmlinkage void chacha20_neon(u8 *out, const u8 *in, const size_t len,
 			      const u32 key[8], const u32 counter[4]);
+#if defined(CONFIG_ZINC_ARCH_ARM64)
+asmlinkage void chacha20_neon_x4(u8 *out, const size_t stride,
+				 struct chacha20_ctx ctx[4]);
+#endif
 
 static bool chacha20_use_neon __ro_after_init;
 static bool *const chacha20_nobs[] __initconst = { &chacha20_use_neon };
@@ -68,6 +72,26 @@ static inline bool chacha20_arch(struct chacha20_ctx *ctx, u8 *dst,
 	return true;
 }
 
+static inline bool chacha20_x4_arch(struct chacha20_ctx ctx[4], u8 *stream,
+				    const size_t stride, u32 nblocks,
+				    simd_context_t *simd_context)
+{
+#if defined(CONFIG_ZINC_ARCH_ARM64)
+	/* The assembly reads the four contexts as consecutive states. */
+	BUILD_BUG_ON(sizeof(*ctx) != CHACHA20_BLOCK_SIZE);
+
+	if (!IS_ENABLED(CONFIG_KERNEL_MODE_NEON) || !chacha20_use_neon ||
+	    !simd_use(simd_context))
+		return false;
+
+	for (; nblocks; --nblocks, stream += CHACHA20_BLOCK_SIZE)
+		chacha20_neon_x4(stream, stride, ctx);
+	return true;
+#else
+	return false;
+#endif
+}
+
 static inline bool hchacha20_arch(u32 derived_key[CHACHA20_KEY_WORDS],
 				  const u8 nonce[HCHACHA20_NONCE_SIZE],
 				  const u8 key[HCHACHA20_KEY_SIZE],
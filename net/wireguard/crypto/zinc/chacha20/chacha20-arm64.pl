@@ -1141,6 +1141,99 @@ ___
 }
 }}}
 
+{{{
+# chacha20_neon_x4 computes one block for each of four independent states.
+# Word i of all four states lives in the lanes of v16+i, so the rounds are
+# plain column-wise vector operations and need no shuffling. This serves
+# batches of short packets, whose keystream is only a few blocks long and
+# therefore doesn't reach the threaded path above.
+my ($out,$stride,$state)=map("x$_",(0..2));
+my @X=map("v$_.4s",(16..31));
+my @T=map("v$_.4s",(0..3));
+
+sub X4ROUND {
+my @q=([@_]);
+    push(@q,[map(($_&~3)+(($_+1)&3),@{$q[$#q]})]) foreach (1..3);
+my @steps=(
+	"add a,a,b", "eor d,d,a", "rev32_16 d,d",
+	"add c,c,d", "eor t,b,c", "ushr b,t,20", "sli b,t,12",
+	"add a,a,b", "eor t,d,a", "ushr d,t,24", "sli d,t,8",
+	"add c,c,d", "eor t,b,c", "ushr b,t,25", "sli b,t,7");
+my @ret;
+
+    foreach my $step (@steps) {
+	my ($insn,$args)=split(' ',$step);
+	foreach my $i (0..3) {
+	    my %r=(a=>$X[$q[$i][0]], b=>$X[$q[$i][1]], c=>$X[$q[$i][2]],
+		   d=>$X[$q[$i][3]], t=>$T[$i]);
+	    push(@ret,"&$insn(".join(',',map(exists($r{$_})?"'$r{$_}'":$_,
+						split(',',$args))).")");
+	}
+    }
+    @ret;
+}
+
+$code.=<<___;
+#if !defined(__KERNEL__) || defined(CONFIG_KERNEL_MODE_NEON)
+.globl	chacha20_neon_x4
+.type	chacha20_neon_x4,%function
+.align	5
+chacha20_neon_x4:
+	mov	x3,$state
+___
+foreach my $l (0..3) {
+    foreach my $g (0..3) {
+	$code.="\tld4\t{".join(',',map("v$_.s",(16+4*$g)..(19+4*$g))).
+	       "}[$l],[x3],#16\n";
+    }
+}
+$code.=<<___;
+	mov	x4,#10
+.Loop_x4:
+	subs	x4,x4,#1
+___
+	foreach (&X4ROUND(0, 4, 8,12)) { eval; }
+	foreach (&X4ROUND(0, 5,10,15)) { eval; }
+$code.=<<___;
+	b.ne	.Loop_x4
+
+	mov	x4,#64
+___
+foreach my $g (0..3) {
+    $code.="\tadd\tx3,$state,#".(16*$g)."\n";
+    foreach my $l (0..3) {
+	$code.="\tld4\t{v0.s,v1.s,v2.s,v3.s}[$l],[x3],x4\n";
+    }
+    foreach my $i (0..3) {
+	$code.="\tadd\t$X[4*$g+$i],$X[4*$g+$i],$T[$i]\n";
+    }
+}
+$code.="#ifdef\t__AARCH64EB__\n";
+foreach my $i (16..31) {
+    $code.="\trev32\tv$i.16b,v$i.16b\n";
+}
+$code.="#endif\n";
+foreach my $l (0..3) {
+    $code.="\tmov\tx3,$out\n";
+    foreach my $g (0..3) {
+	$code.="\tst4\t{".join(',',map("v$_.s",(16+4*$g)..(19+4*$g))).
+	       "}[$l],[x3],#16\n";
+    }
+    $code.="\tadd\t$out,$out,$stride\n";
+}
+foreach my $l (0..3) {
+    my $off=64*$l+48;
+    $code.="\tldr\tw3,[$state,#$off]\n";
+    $code.="\tadd\tw3,w3,#1\n";
+    $code.="\tstr\tw3,[$state,#$off]\n";
+}
+$code.=<<___;
+	ret
+.size	chacha20_neon_x4,.-chacha20_neon_x4
+#endif
+___
+}}}
+
 open SELF,$0;
 while(<SELF>) {
 	next if (/^#!/);
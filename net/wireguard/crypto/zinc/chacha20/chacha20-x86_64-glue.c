@@ -91,6 +91,13 @@ static inline bool chacha20_arch(struct chacha20_ctx *ctx, u8 *dst,
 	return true;
 }
 
+static inline bool chacha20_x4_arch(struct chacha20_ctx ctx[4], u8 *stream,
+				    const size_t stride, u32 nblocks,
+				    simd_context_t *simd_context)
+{
+	return false;
+}
+
 static inline bool hchacha20_arch(u32 derived_key[CHACHA20_KEY_WORDS],
 				  const u8 nonce[HCHACHA20_NONCE_SIZE],
 				  const u8 key[HCHACHA20_KEY_SIZE],
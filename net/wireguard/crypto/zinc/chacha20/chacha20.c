@@ -33,6 +33,12 @@ static inline bool chacha20_arch(struct chacha20_ctx *ctx, u8 *dst,
 {
 	return false;
 }
+static inline bool chacha20_x4_arch(struct chacha20_ctx ctx[4], u8 *stream,
+				    const size_t stride, u32 nblocks,
+				    simd_context_t *simd_context)
+{
+	return false;
+}
 static inline bool hchacha20_arch(u32 derived_key[CHACHA20_KEY_WORDS],
 				  const u8 nonce[HCHACHA20_NONCE_SIZE],
 				  const u8 key[HCHACHA20_KEY_SIZE],
@@ -122,6 +128,26 @@ void chacha20(struct chacha20_ctx *ctx, u8 *dst, const u8 *src, u32 len,
 		chacha20_generic(ctx, dst, src, len);
 }
 
+static void chacha20_x4_generic(struct chacha20_ctx ctx[4], u8 *stream,
+				const size_t stride, u32 nblocks,
+				simd_context_t *simd_context)
+{
+	const u32 len = nblocks * CHACHA20_BLOCK_SIZE;
+	int i;
+
+	for (i = 0; i < 4; ++i, stream += stride) {
+		memset(stream, 0, len);
+		chacha20(&ctx[i], stream, stream, len, simd_context);
+	}
+}
+
+void chacha20_x4(struct chacha20_ctx ctx[4], u8 *stream, const size_t stride,
+		 u32 nblocks, simd_context_t *simd_context)
+{
+	if (!chacha20_x4_arch(ctx, stream, stride, nblocks, simd_context))
+		chacha20_x4_generic(ctx, stream, stride, nblocks, simd_context);
+}
+
 static void hchacha20_generic(u32 derived_key[CHACHA20_KEY_WORDS],
 			      const u8 nonce[HCHACHA20_NONCE_SIZE],
 			      const u8 key[HCHACHA20_KEY_SIZE])
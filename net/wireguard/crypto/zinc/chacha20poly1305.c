@@ -72,12 +72,94 @@ void chacha20poly1305_encrypt(u8 *dst, const u8 *src, const size_t src_len,
 	simd_put(&simd_context);
 }
 
-bool chacha20poly1305_encrypt_sg_inplace(struct scatterlist *src,
-					 const size_t src_len,
-					 const u8 *ad, const size_t ad_len,
-					 const u64 nonce,
-					 const u8 key[CHACHA20POLY1305_KEY_SIZE],
-					 simd_context_t *simd_context)
+/* Keystream for a batch of messages under the same key is generated up front
+ * for all of them at once, which for short messages is most or all of the
+ * keystream they need. Only the first CHACHA20POLY1305_BATCH_BLOCKS blocks
+ * are covered, the remainder of longer messages is left to chacha20().
+ */
+void chacha20poly1305_batch_init(
+	struct chacha20poly1305_batch_stream stream[CHACHA20POLY1305_BATCH_SIZE],
+	const u64 nonce[CHACHA20POLY1305_BATCH_SIZE], const size_t nr,
+	const size_t max_len, const u8 key[CHACHA20POLY1305_KEY_SIZE],
+	simd_context_t *simd_context)
+{
+	struct chacha20_ctx chacha20_state[CHACHA20POLY1305_BATCH_SIZE];
+	const u32 nblocks = 1 + min_t(size_t, CHACHA20POLY1305_BATCH_BLOCKS - 1,
+				      DIV_ROUND_UP(max_len,
+						   CHACHA20_BLOCK_SIZE));
+	size_t i;
+
+	BUILD_BUG_ON(CHACHA20POLY1305_BATCH_SIZE != 4);
+
+	chacha20_init(&chacha20_state[0], key, nonce[0]);
+	for (i = 0; i < ARRAY_SIZE(chacha20_state); ++i) {
+		/* Lanes beyond nr are computed but never used. */
+		u64 n = nonce[i < nr ? i : 0];
+
+		chacha20_state[i] = chacha20_state[0];
+		chacha20_state[i].counter[2] = n & U32_MAX;
+		chacha20_state[i].counter[3] = n >> 32;
+		stream[i].len = nblocks * CHACHA20_BLOCK_SIZE;
+		stream[i].pos = 0;
+	}
+
+	if (nr > 1) {
+		chacha20_x4(chacha20_state, stream[0].block, sizeof(stream[0]),
+			    nblocks, simd_context);
+	} else {
+		memset(stream[0].block, 0, stream[0].len);
+		chacha20(&chacha20_state[0], stream[0].block, stream[0].block,
+			 stream[0].len, simd_context);
+	}
+
+	memzero_explicit(chacha20_state, sizeof(chacha20_state));
+}
+
+static void chacha20poly1305_block0(struct chacha20_ctx *chacha20_state,
+				    struct chacha20poly1305_batch_stream *stream,
+				    u8 block0[POLY1305_KEY_SIZE],
+				    simd_context_t *simd_context)
+{
+	if (!stream) {
+		chacha20(chacha20_state, block0, block0, POLY1305_KEY_SIZE,
+			 simd_context);
+		return;
+	}
+
+	memcpy(block0, stream->block, POLY1305_KEY_SIZE);
+	stream->pos = CHACHA20_BLOCK_SIZE;
+	chacha20_state->counter[0] = stream->len / CHACHA20_BLOCK_SIZE;
+}
+
+/* Callers only ever stop mid-block on their last call, so the batch stream is
+ * consumed in whole blocks up to the point where chacha20() takes over.
+ */
+static void chacha20_batched(struct chacha20_ctx *chacha20_state,
+			     struct chacha20poly1305_batch_stream *stream,
+			     u8 *dst, const u8 *src, size_t len,
+			     simd_context_t *simd_context)
+{
+	if (stream && stream->pos < stream->len) {
+		size_t l = min_t(size_t, len, stream->len - stream->pos);
+
+		crypto_xor_cpy(dst, src, stream->block + stream->pos, l);
+		stream->pos += l;
+		dst += l;
+		src += l;
+		len -= l;
+	}
+	if (len)
+		chacha20(chacha20_state, dst, src, len, simd_context);
+}
+
+static inline bool
+__chacha20poly1305_encrypt_sg_inplace(struct scatterlist *src,
+				      const size_t src_len,
+				      const u8 *ad, const size_t ad_len,
+				      const u64 nonce,
+				      const u8 key[CHACHA20POLY1305_KEY_SIZE],
+				      struct chacha20poly1305_batch_stream *stream,
+				      simd_context_t *simd_context)
 {
 	struct poly1305_ctx poly1305_state;
 	struct chacha20_ctx chacha20_state;
@@ -95,8 +177,7 @@ bool chacha20poly1305_encrypt_sg_inplace(struct scatterlist *src,
 		return false;
 
 	chacha20_init(&chacha20_state, key, nonce);
-	chacha20(&chacha20_state, b.block0, b.block0, sizeof(b.block0),
-		 simd_context);
+	chacha20poly1305_block0(&chacha20_state, stream, b.block0, simd_context);
 	poly1305_init(&poly1305_state, b.block0);
 
 	poly1305_update(&poly1305_state, ad, ad_len, simd_context);
@@ -123,14 +204,16 @@ bool chacha20poly1305_encrypt_sg_inplace(struct scatterlist *src,
 
 			if (unlikely(length < sl))
 				l &= ~(CHACHA20_BLOCK_SIZE - 1);
-			chacha20(&chacha20_state, addr, addr, l, simd_context);
+			chacha20_batched(&chacha20_state, stream, addr, addr, l,
+					 simd_context);
 			addr += l;
 			length -= l;
 		}
 
 		if (unlikely(length > 0)) {
-			chacha20(&chacha20_state, b.chacha20_stream, pad0,
-				 CHACHA20_BLOCK_SIZE, simd_context);
+			chacha20_batched(&chacha20_state, stream,
+					 b.chacha20_stream, pad0,
+					 CHACHA20_BLOCK_SIZE, simd_context);
 			crypto_xor(addr, b.chacha20_stream, length);
 			partial = length;
 		}
@@ -165,6 +248,33 @@ bool chacha20poly1305_encrypt_sg_inplace(struct scatterlist *src,
 	return true;
 }
 
+bool chacha20poly1305_encrypt_sg_inplace(struct scatterlist *src,
+					 const size_t src_len,
+					 const u8 *ad, const size_t ad_len,
+					 const u64 nonce,
+					 const u8 key[CHACHA20POLY1305_KEY_SIZE],
+					 simd_context_t *simd_context)
+{
+	return __chacha20poly1305_encrypt_sg_inplace(src, src_len, ad, ad_len,
+						     nonce, key, NULL,
+						     simd_context);
+}
+
+bool chacha20poly1305_encrypt_sg_inplace_batch(
+	struct scatterlist *src, const size_t src_len, const u8 *ad,
+	const size_t ad_len, const u64 nonce,
+	const u8 key[CHACHA20POLY1305_KEY_SIZE],
+	struct chacha20poly1305_batch_stream *stream,
+	simd_context_t *simd_context)
+{
+	bool ret = __chacha20poly1305_encrypt_sg_inplace(src, src_len, ad,
+							 ad_len, nonce, key,
+							 stream, simd_context);
+
+	memzero_explicit(stream, sizeof(*stream));
+	return ret;
+}
+
 static inline bool
 __chacha20poly1305_decrypt(u8 *dst, const u8 *src, const size_t src_len,
 			   const u8 *ad, const size_t ad_len, const u64 nonce,
@@ -229,12 +339,14 @@ bool chacha20poly1305_decrypt(u8 *dst, const u8 *src, const size_t src_len,
 	return ret;
 }
 
-bool chacha20poly1305_decrypt_sg_inplace(struct scatterlist *src,
-					 size_t src_len,
-					 const u8 *ad, const size_t ad_len,
-					 const u64 nonce,
-					 const u8 key[CHACHA20POLY1305_KEY_SIZE],
-					 simd_context_t *simd_context)
+static inline bool
+__chacha20poly1305_decrypt_sg_inplace(struct scatterlist *src,
+				      size_t src_len,
+				      const u8 *ad, const size_t ad_len,
+				      const u64 nonce,
+				      const u8 key[CHACHA20POLY1305_KEY_SIZE],
+				      struct chacha20poly1305_batch_stream *stream,
+				      simd_context_t *simd_context)
 {
 	struct poly1305_ctx poly1305_state;
 	struct chacha20_ctx chacha20_state;
@@ -257,8 +369,7 @@ bool chacha20poly1305_decrypt_sg_inplace(struct scatterlist *src,
 	src_len -= POLY1305_MAC_SIZE;
 
 	chacha20_init(&chacha20_state, key, nonce);
-	chacha20(&chacha20_state, b.block0, b.block0, sizeof(b.block0),
-		 simd_context);
+	chacha20poly1305_block0(&chacha20_state, stream, b.block0, simd_context);
 	poly1305_init(&poly1305_state, b.block0);
 
 	poly1305_update(&poly1305_state, ad, ad_len, simd_context);
@@ -287,14 +398,16 @@ bool chacha20poly1305_decrypt_sg_inplace(struct scatterlist *src,
 
 			if (unlikely(length < sl))
 				l &= ~(CHACHA20_BLOCK_SIZE - 1);
-			chacha20(&chacha20_state, addr, addr, l, simd_context);
+			chacha20_batched(&chacha20_state, stream, addr, addr, l,
+					 simd_context);
 			addr += l;
 			length -= l;
 		}
 
 		if (unlikely(length > 0)) {
-			chacha20(&chacha20_state, b.chacha20_stream, pad0,
-				 CHACHA20_BLOCK_SIZE, simd_context);
+			chacha20_batched(&chacha20_state, stream,
+					 b.chacha20_stream, pad0,
+					 CHACHA20_BLOCK_SIZE, simd_context);
 			crypto_xor(addr, b.chacha20_stream, length);
 			partial = length;
 		}
@@ -333,6 +446,33 @@ bool chacha20poly1305_decrypt_sg_inplace(struct scatterlist *src,
 	return ret;
 }
 
+bool chacha20poly1305_decrypt_sg_inplace(struct scatterlist *src,
+					 size_t src_len,
+					 const u8 *ad, const size_t ad_len,
+					 const u64 nonce,
+					 const u8 key[CHACHA20POLY1305_KEY_SIZE],
+					 simd_context_t *simd_context)
+{
+	return __chacha20poly1305_decrypt_sg_inplace(src, src_len, ad, ad_len,
+						     nonce, key, NULL,
+						     simd_context);
+}
+
+bool chacha20poly1305_decrypt_sg_inplace_batch(
+	struct scatterlist *src, size_t src_len, const u8 *ad,
+	const size_t ad_len, const u64 nonce,
+	const u8 key[CHACHA20POLY1305_KEY_SIZE],
+	struct chacha20poly1305_batch_stream *stream,
+	simd_context_t *simd_context)
+{
+	bool ret = __chacha20poly1305_decrypt_sg_inplace(src, src_len, ad,
+							 ad_len, nonce, key,
+							 stream, simd_context);
+
+	memzero_explicit(stream, sizeof(*stream));
+	return ret;
+}
+
 void xchacha20poly1305_encrypt(u8 *dst, const u8 *src, const size_t src_len,
 			       const u8 *ad, const size_t ad_len,
 			       const u8 nonce[XCHACHA20POLY1305_NONCE_SIZE],
@@ -31,6 +31,9 @@ struct crypt_queue {
 		struct {
 			struct multicore_worker __percpu *worker;
 			int last_cpu;
+			unsigned long rate_stamp;
+			unsigned int rate_count;
+			bool spread;
 		};
 		struct work_struct work;
 	};
@@ -4,6 +4,92 @@
  */
 
 #include "queueing.h"
+#include <linux/moduleparam.h>
+
+/* Placement of the crypt workers. crypt_cpus restricts them to a mask of
+ * CPUs, 0 meaning all online ones. With crypt_energy_aware set, they are kept
+ * on the little cluster while a queue sees fewer than crypt_spread_rate
+ * packets per second, and only spread over the whole mask above that, so
+ * keepalives and low-rate traffic don't wake the big cores. The per-peer
+ * transmit workers always stay on the little cluster in that mode. Like
+ * cpu_lp_mask itself, the masks assume that all CPUs fit in one long.
+ */
+unsigned int wg_crypt_cpus;
+bool wg_crypt_energy_aware;
+static unsigned int wg_crypt_spread_rate = 10000;
+module_param_named(crypt_cpus, wg_crypt_cpus, uint, 0644);
+module_param_named(crypt_energy_aware, wg_crypt_energy_aware, bool, 0644);
+module_param_named(crypt_spread_rate, wg_crypt_spread_rate, uint, 0644);
+
+#define WG_CRYPT_RATE_WINDOW (HZ / 10)
+
+static unsigned long wg_crypt_mask(bool spread)
+{
+	unsigned long online = cpumask_bits(cpu_online_mask)[0];
+	unsigned long mask = READ_ONCE(wg_crypt_cpus) & online;
+	unsigned long little;
+
+	if (!mask)
+		mask = online;
+	if (READ_ONCE(wg_crypt_energy_aware) && !spread) {
+		little = mask & cpumask_bits(cpu_lp_mask)[0];
+		if (little)
+			mask = little;
+	}
+	return mask;
+}
+
+/* The rate is sampled without locking from every CPU enqueueing to the queue,
+ * so a few packets may be missed per window, which is fine for an estimate.
+ * Spreading stops below half of the threshold to avoid flapping around it.
+ */
+static bool wg_crypt_queue_spread(struct crypt_queue *queue)
+{
+	unsigned long now = jiffies;
+	unsigned long elapsed = now - READ_ONCE(queue->rate_stamp);
+	unsigned int count = READ_ONCE(queue->rate_count) + 1;
+
+	WRITE_ONCE(queue->rate_count, count);
+	if (elapsed >= WG_CRYPT_RATE_WINDOW) {
+		unsigned int limit = READ_ONCE(wg_crypt_spread_rate);
+		u64 rate = div64_ul((u64)count * HZ, elapsed);
+
+		if (rate > limit)
+			WRITE_ONCE(queue->spread, true);
+		else if (rate < limit / 2)
+			WRITE_ONCE(queue->spread, false);
+		WRITE_ONCE(queue->rate_stamp, now);
+		WRITE_ONCE(queue->rate_count, 0);
+	}
+	return READ_ONCE(queue->spread);
+}
+
+int wg_cpumask_next_placed(struct crypt_queue *queue, int *next)
+{
+	unsigned long mask = wg_crypt_mask(wg_crypt_queue_spread(queue));
+	int cpu;
+
+	cpu = find_next_bit(&mask, BITS_PER_LONG, *next);
+	if (cpu >= BITS_PER_LONG)
+		cpu = find_first_bit(&mask, BITS_PER_LONG);
+	*next = (cpu + 1) % nr_cpumask_bits;
+	return cpu;
+}
+
+int wg_cpumask_choose_placed(int *stored_cpu, unsigned int id)
+{
+	unsigned long mask = wg_crypt_mask(false);
+	unsigned int cpu = *stored_cpu, cpu_index, i;
+
+	if (cpu >= BITS_PER_LONG || !(mask & BIT(cpu))) {
+		cpu_index = id % hweight_long(mask);
+		cpu = find_first_bit(&mask, BITS_PER_LONG);
+		for (i = 0; i < cpu_index; ++i)
+			cpu = find_next_bit(&mask, BITS_PER_LONG, cpu + 1);
+		*stored_cpu = cpu;
+	}
+	return cpu;
+}
 
 struct multicore_worker __percpu *
 wg_packet_percpu_multicore_worker_alloc(work_func_t function, void *ptr)
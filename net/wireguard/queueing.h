@@ -25,6 +25,10 @@ int wg_packet_queue_init(struct crypt_queue *queue, work_func_t function,
 void wg_packet_queue_free(struct crypt_queue *queue, bool multicore);
 struct multicore_worker __percpu *
 wg_packet_percpu_multicore_worker_alloc(work_func_t function, void *ptr);
+extern unsigned int wg_crypt_cpus;
+extern bool wg_crypt_energy_aware;
+int wg_cpumask_choose_placed(int *stored_cpu, unsigned int id);
+int wg_cpumask_next_placed(struct crypt_queue *queue, int *next);
 
 /* receive.c APIs: */
 void wg_packet_receive(struct wg_device *wg, struct sk_buff *skb);
@@ -106,10 +110,21 @@ static inline void wg_reset_packet(struct sk_buff *skb, bool encapsulating)
 	skb_reset_inner_headers(skb);
 }
 
+/* Worker placement only deviates from the plain online mask once crypt_cpus
+ * or crypt_energy_aware is set.
+ */
+static inline bool wg_cpumask_placement(void)
+{
+	return READ_ONCE(wg_crypt_cpus) || READ_ONCE(wg_crypt_energy_aware);
+}
+
 static inline int wg_cpumask_choose_online(int *stored_cpu, unsigned int id)
 {
 	unsigned int cpu = *stored_cpu, cpu_index, i;
 
+	if (unlikely(wg_cpumask_placement()))
+		return wg_cpumask_choose_placed(stored_cpu, id);
+
 	if (unlikely(cpu == nr_cpumask_bits ||
 		     !cpumask_test_cpu(cpu, cpu_online_mask))) {
 		cpu_index = id % cpumask_weight(cpu_online_mask);
@@ -153,7 +168,10 @@ static inline int wg_queue_enqueue_per_device_and_peer(
 	/* Then we queue it up in the device queue, which consumes the
 	 * packet as soon as it can.
 	 */
-	cpu = wg_cpumask_next_online(next_cpu);
+	if (unlikely(wg_cpumask_placement()))
+		cpu = wg_cpumask_next_placed(device_queue, next_cpu);
+	else
+		cpu = wg_cpumask_next_online(next_cpu);
 	if (unlikely(ptr_ring_produce_bh(&device_queue->ring, skb)))
 		return -EPIPE;
 	queue_work_on(cpu, wq, &per_cpu_ptr(device_queue->worker, cpu)->work);
@@ -247,6 +247,7 @@ static void keep_key_fresh(struct wg_peer *peer)
 }
 
 static bool decrypt_packet(struct sk_buff *skb, struct noise_keypair *keypair,
+			   struct chacha20poly1305_batch_stream *stream,
 			   simd_context_t *simd_context)
 {
 	struct scatterlist sg[MAX_SKB_FRAGS + 8];
@@ -283,10 +284,10 @@ static bool decrypt_packet(struct sk_buff *skb, struct noise_keypair *keypair,
 	if (skb_to_sgvec(skb, sg, 0, skb->len) <= 0)
 		return false;
 
-	if (!chacha20poly1305_decrypt_sg_inplace(sg, skb->len, NULL, 0,
-						 PACKET_CB(skb)->nonce,
-						 keypair->receiving.key,
-						 simd_context))
+	if (!chacha20poly1305_decrypt_sg_inplace_batch(sg, skb->len, NULL, 0,
+						       PACKET_CB(skb)->nonce,
+						       keypair->receiving.key,
+						       stream, simd_context))
 		return false;
 
 	/* Another ugly situation of pushing and pulling the header so as to
@@ -503,20 +504,73 @@ int wg_packet_rx_poll(struct napi_struct *napi, int budget)
 	return work_done;
 }
 
+/* Prepares the keystream for nr packets received under the same keypair. The
+ * counter is read from the header before decrypt_packet() validates it, which
+ * at worst wastes the keystream of that packet.
+ */
+static void decrypt_batch_init(struct chacha20poly1305_batch_stream *stream,
+			       struct sk_buff **skbs, size_t nr,
+			       struct noise_keypair *keypair,
+			       simd_context_t *simd_context)
+{
+	u64 nonce[CHACHA20POLY1305_BATCH_SIZE];
+	size_t i, max_len = 0;
+
+	for (i = 0; i < nr; ++i) {
+		nonce[i] = le64_to_cpu(
+			((struct message_data *)skbs[i]->data)->counter);
+		max_len = max_t(size_t, max_len,
+				skbs[i]->len - sizeof(struct message_data));
+	}
+	chacha20poly1305_batch_init(stream, nonce, nr, max_len,
+				    keypair->receiving.key, simd_context);
+}
+
 void wg_packet_decrypt_worker(struct work_struct *work)
 {
 	struct crypt_queue *queue = container_of(work, struct multicore_worker,
 						 work)->ptr;
+	struct chacha20poly1305_batch_stream stream[CHACHA20POLY1305_BATCH_SIZE];
+	struct sk_buff *skbs[CHACHA20POLY1305_BATCH_SIZE];
 	simd_context_t simd_context;
-	struct sk_buff *skb;
+	size_t nr, i, first, last;
 
 	simd_get(&simd_context);
-	while ((skb = ptr_ring_consume_bh(&queue->ring)) != NULL) {
-		enum packet_state state =
-			likely(decrypt_packet(skb, PACKET_CB(skb)->keypair,
-					      &simd_context)) ?
-				PACKET_STATE_CRYPTED : PACKET_STATE_DEAD;
-		wg_queue_enqueue_per_peer_napi(skb, state);
+	for (;;) {
+		for (nr = 0; nr < ARRAY_SIZE(skbs); ++nr) {
+			skbs[nr] = ptr_ring_consume_bh(&queue->ring);
+			if (!skbs[nr])
+				break;
+		}
+		if (!nr)
+			break;
+
+		/* Packets of one batch share their keystream setup as long as
+		 * they were received under the same keypair.
+		 */
+		for (first = 0; first < nr; first = last) {
+			struct noise_keypair *keypair =
+				PACKET_CB(skbs[first])->keypair;
+
+			for (last = first + 1; last < nr &&
+			     PACKET_CB(skbs[last])->keypair == keypair; ++last)
+				;
+			if (likely(keypair))
+				decrypt_batch_init(stream, skbs + first,
+						   last - first, keypair,
+						   &simd_context);
+
+			for (i = first; i < last; ++i) {
+				enum packet_state state =
+					likely(decrypt_packet(skbs[i], keypair,
+							      &stream[i - first],
+							      &simd_context)) ?
+						PACKET_STATE_CRYPTED :
+						PACKET_STATE_DEAD;
+				wg_queue_enqueue_per_peer_napi(skbs[i], state);
+			}
+		}
+		memzero_explicit(stream, sizeof(stream));
 		simd_relax(&simd_context);
 	}
 
@@ -161,6 +161,7 @@ static unsigned int calculate_skb_padding(struct sk_buff *skb)
 }
 
 static bool encrypt_packet(struct sk_buff *skb, struct noise_keypair *keypair,
+			   struct chacha20poly1305_batch_stream *stream,
 			   simd_context_t *simd_context)
 {
 	unsigned int padding_len, plaintext_len, trailer_len;
@@ -215,10 +216,31 @@ static bool encrypt_packet(struct sk_buff *skb, struct noise_keypair *keypair,
 	if (skb_to_sgvec(skb, sg, sizeof(struct message_data),
 			 noise_encrypted_len(plaintext_len)) <= 0)
 		return false;
-	return chacha20poly1305_encrypt_sg_inplace(sg, plaintext_len, NULL, 0,
-						   PACKET_CB(skb)->nonce,
-						   keypair->sending.key,
-						   simd_context);
+	return chacha20poly1305_encrypt_sg_inplace_batch(sg, plaintext_len,
+							 NULL, 0,
+							 PACKET_CB(skb)->nonce,
+							 keypair->sending.key,
+							 stream, simd_context);
+}
+
+/* Prepares the keystream for skb and up to the next three packets of its
+ * bundle, which all share the same keypair.
+ */
+static void encrypt_batch_init(struct chacha20poly1305_batch_stream *stream,
+			       struct sk_buff *skb,
+			       struct noise_keypair *keypair,
+			       simd_context_t *simd_context)
+{
+	u64 nonce[CHACHA20POLY1305_BATCH_SIZE];
+	size_t nr = 0, max_len = 0;
+
+	for (; skb && nr < CHACHA20POLY1305_BATCH_SIZE; skb = skb->next) {
+		nonce[nr++] = PACKET_CB(skb)->nonce;
+		max_len = max_t(size_t, max_len,
+				skb->len + calculate_skb_padding(skb));
+	}
+	chacha20poly1305_batch_init(stream, nonce, nr, max_len,
+				    keypair->sending.key, simd_context);
 }
 
 void wg_packet_send_keepalive(struct wg_peer *peer)
@@ -295,23 +317,32 @@ void wg_packet_encrypt_worker(struct work_struct *work)
 {
 	struct crypt_queue *queue = container_of(work, struct multicore_worker,
 						 work)->ptr;
+	struct chacha20poly1305_batch_stream stream[CHACHA20POLY1305_BATCH_SIZE];
 	struct sk_buff *first, *skb, *next;
 	simd_context_t simd_context;
 
 	simd_get(&simd_context);
 	while ((first = ptr_ring_consume_bh(&queue->ring)) != NULL) {
 		enum packet_state state = PACKET_STATE_CRYPTED;
+		unsigned int lane = 0;
 
 		skb_list_walk_safe(first, skb, next) {
+			if (!lane)
+				encrypt_batch_init(stream, skb,
+						   PACKET_CB(first)->keypair,
+						   &simd_context);
 			if (likely(encrypt_packet(skb,
 						  PACKET_CB(first)->keypair,
+						  &stream[lane],
 						  &simd_context))) {
 				wg_reset_packet(skb, true);
 			} else {
 				state = PACKET_STATE_DEAD;
 				break;
 			}
+			lane = (lane + 1) % CHACHA20POLY1305_BATCH_SIZE;
 		}
+		memzero_explicit(stream, sizeof(stream));
 		wg_queue_enqueue_per_peer(&PACKET_PEER(first)->tx_queue, first,
 					  state);
 
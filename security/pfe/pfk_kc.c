@@ -57,6 +57,8 @@
 static DEFINE_SPINLOCK(kc_lock);
 static unsigned long flags;
 static bool kc_ready;
+/* LRU clock, advanced on every use of an entry; protected by kc_lock */
+static u64 kc_lru_clock;
 static char *s_type = "sdcc";
 
 /**
@@ -231,7 +233,7 @@ static void kc_entry_finish_invalidating(struct kc_entry *entry)
 }
 
 /**
- * kc_min_entry() - compare two entries to find one with minimal time
+ * kc_min_entry() - compare two entries to find the least recently used
  * @a: ptr to the first entry. If NULL the other entry will be returned
  * @b: pointer to the second entry
  *
@@ -243,7 +245,7 @@ static inline struct kc_entry *kc_min_entry(struct kc_entry *a,
 	if (!a)
 		return b;
 
-	if (time_before64(b->time_stamp, a->time_stamp))
+	if (b->time_stamp < a->time_stamp)
 		return b;
 
 	return a;
@@ -350,17 +352,20 @@ static struct kc_entry *kc_find_oldest_entry_non_locked(void)
 }
 
 /**
- * kc_update_timestamp() - updates timestamp of entry to current
+ * kc_update_timestamp() - marks entry as the most recently used
  *
  * @entry: entry to update
  *
+ * A counter rather than jiffies is used, so that keys used within the
+ * same tick are still ordered and eviction picks the true LRU entry.
+ * Should be invoked under spinlock
  */
 static void kc_update_timestamp(struct kc_entry *entry)
 {
 	if (!entry)
 		return;
 
-	entry->time_stamp = get_jiffies_64();
+	entry->time_stamp = ++kc_lru_clock;
 }
 
 /**
@@ -91,7 +91,8 @@ static struct snd_pcm_hardware msm_pcm_hardware_playback = {
 				SNDRV_PCM_INFO_BLOCK_TRANSFER |
 				SNDRV_PCM_INFO_MMAP_VALID |
 				SNDRV_PCM_INFO_INTERLEAVED |
-				SNDRV_PCM_INFO_PAUSE | SNDRV_PCM_INFO_RESUME),
+				SNDRV_PCM_INFO_PAUSE | SNDRV_PCM_INFO_RESUME |
+				SNDRV_PCM_INFO_NO_PERIOD_WAKEUP),
 	.formats =              (SNDRV_PCM_FMTBIT_S16_LE |
 				SNDRV_PCM_FMTBIT_S24_LE |
 				SNDRV_PCM_FMTBIT_S24_3LE |
@@ -159,7 +160,12 @@ static void event_handler(uint32_t opcode,
 		pr_debug("ASM_DATA_EVENT_WRITE_DONE_V2\n");
 		pr_debug("Buffer Consumed = 0x%08x\n", *ptrmem);
 		prtd->pcm_irq_pos += prtd->pcm_count;
-		if (atomic_read(&prtd->start))
+		/*
+		 * In mmap mode buffers are requeued from here, so a client
+		 * that asked for no period wakeups only polls the pointer.
+		 */
+		if (atomic_read(&prtd->start) && !(prtd->mmap_flag &&
+		    substream->runtime->no_period_wakeup))
 			snd_pcm_period_elapsed(substream);
 		atomic_inc(&prtd->out_count);
 		wake_up(&the_locks.write_wait);
@@ -27,6 +27,7 @@
 #include <linux/time.h>
 #include <linux/atomic.h>
 #include <linux/mm.h>
+#include <linux/sizes.h>
 
 #include <asm/ioctls.h>
 
@@ -105,6 +106,27 @@ struct asm_buffer_node {
 	phys_addr_t buf_phys_addr;
 	uint32_t  mmap_hdl;
 };
+
+/*
+ * Contiguous stream buffers are parked here on free, still mapped on the
+ * ADSP, so the next stream open of the same size skips both the ION
+ * allocation and the ASM_CMD_SHARED_MEM_MAP_REGIONS round trip.
+ */
+#define ASM_MEM_POOL_MAX_CNT	4
+#define ASM_MEM_POOL_MAX_SIZE	SZ_256K
+
+struct asm_mem_pool_node {
+	struct list_head list;
+	struct ion_client *client;
+	struct ion_handle *handle;
+	phys_addr_t phys;
+	void *data;
+	size_t size;
+	uint32_t mmap_hdl;
+};
+static LIST_HEAD(asm_mem_pool);
+static DEFINE_MUTEX(asm_mem_pool_lock);
+static int asm_mem_pool_cnt;
 static int32_t q6asm_srvc_callback(struct apr_client_data *data, void *priv);
 static int32_t q6asm_callback(struct apr_client_data *data, void *priv);
 static void q6asm_add_hdr(struct audio_client *ac, struct apr_hdr *hdr,
@@ -1015,10 +1037,140 @@ int q6asm_audio_client_buf_free(unsigned int dir,
 	return 0;
 }
 
+static uint32_t q6asm_mem_pool_get(struct audio_buffer *ab, size_t size)
+{
+	struct asm_mem_pool_node *node;
+	uint32_t mmap_hdl = 0;
+
+	mutex_lock(&asm_mem_pool_lock);
+	list_for_each_entry(node, &asm_mem_pool, list) {
+		if (node->size != size)
+			continue;
+
+		ab->client = node->client;
+		ab->handle = node->handle;
+		ab->phys = node->phys;
+		ab->data = node->data;
+		mmap_hdl = node->mmap_hdl;
+		list_del(&node->list);
+		asm_mem_pool_cnt--;
+		kfree(node);
+		break;
+	}
+	mutex_unlock(&asm_mem_pool_lock);
+
+	/* Same state as a fresh msm_audio_ion_alloc() */
+	if (mmap_hdl)
+		memset(ab->data, 0, size);
+
+	return mmap_hdl;
+}
+
+static bool q6asm_mem_pool_put(struct audio_buffer *ab, size_t size,
+			       uint32_t mmap_hdl)
+{
+	struct asm_mem_pool_node *node;
+
+	if (!mmap_hdl || size > ASM_MEM_POOL_MAX_SIZE)
+		return false;
+
+	node = kzalloc(sizeof(*node), GFP_KERNEL);
+	if (!node)
+		return false;
+
+	mutex_lock(&asm_mem_pool_lock);
+	if (asm_mem_pool_cnt >= ASM_MEM_POOL_MAX_CNT) {
+		mutex_unlock(&asm_mem_pool_lock);
+		kfree(node);
+		return false;
+	}
+	node->client = ab->client;
+	node->handle = ab->handle;
+	node->phys = ab->phys;
+	node->data = ab->data;
+	node->size = size;
+	node->mmap_hdl = mmap_hdl;
+	list_add(&node->list, &asm_mem_pool);
+	asm_mem_pool_cnt++;
+	mutex_unlock(&asm_mem_pool_lock);
+
+	return true;
+}
+
+/* ADSP mappings are gone after SSR, release the parked buffers */
+static void q6asm_mem_pool_drop(void)
+{
+	struct asm_mem_pool_node *node, *next;
+
+	mutex_lock(&asm_mem_pool_lock);
+	list_for_each_entry_safe(node, next, &asm_mem_pool, list) {
+		list_del(&node->list);
+		msm_audio_ion_free(node->client, node->handle);
+		kfree(node);
+	}
+	asm_mem_pool_cnt = 0;
+	mutex_unlock(&asm_mem_pool_lock);
+}
+
+/*
+ * Detach a contiguous port buffer from its ADSP mapping handle without
+ * unmapping it. Returns the handle, or 0 if the buffer was never mapped.
+ */
+static uint32_t q6asm_release_buf_nodes(struct audio_client *ac, int dir)
+{
+	struct audio_port_data *port = &ac->port[dir];
+	struct asm_buffer_node *buf_node, *head = NULL;
+	struct list_head *ptr, *next;
+	uint32_t mmap_hdl = 0;
+	int i;
+
+	list_for_each_safe(ptr, next, &port->mem_map_handle) {
+		buf_node = list_entry(ptr, struct asm_buffer_node, list);
+		for (i = 0; i < port->max_buf_cnt; i++) {
+			if (buf_node->buf_phys_addr != port->buf[i].phys)
+				continue;
+			if (!i) {
+				head = buf_node;
+				mmap_hdl = buf_node->mmap_hdl;
+			}
+			list_del(&buf_node->list);
+			break;
+		}
+	}
+	/* nodes of one mapping are allocated as a single array */
+	kfree(head);
+
+	return mmap_hdl;
+}
+
+/* Caller holds ac->cmd_lock */
+static int q6asm_add_buf_nodes(struct audio_client *ac, int dir,
+			       uint32_t mmap_hdl)
+{
+	struct audio_port_data *port = &ac->port[dir];
+	struct asm_buffer_node *buffer_node;
+	int i;
+
+	buffer_node = kcalloc(port->max_buf_cnt, sizeof(*buffer_node),
+			      GFP_KERNEL);
+	if (!buffer_node)
+		return -ENOMEM;
+
+	for (i = 0; i < port->max_buf_cnt; i++) {
+		buffer_node[i].buf_phys_addr = port->buf[i].phys;
+		buffer_node[i].mmap_hdl = mmap_hdl;
+		list_add_tail(&buffer_node[i].list, &port->mem_map_handle);
+	}
+
+	return 0;
+}
+
 int q6asm_audio_client_buf_free_contiguous(unsigned int dir,
 			struct audio_client *ac)
 {
 	struct audio_port_data *port;
+	uint32_t mmap_hdl;
+	size_t size;
 	int cnt = 0;
 	int rc = 0;
 
@@ -1031,7 +1183,21 @@ int q6asm_audio_client_buf_free_contiguous(unsigned int dir,
 	}
 	cnt = port->max_buf_cnt - 1;
 
-	if (cnt >= 0) {
+	size = PAGE_ALIGN(port->buf[0].size * port->max_buf_cnt);
+	if (cnt >= 0 && port->buf[0].data && this_mmap.apr &&
+	    !atomic_read(&ac->reset) && size <= ASM_MEM_POOL_MAX_SIZE) {
+		mmap_hdl = q6asm_release_buf_nodes(ac, dir);
+		if (q6asm_mem_pool_put(&port->buf[0], size, mmap_hdl)) {
+			port->buf[0].client = NULL;
+			port->buf[0].handle = NULL;
+			port->buf[0].data = NULL;
+		} else if (mmap_hdl) {
+			/* put the node back so the unmap below finds it */
+			q6asm_add_buf_nodes(ac, dir, mmap_hdl);
+		}
+	}
+
+	if (cnt >= 0 && port->buf[0].data) {
 		rc = q6asm_memory_unmap(ac, port->buf[0].phys, dir);
 		if (rc < 0)
 			pr_err("%s: Memory_unmap_regions failed %d\n",
@@ -1459,6 +1625,7 @@ int q6asm_audio_client_buf_alloc_contiguous(unsigned int dir,
 	struct audio_buffer *buf;
 	size_t len;
 	int bytes_to_alloc;
+	uint32_t mmap_hdl;
 
 	if (!(ac) || ((dir != IN) && (dir != OUT))) {
 		pr_err("%s: ac %pK dir %d\n", __func__, ac, dir);
@@ -1502,15 +1669,18 @@ int q6asm_audio_client_buf_alloc_contiguous(unsigned int dir,
 	/* The size to allocate should be multiple of 4K bytes */
 	bytes_to_alloc = PAGE_ALIGN(bytes_to_alloc);
 
-	rc = msm_audio_ion_alloc("asm_client", &buf[0].client, &buf[0].handle,
-		bytes_to_alloc,
-		(ion_phys_addr_t *)&buf[0].phys, &len,
-		&buf[0].data);
-	if (rc) {
-		pr_err("%s: Audio ION alloc is failed, rc = %d\n",
-			__func__, rc);
-		mutex_unlock(&ac->cmd_lock);
-		goto fail;
+	mmap_hdl = q6asm_mem_pool_get(&buf[0], bytes_to_alloc);
+	if (!mmap_hdl) {
+		rc = msm_audio_ion_alloc("asm_client", &buf[0].client,
+			&buf[0].handle, bytes_to_alloc,
+			(ion_phys_addr_t *)&buf[0].phys, &len,
+			&buf[0].data);
+		if (rc) {
+			pr_err("%s: Audio ION alloc is failed, rc = %d\n",
+				__func__, rc);
+			mutex_unlock(&ac->cmd_lock);
+			goto fail;
+		}
 	}
 
 	buf[0].used = dir ^ 1;
@@ -1539,6 +1709,19 @@ int q6asm_audio_client_buf_alloc_contiguous(unsigned int dir,
 		cnt++;
 	}
 	ac->port[dir].max_buf_cnt = cnt;
+	if (mmap_hdl) {
+		rc = q6asm_add_buf_nodes(ac, dir, mmap_hdl);
+		if (rc < 0 &&
+		    q6asm_mem_pool_put(&buf[0], bytes_to_alloc, mmap_hdl)) {
+			buf[0].client = NULL;
+			buf[0].handle = NULL;
+			buf[0].data = NULL;
+		}
+		mutex_unlock(&ac->cmd_lock);
+		if (rc < 0)
+			goto fail;
+		return 0;
+	}
 	mutex_unlock(&ac->cmd_lock);
 	rc = q6asm_memory_map_regions(ac, dir, bufsz, cnt, 1);
 	if (rc < 0) {
@@ -1600,6 +1783,7 @@ static int32_t q6asm_srvc_callback(struct apr_client_data *data, void *priv)
 		}
 
 		cal_utils_clear_cal_block_q6maps(ASM_MAX_CAL_TYPES, cal_data);
+		q6asm_mem_pool_drop();
 		common_client.mmap_apr = NULL;
 		mutex_lock(&cal_data[ASM_CUSTOM_TOP_CAL]->lock);
 		set_custom_topology = 1;
@@ -9859,6 +10043,7 @@ static int __init q6asm_init(void)
 
 static void __exit q6asm_exit(void)
 {
+	q6asm_mem_pool_drop();
 	q6asm_delete_cal_data();
 }
 